@@ -0,0 +1,15 @@
+-- asof(ts, at_time) marks a join as an ASOF join, which joins every row of one
+-- side with the latest row of the other side whose time is at or before the
+-- row's time, e.g., every trade with the latest quote of its symbol:
+--
+--   SELECT * FROM trades t
+--   LEFT JOIN quotes q ON q.symbol = t.symbol AND asof(q.time, t.time);
+--
+-- The first argument is the time of the side whose latest rows are looked
+-- up, and the second one is the time of the side whose rows are joined,
+-- which must be the outer side of a left join. Other join conditions of a
+-- left ASOF join must be equalities between columns of the two sides, which
+-- select the rows to look up among. The condition can only be evaluated by
+-- the join.
+CREATE OR REPLACE FUNCTION asof(ts ANYELEMENT, at_time ANYELEMENT) RETURNS BOOLEAN
+	AS '@MODULE_PATHNAME@', 'asof_join_marker' LANGUAGE C IMMUTABLE PARALLEL SAFE;
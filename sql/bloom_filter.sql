@@ -0,0 +1,48 @@
+-- This file defines functions for bloom filters, which track the set of
+-- values of a column in each chunk of a hypertable.
+
+-- Add a bloom filter on a column of a hypertable. Chunks whose filter shows
+-- that they do not contain the value of an equality restriction on the
+-- column are excluded when a query executes. Filters are built for the
+-- existing chunks when the bloom filter is added. A write to a chunk removes
+-- its filters; rebuild them with build_chunk_bloom_filters() once the chunk
+-- no longer receives writes.
+--
+-- main_table - The hypertable to add the bloom filter to
+-- column_name - The column to filter. Its type must have a hash opclass and
+--               it must not be a partitioning column
+-- false_positive_rate - (Optional) The rate at which filters report a value
+--                       that is not in the chunk. Lower rates need larger
+--                       filters
+-- if_not_exists - (Optional) Do not fail if the bloom filter already exists
+CREATE OR REPLACE FUNCTION add_bloom_filter(
+    main_table              REGCLASS,
+    column_name             NAME,
+    false_positive_rate     FLOAT8 = 0.01,
+    if_not_exists           BOOLEAN = FALSE
+) RETURNS VOID AS '@MODULE_PATHNAME@', 'bloom_filter_add' LANGUAGE C VOLATILE;
+
+-- Remove a bloom filter from a hypertable.
+--
+-- main_table - The hypertable to remove the bloom filter from
+-- column_name - The filtered column
+-- if_exists - (Optional) Do not fail if the bloom filter does not exist
+CREATE OR REPLACE FUNCTION remove_bloom_filter(
+    main_table              REGCLASS,
+    column_name             NAME,
+    if_exists               BOOLEAN = FALSE
+) RETURNS VOID AS '@MODULE_PATHNAME@', 'bloom_filter_remove' LANGUAGE C VOLATILE;
+
+-- Build the bloom filters of a chunk from its current rows, replacing any
+-- existing filters. Filters are sized for the number of rows in the chunk,
+-- so build them once the chunk no longer receives writes.
+--
+-- chunk - The chunk to build the filters for
+CREATE OR REPLACE FUNCTION build_chunk_bloom_filters(
+    chunk                   REGCLASS
+) RETURNS VOID AS '@MODULE_PATHNAME@', 'bloom_filter_build_chunk' LANGUAGE C VOLATILE;
+
+-- Row trigger that removes the bloom filters of a chunk when rows are
+-- inserted into or updated in the chunk.
+CREATE OR REPLACE FUNCTION _timescaledb_internal.bloom_filter_invalidate_trigger()
+    RETURNS TRIGGER AS '@MODULE_PATHNAME@', 'bloom_filter_invalidate_trigger' LANGUAGE C;
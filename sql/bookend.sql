@@ -33,6 +33,26 @@ RETURNS internal
 AS '@MODULE_PATHNAME@', 'bookend_deserializefunc'
 LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
 
+CREATE OR REPLACE FUNCTION _timescaledb_internal.first_msfunc(internal, anyelement, "any")
+RETURNS internal
+AS '@MODULE_PATHNAME@', 'first_msfunc'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION _timescaledb_internal.last_msfunc(internal, anyelement, "any")
+RETURNS internal
+AS '@MODULE_PATHNAME@', 'last_msfunc'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION _timescaledb_internal.bookend_minvfunc(internal, anyelement, "any")
+RETURNS internal
+AS '@MODULE_PATHNAME@', 'bookend_minvfunc'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION _timescaledb_internal.bookend_moving_finalfunc(internal, anyelement, "any")
+RETURNS anyelement
+AS '@MODULE_PATHNAME@', 'bookend_moving_finalfunc'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
 --This aggregate returns the "first" element of the first argument when ordered by the second argument.
 --Ex. first(temp, time) returns the temp value for the row with the lowest time
 DROP AGGREGATE IF EXISTS first(anyelement, "any");
@@ -44,7 +64,12 @@ CREATE AGGREGATE first(anyelement, "any") (
     DESERIALFUNC = _timescaledb_internal.bookend_deserializefunc,
     PARALLEL = SAFE,
     FINALFUNC = _timescaledb_internal.bookend_finalfunc,
-    FINALFUNC_EXTRA
+    FINALFUNC_EXTRA,
+    MSFUNC = _timescaledb_internal.first_msfunc,
+    MINVFUNC = _timescaledb_internal.bookend_minvfunc,
+    MSTYPE = internal,
+    MFINALFUNC = _timescaledb_internal.bookend_moving_finalfunc,
+    MFINALFUNC_EXTRA
 );
 
 --This aggregate returns the "last" element of the first argument when ordered by the second argument.
@@ -58,5 +83,10 @@ CREATE AGGREGATE last(anyelement, "any") (
     DESERIALFUNC = _timescaledb_internal.bookend_deserializefunc,
     PARALLEL = SAFE,
     FINALFUNC = _timescaledb_internal.bookend_finalfunc,
-    FINALFUNC_EXTRA
+    FINALFUNC_EXTRA,
+    MSFUNC = _timescaledb_internal.last_msfunc,
+    MINVFUNC = _timescaledb_internal.bookend_minvfunc,
+    MSTYPE = internal,
+    MFINALFUNC = _timescaledb_internal.bookend_moving_finalfunc,
+    MFINALFUNC_EXTRA
 );
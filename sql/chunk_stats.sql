@@ -0,0 +1,19 @@
+-- This file defines functions for chunk statistics, which answer aggregates
+-- over chunks that no longer receive writes.
+
+-- Record the number of rows and the range of the time column of a chunk.
+-- Queries that compute count(*), count(time), min(time) or max(time) over a
+-- hypertable without grouping read the statistics instead of the rows of
+-- chunks that lie entirely within the query's time range. A write to the
+-- chunk removes its statistics, so record them once the chunk no longer
+-- receives writes.
+--
+-- chunk - The chunk to record the statistics for
+CREATE OR REPLACE FUNCTION record_chunk_stats(
+    chunk                   REGCLASS
+) RETURNS VOID AS '@MODULE_PATHNAME@', 'chunk_stats_record_chunk' LANGUAGE C VOLATILE;
+
+-- Trigger that removes the statistics of a chunk when rows are inserted
+-- into, updated in or deleted from the chunk, or the chunk is truncated.
+CREATE OR REPLACE FUNCTION _timescaledb_internal.chunk_stats_invalidate_trigger()
+    RETURNS TRIGGER AS '@MODULE_PATHNAME@', 'chunk_stats_invalidate_trigger' LANGUAGE C;
@@ -0,0 +1,24 @@
+-- This file defines functions for compressing and decompressing chunks.
+
+-- Compress a chunk into columnar form. The rows of the chunk are moved to
+-- a compressed table in batches of up to 1000 rows, with every column except
+-- the segment_by columns stored in compressed form.
+--
+-- chunk - The chunk to compress
+-- segment_by - (Optional) Columns whose values are stored uncompressed; each
+--              batch only holds rows with the same values in these columns
+CREATE OR REPLACE FUNCTION compress_chunk(
+    chunk       REGCLASS,
+    segment_by  NAME[] = NULL
+) RETURNS VOID AS '@MODULE_PATHNAME@', 'compressed_chunk_compress' LANGUAGE C VOLATILE;
+
+-- Trigger that refuses direct writes to a compressed chunk
+CREATE OR REPLACE FUNCTION _timescaledb_internal.compressed_chunk_block_trigger()
+    RETURNS TRIGGER AS '@MODULE_PATHNAME@', 'compressed_chunk_block_trigger' LANGUAGE C;
+
+-- Decompress a compressed chunk, moving its rows back into the chunk.
+--
+-- chunk - The chunk to decompress
+CREATE OR REPLACE FUNCTION decompress_chunk(
+    chunk       REGCLASS
+) RETURNS VOID AS '@MODULE_PATHNAME@', 'compressed_chunk_decompress' LANGUAGE C VOLATILE;
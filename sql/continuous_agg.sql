@@ -0,0 +1,45 @@
+-- This file defines functions for continuous aggregates, which materialize
+-- aggregate queries over the time buckets of a hypertable and refresh the
+-- materialized buckets incrementally.
+
+-- Create a continuous aggregate. The query must select from a single
+-- hypertable, group by time_bucket() of the hypertable's time column with a
+-- constant width, and select the bucket. The aggregate is queried through a
+-- view with the given name. The view returns the materialized buckets up to
+-- the last refresh and computes the later buckets from the hypertable, unless
+-- materialized_only is set. Nothing is materialized until the first refresh.
+--
+-- view_name - The name of the view to create
+-- query - The aggregate query, as text
+-- materialized_only - (Optional) Only return the materialized buckets
+-- schema_name - (Optional) The schema of the view. Defaults to the first
+--               schema in the search path
+CREATE OR REPLACE FUNCTION create_continuous_aggregate(
+    view_name               NAME,
+    query                   TEXT,
+    materialized_only       BOOLEAN = FALSE,
+    schema_name             NAME = NULL
+) RETURNS VOID AS '@MODULE_PATHNAME@', 'continuous_agg_create' LANGUAGE C VOLATILE;
+
+-- Refresh a continuous aggregate. Buckets that were modified since the last
+-- refresh are recomputed, and the buckets up to the latest time in the
+-- hypertable are materialized.
+--
+-- continuous_aggregate - The view of the continuous aggregate
+CREATE OR REPLACE FUNCTION refresh_continuous_aggregate(
+    continuous_aggregate    REGCLASS
+) RETURNS VOID AS '@MODULE_PATHNAME@', 'continuous_agg_refresh' LANGUAGE C VOLATILE;
+
+-- The watermark of a continuous aggregate, in the type of the given bucket
+-- (the value of which is ignored). Buckets below the watermark are
+-- materialized. Returns -infinity before the first refresh.
+CREATE OR REPLACE FUNCTION _timescaledb_internal.continuous_agg_watermark(
+    continuous_agg_id       INTEGER,
+    bucket                  ANYELEMENT
+) RETURNS ANYELEMENT AS '@MODULE_PATHNAME@', 'continuous_agg_watermark' LANGUAGE C STABLE;
+
+-- Trigger that records the time range of rows updated in or deleted from a
+-- hypertable, or the whole time range on truncation, as modified for the
+-- continuous aggregates of the hypertable.
+CREATE OR REPLACE FUNCTION _timescaledb_internal.continuous_agg_invalidate_trigger()
+    RETURNS TRIGGER AS '@MODULE_PATHNAME@', 'continuous_agg_invalidate_trigger' LANGUAGE C;
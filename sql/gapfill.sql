@@ -0,0 +1,20 @@
+-- time_bucket_gapfill buckets like time_bucket. When it is used in the GROUP BY
+-- clause of a query, a gap-filling node adds a row for every bucket between
+-- start (inclusive) and finish (exclusive) that has no data.
+CREATE OR REPLACE FUNCTION time_bucket_gapfill(bucket_width INTERVAL, ts TIMESTAMP, start TIMESTAMP, finish TIMESTAMP)
+	RETURNS TIMESTAMP
+	AS '@MODULE_PATHNAME@', 'timestamp_bucket_gapfill' LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION time_bucket_gapfill(bucket_width INTERVAL, ts TIMESTAMPTZ, start TIMESTAMPTZ, finish TIMESTAMPTZ)
+	RETURNS TIMESTAMPTZ
+	AS '@MODULE_PATHNAME@', 'timestamptz_bucket_gapfill' LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- locf and interpolate return their argument. In a gap-filled query, they
+-- mark the output columns whose values in missing buckets are carried forward
+-- from the previous bucket or linearly interpolated from the surrounding
+-- buckets, respectively.
+CREATE OR REPLACE FUNCTION locf(value ANYELEMENT) RETURNS ANYELEMENT
+	AS '@MODULE_PATHNAME@', 'gapfill_locf' LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION interpolate(value DOUBLE PRECISION) RETURNS DOUBLE PRECISION
+	AS '@MODULE_PATHNAME@', 'gapfill_interpolate' LANGUAGE C IMMUTABLE PARALLEL SAFE;
@@ -3,6 +3,16 @@ RETURNS INTERNAL
 AS '@MODULE_PATHNAME@', 'hist_sfunc'
 LANGUAGE C IMMUTABLE PARALLEL SAFE;
 
+CREATE OR REPLACE FUNCTION _timescaledb_internal.hist_msfunc (state INTERNAL, val DOUBLE PRECISION, MIN DOUBLE PRECISION, MAX DOUBLE PRECISION, nbuckets INTEGER)
+RETURNS INTERNAL
+AS '@MODULE_PATHNAME@', 'hist_msfunc'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION _timescaledb_internal.hist_minvfunc (state INTERNAL, val DOUBLE PRECISION, MIN DOUBLE PRECISION, MAX DOUBLE PRECISION, nbuckets INTEGER)
+RETURNS INTERNAL
+AS '@MODULE_PATHNAME@', 'hist_minvfunc'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
 CREATE OR REPLACE FUNCTION _timescaledb_internal.hist_combinefunc(state1 INTERNAL, state2 INTERNAL)
 RETURNS INTERNAL
 AS '@MODULE_PATHNAME@', 'hist_combinefunc'
@@ -33,5 +43,10 @@ CREATE AGGREGATE histogram (DOUBLE PRECISION, DOUBLE PRECISION, DOUBLE PRECISION
     DESERIALFUNC = _timescaledb_internal.hist_deserializefunc,
     PARALLEL = SAFE,
     FINALFUNC = _timescaledb_internal.hist_finalfunc,
-    FINALFUNC_EXTRA
+    FINALFUNC_EXTRA,
+    MSFUNC = _timescaledb_internal.hist_msfunc,
+    MINVFUNC = _timescaledb_internal.hist_minvfunc,
+    MSTYPE = INTERNAL,
+    MFINALFUNC = _timescaledb_internal.hist_finalfunc,
+    MFINALFUNC_EXTRA
 );
@@ -0,0 +1,76 @@
+CREATE OR REPLACE FUNCTION _timescaledb_internal.hll_sfunc(state INTERNAL, val ANYELEMENT)
+RETURNS INTERNAL
+AS '@MODULE_PATHNAME@', 'hll_sfunc'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION _timescaledb_internal.hll_sfunc(state INTERNAL, val ANYELEMENT, precision INTEGER)
+RETURNS INTERNAL
+AS '@MODULE_PATHNAME@', 'hll_sfunc'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION _timescaledb_internal.hll_union_sfunc(state INTERNAL, sketch BYTEA)
+RETURNS INTERNAL
+AS '@MODULE_PATHNAME@', 'hll_union_sfunc'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION _timescaledb_internal.hll_combinefunc(state1 INTERNAL, state2 INTERNAL)
+RETURNS INTERNAL
+AS '@MODULE_PATHNAME@', 'hll_combinefunc'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION _timescaledb_internal.hll_serializefunc(INTERNAL)
+RETURNS bytea
+AS '@MODULE_PATHNAME@', 'hll_serializefunc'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION _timescaledb_internal.hll_deserializefunc(bytea, INTERNAL)
+RETURNS INTERNAL
+AS '@MODULE_PATHNAME@', 'hll_deserializefunc'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION _timescaledb_internal.hll_finalfunc(state INTERNAL)
+RETURNS bytea
+AS '@MODULE_PATHNAME@', 'hll_finalfunc'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- Get the approximate number of distinct values from a sketch
+CREATE OR REPLACE FUNCTION distinct_count(sketch BYTEA)
+RETURNS BIGINT
+AS '@MODULE_PATHNAME@', 'hll_distinct_count'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+-- HyperLogLog sketch of the distinct values, with 2^12 registers
+DROP AGGREGATE IF EXISTS hyperloglog (ANYELEMENT);
+CREATE AGGREGATE hyperloglog (ANYELEMENT) (
+    SFUNC = _timescaledb_internal.hll_sfunc,
+    STYPE = INTERNAL,
+    COMBINEFUNC = _timescaledb_internal.hll_combinefunc,
+    SERIALFUNC = _timescaledb_internal.hll_serializefunc,
+    DESERIALFUNC = _timescaledb_internal.hll_deserializefunc,
+    PARALLEL = SAFE,
+    FINALFUNC = _timescaledb_internal.hll_finalfunc
+);
+
+-- HyperLogLog sketch of the distinct values, with 2^precision registers
+DROP AGGREGATE IF EXISTS hyperloglog (ANYELEMENT, INTEGER);
+CREATE AGGREGATE hyperloglog (ANYELEMENT, INTEGER) (
+    SFUNC = _timescaledb_internal.hll_sfunc,
+    STYPE = INTERNAL,
+    COMBINEFUNC = _timescaledb_internal.hll_combinefunc,
+    SERIALFUNC = _timescaledb_internal.hll_serializefunc,
+    DESERIALFUNC = _timescaledb_internal.hll_deserializefunc,
+    PARALLEL = SAFE,
+    FINALFUNC = _timescaledb_internal.hll_finalfunc
+);
+
+-- Union of sketches, e.g., to roll up stored sketches over longer time ranges
+DROP AGGREGATE IF EXISTS hyperloglog_union (BYTEA);
+CREATE AGGREGATE hyperloglog_union (BYTEA) (
+    SFUNC = _timescaledb_internal.hll_union_sfunc,
+    STYPE = INTERNAL,
+    COMBINEFUNC = _timescaledb_internal.hll_combinefunc,
+    SERIALFUNC = _timescaledb_internal.hll_serializefunc,
+    DESERIALFUNC = _timescaledb_internal.hll_deserializefunc,
+    PARALLEL = SAFE,
+    FINALFUNC = _timescaledb_internal.hll_finalfunc
+);
@@ -0,0 +1,51 @@
+-- This file defines functions for last point caches, which keep the latest
+-- row of every key of a hypertable in shared memory.
+
+-- Add a last point cache to a hypertable. The cache keeps, per value of the
+-- key column, the row with the latest time inserted through the hypertable,
+-- and is loaded with the latest row of every key when it is added. The cache
+-- lives in shared memory sized by timescaledb.last_point_cache_entries and
+-- timescaledb.last_point_cache_row_size, and is empty after a restart until
+-- it is refreshed. Updates, deletes, truncation, upserts and altering the
+-- hypertable empty the cache of the hypertable.
+--
+-- main_table - The hypertable to add the cache to
+-- key_column - The column whose values identify the series, e.g., a device
+--              ID. Its type must have a btree opclass
+-- if_not_exists - (Optional) Do not fail if the cache already exists
+CREATE OR REPLACE FUNCTION add_last_point_cache(
+    main_table              REGCLASS,
+    key_column              NAME,
+    if_not_exists           BOOLEAN = FALSE
+) RETURNS VOID AS '@MODULE_PATHNAME@', 'last_point_cache_add' LANGUAGE C VOLATILE;
+
+-- Remove the last point cache of a hypertable.
+--
+-- main_table - The hypertable to remove the cache from
+-- if_exists - (Optional) Do not fail if the cache does not exist
+CREATE OR REPLACE FUNCTION remove_last_point_cache(
+    main_table              REGCLASS,
+    if_exists               BOOLEAN = FALSE
+) RETURNS VOID AS '@MODULE_PATHNAME@', 'last_point_cache_remove' LANGUAGE C VOLATILE;
+
+-- Reload the last point cache of a hypertable with the latest row of every
+-- key, e.g., after a restart or once writes emptied the cache.
+--
+-- main_table - The hypertable whose cache to refresh
+CREATE OR REPLACE FUNCTION refresh_last_point_cache(
+    main_table              REGCLASS
+) RETURNS VOID AS '@MODULE_PATHNAME@', 'last_point_cache_refresh' LANGUAGE C VOLATILE;
+
+-- Return the cached rows of a hypertable, one per key, e.g.:
+--
+--   SELECT * FROM last_points(NULL::conditions);
+--
+-- main_table - A value of the hypertable's row type. Only its type is used
+CREATE OR REPLACE FUNCTION last_points(
+    main_table              ANYELEMENT
+) RETURNS SETOF ANYELEMENT AS '@MODULE_PATHNAME@', 'last_point_cache_rows' LANGUAGE C VOLATILE;
+
+-- Statement trigger that empties the last point cache of a hypertable when
+-- its rows are updated, deleted or truncated.
+CREATE OR REPLACE FUNCTION _timescaledb_internal.last_point_cache_reset_trigger()
+    RETURNS TRIGGER AS '@MODULE_PATHNAME@', 'last_point_cache_reset_trigger' LANGUAGE C;
@@ -0,0 +1,33 @@
+-- This file defines functions for min/max indexes, which track the range
+-- of values of a column in each chunk of a hypertable.
+
+-- Add a min/max index on a column of a hypertable. Chunks whose range of
+-- values in the column does not overlap the restrictions of a query are
+-- excluded when the query executes. Ranges of existing chunks are computed
+-- when the index is added.
+--
+-- main_table - The hypertable to add the index to
+-- column_name - The column to index. Must be of an integer or time type and
+--               must not be a partitioning column
+-- if_not_exists - (Optional) Do not fail if the index already exists
+CREATE OR REPLACE FUNCTION add_minmax_index(
+    main_table              REGCLASS,
+    column_name             NAME,
+    if_not_exists           BOOLEAN = FALSE
+) RETURNS VOID AS '@MODULE_PATHNAME@', 'minmax_index_add' LANGUAGE C VOLATILE;
+
+-- Remove a min/max index from a hypertable.
+--
+-- main_table - The hypertable to remove the index from
+-- column_name - The indexed column
+-- if_exists - (Optional) Do not fail if the index does not exist
+CREATE OR REPLACE FUNCTION remove_minmax_index(
+    main_table              REGCLASS,
+    column_name             NAME,
+    if_exists               BOOLEAN = FALSE
+) RETURNS VOID AS '@MODULE_PATHNAME@', 'minmax_index_remove' LANGUAGE C VOLATILE;
+
+-- Row trigger that keeps the min/max ranges of a chunk up to date for rows
+-- that are not tracked by the insert path, e.g., updated rows.
+CREATE OR REPLACE FUNCTION _timescaledb_internal.minmax_range_trigger()
+    RETURNS TRIGGER AS '@MODULE_PATHNAME@', 'minmax_range_trigger' LANGUAGE C;
@@ -0,0 +1,76 @@
+CREATE OR REPLACE FUNCTION _timescaledb_internal.percentile_sketch_sfunc(state INTERNAL, val DOUBLE PRECISION)
+RETURNS INTERNAL
+AS '@MODULE_PATHNAME@', 'percentile_sketch_sfunc'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION _timescaledb_internal.percentile_sketch_sfunc(state INTERNAL, val DOUBLE PRECISION, relative_accuracy DOUBLE PRECISION)
+RETURNS INTERNAL
+AS '@MODULE_PATHNAME@', 'percentile_sketch_sfunc'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION _timescaledb_internal.percentile_sketch_merge_sfunc(state INTERNAL, sketch BYTEA)
+RETURNS INTERNAL
+AS '@MODULE_PATHNAME@', 'percentile_sketch_merge_sfunc'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION _timescaledb_internal.percentile_sketch_combinefunc(state1 INTERNAL, state2 INTERNAL)
+RETURNS INTERNAL
+AS '@MODULE_PATHNAME@', 'percentile_sketch_combinefunc'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION _timescaledb_internal.percentile_sketch_serializefunc(INTERNAL)
+RETURNS bytea
+AS '@MODULE_PATHNAME@', 'percentile_sketch_serializefunc'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION _timescaledb_internal.percentile_sketch_deserializefunc(bytea, INTERNAL)
+RETURNS INTERNAL
+AS '@MODULE_PATHNAME@', 'percentile_sketch_deserializefunc'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION _timescaledb_internal.percentile_sketch_finalfunc(state INTERNAL)
+RETURNS bytea
+AS '@MODULE_PATHNAME@', 'percentile_sketch_finalfunc'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- Get an approximate percentile (between 0 and 1) from a sketch
+CREATE OR REPLACE FUNCTION approx_percentile(percentile DOUBLE PRECISION, sketch BYTEA)
+RETURNS DOUBLE PRECISION
+AS '@MODULE_PATHNAME@', 'approx_percentile'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+-- Sketch of the distribution of values, with a relative accuracy of 1%
+DROP AGGREGATE IF EXISTS percentile_sketch (DOUBLE PRECISION);
+CREATE AGGREGATE percentile_sketch (DOUBLE PRECISION) (
+    SFUNC = _timescaledb_internal.percentile_sketch_sfunc,
+    STYPE = INTERNAL,
+    COMBINEFUNC = _timescaledb_internal.percentile_sketch_combinefunc,
+    SERIALFUNC = _timescaledb_internal.percentile_sketch_serializefunc,
+    DESERIALFUNC = _timescaledb_internal.percentile_sketch_deserializefunc,
+    PARALLEL = SAFE,
+    FINALFUNC = _timescaledb_internal.percentile_sketch_finalfunc
+);
+
+-- Sketch of the distribution of values, with a given relative accuracy
+DROP AGGREGATE IF EXISTS percentile_sketch (DOUBLE PRECISION, DOUBLE PRECISION);
+CREATE AGGREGATE percentile_sketch (DOUBLE PRECISION, DOUBLE PRECISION) (
+    SFUNC = _timescaledb_internal.percentile_sketch_sfunc,
+    STYPE = INTERNAL,
+    COMBINEFUNC = _timescaledb_internal.percentile_sketch_combinefunc,
+    SERIALFUNC = _timescaledb_internal.percentile_sketch_serializefunc,
+    DESERIALFUNC = _timescaledb_internal.percentile_sketch_deserializefunc,
+    PARALLEL = SAFE,
+    FINALFUNC = _timescaledb_internal.percentile_sketch_finalfunc
+);
+
+-- Merge sketches, e.g., to roll up stored sketches over longer time ranges
+DROP AGGREGATE IF EXISTS percentile_sketch_merge (BYTEA);
+CREATE AGGREGATE percentile_sketch_merge (BYTEA) (
+    SFUNC = _timescaledb_internal.percentile_sketch_merge_sfunc,
+    STYPE = INTERNAL,
+    COMBINEFUNC = _timescaledb_internal.percentile_sketch_combinefunc,
+    SERIALFUNC = _timescaledb_internal.percentile_sketch_serializefunc,
+    DESERIALFUNC = _timescaledb_internal.percentile_sketch_deserializefunc,
+    PARALLEL = SAFE,
+    FINALFUNC = _timescaledb_internal.percentile_sketch_finalfunc
+);
@@ -0,0 +1,175 @@
+CREATE OR REPLACE FUNCTION _timescaledb_internal.ts_summary_sfunc(state INTERNAL, value DOUBLE PRECISION, time TIMESTAMPTZ)
+RETURNS INTERNAL
+AS '@MODULE_PATHNAME@', 'ts_summary_sfunc'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION _timescaledb_internal.ts_points_combinefunc(state1 INTERNAL, state2 INTERNAL)
+RETURNS INTERNAL
+AS '@MODULE_PATHNAME@', 'ts_points_combinefunc'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION _timescaledb_internal.ts_points_serializefunc(INTERNAL)
+RETURNS bytea
+AS '@MODULE_PATHNAME@', 'ts_points_serializefunc'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION _timescaledb_internal.ts_points_deserializefunc(bytea, INTERNAL)
+RETURNS INTERNAL
+AS '@MODULE_PATHNAME@', 'ts_points_deserializefunc'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION _timescaledb_internal.time_weight_avg_finalfunc(state INTERNAL)
+RETURNS DOUBLE PRECISION
+AS '@MODULE_PATHNAME@', 'time_weight_avg_finalfunc'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION _timescaledb_internal.counter_rate_finalfunc(state INTERNAL)
+RETURNS DOUBLE PRECISION
+AS '@MODULE_PATHNAME@', 'counter_rate_finalfunc'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION _timescaledb_internal.delta_sfunc(state INTERNAL, value DOUBLE PRECISION, time TIMESTAMPTZ)
+RETURNS INTERNAL
+AS '@MODULE_PATHNAME@', 'delta_sfunc'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION _timescaledb_internal.delta_combinefunc(state1 INTERNAL, state2 INTERNAL)
+RETURNS INTERNAL
+AS '@MODULE_PATHNAME@', 'delta_combinefunc'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION _timescaledb_internal.delta_serializefunc(INTERNAL)
+RETURNS bytea
+AS '@MODULE_PATHNAME@', 'delta_serializefunc'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION _timescaledb_internal.delta_deserializefunc(bytea, INTERNAL)
+RETURNS INTERNAL
+AS '@MODULE_PATHNAME@', 'delta_deserializefunc'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION _timescaledb_internal.delta_finalfunc(state INTERNAL)
+RETURNS DOUBLE PRECISION
+AS '@MODULE_PATHNAME@', 'delta_finalfunc'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION _timescaledb_internal.downsample_sfunc(state INTERNAL, value DOUBLE PRECISION, time TIMESTAMPTZ, resolution INTEGER)
+RETURNS INTERNAL
+AS '@MODULE_PATHNAME@', 'downsample_sfunc'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION _timescaledb_internal.lttb_finalfunc(state INTERNAL)
+RETURNS bytea
+AS '@MODULE_PATHNAME@', 'lttb_finalfunc'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION _timescaledb_internal.minmax_downsample_finalfunc(state INTERNAL)
+RETURNS bytea
+AS '@MODULE_PATHNAME@', 'minmax_downsample_finalfunc'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION _timescaledb_internal.minmax_buckets_sfunc(state INTERNAL, value DOUBLE PRECISION, time TIMESTAMPTZ, resolution INTEGER, start TIMESTAMPTZ, finish TIMESTAMPTZ)
+RETURNS INTERNAL
+AS '@MODULE_PATHNAME@', 'minmax_buckets_sfunc'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION _timescaledb_internal.minmax_buckets_combinefunc(state1 INTERNAL, state2 INTERNAL)
+RETURNS INTERNAL
+AS '@MODULE_PATHNAME@', 'minmax_buckets_combinefunc'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION _timescaledb_internal.minmax_buckets_serializefunc(INTERNAL)
+RETURNS bytea
+AS '@MODULE_PATHNAME@', 'minmax_buckets_serializefunc'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION _timescaledb_internal.minmax_buckets_deserializefunc(bytea, INTERNAL)
+RETURNS INTERNAL
+AS '@MODULE_PATHNAME@', 'minmax_buckets_deserializefunc'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+CREATE OR REPLACE FUNCTION _timescaledb_internal.minmax_buckets_finalfunc(state INTERNAL)
+RETURNS bytea
+AS '@MODULE_PATHNAME@', 'minmax_buckets_finalfunc'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- Expand a series of points returned by lttb() or minmax_downsample() into rows
+CREATE OR REPLACE FUNCTION unnest_points(series bytea)
+RETURNS TABLE (time TIMESTAMPTZ, value DOUBLE PRECISION)
+AS '@MODULE_PATHNAME@', 'ts_points_unnest'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+-- Average of value weighted by how long each value was held. Rows must be
+-- aggregated in time-ordered runs, otherwise the call needs an ORDER BY,
+-- e.g., time_weight_avg(value, time ORDER BY time). The rows of parallel
+-- workers interleave, so partial states cannot be combined.
+DROP AGGREGATE IF EXISTS time_weight_avg (DOUBLE PRECISION, TIMESTAMPTZ);
+CREATE AGGREGATE time_weight_avg (DOUBLE PRECISION, TIMESTAMPTZ) (
+    SFUNC = _timescaledb_internal.ts_summary_sfunc,
+    STYPE = INTERNAL,
+    PARALLEL = RESTRICTED,
+    FINALFUNC = _timescaledb_internal.time_weight_avg_finalfunc
+);
+
+-- Per-second rate of increase of a counter, accounting for counter resets.
+-- Rows must be aggregated in time-ordered runs, like for time_weight_avg().
+DROP AGGREGATE IF EXISTS counter_rate (DOUBLE PRECISION, TIMESTAMPTZ);
+CREATE AGGREGATE counter_rate (DOUBLE PRECISION, TIMESTAMPTZ) (
+    SFUNC = _timescaledb_internal.ts_summary_sfunc,
+    STYPE = INTERNAL,
+    PARALLEL = RESTRICTED,
+    FINALFUNC = _timescaledb_internal.counter_rate_finalfunc
+);
+
+-- Value at the latest time minus value at the earliest time
+DROP AGGREGATE IF EXISTS delta (DOUBLE PRECISION, TIMESTAMPTZ);
+CREATE AGGREGATE delta (DOUBLE PRECISION, TIMESTAMPTZ) (
+    SFUNC = _timescaledb_internal.delta_sfunc,
+    STYPE = INTERNAL,
+    COMBINEFUNC = _timescaledb_internal.delta_combinefunc,
+    SERIALFUNC = _timescaledb_internal.delta_serializefunc,
+    DESERIALFUNC = _timescaledb_internal.delta_deserializefunc,
+    PARALLEL = SAFE,
+    FINALFUNC = _timescaledb_internal.delta_finalfunc
+);
+
+-- Downsample a series to at most resolution points with largest-triangle-three-buckets.
+-- Keeps every point of the group in memory until the final function.
+DROP AGGREGATE IF EXISTS lttb (DOUBLE PRECISION, TIMESTAMPTZ, INTEGER);
+CREATE AGGREGATE lttb (DOUBLE PRECISION, TIMESTAMPTZ, INTEGER) (
+    SFUNC = _timescaledb_internal.downsample_sfunc,
+    STYPE = INTERNAL,
+    COMBINEFUNC = _timescaledb_internal.ts_points_combinefunc,
+    SERIALFUNC = _timescaledb_internal.ts_points_serializefunc,
+    DESERIALFUNC = _timescaledb_internal.ts_points_deserializefunc,
+    PARALLEL = SAFE,
+    FINALFUNC = _timescaledb_internal.lttb_finalfunc
+);
+
+-- Downsample a series to the minimum and maximum points of resolution / 2 time ranges over
+-- the time range of the series. Keeps every point of the group in memory until the
+-- final function; see below for a variant with a fixed time range that does not.
+DROP AGGREGATE IF EXISTS minmax_downsample (DOUBLE PRECISION, TIMESTAMPTZ, INTEGER);
+CREATE AGGREGATE minmax_downsample (DOUBLE PRECISION, TIMESTAMPTZ, INTEGER) (
+    SFUNC = _timescaledb_internal.downsample_sfunc,
+    STYPE = INTERNAL,
+    COMBINEFUNC = _timescaledb_internal.ts_points_combinefunc,
+    SERIALFUNC = _timescaledb_internal.ts_points_serializefunc,
+    DESERIALFUNC = _timescaledb_internal.ts_points_deserializefunc,
+    PARALLEL = SAFE,
+    FINALFUNC = _timescaledb_internal.minmax_downsample_finalfunc
+);
+
+-- Downsample a series to the minimum and maximum points of resolution / 2 time ranges
+-- between start and finish. Rows outside of [start, finish) are ignored. Only keeps
+-- the minimum and maximum of each time range, so memory does not grow with the rows.
+DROP AGGREGATE IF EXISTS minmax_downsample (DOUBLE PRECISION, TIMESTAMPTZ, INTEGER, TIMESTAMPTZ, TIMESTAMPTZ);
+CREATE AGGREGATE minmax_downsample (DOUBLE PRECISION, TIMESTAMPTZ, INTEGER, TIMESTAMPTZ, TIMESTAMPTZ) (
+    SFUNC = _timescaledb_internal.minmax_buckets_sfunc,
+    STYPE = INTERNAL,
+    COMBINEFUNC = _timescaledb_internal.minmax_buckets_combinefunc,
+    SERIALFUNC = _timescaledb_internal.minmax_buckets_serializefunc,
+    DESERIALFUNC = _timescaledb_internal.minmax_buckets_deserializefunc,
+    PARALLEL = SAFE,
+    FINALFUNC = _timescaledb_internal.minmax_buckets_finalfunc
+);
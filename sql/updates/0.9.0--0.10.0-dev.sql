@@ -0,0 +1,145 @@
+-- A compressed chunk stores its rows in columnar, compressed batches in a
+-- separate table, given by 'schema_name' and 'table_name'. The chunk's own
+-- table is kept (empty) so that the chunk retains its constraints and its
+-- place in the hypertable. The segment_by columns are stored uncompressed,
+-- one value per batch.
+CREATE TABLE IF NOT EXISTS _timescaledb_catalog.compressed_chunk (
+    chunk_id        INTEGER  PRIMARY KEY REFERENCES _timescaledb_catalog.chunk(id) ON DELETE CASCADE,
+    schema_name     NAME     NOT NULL,
+    table_name      NAME     NOT NULL,
+    segment_by      NAME[]   NOT NULL,
+    UNIQUE (schema_name, table_name)
+);
+SELECT pg_catalog.pg_extension_config_dump('_timescaledb_catalog.compressed_chunk', '');
+
+GRANT SELECT ON _timescaledb_catalog.compressed_chunk TO PUBLIC;
+
+-- A min/max index tracks, per chunk, the range of values in a
+-- non-partitioning column of a hypertable. Queries that restrict the
+-- column can skip chunks whose range does not overlap the restriction.
+CREATE TABLE IF NOT EXISTS _timescaledb_catalog.minmax_index (
+    id              SERIAL   NOT NULL PRIMARY KEY,
+    hypertable_id   INTEGER  NOT NULL REFERENCES _timescaledb_catalog.hypertable(id) ON DELETE CASCADE,
+    column_name     NAME     NOT NULL,
+    UNIQUE (hypertable_id, column_name)
+);
+SELECT pg_catalog.pg_extension_config_dump('_timescaledb_catalog.minmax_index', '');
+SELECT pg_catalog.pg_extension_config_dump(pg_get_serial_sequence('_timescaledb_catalog.minmax_index','id'), '');
+
+-- The range of values of a min/max indexed column in a chunk, stored in
+-- the same internal representation as time dimension values. The range
+-- is NULL if the chunk has no non-NULL values in the column. A chunk
+-- without a row here has an unknown range and is never excluded.
+CREATE TABLE IF NOT EXISTS _timescaledb_catalog.chunk_minmax (
+    chunk_id          INTEGER  NOT NULL REFERENCES _timescaledb_catalog.chunk(id) ON DELETE CASCADE,
+    minmax_index_id   INTEGER  NOT NULL REFERENCES _timescaledb_catalog.minmax_index(id) ON DELETE CASCADE,
+    min_value         BIGINT   NULL,
+    max_value         BIGINT   NULL,
+    PRIMARY KEY (chunk_id, minmax_index_id),
+    CHECK (min_value <= max_value)
+);
+SELECT pg_catalog.pg_extension_config_dump('_timescaledb_catalog.chunk_minmax', '');
+
+GRANT SELECT ON _timescaledb_catalog.minmax_index TO PUBLIC;
+GRANT SELECT ON _timescaledb_catalog.chunk_minmax TO PUBLIC;
+
+-- A bloom filter tracks, per chunk, the set of values in a
+-- non-partitioning column of a hypertable. Queries with an equality
+-- restriction on the column can skip chunks that certainly do not
+-- contain the value.
+CREATE TABLE IF NOT EXISTS _timescaledb_catalog.bloom_filter (
+    id                    SERIAL   NOT NULL PRIMARY KEY,
+    hypertable_id         INTEGER  NOT NULL REFERENCES _timescaledb_catalog.hypertable(id) ON DELETE CASCADE,
+    column_name           NAME     NOT NULL,
+    false_positive_rate   FLOAT8   NOT NULL CHECK (false_positive_rate > 0 AND false_positive_rate < 1),
+    UNIQUE (hypertable_id, column_name)
+);
+SELECT pg_catalog.pg_extension_config_dump('_timescaledb_catalog.bloom_filter', '');
+SELECT pg_catalog.pg_extension_config_dump(pg_get_serial_sequence('_timescaledb_catalog.bloom_filter','id'), '');
+
+-- The bloom filter of a column in a chunk. A chunk without a row here has
+-- no filter and is never excluded. Filters are built for chunks that no
+-- longer receive writes and are removed when the chunk is written to.
+CREATE TABLE IF NOT EXISTS _timescaledb_catalog.chunk_bloom_filter (
+    chunk_id          INTEGER  NOT NULL REFERENCES _timescaledb_catalog.chunk(id) ON DELETE CASCADE,
+    bloom_filter_id   INTEGER  NOT NULL REFERENCES _timescaledb_catalog.bloom_filter(id) ON DELETE CASCADE,
+    num_hashes        INTEGER  NOT NULL CHECK (num_hashes > 0),
+    filter            BYTEA    NOT NULL,
+    PRIMARY KEY (chunk_id, bloom_filter_id)
+);
+-- The filter bits are random, so do not try to compress them
+ALTER TABLE _timescaledb_catalog.chunk_bloom_filter ALTER COLUMN filter SET STORAGE EXTERNAL;
+SELECT pg_catalog.pg_extension_config_dump('_timescaledb_catalog.chunk_bloom_filter', '');
+
+GRANT SELECT ON _timescaledb_catalog.bloom_filter TO PUBLIC;
+GRANT SELECT ON _timescaledb_catalog.chunk_bloom_filter TO PUBLIC;
+
+-- Aggregate statistics of a chunk: its number of rows and the range of its
+-- time column in internal time format. Statistics are recorded for chunks
+-- that no longer receive writes and are removed when the chunk is written
+-- to, so a chunk with a row here has exactly these statistics.
+CREATE TABLE IF NOT EXISTS _timescaledb_catalog.chunk_stats (
+    chunk_id    INTEGER  NOT NULL PRIMARY KEY REFERENCES _timescaledb_catalog.chunk(id) ON DELETE CASCADE,
+    row_count   BIGINT   NOT NULL CHECK (row_count >= 0),
+    min_time    BIGINT   NULL,
+    max_time    BIGINT   NULL,
+    CHECK (min_time <= max_time),
+    CHECK ((row_count = 0) = (min_time IS NULL) AND (row_count = 0) = (max_time IS NULL))
+);
+SELECT pg_catalog.pg_extension_config_dump('_timescaledb_catalog.chunk_stats', '');
+
+GRANT SELECT ON _timescaledb_catalog.chunk_stats TO PUBLIC;
+
+-- A continuous aggregate materializes an aggregate query that groups the rows
+-- of a hypertable by time_bucket() of the hypertable's time column. The query
+-- is stored as the direct view and its result, one row per group, in the
+-- materialization table. The user view returns the materialized buckets
+-- below the watermark (in internal time format) and, unless
+-- materialized_only is set, computes the buckets at or above the watermark
+-- from the hypertable. The bucket width is in the internal unit of time.
+CREATE TABLE IF NOT EXISTS _timescaledb_catalog.continuous_agg (
+    id                   SERIAL   NOT NULL PRIMARY KEY,
+    hypertable_id        INTEGER  NOT NULL REFERENCES _timescaledb_catalog.hypertable(id) ON DELETE CASCADE,
+    user_view_schema     NAME     NOT NULL,
+    user_view_name       NAME     NOT NULL,
+    direct_view_schema   NAME     NOT NULL,
+    direct_view_name     NAME     NOT NULL,
+    mat_table_schema     NAME     NOT NULL,
+    mat_table_name       NAME     NOT NULL,
+    bucket_column_name   NAME     NOT NULL,
+    bucket_width         BIGINT   NOT NULL CHECK (bucket_width > 0),
+    materialized_only    BOOLEAN  NOT NULL,
+    watermark            BIGINT   NULL,
+    UNIQUE (user_view_schema, user_view_name)
+);
+CREATE INDEX IF NOT EXISTS continuous_agg_hypertable_id_idx
+ON _timescaledb_catalog.continuous_agg(hypertable_id);
+SELECT pg_catalog.pg_extension_config_dump('_timescaledb_catalog.continuous_agg', '');
+SELECT pg_catalog.pg_extension_config_dump(pg_get_serial_sequence('_timescaledb_catalog.continuous_agg','id'), '');
+
+-- Ranges of the time column, in internal time format, that were modified in
+-- the hypertable of a continuous aggregate since the aggregate was last
+-- refreshed. A refresh recomputes the materialized buckets that overlap the
+-- ranges and removes the ranges.
+CREATE TABLE IF NOT EXISTS _timescaledb_catalog.continuous_agg_invalidation_log (
+    continuous_agg_id         INTEGER  NOT NULL REFERENCES _timescaledb_catalog.continuous_agg(id) ON DELETE CASCADE,
+    lowest_modified_value     BIGINT   NOT NULL,
+    greatest_modified_value   BIGINT   NOT NULL,
+    CHECK (lowest_modified_value <= greatest_modified_value)
+);
+CREATE INDEX IF NOT EXISTS continuous_agg_invalidation_log_continuous_agg_id_idx
+ON _timescaledb_catalog.continuous_agg_invalidation_log(continuous_agg_id);
+SELECT pg_catalog.pg_extension_config_dump('_timescaledb_catalog.continuous_agg_invalidation_log', '');
+
+-- Hypertables whose most recent row per value of the key column is kept in
+-- the last point cache in shared memory. The cached rows themselves are not
+-- stored in the catalog.
+CREATE TABLE IF NOT EXISTS _timescaledb_catalog.last_point_cache (
+    hypertable_id     INTEGER  NOT NULL PRIMARY KEY REFERENCES _timescaledb_catalog.hypertable(id) ON DELETE CASCADE,
+    key_column_name   NAME     NOT NULL
+);
+SELECT pg_catalog.pg_extension_config_dump('_timescaledb_catalog.last_point_cache', '');
+
+GRANT SELECT ON _timescaledb_catalog.continuous_agg TO PUBLIC;
+GRANT SELECT ON _timescaledb_catalog.continuous_agg_invalidation_log TO PUBLIC;
+GRANT SELECT ON _timescaledb_catalog.last_point_cache TO PUBLIC;
@@ -1,9 +1,14 @@
 #include <postgres.h>
 #include <fmgr.h>
+#include <access/tupmacs.h>
 #include <catalog/namespace.h>
 #include <nodes/value.h>
 #include <utils/lsyscache.h>
 #include <utils/datum.h>
+#include <utils/builtins.h>
+#include <utils/expandeddatum.h>
+#include <utils/timestamp.h>
+#include <catalog/pg_type.h>
 #include <lib/stringinfo.h>
 #include <libpq/pqformat.h>
 
@@ -24,6 +29,10 @@ TS_FUNCTION_INFO_V1(last_combinefunc);
 TS_FUNCTION_INFO_V1(bookend_finalfunc);
 TS_FUNCTION_INFO_V1(bookend_serializefunc);
 TS_FUNCTION_INFO_V1(bookend_deserializefunc);
+TS_FUNCTION_INFO_V1(first_msfunc);
+TS_FUNCTION_INFO_V1(last_msfunc);
+TS_FUNCTION_INFO_V1(bookend_minvfunc);
+TS_FUNCTION_INFO_V1(bookend_moving_finalfunc);
 
 /* A  PolyDatum represents a polymorphic datum */
 typedef struct PolyDatum
@@ -38,6 +47,9 @@ typedef struct PolyDatum
 typedef struct PolyDatumIOState
 {
 	Oid			type;
+	int16		typlen;
+	bool		typbyval;
+	/* send or receive function, only used for variable-length types */
 	FmgrInfo	proc;
 	Oid			typeioparam;
 } PolyDatumIOState;
@@ -60,13 +72,66 @@ polydatum_from_arg(int argno, FunctionCallInfo fcinfo)
 	return value;
 }
 
-/* serializes the polydatum pd unto buf */
+static void
+polydatum_iostate_set_type(PolyDatumIOState *state, Oid type, bool send, FunctionCallInfo fcinfo)
+{
+	Oid			func;
+	bool		is_varlena;
+
+	if (state->type == type)
+		return;
+
+	get_typlenbyval(type, &state->typlen, &state->typbyval);
+
+	if (state->typlen <= 0)
+	{
+		if (send)
+			getTypeBinaryOutputInfo(type, &func, &is_varlena);
+		else
+			getTypeBinaryInputInfo(type, &func, &state->typeioparam);
+
+		fmgr_info_cxt(func, &state->proc, fcinfo->flinfo->fn_mcxt);
+	}
+	state->type = type;
+}
+
+/*
+ * Serializes the polydatum pd unto buf.
+ *
+ * Values of fixed-length types are written as a null flag followed by their
+ * raw bytes. Values of other types are written with the type's send function,
+ * prefixed by their length (-1 for NULL).
+ */
 static void
 polydatum_serialize(PolyDatum *pd, StringInfo buf, PolyDatumIOState *state, FunctionCallInfo fcinfo)
 {
 	bytea	   *outputbytes;
 
 	pq_sendint(buf, pd->type, sizeof(Oid));
+	polydatum_iostate_set_type(state, pd->type, true, fcinfo);
+
+	if (state->typlen > 0)
+	{
+		pq_sendbyte(buf, pd->is_null);
+
+		if (pd->is_null)
+			return;
+
+		if (state->typbyval)
+		{
+			union
+			{
+				Datum		datum;
+				char		data[sizeof(Datum)];
+			}			raw;
+
+			store_att_byval(raw.data, pd->datum, state->typlen);
+			pq_sendbytes(buf, raw.data, state->typlen);
+		}
+		else
+			pq_sendbytes(buf, DatumGetPointer(pd->datum), state->typlen);
+		return;
+	}
 
 	if (pd->is_null)
 	{
@@ -75,18 +140,6 @@ polydatum_serialize(PolyDatum *pd, StringInfo buf, PolyDatumIOState *state, Func
 		return;
 	}
 
-	if (state->type != pd->type)
-	{
-		Oid			func;
-		bool		is_varlena;
-
-		getTypeBinaryOutputInfo(pd->type,
-								&func,
-								&is_varlena);
-		fmgr_info_cxt(func, &state->proc,
-					  fcinfo->flinfo->fn_mcxt);
-		state->type = pd->type;
-	}
 	outputbytes = SendFunctionCall(&state->proc, pd->datum);
 	pq_sendint(buf, VARSIZE(outputbytes) - VARHDRSZ, 4);
 	pq_sendbytes(buf, VARDATA(outputbytes), VARSIZE(outputbytes) - VARHDRSZ);
@@ -111,6 +164,42 @@ polydatum_deserialize(PolyDatum *result, StringInfo buf, PolyDatumIOState *state
 	}
 
 	result->type = pq_getmsgint(buf, sizeof(Oid));
+	polydatum_iostate_set_type(state, result->type, false, fcinfo);
+
+	if (state->typlen > 0)
+	{
+		const char *data;
+
+		result->is_null = pq_getmsgbyte(buf) != 0;
+
+		if (result->is_null)
+		{
+			result->datum = PointerGetDatum(NULL);
+			return result;
+		}
+
+		data = pq_getmsgbytes(buf, state->typlen);
+
+		if (state->typbyval)
+		{
+			union
+			{
+				Datum		datum;
+				char		data[sizeof(Datum)];
+			}			raw;
+
+			memcpy(raw.data, data, state->typlen);
+			result->datum = fetch_att(raw.data, true, state->typlen);
+		}
+		else
+		{
+			char	   *copy = palloc(state->typlen);
+
+			memcpy(copy, data, state->typlen);
+			result->datum = PointerGetDatum(copy);
+		}
+		return result;
+	}
 
 	/* Following is copied/adapted from record_recv in core postgres */
 
@@ -151,18 +240,6 @@ polydatum_deserialize(PolyDatum *result, StringInfo buf, PolyDatumIOState *state
 	}
 
 	/* Now call the column's receiveproc */
-	if (state->type != result->type)
-	{
-		Oid			func;
-
-		getTypeBinaryInputInfo(result->type,
-							   &func,
-							   &state->typeioparam);
-		fmgr_info_cxt(func, &state->proc,
-					  fcinfo->flinfo->fn_mcxt);
-		state->type = result->type;
-	}
-
 	result->datum = ReceiveFunctionCall(&state->proc,
 										bufptr,
 										state->typeioparam,
@@ -181,11 +258,23 @@ polydatum_deserialize(PolyDatum *result, StringInfo buf, PolyDatumIOState *state
 	return result;
 }
 
+/*
+ * Memory owned by the aggregate state for storing a by-reference datum. It is
+ * reused when the stored datum is replaced, if large enough.
+ */
+typedef struct DatumBuffer
+{
+	Pointer		data;
+	Size		size;
+} DatumBuffer;
+
 /* Internal state for bookend aggregates */
 typedef struct InternalCmpAggStore
 {
 	PolyDatum	value;
 	PolyDatum	cmp;			/* the comparison element. e.g. time */
+	DatumBuffer value_buf;
+	DatumBuffer cmp_buf;
 } InternalCmpAggStore;
 
 /* State used to cache data for serialize/deserialize operations */
@@ -208,25 +297,117 @@ typeinfocache_init(TypeInfoCache *tic)
 	tic->type = InvalidOid;
 }
 
+/*
+ * Copy a PolyDatum into the aggregate state. By-value datums are stored as is,
+ * while by-reference datums are copied into the state's buffer. Must be called
+ * in the aggregate memory context.
+ */
 inline static void
-typeinfocache_polydatumcopy(TypeInfoCache *tic, PolyDatum input, PolyDatum *output)
+typeinfocache_polydatumcopy(TypeInfoCache *tic, PolyDatum input, PolyDatum *output, DatumBuffer *buf)
 {
+	Pointer		ptr;
+	Size		size;
+
 	if (tic->type != input.type)
 	{
 		tic->type = input.type;
 		get_typlenbyval(tic->type, &tic->typelen, &tic->typebyval);
 	}
 	*output = input;
-	if (!input.is_null)
-		output->datum = datumCopy(input.datum, tic->typebyval, tic->typelen);
-	else
+
+	if (input.is_null)
+	{
 		output->datum = PointerGetDatum(NULL);
+		return;
+	}
+
+	if (tic->typebyval)
+		return;
+
+	ptr = DatumGetPointer(input.datum);
+
+	/* expanded objects are flattened, like datumCopy() does */
+	if (tic->typelen == -1 && VARATT_IS_EXTERNAL_EXPANDED(ptr))
+		size = EOH_get_flat_size(DatumGetEOHP(input.datum));
+	else
+		size = datumGetSize(input.datum, false, tic->typelen);
+
+	if (buf->size < size)
+	{
+		if (buf->data != NULL)
+			pfree(buf->data);
+		buf->data = palloc(size);
+		buf->size = size;
+	}
+
+	if (tic->typelen == -1 && VARATT_IS_EXTERNAL_EXPANDED(ptr))
+		EOH_flatten_into(DatumGetEOHP(input.datum), buf->data, size);
+	else
+		memcpy(buf->data, ptr, size);
+
+	output->datum = PointerGetDatum(buf->data);
+}
+
+/* Native three-way comparison of by-value datums of the same type */
+typedef int (*datum_cmp_func) (Datum left, Datum right);
+
+static int
+int4_datum_cmp(Datum left, Datum right)
+{
+	int32		l = DatumGetInt32(left);
+	int32		r = DatumGetInt32(right);
+
+	return (l > r) - (l < r);
+}
+
+static int
+int8_datum_cmp(Datum left, Datum right)
+{
+	int64		l = DatumGetInt64(left);
+	int64		r = DatumGetInt64(right);
+
+	return (l > r) - (l < r);
+}
+
+static int
+timestamp_datum_cmp(Datum left, Datum right)
+{
+	return timestamp_cmp_internal(DatumGetTimestamp(left), DatumGetTimestamp(right));
+}
+
+static int
+float8_datum_cmp(Datum left, Datum right)
+{
+	/* NaN sorts above all other values, like for the < operator */
+	return float8_cmp_internal(DatumGetFloat8(left), DatumGetFloat8(right));
+}
+
+static datum_cmp_func
+native_cmp_for_type(Oid type)
+{
+	switch (type)
+	{
+		case INT4OID:
+		case DATEOID:
+			return int4_datum_cmp;
+		case INT8OID:
+			return int8_datum_cmp;
+		case TIMESTAMPOID:
+		case TIMESTAMPTZOID:
+			return timestamp_datum_cmp;
+		case FLOAT8OID:
+			return float8_datum_cmp;
+		default:
+			return NULL;
+	}
 }
 
 typedef struct CmpFuncCache
 {
 	Oid			cmp_type;
 	char		op;
+	/* native comparison for common types, otherwise the operator's proc */
+	datum_cmp_func native_cmp;
 	FmgrInfo	proc;
 } CmpFuncCache;
 
@@ -249,15 +430,31 @@ cmpfunccache_cmp(CmpFuncCache *cache, FunctionCallInfo fcinfo, char *opname, Pol
 
 		if (!OidIsValid(left.type))
 			elog(ERROR, "could not determine the type of the comparison_element");
-		cmp_op = OpernameGetOprid(list_make1(makeString(opname)), left.type, left.type);
-		if (!OidIsValid(cmp_op))
-			elog(ERROR, "could not find a %s operator for type %d", opname, left.type);
-		cmp_regproc = get_opcode(cmp_op);
-		if (!OidIsValid(cmp_regproc))
-			elog(ERROR, "could not find the procedure for the %s operator for type %d", opname, left.type);
-		fmgr_info_cxt(cmp_regproc, &cache->proc,
-					  fcinfo->flinfo->fn_mcxt);
+
+		cache->native_cmp = native_cmp_for_type(left.type);
+
+		if (cache->native_cmp == NULL)
+		{
+			cmp_op = OpernameGetOprid(list_make1(makeString(opname)), left.type, left.type);
+			if (!OidIsValid(cmp_op))
+				elog(ERROR, "could not find a %s operator for type %d", opname, left.type);
+			cmp_regproc = get_opcode(cmp_op);
+			if (!OidIsValid(cmp_regproc))
+				elog(ERROR, "could not find the procedure for the %s operator for type %d", opname, left.type);
+			fmgr_info_cxt(cmp_regproc, &cache->proc,
+						  fcinfo->flinfo->fn_mcxt);
+		}
+		cache->cmp_type = left.type;
+		cache->op = opname[0];
+	}
+
+	if (cache->native_cmp != NULL)
+	{
+		int			cmp = cache->native_cmp(left.datum, right.datum);
+
+		return cache->op == '<' ? cmp < 0 : cmp > 0;
 	}
+
 	return DatumGetBool(FunctionCall2Coll(&cache->proc, fcinfo->fncollation, left.datum, right.datum));
 }
 
@@ -294,27 +491,25 @@ bookend_sfunc(MemoryContext aggcontext, InternalCmpAggStore *state, PolyDatum va
 	MemoryContext old_context;
 	TransCache *cache = transcache_get(fcinfo);
 
-	old_context = MemoryContextSwitchTo(aggcontext);
-
 	if (state == NULL)
 	{
-		state = (InternalCmpAggStore *) MemoryContextAlloc(aggcontext, sizeof(InternalCmpAggStore));
-		typeinfocache_polydatumcopy(&cache->value_type_cache, value, &state->value);
-		typeinfocache_polydatumcopy(&cache->cmp_type_cache, cmp, &state->cmp);
+		old_context = MemoryContextSwitchTo(aggcontext);
+		state = (InternalCmpAggStore *) palloc0(sizeof(InternalCmpAggStore));
+		typeinfocache_polydatumcopy(&cache->value_type_cache, value, &state->value, &state->value_buf);
+		typeinfocache_polydatumcopy(&cache->cmp_type_cache, cmp, &state->cmp, &state->cmp_buf);
+		MemoryContextSwitchTo(old_context);
 	}
-	else
+	else if (state->cmp.is_null || cmp.is_null)
 	{
-		if (state->cmp.is_null || cmp.is_null)
-		{
-			state->cmp.is_null = true;
-		}
-		else if (cmpfunccache_cmp(&cache->cmp_func_cache, fcinfo, opname, cmp, state->cmp))
-		{
-			typeinfocache_polydatumcopy(&cache->value_type_cache, value, &state->value);
-			typeinfocache_polydatumcopy(&cache->cmp_type_cache, cmp, &state->cmp);
-		}
+		state->cmp.is_null = true;
+	}
+	else if (cmpfunccache_cmp(&cache->cmp_func_cache, fcinfo, opname, cmp, state->cmp))
+	{
+		old_context = MemoryContextSwitchTo(aggcontext);
+		typeinfocache_polydatumcopy(&cache->value_type_cache, value, &state->value, &state->value_buf);
+		typeinfocache_polydatumcopy(&cache->cmp_type_cache, cmp, &state->cmp, &state->cmp_buf);
+		MemoryContextSwitchTo(old_context);
 	}
-	MemoryContextSwitchTo(old_context);
 
 	PG_RETURN_POINTER(state);
 }
@@ -341,9 +536,9 @@ bookend_combinefunc(MemoryContext aggcontext, InternalCmpAggStore *state1, Inter
 	{
 		old_context = MemoryContextSwitchTo(aggcontext);
 
-		state1 = (InternalCmpAggStore *) MemoryContextAlloc(aggcontext, sizeof(InternalCmpAggStore));
-		typeinfocache_polydatumcopy(&cache->value_type_cache, state2->value, &state1->value);
-		typeinfocache_polydatumcopy(&cache->cmp_type_cache, state2->cmp, &state1->cmp);
+		state1 = (InternalCmpAggStore *) palloc0(sizeof(InternalCmpAggStore));
+		typeinfocache_polydatumcopy(&cache->value_type_cache, state2->value, &state1->value, &state1->value_buf);
+		typeinfocache_polydatumcopy(&cache->cmp_type_cache, state2->cmp, &state1->cmp, &state1->cmp_buf);
 
 		MemoryContextSwitchTo(old_context);
 		PG_RETURN_POINTER(state1);
@@ -362,8 +557,8 @@ bookend_combinefunc(MemoryContext aggcontext, InternalCmpAggStore *state1, Inter
 	if (cmpfunccache_cmp(&cache->cmp_func_cache, fcinfo, opname, state2->cmp, state1->cmp))
 	{
 		old_context = MemoryContextSwitchTo(aggcontext);
-		typeinfocache_polydatumcopy(&cache->value_type_cache, state2->value, &state1->value);
-		typeinfocache_polydatumcopy(&cache->cmp_type_cache, state2->cmp, &state1->cmp);
+		typeinfocache_polydatumcopy(&cache->value_type_cache, state2->value, &state1->value, &state1->value_buf);
+		typeinfocache_polydatumcopy(&cache->cmp_type_cache, state2->cmp, &state1->cmp, &state1->cmp_buf);
 		MemoryContextSwitchTo(old_context);
 	}
 
@@ -492,7 +687,7 @@ bookend_deserializefunc(PG_FUNCTION_ARGS)
 		my_extra = (InternalCmpAggStoreIOState *) fcinfo->flinfo->fn_extra;
 	}
 
-	result = palloc(sizeof(InternalCmpAggStore));
+	result = palloc0(sizeof(InternalCmpAggStore));
 	polydatum_deserialize(&result->value, &buf, &my_extra->value, fcinfo);
 	polydatum_deserialize(&result->cmp, &buf, &my_extra->cmp, fcinfo);
 	PG_RETURN_POINTER(result);
@@ -521,3 +716,217 @@ bookend_finalfunc(PG_FUNCTION_ARGS)
 
 	PG_RETURN_DATUM(state->value.datum);
 }
+
+/*
+ * Moving-aggregate state for bookend aggregates evaluated over sliding window
+ * frames.
+ *
+ * The rows of the frame that can still become the result are kept in a deque,
+ * in the order they were added. Adding a row evicts the rows at the back that
+ * it beats, so the comparison elements are monotonic from front to back and
+ * the result is always at the front. Rows leave the frame in the order they
+ * were added, so removing a row only has to check the front. Both operations
+ * are amortized O(1).
+ *
+ * Rows with a NULL comparison element make the aggregate NULL while they are
+ * in the frame, so they are only counted.
+ */
+typedef struct BookendDequeEntry
+{
+	int64		seqno;
+	PolyDatum	value;
+	PolyDatum	cmp;
+	DatumBuffer value_buf;
+	DatumBuffer cmp_buf;
+} BookendDequeEntry;
+
+typedef struct MovingBookendState
+{
+	BookendDequeEntry *entries;
+	int			capacity;
+	int			head;
+	int			count;
+	int64		next_seqno;		/* seqno of the next row added */
+	int64		next_removed_seqno; /* seqno of the next row leaving the frame */
+	int64		null_cmps;		/* rows in the frame with a NULL cmp */
+} MovingBookendState;
+
+#define MOVING_BOOKEND_INITIAL_CAPACITY 8
+
+static inline BookendDequeEntry *
+moving_bookend_entry(MovingBookendState *state, int i)
+{
+	return &state->entries[(state->head + i) % state->capacity];
+}
+
+/*
+ * Add an entry at the back of the deque. Slots are reused along with their
+ * buffers, so steady-state windows do not allocate.
+ */
+static BookendDequeEntry *
+moving_bookend_push(MovingBookendState *state)
+{
+	if (state->count == state->capacity)
+	{
+		BookendDequeEntry *entries = palloc0(sizeof(BookendDequeEntry) * state->capacity * 2);
+		int			i;
+
+		for (i = 0; i < state->capacity; i++)
+			entries[i] = *moving_bookend_entry(state, i);
+
+		pfree(state->entries);
+		state->entries = entries;
+		state->head = 0;
+		state->capacity *= 2;
+	}
+
+	state->count++;
+
+	return moving_bookend_entry(state, state->count - 1);
+}
+
+static inline Datum
+bookend_msfunc(MemoryContext aggcontext, MovingBookendState *state, PolyDatum value, PolyDatum cmp, char *opname, FunctionCallInfo fcinfo)
+{
+	MemoryContext old_context;
+	TransCache *cache = transcache_get(fcinfo);
+	int64		seqno;
+
+	old_context = MemoryContextSwitchTo(aggcontext);
+
+	if (state == NULL)
+	{
+		state = palloc0(sizeof(MovingBookendState));
+		state->capacity = MOVING_BOOKEND_INITIAL_CAPACITY;
+		state->entries = palloc0(sizeof(BookendDequeEntry) * state->capacity);
+	}
+
+	seqno = state->next_seqno++;
+
+	if (cmp.is_null)
+		state->null_cmps++;
+	else
+	{
+		BookendDequeEntry *entry;
+
+		/* evict the rows at the back that the new row beats */
+		while (state->count > 0 &&
+			   cmpfunccache_cmp(&cache->cmp_func_cache, fcinfo, opname, cmp,
+								moving_bookend_entry(state, state->count - 1)->cmp))
+			state->count--;
+
+		entry = moving_bookend_push(state);
+		entry->seqno = seqno;
+		typeinfocache_polydatumcopy(&cache->value_type_cache, value, &entry->value, &entry->value_buf);
+		typeinfocache_polydatumcopy(&cache->cmp_type_cache, cmp, &entry->cmp, &entry->cmp_buf);
+	}
+
+	MemoryContextSwitchTo(old_context);
+
+	PG_RETURN_POINTER(state);
+}
+
+/*
+ * bookend_moving_remove - internal function called by bookend_minvfunc with
+ * the row leaving the window frame
+ */
+static inline Datum
+bookend_moving_remove(MovingBookendState *state, PolyDatum cmp)
+{
+	int64		seqno;
+
+	if (state == NULL)
+		elog(ERROR, "bookend inverse transition called without a state");
+
+	seqno = state->next_removed_seqno++;
+
+	if (cmp.is_null)
+		state->null_cmps--;
+	else if (state->count > 0 && moving_bookend_entry(state, 0)->seqno == seqno)
+	{
+		state->head = (state->head + 1) % state->capacity;
+		state->count--;
+	}
+
+	PG_RETURN_POINTER(state);
+}
+
+/* first_msfunc(internal internal_state, anyelement value, "any" comparison_element) */
+Datum
+first_msfunc(PG_FUNCTION_ARGS)
+{
+	MovingBookendState *state = PG_ARGISNULL(0) ? NULL : (MovingBookendState *) PG_GETARG_POINTER(0);
+	PolyDatum	value = polydatum_from_arg(1, fcinfo);
+	PolyDatum	cmp = polydatum_from_arg(2, fcinfo);
+	MemoryContext aggcontext;
+
+	if (!AggCheckCallContext(fcinfo, &aggcontext))
+	{
+		/* cannot be called directly because of internal-type argument */
+		elog(ERROR, "first_msfunc called in non-aggregate context");
+	}
+
+	return bookend_msfunc(aggcontext, state, value, cmp, "<", fcinfo);
+}
+
+/* last_msfunc(internal internal_state, anyelement value, "any" comparison_element) */
+Datum
+last_msfunc(PG_FUNCTION_ARGS)
+{
+	MovingBookendState *state = PG_ARGISNULL(0) ? NULL : (MovingBookendState *) PG_GETARG_POINTER(0);
+	PolyDatum	value = polydatum_from_arg(1, fcinfo);
+	PolyDatum	cmp = polydatum_from_arg(2, fcinfo);
+	MemoryContext aggcontext;
+
+	if (!AggCheckCallContext(fcinfo, &aggcontext))
+	{
+		/* cannot be called directly because of internal-type argument */
+		elog(ERROR, "last_msfunc called in non-aggregate context");
+	}
+
+	return bookend_msfunc(aggcontext, state, value, cmp, ">", fcinfo);
+}
+
+/* bookend_minvfunc(internal internal_state, anyelement value, "any" comparison_element) */
+Datum
+bookend_minvfunc(PG_FUNCTION_ARGS)
+{
+	MovingBookendState *state = PG_ARGISNULL(0) ? NULL : (MovingBookendState *) PG_GETARG_POINTER(0);
+
+	if (!AggCheckCallContext(fcinfo, NULL))
+	{
+		/* cannot be called directly because of internal-type argument */
+		elog(ERROR, "bookend_minvfunc called in non-aggregate context");
+	}
+
+	return bookend_moving_remove(state, polydatum_from_arg(2, fcinfo));
+}
+
+/* bookend_moving_finalfunc(internal, anyelement, "any") => anyelement */
+Datum
+bookend_moving_finalfunc(PG_FUNCTION_ARGS)
+{
+	MovingBookendState *state;
+	BookendDequeEntry *front;
+
+	if (!AggCheckCallContext(fcinfo, NULL))
+	{
+		/* cannot be called directly because of internal-type argument */
+		elog(ERROR, "bookend_moving_finalfunc called in non-aggregate context");
+	}
+
+	if (PG_ARGISNULL(0))
+		PG_RETURN_NULL();
+
+	state = (MovingBookendState *) PG_GETARG_POINTER(0);
+
+	if (state->null_cmps > 0 || state->count == 0)
+		PG_RETURN_NULL();
+
+	front = moving_bookend_entry(state, 0);
+
+	if (front->value.is_null)
+		PG_RETURN_NULL();
+
+	PG_RETURN_DATUM(front->value.datum);
+}
@@ -0,0 +1,1315 @@
+#include <postgres.h>
+#include <fmgr.h>
+#include <funcapi.h>
+#include <access/htup_details.h>
+#include <lib/stringinfo.h>
+#include <libpq/pqformat.h>
+#include <utils/timestamp.h>
+#include <math.h>
+
+#include "compat.h"
+
+/*
+ * Time-series aggregates:
+ *
+ *	 time_weight_avg(value, time) - the average of value weighted by the time
+ *		each value was held, i.e., the value of a row is carried forward until
+ *		the time of the next row (last observation carried forward).
+ *	 counter_rate(value, time) - the per-second rate of increase of a monotonic
+ *		counter. A value lower than the previous one is a counter reset, after
+ *		which the counter is assumed to have restarted from zero.
+ *	 delta(value, time) - the value at the latest time minus the value at the
+ *		earliest time.
+ *
+ * These replace window queries with lag() followed by an outer aggregate.
+ *
+ * time_weight_avg() and counter_rate() summarize runs of points that reach
+ * the aggregate in time order (or in reverse time order) into segments that
+ * only keep the first and last points and running sums: the sum of each
+ * value times how long it was held, and the increase of the counter. A point
+ * that does not continue the current segment starts a new one, so rows that
+ * come in time-ordered runs, like the chunks of an unordered Append, need
+ * one segment per run. The segments never overlap and are joined in time
+ * order by the final function. A point that falls inside the time range of
+ * a segment, or more than TS_SUMMARY_MAX_SEGMENTS runs, raises an error, in
+ * which case the aggregate call needs an ORDER BY on the time column.
+ *
+ * Partial states from parallel workers cannot be combined, since the rows of
+ * the workers interleave in time, so these two aggregates are restricted to
+ * the leader.
+ *
+ * delta() only needs the first and last points, which is all its state
+ * keeps. Its states can be combined in any order.
+ *
+ * Downsampling aggregates for visualization:
+ *
+ *	 lttb(value, time, resolution) - at most resolution points picked with the
+ *		largest-triangle-three-buckets algorithm, which keeps the visual shape
+ *		of the series.
+ *	 minmax_downsample(value, time, resolution) - the minimum and maximum
+ *		points of resolution / 2 equal time ranges.
+ *
+ * They return a series of points as bytea, to be expanded into rows with
+ * unnest_points(series). Picking points depends on the number of points and
+ * the time range of the whole series, which are only known once all rows
+ * were seen, so these aggregates keep every point of the group (16 bytes
+ * per point) and downsample in a single pass in the final function.
+ *
+ *	 minmax_downsample(value, time, resolution, start, finish) - the minimum
+ *		and maximum points of resolution / 2 equal time ranges between start
+ *		and finish. Rows outside of the range are ignored.
+ *
+ * With the time range given, each row is added to its time range as it
+ * arrives, so the state only keeps the minimum and maximum of each range and
+ * rows can come in any order.
+ */
+
+TS_FUNCTION_INFO_V1(ts_summary_sfunc);
+TS_FUNCTION_INFO_V1(ts_points_combinefunc);
+TS_FUNCTION_INFO_V1(ts_points_serializefunc);
+TS_FUNCTION_INFO_V1(ts_points_deserializefunc);
+TS_FUNCTION_INFO_V1(time_weight_avg_finalfunc);
+TS_FUNCTION_INFO_V1(counter_rate_finalfunc);
+TS_FUNCTION_INFO_V1(delta_sfunc);
+TS_FUNCTION_INFO_V1(delta_combinefunc);
+TS_FUNCTION_INFO_V1(delta_serializefunc);
+TS_FUNCTION_INFO_V1(delta_deserializefunc);
+TS_FUNCTION_INFO_V1(delta_finalfunc);
+TS_FUNCTION_INFO_V1(downsample_sfunc);
+TS_FUNCTION_INFO_V1(lttb_finalfunc);
+TS_FUNCTION_INFO_V1(minmax_downsample_finalfunc);
+TS_FUNCTION_INFO_V1(minmax_buckets_sfunc);
+TS_FUNCTION_INFO_V1(minmax_buckets_combinefunc);
+TS_FUNCTION_INFO_V1(minmax_buckets_serializefunc);
+TS_FUNCTION_INFO_V1(minmax_buckets_deserializefunc);
+TS_FUNCTION_INFO_V1(minmax_buckets_finalfunc);
+TS_FUNCTION_INFO_V1(ts_points_unnest);
+
+#ifdef HAVE_INT64_TIMESTAMP
+#define TIME_DIFF_SECONDS(diff) ((double) (diff) / USECS_PER_SEC)
+#define pq_sendtimestamp(buf, ts) pq_sendint64(buf, ts)
+#define pq_getmsgtimestamp(buf) pq_getmsgint64(buf)
+#else
+#define TIME_DIFF_SECONDS(diff) (diff)
+#define pq_sendtimestamp(buf, ts) pq_sendfloat8(buf, ts)
+#define pq_getmsgtimestamp(buf) pq_getmsgfloat8(buf)
+#endif
+
+#define TS_POINTS_INITIAL_SIZE 64
+#define TS_SUMMARY_INITIAL_SEGMENTS 8
+#define TS_SUMMARY_MAX_SEGMENTS 1024
+
+typedef struct TSPoint
+{
+	TimestampTz time;
+	double		value;
+} TSPoint;
+
+typedef struct TSPoints
+{
+	int32		npoints;
+	int32		maxpoints;
+	bool		sorted;			/* points were added in time order */
+	int32		resolution;		/* number of points to downsample to, if any */
+	TSPoint    *points;
+} TSPoints;
+
+/* A time-ordered run of points of time_weight_avg() and counter_rate() */
+typedef struct TSSummary
+{
+	TSPoint		first;
+	TSPoint		last;
+	double		weighted_sum;	/* sum of value * time held until the next point */
+	double		increase;		/* increase of the counter, with resets */
+	double		value_sum;		/* sum of values, for points all at one time */
+	int64		npoints;
+} TSSummary;
+
+/* State of time_weight_avg() and counter_rate() */
+typedef struct TSSummaries
+{
+	int32		nsegments;
+	int32		maxsegments;
+	int32		current;		/* segment the last point was added to */
+	int32		direction;		/* 1 if the current segment grew forward in
+								 * time, -1 if backward, 0 if neither */
+	TSSummary  *segments;		/* ordered by time, not overlapping */
+} TSSummaries;
+
+typedef struct DeltaState
+{
+	TSPoint		first;
+	TSPoint		last;
+} DeltaState;
+
+typedef struct MinMaxBucket
+{
+	bool		empty;
+	TSPoint		min;
+	TSPoint		max;
+} MinMaxBucket;
+
+/* State of minmax_downsample() with a time range */
+typedef struct MinMaxBuckets
+{
+	int32		resolution;
+	TimestampTz start;
+	TimestampTz finish;
+	int32		nbuckets;
+	MinMaxBucket buckets[FLEXIBLE_ARRAY_MEMBER];
+} MinMaxBuckets;
+
+/*
+ * Order points by time. Points with the same time are ordered by value so
+ * that the results do not depend on the order of the input.
+ */
+static int
+ts_point_cmp(const void *left, const void *right)
+{
+	const TSPoint *p1 = left;
+	const TSPoint *p2 = right;
+
+	if (p1->time != p2->time)
+		return p1->time < p2->time ? -1 : 1;
+
+	if (p1->value != p2->value)
+		return p1->value < p2->value ? -1 : 1;
+
+	return 0;
+}
+
+static TSPoints *
+ts_points_create(MemoryContext mcxt, int32 maxpoints)
+{
+	TSPoints   *state = MemoryContextAlloc(mcxt, sizeof(TSPoints));
+
+	state->npoints = 0;
+	state->maxpoints = maxpoints;
+	state->sorted = true;
+	state->resolution = 0;
+	state->points = MemoryContextAlloc(mcxt, sizeof(TSPoint) * maxpoints);
+
+	return state;
+}
+
+/* Make room for npoints more points. The points stay in their memory context. */
+static void
+ts_points_reserve(TSPoints *state, int32 npoints)
+{
+	int32		maxpoints = state->maxpoints;
+
+	if (state->npoints + npoints <= maxpoints)
+		return;
+
+	while (state->npoints + npoints > maxpoints)
+		maxpoints *= 2;
+
+	if ((Size) maxpoints > MaxAllocSize / sizeof(TSPoint))
+		ereport(ERROR,
+				(errcode(ERRCODE_PROGRAM_LIMIT_EXCEEDED),
+				 errmsg("too many points in time-series aggregate")));
+
+	state->points = repalloc(state->points, sizeof(TSPoint) * maxpoints);
+	state->maxpoints = maxpoints;
+}
+
+static void
+ts_points_append(TSPoints *state, TSPoint *points, int32 npoints, bool sorted)
+{
+	if (npoints == 0)
+		return;
+
+	if (state->npoints > 0 &&
+		ts_point_cmp(&state->points[state->npoints - 1], &points[0]) > 0)
+		state->sorted = false;
+
+	state->sorted = state->sorted && sorted;
+	ts_points_reserve(state, npoints);
+	memcpy(state->points + state->npoints, points, sizeof(TSPoint) * npoints);
+	state->npoints += npoints;
+}
+
+static void
+ts_points_sort(TSPoints *state)
+{
+	if (!state->sorted)
+	{
+		qsort(state->points, state->npoints, sizeof(TSPoint), ts_point_cmp);
+		state->sorted = true;
+	}
+}
+
+/* ts_points_combinefunc(internal, internal) => internal */
+Datum
+ts_points_combinefunc(PG_FUNCTION_ARGS)
+{
+	MemoryContext aggcontext;
+	TSPoints   *state1 = PG_ARGISNULL(0) ? NULL : (TSPoints *) PG_GETARG_POINTER(0);
+	TSPoints   *state2 = PG_ARGISNULL(1) ? NULL : (TSPoints *) PG_GETARG_POINTER(1);
+
+	if (!AggCheckCallContext(fcinfo, &aggcontext))
+	{
+		/* cannot be called directly because of internal-type argument */
+		elog(ERROR, "ts_points_combinefunc called in non-aggregate context");
+	}
+
+	if (state2 == NULL)
+	{
+		if (state1 == NULL)
+			PG_RETURN_NULL();
+		PG_RETURN_POINTER(state1);
+	}
+
+	/* state2 might not live in the aggregate context, so copy it */
+	if (state1 == NULL)
+	{
+		state1 = ts_points_create(aggcontext, Max(state2->npoints, TS_POINTS_INITIAL_SIZE));
+		state1->resolution = state2->resolution;
+	}
+	else if (state1->resolution != state2->resolution)
+		elog(ERROR, "cannot combine series downsampled to different resolutions");
+
+	ts_points_append(state1, state2->points, state2->npoints, state2->sorted);
+
+	PG_RETURN_POINTER(state1);
+}
+
+/* ts_points_serializefunc(internal) => bytea */
+Datum
+ts_points_serializefunc(PG_FUNCTION_ARGS)
+{
+	TSPoints   *state;
+	StringInfoData buf;
+	int32		i;
+
+	Assert(!PG_ARGISNULL(0));
+	state = (TSPoints *) PG_GETARG_POINTER(0);
+
+	pq_begintypsend(&buf);
+	pq_sendint(&buf, state->npoints, 4);
+	pq_sendbyte(&buf, state->sorted);
+	pq_sendint(&buf, state->resolution, 4);
+
+	for (i = 0; i < state->npoints; i++)
+	{
+		pq_sendtimestamp(&buf, state->points[i].time);
+		pq_sendfloat8(&buf, state->points[i].value);
+	}
+
+	PG_RETURN_BYTEA_P(pq_endtypsend(&buf));
+}
+
+/* ts_points_deserializefunc(bytea, internal) => internal */
+Datum
+ts_points_deserializefunc(PG_FUNCTION_ARGS)
+{
+	bytea	   *sstate;
+	StringInfoData buf;
+	TSPoints   *state;
+	int32		npoints;
+	int32		i;
+
+	Assert(!PG_ARGISNULL(0));
+	sstate = PG_GETARG_BYTEA_P(0);
+
+	/* Set up a StringInfo pointing into the bytea, which is not modified */
+	buf.data = VARDATA(sstate);
+	buf.len = VARSIZE(sstate) - VARHDRSZ;
+	buf.maxlen = buf.len;
+	buf.cursor = 0;
+
+	npoints = pq_getmsgint(&buf, 4);
+
+	if (npoints < 0 || (Size) (buf.len - buf.cursor) != 5 + sizeof(TSPoint) * (Size) npoints)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+				 errmsg("invalid time-series aggregate state")));
+
+	state = ts_points_create(CurrentMemoryContext, Max(npoints, 1));
+	state->sorted = pq_getmsgbyte(&buf) != 0;
+	state->resolution = pq_getmsgint(&buf, 4);
+	state->npoints = npoints;
+
+	for (i = 0; i < npoints; i++)
+	{
+		state->points[i].time = pq_getmsgtimestamp(&buf);
+		state->points[i].value = pq_getmsgfloat8(&buf);
+	}
+
+	pq_getmsgend(&buf);
+
+	PG_RETURN_POINTER(state);
+}
+
+/* Increase of a counter between two points, where a lower value is a reset */
+static inline double
+counter_increase(double prev, double next)
+{
+	return next >= prev ? next - prev : next;
+}
+
+/*
+ * Append the points of a summary to those of another summary. The first
+ * point of next must not come before the last point of prev.
+ */
+static void
+ts_summary_join(TSSummary *result, TSSummary *prev, TSSummary *next)
+{
+	result->weighted_sum = prev->weighted_sum + next->weighted_sum +
+		prev->last.value * (double) (next->first.time - prev->last.time);
+	result->increase = prev->increase + next->increase +
+		counter_increase(prev->last.value, next->first.value);
+	result->value_sum = prev->value_sum + next->value_sum;
+	result->npoints = prev->npoints + next->npoints;
+	result->first = prev->first;
+	result->last = next->last;
+}
+
+static void
+ts_summary_init(TSSummary *state, TSPoint *point)
+{
+	state->first = *point;
+	state->last = *point;
+	state->weighted_sum = 0;
+	state->increase = 0;
+	state->value_sum = point->value;
+	state->npoints = 1;
+}
+
+static void
+ts_summary_not_in_order_error(void)
+{
+	ereport(ERROR,
+			(errcode(ERRCODE_DATA_EXCEPTION),
+			 errmsg("time-series aggregate input is not in time order"),
+			 errhint("Add ORDER BY on the time column to the aggregate call.")));
+}
+
+/*
+ * Find the first segment that starts after the given time, or nsegments if
+ * there is none.
+ */
+static int32
+ts_summaries_search(TSSummaries *state, TimestampTz time)
+{
+	int32		low = 0;
+	int32		high = state->nsegments;
+
+	while (low < high)
+	{
+		int32		mid = low + (high - low) / 2;
+
+		if (state->segments[mid].first.time <= time)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+
+	return low;
+}
+
+/*
+ * Add a point to the state. The point is added to the current segment if it
+ * continues it in the direction it grows without reaching into its
+ * neighbors. Otherwise, it starts a new segment, unless it falls inside the
+ * time range of a segment, in which case the points around it were already
+ * summarized. A run that starts before the current segment therefore gets a
+ * segment of its own, so that a later run can still fill the gap between
+ * them.
+ */
+static void
+ts_summaries_add(TSSummaries *state, TSPoint *point)
+{
+	TSSummary  *cur = &state->segments[state->current];
+	TSSummary  *prev = state->current > 0 ? cur - 1 : NULL;
+	TSSummary  *next = state->current + 1 < state->nsegments ? cur + 1 : NULL;
+	TSSummary	summary;
+	int32		pos;
+
+	ts_summary_init(&summary, point);
+
+	if (state->direction >= 0 && point->time >= cur->last.time &&
+		(NULL == next || point->time <= next->first.time))
+	{
+		if (point->time > cur->last.time)
+			state->direction = 1;
+		ts_summary_join(cur, cur, &summary);
+		return;
+	}
+
+	if (state->direction <= 0 && point->time <= cur->first.time &&
+		(NULL == prev || point->time >= prev->last.time))
+	{
+		if (point->time < cur->first.time)
+			state->direction = -1;
+		ts_summary_join(cur, &summary, cur);
+		return;
+	}
+
+	pos = ts_summaries_search(state, point->time);
+
+	if (pos > 0 && point->time <= state->segments[pos - 1].last.time)
+	{
+		/* The point can only be at either end of the segment */
+		state->current = pos - 1;
+		state->direction = 0;
+		cur = &state->segments[pos - 1];
+
+		if (point->time == cur->last.time)
+			ts_summary_join(cur, cur, &summary);
+		else if (point->time == cur->first.time)
+			ts_summary_join(cur, &summary, cur);
+		else
+			ts_summary_not_in_order_error();
+
+		return;
+	}
+
+	if (state->nsegments == state->maxsegments)
+	{
+		if (state->maxsegments >= TS_SUMMARY_MAX_SEGMENTS)
+			ts_summary_not_in_order_error();
+
+		state->maxsegments *= 2;
+		state->segments = repalloc(state->segments, sizeof(TSSummary) * state->maxsegments);
+	}
+
+	memmove(&state->segments[pos + 1], &state->segments[pos],
+			sizeof(TSSummary) * (state->nsegments - pos));
+	state->segments[pos] = summary;
+	state->nsegments++;
+	state->current = pos;
+	state->direction = 0;
+}
+
+/* ts_summary_sfunc(internal, value DOUBLE PRECISION, time TIMESTAMPTZ) */
+Datum
+ts_summary_sfunc(PG_FUNCTION_ARGS)
+{
+	MemoryContext aggcontext;
+	TSSummaries *state = PG_ARGISNULL(0) ? NULL : (TSSummaries *) PG_GETARG_POINTER(0);
+	TSPoint		point;
+
+	if (!AggCheckCallContext(fcinfo, &aggcontext))
+	{
+		/* cannot be called directly because of internal-type argument */
+		elog(ERROR, "ts_summary_sfunc called in non-aggregate context");
+	}
+
+	if (PG_ARGISNULL(1) || PG_ARGISNULL(2))
+	{
+		if (state == NULL)
+			PG_RETURN_NULL();
+		PG_RETURN_POINTER(state);
+	}
+
+	point.value = PG_GETARG_FLOAT8(1);
+	point.time = PG_GETARG_TIMESTAMPTZ(2);
+
+	if (state == NULL)
+	{
+		state = MemoryContextAlloc(aggcontext, sizeof(TSSummaries));
+		state->nsegments = 1;
+		state->maxsegments = TS_SUMMARY_INITIAL_SEGMENTS;
+		state->current = 0;
+		state->direction = 0;
+		state->segments = MemoryContextAlloc(aggcontext, sizeof(TSSummary) * state->maxsegments);
+		ts_summary_init(&state->segments[0], &point);
+		PG_RETURN_POINTER(state);
+	}
+
+	ts_summaries_add(state, &point);
+
+	PG_RETURN_POINTER(state);
+}
+
+/* Join the segments of the state, which are in time order */
+static void
+ts_summaries_join(TSSummaries *state, TSSummary *result)
+{
+	int32		i;
+
+	*result = state->segments[0];
+
+	for (i = 1; i < state->nsegments; i++)
+		ts_summary_join(result, result, &state->segments[i]);
+}
+
+/* time_weight_avg_finalfunc(internal, ...) => DOUBLE PRECISION */
+Datum
+time_weight_avg_finalfunc(PG_FUNCTION_ARGS)
+{
+	TSSummary	summary;
+	double		duration;
+
+	if (!AggCheckCallContext(fcinfo, NULL))
+	{
+		/* cannot be called directly because of internal-type argument */
+		elog(ERROR, "time_weight_avg_finalfunc called in non-aggregate context");
+	}
+
+	if (PG_ARGISNULL(0))
+		PG_RETURN_NULL();
+
+	ts_summaries_join((TSSummaries *) PG_GETARG_POINTER(0), &summary);
+	duration = (double) (summary.last.time - summary.first.time);
+
+	/* All points at the same time have the same weight */
+	if (duration == 0)
+		PG_RETURN_FLOAT8(summary.value_sum / summary.npoints);
+
+	PG_RETURN_FLOAT8(summary.weighted_sum / duration);
+}
+
+/* counter_rate_finalfunc(internal, ...) => DOUBLE PRECISION */
+Datum
+counter_rate_finalfunc(PG_FUNCTION_ARGS)
+{
+	TSSummary	summary;
+
+	if (!AggCheckCallContext(fcinfo, NULL))
+	{
+		/* cannot be called directly because of internal-type argument */
+		elog(ERROR, "counter_rate_finalfunc called in non-aggregate context");
+	}
+
+	if (PG_ARGISNULL(0))
+		PG_RETURN_NULL();
+
+	ts_summaries_join((TSSummaries *) PG_GETARG_POINTER(0), &summary);
+
+	/* A rate needs two points in time */
+	if (summary.last.time == summary.first.time)
+		PG_RETURN_NULL();
+
+	PG_RETURN_FLOAT8(summary.increase / TIME_DIFF_SECONDS(summary.last.time - summary.first.time));
+}
+
+/* delta_sfunc(internal, value DOUBLE PRECISION, time TIMESTAMPTZ) */
+Datum
+delta_sfunc(PG_FUNCTION_ARGS)
+{
+	MemoryContext aggcontext;
+	DeltaState *state = PG_ARGISNULL(0) ? NULL : (DeltaState *) PG_GETARG_POINTER(0);
+	TSPoint		point;
+
+	if (!AggCheckCallContext(fcinfo, &aggcontext))
+	{
+		/* cannot be called directly because of internal-type argument */
+		elog(ERROR, "delta_sfunc called in non-aggregate context");
+	}
+
+	if (PG_ARGISNULL(1) || PG_ARGISNULL(2))
+	{
+		if (state == NULL)
+			PG_RETURN_NULL();
+		PG_RETURN_POINTER(state);
+	}
+
+	point.value = PG_GETARG_FLOAT8(1);
+	point.time = PG_GETARG_TIMESTAMPTZ(2);
+
+	if (state == NULL)
+	{
+		state = MemoryContextAlloc(aggcontext, sizeof(DeltaState));
+		state->first = point;
+		state->last = point;
+	}
+	else if (ts_point_cmp(&point, &state->first) < 0)
+		state->first = point;
+	else if (ts_point_cmp(&point, &state->last) > 0)
+		state->last = point;
+
+	PG_RETURN_POINTER(state);
+}
+
+/* delta_combinefunc(internal, internal) => internal */
+Datum
+delta_combinefunc(PG_FUNCTION_ARGS)
+{
+	MemoryContext aggcontext;
+	DeltaState *state1 = PG_ARGISNULL(0) ? NULL : (DeltaState *) PG_GETARG_POINTER(0);
+	DeltaState *state2 = PG_ARGISNULL(1) ? NULL : (DeltaState *) PG_GETARG_POINTER(1);
+
+	if (!AggCheckCallContext(fcinfo, &aggcontext))
+	{
+		/* cannot be called directly because of internal-type argument */
+		elog(ERROR, "delta_combinefunc called in non-aggregate context");
+	}
+
+	if (state2 == NULL)
+	{
+		if (state1 == NULL)
+			PG_RETURN_NULL();
+		PG_RETURN_POINTER(state1);
+	}
+
+	/* state2 might not live in the aggregate context, so copy it */
+	if (state1 == NULL)
+	{
+		state1 = MemoryContextAlloc(aggcontext, sizeof(DeltaState));
+		*state1 = *state2;
+		PG_RETURN_POINTER(state1);
+	}
+
+	if (ts_point_cmp(&state2->first, &state1->first) < 0)
+		state1->first = state2->first;
+	if (ts_point_cmp(&state2->last, &state1->last) > 0)
+		state1->last = state2->last;
+
+	PG_RETURN_POINTER(state1);
+}
+
+/* delta_serializefunc(internal) => bytea */
+Datum
+delta_serializefunc(PG_FUNCTION_ARGS)
+{
+	DeltaState *state;
+	StringInfoData buf;
+
+	Assert(!PG_ARGISNULL(0));
+	state = (DeltaState *) PG_GETARG_POINTER(0);
+
+	pq_begintypsend(&buf);
+	pq_sendtimestamp(&buf, state->first.time);
+	pq_sendfloat8(&buf, state->first.value);
+	pq_sendtimestamp(&buf, state->last.time);
+	pq_sendfloat8(&buf, state->last.value);
+
+	PG_RETURN_BYTEA_P(pq_endtypsend(&buf));
+}
+
+/* delta_deserializefunc(bytea, internal) => internal */
+Datum
+delta_deserializefunc(PG_FUNCTION_ARGS)
+{
+	bytea	   *sstate;
+	StringInfoData buf;
+	DeltaState *state;
+
+	Assert(!PG_ARGISNULL(0));
+	sstate = PG_GETARG_BYTEA_P(0);
+
+	/* Set up a StringInfo pointing into the bytea, which is not modified */
+	buf.data = VARDATA(sstate);
+	buf.len = VARSIZE(sstate) - VARHDRSZ;
+	buf.maxlen = buf.len;
+	buf.cursor = 0;
+
+	state = palloc(sizeof(DeltaState));
+	state->first.time = pq_getmsgtimestamp(&buf);
+	state->first.value = pq_getmsgfloat8(&buf);
+	state->last.time = pq_getmsgtimestamp(&buf);
+	state->last.value = pq_getmsgfloat8(&buf);
+	pq_getmsgend(&buf);
+
+	PG_RETURN_POINTER(state);
+}
+
+/* delta_finalfunc(internal, ...) => DOUBLE PRECISION */
+Datum
+delta_finalfunc(PG_FUNCTION_ARGS)
+{
+	DeltaState *state;
+
+	if (!AggCheckCallContext(fcinfo, NULL))
+	{
+		/* cannot be called directly because of internal-type argument */
+		elog(ERROR, "delta_finalfunc called in non-aggregate context");
+	}
+
+	if (PG_ARGISNULL(0))
+		PG_RETURN_NULL();
+
+	state = (DeltaState *) PG_GETARG_POINTER(0);
+
+	PG_RETURN_FLOAT8(state->last.value - state->first.value);
+}
+
+/* downsample_sfunc(internal, value DOUBLE PRECISION, time TIMESTAMPTZ, resolution INTEGER) */
+Datum
+downsample_sfunc(PG_FUNCTION_ARGS)
+{
+	MemoryContext aggcontext;
+	TSPoints   *state = PG_ARGISNULL(0) ? NULL : (TSPoints *) PG_GETARG_POINTER(0);
+	TSPoint		point;
+	int32		resolution;
+
+	if (!AggCheckCallContext(fcinfo, &aggcontext))
+	{
+		/* cannot be called directly because of internal-type argument */
+		elog(ERROR, "downsample_sfunc called in non-aggregate context");
+	}
+
+	if (PG_ARGISNULL(1) || PG_ARGISNULL(2) || PG_ARGISNULL(3))
+	{
+		if (state == NULL)
+			PG_RETURN_NULL();
+		PG_RETURN_POINTER(state);
+	}
+
+	resolution = PG_GETARG_INT32(3);
+
+	if (state == NULL)
+	{
+		if (resolution < 2)
+			ereport(ERROR,
+					(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+					 errmsg("resolution must be at least 2")));
+
+		state = ts_points_create(aggcontext, TS_POINTS_INITIAL_SIZE);
+		state->resolution = resolution;
+	}
+	else if (state->resolution != resolution)
+		elog(ERROR, "resolution cannot change between rows");
+
+	point.value = PG_GETARG_FLOAT8(1);
+	point.time = PG_GETARG_TIMESTAMPTZ(2);
+
+	ts_points_append(state, &point, 1, true);
+
+	PG_RETURN_POINTER(state);
+}
+
+/*
+ * Serialize a downsampled series: the number of points followed by the time
+ * and value of each point.
+ */
+static bytea *
+ts_points_series_send(TSPoint *points, int32 npoints)
+{
+	StringInfoData buf;
+	int32		i;
+
+	pq_begintypsend(&buf);
+	pq_sendint(&buf, npoints, 4);
+
+	for (i = 0; i < npoints; i++)
+	{
+		pq_sendtimestamp(&buf, points[i].time);
+		pq_sendfloat8(&buf, points[i].value);
+	}
+
+	return pq_endtypsend(&buf);
+}
+
+static TSPoints *
+ts_points_series_recv(bytea *series)
+{
+	StringInfoData buf;
+	TSPoints   *state;
+	int32		npoints;
+	int32		i;
+
+	buf.data = VARDATA(series);
+	buf.len = VARSIZE(series) - VARHDRSZ;
+	buf.maxlen = buf.len;
+	buf.cursor = 0;
+
+	npoints = pq_getmsgint(&buf, 4);
+
+	if (npoints < 0 || (Size) (buf.len - buf.cursor) != sizeof(TSPoint) * (Size) npoints)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+				 errmsg("invalid series of points")));
+
+	state = ts_points_create(CurrentMemoryContext, Max(npoints, 1));
+	state->npoints = npoints;
+
+	for (i = 0; i < npoints; i++)
+	{
+		state->points[i].time = pq_getmsgtimestamp(&buf);
+		state->points[i].value = pq_getmsgfloat8(&buf);
+	}
+
+	pq_getmsgend(&buf);
+
+	return state;
+}
+
+/*
+ * Largest-triangle-three-buckets: the first and last points are kept, and the
+ * points in between are split into resolution - 2 buckets of equal size. From
+ * each bucket, the point that forms the largest triangle with the point picked
+ * from the previous bucket and the average point of the next bucket is kept.
+ */
+static int32
+lttb_downsample(TSPoint *points, int32 npoints, int32 resolution, TSPoint *result)
+{
+	double		every = (double) (npoints - 2) / (resolution - 2);
+	int32		prev = 0;
+	int32		nresult = 0;
+	int32		i,
+				j;
+
+	/* Times are relative to the first point to keep their precision */
+#define POINT_X(p) ((double) ((p).time - points[0].time))
+
+	result[nresult++] = points[0];
+
+	for (i = 0; i < resolution - 2; i++)
+	{
+		int32		start = (int32) floor(i * every) + 1;
+		int32		end = (int32) floor((i + 1) * every) + 1;
+		int32		avg_start = end;
+		int32		avg_end = Min((int32) floor((i + 2) * every) + 1, npoints);
+		double		avg_x = 0;
+		double		avg_y = 0;
+		double		prev_x = POINT_X(points[prev]);
+		double		prev_y = points[prev].value;
+		double		max_area = -1;
+		int32		next = start;
+
+		for (j = avg_start; j < avg_end; j++)
+		{
+			avg_x += POINT_X(points[j]);
+			avg_y += points[j].value;
+		}
+
+		avg_x /= avg_end - avg_start;
+		avg_y /= avg_end - avg_start;
+
+		for (j = start; j < end; j++)
+		{
+			/* Twice the area of the triangle, which does not change the maximum */
+			double		area = fabs((prev_x - avg_x) * (points[j].value - prev_y) -
+									(prev_x - POINT_X(points[j])) * (avg_y - prev_y));
+
+			if (area > max_area)
+			{
+				max_area = area;
+				next = j;
+			}
+		}
+
+		result[nresult++] = points[next];
+		prev = next;
+	}
+
+#undef POINT_X
+
+	result[nresult++] = points[npoints - 1];
+
+	return nresult;
+}
+
+/* lttb_finalfunc(internal, ...) => bytea */
+Datum
+lttb_finalfunc(PG_FUNCTION_ARGS)
+{
+	TSPoints   *state;
+	TSPoint    *result;
+	int32		nresult;
+
+	if (!AggCheckCallContext(fcinfo, NULL))
+	{
+		/* cannot be called directly because of internal-type argument */
+		elog(ERROR, "lttb_finalfunc called in non-aggregate context");
+	}
+
+	if (PG_ARGISNULL(0))
+		PG_RETURN_NULL();
+
+	state = (TSPoints *) PG_GETARG_POINTER(0);
+	ts_points_sort(state);
+
+	if (state->npoints <= state->resolution)
+		PG_RETURN_BYTEA_P(ts_points_series_send(state->points, state->npoints));
+
+	result = palloc(sizeof(TSPoint) * state->resolution);
+	nresult = lttb_downsample(state->points, state->npoints, state->resolution, result);
+
+	PG_RETURN_BYTEA_P(ts_points_series_send(result, nresult));
+}
+
+/*
+ * Keep the minimum and maximum points of each of resolution / 2 equal time
+ * ranges between the first and last points, in time order.
+ */
+static int32
+minmax_downsample(TSPoint *points, int32 npoints, int32 resolution, TSPoint *result)
+{
+	int32		nbuckets = resolution / 2;
+	double		width = (double) (points[npoints - 1].time - points[0].time) / nbuckets;
+	int32		nresult = 0;
+	int32		bucket = -1;
+	int32		min = 0;
+	int32		max = 0;
+	int32		i;
+
+	for (i = 0; i <= npoints; i++)
+	{
+		int32		b = -1;
+
+		if (i < npoints)
+		{
+			b = width > 0 ? (int32) ((double) (points[i].time - points[0].time) / width) : 0;
+			b = Min(b, nbuckets - 1);
+		}
+
+		if (b == bucket)
+		{
+			if (points[i].value < points[min].value)
+				min = i;
+			if (points[i].value > points[max].value)
+				max = i;
+			continue;
+		}
+
+		/* Flush the previous bucket */
+		if (bucket >= 0)
+		{
+			result[nresult++] = points[Min(min, max)];
+			if (min != max)
+				result[nresult++] = points[Max(min, max)];
+		}
+
+		bucket = b;
+		min = max = i;
+	}
+
+	return nresult;
+}
+
+/* minmax_downsample_finalfunc(internal, ...) => bytea */
+Datum
+minmax_downsample_finalfunc(PG_FUNCTION_ARGS)
+{
+	TSPoints   *state;
+	TSPoint    *result;
+	int32		nresult;
+
+	if (!AggCheckCallContext(fcinfo, NULL))
+	{
+		/* cannot be called directly because of internal-type argument */
+		elog(ERROR, "minmax_downsample_finalfunc called in non-aggregate context");
+	}
+
+	if (PG_ARGISNULL(0))
+		PG_RETURN_NULL();
+
+	state = (TSPoints *) PG_GETARG_POINTER(0);
+	ts_points_sort(state);
+
+	if (state->npoints <= state->resolution)
+		PG_RETURN_BYTEA_P(ts_points_series_send(state->points, state->npoints));
+
+	result = palloc(sizeof(TSPoint) * state->resolution);
+	nresult = minmax_downsample(state->points, state->npoints, state->resolution, result);
+
+	PG_RETURN_BYTEA_P(ts_points_series_send(result, nresult));
+}
+
+static MinMaxBuckets *
+minmax_buckets_create(MemoryContext mcxt, int32 resolution, TimestampTz start, TimestampTz finish)
+{
+	int32		nbuckets = resolution / 2;
+	MinMaxBuckets *state = MemoryContextAlloc(mcxt, offsetof(MinMaxBuckets, buckets) +
+											  sizeof(MinMaxBucket) * nbuckets);
+	int32		i;
+
+	state->resolution = resolution;
+	state->start = start;
+	state->finish = finish;
+	state->nbuckets = nbuckets;
+
+	for (i = 0; i < nbuckets; i++)
+		state->buckets[i].empty = true;
+
+	return state;
+}
+
+/*
+ * Add a point to a bucket. Of points with the same value, the earliest one is
+ * kept, so that the result does not depend on the order of the input.
+ */
+static void
+minmax_bucket_add(MinMaxBucket *bucket, TSPoint *min, TSPoint *max)
+{
+	if (bucket->empty)
+	{
+		bucket->min = *min;
+		bucket->max = *max;
+		bucket->empty = false;
+		return;
+	}
+
+	if (min->value < bucket->min.value ||
+		(min->value == bucket->min.value && min->time < bucket->min.time))
+		bucket->min = *min;
+
+	if (max->value > bucket->max.value ||
+		(max->value == bucket->max.value && max->time < bucket->max.time))
+		bucket->max = *max;
+}
+
+/*
+ * minmax_buckets_sfunc(internal, value DOUBLE PRECISION, time TIMESTAMPTZ,
+ *						resolution INTEGER, start TIMESTAMPTZ, finish TIMESTAMPTZ)
+ */
+Datum
+minmax_buckets_sfunc(PG_FUNCTION_ARGS)
+{
+	MemoryContext aggcontext;
+	MinMaxBuckets *state = PG_ARGISNULL(0) ? NULL : (MinMaxBuckets *) PG_GETARG_POINTER(0);
+	TSPoint		point;
+	int32		resolution;
+	TimestampTz start;
+	TimestampTz finish;
+	int32		bucket;
+
+	if (!AggCheckCallContext(fcinfo, &aggcontext))
+	{
+		/* cannot be called directly because of internal-type argument */
+		elog(ERROR, "minmax_buckets_sfunc called in non-aggregate context");
+	}
+
+	if (PG_ARGISNULL(1) || PG_ARGISNULL(2) || PG_ARGISNULL(3) ||
+		PG_ARGISNULL(4) || PG_ARGISNULL(5))
+	{
+		if (state == NULL)
+			PG_RETURN_NULL();
+		PG_RETURN_POINTER(state);
+	}
+
+	resolution = PG_GETARG_INT32(3);
+	start = PG_GETARG_TIMESTAMPTZ(4);
+	finish = PG_GETARG_TIMESTAMPTZ(5);
+
+	if (state == NULL)
+	{
+		if (resolution < 2)
+			ereport(ERROR,
+					(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+					 errmsg("resolution must be at least 2")));
+
+		if (finish <= start)
+			ereport(ERROR,
+					(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+					 errmsg("finish must be after start")));
+
+		state = minmax_buckets_create(aggcontext, resolution, start, finish);
+	}
+	else if (state->resolution != resolution || state->start != start || state->finish != finish)
+		elog(ERROR, "resolution and time range cannot change between rows");
+
+	point.value = PG_GETARG_FLOAT8(1);
+	point.time = PG_GETARG_TIMESTAMPTZ(2);
+
+	if (point.time < start || point.time >= finish)
+		PG_RETURN_POINTER(state);
+
+	bucket = (int32) ((double) (point.time - start) / (double) (finish - start) * state->nbuckets);
+	bucket = Min(bucket, state->nbuckets - 1);
+	minmax_bucket_add(&state->buckets[bucket], &point, &point);
+
+	PG_RETURN_POINTER(state);
+}
+
+/* minmax_buckets_combinefunc(internal, internal) => internal */
+Datum
+minmax_buckets_combinefunc(PG_FUNCTION_ARGS)
+{
+	MemoryContext aggcontext;
+	MinMaxBuckets *state1 = PG_ARGISNULL(0) ? NULL : (MinMaxBuckets *) PG_GETARG_POINTER(0);
+	MinMaxBuckets *state2 = PG_ARGISNULL(1) ? NULL : (MinMaxBuckets *) PG_GETARG_POINTER(1);
+	int32		i;
+
+	if (!AggCheckCallContext(fcinfo, &aggcontext))
+	{
+		/* cannot be called directly because of internal-type argument */
+		elog(ERROR, "minmax_buckets_combinefunc called in non-aggregate context");
+	}
+
+	if (state2 == NULL)
+	{
+		if (state1 == NULL)
+			PG_RETURN_NULL();
+		PG_RETURN_POINTER(state1);
+	}
+
+	/* state2 might not live in the aggregate context, so copy it */
+	if (state1 == NULL)
+		state1 = minmax_buckets_create(aggcontext, state2->resolution, state2->start, state2->finish);
+	else if (state1->resolution != state2->resolution ||
+			 state1->start != state2->start || state1->finish != state2->finish)
+		elog(ERROR, "cannot combine series downsampled to different resolutions or time ranges");
+
+	for (i = 0; i < state2->nbuckets; i++)
+		if (!state2->buckets[i].empty)
+			minmax_bucket_add(&state1->buckets[i], &state2->buckets[i].min, &state2->buckets[i].max);
+
+	PG_RETURN_POINTER(state1);
+}
+
+/* minmax_buckets_serializefunc(internal) => bytea */
+Datum
+minmax_buckets_serializefunc(PG_FUNCTION_ARGS)
+{
+	MinMaxBuckets *state;
+	StringInfoData buf;
+	int32		i;
+
+	Assert(!PG_ARGISNULL(0));
+	state = (MinMaxBuckets *) PG_GETARG_POINTER(0);
+
+	pq_begintypsend(&buf);
+	pq_sendint(&buf, state->resolution, 4);
+	pq_sendtimestamp(&buf, state->start);
+	pq_sendtimestamp(&buf, state->finish);
+
+	for (i = 0; i < state->nbuckets; i++)
+	{
+		MinMaxBucket *bucket = &state->buckets[i];
+
+		pq_sendbyte(&buf, bucket->empty);
+
+		if (bucket->empty)
+			continue;
+
+		pq_sendtimestamp(&buf, bucket->min.time);
+		pq_sendfloat8(&buf, bucket->min.value);
+		pq_sendtimestamp(&buf, bucket->max.time);
+		pq_sendfloat8(&buf, bucket->max.value);
+	}
+
+	PG_RETURN_BYTEA_P(pq_endtypsend(&buf));
+}
+
+/* minmax_buckets_deserializefunc(bytea, internal) => internal */
+Datum
+minmax_buckets_deserializefunc(PG_FUNCTION_ARGS)
+{
+	bytea	   *sstate;
+	StringInfoData buf;
+	MinMaxBuckets *state;
+	int32		resolution;
+	TimestampTz start;
+	TimestampTz finish;
+	int32		i;
+
+	Assert(!PG_ARGISNULL(0));
+	sstate = PG_GETARG_BYTEA_P(0);
+
+	/* Set up a StringInfo pointing into the bytea, which is not modified */
+	buf.data = VARDATA(sstate);
+	buf.len = VARSIZE(sstate) - VARHDRSZ;
+	buf.maxlen = buf.len;
+	buf.cursor = 0;
+
+	resolution = pq_getmsgint(&buf, 4);
+	start = pq_getmsgtimestamp(&buf);
+	finish = pq_getmsgtimestamp(&buf);
+
+	if (resolution < 2)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+				 errmsg("invalid time-series aggregate state")));
+
+	state = minmax_buckets_create(CurrentMemoryContext, resolution, start, finish);
+
+	for (i = 0; i < state->nbuckets; i++)
+	{
+		MinMaxBucket *bucket = &state->buckets[i];
+
+		bucket->empty = pq_getmsgbyte(&buf) != 0;
+
+		if (bucket->empty)
+			continue;
+
+		bucket->min.time = pq_getmsgtimestamp(&buf);
+		bucket->min.value = pq_getmsgfloat8(&buf);
+		bucket->max.time = pq_getmsgtimestamp(&buf);
+		bucket->max.value = pq_getmsgfloat8(&buf);
+	}
+
+	pq_getmsgend(&buf);
+
+	PG_RETURN_POINTER(state);
+}
+
+/* minmax_buckets_finalfunc(internal) => bytea */
+Datum
+minmax_buckets_finalfunc(PG_FUNCTION_ARGS)
+{
+	MinMaxBuckets *state;
+	TSPoint    *result;
+	int32		nresult = 0;
+	int32		i;
+
+	if (!AggCheckCallContext(fcinfo, NULL))
+	{
+		/* cannot be called directly because of internal-type argument */
+		elog(ERROR, "minmax_buckets_finalfunc called in non-aggregate context");
+	}
+
+	if (PG_ARGISNULL(0))
+		PG_RETURN_NULL();
+
+	state = (MinMaxBuckets *) PG_GETARG_POINTER(0);
+	result = palloc(sizeof(TSPoint) * state->nbuckets * 2);
+
+	/* The buckets are in time order, and so are the points of each bucket */
+	for (i = 0; i < state->nbuckets; i++)
+	{
+		MinMaxBucket *bucket = &state->buckets[i];
+		int			cmp;
+
+		if (bucket->empty)
+			continue;
+
+		cmp = ts_point_cmp(&bucket->min, &bucket->max);
+		result[nresult++] = cmp <= 0 ? bucket->min : bucket->max;
+
+		if (cmp != 0)
+			result[nresult++] = cmp < 0 ? bucket->max : bucket->min;
+	}
+
+	PG_RETURN_BYTEA_P(ts_points_series_send(result, nresult));
+}
+
+/* unnest_points(series bytea) => TABLE (time TIMESTAMPTZ, value DOUBLE PRECISION) */
+Datum
+ts_points_unnest(PG_FUNCTION_ARGS)
+{
+	FuncCallContext *funcctx;
+	TSPoints   *series;
+
+	if (SRF_IS_FIRSTCALL())
+	{
+		MemoryContext oldcontext;
+		TupleDesc	tupdesc;
+
+		funcctx = SRF_FIRSTCALL_INIT();
+		oldcontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+
+		if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+			ereport(ERROR,
+					(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					 errmsg("function returning record called in context "
+							"that cannot accept type record")));
+
+		funcctx->tuple_desc = BlessTupleDesc(tupdesc);
+		funcctx->user_fctx = ts_points_series_recv(PG_GETARG_BYTEA_P(0));
+		MemoryContextSwitchTo(oldcontext);
+	}
+
+	funcctx = SRF_PERCALL_SETUP();
+	series = funcctx->user_fctx;
+
+	if (funcctx->call_cntr < (uint64) series->npoints)
+	{
+		TSPoint    *point = &series->points[funcctx->call_cntr];
+		Datum		values[2];
+		bool		nulls[2] = {false, false};
+		HeapTuple	tuple;
+
+		values[0] = TimestampTzGetDatum(point->time);
+		values[1] = Float8GetDatum(point->value);
+		tuple = heap_form_tuple(funcctx->tuple_desc, values, nulls);
+
+		SRF_RETURN_NEXT(funcctx, HeapTupleGetDatum(tuple));
+	}
+
+	SRF_RETURN_DONE(funcctx);
+}
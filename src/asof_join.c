@@ -0,0 +1,1220 @@
+#include <postgres.h>
+#include <math.h>
+#include <catalog/pg_am.h>
+#include <commands/explain.h>
+#include <executor/executor.h>
+#include <miscadmin.h>
+#include <nodes/extensible.h>
+#include <nodes/makefuncs.h>
+#include <nodes/nodeFuncs.h>
+#include <optimizer/cost.h>
+#include <optimizer/pathnode.h>
+#include <optimizer/prep.h>
+#include <utils/datum.h>
+#include <utils/lsyscache.h>
+#include <utils/memutils.h>
+#include <utils/tuplesort.h>
+#include <utils/typcache.h>
+
+#include "asof_join.h"
+#include "constraint_aware_append.h"
+#include "decompress_chunk.h"
+#include "utils.h"
+#include "compat.h"
+
+/*
+ * ASOF joins match every row of one side of a join (the probe side, e.g.,
+ * trades) with the latest row of the other side (the build side, e.g.,
+ * quotes) at or before its time, optionally among the rows with equal keys:
+ *
+ *	 SELECT * FROM trades t
+ *	 LEFT JOIN quotes q ON q.symbol = t.symbol AND asof(q.time, t.time);
+ *
+ * PostgreSQL has no syntax for this, so the join is marked by the asof(ts,
+ * at_time) condition. Without the node, the same result needs a LATERAL subquery
+ * with ORDER BY time DESC LIMIT 1 for every probe row.
+ *
+ * The node merges the two sides in time order in a single pass. Every side
+ * is read from ordered index scans on its chunks, which the node merges by
+ * time itself, so no Sort or MergeAppend of the whole side is needed. Inputs
+ * without an index on time are sorted by the node. Build rows are consumed
+ * up to the time of the current probe row and kept in a hash table that
+ * holds only the latest build row per key, so the probe row finds its match
+ * with a single lookup.
+ */
+
+struct AsofJoinInput
+{
+	PlanState  *ps;
+	bool		ordered;		/* the plan returns tuples in time order */
+	Tuplesortstate *sortstate;	/* sorts the tuples of an unordered plan */
+	TupleTableSlot *sort_slot;
+	TupleTableSlot *slot;		/* current tuple */
+};
+
+struct AsofJoinKey
+{
+	AttrNumber	probe_attno;
+	AttrNumber	build_attno;
+	bool		probe_is_left;	/* the probe column is the left operand */
+	Oid			collation;
+	FmgrInfo	eq_fn;			/* the join operator */
+	FmgrInfo	probe_hash;
+	FmgrInfo	build_hash;
+	FmgrInfo   *build_eq;		/* equality of two build values */
+	int16		build_typlen;
+	bool		build_typbyval;
+};
+
+/* The latest build tuple of a key */
+typedef struct AsofJoinMatch
+{
+	Datum	   *key_values;
+	MinimalTuple tuple;
+} AsofJoinMatch;
+
+typedef struct AsofJoinHashEntry
+{
+	uint32		hash;
+	List	   *matches;		/* matches of the keys with this hash */
+} AsofJoinHashEntry;
+
+typedef struct AsofJoinPath
+{
+	CustomPath	cpath;
+	List	   *probe_tlist;	/* columns of the probe side */
+	List	   *build_tlist;	/* columns of the build side */
+	int			num_probe_inputs;
+	List	   *ordered;		/* whether every input is ordered by time */
+	Var		   *probe_time;
+	Var		   *build_time;
+	List	   *probe_keys;		/* key columns of the probe side */
+	List	   *build_keys;		/* key columns of the build side */
+	List	   *key_ops;
+	List	   *key_probe_is_left;
+	List	   *key_collations;
+	List	   *filter;			/* RestrictInfos of the other join clauses */
+	bool		left_join;
+} AsofJoinPath;
+
+#define LOG2(x) (log(x) / 0.693147180559945)
+
+TS_FUNCTION_INFO_V1(asof_join_marker);
+
+/* asof(ts, at_time) only marks the join condition of an ASOF join */
+Datum
+asof_join_marker(PG_FUNCTION_ARGS)
+{
+	ereport(ERROR,
+			(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+			 errmsg("asof() can only be used as a join condition of an ASOF join"),
+			 errhint("Use asof() in the ON clause of a join between two tables, "
+					 "e.g., JOIN quotes q ON asof(q.time, t.time).")));
+
+	PG_RETURN_BOOL(false);
+}
+
+static bool
+is_asof_call(Node *node)
+{
+	return IsA(node, FuncExpr) &&
+		list_length(((FuncExpr *) node)->args) == 2 &&
+		function_has_symbol(((FuncExpr *) node)->funcid, "asof_join_marker");
+}
+
+static int
+asof_join_heap_compare(Datum a, Datum b, void *arg)
+{
+	AsofJoinSide *side = arg;
+	TupleTableSlot *slot_a = side->inputs[DatumGetInt32(a)].slot;
+	TupleTableSlot *slot_b = side->inputs[DatumGetInt32(b)].slot;
+	Datum		value_a,
+				value_b;
+	bool		isnull_a,
+				isnull_b;
+
+	value_a = slot_getattr(slot_a, side->time_attno, &isnull_a);
+	value_b = slot_getattr(slot_b, side->time_attno, &isnull_b);
+
+	/* The heap is a max-heap, so invert the order to get the earliest time */
+	return -ApplySortComparator(value_a, isnull_a, value_b, isnull_b, side->time_sort);
+}
+
+static void
+asof_join_side_init(AsofJoinState *state, AsofJoinSide *side, List *plans, List *ordered, AttrNumber time_attno)
+{
+	ListCell   *lc_plan,
+			   *lc_ordered;
+	int			i = 0;
+
+	side->ninputs = list_length(plans);
+	side->inputs = palloc0(sizeof(AsofJoinInput) * Max(side->ninputs, 1));
+	side->time_attno = time_attno;
+	side->time_sort = &state->time_sort;
+	side->heap = binaryheap_allocate(Max(side->ninputs, 1), asof_join_heap_compare, side);
+	side->started = false;
+
+	forboth(lc_plan, plans, lc_ordered, ordered)
+	{
+		side->inputs[i].ps = lfirst(lc_plan);
+		side->inputs[i].ordered = lfirst_int(lc_ordered);
+		i++;
+	}
+}
+
+static void
+asof_join_input_sort(AsofJoinState *state, AsofJoinSide *side, AsofJoinInput *input)
+{
+	TupleDesc	tupdesc = ExecGetResultType(input->ps);
+	bool		nulls_first = false;
+
+	input->sortstate = tuplesort_begin_heap(tupdesc, 1, &side->time_attno,
+											&state->time_sortop,
+											&state->time_collation,
+											&nulls_first, work_mem, false);
+
+	for (;;)
+	{
+		TupleTableSlot *slot = ExecProcNode(input->ps);
+
+		if (TupIsNull(slot))
+			break;
+
+		tuplesort_puttupleslot(input->sortstate, slot);
+	}
+
+	tuplesort_performsort(input->sortstate);
+	input->sort_slot = MakeSingleTupleTableSlot(tupdesc);
+}
+
+/* Fetch the next tuple of an input in time order. Returns false when done */
+static bool
+asof_join_input_fetch(AsofJoinState *state, AsofJoinSide *side, AsofJoinInput *input)
+{
+	if (input->ordered)
+	{
+		input->slot = ExecProcNode(input->ps);
+		return !TupIsNull(input->slot);
+	}
+
+	if (NULL == input->sortstate)
+		asof_join_input_sort(state, side, input);
+
+	input->slot = input->sort_slot;
+
+#if PG10
+	return tuplesort_gettupleslot(input->sortstate, true, false, input->slot, NULL);
+#elif PG96
+	return tuplesort_gettupleslot(input->sortstate, true, input->slot, NULL);
+#endif
+}
+
+/*
+ * Get the earliest tuple of a side without consuming it, or NULL if the side
+ * is done.
+ */
+static TupleTableSlot *
+asof_join_side_first(AsofJoinState *state, AsofJoinSide *side)
+{
+	if (!side->started)
+	{
+		int			i;
+
+		for (i = 0; i < side->ninputs; i++)
+			if (asof_join_input_fetch(state, side, &side->inputs[i]))
+				binaryheap_add_unordered(side->heap, Int32GetDatum(i));
+
+		binaryheap_build(side->heap);
+		side->started = true;
+	}
+
+	if (binaryheap_empty(side->heap))
+		return NULL;
+
+	return side->inputs[DatumGetInt32(binaryheap_first(side->heap))].slot;
+}
+
+/* Consume the earliest tuple of a side */
+static void
+asof_join_side_advance(AsofJoinState *state, AsofJoinSide *side)
+{
+	int			i = DatumGetInt32(binaryheap_first(side->heap));
+
+	if (asof_join_input_fetch(state, side, &side->inputs[i]))
+		binaryheap_replace_first(side->heap, Int32GetDatum(i));
+	else
+		binaryheap_remove_first(side->heap);
+}
+
+static void
+asof_join_side_reset(AsofJoinSide *side)
+{
+	int			i;
+
+	for (i = 0; i < side->ninputs; i++)
+	{
+		AsofJoinInput *input = &side->inputs[i];
+
+		if (NULL != input->sortstate)
+		{
+			tuplesort_end(input->sortstate);
+			ExecDropSingleTupleTableSlot(input->sort_slot);
+		}
+
+		input->sortstate = NULL;
+		input->sort_slot = NULL;
+		input->slot = NULL;
+	}
+
+	binaryheap_reset(side->heap);
+	side->started = false;
+}
+
+static void
+asof_join_reset_matches(AsofJoinState *state)
+{
+	HASHCTL		ctl;
+
+	MemoryContextReset(state->match_context);
+
+	memset(&ctl, 0, sizeof(ctl));
+	ctl.keysize = sizeof(uint32);
+	ctl.entrysize = sizeof(AsofJoinHashEntry);
+	ctl.hcxt = state->match_context;
+
+	state->matches = hash_create("AsofJoin matches", 256, &ctl,
+								 HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
+}
+
+/*
+ * Get the key of a probe or build tuple and its hash. Returns false if a key
+ * column is NULL, since NULL keys never match.
+ */
+static bool
+asof_join_tuple_key(AsofJoinState *state, TupleTableSlot *slot, bool probe, uint32 *hash)
+{
+	int			i;
+
+	*hash = 0;
+
+	for (i = 0; i < state->nkeys; i++)
+	{
+		AsofJoinKey *key = &state->keys[i];
+		bool		isnull;
+		Datum		value = slot_getattr(slot, probe ? key->probe_attno : key->build_attno, &isnull);
+
+		if (isnull)
+			return false;
+
+		state->key_values[i] = value;
+		*hash = (*hash << 1) | (*hash >> 31);
+		*hash ^= DatumGetUInt32(FunctionCall1Coll(probe ? &key->probe_hash : &key->build_hash,
+												  key->collation,
+												  value));
+	}
+
+	return true;
+}
+
+static bool
+asof_join_key_matches(AsofJoinState *state, AsofJoinMatch *match, bool probe)
+{
+	int			i;
+
+	for (i = 0; i < state->nkeys; i++)
+	{
+		AsofJoinKey *key = &state->keys[i];
+		Datum		value = state->key_values[i];
+		Datum		result;
+
+		if (!probe)
+			result = FunctionCall2Coll(key->build_eq, key->collation, match->key_values[i], value);
+		else if (key->probe_is_left)
+			result = FunctionCall2Coll(&key->eq_fn, key->collation, value, match->key_values[i]);
+		else
+			result = FunctionCall2Coll(&key->eq_fn, key->collation, match->key_values[i], value);
+
+		if (!DatumGetBool(result))
+			return false;
+	}
+
+	return true;
+}
+
+/* Make a build tuple the latest one of its key */
+static void
+asof_join_store(AsofJoinState *state, TupleTableSlot *slot)
+{
+	AsofJoinHashEntry *entry;
+	AsofJoinMatch *match = NULL;
+	MemoryContext old;
+	ListCell   *lc;
+	uint32		hash;
+	bool		found;
+	int			i;
+
+	if (!asof_join_tuple_key(state, slot, false, &hash))
+		return;
+
+	entry = hash_search(state->matches, &hash, HASH_ENTER, &found);
+
+	if (!found)
+		entry->matches = NIL;
+
+	foreach(lc, entry->matches)
+	{
+		if (asof_join_key_matches(state, lfirst(lc), false))
+		{
+			match = lfirst(lc);
+			break;
+		}
+	}
+
+	old = MemoryContextSwitchTo(state->match_context);
+
+	if (NULL == match)
+	{
+		match = palloc(sizeof(AsofJoinMatch));
+		match->key_values = palloc(sizeof(Datum) * Max(state->nkeys, 1));
+		match->tuple = NULL;
+
+		for (i = 0; i < state->nkeys; i++)
+			match->key_values[i] = datumCopy(state->key_values[i],
+											 state->keys[i].build_typbyval,
+											 state->keys[i].build_typlen);
+
+		entry->matches = lappend(entry->matches, match);
+	}
+
+	if (NULL != match->tuple)
+		pfree(match->tuple);
+
+	match->tuple = ExecCopySlotMinimalTuple(slot);
+
+	MemoryContextSwitchTo(old);
+}
+
+static AsofJoinMatch *
+asof_join_lookup(AsofJoinState *state, TupleTableSlot *slot)
+{
+	AsofJoinHashEntry *entry;
+	ListCell   *lc;
+	uint32		hash;
+
+	if (!asof_join_tuple_key(state, slot, true, &hash))
+		return NULL;
+
+	entry = hash_search(state->matches, &hash, HASH_FIND, NULL);
+
+	if (NULL == entry)
+		return NULL;
+
+	foreach(lc, entry->matches)
+		if (asof_join_key_matches(state, lfirst(lc), true))
+			return lfirst(lc);
+
+	return NULL;
+}
+
+/*
+ * Consume the build tuples up to the time of a probe tuple. Build tuples
+ * with a NULL time sort last and match no probe tuple, so they stop the
+ * build side.
+ */
+static void
+asof_join_build_until(AsofJoinState *state, Datum time)
+{
+	TupleTableSlot *slot;
+
+	while (NULL != (slot = asof_join_side_first(state, &state->build)))
+	{
+		bool		isnull;
+		Datum		build_time = slot_getattr(slot, state->build.time_attno, &isnull);
+
+		if (isnull || ApplySortComparator(build_time, false, time, false, &state->time_sort) > 0)
+			break;
+
+		asof_join_store(state, slot);
+		asof_join_side_advance(state, &state->build);
+	}
+}
+
+static void
+asof_join_begin(CustomScanState *node, EState *estate, int eflags)
+{
+	AsofJoinState *state = (AsofJoinState *) node;
+	CustomScan *cscan = (CustomScan *) node->ss.ps.plan;
+	TupleDesc	tupdesc = node->ss.ss_ScanTupleSlot->tts_tupleDescriptor;
+	List	   *settings = linitial(cscan->custom_private);
+	List	   *ordered = lsecond(cscan->custom_private);
+	List	   *keys = lthird(cscan->custom_private);
+	int			num_probe_inputs = linitial_int(settings);
+	AttrNumber	probe_time_attno = lsecond_int(settings);
+	AttrNumber	build_time_attno = lthird_int(settings);
+	Form_pg_attribute time_attr = tupdesc->attrs[probe_time_attno - 1];
+	TypeCacheEntry *tce;
+	List	   *plans = NIL;
+	ListCell   *lc;
+	int			i = 0;
+
+	state->probe_ncolumns = lfourth_int(settings);
+	state->left_join = list_nth_int(settings, 4);
+
+	foreach(lc, cscan->custom_plans)
+		plans = lappend(plans, ExecInitNode(lfirst(lc), estate, eflags));
+
+	node->custom_ps = plans;
+
+	tce = lookup_type_cache(time_attr->atttypid, TYPECACHE_LT_OPR);
+
+	if (!OidIsValid(tce->lt_opr))
+		elog(ERROR, "could not find ordering operator for type %u", time_attr->atttypid);
+
+	state->time_sortop = tce->lt_opr;
+	state->time_collation = time_attr->attcollation;
+	state->time_sort.ssup_cxt = CurrentMemoryContext;
+	state->time_sort.ssup_collation = time_attr->attcollation;
+	state->time_sort.ssup_nulls_first = false;
+	PrepareSortSupportFromOrderingOp(tce->lt_opr, &state->time_sort);
+
+	asof_join_side_init(state, &state->probe,
+						list_truncate(list_copy(plans), num_probe_inputs),
+						list_truncate(list_copy(ordered), num_probe_inputs),
+						probe_time_attno);
+	asof_join_side_init(state, &state->build,
+						list_copy_tail(plans, num_probe_inputs),
+						list_copy_tail(ordered, num_probe_inputs),
+						build_time_attno - state->probe_ncolumns);
+
+	state->nkeys = list_length(keys);
+	state->keys = palloc0(sizeof(AsofJoinKey) * Max(state->nkeys, 1));
+	state->key_values = palloc0(sizeof(Datum) * Max(state->nkeys, 1));
+
+	foreach(lc, keys)
+	{
+		AsofJoinKey *key = &state->keys[i++];
+		List	   *attnos = linitial(lfirst(lc));
+		List	   *oids = lsecond(lfirst(lc));
+		Oid			opno = linitial_oid(oids);
+		Form_pg_attribute build_attr;
+		RegProcedure left_hash;
+		RegProcedure right_hash;
+
+		key->probe_attno = linitial_int(attnos);
+		key->build_attno = lsecond_int(attnos) - state->probe_ncolumns;
+		key->probe_is_left = lthird_int(attnos);
+		key->collation = lsecond_oid(oids);
+
+		build_attr = tupdesc->attrs[lsecond_int(attnos) - 1];
+		key->build_typlen = build_attr->attlen;
+		key->build_typbyval = build_attr->attbyval;
+
+		if (!get_op_hash_functions(opno, &left_hash, &right_hash))
+			elog(ERROR, "could not find hash functions for operator %u", opno);
+
+		fmgr_info(get_opcode(opno), &key->eq_fn);
+		fmgr_info(key->probe_is_left ? left_hash : right_hash, &key->probe_hash);
+		fmgr_info(key->probe_is_left ? right_hash : left_hash, &key->build_hash);
+
+		tce = lookup_type_cache(build_attr->atttypid, TYPECACHE_EQ_OPR_FINFO);
+
+		if (!OidIsValid(tce->eq_opr))
+			elog(ERROR, "could not find equality operator for type %u", build_attr->atttypid);
+
+		key->build_eq = &tce->eq_opr_finfo;
+	}
+
+	if (state->build.ninputs > 0)
+		state->match_slot = MakeSingleTupleTableSlot(ExecGetResultType(state->build.inputs[0].ps));
+
+	state->match_context = AllocSetContextCreate(CurrentMemoryContext,
+												 "AsofJoin matches",
+												 ALLOCSET_DEFAULT_SIZES);
+	asof_join_reset_matches(state);
+}
+
+static TupleTableSlot *
+asof_join_next(ScanState *node)
+{
+	AsofJoinState *state = (AsofJoinState *) node;
+	TupleTableSlot *slot = node->ss_ScanTupleSlot;
+	TupleTableSlot *probe_slot;
+	AsofJoinMatch *match;
+	int			natts = slot->tts_tupleDescriptor->natts;
+
+	ExecClearTuple(slot);
+
+	for (;;)
+	{
+		Datum		time;
+		bool		isnull;
+
+		if (state->probe_returned)
+			asof_join_side_advance(state, &state->probe);
+
+		probe_slot = asof_join_side_first(state, &state->probe);
+		state->probe_returned = probe_slot != NULL;
+
+		if (NULL == probe_slot)
+			return slot;
+
+		time = slot_getattr(probe_slot, state->probe.time_attno, &isnull);
+		match = NULL;
+
+		/* Probe tuples with a NULL time match nothing */
+		if (!isnull)
+		{
+			asof_join_build_until(state, time);
+			match = asof_join_lookup(state, probe_slot);
+		}
+
+		if (NULL != match || state->left_join)
+			break;
+
+		CHECK_FOR_INTERRUPTS();
+	}
+
+	slot_getallattrs(probe_slot);
+	memcpy(slot->tts_values, probe_slot->tts_values, sizeof(Datum) * state->probe_ncolumns);
+	memcpy(slot->tts_isnull, probe_slot->tts_isnull, sizeof(bool) * state->probe_ncolumns);
+
+	if (NULL != match)
+	{
+		ExecStoreMinimalTuple(match->tuple, state->match_slot, false);
+		slot_getallattrs(state->match_slot);
+		memcpy(slot->tts_values + state->probe_ncolumns,
+			   state->match_slot->tts_values,
+			   sizeof(Datum) * (natts - state->probe_ncolumns));
+		memcpy(slot->tts_isnull + state->probe_ncolumns,
+			   state->match_slot->tts_isnull,
+			   sizeof(bool) * (natts - state->probe_ncolumns));
+	}
+	else
+		memset(slot->tts_isnull + state->probe_ncolumns, true, natts - state->probe_ncolumns);
+
+	return ExecStoreVirtualTuple(slot);
+}
+
+/* Row locks are not supported, so there is nothing to recheck */
+static bool
+asof_join_recheck(ScanState *node, TupleTableSlot *slot)
+{
+	return true;
+}
+
+static TupleTableSlot *
+asof_join_exec(CustomScanState *node)
+{
+	return ExecScan(&node->ss, asof_join_next, asof_join_recheck);
+}
+
+static void
+asof_join_end(CustomScanState *node)
+{
+	AsofJoinState *state = (AsofJoinState *) node;
+	ListCell   *lc;
+
+	asof_join_side_reset(&state->probe);
+	asof_join_side_reset(&state->build);
+
+	if (NULL != state->match_slot)
+		ExecDropSingleTupleTableSlot(state->match_slot);
+
+	foreach(lc, node->custom_ps)
+		ExecEndNode(lfirst(lc));
+}
+
+static void
+asof_join_rescan(CustomScanState *node)
+{
+	AsofJoinState *state = (AsofJoinState *) node;
+	ListCell   *lc;
+
+	ExecScanReScan(&node->ss);
+
+	foreach(lc, node->custom_ps)
+	{
+		PlanState  *ps = lfirst(lc);
+
+		if (NULL != node->ss.ps.chgParam)
+			UpdateChangedParamSet(ps, node->ss.ps.chgParam);
+
+		/* Children with changed parameters are rescanned by ExecProcNode() */
+		if (NULL == ps->chgParam)
+			ExecReScan(ps);
+	}
+
+	asof_join_side_reset(&state->probe);
+	asof_join_side_reset(&state->build);
+	asof_join_reset_matches(state);
+	state->probe_returned = false;
+}
+
+static void
+asof_join_explain(CustomScanState *node, List *ancestors, ExplainState *es)
+{
+	AsofJoinState *state = (AsofJoinState *) node;
+
+	ExplainPropertyText("Join Type", state->left_join ? "Left" : "Inner", es);
+}
+
+static CustomExecMethods asof_join_state_methods = {
+	.CustomName = "AsofJoin",
+	.BeginCustomScan = asof_join_begin,
+	.ExecCustomScan = asof_join_exec,
+	.EndCustomScan = asof_join_end,
+	.ReScanCustomScan = asof_join_rescan,
+	.ExplainCustomScan = asof_join_explain,
+};
+
+static Node *
+asof_join_state_create(CustomScan *cscan)
+{
+	AsofJoinState *state;
+
+	state = (AsofJoinState *) newNode(sizeof(AsofJoinState), T_CustomScanState);
+	state->csstate.methods = &asof_join_state_methods;
+
+	return (Node *) state;
+}
+
+static CustomScanMethods asof_join_plan_methods = {
+	.CustomName = "AsofJoin",
+	.CreateCustomScanState = asof_join_state_create,
+};
+
+/* Get the position of a column in the columns of a side */
+static AttrNumber
+asof_join_tlist_attno(List *tlist, Var *var)
+{
+	ListCell   *lc;
+	int			attno = 1;
+
+	foreach(lc, tlist)
+	{
+		if (equal(lfirst(lc), var))
+			return attno;
+
+		attno++;
+	}
+
+	elog(ERROR, "column of ASOF join not found in its input");
+
+	return InvalidAttrNumber;	/* keep compiler quiet */
+}
+
+/*
+ * Scan tuples are the columns of the probe side followed by the columns of
+ * the build side, which the inputs return in the order of the side's target.
+ */
+static Plan *
+asof_join_plan_create(PlannerInfo *root,
+					  RelOptInfo *rel,
+					  struct CustomPath *path,
+					  List *tlist,
+					  List *clauses,
+					  List *custom_plans)
+{
+	AsofJoinPath *apath = (AsofJoinPath *) path;
+	CustomScan *cscan = makeNode(CustomScan);
+	int			probe_ncolumns = list_length(apath->probe_tlist);
+	List	   *scan_tlist = NIL;
+	List	   *quals = NIL;
+	List	   *keys = NIL;
+	List	   *settings;
+	ListCell   *lc;
+	AttrNumber	resno = 1;
+	int			i;
+
+	foreach(lc, list_concat(list_copy(apath->probe_tlist), apath->build_tlist))
+		scan_tlist = lappend(scan_tlist, makeTargetEntry(copyObject(lfirst(lc)), resno++, NULL, false));
+
+	for (i = 0; i < list_length(apath->probe_keys); i++)
+	{
+		List	   *attnos = list_make3_int(asof_join_tlist_attno(apath->probe_tlist, list_nth(apath->probe_keys, i)),
+											probe_ncolumns + asof_join_tlist_attno(apath->build_tlist, list_nth(apath->build_keys, i)),
+											list_nth_int(apath->key_probe_is_left, i));
+
+		keys = lappend(keys, list_make2(attnos,
+										list_make2_oid(list_nth_oid(apath->key_ops, i),
+													   list_nth_oid(apath->key_collations, i))));
+	}
+
+	/* Pseudoconstant clauses are checked per row, since there is no gating Result */
+	foreach(lc, apath->filter)
+		quals = lappend(quals, ((RestrictInfo *) lfirst(lc))->clause);
+
+	settings = list_make4_int(apath->num_probe_inputs,
+							  asof_join_tlist_attno(apath->probe_tlist, apath->probe_time),
+							  probe_ncolumns + asof_join_tlist_attno(apath->build_tlist, apath->build_time),
+							  probe_ncolumns);
+	settings = lappend_int(settings, apath->left_join);
+
+	cscan->scan.scanrelid = 0;
+	cscan->scan.plan.targetlist = tlist;
+	cscan->scan.plan.qual = quals;
+	cscan->custom_scan_tlist = scan_tlist;
+	cscan->custom_plans = custom_plans;
+	cscan->custom_exprs = NIL;
+	cscan->custom_private = list_make3(settings, apath->ordered, keys);
+	cscan->flags = path->flags;
+	cscan->methods = &asof_join_plan_methods;
+
+	return &cscan->scan.plan;
+}
+
+static CustomPathMethods asof_join_path_methods = {
+	.CustomName = "AsofJoin",
+	.PlanCustomPath = asof_join_plan_create,
+};
+
+static bool
+is_asof_join_path(Path *path)
+{
+	return IsA(path, CustomPath) && ((CustomPath *) path)->methods == &asof_join_path_methods;
+}
+
+/*
+ * Get the direction to scan an index in to return its tuples in ascending
+ * time order with NULLs last. Returns false if the index does not order by
+ * time that way.
+ */
+static bool
+asof_join_index_direction(IndexOptInfo *index, Var *time, ScanDirection *direction)
+{
+	TypeCacheEntry *tce = lookup_type_cache(time->vartype, TYPECACHE_BTREE_OPFAMILY);
+
+	if (index->relam != BTREE_AM_OID || index->ncolumns < 1 ||
+		index->indexkeys[0] != time->varattno ||
+		index->opfamily[0] != tce->btree_opf ||
+		index->indexcollations[0] != time->varcollid)
+		return false;
+
+	if (!index->reverse_sort[0] && !index->nulls_first[0])
+		*direction = ForwardScanDirection;
+	else if (index->reverse_sort[0] && index->nulls_first[0])
+		*direction = BackwardScanDirection;
+	else
+		return false;
+
+	return true;
+}
+
+/*
+ * Get a path that returns the rows of a relation in time order, if it has an
+ * index on time. Otherwise, returns its cheapest path and sets ordered to
+ * false, so that the node sorts its rows.
+ */
+static Path *
+asof_join_ordered_path(PlannerInfo *root, RelOptInfo *rel, Path *path, Var *time, bool *ordered)
+{
+	ScanDirection direction;
+	ListCell   *lc;
+
+	*ordered = false;
+
+	if (rel->reloptkind == RELOPT_JOINREL || rel->rtekind != RTE_RELATION || !IsA(time, Var))
+		return path;
+
+	/* Compressed chunks can only be read through DecompressChunk */
+	if (rel->pathlist != NIL && is_decompress_chunk_path(linitial(rel->pathlist)))
+		return path;
+
+	*ordered = true;
+
+	/* The index quals of existing index paths make them cheaper */
+	foreach(lc, rel->pathlist)
+	{
+		IndexPath  *index_path = lfirst(lc);
+
+		if (IsA(index_path, IndexPath) && index_path->path.param_info == NULL &&
+			asof_join_index_direction(index_path->indexinfo, time, &direction))
+		{
+			IndexPath  *ordered_path = makeNode(IndexPath);
+
+			memcpy(ordered_path, index_path, sizeof(IndexPath));
+			ordered_path->indexscandir = direction;
+			ordered_path->path.pathkeys = NIL;
+
+			return &ordered_path->path;
+		}
+	}
+
+	foreach(lc, rel->indexlist)
+	{
+		IndexOptInfo *index = lfirst(lc);
+
+		if ((index->indpred == NIL || index->predOK) &&
+			asof_join_index_direction(index, time, &direction))
+			return (Path *) create_index_path_compat(root, index, NIL, NIL, NIL, NIL, NIL,
+													 direction, false, NULL, 1.0);
+	}
+
+	*ordered = false;
+
+	return path;
+}
+
+/*
+ * Get the inputs of a side of the join. The chunks of a hypertable, or the
+ * children of another append relation, are separate inputs, so that each of
+ * them is read in time order from its own index. Returns false if the side
+ * has no unparameterized path.
+ */
+static bool
+asof_join_side_inputs(PlannerInfo *root, RelOptInfo *rel, Var *time, List **inputs, List **ordered)
+{
+	Path	   *path = rel->cheapest_total_path;
+	ListCell   *lc;
+	bool		is_ordered;
+
+	if (NULL == path || NULL != path->param_info)
+		return false;
+
+	if (is_constraint_aware_append_path(path))
+		path = linitial(((CustomPath *) path)->custom_paths);
+
+	if (IsA(path, AppendPath) && rel->reloptkind == RELOPT_BASEREL)
+	{
+		foreach(lc, ((AppendPath *) path)->subpaths)
+		{
+			Path	   *subpath = lfirst(lc);
+			RelOptInfo *child = subpath->parent;
+			AppendRelInfo *appinfo = find_childrel_appendrelinfo(root, child);
+			Var		   *child_time = (Var *) adjust_appendrel_attrs(root, (Node *) time, appinfo);
+
+			*inputs = lappend(*inputs, asof_join_ordered_path(root, child, subpath, child_time, &is_ordered));
+			*ordered = lappend_int(*ordered, is_ordered);
+		}
+
+		return true;
+	}
+
+	*inputs = lappend(*inputs, asof_join_ordered_path(root, rel, rel->cheapest_total_path, time, &is_ordered));
+	*ordered = lappend_int(*ordered, is_ordered);
+
+	return true;
+}
+
+static Path *
+asof_join_path_create(PlannerInfo *root, RelOptInfo *joinrel, AsofJoinPath *info,
+					  RelOptInfo *probe_rel, RelOptInfo *build_rel)
+{
+	AsofJoinPath *path;
+	List	   *inputs = NIL;
+	List	   *ordered = NIL;
+	ListCell   *lc_input,
+			   *lc_ordered;
+	Cost		startup_cost = 0;
+	Cost		total_cost = 0;
+	double		tuples = 0;
+
+	if (!asof_join_side_inputs(root, probe_rel, info->probe_time, &inputs, &ordered))
+		return NULL;
+
+	info->num_probe_inputs = list_length(inputs);
+
+	if (!asof_join_side_inputs(root, build_rel, info->build_time, &inputs, &ordered))
+		return NULL;
+
+	/* Unordered inputs are sorted before their first tuple is returned */
+	forboth(lc_input, inputs, lc_ordered, ordered)
+	{
+		Path	   *input = lfirst(lc_input);
+
+		if (lfirst_int(lc_ordered))
+		{
+			startup_cost += input->startup_cost;
+			total_cost += input->total_cost;
+		}
+		else
+		{
+			Path		sort_path;
+
+			cost_sort(&sort_path, root, NIL, input->total_cost, input->rows,
+					  input->pathtarget->width, 0.0, work_mem, -1.0);
+			startup_cost += sort_path.startup_cost;
+			total_cost += sort_path.total_cost;
+		}
+
+		tuples += input->rows;
+	}
+
+	/* Every tuple is merged by time and hashed by its key */
+	total_cost += tuples * cpu_operator_cost *
+		(list_length(info->probe_keys) + LOG2(list_length(inputs) + 1) + 1);
+
+	/* An ASOF join returns at most one row for every probe row */
+	joinrel->rows = probe_rel->rows;
+	total_cost += (cpu_tuple_cost + joinrel->reltarget->cost.per_tuple) * joinrel->rows;
+
+	path = (AsofJoinPath *) newNode(sizeof(AsofJoinPath), T_CustomPath);
+	memcpy(path, info, sizeof(AsofJoinPath));
+	path->cpath.path.pathtype = T_CustomScan;
+	path->cpath.path.parent = joinrel;
+	path->cpath.path.pathtarget = joinrel->reltarget;
+	path->cpath.path.param_info = NULL;
+	path->cpath.path.parallel_aware = false;
+	path->cpath.path.parallel_safe = false;
+	path->cpath.path.parallel_workers = 0;
+	path->cpath.path.rows = joinrel->rows;
+	path->cpath.path.startup_cost = startup_cost;
+	path->cpath.path.total_cost = total_cost;
+	path->cpath.path.pathkeys = NIL;
+	path->cpath.flags = 0;
+	path->cpath.custom_paths = inputs;
+	path->cpath.custom_private = NIL;
+	path->cpath.methods = &asof_join_path_methods;
+	path->ordered = ordered;
+	path->probe_tlist = probe_rel->reltarget->exprs;
+	path->build_tlist = build_rel->reltarget->exprs;
+
+	return &path->cpath.path;
+}
+
+static Node *
+asof_join_strip_relabel(Node *node)
+{
+	while (IsA(node, RelabelType))
+		node = (Node *) ((RelabelType *) node)->arg;
+
+	return node;
+}
+
+/*
+ * Add a join clause to the keys of the join if it is a hashable equality of a
+ * probe column and a build column.
+ */
+static bool
+asof_join_add_key(AsofJoinPath *path, RestrictInfo *rinfo, RelOptInfo *probe_rel, RelOptInfo *build_rel)
+{
+	OpExpr	   *op = (OpExpr *) rinfo->clause;
+	Var		   *left;
+	Var		   *right;
+	bool		probe_is_left;
+
+	if (!IsA(op, OpExpr) || list_length(op->args) != 2 || !OidIsValid(rinfo->hashjoinoperator))
+		return false;
+
+	left = (Var *) asof_join_strip_relabel(linitial(op->args));
+	right = (Var *) asof_join_strip_relabel(lsecond(op->args));
+
+	if (!IsA(left, Var) || !IsA(right, Var))
+		return false;
+
+	if (bms_is_member(left->varno, probe_rel->relids) && bms_is_member(right->varno, build_rel->relids))
+		probe_is_left = true;
+	else if (bms_is_member(right->varno, probe_rel->relids) && bms_is_member(left->varno, build_rel->relids))
+		probe_is_left = false;
+	else
+		return false;
+
+	path->probe_keys = lappend(path->probe_keys, probe_is_left ? left : right);
+	path->build_keys = lappend(path->build_keys, probe_is_left ? right : left);
+	path->key_ops = lappend_oid(path->key_ops, op->opno);
+	path->key_probe_is_left = lappend_int(path->key_probe_is_left, probe_is_left);
+	path->key_collations = lappend_oid(path->key_collations, op->inputcollid);
+
+	return true;
+}
+
+static bool
+asof_join_clauses_have_marker(List *clauses)
+{
+	ListCell   *lc;
+
+	foreach(lc, clauses)
+		if (is_asof_call((Node *) ((RestrictInfo *) lfirst(lc))->clause))
+			return true;
+
+	return false;
+}
+
+/* Check whether a path evaluates asof() as an ordinary join condition */
+static bool
+asof_join_path_has_marker(Path *path)
+{
+	ListCell   *lc;
+
+	if (NULL != path->param_info && asof_join_clauses_have_marker(path->param_info->ppi_clauses))
+		return true;
+
+	switch (nodeTag(path))
+	{
+		case T_NestPath:
+		case T_MergePath:
+		case T_HashPath:
+			{
+				JoinPath   *join = (JoinPath *) path;
+
+				return asof_join_clauses_have_marker(join->joinrestrictinfo) ||
+					asof_join_path_has_marker(join->outerjoinpath) ||
+					asof_join_path_has_marker(join->innerjoinpath);
+			}
+		case T_MaterialPath:
+			return asof_join_path_has_marker(((MaterialPath *) path)->subpath);
+		case T_UniquePath:
+			return asof_join_path_has_marker(((UniquePath *) path)->subpath);
+		case T_AppendPath:
+			foreach(lc, ((AppendPath *) path)->subpaths)
+				if (asof_join_path_has_marker(lfirst(lc)))
+					return true;
+			return false;
+		case T_MergeAppendPath:
+			foreach(lc, ((MergeAppendPath *) path)->subpaths)
+				if (asof_join_path_has_marker(lfirst(lc)))
+					return true;
+			return false;
+		default:
+			return false;
+	}
+}
+
+/*
+ * Plan a join with an asof() condition as an ASOF join. Since asof() cannot
+ * be evaluated as an ordinary condition, the paths of the join relation that
+ * would evaluate it are replaced with an AsofJoin path, and joins that an
+ * AsofJoin cannot do fail.
+ */
+void
+plan_add_asof_join(PlannerInfo *root, RelOptInfo *joinrel, RelOptInfo *outerrel,
+				   RelOptInfo *innerrel, JoinType jointype, JoinPathExtraData *extra)
+{
+	RestrictInfo *marker = NULL;
+	AsofJoinPath info;
+	RelOptInfo *probe_rel;
+	RelOptInfo *build_rel;
+	FuncExpr   *func;
+	Path	   *path;
+	List	   *pathlist = NIL;
+	bool		probe_is_outer;
+	bool		have_path = false;
+	ListCell   *lc;
+
+	foreach(lc, extra->restrictlist)
+	{
+		RestrictInfo *rinfo = lfirst(lc);
+
+		if (!is_asof_call((Node *) rinfo->clause))
+			continue;
+
+		if (NULL != marker)
+			ereport(ERROR,
+					(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					 errmsg("an ASOF join can only have one asof() condition")));
+
+		marker = rinfo;
+	}
+
+	if (NULL == marker)
+		return;
+
+	memset(&info, 0, sizeof(AsofJoinPath));
+	func = (FuncExpr *) marker->clause;
+	info.build_time = (Var *) linitial(func->args);
+	info.probe_time = (Var *) lsecond(func->args);
+
+	if (!IsA(info.build_time, Var) || !IsA(info.probe_time, Var) ||
+		info.build_time->varlevelsup != 0 || info.probe_time->varlevelsup != 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("the arguments of asof() must be columns of the joined tables")));
+
+	if (bms_is_member(info.probe_time->varno, outerrel->relids) &&
+		bms_is_member(info.build_time->varno, innerrel->relids))
+		probe_is_outer = true;
+	else if (bms_is_member(info.probe_time->varno, innerrel->relids) &&
+			 bms_is_member(info.build_time->varno, outerrel->relids))
+		probe_is_outer = false;
+	else
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("the arguments of asof() must be columns of the two sides of the join")));
+
+	probe_rel = probe_is_outer ? outerrel : innerrel;
+	build_rel = probe_is_outer ? innerrel : outerrel;
+
+	/* The outer side of a left join is the probe side */
+	switch (jointype)
+	{
+		case JOIN_INNER:
+			info.left_join = false;
+			break;
+		case JOIN_LEFT:
+		case JOIN_RIGHT:
+			if (probe_is_outer != (jointype == JOIN_LEFT))
+				ereport(ERROR,
+						(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+						 errmsg("the second argument of asof() must be a column of the outer side of a left join")));
+			info.left_join = true;
+			break;
+		default:
+			ereport(ERROR,
+					(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					 errmsg("ASOF joins must be inner or left joins")));
+	}
+
+	if (root->rowMarks != NIL)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("ASOF joins do not support UPDATE, DELETE or row locking clauses")));
+
+	foreach(lc, extra->restrictlist)
+	{
+		RestrictInfo *rinfo = lfirst(lc);
+
+		if (rinfo == marker)
+			continue;
+
+		/* The WHERE clauses of a left join filter the joined rows */
+		if (info.left_join && rinfo->is_pushed_down)
+			info.filter = lappend(info.filter, rinfo);
+		else if (asof_join_add_key(&info, rinfo, probe_rel, build_rel))
+			continue;
+		else if (info.left_join)
+			ereport(ERROR,
+					(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					 errmsg("unsupported join condition in ASOF join"),
+					 errdetail("Left ASOF joins only support equality conditions between columns of the two sides besides asof().")));
+		else
+			info.filter = lappend(info.filter, rinfo);
+	}
+
+	foreach(lc, joinrel->pathlist)
+	{
+		path = lfirst(lc);
+
+		if (is_asof_join_path(path))
+			have_path = true;
+
+		if (!asof_join_path_has_marker(path))
+			pathlist = lappend(pathlist, path);
+	}
+
+	joinrel->pathlist = pathlist;
+	joinrel->partial_pathlist = NIL;
+
+	if (have_path)
+		return;
+
+	path = asof_join_path_create(root, joinrel, &info, probe_rel, build_rel);
+
+	if (NULL == path)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("ASOF joins do not support LATERAL references")));
+
+	add_path(joinrel, path);
+}
+
+void
+_asof_join_init(void)
+{
+	/* Needed to (de)serialize the plan for parallel workers */
+	RegisterCustomScanMethods(&asof_join_plan_methods);
+}
+
+void
+_asof_join_fini(void)
+{
+}
@@ -0,0 +1,48 @@
+#ifndef TIMESCALEDB_ASOF_JOIN_H
+#define TIMESCALEDB_ASOF_JOIN_H
+
+#include <postgres.h>
+#include <lib/binaryheap.h>
+#include <nodes/execnodes.h>
+#include <nodes/extensible.h>
+#include <nodes/relation.h>
+#include <utils/hsearch.h>
+#include <utils/sortsupport.h>
+
+typedef struct AsofJoinInput AsofJoinInput;
+typedef struct AsofJoinKey AsofJoinKey;
+
+/* The inputs of one side of an ASOF join, merged in time order */
+typedef struct AsofJoinSide
+{
+	int			ninputs;
+	AsofJoinInput *inputs;
+	binaryheap *heap;			/* inputs by the time of their current tuple */
+	AttrNumber	time_attno;		/* time column in the tuples of the inputs */
+	SortSupport time_sort;
+	bool		started;
+} AsofJoinSide;
+
+typedef struct AsofJoinState
+{
+	CustomScanState csstate;
+	AsofJoinSide probe;			/* the side whose rows are joined */
+	AsofJoinSide build;			/* the side whose latest rows are looked up */
+	int			probe_ncolumns;
+	bool		probe_returned; /* the current probe tuple was joined */
+	bool		left_join;
+	int			nkeys;
+	AsofJoinKey *keys;
+	Datum	   *key_values;		/* key of the current tuple */
+	SortSupportData time_sort;
+	Oid			time_sortop;
+	Oid			time_collation;
+	HTAB	   *matches;		/* latest build tuple per key */
+	MemoryContext match_context;
+	TupleTableSlot *match_slot;
+} AsofJoinState;
+
+extern void plan_add_asof_join(PlannerInfo *root, RelOptInfo *joinrel, RelOptInfo *outerrel,
+				   RelOptInfo *innerrel, JoinType jointype, JoinPathExtraData *extra);
+
+#endif							/* TIMESCALEDB_ASOF_JOIN_H */
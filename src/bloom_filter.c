@@ -0,0 +1,1066 @@
+#include <postgres.h>
+#include <access/hash.h>
+#include <access/heapam.h>
+#include <access/htup_details.h>
+#include <access/stratnum.h>
+#include <access/xact.h>
+#include <catalog/dependency.h>
+#include <catalog/objectaddress.h>
+#include <catalog/pg_inherits_fn.h>
+#include <catalog/pg_trigger.h>
+#include <commands/trigger.h>
+#include <miscadmin.h>
+#include <nodes/makefuncs.h>
+#include <nodes/relation.h>
+#include <storage/lmgr.h>
+#include <utils/builtins.h>
+#include <utils/fmgroids.h>
+#include <utils/lsyscache.h>
+#include <utils/rel.h>
+#include <utils/snapmgr.h>
+#include <utils/typcache.h>
+#include <math.h>
+
+#include "bloom_filter.h"
+#include "catalog.h"
+#include "chunk.h"
+#include "compressed_chunk.h"
+#include "dimension.h"
+#include "errors.h"
+#include "hypertable.h"
+#include "hypertable_cache.h"
+#include "scanner.h"
+#include "utils.h"
+#include "compat.h"
+
+/*
+ * Bloom filters.
+ *
+ * A bloom filter keeps, for every chunk of a hypertable, a bit array in the
+ * chunk_bloom_filter catalog table into which the hashes of all values of a
+ * column in the chunk are set. A value whose bits are not all set is
+ * certainly not in the chunk, so ConstraintAwareAppend can exclude the chunk
+ * for an equality restriction on the value.
+ *
+ * Filters are built from a chunk's rows and sized for the number of values
+ * in the chunk, so they are meant to be built once a chunk no longer
+ * receives writes. A row trigger on every chunk with filters removes the
+ * filters on the first write to the chunk. A chunk without filters is never
+ * excluded.
+ *
+ * Values are hashed with the hash function of the column type's default hash
+ * operator class, and the bits of a value are derived from that hash with
+ * double hashing. Hash functions of the same operator family are compatible
+ * across types, so a restriction can compare the column with a constant of
+ * another type in the family.
+ */
+
+#define BLOOM_FILTER_MIN_BYTES 8
+#define BLOOM_FILTER_MAX_BYTES (64 * 1024 * 1024)
+#define BLOOM_FILTER_MAX_HASHES 16
+
+typedef struct BloomRestrictInfo
+{
+	int32		bloom_filter_id;
+	uint32		hash;			/* hash of the value the column must equal */
+} BloomRestrictInfo;
+
+/*
+ * Size a filter for the given number of values so that a value not in the
+ * filter tests positive with the given probability.
+ */
+static void
+bloom_filter_size(int64 num_values, double false_positive_rate, int32 *nbytes, int32 *num_hashes)
+{
+	double		nbits = ceil(-((double) num_values) * log(false_positive_rate) / (log(2.0) * log(2.0)));
+	double		bytes = ceil(nbits / 8.0);
+
+	if (bytes < BLOOM_FILTER_MIN_BYTES)
+		bytes = BLOOM_FILTER_MIN_BYTES;
+	else if (bytes > BLOOM_FILTER_MAX_BYTES)
+		bytes = BLOOM_FILTER_MAX_BYTES;
+
+	*nbytes = (int32) bytes;
+
+	if (num_values == 0)
+		*num_hashes = 1;
+	else
+	{
+		double		k = rint(bytes * 8.0 / num_values * log(2.0));
+
+		*num_hashes = (int32) Max(1.0, Min(k, (double) BLOOM_FILTER_MAX_HASHES));
+	}
+}
+
+static inline uint64
+bloom_filter_bit(uint32 hash, int i, uint64 nbits)
+{
+	uint32		hash2 = DatumGetUInt32(hash_uint32(hash)) | 1;
+
+	return ((uint64) hash + (uint64) i * hash2) % nbits;
+}
+
+static void
+bloom_filter_add_hash(bytea *filter, int32 num_hashes, uint32 hash)
+{
+	uint8	   *bits = (uint8 *) VARDATA(filter);
+	uint64		nbits = (uint64) (VARSIZE(filter) - VARHDRSZ) * 8;
+	int			i;
+
+	for (i = 0; i < num_hashes; i++)
+	{
+		uint64		bit = bloom_filter_bit(hash, i, nbits);
+
+		bits[bit >> 3] |= 1 << (bit & 7);
+	}
+}
+
+static bool
+bloom_filter_contains_hash(bytea *filter, int32 num_hashes, uint32 hash)
+{
+	uint8	   *bits = (uint8 *) VARDATA_ANY(filter);
+	uint64		nbits = (uint64) VARSIZE_ANY_EXHDR(filter) * 8;
+	int			i;
+
+	for (i = 0; i < num_hashes; i++)
+	{
+		uint64		bit = bloom_filter_bit(hash, i, nbits);
+
+		if ((bits[bit >> 3] & (1 << (bit & 7))) == 0)
+			return false;
+	}
+
+	return true;
+}
+
+/*
+ * Bloom filter catalog.
+ */
+
+static BloomFilter *
+bloom_filter_from_tuple(HeapTuple tuple, Oid main_table_relid)
+{
+	BloomFilter *filter = palloc0(sizeof(BloomFilter));
+
+	memcpy(&filter->fd, GETSTRUCT(tuple), sizeof(FormData_bloom_filter));
+
+	if (OidIsValid(main_table_relid))
+	{
+		filter->column_attno = get_attnum(main_table_relid, NameStr(filter->fd.column_name));
+		filter->column_type = get_atttype(main_table_relid, filter->column_attno);
+	}
+
+	return filter;
+}
+
+typedef struct BloomFilterScanData
+{
+	Oid			main_table_relid;
+	List	   *filters;
+} BloomFilterScanData;
+
+static bool
+bloom_filter_tuple_found(TupleInfo *ti, void *data)
+{
+	BloomFilterScanData *scandata = data;
+
+	scandata->filters = lappend(scandata->filters,
+								bloom_filter_from_tuple(ti->tuple, scandata->main_table_relid));
+
+	return true;
+}
+
+static bool
+bloom_filter_tuple_delete(TupleInfo *ti, void *data)
+{
+	CatalogSecurityContext sec_ctx;
+
+	catalog_become_owner(catalog_get(), &sec_ctx);
+	catalog_delete(ti->scanrel, ti->tuple);
+	catalog_restore_user(&sec_ctx);
+
+	return true;
+}
+
+static int
+bloom_filter_scan(ScanKeyData *scankey,
+				  int nkeys,
+				  int indexid,
+				  tuple_found_func tuple_found,
+				  void *data,
+				  LOCKMODE lockmode)
+{
+	Catalog    *catalog = catalog_get();
+	ScannerCtx	scanctx = {
+		.table = catalog->tables[BLOOM_FILTER].id,
+		.index = CATALOG_INDEX(catalog, BLOOM_FILTER, indexid),
+		.nkeys = nkeys,
+		.scankey = scankey,
+		.tuple_found = tuple_found,
+		.data = data,
+		.lockmode = lockmode,
+		.scandirection = ForwardScanDirection,
+	};
+
+	return scanner_scan(&scanctx);
+}
+
+static int
+bloom_filter_scan_by_hypertable_id_internal(int32 hypertable_id,
+											tuple_found_func tuple_found,
+											void *data,
+											LOCKMODE lockmode)
+{
+	ScanKeyData scankey[1];
+
+	ScanKeyInit(&scankey[0], Anum_bloom_filter_hypertable_id_column_name_idx_hypertable_id,
+				BTEqualStrategyNumber, F_INT4EQ, Int32GetDatum(hypertable_id));
+
+	return bloom_filter_scan(scankey, 1, BLOOM_FILTER_HYPERTABLE_ID_COLUMN_NAME_IDX,
+							 tuple_found, data, lockmode);
+}
+
+List *
+bloom_filter_scan_by_hypertable_id(int32 hypertable_id, Oid main_table_relid)
+{
+	BloomFilterScanData scandata = {
+		.main_table_relid = main_table_relid,
+		.filters = NIL,
+	};
+
+	bloom_filter_scan_by_hypertable_id_internal(hypertable_id, bloom_filter_tuple_found,
+												&scandata, AccessShareLock);
+
+	return scandata.filters;
+}
+
+BloomFilter *
+bloom_filter_get_by_column_name(List *filters, const char *column_name)
+{
+	ListCell   *lc;
+
+	foreach(lc, filters)
+	{
+		BloomFilter *filter = lfirst(lc);
+
+		if (namestrcmp(&filter->fd.column_name, column_name) == 0)
+			return filter;
+	}
+
+	return NULL;
+}
+
+static BloomFilter *
+bloom_filter_get_by_attno(List *filters, AttrNumber attno)
+{
+	ListCell   *lc;
+
+	foreach(lc, filters)
+	{
+		BloomFilter *filter = lfirst(lc);
+
+		if (filter->column_attno == attno)
+			return filter;
+	}
+
+	return NULL;
+}
+
+static void
+bloom_filter_insert(int32 hypertable_id, Name column_name, double false_positive_rate)
+{
+	Catalog    *catalog = catalog_get();
+	Relation	rel;
+	Datum		values[Natts_bloom_filter];
+	bool		nulls[Natts_bloom_filter] = {false};
+	CatalogSecurityContext sec_ctx;
+
+	rel = heap_open(catalog->tables[BLOOM_FILTER].id, RowExclusiveLock);
+
+	catalog_become_owner(catalog, &sec_ctx);
+	values[Anum_bloom_filter_id - 1] = Int32GetDatum(catalog_table_next_seq_id(catalog, BLOOM_FILTER));
+	values[Anum_bloom_filter_hypertable_id - 1] = Int32GetDatum(hypertable_id);
+	values[Anum_bloom_filter_column_name - 1] = NameGetDatum(column_name);
+	values[Anum_bloom_filter_false_positive_rate - 1] = Float8GetDatum(false_positive_rate);
+	catalog_insert_values(rel, RelationGetDescr(rel), values, nulls);
+	catalog_restore_user(&sec_ctx);
+
+	heap_close(rel, RowExclusiveLock);
+}
+
+static bool
+bloom_filter_tuple_set_column_name(TupleInfo *ti, void *data)
+{
+	const char *newname = data;
+	HeapTuple	tuple = heap_copytuple(ti->tuple);
+	FormData_bloom_filter *form = (FormData_bloom_filter *) GETSTRUCT(tuple);
+	CatalogSecurityContext sec_ctx;
+
+	namestrcpy(&form->column_name, newname);
+	catalog_become_owner(catalog_get(), &sec_ctx);
+	catalog_update(ti->scanrel, tuple);
+	catalog_restore_user(&sec_ctx);
+	heap_freetuple(tuple);
+
+	return false;
+}
+
+int
+bloom_filter_set_column_name(BloomFilter *filter, const char *newname)
+{
+	ScanKeyData scankey[1];
+
+	ScanKeyInit(&scankey[0], Anum_bloom_filter_pkey_idx_id,
+				BTEqualStrategyNumber, F_INT4EQ, Int32GetDatum(filter->fd.id));
+
+	return bloom_filter_scan(scankey, 1, BLOOM_FILTER_PKEY_IDX,
+							 bloom_filter_tuple_set_column_name,
+							 (void *) newname, RowExclusiveLock);
+}
+
+/*
+ * Chunk bloom filter catalog.
+ */
+
+static int
+chunk_bloom_filter_scan(ScanKeyData *scankey,
+						int nkeys,
+						bool use_index,
+						tuple_found_func tuple_found,
+						void *data,
+						LOCKMODE lockmode,
+						bool tuplock,
+						Snapshot snapshot)
+{
+	Catalog    *catalog = catalog_get();
+	ScannerCtx	scanctx = {
+		.table = catalog->tables[CHUNK_BLOOM_FILTER].id,
+		.index = use_index ? CATALOG_INDEX(catalog, CHUNK_BLOOM_FILTER, CHUNK_BLOOM_FILTER_PKEY_IDX) : InvalidOid,
+		.nkeys = nkeys,
+		.scankey = scankey,
+		.tuple_found = tuple_found,
+		.data = data,
+		.lockmode = lockmode,
+		.tuplock = {
+			.lockmode = LockTupleExclusive,
+			.waitpolicy = LockWaitBlock,
+			.enabled = tuplock,
+		},
+		.scandirection = ForwardScanDirection,
+		.snapshot = snapshot,
+	};
+
+	return scanner_scan(&scanctx);
+}
+
+static bool
+chunk_bloom_filter_tuple_delete(TupleInfo *ti, void *data)
+{
+	CatalogSecurityContext sec_ctx;
+
+	/*
+	 * When locking, skip filters that a concurrent transaction already
+	 * removed
+	 */
+	if (NULL != data && ti->lockresult != HeapTupleMayBeUpdated)
+		return true;
+
+	catalog_become_owner(catalog_get(), &sec_ctx);
+	catalog_delete(ti->scanrel, ti->tuple);
+	catalog_restore_user(&sec_ctx);
+
+	return true;
+}
+
+int
+chunk_bloom_filter_delete_by_chunk_id(int32 chunk_id)
+{
+	ScanKeyData scankey[1];
+
+	ScanKeyInit(&scankey[0], Anum_chunk_bloom_filter_pkey_idx_chunk_id,
+				BTEqualStrategyNumber, F_INT4EQ, Int32GetDatum(chunk_id));
+
+	return chunk_bloom_filter_scan(scankey, 1, true, chunk_bloom_filter_tuple_delete,
+								   NULL, RowExclusiveLock, false, NULL);
+}
+
+/*
+ * Remove the filters of a chunk that is being written to. The filters are
+ * locked first, so that concurrent writers to the chunk do not fail trying to
+ * delete the same filters.
+ */
+static int
+chunk_bloom_filter_invalidate(int32 chunk_id)
+{
+	ScanKeyData scankey[1];
+	bool		locked = true;
+
+	ScanKeyInit(&scankey[0], Anum_chunk_bloom_filter_pkey_idx_chunk_id,
+				BTEqualStrategyNumber, F_INT4EQ, Int32GetDatum(chunk_id));
+
+	return chunk_bloom_filter_scan(scankey, 1, true, chunk_bloom_filter_tuple_delete,
+								   &locked, RowExclusiveLock, true, NULL);
+}
+
+static int
+chunk_bloom_filter_delete_by_bloom_filter_id(int32 bloom_filter_id)
+{
+	ScanKeyData scankey[1];
+
+	/* Not the leading column of the primary key, so do a heap scan */
+	ScanKeyInit(&scankey[0], Anum_chunk_bloom_filter_bloom_filter_id,
+				BTEqualStrategyNumber, F_INT4EQ, Int32GetDatum(bloom_filter_id));
+
+	return chunk_bloom_filter_scan(scankey, 1, false, chunk_bloom_filter_tuple_delete,
+								   NULL, RowExclusiveLock, false, NULL);
+}
+
+static void
+chunk_bloom_filter_insert_relation(Relation rel, int32 chunk_id, int32 bloom_filter_id,
+								   int32 num_hashes, bytea *filter)
+{
+	Datum		values[Natts_chunk_bloom_filter];
+	bool		nulls[Natts_chunk_bloom_filter] = {false};
+	CatalogSecurityContext sec_ctx;
+
+	values[Anum_chunk_bloom_filter_chunk_id - 1] = Int32GetDatum(chunk_id);
+	values[Anum_chunk_bloom_filter_bloom_filter_id - 1] = Int32GetDatum(bloom_filter_id);
+	values[Anum_chunk_bloom_filter_num_hashes - 1] = Int32GetDatum(num_hashes);
+	values[Anum_chunk_bloom_filter_filter - 1] = PointerGetDatum(filter);
+
+	catalog_become_owner(catalog_get(), &sec_ctx);
+	catalog_insert_values(rel, RelationGetDescr(rel), values, nulls);
+	catalog_restore_user(&sec_ctx);
+}
+
+typedef struct ChunkBloomFilterProbe
+{
+	uint32		hash;
+	bool		contains;
+} ChunkBloomFilterProbe;
+
+static bool
+chunk_bloom_filter_tuple_probe(TupleInfo *ti, void *data)
+{
+	ChunkBloomFilterProbe *probe = data;
+	bool		isnull;
+	Datum		num_hashes = heap_getattr(ti->tuple, Anum_chunk_bloom_filter_num_hashes, ti->desc, &isnull);
+	Datum		filter = heap_getattr(ti->tuple, Anum_chunk_bloom_filter_filter, ti->desc, &isnull);
+
+	probe->contains = bloom_filter_contains_hash(DatumGetByteaPP(filter),
+												 DatumGetInt32(num_hashes),
+												 probe->hash);
+
+	return false;
+}
+
+/*
+ * Check if a chunk's filter might contain a value. Chunks without a filter
+ * might contain any value.
+ */
+static bool
+chunk_bloom_filter_contains(int32 chunk_id, int32 bloom_filter_id, uint32 hash, Snapshot snapshot)
+{
+	ScanKeyData scankey[2];
+	ChunkBloomFilterProbe probe = {
+		.hash = hash,
+		.contains = true,
+	};
+
+	ScanKeyInit(&scankey[0], Anum_chunk_bloom_filter_pkey_idx_chunk_id,
+				BTEqualStrategyNumber, F_INT4EQ, Int32GetDatum(chunk_id));
+	ScanKeyInit(&scankey[1], Anum_chunk_bloom_filter_pkey_idx_bloom_filter_id,
+				BTEqualStrategyNumber, F_INT4EQ, Int32GetDatum(bloom_filter_id));
+
+	chunk_bloom_filter_scan(scankey, 2, true, chunk_bloom_filter_tuple_probe,
+							&probe, AccessShareLock, false, snapshot);
+
+	return probe.contains;
+}
+
+/*
+ * Building filters.
+ */
+
+typedef struct ChunkBloomFilterColumn
+{
+	int32		bloom_filter_id;
+	double		false_positive_rate;
+	AttrNumber	attno;			/* attribute number in the chunk */
+	FmgrInfo   *hash_finfo;
+	Oid			collation;
+	int64		num_values;
+	int32		num_hashes;
+	bytea	   *filter;
+} ChunkBloomFilterColumn;
+
+/*
+ * Scan the chunk, counting the values of every column or, once the filters
+ * are allocated, adding the values to the filters.
+ */
+static void
+chunk_bloom_filter_scan_rows(Relation rel, Snapshot snapshot,
+							 ChunkBloomFilterColumn *columns, int num_columns, bool count)
+{
+	TupleDesc	tupdesc = RelationGetDescr(rel);
+	HeapScanDesc scan = heap_beginscan(rel, snapshot, 0, NULL);
+	HeapTuple	tuple;
+
+	while ((tuple = heap_getnext(scan, ForwardScanDirection)) != NULL)
+	{
+		int			i;
+
+		for (i = 0; i < num_columns; i++)
+		{
+			ChunkBloomFilterColumn *column = &columns[i];
+			bool		isnull;
+			Datum		value = heap_getattr(tuple, column->attno, tupdesc, &isnull);
+
+			if (isnull)
+				continue;
+
+			if (count)
+				column->num_values++;
+			else
+				bloom_filter_add_hash(column->filter, column->num_hashes,
+									  DatumGetUInt32(FunctionCall1Coll(column->hash_finfo,
+																	   column->collation,
+																	   value)));
+		}
+	}
+
+	heap_endscan(scan);
+}
+
+static void
+bloom_filter_invalidate_trigger_create(Oid chunk_relid)
+{
+	CreateTrigStmt stmt = {
+		.type = T_CreateTrigStmt,
+		.trigname = BLOOM_FILTER_INVALIDATE_TRIGGER_NAME,
+		.relation = makeRangeVarFromRelid(chunk_relid),
+		.funcname = list_make2(makeString(INTERNAL_SCHEMA_NAME), makeString("bloom_filter_invalidate_trigger")),
+		.args = NIL,
+		.row = true,
+		.timing = TRIGGER_TYPE_AFTER,
+		.events = TRIGGER_TYPE_INSERT | TRIGGER_TYPE_UPDATE,
+		.columns = NIL,
+		.whenClause = NULL,
+		.isconstraint = false,
+	};
+
+	if (OidIsValid(get_trigger_oid(chunk_relid, BLOOM_FILTER_INVALIDATE_TRIGGER_NAME, true)))
+		return;
+
+	CreateTrigger(&stmt, NULL, InvalidOid, InvalidOid,
+				  InvalidOid, InvalidOid, false);
+	CommandCounterIncrement();
+}
+
+static void
+bloom_filter_invalidate_trigger_drop(Hypertable *ht)
+{
+	List	   *children = find_inheritance_children(ht->main_table_relid, NoLock);
+	ListCell   *lc;
+
+	foreach(lc, children)
+	{
+		ObjectAddress address = {
+			.classId = TriggerRelationId,
+			.objectId = get_trigger_oid(lfirst_oid(lc), BLOOM_FILTER_INVALIDATE_TRIGGER_NAME, true),
+		};
+
+		if (OidIsValid(address.objectId))
+			performDeletion(&address, DROP_RESTRICT, 0);
+	}
+}
+
+/*
+ * Build the filters of a chunk from its rows, replacing any existing filters.
+ *
+ * Writes to the chunk are blocked while the filters are built, so the
+ * filters cover all rows once built, and any later write fires the trigger
+ * that removes them again.
+ */
+static void
+chunk_bloom_filter_build(Chunk *chunk, List *filters)
+{
+	Catalog    *catalog = catalog_get();
+	ChunkBloomFilterColumn *columns;
+	int			num_columns = 0;
+	Relation	rel;
+	Relation	catalog_rel;
+	Snapshot	snapshot;
+	ListCell   *lc;
+	int			i;
+
+	if (filters == NIL)
+		return;
+
+	LockRelationOid(chunk->table_id, ShareRowExclusiveLock);
+
+	columns = palloc0(sizeof(ChunkBloomFilterColumn) * list_length(filters));
+
+	foreach(lc, filters)
+	{
+		BloomFilter *filter = lfirst(lc);
+		ChunkBloomFilterColumn *column = &columns[num_columns];
+		AttrNumber	attno = get_attnum(chunk->table_id, NameStr(filter->fd.column_name));
+		Oid			typid;
+		int32		typmod;
+		TypeCacheEntry *tce;
+
+		if (!AttributeNumberIsValid(attno))
+			continue;
+
+		get_atttypetypmodcoll(chunk->table_id, attno, &typid, &typmod, &column->collation);
+		tce = lookup_type_cache(typid, TYPECACHE_HASH_PROC_FINFO);
+
+		if (!OidIsValid(tce->hash_proc))
+			continue;
+
+		column->bloom_filter_id = filter->fd.id;
+		column->false_positive_rate = filter->fd.false_positive_rate;
+		column->attno = attno;
+		column->hash_finfo = &tce->hash_proc_finfo;
+		num_columns++;
+	}
+
+	rel = heap_open(chunk->table_id, NoLock);
+	snapshot = RegisterSnapshot(GetLatestSnapshot());
+
+	chunk_bloom_filter_scan_rows(rel, snapshot, columns, num_columns, true);
+
+	for (i = 0; i < num_columns; i++)
+	{
+		ChunkBloomFilterColumn *column = &columns[i];
+		int32		nbytes;
+
+		bloom_filter_size(column->num_values, column->false_positive_rate,
+						  &nbytes, &column->num_hashes);
+		column->filter = palloc0(VARHDRSZ + nbytes);
+		SET_VARSIZE(column->filter, VARHDRSZ + nbytes);
+	}
+
+	chunk_bloom_filter_scan_rows(rel, snapshot, columns, num_columns, false);
+
+	UnregisterSnapshot(snapshot);
+	heap_close(rel, NoLock);
+
+	chunk_bloom_filter_delete_by_chunk_id(chunk->fd.id);
+
+	catalog_rel = heap_open(catalog->tables[CHUNK_BLOOM_FILTER].id, RowExclusiveLock);
+
+	for (i = 0; i < num_columns; i++)
+		chunk_bloom_filter_insert_relation(catalog_rel, chunk->fd.id, columns[i].bloom_filter_id,
+										   columns[i].num_hashes, columns[i].filter);
+
+	heap_close(catalog_rel, RowExclusiveLock);
+
+	bloom_filter_invalidate_trigger_create(chunk->table_id);
+}
+
+/*
+ * Row trigger that removes the filters of a chunk when rows are inserted
+ * into or updated in the chunk. Only the first row of a statement touches
+ * the catalog.
+ */
+TS_FUNCTION_INFO_V1(bloom_filter_invalidate_trigger);
+
+Datum
+bloom_filter_invalidate_trigger(PG_FUNCTION_ARGS)
+{
+	TriggerData *trigdata = (TriggerData *) fcinfo->context;
+	Oid			relid;
+
+	if (!CALLED_AS_TRIGGER(fcinfo))
+		elog(ERROR, "bloom_filter_invalidate_trigger: not called by trigger manager");
+
+	if (!TRIGGER_FIRED_AFTER(trigdata->tg_event) || !TRIGGER_FIRED_FOR_ROW(trigdata->tg_event))
+		elog(ERROR, "bloom_filter_invalidate_trigger: must be fired AFTER ROW");
+
+	relid = RelationGetRelid(trigdata->tg_relation);
+
+	if (NULL == fcinfo->flinfo->fn_extra ||
+		*((Oid *) fcinfo->flinfo->fn_extra) != relid)
+	{
+		Chunk	   *chunk = chunk_get_by_relid(relid, 0, false);
+
+		if (NULL != chunk)
+			chunk_bloom_filter_invalidate(chunk->fd.id);
+
+		fcinfo->flinfo->fn_extra = MemoryContextAlloc(fcinfo->flinfo->fn_mcxt, sizeof(Oid));
+		*((Oid *) fcinfo->flinfo->fn_extra) = relid;
+	}
+
+	return PointerGetDatum(NULL);
+}
+
+/*
+ * Adding and removing bloom filters.
+ */
+
+static Hypertable *
+bloom_filter_get_hypertable(Cache *hcache, Oid table_relid)
+{
+	Hypertable *ht;
+
+	if (!OidIsValid(table_relid))
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("invalid main_table")));
+
+	hypertable_permissions_check(table_relid, GetUserId());
+
+	/*
+	 * Block writes to the hypertable while the filters of existing chunks are
+	 * built. This is also the lock needed to create and drop triggers.
+	 */
+	LockRelationOid(table_relid, ShareRowExclusiveLock);
+
+	ht = hypertable_cache_get_entry(hcache, table_relid);
+
+	if (NULL == ht)
+		ereport(ERROR,
+				(errcode(ERRCODE_IO_HYPERTABLE_NOT_EXIST),
+				 errmsg("table \"%s\" is not a hypertable",
+						get_rel_name(table_relid))));
+
+	return ht;
+}
+
+/*
+ * Remove a bloom filter and its chunk filters. The invalidation triggers are
+ * dropped along with the last bloom filter of the hypertable.
+ */
+void
+bloom_filter_drop(Hypertable *ht, BloomFilter *filter)
+{
+	ScanKeyData scankey[1];
+
+	chunk_bloom_filter_delete_by_bloom_filter_id(filter->fd.id);
+
+	ScanKeyInit(&scankey[0], Anum_bloom_filter_pkey_idx_id,
+				BTEqualStrategyNumber, F_INT4EQ, Int32GetDatum(filter->fd.id));
+	bloom_filter_scan(scankey, 1, BLOOM_FILTER_PKEY_IDX,
+					  bloom_filter_tuple_delete, NULL, RowExclusiveLock);
+
+	if (bloom_filter_scan_by_hypertable_id_internal(ht->fd.id, NULL, NULL, AccessShareLock) == 0)
+		bloom_filter_invalidate_trigger_drop(ht);
+}
+
+int
+bloom_filter_delete_by_hypertable_id(int32 hypertable_id)
+{
+	List	   *filters = bloom_filter_scan_by_hypertable_id(hypertable_id, InvalidOid);
+	ListCell   *lc;
+
+	foreach(lc, filters)
+		chunk_bloom_filter_delete_by_bloom_filter_id(((BloomFilter *) lfirst(lc))->fd.id);
+
+	return bloom_filter_scan_by_hypertable_id_internal(hypertable_id, bloom_filter_tuple_delete,
+													   NULL, RowExclusiveLock);
+}
+
+TS_FUNCTION_INFO_V1(bloom_filter_add);
+
+/*
+ * Add a bloom filter on a column of a hypertable and build the filters of
+ * the existing chunks.
+ *
+ * Arguments:
+ * 0. Relation ID of the hypertable
+ * 1. Column name
+ * 2. False positive rate
+ * 3. IF NOT EXISTS option (bool)
+ */
+Datum
+bloom_filter_add(PG_FUNCTION_ARGS)
+{
+	Oid			table_relid = PG_ARGISNULL(0) ? InvalidOid : PG_GETARG_OID(0);
+	Name		column_name = PG_ARGISNULL(1) ? NULL : PG_GETARG_NAME(1);
+	double		false_positive_rate = PG_ARGISNULL(2) ? 0 : PG_GETARG_FLOAT8(2);
+	bool		if_not_exists = PG_ARGISNULL(3) ? false : PG_GETARG_BOOL(3);
+	Cache	   *hcache = hypertable_cache_pin();
+	Hypertable *ht = bloom_filter_get_hypertable(hcache, table_relid);
+	AttrNumber	attno;
+	Oid			column_type;
+	List	   *filters;
+	List	   *children;
+	ListCell   *lc;
+
+	if (NULL == column_name)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("invalid column name")));
+
+	if (!(false_positive_rate > 0 && false_positive_rate < 1))
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("false positive rate must be greater than 0 and less than 1")));
+
+	attno = get_attnum(table_relid, NameStr(*column_name));
+
+	if (!AttributeNumberIsValid(attno))
+		ereport(ERROR,
+				(errcode(ERRCODE_UNDEFINED_COLUMN),
+				 errmsg("column \"%s\" does not exist", NameStr(*column_name))));
+
+	column_type = get_atttype(table_relid, attno);
+
+	if (!OidIsValid(lookup_type_cache(column_type, TYPECACHE_HASH_PROC)->hash_proc))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("cannot add a bloom filter on column \"%s\" of type %s",
+						NameStr(*column_name), format_type_be(column_type)),
+				 errhint("Bloom filters need a type with a default hash operator class.")));
+
+	if (NULL != hyperspace_get_dimension_by_name(ht->space, DIMENSION_TYPE_ANY, NameStr(*column_name)))
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("cannot add a bloom filter on partitioning column \"%s\"",
+						NameStr(*column_name))));
+
+	if (NULL != bloom_filter_get_by_column_name(ht->bloom_filters, NameStr(*column_name)))
+	{
+		if (!if_not_exists)
+			ereport(ERROR,
+					(errcode(ERRCODE_DUPLICATE_OBJECT),
+					 errmsg("bloom filter on column \"%s\" already exists",
+							NameStr(*column_name))));
+
+		ereport(NOTICE,
+				(errmsg("bloom filter on column \"%s\" already exists, skipping",
+						NameStr(*column_name))));
+		cache_release(hcache);
+		PG_RETURN_VOID();
+	}
+
+	bloom_filter_insert(ht->fd.id, column_name, false_positive_rate);
+
+	/*
+	 * Rebuild the filters of existing chunks, including those of other
+	 * columns that writes might have removed. Compressed chunks have no rows
+	 * in their tables, so they are left without filters.
+	 */
+	filters = bloom_filter_scan_by_hypertable_id(ht->fd.id, ht->main_table_relid);
+	children = find_inheritance_children(ht->main_table_relid, NoLock);
+
+	foreach(lc, children)
+	{
+		Chunk	   *chunk = chunk_get_by_relid(lfirst_oid(lc), 0, false);
+
+		if (NULL == chunk || NULL != compressed_chunk_get_by_chunk_id(chunk->fd.id))
+			continue;
+
+		chunk_bloom_filter_build(chunk, filters);
+	}
+
+	cache_release(hcache);
+
+	PG_RETURN_VOID();
+}
+
+TS_FUNCTION_INFO_V1(bloom_filter_remove);
+
+/*
+ * Remove a bloom filter from a hypertable.
+ *
+ * Arguments:
+ * 0. Relation ID of the hypertable
+ * 1. Column name
+ * 2. IF EXISTS option (bool)
+ */
+Datum
+bloom_filter_remove(PG_FUNCTION_ARGS)
+{
+	Oid			table_relid = PG_ARGISNULL(0) ? InvalidOid : PG_GETARG_OID(0);
+	Name		column_name = PG_ARGISNULL(1) ? NULL : PG_GETARG_NAME(1);
+	bool		if_exists = PG_ARGISNULL(2) ? false : PG_GETARG_BOOL(2);
+	Cache	   *hcache = hypertable_cache_pin();
+	Hypertable *ht = bloom_filter_get_hypertable(hcache, table_relid);
+	BloomFilter *filter;
+
+	if (NULL == column_name)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("invalid column name")));
+
+	filter = bloom_filter_get_by_column_name(ht->bloom_filters, NameStr(*column_name));
+
+	if (NULL == filter)
+	{
+		if (!if_exists)
+			ereport(ERROR,
+					(errcode(ERRCODE_UNDEFINED_OBJECT),
+					 errmsg("bloom filter on column \"%s\" does not exist",
+							NameStr(*column_name))));
+
+		ereport(NOTICE,
+				(errmsg("bloom filter on column \"%s\" does not exist, skipping",
+						NameStr(*column_name))));
+	}
+	else
+		bloom_filter_drop(ht, filter);
+
+	cache_release(hcache);
+
+	PG_RETURN_VOID();
+}
+
+TS_FUNCTION_INFO_V1(bloom_filter_build_chunk);
+
+/*
+ * Build the bloom filters of a chunk.
+ *
+ * Arguments:
+ * 0. Relation ID of the chunk
+ */
+Datum
+bloom_filter_build_chunk(PG_FUNCTION_ARGS)
+{
+	Oid			chunk_relid = PG_ARGISNULL(0) ? InvalidOid : PG_GETARG_OID(0);
+	Chunk	   *chunk;
+	Cache	   *hcache;
+	Hypertable *ht;
+
+	if (!OidIsValid(chunk_relid))
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("invalid chunk")));
+
+	chunk = chunk_get_by_relid(chunk_relid, 0, false);
+
+	if (NULL == chunk)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("\"%s\" is not a chunk", get_rel_name(chunk_relid))));
+
+	hcache = hypertable_cache_pin();
+	ht = hypertable_cache_get_entry_by_id(hcache, chunk->fd.hypertable_id);
+
+	hypertable_permissions_check(ht->main_table_relid, GetUserId());
+
+	if (NULL != compressed_chunk_get_by_chunk_id(chunk->fd.id))
+		ereport(ERROR,
+				(errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
+				 errmsg("cannot build bloom filters for compressed chunk \"%s\"",
+						get_rel_name(chunk_relid))));
+
+	chunk_bloom_filter_build(chunk, ht->bloom_filters);
+	cache_release(hcache);
+
+	PG_RETURN_VOID();
+}
+
+/*
+ * Chunk exclusion.
+ */
+
+static void
+bloom_restrict_info_add_opexpr(List **restrictions, Hypertable *ht, Index rti, OpExpr *op)
+{
+	Node	   *left,
+			   *right;
+	Var		   *var;
+	Const	   *c;
+	BloomFilter *filter;
+	TypeCacheEntry *tce;
+	Oid			hash_proc;
+	BloomRestrictInfo *bri;
+
+	if (list_length(op->args) != 2)
+		return;
+
+	left = linitial(op->args);
+	right = lsecond(op->args);
+
+	if (IsA(left, Var) && IsA(right, Const))
+	{
+		var = (Var *) left;
+		c = (Const *) right;
+	}
+	else if (IsA(right, Var) && IsA(left, Const))
+	{
+		var = (Var *) right;
+		c = (Const *) left;
+	}
+	else
+		return;
+
+	if (var->varno != rti || var->varlevelsup != 0 || c->constisnull)
+		return;
+
+	filter = bloom_filter_get_by_attno(ht->bloom_filters, var->varattno);
+
+	if (NULL == filter)
+		return;
+
+	/*
+	 * The operator must be the equality of the hash operator family that the
+	 * filter's hash function belongs to, so that equal values of the
+	 * constant's type hash to the same value
+	 */
+	tce = lookup_type_cache(var->vartype, TYPECACHE_HASH_OPFAMILY);
+
+	if (!OidIsValid(tce->hash_opf) ||
+		get_op_opfamily_strategy(op->opno, tce->hash_opf) != HTEqualStrategyNumber)
+		return;
+
+	hash_proc = get_opfamily_proc(tce->hash_opf, c->consttype, c->consttype, HASHPROC);
+
+	if (!OidIsValid(hash_proc))
+		return;
+
+	bri = palloc(sizeof(BloomRestrictInfo));
+	bri->bloom_filter_id = filter->fd.id;
+	bri->hash = DatumGetUInt32(OidFunctionCall1Coll(hash_proc, op->inputcollid, c->constvalue));
+	*restrictions = lappend(*restrictions, bri);
+}
+
+/*
+ * Get the equality restrictions on columns with bloom filters from a list of
+ * restriction clauses. Only clauses of the form "column = constant" are used.
+ */
+List *
+bloom_restrict_info_create(Hypertable *ht, Index rti, List *restrictinfos)
+{
+	List	   *restrictions = NIL;
+	ListCell   *lc;
+
+	if (ht->bloom_filters == NIL)
+		return NIL;
+
+	foreach(lc, restrictinfos)
+	{
+		RestrictInfo *rinfo = lfirst(lc);
+
+		if (IsA(rinfo->clause, OpExpr))
+			bloom_restrict_info_add_opexpr(&restrictions, ht, rti, (OpExpr *) rinfo->clause);
+	}
+
+	return restrictions;
+}
+
+/*
+ * Check if a chunk might contain the values of the given restrictions. The
+ * filters are read with the query's snapshot, like min/max ranges.
+ */
+bool
+chunk_bloom_filter_matches(int32 chunk_id, List *restrictions, Snapshot snapshot)
+{
+	ListCell   *lc;
+
+	if (chunk_id <= 0)
+		return true;
+
+	foreach(lc, restrictions)
+	{
+		BloomRestrictInfo *bri = lfirst(lc);
+
+		if (!chunk_bloom_filter_contains(chunk_id, bri->bloom_filter_id, bri->hash, snapshot))
+			return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,37 @@
+#ifndef TIMESCALEDB_BLOOM_FILTER_H
+#define TIMESCALEDB_BLOOM_FILTER_H
+
+#include <postgres.h>
+#include <access/attnum.h>
+#include <nodes/pg_list.h>
+#include <utils/snapshot.h>
+
+#include "catalog.h"
+#include "hypertable.h"
+
+#define BLOOM_FILTER_INVALIDATE_TRIGGER_NAME "ts_bloom_filter_invalidate"
+
+/*
+ * A bloom filter tracks the set of values of a (non-partitioning) column in
+ * each chunk of a hypertable. Queries with an equality restriction on the
+ * column can skip chunks that certainly do not contain the value.
+ */
+typedef struct BloomFilter
+{
+	FormData_bloom_filter fd;
+	AttrNumber	column_attno;	/* attribute number in the main table */
+	Oid			column_type;
+} BloomFilter;
+
+extern List *bloom_filter_scan_by_hypertable_id(int32 hypertable_id, Oid main_table_relid);
+extern BloomFilter *bloom_filter_get_by_column_name(List *filters, const char *column_name);
+extern int	bloom_filter_delete_by_hypertable_id(int32 hypertable_id);
+extern int	bloom_filter_set_column_name(BloomFilter *filter, const char *newname);
+extern void bloom_filter_drop(Hypertable *ht, BloomFilter *filter);
+
+extern int	chunk_bloom_filter_delete_by_chunk_id(int32 chunk_id);
+
+extern List *bloom_restrict_info_create(Hypertable *ht, Index rti, List *restrictinfos);
+extern bool chunk_bloom_filter_matches(int32 chunk_id, List *restrictions, Snapshot snapshot);
+
+#endif							/* TIMESCALEDB_BLOOM_FILTER_H */
@@ -9,6 +9,7 @@
 #include "catalog.h"
 #include "compat.h"
 #include "extension.h"
+#include "compressed_chunk.h"
 #include "hypertable_cache.h"
 
 /*
@@ -46,6 +47,7 @@ static void
 cache_invalidate_all(void)
 {
 	hypertable_cache_invalidate_callback();
+	compressed_chunk_cache_invalidate();
 }
 
 /*
@@ -69,7 +71,10 @@ cache_invalidate_callback(Datum arg, Oid relid)
 	catalog = catalog_get();
 
 	if (relid == catalog_get_cache_proxy_id(catalog, CACHE_TYPE_HYPERTABLE))
+	{
 		hypertable_cache_invalidate_callback();
+		compressed_chunk_cache_invalidate();
+	}
 }
 
 TS_FUNCTION_INFO_V1(timescaledb_invalidate_cache);
@@ -29,6 +29,15 @@ static const char *catalog_table_names[_MAX_CATALOG_TABLES + 1] = {
 	[CHUNK_CONSTRAINT] = CHUNK_CONSTRAINT_TABLE_NAME,
 	[CHUNK_INDEX] = CHUNK_INDEX_TABLE_NAME,
 	[TABLESPACE] = TABLESPACE_TABLE_NAME,
+	[COMPRESSED_CHUNK] = COMPRESSED_CHUNK_TABLE_NAME,
+	[MINMAX_INDEX] = MINMAX_INDEX_TABLE_NAME,
+	[CHUNK_MINMAX] = CHUNK_MINMAX_TABLE_NAME,
+	[BLOOM_FILTER] = BLOOM_FILTER_TABLE_NAME,
+	[CHUNK_BLOOM_FILTER] = CHUNK_BLOOM_FILTER_TABLE_NAME,
+	[CHUNK_STATS] = CHUNK_STATS_TABLE_NAME,
+	[CONTINUOUS_AGG] = CONTINUOUS_AGG_TABLE_NAME,
+	[CONTINUOUS_AGG_INVALIDATION_LOG] = CONTINUOUS_AGG_INVALIDATION_LOG_TABLE_NAME,
+	[LAST_POINT_CACHE] = LAST_POINT_CACHE_TABLE_NAME,
 	[_MAX_CATALOG_TABLES] = "invalid table",
 };
 
@@ -88,6 +97,64 @@ static const TableIndexDef catalog_table_index_definitions[_MAX_CATALOG_TABLES]
 			[TABLESPACE_PKEY_IDX] = "tablespace_pkey",
 			[TABLESPACE_HYPERTABLE_ID_TABLESPACE_NAME_IDX] = "tablespace_hypertable_id_tablespace_name_key",
 		}
+	},
+	[COMPRESSED_CHUNK] = {
+		.length = _MAX_COMPRESSED_CHUNK_INDEX,
+		.names = (char *[]) {
+			[COMPRESSED_CHUNK_PKEY_IDX] = "compressed_chunk_pkey",
+		}
+	},
+	[MINMAX_INDEX] = {
+		.length = _MAX_MINMAX_INDEX_INDEX,
+		.names = (char *[]) {
+			[MINMAX_INDEX_PKEY_IDX] = "minmax_index_pkey",
+			[MINMAX_INDEX_HYPERTABLE_ID_COLUMN_NAME_IDX] = "minmax_index_hypertable_id_column_name_key",
+		}
+	},
+	[CHUNK_MINMAX] = {
+		.length = _MAX_CHUNK_MINMAX_INDEX,
+		.names = (char *[]) {
+			[CHUNK_MINMAX_PKEY_IDX] = "chunk_minmax_pkey",
+		}
+	},
+	[BLOOM_FILTER] = {
+		.length = _MAX_BLOOM_FILTER_INDEX,
+		.names = (char *[]) {
+			[BLOOM_FILTER_PKEY_IDX] = "bloom_filter_pkey",
+			[BLOOM_FILTER_HYPERTABLE_ID_COLUMN_NAME_IDX] = "bloom_filter_hypertable_id_column_name_key",
+		}
+	},
+	[CHUNK_BLOOM_FILTER] = {
+		.length = _MAX_CHUNK_BLOOM_FILTER_INDEX,
+		.names = (char *[]) {
+			[CHUNK_BLOOM_FILTER_PKEY_IDX] = "chunk_bloom_filter_pkey",
+		}
+	},
+	[CHUNK_STATS] = {
+		.length = _MAX_CHUNK_STATS_INDEX,
+		.names = (char *[]) {
+			[CHUNK_STATS_PKEY_IDX] = "chunk_stats_pkey",
+		}
+	},
+	[CONTINUOUS_AGG] = {
+		.length = _MAX_CONTINUOUS_AGG_INDEX,
+		.names = (char *[]) {
+			[CONTINUOUS_AGG_PKEY_IDX] = "continuous_agg_pkey",
+			[CONTINUOUS_AGG_USER_VIEW_SCHEMA_USER_VIEW_NAME_IDX] = "continuous_agg_user_view_schema_user_view_name_key",
+			[CONTINUOUS_AGG_HYPERTABLE_ID_IDX] = "continuous_agg_hypertable_id_idx",
+		}
+	},
+	[CONTINUOUS_AGG_INVALIDATION_LOG] = {
+		.length = _MAX_CONTINUOUS_AGG_INVALIDATION_LOG_INDEX,
+		.names = (char *[]) {
+			[CONTINUOUS_AGG_INVALIDATION_LOG_CONTINUOUS_AGG_ID_IDX] = "continuous_agg_invalidation_log_continuous_agg_id_idx",
+		}
+	},
+	[LAST_POINT_CACHE] = {
+		.length = _MAX_LAST_POINT_CACHE_INDEX,
+		.names = (char *[]) {
+			[LAST_POINT_CACHE_PKEY_IDX] = "last_point_cache_pkey",
+		}
 	}
 };
 
@@ -99,6 +166,15 @@ static const char *catalog_table_serial_id_names[_MAX_CATALOG_TABLES] = {
 	[CHUNK_CONSTRAINT] = CATALOG_SCHEMA_NAME ".chunk_constraint_name",
 	[CHUNK_INDEX] = NULL,
 	[TABLESPACE] = CATALOG_SCHEMA_NAME ".tablespace_id_seq",
+	[COMPRESSED_CHUNK] = NULL,
+	[MINMAX_INDEX] = CATALOG_SCHEMA_NAME ".minmax_index_id_seq",
+	[CHUNK_MINMAX] = NULL,
+	[BLOOM_FILTER] = CATALOG_SCHEMA_NAME ".bloom_filter_id_seq",
+	[CHUNK_BLOOM_FILTER] = NULL,
+	[CHUNK_STATS] = NULL,
+	[CONTINUOUS_AGG] = CATALOG_SCHEMA_NAME ".continuous_agg_id_seq",
+	[CONTINUOUS_AGG_INVALIDATION_LOG] = NULL,
+	[LAST_POINT_CACHE] = NULL,
 };
 
 typedef struct InternalFunctionDef
@@ -111,6 +187,14 @@ const static InternalFunctionDef internal_function_definitions[_MAX_INTERNAL_FUN
 	[DDL_ADD_CHUNK_CONSTRAINT] = {
 		.name = "chunk_constraint_add_table_constraint",
 		.args = 1,
+	},
+	[MINMAX_RANGE_TRIGGER] = {
+		.name = "minmax_range_trigger",
+		.args = 0,
+	},
+	[BLOOM_FILTER_INVALIDATE_TRIGGER] = {
+		.name = "bloom_filter_invalidate_trigger",
+		.args = 0,
 	}
 };
 
@@ -480,6 +564,10 @@ catalog_invalidate_cache(Oid catalog_relid, CmdType operation)
 	switch (table)
 	{
 		case CHUNK:
+			/* New chunks invalidate the chunk lists of hypertables */
+			relid = catalog_get_cache_proxy_id(catalog, CACHE_TYPE_HYPERTABLE);
+			CacheInvalidateRelcacheByRelid(relid);
+			break;
 		case CHUNK_CONSTRAINT:
 		case DIMENSION_SLICE:
 			if (operation == CMD_UPDATE || operation == CMD_DELETE)
@@ -490,9 +578,20 @@ catalog_invalidate_cache(Oid catalog_relid, CmdType operation)
 			break;
 		case HYPERTABLE:
 		case DIMENSION:
+		case MINMAX_INDEX:
+		case BLOOM_FILTER:
+		case LAST_POINT_CACHE:
+		case COMPRESSED_CHUNK:
 			relid = catalog_get_cache_proxy_id(catalog, CACHE_TYPE_HYPERTABLE);
 			CacheInvalidateRelcacheByRelid(relid);
 			break;
+		case CONTINUOUS_AGG:
+			if (operation == CMD_INSERT || operation == CMD_DELETE)
+			{
+				relid = catalog_get_cache_proxy_id(catalog, CACHE_TYPE_HYPERTABLE);
+				CacheInvalidateRelcacheByRelid(relid);
+			}
+			break;
 		case CHUNK_INDEX:
 		default:
 			break;
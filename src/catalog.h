@@ -30,6 +30,15 @@ typedef enum CatalogTable
 	CHUNK_CONSTRAINT,
 	CHUNK_INDEX,
 	TABLESPACE,
+	COMPRESSED_CHUNK,
+	MINMAX_INDEX,
+	CHUNK_MINMAX,
+	BLOOM_FILTER,
+	CHUNK_BLOOM_FILTER,
+	CHUNK_STATS,
+	CONTINUOUS_AGG,
+	CONTINUOUS_AGG_INVALIDATION_LOG,
+	LAST_POINT_CACHE,
 	_MAX_CATALOG_TABLES,
 } CatalogTable;
 
@@ -51,6 +60,8 @@ typedef enum CatalogTable
 typedef enum InternalFunction
 {
 	DDL_ADD_CHUNK_CONSTRAINT,
+	MINMAX_RANGE_TRIGGER,
+	BLOOM_FILTER_INVALIDATE_TRIGGER,
 	_MAX_INTERNAL_FUNCTIONS,
 } InternalFunction;
 
@@ -462,6 +473,428 @@ typedef struct FormData_tablespace_hypertable_id_tablespace_name_idx
 	NameData	tablespace_name;
 }			FormData_tablespace_hypertable_id_tablespace_name_idx;
 
+/************************************
+ *
+ * Compressed chunk table definitions
+ *
+ ************************************/
+
+#define COMPRESSED_CHUNK_TABLE_NAME "compressed_chunk"
+
+enum Anum_compressed_chunk
+{
+	Anum_compressed_chunk_chunk_id = 1,
+	Anum_compressed_chunk_schema_name,
+	Anum_compressed_chunk_table_name,
+	Anum_compressed_chunk_segment_by,
+	_Anum_compressed_chunk_max,
+};
+
+#define Natts_compressed_chunk \
+	(_Anum_compressed_chunk_max - 1)
+
+/* The segment_by NAME[] column is variable length and not part of the struct */
+typedef struct FormData_compressed_chunk
+{
+	int32		chunk_id;
+	NameData	schema_name;
+	NameData	table_name;
+} FormData_compressed_chunk;
+
+typedef FormData_compressed_chunk *Form_compressed_chunk;
+
+enum
+{
+	COMPRESSED_CHUNK_PKEY_IDX = 0,
+	_MAX_COMPRESSED_CHUNK_INDEX,
+};
+
+enum Anum_compressed_chunk_pkey_idx
+{
+	Anum_compressed_chunk_pkey_idx_chunk_id = 1,
+	_Anum_compressed_chunk_pkey_idx_max,
+};
+
+/********************************
+ *
+ * Min/max index table definitions
+ *
+ ********************************/
+
+#define MINMAX_INDEX_TABLE_NAME "minmax_index"
+
+enum Anum_minmax_index
+{
+	Anum_minmax_index_id = 1,
+	Anum_minmax_index_hypertable_id,
+	Anum_minmax_index_column_name,
+	_Anum_minmax_index_max,
+};
+
+#define Natts_minmax_index \
+	(_Anum_minmax_index_max - 1)
+
+typedef struct FormData_minmax_index
+{
+	int32		id;
+	int32		hypertable_id;
+	NameData	column_name;
+} FormData_minmax_index;
+
+typedef FormData_minmax_index *Form_minmax_index;
+
+enum
+{
+	MINMAX_INDEX_PKEY_IDX = 0,
+	MINMAX_INDEX_HYPERTABLE_ID_COLUMN_NAME_IDX,
+	_MAX_MINMAX_INDEX_INDEX,
+};
+
+enum Anum_minmax_index_pkey_idx
+{
+	Anum_minmax_index_pkey_idx_id = 1,
+	_Anum_minmax_index_pkey_idx_max,
+};
+
+enum Anum_minmax_index_hypertable_id_column_name_idx
+{
+	Anum_minmax_index_hypertable_id_column_name_idx_hypertable_id = 1,
+	Anum_minmax_index_hypertable_id_column_name_idx_column_name,
+	_Anum_minmax_index_hypertable_id_column_name_idx_max,
+};
+
+/*******************************
+ *
+ * Chunk min/max table definitions
+ *
+ *******************************/
+
+#define CHUNK_MINMAX_TABLE_NAME "chunk_minmax"
+
+enum Anum_chunk_minmax
+{
+	Anum_chunk_minmax_chunk_id = 1,
+	Anum_chunk_minmax_minmax_index_id,
+	Anum_chunk_minmax_min_value,
+	Anum_chunk_minmax_max_value,
+	_Anum_chunk_minmax_max,
+};
+
+#define Natts_chunk_minmax \
+	(_Anum_chunk_minmax_max - 1)
+
+/* The min/max values are NULL if the chunk has no values in the column */
+typedef struct FormData_chunk_minmax
+{
+	int32		chunk_id;
+	int32		minmax_index_id;
+	int64		min_value;
+	int64		max_value;
+} FormData_chunk_minmax;
+
+typedef FormData_chunk_minmax *Form_chunk_minmax;
+
+enum
+{
+	CHUNK_MINMAX_PKEY_IDX = 0,
+	_MAX_CHUNK_MINMAX_INDEX,
+};
+
+enum Anum_chunk_minmax_pkey_idx
+{
+	Anum_chunk_minmax_pkey_idx_chunk_id = 1,
+	Anum_chunk_minmax_pkey_idx_minmax_index_id,
+	_Anum_chunk_minmax_pkey_idx_max,
+};
+
+/********************************
+ *
+ * Bloom filter table definitions
+ *
+ ********************************/
+
+#define BLOOM_FILTER_TABLE_NAME "bloom_filter"
+
+enum Anum_bloom_filter
+{
+	Anum_bloom_filter_id = 1,
+	Anum_bloom_filter_hypertable_id,
+	Anum_bloom_filter_column_name,
+	Anum_bloom_filter_false_positive_rate,
+	_Anum_bloom_filter_max,
+};
+
+#define Natts_bloom_filter \
+	(_Anum_bloom_filter_max - 1)
+
+typedef struct FormData_bloom_filter
+{
+	int32		id;
+	int32		hypertable_id;
+	NameData	column_name;
+	float8		false_positive_rate;
+} FormData_bloom_filter;
+
+typedef FormData_bloom_filter *Form_bloom_filter;
+
+enum
+{
+	BLOOM_FILTER_PKEY_IDX = 0,
+	BLOOM_FILTER_HYPERTABLE_ID_COLUMN_NAME_IDX,
+	_MAX_BLOOM_FILTER_INDEX,
+};
+
+enum Anum_bloom_filter_pkey_idx
+{
+	Anum_bloom_filter_pkey_idx_id = 1,
+	_Anum_bloom_filter_pkey_idx_max,
+};
+
+enum Anum_bloom_filter_hypertable_id_column_name_idx
+{
+	Anum_bloom_filter_hypertable_id_column_name_idx_hypertable_id = 1,
+	Anum_bloom_filter_hypertable_id_column_name_idx_column_name,
+	_Anum_bloom_filter_hypertable_id_column_name_idx_max,
+};
+
+/*************************************
+ *
+ * Chunk bloom filter table definitions
+ *
+ *************************************/
+
+#define CHUNK_BLOOM_FILTER_TABLE_NAME "chunk_bloom_filter"
+
+enum Anum_chunk_bloom_filter
+{
+	Anum_chunk_bloom_filter_chunk_id = 1,
+	Anum_chunk_bloom_filter_bloom_filter_id,
+	Anum_chunk_bloom_filter_num_hashes,
+	Anum_chunk_bloom_filter_filter,
+	_Anum_chunk_bloom_filter_max,
+};
+
+#define Natts_chunk_bloom_filter \
+	(_Anum_chunk_bloom_filter_max - 1)
+
+/* The variable-length filter bits follow the fixed-size fields */
+typedef struct FormData_chunk_bloom_filter
+{
+	int32		chunk_id;
+	int32		bloom_filter_id;
+	int32		num_hashes;
+} FormData_chunk_bloom_filter;
+
+typedef FormData_chunk_bloom_filter *Form_chunk_bloom_filter;
+
+enum
+{
+	CHUNK_BLOOM_FILTER_PKEY_IDX = 0,
+	_MAX_CHUNK_BLOOM_FILTER_INDEX,
+};
+
+enum Anum_chunk_bloom_filter_pkey_idx
+{
+	Anum_chunk_bloom_filter_pkey_idx_chunk_id = 1,
+	Anum_chunk_bloom_filter_pkey_idx_bloom_filter_id,
+	_Anum_chunk_bloom_filter_pkey_idx_max,
+};
+
+/*******************************
+ *
+ * Chunk stats table definitions
+ *
+ *******************************/
+
+#define CHUNK_STATS_TABLE_NAME "chunk_stats"
+
+enum Anum_chunk_stats
+{
+	Anum_chunk_stats_chunk_id = 1,
+	Anum_chunk_stats_row_count,
+	Anum_chunk_stats_min_time,
+	Anum_chunk_stats_max_time,
+	_Anum_chunk_stats_max,
+};
+
+#define Natts_chunk_stats \
+	(_Anum_chunk_stats_max - 1)
+
+/* The min/max times are NULL if the chunk has no rows */
+typedef struct FormData_chunk_stats
+{
+	int32		chunk_id;
+	int64		row_count;
+	int64		min_time;
+	int64		max_time;
+} FormData_chunk_stats;
+
+typedef FormData_chunk_stats *Form_chunk_stats;
+
+enum
+{
+	CHUNK_STATS_PKEY_IDX = 0,
+	_MAX_CHUNK_STATS_INDEX,
+};
+
+enum Anum_chunk_stats_pkey_idx
+{
+	Anum_chunk_stats_pkey_idx_chunk_id = 1,
+	_Anum_chunk_stats_pkey_idx_max,
+};
+
+/**********************************
+ *
+ * Continuous agg table definitions
+ *
+ **********************************/
+
+#define CONTINUOUS_AGG_TABLE_NAME "continuous_agg"
+
+enum Anum_continuous_agg
+{
+	Anum_continuous_agg_id = 1,
+	Anum_continuous_agg_hypertable_id,
+	Anum_continuous_agg_user_view_schema,
+	Anum_continuous_agg_user_view_name,
+	Anum_continuous_agg_direct_view_schema,
+	Anum_continuous_agg_direct_view_name,
+	Anum_continuous_agg_mat_table_schema,
+	Anum_continuous_agg_mat_table_name,
+	Anum_continuous_agg_bucket_column_name,
+	Anum_continuous_agg_bucket_width,
+	Anum_continuous_agg_materialized_only,
+	Anum_continuous_agg_watermark,
+	_Anum_continuous_agg_max,
+};
+
+#define Natts_continuous_agg \
+	(_Anum_continuous_agg_max - 1)
+
+/* The watermark is NULL until the aggregate is first refreshed */
+typedef struct FormData_continuous_agg
+{
+	int32		id;
+	int32		hypertable_id;
+	NameData	user_view_schema;
+	NameData	user_view_name;
+	NameData	direct_view_schema;
+	NameData	direct_view_name;
+	NameData	mat_table_schema;
+	NameData	mat_table_name;
+	NameData	bucket_column_name;
+	int64		bucket_width;
+	bool		materialized_only;
+	int64		watermark;
+} FormData_continuous_agg;
+
+typedef FormData_continuous_agg *Form_continuous_agg;
+
+enum
+{
+	CONTINUOUS_AGG_PKEY_IDX = 0,
+	CONTINUOUS_AGG_USER_VIEW_SCHEMA_USER_VIEW_NAME_IDX,
+	CONTINUOUS_AGG_HYPERTABLE_ID_IDX,
+	_MAX_CONTINUOUS_AGG_INDEX,
+};
+
+enum Anum_continuous_agg_pkey_idx
+{
+	Anum_continuous_agg_pkey_idx_id = 1,
+	_Anum_continuous_agg_pkey_idx_max,
+};
+
+enum Anum_continuous_agg_user_view_schema_user_view_name_idx
+{
+	Anum_continuous_agg_user_view_schema_user_view_name_idx_user_view_schema = 1,
+	Anum_continuous_agg_user_view_schema_user_view_name_idx_user_view_name,
+	_Anum_continuous_agg_user_view_schema_user_view_name_idx_max,
+};
+
+enum Anum_continuous_agg_hypertable_id_idx
+{
+	Anum_continuous_agg_hypertable_id_idx_hypertable_id = 1,
+	_Anum_continuous_agg_hypertable_id_idx_max,
+};
+
+/***************************************************
+ *
+ * Continuous agg invalidation log table definitions
+ *
+ ***************************************************/
+
+#define CONTINUOUS_AGG_INVALIDATION_LOG_TABLE_NAME "continuous_agg_invalidation_log"
+
+enum Anum_continuous_agg_invalidation_log
+{
+	Anum_continuous_agg_invalidation_log_continuous_agg_id = 1,
+	Anum_continuous_agg_invalidation_log_lowest_modified_value,
+	Anum_continuous_agg_invalidation_log_greatest_modified_value,
+	_Anum_continuous_agg_invalidation_log_max,
+};
+
+#define Natts_continuous_agg_invalidation_log \
+	(_Anum_continuous_agg_invalidation_log_max - 1)
+
+typedef struct FormData_continuous_agg_invalidation_log
+{
+	int32		continuous_agg_id;
+	int64		lowest_modified_value;
+	int64		greatest_modified_value;
+} FormData_continuous_agg_invalidation_log;
+
+typedef FormData_continuous_agg_invalidation_log *Form_continuous_agg_invalidation_log;
+
+enum
+{
+	CONTINUOUS_AGG_INVALIDATION_LOG_CONTINUOUS_AGG_ID_IDX = 0,
+	_MAX_CONTINUOUS_AGG_INVALIDATION_LOG_INDEX,
+};
+
+enum Anum_continuous_agg_invalidation_log_continuous_agg_id_idx
+{
+	Anum_continuous_agg_invalidation_log_continuous_agg_id_idx_continuous_agg_id = 1,
+	_Anum_continuous_agg_invalidation_log_continuous_agg_id_idx_max,
+};
+
+/************************************
+ *
+ * Last point cache table definitions
+ *
+ ************************************/
+
+#define LAST_POINT_CACHE_TABLE_NAME "last_point_cache"
+
+enum Anum_last_point_cache
+{
+	Anum_last_point_cache_hypertable_id = 1,
+	Anum_last_point_cache_key_column_name,
+	_Anum_last_point_cache_max,
+};
+
+#define Natts_last_point_cache \
+	(_Anum_last_point_cache_max - 1)
+
+typedef struct FormData_last_point_cache
+{
+	int32		hypertable_id;
+	NameData	key_column_name;
+} FormData_last_point_cache;
+
+typedef FormData_last_point_cache *Form_last_point_cache;
+
+enum
+{
+	LAST_POINT_CACHE_PKEY_IDX = 0,
+	_MAX_LAST_POINT_CACHE_INDEX,
+};
+
+enum Anum_last_point_cache_pkey_idx
+{
+	Anum_last_point_cache_pkey_idx_hypertable_id = 1,
+	_Anum_last_point_cache_pkey_idx_max,
+};
+
 
 #define MAX(a, b) \
 	((long)(a) > (long)(b) ? (a) : (b))
@@ -473,7 +906,16 @@ typedef struct FormData_tablespace_hypertable_id_tablespace_name_idx
 				MAX(_MAX_CHUNK_CONSTRAINT_INDEX,		\
 					MAX(_MAX_CHUNK_INDEX_INDEX,			\
 						MAX(_MAX_TABLESPACE_INDEX,		\
-							_MAX_CHUNK_INDEX))))))
+							MAX(_MAX_COMPRESSED_CHUNK_INDEX, \
+								MAX(_MAX_MINMAX_INDEX_INDEX, \
+									MAX(_MAX_CHUNK_MINMAX_INDEX, \
+										MAX(_MAX_BLOOM_FILTER_INDEX, \
+											MAX(_MAX_CHUNK_BLOOM_FILTER_INDEX, \
+												MAX(_MAX_CHUNK_STATS_INDEX, \
+													MAX(_MAX_CONTINUOUS_AGG_INDEX, \
+														MAX(_MAX_CONTINUOUS_AGG_INVALIDATION_LOG_INDEX, \
+															MAX(_MAX_LAST_POINT_CACHE_INDEX, \
+																_MAX_CHUNK_INDEX)))))))))))))))
 
 typedef enum CacheType
 {
@@ -20,7 +20,11 @@
 
 #include "chunk.h"
 #include "chunk_index.h"
+#include "compressed_chunk.h"
 #include "catalog.h"
+#include "minmax_index.h"
+#include "bloom_filter.h"
+#include "chunk_stats.h"
 #include "dimension.h"
 #include "dimension_slice.h"
 #include "dimension_vector.h"
@@ -476,6 +480,9 @@ chunk_create_after_lock(Hypertable *ht, Point *p, const char *schema, const char
 	/* Add metadata for dimensional and inheritable constraints */
 	chunk_add_constraints(chunk);
 
+	/* The new chunk has no rows, so its min/max ranges are empty */
+	chunk_minmax_insert_empty(ht, chunk->fd.id);
+
 	/* Create the actual table relation for the chunk */
 	chunk->table_id = chunk_create_table(chunk, ht);
 
@@ -993,6 +1000,10 @@ chunk_tuple_delete(TupleInfo *ti, void *data)
 
 	chunk_constraint_delete_by_chunk_id(form->id, ccs);
 	chunk_index_delete_by_chunk_id(form->id, true);
+	compressed_chunk_delete_by_chunk_id(form->id);
+	chunk_minmax_delete_by_chunk_id(form->id);
+	chunk_bloom_filter_delete_by_chunk_id(form->id);
+	chunk_stats_delete_by_chunk_id(form->id);
 
 	/* Check for dimension slices that are orphaned by the chunk deletion */
 	for (i = 0; i < ccs->num_constraints; i++)
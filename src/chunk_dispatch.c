@@ -10,6 +10,9 @@
 #include "subspace_store.h"
 #include "dimension.h"
 #include "guc.h"
+#include "minmax_index.h"
+#include "continuous_agg.h"
+#include "last_point_cache.h"
 
 ChunkDispatch *
 chunk_dispatch_create(Hypertable *ht, EState *estate, Query *parse)
@@ -20,6 +23,9 @@ chunk_dispatch_create(Hypertable *ht, EState *estate, Query *parse)
 	cd->estate = estate;
 	cd->hypertable_result_rel_info = NULL;
 	cd->parse = parse;
+	cd->minmax_trackers = NIL;
+	cd->lowest_modified_value = PG_INT64_MAX;
+	cd->greatest_modified_value = PG_INT64_MIN;
 	cd->cache = subspace_store_init(ht->space, estate->es_query_cxt, guc_max_open_chunks_per_insert);
 
 	return cd;
@@ -29,6 +35,74 @@ void
 chunk_dispatch_destroy(ChunkDispatch *cd)
 {
 	subspace_store_free(cd->cache);
+	chunk_dispatch_flush_minmax(cd);
+
+	if (cd->lowest_modified_value <= cd->greatest_modified_value)
+		continuous_agg_invalidate_range(cd->hypertable->fd.id,
+										cd->lowest_modified_value,
+										cd->greatest_modified_value);
+}
+
+/*
+ * Write the min/max ranges of the dispatched tuples to the catalog. This
+ * should happen once all tuples are dispatched, but before AFTER triggers
+ * fire, so that the triggers see the new ranges. Flushing is cheap when the
+ * ranges are already up to date.
+ */
+void
+chunk_dispatch_flush_minmax(ChunkDispatch *cd)
+{
+	chunk_minmax_tracker_flush_all(cd->minmax_trackers);
+}
+
+/*
+ * Track the last point of a dispatched tuple. Upserts might update existing
+ * rows instead, and BEFORE ROW triggers might change or skip the tuple, so
+ * these reset the cache of the hypertable.
+ */
+static void
+chunk_dispatch_track_last_point(ChunkDispatch *cd, HeapTuple tuple, TupleDesc tupdesc)
+{
+	TriggerDesc *trigdesc = cd->hypertable_result_rel_info->ri_TrigDesc;
+
+	if (cd->last_point_cache_reset)
+		return;
+
+	if ((NULL != cd->parse && NULL != cd->parse->onConflict) ||
+		(NULL != trigdesc && trigdesc->trig_insert_before_row))
+	{
+		last_point_cache_reset(cd->hypertable->fd.id);
+		cd->last_point_cache_reset = true;
+		return;
+	}
+
+	last_point_cache_add_row(cd->hypertable, tuple, tupdesc);
+}
+
+/*
+ * Track a dispatched tuple for invalidating the continuous aggregates of the
+ * hypertable and for its last point cache. The time value is the point's
+ * first coordinate, since open dimensions come first and continuous
+ * aggregates need the time dimension to be without a partitioning function.
+ */
+void
+chunk_dispatch_track_modified(ChunkDispatch *cd, Point *point, HeapTuple tuple, TupleDesc tupdesc)
+{
+	int64		value;
+
+	if (NULL != cd->hypertable->last_point_cache)
+		chunk_dispatch_track_last_point(cd, tuple, tupdesc);
+
+	if (cd->hypertable->continuous_aggs == NIL)
+		return;
+
+	value = point->coordinates[0];
+
+	if (value < cd->lowest_modified_value)
+		cd->lowest_modified_value = value;
+
+	if (value > cd->greatest_modified_value)
+		cd->greatest_modified_value = value;
 }
 
 static void
@@ -27,6 +27,22 @@ typedef struct ChunkDispatch
 	ResultRelInfo *hypertable_result_rel_info;
 	Query	   *parse;
 
+	/*
+	 * Min/max range trackers of the chunks inserted into. These outlive the
+	 * chunk insert states, which might be closed before the ranges are
+	 * flushed.
+	 */
+	List	   *minmax_trackers;
+
+	/*
+	 * The range of time values dispatched, which invalidates the continuous
+	 * aggregates of the hypertable. Empty if lowest > greatest.
+	 */
+	int64		lowest_modified_value;
+	int64		greatest_modified_value;
+
+	/* The statement's rows reset the last point cache instead of adding to it */
+	bool		last_point_cache_reset;
 } ChunkDispatch;
 
 typedef struct Point Point;
@@ -34,6 +50,8 @@ typedef struct ChunkInsertState ChunkInsertState;
 
 ChunkDispatch *chunk_dispatch_create(Hypertable *ht, EState *estate, Query *query);
 void		chunk_dispatch_destroy(ChunkDispatch *dispatch);
+void		chunk_dispatch_flush_minmax(ChunkDispatch *dispatch);
+void		chunk_dispatch_track_modified(ChunkDispatch *dispatch, Point *p, HeapTuple tuple, TupleDesc tupdesc);
 ChunkInsertState *chunk_dispatch_get_chunk_insert_state(ChunkDispatch *dispatch, Point *p, CmdType operation);
 
 #endif							/* TIMESCALEDB_CHUNK_DISPATCH_H */
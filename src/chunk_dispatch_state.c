@@ -75,6 +75,11 @@ chunk_dispatch_exec(CustomScanState *node)
 		/* Find or create the insert state matching the point */
 		cis = chunk_dispatch_get_chunk_insert_state(dispatch, point, operation);
 
+		if (NULL != cis->minmax)
+			chunk_minmax_tracker_add_tuple(cis->minmax, tuple, tupdesc);
+
+		chunk_dispatch_track_modified(dispatch, point, tuple, tupdesc);
+
 		/*
 		 * Update the arbiter indexes for ON CONFLICT statements so that they
 		 * match the chunk. Note that this requires updating the existing List
@@ -96,6 +101,8 @@ chunk_dispatch_exec(CustomScanState *node)
 		/* Convert the tuple to the chunk's rowtype, if necessary */
 		tuple = chunk_insert_state_convert_tuple(cis, tuple, &slot);
 	}
+	else
+		chunk_dispatch_flush_minmax(state->dispatch);
 
 	return slot;
 }
@@ -15,6 +15,7 @@
 #include "errors.h"
 #include "chunk_insert_state.h"
 #include "chunk_dispatch.h"
+#include "compressed_chunk.h"
 #include "compat.h"
 
 /*
@@ -251,6 +252,13 @@ chunk_insert_state_create(Chunk *chunk, ChunkDispatch *dispatch, CmdType operati
 				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
 				 errmsg("Hypertables don't support row-level security")));
 
+	if (compressed_chunk_get_by_chunk_id(chunk->fd.id) != NULL)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("cannot insert into compressed chunk \"%s\"",
+						NameStr(chunk->fd.table_name)),
+				 errhint("Decompress the chunk with decompress_chunk() first.")));
+
 	/*
 	 * We must allocate the range table entry on the executor's per-query
 	 * context
@@ -285,6 +293,20 @@ chunk_insert_state_create(Chunk *chunk, ChunkDispatch *dispatch, CmdType operati
 			elog(ERROR, "Insert trigger on chunk table not supported");
 	}
 
+	/*
+	 * Track the min/max ranges of inserted tuples. The tracker is allocated
+	 * on the per-query context since the chunk insert state might be closed
+	 * before the ranges are flushed at the end of the insert.
+	 */
+	MemoryContextSwitchTo(dispatch->estate->es_query_cxt);
+	state->minmax = chunk_minmax_tracker_create(dispatch->hypertable, chunk->fd.id,
+												resrelinfo, onconflict);
+
+	if (NULL != state->minmax)
+		dispatch->minmax_trackers = lappend(dispatch->minmax_trackers, state->minmax);
+
+	MemoryContextSwitchTo(cis_context);
+
 	/* Set the chunk's arbiter indexes for ON CONFLICT statements */
 	if (parse != NULL && parse->onConflict != NULL)
 		state->arbiter_indexes = chunk_infer_arbiter_indexes(rti, dispatch->estate->es_range_table, dispatch->parse);
@@ -8,6 +8,7 @@
 #include "hypertable.h"
 #include "chunk.h"
 #include "cache.h"
+#include "minmax_index.h"
 
 typedef struct ChunkInsertState
 {
@@ -17,6 +18,8 @@ typedef struct ChunkInsertState
 	TupleConversionMap *tup_conv_map;
 	TupleTableSlot *slot;
 	MemoryContext mctx;
+	/* Tracks min/max ranges, or NULL if tracked by the chunk's trigger */
+	ChunkMinMaxTracker *minmax;
 } ChunkInsertState;
 
 typedef struct ChunkDispatch ChunkDispatch;
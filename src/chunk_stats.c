@@ -0,0 +1,506 @@
+#include <postgres.h>
+#include <access/heapam.h>
+#include <access/htup_details.h>
+#include <access/stratnum.h>
+#include <access/xact.h>
+#include <catalog/pg_type.h>
+#include <catalog/pg_trigger.h>
+#include <commands/trigger.h>
+#include <miscadmin.h>
+#include <nodes/makefuncs.h>
+#include <storage/lmgr.h>
+#include <utils/builtins.h>
+#include <utils/fmgroids.h>
+#include <utils/lsyscache.h>
+#include <utils/rel.h>
+#include <utils/snapmgr.h>
+#include <utils/typcache.h>
+
+#include "chunk.h"
+#include "chunk_stats.h"
+#include "compressed_chunk.h"
+#include "dimension.h"
+#include "dimension_slice.h"
+#include "hypercube.h"
+#include "hypertable.h"
+#include "hypertable_cache.h"
+#include "scanner.h"
+#include "utils.h"
+#include "compat.h"
+
+/*
+ * Chunk statistics.
+ *
+ * The statistics of a chunk are its number of rows and the range of its time
+ * column, which answer count(*), count(time), min(time) and max(time) over
+ * the chunk without reading its rows. They are recorded in the chunk_stats
+ * catalog table once a chunk no longer receives writes. Triggers on the chunk
+ * remove the statistics on the first insert, update or delete of rows in the
+ * chunk and when the chunk is truncated, so statistics that a query's
+ * snapshot sees always describe the rows that the snapshot sees.
+ *
+ * The VectorAgg node answers the aggregates of a chunk from its statistics if
+ * the query's restrictions hold for every row of the chunk, i.e., the chunk's
+ * time slice lies within the restricted time range.
+ */
+
+static int
+chunk_stats_scan(int32 chunk_id,
+				 tuple_found_func tuple_found,
+				 void *data,
+				 LOCKMODE lockmode,
+				 bool tuplock,
+				 Snapshot snapshot)
+{
+	Catalog    *catalog = catalog_get();
+	ScanKeyData scankey[1];
+	ScannerCtx	scanctx = {
+		.table = catalog->tables[CHUNK_STATS].id,
+		.index = CATALOG_INDEX(catalog, CHUNK_STATS, CHUNK_STATS_PKEY_IDX),
+		.nkeys = 1,
+		.scankey = scankey,
+		.tuple_found = tuple_found,
+		.data = data,
+		.lockmode = lockmode,
+		.tuplock = {
+			.lockmode = LockTupleExclusive,
+			.waitpolicy = LockWaitBlock,
+			.enabled = tuplock,
+		},
+		.scandirection = ForwardScanDirection,
+		.snapshot = snapshot,
+	};
+
+	ScanKeyInit(&scankey[0], Anum_chunk_stats_pkey_idx_chunk_id,
+				BTEqualStrategyNumber, F_INT4EQ, Int32GetDatum(chunk_id));
+
+	return scanner_scan(&scanctx);
+}
+
+static bool
+chunk_stats_tuple_found(TupleInfo *ti, void *data)
+{
+	ChunkStats *stats = data;
+	Datum		values[Natts_chunk_stats];
+	bool		nulls[Natts_chunk_stats];
+
+	heap_deform_tuple(ti->tuple, ti->desc, values, nulls);
+
+	stats->chunk_id = DatumGetInt32(values[Anum_chunk_stats_chunk_id - 1]);
+	stats->row_count = DatumGetInt64(values[Anum_chunk_stats_row_count - 1]);
+	stats->min_time = nulls[Anum_chunk_stats_min_time - 1] ? 0 :
+		DatumGetInt64(values[Anum_chunk_stats_min_time - 1]);
+	stats->max_time = nulls[Anum_chunk_stats_max_time - 1] ? 0 :
+		DatumGetInt64(values[Anum_chunk_stats_max_time - 1]);
+
+	return false;
+}
+
+/*
+ * Get the statistics of a chunk as seen by the given snapshot. Returns false
+ * if the chunk has no statistics.
+ */
+bool
+chunk_stats_get(int32 chunk_id, Snapshot snapshot, ChunkStats *stats)
+{
+	return chunk_stats_scan(chunk_id, chunk_stats_tuple_found, stats,
+							AccessShareLock, false, snapshot) > 0;
+}
+
+void
+chunk_stats_insert(ChunkStats *stats)
+{
+	Catalog    *catalog = catalog_get();
+	Relation	rel;
+	Datum		values[Natts_chunk_stats];
+	bool		nulls[Natts_chunk_stats] = {false};
+	CatalogSecurityContext sec_ctx;
+
+	values[Anum_chunk_stats_chunk_id - 1] = Int32GetDatum(stats->chunk_id);
+	values[Anum_chunk_stats_row_count - 1] = Int64GetDatum(stats->row_count);
+	values[Anum_chunk_stats_min_time - 1] = Int64GetDatum(stats->min_time);
+	values[Anum_chunk_stats_max_time - 1] = Int64GetDatum(stats->max_time);
+	nulls[Anum_chunk_stats_min_time - 1] = stats->row_count == 0;
+	nulls[Anum_chunk_stats_max_time - 1] = stats->row_count == 0;
+
+	rel = heap_open(catalog->tables[CHUNK_STATS].id, RowExclusiveLock);
+	catalog_become_owner(catalog, &sec_ctx);
+	catalog_insert_values(rel, RelationGetDescr(rel), values, nulls);
+	catalog_restore_user(&sec_ctx);
+	heap_close(rel, RowExclusiveLock);
+}
+
+static bool
+chunk_stats_tuple_delete(TupleInfo *ti, void *data)
+{
+	CatalogSecurityContext sec_ctx;
+
+	/*
+	 * When locking, skip statistics that a concurrent transaction already
+	 * removed
+	 */
+	if (NULL != data && ti->lockresult != HeapTupleMayBeUpdated)
+		return true;
+
+	catalog_become_owner(catalog_get(), &sec_ctx);
+	catalog_delete(ti->scanrel, ti->tuple);
+	catalog_restore_user(&sec_ctx);
+
+	return true;
+}
+
+int
+chunk_stats_delete_by_chunk_id(int32 chunk_id)
+{
+	return chunk_stats_scan(chunk_id, chunk_stats_tuple_delete, NULL,
+							RowExclusiveLock, false, NULL);
+}
+
+/*
+ * Remove the statistics of a chunk that is being written to. The statistics
+ * are locked first, so that concurrent writers to the chunk do not fail
+ * trying to delete the same row.
+ */
+static int
+chunk_stats_invalidate(int32 chunk_id)
+{
+	bool		locked = true;
+
+	return chunk_stats_scan(chunk_id, chunk_stats_tuple_delete, &locked,
+							RowExclusiveLock, true, NULL);
+}
+
+static void
+chunk_stats_trigger_create(Oid chunk_relid, char *trigname, bool row, int16 events)
+{
+	CreateTrigStmt stmt = {
+		.type = T_CreateTrigStmt,
+		.trigname = trigname,
+		.relation = makeRangeVarFromRelid(chunk_relid),
+		.funcname = list_make2(makeString(INTERNAL_SCHEMA_NAME), makeString("chunk_stats_invalidate_trigger")),
+		.args = NIL,
+		.row = row,
+		.timing = TRIGGER_TYPE_AFTER,
+		.events = events,
+		.columns = NIL,
+		.whenClause = NULL,
+		.isconstraint = false,
+	};
+
+	if (OidIsValid(get_trigger_oid(chunk_relid, trigname, true)))
+		return;
+
+	CreateTrigger(&stmt, NULL, InvalidOid, InvalidOid,
+				  InvalidOid, InvalidOid, false);
+	CommandCounterIncrement();
+}
+
+/*
+ * Record the statistics of a chunk from its rows, replacing any existing
+ * statistics.
+ *
+ * Writes to the chunk are blocked while the rows are read, so the statistics
+ * cover all rows once recorded, and any later write fires the triggers that
+ * remove them again.
+ */
+static void
+chunk_stats_record(Hypertable *ht, Chunk *chunk)
+{
+	Dimension  *dim = hyperspace_get_open_dimension(ht->space, 0);
+	ChunkStats	stats = {
+		.chunk_id = chunk->fd.id,
+	};
+	AttrNumber	time_attno;
+	Relation	rel;
+	TupleDesc	tupdesc;
+	Snapshot	snapshot;
+	HeapScanDesc scan;
+	HeapTuple	tuple;
+
+	LockRelationOid(chunk->table_id, ShareRowExclusiveLock);
+
+	time_attno = get_attnum(chunk->table_id, NameStr(dim->fd.column_name));
+	rel = heap_open(chunk->table_id, NoLock);
+	tupdesc = RelationGetDescr(rel);
+	snapshot = RegisterSnapshot(GetLatestSnapshot());
+	scan = heap_beginscan(rel, snapshot, 0, NULL);
+
+	while ((tuple = heap_getnext(scan, ForwardScanDirection)) != NULL)
+	{
+		bool		isnull;
+		Datum		value = heap_getattr(tuple, time_attno, tupdesc, &isnull);
+		int64		time;
+
+		/* The time column is NOT NULL */
+		Assert(!isnull);
+
+		time = time_value_to_internal(value, dim->fd.column_type);
+
+		if (stats.row_count == 0 || time < stats.min_time)
+			stats.min_time = time;
+		if (stats.row_count == 0 || time > stats.max_time)
+			stats.max_time = time;
+
+		stats.row_count++;
+		CHECK_FOR_INTERRUPTS();
+	}
+
+	heap_endscan(scan);
+	UnregisterSnapshot(snapshot);
+	heap_close(rel, NoLock);
+
+	chunk_stats_delete_by_chunk_id(chunk->fd.id);
+	chunk_stats_insert(&stats);
+
+	chunk_stats_trigger_create(chunk->table_id, CHUNK_STATS_INVALIDATE_TRIGGER_NAME, true,
+							   TRIGGER_TYPE_INSERT | TRIGGER_TYPE_UPDATE | TRIGGER_TYPE_DELETE);
+	chunk_stats_trigger_create(chunk->table_id, CHUNK_STATS_INVALIDATE_TRUNCATE_TRIGGER_NAME, false,
+							   TRIGGER_TYPE_TRUNCATE);
+}
+
+/*
+ * Trigger that removes the statistics of a chunk when rows are inserted into,
+ * updated in or deleted from the chunk, or the chunk is truncated. Only the
+ * first row of a statement touches the catalog.
+ */
+TS_FUNCTION_INFO_V1(chunk_stats_invalidate_trigger);
+
+Datum
+chunk_stats_invalidate_trigger(PG_FUNCTION_ARGS)
+{
+	TriggerData *trigdata = (TriggerData *) fcinfo->context;
+	Oid			relid;
+
+	if (!CALLED_AS_TRIGGER(fcinfo))
+		elog(ERROR, "chunk_stats_invalidate_trigger: not called by trigger manager");
+
+	if (!TRIGGER_FIRED_AFTER(trigdata->tg_event))
+		elog(ERROR, "chunk_stats_invalidate_trigger: must be fired AFTER");
+
+	relid = RelationGetRelid(trigdata->tg_relation);
+
+	if (NULL == fcinfo->flinfo->fn_extra ||
+		*((Oid *) fcinfo->flinfo->fn_extra) != relid)
+	{
+		Chunk	   *chunk = chunk_get_by_relid(relid, 0, false);
+
+		if (NULL != chunk)
+			chunk_stats_invalidate(chunk->fd.id);
+
+		if (TRIGGER_FIRED_FOR_ROW(trigdata->tg_event))
+		{
+			fcinfo->flinfo->fn_extra = MemoryContextAlloc(fcinfo->flinfo->fn_mcxt, sizeof(Oid));
+			*((Oid *) fcinfo->flinfo->fn_extra) = relid;
+		}
+	}
+
+	return PointerGetDatum(NULL);
+}
+
+TS_FUNCTION_INFO_V1(chunk_stats_record_chunk);
+
+/*
+ * Record the statistics of a chunk.
+ *
+ * Arguments:
+ * 0. Relation ID of the chunk
+ */
+Datum
+chunk_stats_record_chunk(PG_FUNCTION_ARGS)
+{
+	Oid			chunk_relid = PG_ARGISNULL(0) ? InvalidOid : PG_GETARG_OID(0);
+	Chunk	   *chunk;
+	Cache	   *hcache;
+	Hypertable *ht;
+
+	if (!OidIsValid(chunk_relid))
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("invalid chunk")));
+
+	chunk = chunk_get_by_relid(chunk_relid, 0, false);
+
+	if (NULL == chunk)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("\"%s\" is not a chunk", get_rel_name(chunk_relid))));
+
+	hcache = hypertable_cache_pin();
+	ht = hypertable_cache_get_entry_by_id(hcache, chunk->fd.hypertable_id);
+
+	hypertable_permissions_check(ht->main_table_relid, GetUserId());
+
+	if (NULL != compressed_chunk_get_by_chunk_id(chunk->fd.id))
+		ereport(ERROR,
+				(errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
+				 errmsg("cannot record statistics for compressed chunk \"%s\"",
+						get_rel_name(chunk_relid)),
+				 errhint("Record the statistics before compressing the chunk.")));
+
+	chunk_stats_record(ht, chunk);
+	cache_release(hcache);
+
+	PG_RETURN_VOID();
+}
+
+/*
+ * Query planning.
+ */
+
+static bool
+chunk_stats_type_is_integer(Oid type)
+{
+	return type == INT2OID || type == INT4OID || type == INT8OID;
+}
+
+/*
+ * Check if a restriction of the form "time_column op const" holds for every
+ * time in a slice [start, end).
+ */
+static bool
+chunk_stats_clause_covers_slice(OpExpr *op, Index rti, AttrNumber time_attno, DimensionSlice *slice)
+{
+	Node	   *left,
+			   *right;
+	Var		   *var;
+	Const	   *c;
+	TypeCacheEntry *tce;
+	Oid			lefttype,
+				righttype;
+	int64		value;
+	int			strategy;
+	bool		commuted = false;
+
+	if (list_length(op->args) != 2)
+		return false;
+
+	left = linitial(op->args);
+	right = lsecond(op->args);
+
+	if (IsA(left, Var) && IsA(right, Const))
+	{
+		var = (Var *) left;
+		c = (Const *) right;
+	}
+	else if (IsA(right, Var) && IsA(left, Const))
+	{
+		var = (Var *) right;
+		c = (Const *) left;
+		commuted = true;
+	}
+	else
+		return false;
+
+	if (var->varno != rti || var->varlevelsup != 0 || var->varattno != time_attno ||
+		c->constisnull)
+		return false;
+
+	/*
+	 * Integer time columns can be compared with any integer constant, since
+	 * integers of all widths have the same internal time
+	 */
+	if (c->consttype != var->vartype &&
+		!(chunk_stats_type_is_integer(c->consttype) &&
+		  chunk_stats_type_is_integer(var->vartype)))
+		return false;
+
+	op_input_types(op->opno, &lefttype, &righttype);
+
+	if ((commuted ? righttype : lefttype) != var->vartype ||
+		(commuted ? lefttype : righttype) != c->consttype)
+		return false;
+
+	tce = lookup_type_cache(var->vartype, TYPECACHE_BTREE_OPFAMILY);
+
+	if (!OidIsValid(tce->btree_opf))
+		return false;
+
+	strategy = get_op_opfamily_strategy(op->opno, tce->btree_opf);
+
+	if (commuted)
+	{
+		switch (strategy)
+		{
+			case BTLessStrategyNumber:
+				strategy = BTGreaterStrategyNumber;
+				break;
+			case BTLessEqualStrategyNumber:
+				strategy = BTGreaterEqualStrategyNumber;
+				break;
+			case BTGreaterEqualStrategyNumber:
+				strategy = BTLessEqualStrategyNumber;
+				break;
+			case BTGreaterStrategyNumber:
+				strategy = BTLessStrategyNumber;
+				break;
+			default:
+				break;
+		}
+	}
+
+	if (!time_value_is_convertible(c->constvalue, c->consttype))
+		return false;
+
+	value = time_value_to_internal(c->constvalue, c->consttype);
+
+	switch (strategy)
+	{
+		case BTLessStrategyNumber:
+			return slice->fd.range_end <= value;
+		case BTLessEqualStrategyNumber:
+			return slice->fd.range_end - 1 <= value;
+		case BTGreaterEqualStrategyNumber:
+			return slice->fd.range_start >= value;
+		case BTGreaterStrategyNumber:
+			return slice->fd.range_start > value;
+		default:
+			return false;
+	}
+}
+
+/*
+ * Get the ID of the chunk that an append child relation scans if every row of
+ * the chunk satisfies the relation's restrictions, so that aggregates over
+ * the scan can be answered from the chunk's statistics. Returns 0 otherwise.
+ *
+ * Only restrictions on the time column are supported.
+ */
+int32
+chunk_stats_covered_chunk_id(PlannerInfo *root, Hypertable *ht, RelOptInfo *rel)
+{
+	Dimension  *dim = hyperspace_get_open_dimension(ht->space, 0);
+	RangeTblEntry *rte = planner_rt_fetch(rel->relid, root);
+	Hypercube  *cube;
+	DimensionSlice *slice;
+	AttrNumber	time_attno;
+	int32		chunk_id;
+	ListCell   *lc;
+
+	if (NULL == dim || NULL != dim->partitioning || rte->rtekind != RTE_RELATION)
+		return 0;
+
+	chunk_id = hypertable_get_chunk_id(ht, rte->relid);
+	cube = hypertable_get_chunk_cube(ht, rte->relid);
+
+	if (chunk_id <= 0 || NULL == cube)
+		return 0;
+
+	slice = hypercube_get_slice_by_dimension_id(cube, dim->fd.id);
+
+	if (NULL == slice)
+		return 0;
+
+	time_attno = get_attnum(rte->relid, NameStr(dim->fd.column_name));
+
+	foreach(lc, rel->baserestrictinfo)
+	{
+		RestrictInfo *rinfo = lfirst(lc);
+
+		if (!IsA(rinfo->clause, OpExpr) ||
+			!chunk_stats_clause_covers_slice((OpExpr *) rinfo->clause, rel->relid,
+											 time_attno, slice))
+			return 0;
+	}
+
+	return chunk_id;
+}
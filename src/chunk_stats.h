@@ -0,0 +1,27 @@
+#ifndef TIMESCALEDB_CHUNK_STATS_H
+#define TIMESCALEDB_CHUNK_STATS_H
+
+#include <postgres.h>
+#include <nodes/relation.h>
+#include <utils/snapshot.h>
+
+#include "catalog.h"
+#include "hypertable.h"
+
+#define CHUNK_STATS_INVALIDATE_TRIGGER_NAME "ts_chunk_stats_invalidate"
+#define CHUNK_STATS_INVALIDATE_TRUNCATE_TRIGGER_NAME "ts_chunk_stats_invalidate_truncate"
+
+/*
+ * The recorded statistics of a chunk that no longer receives writes. The
+ * min/max times are in internal time format and only valid if the chunk has
+ * rows.
+ */
+typedef FormData_chunk_stats ChunkStats;
+
+extern bool chunk_stats_get(int32 chunk_id, Snapshot snapshot, ChunkStats *stats);
+extern void chunk_stats_insert(ChunkStats *stats);
+extern int	chunk_stats_delete_by_chunk_id(int32 chunk_id);
+
+extern int32 chunk_stats_covered_chunk_id(PlannerInfo *root, Hypertable *ht, RelOptInfo *rel);
+
+#endif							/* TIMESCALEDB_CHUNK_STATS_H */
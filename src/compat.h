@@ -18,6 +18,10 @@
 	ParseFuncOrColumn(pstate, funcname, fargs, (pstate)->p_last_srf, fn, location)
 #define make_op_compat(pstate, opname, ltree, rtree, location)	\
 	make_op(pstate, opname, ltree, rtree, (pstate)->p_last_srf, location)
+#define ExecEvalExprCompat(state, econtext, isnull) \
+	ExecEvalExpr(state, econtext, isnull)
+#define create_index_path_compat(root, index, indexclauses, indexclausecols, indexorderbys, indexorderbycols, pathkeys, indexscandir, indexonly, required_outer, loop_count) \
+	create_index_path(root, index, indexclauses, indexclausecols, indexorderbys, indexorderbycols, pathkeys, indexscandir, indexonly, required_outer, loop_count, false)
 
 #elif PG96
 
@@ -33,6 +37,10 @@
 	ParseFuncOrColumn(pstate, funcname, fargs, fn, location)
 #define make_op_compat(pstate, opname, ltree, rtree, location)	\
 	make_op(pstate, opname, ltree, rtree, location)
+#define ExecEvalExprCompat(state, econtext, isnull) \
+	ExecEvalExpr(state, econtext, isnull, NULL)
+#define create_index_path_compat(root, index, indexclauses, indexclausecols, indexorderbys, indexorderbycols, pathkeys, indexscandir, indexonly, required_outer, loop_count) \
+	create_index_path(root, index, indexclauses, indexclausecols, indexorderbys, indexorderbycols, pathkeys, indexscandir, indexonly, required_outer, loop_count)
 
 #else
 
@@ -0,0 +1,1147 @@
+#include <postgres.h>
+#include <access/heapam.h>
+#include <access/htup_details.h>
+#include <access/xact.h>
+#include <catalog/dependency.h>
+#include <catalog/index.h>
+#include <catalog/namespace.h>
+#include <catalog/pg_class.h>
+#include <catalog/pg_inherits_fn.h>
+#include <catalog/pg_trigger.h>
+#include <catalog/pg_type.h>
+#include <commands/tablecmds.h>
+#include <commands/tablespace.h>
+#include <commands/trigger.h>
+#include <executor/tuptable.h>
+#include <miscadmin.h>
+#include <nodes/makefuncs.h>
+#include <parser/parse_oper.h>
+#include <storage/lmgr.h>
+#include <utils/array.h>
+#include <utils/builtins.h>
+#include <utils/datum.h>
+#include <utils/fmgroids.h>
+#include <utils/inval.h>
+#include <utils/lsyscache.h>
+#include <utils/memutils.h>
+#include <utils/rel.h>
+#include <utils/snapmgr.h>
+#include <utils/tuplesort.h>
+
+#include "compat.h"
+#include "catalog.h"
+#include "chunk.h"
+#include "chunk_stats.h"
+#include "compressed_chunk.h"
+#include "compression.h"
+#include "dimension.h"
+#include "hypertable.h"
+#include "hypertable_cache.h"
+#include "scanner.h"
+#include "utils.h"
+
+static List *
+name_array_to_list(ArrayType *arr)
+{
+	Datum	   *elems;
+	bool	   *nulls;
+	int			nelems;
+	int			i;
+	List	   *names = NIL;
+
+	deconstruct_array(arr, NAMEOID, NAMEDATALEN, false, 'c', &elems, &nulls, &nelems);
+
+	for (i = 0; i < nelems; i++)
+		if (!nulls[i])
+			names = lappend(names, pstrdup(NameStr(*DatumGetName(elems[i]))));
+
+	return names;
+}
+
+static ArrayType *
+name_list_to_array(List *names)
+{
+	Datum	   *elems;
+	ListCell   *lc;
+	int			i = 0;
+
+	if (names == NIL)
+		return construct_empty_array(NAMEOID);
+
+	elems = palloc(sizeof(Datum) * list_length(names));
+
+	foreach(lc, names)
+		elems[i++] = DirectFunctionCall1(namein, CStringGetDatum(lfirst(lc)));
+
+	return construct_array(elems, i, NAMEOID, NAMEDATALEN, false, 'c');
+}
+
+static bool
+name_list_member(List *names, const char *name)
+{
+	ListCell   *lc;
+
+	foreach(lc, names)
+		if (strcmp(lfirst(lc), name) == 0)
+			return true;
+
+	return false;
+}
+
+static CompressedChunk *
+compressed_chunk_from_tuple(HeapTuple tuple, TupleDesc desc)
+{
+	CompressedChunk *cc = palloc0(sizeof(CompressedChunk));
+	Datum		segment_by;
+	bool		isnull;
+	Oid			schemaid;
+
+	memcpy(&cc->fd, GETSTRUCT(tuple), sizeof(FormData_compressed_chunk));
+	segment_by = heap_getattr(tuple, Anum_compressed_chunk_segment_by, desc, &isnull);
+
+	if (!isnull)
+		cc->segment_by = name_array_to_list(DatumGetArrayTypeP(segment_by));
+
+	schemaid = get_namespace_oid(NameStr(cc->fd.schema_name), true);
+
+	if (OidIsValid(schemaid))
+		cc->compressed_relid = get_relname_relid(NameStr(cc->fd.table_name), schemaid);
+
+	return cc;
+}
+
+static bool
+compressed_chunk_tuple_found(TupleInfo *ti, void *data)
+{
+	CompressedChunk **cc = data;
+
+	*cc = compressed_chunk_from_tuple(ti->tuple, ti->desc);
+
+	return false;
+}
+
+static bool
+compressed_chunk_tuple_delete(TupleInfo *ti, void *data)
+{
+	CatalogSecurityContext sec_ctx;
+
+	catalog_become_owner(catalog_get(), &sec_ctx);
+	catalog_delete(ti->scanrel, ti->tuple);
+	catalog_restore_user(&sec_ctx);
+
+	return true;
+}
+
+static int
+compressed_chunk_scan_by_chunk_id(int32 chunk_id,
+								  tuple_found_func tuple_found,
+								  void *data,
+								  LOCKMODE lockmode)
+{
+	Catalog    *catalog = catalog_get();
+	ScanKeyData scankey[1];
+	ScannerCtx	scanctx = {
+		.table = catalog->tables[COMPRESSED_CHUNK].id,
+		.index = CATALOG_INDEX(catalog, COMPRESSED_CHUNK, COMPRESSED_CHUNK_PKEY_IDX),
+		.nkeys = 1,
+		.scankey = scankey,
+		.tuple_found = tuple_found,
+		.data = data,
+		.lockmode = lockmode,
+		.scandirection = ForwardScanDirection,
+	};
+
+	ScanKeyInit(&scankey[0], Anum_compressed_chunk_pkey_idx_chunk_id,
+				BTEqualStrategyNumber, F_INT4EQ, Int32GetDatum(chunk_id));
+
+	return scanner_scan(&scanctx);
+}
+
+CompressedChunk *
+compressed_chunk_get_by_chunk_id(int32 chunk_id)
+{
+	CompressedChunk *cc = NULL;
+
+	compressed_chunk_scan_by_chunk_id(chunk_id, compressed_chunk_tuple_found, &cc, AccessShareLock);
+
+	return cc;
+}
+
+/*
+ * Compressed chunk lookups by relid. The planner looks up every relation it
+ * scans, so the result, including that a relation is not a compressed chunk,
+ * is cached. Changes to the chunk and compressed_chunk catalog tables
+ * invalidate the cache together with the hypertable cache.
+ */
+typedef struct CompressedChunkCacheEntry
+{
+	Oid			chunk_relid;
+	CompressedChunk *cc;		/* NULL if not a compressed chunk */
+} CompressedChunkCacheEntry;
+
+static MemoryContext compressed_chunk_cache_mcxt = NULL;
+static HTAB *compressed_chunk_cache = NULL;
+
+void
+compressed_chunk_cache_invalidate(void)
+{
+	if (NULL != compressed_chunk_cache_mcxt)
+		MemoryContextDelete(compressed_chunk_cache_mcxt);
+
+	compressed_chunk_cache_mcxt = NULL;
+	compressed_chunk_cache = NULL;
+}
+
+static CompressedChunk *
+compressed_chunk_copy(CompressedChunk *cc)
+{
+	CompressedChunk *copy = palloc(sizeof(CompressedChunk));
+	ListCell   *lc;
+
+	memcpy(copy, cc, sizeof(CompressedChunk));
+	copy->segment_by = NIL;
+
+	foreach(lc, cc->segment_by)
+		copy->segment_by = lappend(copy->segment_by, pstrdup(lfirst(lc)));
+
+	return copy;
+}
+
+/*
+ * Get a compressed chunk by the relid of the chunk. Returns a copy that
+ * belongs to the caller, since an invalidation can reset the cache at any
+ * catalog access.
+ */
+CompressedChunk *
+compressed_chunk_get_by_relid(Oid chunk_relid)
+{
+	CompressedChunkCacheEntry *entry;
+	CompressedChunk *cc = NULL;
+	Chunk	   *chunk;
+	MemoryContext old_mcxt;
+
+	if (NULL != compressed_chunk_cache)
+	{
+		entry = hash_search(compressed_chunk_cache, &chunk_relid, HASH_FIND, NULL);
+
+		if (NULL != entry)
+			return NULL == entry->cc ? NULL : compressed_chunk_copy(entry->cc);
+	}
+
+	/*
+	 * Scan the catalog before setting up the cache, since the scans can
+	 * process invalidations that reset it
+	 */
+	chunk = chunk_get_by_relid(chunk_relid, 0, false);
+
+	if (NULL != chunk)
+		cc = compressed_chunk_get_by_chunk_id(chunk->fd.id);
+
+	if (NULL == compressed_chunk_cache)
+	{
+		HASHCTL		ctl = {
+			.keysize = sizeof(Oid),
+			.entrysize = sizeof(CompressedChunkCacheEntry),
+		};
+
+		compressed_chunk_cache_mcxt = AllocSetContextCreate(CacheMemoryContext,
+															"compressed chunk cache",
+															ALLOCSET_SMALL_SIZES);
+		ctl.hcxt = compressed_chunk_cache_mcxt;
+		compressed_chunk_cache = hash_create("compressed chunk cache", 64, &ctl,
+											 HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
+	}
+
+	old_mcxt = MemoryContextSwitchTo(compressed_chunk_cache_mcxt);
+	entry = hash_search(compressed_chunk_cache, &chunk_relid, HASH_ENTER, NULL);
+	entry->cc = NULL == cc ? NULL : compressed_chunk_copy(cc);
+	MemoryContextSwitchTo(old_mcxt);
+
+	return cc;
+}
+
+int
+compressed_chunk_delete_by_chunk_id(int32 chunk_id)
+{
+	return compressed_chunk_scan_by_chunk_id(chunk_id, compressed_chunk_tuple_delete, NULL, RowExclusiveLock);
+}
+
+/*
+ * Get the compressed chunks of a hypertable.
+ */
+List *
+compressed_chunk_get_by_hypertable(Hypertable *ht)
+{
+	List	   *compressed = NIL;
+	ListCell   *lc;
+
+	foreach(lc, find_inheritance_children(ht->main_table_relid, NoLock))
+	{
+		CompressedChunk *cc = compressed_chunk_get_by_relid(lfirst_oid(lc));
+
+		if (NULL != cc)
+			compressed = lappend(compressed, cc);
+	}
+
+	return compressed;
+}
+
+/*
+ * Drop a column of a hypertable from the compressed tables of its chunks.
+ *
+ * Compressed columns are matched to chunk columns by name, so a column that
+ * is added later under the same name would otherwise read the data of the
+ * dropped one. Segment_by columns cannot be dropped since the batches are
+ * grouped on them.
+ */
+void
+compressed_chunk_drop_column(Hypertable *ht, const char *column_name)
+{
+	ListCell   *lc;
+
+	foreach(lc, compressed_chunk_get_by_hypertable(ht))
+	{
+		CompressedChunk *cc = lfirst(lc);
+		AlterTableCmd cmd = {
+			.type = T_AlterTableCmd,
+			.subtype = AT_DropColumn,
+			.name = (char *) column_name,
+			.behavior = DROP_RESTRICT,
+			.missing_ok = true,
+		};
+
+		if (name_list_member(cc->segment_by, column_name))
+			ereport(ERROR,
+					(errcode(ERRCODE_IO_OPERATION_NOT_SUPPORTED),
+					 errmsg("cannot drop segment_by column \"%s\" of a compressed chunk",
+							column_name),
+					 errhint("Decompress the chunks with decompress_chunk() first.")));
+
+		if (OidIsValid(cc->compressed_relid))
+			AlterTableInternal(cc->compressed_relid, list_make1(&cmd), false);
+	}
+}
+
+static void
+compressed_chunk_insert(int32 chunk_id, const char *schema_name, const char *table_name, List *segment_by)
+{
+	Catalog    *catalog = catalog_get();
+	Relation	rel;
+	Datum		values[Natts_compressed_chunk];
+	bool		nulls[Natts_compressed_chunk] = {false};
+	CatalogSecurityContext sec_ctx;
+
+	rel = heap_open(catalog->tables[COMPRESSED_CHUNK].id, RowExclusiveLock);
+
+	values[Anum_compressed_chunk_chunk_id - 1] = Int32GetDatum(chunk_id);
+	values[Anum_compressed_chunk_schema_name - 1] =
+		DirectFunctionCall1(namein, CStringGetDatum(schema_name));
+	values[Anum_compressed_chunk_table_name - 1] =
+		DirectFunctionCall1(namein, CStringGetDatum(table_name));
+	values[Anum_compressed_chunk_segment_by - 1] =
+		PointerGetDatum(name_list_to_array(segment_by));
+
+	catalog_become_owner(catalog, &sec_ctx);
+	catalog_insert_values(rel, RelationGetDescr(rel), values, nulls);
+	catalog_restore_user(&sec_ctx);
+
+	heap_close(rel, RowExclusiveLock);
+}
+
+static AttrNumber
+tupdesc_get_attno(TupleDesc desc, const char *name)
+{
+	int			i;
+
+	for (i = 0; i < desc->natts; i++)
+	{
+		Form_pg_attribute attr = desc->attrs[i];
+
+		if (!attr->attisdropped && namestrcmp(&attr->attname, name) == 0)
+			return attr->attnum;
+	}
+
+	return InvalidAttrNumber;
+}
+
+/*
+ * Map the columns of a chunk to the columns of its compressed table.
+ *
+ * Columns are matched by name. Columns that were added to the chunk after it
+ * was compressed are not stored in the compressed table and read as NULL.
+ */
+CompressedColumnInfo *
+compressed_chunk_column_info(TupleDesc chunkdesc,
+							 TupleDesc compresseddesc,
+							 List *segment_by,
+							 AttrNumber *count_attno)
+{
+	CompressedColumnInfo *columns = palloc0(sizeof(CompressedColumnInfo) * chunkdesc->natts);
+	int			i;
+
+	for (i = 0; i < chunkdesc->natts; i++)
+	{
+		Form_pg_attribute attr = chunkdesc->attrs[i];
+
+		if (attr->attisdropped)
+			continue;
+
+		columns[i].typid = attr->atttypid;
+		columns[i].segment_by = name_list_member(segment_by, NameStr(attr->attname));
+		columns[i].compressed_attno = tupdesc_get_attno(compresseddesc, NameStr(attr->attname));
+	}
+
+	*count_attno = tupdesc_get_attno(compresseddesc, COMPRESSION_COUNT_COLUMN_NAME);
+
+	if (!AttributeNumberIsValid(*count_attno))
+		elog(ERROR, "compressed table is missing the \"%s\" column",
+			 COMPRESSION_COUNT_COLUMN_NAME);
+
+	return columns;
+}
+
+/*
+ * Decompress a row of the compressed table into one DecompressedColumn per
+ * chunk column. Returns the number of chunk rows in the batch.
+ *
+ * Segment_by values point into the compressed values, while decompressed
+ * values are allocated in the current memory context.
+ */
+int
+compressed_chunk_decompress_batch(CompressedColumnInfo *columns,
+								  int natts,
+								  AttrNumber count_attno,
+								  Datum *compressed_values,
+								  bool *compressed_nulls,
+								  DecompressedColumn *batch)
+{
+	int			num_rows;
+	int			i;
+
+	if (compressed_nulls[count_attno - 1])
+		elog(ERROR, "compressed batch has no row count");
+
+	num_rows = DatumGetInt32(compressed_values[count_attno - 1]);
+
+	for (i = 0; i < natts; i++)
+	{
+		CompressedColumnInfo *info = &columns[i];
+		DecompressedColumn *column = &batch[i];
+		AttrNumber	attno = info->compressed_attno;
+
+		if (!AttributeNumberIsValid(attno) || (!info->segment_by && compressed_nulls[attno - 1]))
+		{
+			column->num_rows = 0;
+			column->values = NULL;
+			column->nulls = NULL;
+		}
+		else if (info->segment_by)
+		{
+			column->num_rows = 1;
+			column->values = &compressed_values[attno - 1];
+			column->nulls = &compressed_nulls[attno - 1];
+		}
+		else
+		{
+			decompress_column((bytea *) PG_DETOAST_DATUM(compressed_values[attno - 1]),
+							  info->typid, column);
+
+			if (column->num_rows != num_rows)
+				ereport(ERROR,
+						(errcode(ERRCODE_DATA_CORRUPTED),
+						 errmsg("compressed data is corrupt")));
+		}
+	}
+
+	return num_rows;
+}
+
+/*
+ * Create the table that holds the compressed data of a chunk.
+ *
+ * Like the chunk itself, the table is created as the catalog owner if it is
+ * in the internal schema, but it is owned by the chunk's owner. The table
+ * depends internally on the chunk, so that it is dropped along with the chunk
+ * and cannot be dropped on its own.
+ */
+static Oid
+compressed_table_create(Relation chunk_rel, const char *table_name, List *segment_by)
+{
+	Catalog    *catalog = catalog_get();
+	TupleDesc	chunkdesc = RelationGetDescr(chunk_rel);
+	char	   *schema_name = get_namespace_name(RelationGetNamespace(chunk_rel));
+	List	   *elts = NIL;
+	ColumnDef  *coldef;
+	ObjectAddress objaddr;
+	ObjectAddress chunkaddr = {
+		.classId = RelationRelationId,
+		.objectId = RelationGetRelid(chunk_rel),
+	};
+	CreateStmt	stmt = {
+		.type = T_CreateStmt,
+		.relation = makeRangeVar(schema_name, pstrdup(table_name), 0),
+		.oncommit = ONCOMMIT_NOOP,
+	};
+	Oid			uid,
+				saved_uid;
+	int			sec_ctx;
+	int			i;
+
+	for (i = 0; i < chunkdesc->natts; i++)
+	{
+		Form_pg_attribute attr = chunkdesc->attrs[i];
+
+		if (attr->attisdropped)
+			continue;
+
+		coldef = makeNode(ColumnDef);
+		coldef->colname = pstrdup(NameStr(attr->attname));
+		coldef->is_local = true;
+		coldef->location = -1;
+
+		if (name_list_member(segment_by, NameStr(attr->attname)))
+		{
+			coldef->typeName = makeTypeNameFromOid(attr->atttypid, attr->atttypmod);
+			coldef->collOid = attr->attcollation;
+		}
+		else
+			coldef->typeName = makeTypeNameFromOid(BYTEAOID, -1);
+
+		elts = lappend(elts, coldef);
+	}
+
+	coldef = makeNode(ColumnDef);
+	coldef->colname = COMPRESSION_COUNT_COLUMN_NAME;
+	coldef->typeName = makeTypeNameFromOid(INT4OID, -1);
+	coldef->is_local = true;
+	coldef->is_not_null = true;
+	coldef->location = -1;
+	stmt.tableElts = lappend(elts, coldef);
+
+	if (OidIsValid(chunk_rel->rd_rel->reltablespace))
+		stmt.tablespacename = get_tablespace_name(chunk_rel->rd_rel->reltablespace);
+
+	if (strcmp(schema_name, INTERNAL_SCHEMA_NAME) == 0)
+		uid = catalog->owner_uid;
+	else
+		uid = chunk_rel->rd_rel->relowner;
+
+	GetUserIdAndSecContext(&saved_uid, &sec_ctx);
+
+	if (uid != saved_uid)
+		SetUserIdAndSecContext(uid, sec_ctx | SECURITY_LOCAL_USERID_CHANGE);
+
+	objaddr = DefineRelation(&stmt,
+							 RELKIND_RELATION,
+							 chunk_rel->rd_rel->relowner,
+							 NULL
+#if PG10
+							 ,NULL
+#endif
+		);
+
+	if (uid != saved_uid)
+		SetUserIdAndSecContext(saved_uid, sec_ctx);
+
+	recordDependencyOn(&objaddr, &chunkaddr, DEPENDENCY_INTERNAL);
+	CommandCounterIncrement();
+
+	return objaddr.objectId;
+}
+
+static void
+compressed_table_drop(Oid compressed_relid)
+{
+	ObjectAddress objaddr = {
+		.classId = RelationRelationId,
+		.objectId = compressed_relid,
+	};
+
+	/* Remove the internal dependency on the chunk so that the table can go */
+	deleteDependencyRecordsForClass(RelationRelationId, compressed_relid,
+									RelationRelationId, DEPENDENCY_INTERNAL);
+	CommandCounterIncrement();
+	performDeletion(&objaddr, DROP_RESTRICT, 0);
+}
+
+typedef struct CompressColumn
+{
+	AttrNumber	chunk_attno;
+	AttrNumber	compressed_attno;
+	int16		typlen;
+	bool		typbyval;
+	bool		segment_by;
+	Compressor *compressor;
+	Datum		segment_value;
+	bool		segment_isnull;
+} CompressColumn;
+
+typedef struct CompressState
+{
+	Relation	compressed_rel;
+	BulkInsertState bistate;
+	CommandId	mycid;
+	CompressColumn *columns;
+	int			num_columns;
+	AttrNumber	count_attno;
+	int32		batch_rows;
+	MemoryContext batch_context;
+} CompressState;
+
+static bool
+compress_state_segment_changed(CompressState *cs, TupleTableSlot *slot)
+{
+	int			i;
+
+	for (i = 0; i < cs->num_columns; i++)
+	{
+		CompressColumn *col = &cs->columns[i];
+		Datum		value = slot->tts_values[col->chunk_attno - 1];
+		bool		isnull = slot->tts_isnull[col->chunk_attno - 1];
+
+		if (!col->segment_by)
+			continue;
+
+		if (isnull != col->segment_isnull)
+			return true;
+
+		if (!isnull && !datumIsEqual(value, col->segment_value, col->typbyval, col->typlen))
+			return true;
+	}
+
+	return false;
+}
+
+static void
+compress_state_start_batch(CompressState *cs, TupleTableSlot *slot)
+{
+	MemoryContext old = MemoryContextSwitchTo(cs->batch_context);
+	int			i;
+
+	for (i = 0; i < cs->num_columns; i++)
+	{
+		CompressColumn *col = &cs->columns[i];
+
+		if (col->segment_by)
+		{
+			col->segment_isnull = slot->tts_isnull[col->chunk_attno - 1];
+			col->segment_value = col->segment_isnull ? (Datum) 0 :
+				datumCopy(slot->tts_values[col->chunk_attno - 1], col->typbyval, col->typlen);
+		}
+		else
+			col->compressor = compressor_create(slot->tts_tupleDescriptor->attrs[col->chunk_attno - 1]->atttypid);
+	}
+
+	MemoryContextSwitchTo(old);
+}
+
+static void
+compress_state_flush_batch(CompressState *cs)
+{
+	TupleDesc	desc = RelationGetDescr(cs->compressed_rel);
+	Datum	   *values = palloc0(sizeof(Datum) * desc->natts);
+	bool	   *nulls = palloc(sizeof(bool) * desc->natts);
+	MemoryContext old = MemoryContextSwitchTo(cs->batch_context);
+	HeapTuple	tuple;
+	int			i;
+
+	memset(nulls, true, sizeof(bool) * desc->natts);
+
+	for (i = 0; i < cs->num_columns; i++)
+	{
+		CompressColumn *col = &cs->columns[i];
+		AttrNumber	attno = col->compressed_attno;
+
+		if (col->segment_by)
+		{
+			values[attno - 1] = col->segment_value;
+			nulls[attno - 1] = col->segment_isnull;
+		}
+		else
+		{
+			values[attno - 1] = PointerGetDatum(compressor_finish(col->compressor));
+			nulls[attno - 1] = false;
+		}
+	}
+
+	values[cs->count_attno - 1] = Int32GetDatum(cs->batch_rows);
+	nulls[cs->count_attno - 1] = false;
+
+	tuple = heap_form_tuple(desc, values, nulls);
+	heap_insert(cs->compressed_rel, tuple, cs->mycid, 0, cs->bistate);
+
+	MemoryContextSwitchTo(old);
+	MemoryContextReset(cs->batch_context);
+	pfree(values);
+	pfree(nulls);
+	cs->batch_rows = 0;
+}
+
+static void
+compress_state_append(CompressState *cs, TupleTableSlot *slot)
+{
+	MemoryContext old;
+	int			i;
+
+	if (cs->batch_rows > 0 &&
+		(cs->batch_rows >= COMPRESSION_BATCH_MAX_ROWS ||
+		 compress_state_segment_changed(cs, slot)))
+		compress_state_flush_batch(cs);
+
+	if (cs->batch_rows == 0)
+		compress_state_start_batch(cs, slot);
+
+	old = MemoryContextSwitchTo(cs->batch_context);
+
+	for (i = 0; i < cs->num_columns; i++)
+	{
+		CompressColumn *col = &cs->columns[i];
+
+		if (!col->segment_by)
+			compressor_append(col->compressor,
+							  slot->tts_values[col->chunk_attno - 1],
+							  slot->tts_isnull[col->chunk_attno - 1]);
+	}
+
+	MemoryContextSwitchTo(old);
+	cs->batch_rows++;
+}
+
+/*
+ * Move the rows of the chunk into the compressed table.
+ *
+ * The rows are sorted on the segment_by columns and then on time, so that
+ * each batch covers a single segment and the time column compresses well.
+ */
+static void
+compress_chunk_rows(Relation chunk_rel, Relation compressed_rel, List *segment_by, AttrNumber time_attno)
+{
+	TupleDesc	chunkdesc = RelationGetDescr(chunk_rel);
+	TupleDesc	compresseddesc = RelationGetDescr(compressed_rel);
+	int			nkeys = list_length(segment_by) + 1;
+	AttrNumber *sort_attnos = palloc(sizeof(AttrNumber) * nkeys);
+	Oid		   *sort_ops = palloc(sizeof(Oid) * nkeys);
+	Oid		   *sort_collations = palloc(sizeof(Oid) * nkeys);
+	bool	   *nulls_first = palloc0(sizeof(bool) * nkeys);
+	CompressState cs = {
+		.compressed_rel = compressed_rel,
+		.bistate = GetBulkInsertState(),
+		.mycid = GetCurrentCommandId(true),
+		.columns = palloc0(sizeof(CompressColumn) * chunkdesc->natts),
+		.batch_context = AllocSetContextCreate(CurrentMemoryContext,
+											   "compression batch",
+											   ALLOCSET_DEFAULT_SIZES),
+	};
+	Tuplesortstate *sortstate;
+	TupleTableSlot *slot;
+	HeapScanDesc scan;
+	HeapTuple	tuple;
+	Snapshot	snapshot;
+	ListCell   *lc;
+	int			i;
+
+	i = 0;
+	foreach(lc, segment_by)
+		sort_attnos[i++] = get_attnum(RelationGetRelid(chunk_rel), lfirst(lc));
+	sort_attnos[i] = time_attno;
+
+	for (i = 0; i < nkeys; i++)
+	{
+		Form_pg_attribute attr = chunkdesc->attrs[sort_attnos[i] - 1];
+
+		get_sort_group_operators(attr->atttypid, true, false, false,
+								 &sort_ops[i], NULL, NULL, NULL);
+		sort_collations[i] = attr->attcollation;
+	}
+
+	for (i = 0; i < chunkdesc->natts; i++)
+	{
+		Form_pg_attribute attr = chunkdesc->attrs[i];
+		CompressColumn *col;
+
+		if (attr->attisdropped)
+			continue;
+
+		col = &cs.columns[cs.num_columns++];
+		col->chunk_attno = attr->attnum;
+		col->compressed_attno = tupdesc_get_attno(compresseddesc, NameStr(attr->attname));
+		col->typlen = attr->attlen;
+		col->typbyval = attr->attbyval;
+		col->segment_by = name_list_member(segment_by, NameStr(attr->attname));
+	}
+
+	cs.count_attno = tupdesc_get_attno(compresseddesc, COMPRESSION_COUNT_COLUMN_NAME);
+
+	sortstate = tuplesort_begin_heap(chunkdesc, nkeys, sort_attnos, sort_ops,
+									 sort_collations, nulls_first,
+									 maintenance_work_mem, false);
+	slot = MakeSingleTupleTableSlot(chunkdesc);
+	snapshot = RegisterSnapshot(GetLatestSnapshot());
+	scan = heap_beginscan(chunk_rel, snapshot, 0, NULL);
+
+	while ((tuple = heap_getnext(scan, ForwardScanDirection)) != NULL)
+	{
+		ExecStoreTuple(tuple, slot, InvalidBuffer, false);
+		tuplesort_puttupleslot(sortstate, slot);
+	}
+
+	heap_endscan(scan);
+	UnregisterSnapshot(snapshot);
+
+	tuplesort_performsort(sortstate);
+
+#if PG10
+	while (tuplesort_gettupleslot(sortstate, true, false, slot, NULL))
+#elif PG96
+	while (tuplesort_gettupleslot(sortstate, true, slot, NULL))
+#endif
+	{
+		slot_getallattrs(slot);
+		compress_state_append(&cs, slot);
+	}
+
+	if (cs.batch_rows > 0)
+		compress_state_flush_batch(&cs);
+
+	tuplesort_end(sortstate);
+	ExecDropSingleTupleTableSlot(slot);
+	FreeBulkInsertState(cs.bistate);
+	MemoryContextDelete(cs.batch_context);
+}
+
+static void
+truncate_chunk(Oid chunk_relid)
+{
+	RangeVar	rv = {
+		.schemaname = get_namespace_name(get_rel_namespace(chunk_relid)),
+		.relname = get_rel_name(chunk_relid),
+#if PG10
+		.inh = false,
+#elif PG96
+		.inhOpt = INH_NO,
+#endif
+	};
+	TruncateStmt stmt = {
+		.type = T_TruncateStmt,
+		.relations = list_make1(&rv),
+		.behavior = DROP_RESTRICT,
+	};
+
+	ExecuteTruncate(&stmt);
+}
+
+/*
+ * Block trigger.
+ *
+ * The rows of a compressed chunk live in its compressed table, so writes to
+ * the chunk's own table would not be visible to scans and would be lost on
+ * decompression. Inserts through the hypertable are refused by the chunk
+ * dispatch, while this trigger refuses direct writes to the chunk, including
+ * COPY.
+ */
+
+static void
+compressed_chunk_block_trigger_create(Oid chunk_relid)
+{
+	CreateTrigStmt stmt = {
+		.type = T_CreateTrigStmt,
+		.trigname = COMPRESSED_CHUNK_BLOCK_TRIGGER_NAME,
+		.relation = makeRangeVarFromRelid(chunk_relid),
+		.funcname = list_make2(makeString(INTERNAL_SCHEMA_NAME), makeString("compressed_chunk_block_trigger")),
+		.args = NIL,
+		.row = false,
+		.timing = TRIGGER_TYPE_BEFORE,
+		.events = TRIGGER_TYPE_INSERT | TRIGGER_TYPE_UPDATE | TRIGGER_TYPE_DELETE,
+		.columns = NIL,
+		.whenClause = NULL,
+		.isconstraint = false,
+	};
+
+	if (OidIsValid(get_trigger_oid(chunk_relid, COMPRESSED_CHUNK_BLOCK_TRIGGER_NAME, true)))
+		return;
+
+	CreateTrigger(&stmt, NULL, InvalidOid, InvalidOid, InvalidOid, InvalidOid, false);
+	CommandCounterIncrement();
+}
+
+static void
+compressed_chunk_block_trigger_drop(Oid chunk_relid)
+{
+	ObjectAddress address = {
+		.classId = TriggerRelationId,
+		.objectId = get_trigger_oid(chunk_relid, COMPRESSED_CHUNK_BLOCK_TRIGGER_NAME, true),
+	};
+
+	if (OidIsValid(address.objectId))
+		performDeletion(&address, DROP_RESTRICT, 0);
+}
+
+/*
+ * Statement trigger that refuses inserts into, updates of and deletes from a
+ * compressed chunk.
+ */
+TS_FUNCTION_INFO_V1(compressed_chunk_block_trigger);
+
+Datum
+compressed_chunk_block_trigger(PG_FUNCTION_ARGS)
+{
+	TriggerData *trigdata = (TriggerData *) fcinfo->context;
+
+	if (!CALLED_AS_TRIGGER(fcinfo))
+		elog(ERROR, "compressed_chunk_block_trigger: not called by trigger manager");
+
+	if (!TRIGGER_FIRED_BEFORE(trigdata->tg_event) || TRIGGER_FIRED_FOR_ROW(trigdata->tg_event))
+		elog(ERROR, "compressed_chunk_block_trigger: must be fired BEFORE STATEMENT");
+
+	if (TRIGGER_FIRED_BY_INSERT(trigdata->tg_event))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("cannot insert into compressed chunk \"%s\"",
+						RelationGetRelationName(trigdata->tg_relation)),
+				 errhint("Decompress the chunk with decompress_chunk() first.")));
+
+	ereport(ERROR,
+			(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+			 errmsg("cannot modify compressed chunk \"%s\"",
+					RelationGetRelationName(trigdata->tg_relation)),
+			 errhint("Decompress the chunk with decompress_chunk() first.")));
+
+	return PointerGetDatum(NULL);
+}
+
+static Chunk *
+compressed_chunk_lookup_chunk(Oid chunk_relid)
+{
+	Chunk	   *chunk;
+
+	if (!OidIsValid(chunk_relid))
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("invalid chunk")));
+
+	chunk = chunk_get_by_relid(chunk_relid, 0, false);
+
+	if (NULL == chunk)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("\"%s\" is not a chunk", get_rel_name(chunk_relid))));
+
+	hypertable_permissions_check(chunk_relid, GetUserId());
+
+	/* Block reads and writes on the chunk while its data is moved */
+	LockRelationOid(chunk_relid, AccessExclusiveLock);
+
+	return chunk;
+}
+
+static List *
+compress_chunk_validate_segment_by(Chunk *chunk, ArrayType *segment_by_arr, AttrNumber time_attno)
+{
+	List	   *segment_by = NIL;
+	ListCell   *lc;
+
+	if (NULL == segment_by_arr)
+		return NIL;
+
+	foreach(lc, name_array_to_list(segment_by_arr))
+	{
+		char	   *colname = lfirst(lc);
+		AttrNumber	attno = get_attnum(chunk->table_id, colname);
+
+		if (!AttributeNumberIsValid(attno))
+			ereport(ERROR,
+					(errcode(ERRCODE_UNDEFINED_COLUMN),
+					 errmsg("column \"%s\" does not exist", colname)));
+
+		if (attno == time_attno)
+			ereport(ERROR,
+					(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+					 errmsg("cannot segment by the time column \"%s\"", colname)));
+
+		if (name_list_member(segment_by, colname))
+			ereport(ERROR,
+					(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+					 errmsg("column \"%s\" specified more than once in segment_by", colname)));
+
+		segment_by = lappend(segment_by, colname);
+	}
+
+	return segment_by;
+}
+
+/*
+ * Compress a chunk.
+ *
+ * The chunk's rows are moved into a new table in columnar, compressed form and
+ * the chunk's own table is truncated. The chunk keeps its catalog entry and
+ * constraints, so it is still excluded and expanded like any other chunk, but
+ * scans of it go through the DecompressChunk node. Inserts into compressed
+ * chunks are not supported.
+ */
+TS_FUNCTION_INFO_V1(compressed_chunk_compress);
+
+Datum
+compressed_chunk_compress(PG_FUNCTION_ARGS)
+{
+	Oid			chunk_relid = PG_ARGISNULL(0) ? InvalidOid : PG_GETARG_OID(0);
+	ArrayType  *segment_by_arr = PG_ARGISNULL(1) ? NULL : PG_GETARG_ARRAYTYPE_P(1);
+	Chunk	   *chunk = compressed_chunk_lookup_chunk(chunk_relid);
+	Cache	   *hcache;
+	Hypertable *ht;
+	Dimension  *time_dim;
+	AttrNumber	time_attno;
+	List	   *segment_by;
+	Relation	chunk_rel;
+	Relation	compressed_rel;
+	Oid			compressed_relid;
+	char		table_name[NAMEDATALEN];
+	ChunkStats	stats;
+	bool		has_stats;
+
+	if (compressed_chunk_get_by_chunk_id(chunk->fd.id) != NULL)
+		ereport(ERROR,
+				(errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
+				 errmsg("chunk \"%s\" is already compressed", get_rel_name(chunk_relid))));
+
+	hcache = hypertable_cache_pin();
+	ht = hypertable_cache_get_entry_by_id(hcache, chunk->fd.hypertable_id);
+	time_dim = hyperspace_get_open_dimension(ht->space, 0);
+	time_attno = get_attnum(chunk_relid, NameStr(time_dim->fd.column_name));
+	cache_release(hcache);
+
+	if (get_attnum(chunk_relid, COMPRESSION_COUNT_COLUMN_NAME) != InvalidAttrNumber)
+		ereport(ERROR,
+				(errcode(ERRCODE_DUPLICATE_COLUMN),
+				 errmsg("cannot compress chunk \"%s\" with a column named \"%s\"",
+						get_rel_name(chunk_relid), COMPRESSION_COUNT_COLUMN_NAME)));
+
+	segment_by = compress_chunk_validate_segment_by(chunk, segment_by_arr, time_attno);
+
+	snprintf(table_name, NAMEDATALEN, "_compressed_chunk_%d", chunk->fd.id);
+
+	chunk_rel = heap_open(chunk_relid, NoLock);
+	compressed_relid = compressed_table_create(chunk_rel, table_name, segment_by);
+	compressed_rel = heap_open(compressed_relid, AccessExclusiveLock);
+
+	compress_chunk_rows(chunk_rel, compressed_rel, segment_by, time_attno);
+
+	heap_close(compressed_rel, NoLock);
+	heap_close(chunk_rel, NoLock);
+
+	/*
+	 * The chunk's rows do not change, so keep the statistics that truncating
+	 * the chunk removes
+	 */
+	has_stats = chunk_stats_get(chunk->fd.id, NULL, &stats);
+
+	truncate_chunk(chunk_relid);
+
+	if (has_stats)
+		chunk_stats_insert(&stats);
+
+	compressed_chunk_insert(chunk->fd.id,
+							get_namespace_name(get_rel_namespace(compressed_relid)),
+							table_name,
+							segment_by);
+
+	compressed_chunk_block_trigger_create(chunk_relid);
+
+	/* Invalidate plans that scan the chunk's heap directly */
+	CacheInvalidateRelcacheByRelid(chunk_relid);
+
+	PG_RETURN_VOID();
+}
+
+/*
+ * Decompress a chunk, moving its rows back into the chunk's table and
+ * dropping the compressed table.
+ */
+TS_FUNCTION_INFO_V1(compressed_chunk_decompress);
+
+Datum
+compressed_chunk_decompress(PG_FUNCTION_ARGS)
+{
+	Oid			chunk_relid = PG_ARGISNULL(0) ? InvalidOid : PG_GETARG_OID(0);
+	Chunk	   *chunk = compressed_chunk_lookup_chunk(chunk_relid);
+	CompressedChunk *cc = compressed_chunk_get_by_chunk_id(chunk->fd.id);
+	Relation	chunk_rel;
+	Relation	compressed_rel;
+	TupleDesc	chunkdesc;
+	TupleDesc	compresseddesc;
+	CompressedColumnInfo *columns;
+	AttrNumber	count_attno;
+	DecompressedColumn *batch;
+	Datum	   *compressed_values;
+	bool	   *compressed_nulls;
+	Datum	   *values;
+	bool	   *nulls;
+	BulkInsertState bistate;
+	CommandId	mycid = GetCurrentCommandId(true);
+	MemoryContext batch_context;
+	MemoryContext old;
+	HeapScanDesc scan;
+	HeapTuple	tuple;
+	Snapshot	snapshot;
+
+	if (NULL == cc)
+		ereport(ERROR,
+				(errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
+				 errmsg("chunk \"%s\" is not compressed", get_rel_name(chunk_relid))));
+
+	chunk_rel = heap_open(chunk_relid, NoLock);
+	compressed_rel = heap_open(cc->compressed_relid, AccessExclusiveLock);
+	chunkdesc = RelationGetDescr(chunk_rel);
+	compresseddesc = RelationGetDescr(compressed_rel);
+	columns = compressed_chunk_column_info(chunkdesc, compresseddesc, cc->segment_by, &count_attno);
+	batch = palloc(sizeof(DecompressedColumn) * chunkdesc->natts);
+	compressed_values = palloc(sizeof(Datum) * compresseddesc->natts);
+	compressed_nulls = palloc(sizeof(bool) * compresseddesc->natts);
+	values = palloc(sizeof(Datum) * chunkdesc->natts);
+	nulls = palloc(sizeof(bool) * chunkdesc->natts);
+	batch_context = AllocSetContextCreate(CurrentMemoryContext,
+										  "decompression batch",
+										  ALLOCSET_DEFAULT_SIZES);
+	bistate = GetBulkInsertState();
+	snapshot = RegisterSnapshot(GetLatestSnapshot());
+	scan = heap_beginscan(compressed_rel, snapshot, 0, NULL);
+
+	while ((tuple = heap_getnext(scan, ForwardScanDirection)) != NULL)
+	{
+		int			num_rows;
+		int			row;
+		int			i;
+
+		old = MemoryContextSwitchTo(batch_context);
+		heap_deform_tuple(tuple, compresseddesc, compressed_values, compressed_nulls);
+		num_rows = compressed_chunk_decompress_batch(columns, chunkdesc->natts, count_attno,
+													 compressed_values, compressed_nulls, batch);
+
+		for (row = 0; row < num_rows; row++)
+		{
+			for (i = 0; i < chunkdesc->natts; i++)
+				decompressed_column_get(&batch[i], row, &values[i], &nulls[i]);
+
+			heap_insert(chunk_rel, heap_form_tuple(chunkdesc, values, nulls), mycid, 0, bistate);
+		}
+
+		MemoryContextSwitchTo(old);
+		MemoryContextReset(batch_context);
+	}
+
+	heap_endscan(scan);
+	UnregisterSnapshot(snapshot);
+	FreeBulkInsertState(bistate);
+	MemoryContextDelete(batch_context);
+	heap_close(compressed_rel, NoLock);
+	heap_close(chunk_rel, NoLock);
+
+	/* The indexes were emptied when the chunk was compressed */
+	reindex_relation(chunk_relid, 0, 0);
+
+	compressed_chunk_block_trigger_drop(chunk_relid);
+	compressed_chunk_delete_by_chunk_id(chunk->fd.id);
+	compressed_table_drop(cc->compressed_relid);
+	CacheInvalidateRelcacheByRelid(chunk_relid);
+
+	PG_RETURN_VOID();
+}
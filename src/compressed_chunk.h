@@ -0,0 +1,85 @@
+#ifndef TIMESCALEDB_COMPRESSED_CHUNK_H
+#define TIMESCALEDB_COMPRESSED_CHUNK_H
+
+#include <postgres.h>
+#include <access/attnum.h>
+#include <access/tupdesc.h>
+#include <nodes/pg_list.h>
+
+#include "catalog.h"
+#include "compression.h"
+#include "hypertable.h"
+
+/* Maximum number of chunk rows stored in one row of the compressed table */
+#define COMPRESSION_BATCH_MAX_ROWS 1000
+
+/* Column of the compressed table that holds the number of rows in a batch */
+#define COMPRESSION_COUNT_COLUMN_NAME "_ts_meta_count"
+
+/* Trigger that blocks direct writes to a compressed chunk */
+#define COMPRESSED_CHUNK_BLOCK_TRIGGER_NAME "ts_compressed_chunk_block"
+
+/*
+ * A compressed chunk keeps its rows in a separate table. Each row of that
+ * table is a batch of up to COMPRESSION_BATCH_MAX_ROWS chunk rows that have
+ * the same values in the segment_by columns. The segment_by columns are
+ * stored as is, while every other column is stored as a compressed bytea
+ * under the same name.
+ */
+typedef struct CompressedChunk
+{
+	FormData_compressed_chunk fd;
+	List	   *segment_by;		/* segment_by column names (char *) */
+	Oid			compressed_relid;
+} CompressedChunk;
+
+/*
+ * Describes how a chunk column is stored in the compressed table. Indexed by
+ * the chunk's attribute number minus one.
+ */
+typedef struct CompressedColumnInfo
+{
+	AttrNumber	compressed_attno;	/* InvalidAttrNumber if not stored */
+	Oid			typid;
+	bool		segment_by;
+} CompressedColumnInfo;
+
+extern CompressedChunk *compressed_chunk_get_by_chunk_id(int32 chunk_id);
+extern CompressedChunk *compressed_chunk_get_by_relid(Oid chunk_relid);
+extern void compressed_chunk_cache_invalidate(void);
+extern int	compressed_chunk_delete_by_chunk_id(int32 chunk_id);
+extern List *compressed_chunk_get_by_hypertable(Hypertable *ht);
+extern void compressed_chunk_drop_column(Hypertable *ht, const char *column_name);
+extern CompressedColumnInfo *compressed_chunk_column_info(TupleDesc chunkdesc,
+							 TupleDesc compresseddesc,
+							 List *segment_by,
+							 AttrNumber *count_attno);
+extern int compressed_chunk_decompress_batch(CompressedColumnInfo *columns,
+								  int natts,
+								  AttrNumber count_attno,
+								  Datum *compressed_values,
+								  bool *compressed_nulls,
+								  DecompressedColumn *batch);
+
+/*
+ * Get the value of a row in a decompressed batch column. Segment_by columns
+ * hold a single value for the whole batch and columns that are not stored in
+ * the compressed table hold no values at all.
+ */
+static inline void
+decompressed_column_get(DecompressedColumn *column, int row, Datum *value, bool *isnull)
+{
+	int			i = column->num_rows == 1 ? 0 : row;
+
+	if (column->num_rows == 0)
+	{
+		*value = (Datum) 0;
+		*isnull = true;
+		return;
+	}
+
+	*value = column->values[i];
+	*isnull = column->nulls[i];
+}
+
+#endif							/* TIMESCALEDB_COMPRESSED_CHUNK_H */
@@ -0,0 +1,851 @@
+#include <postgres.h>
+#include <fmgr.h>
+#include <access/tupmacs.h>
+#include <catalog/pg_type.h>
+#include <lib/stringinfo.h>
+#include <utils/lsyscache.h>
+
+#include "compression.h"
+
+/* An unsigned 64-bit varint needs at most 10 bytes with 7 bits per byte */
+#define VARINT_MAX_BYTES 10
+
+/* Number of bits used to store the leading zeros and the length of the
+ * meaningful bits in the Gorilla encoding */
+#define GORILLA_WIDTH_BITS 6
+
+struct Compressor
+{
+	CompressionAlgorithm algorithm;
+	Oid			typid;
+	int16		typlen;
+	bool		typbyval;
+	int32		num_rows;
+	int32		num_values;
+	bool		has_nulls;
+	StringInfoData nulls;
+	StringInfoData payload;
+
+	/* delta-of-delta and Gorilla */
+	uint64		prev_value;
+	uint64		prev_delta;
+
+	/* Gorilla bit packing */
+	uint8		current_byte;
+	int			bits_used;
+	int			prev_leading;
+	int			prev_trailing;
+
+	/* dictionary */
+	StringInfoData entries;
+	int32		num_entries;
+	int32		max_entries;
+	int32	   *entry_offsets;
+	int32	   *entry_lengths;
+	StringInfoData scratch;
+	StringInfoData runs;
+	int32		run_index;
+	int32		run_length;
+};
+
+typedef struct ByteReader
+{
+	const uint8 *data;
+	Size		len;
+	Size		pos;
+	int			bitpos;
+} ByteReader;
+
+static const char *compression_algorithm_names[_MAX_COMPRESSION_ALGORITHMS] = {
+	[COMPRESSION_ALGORITHM_NONE] = "none",
+	[COMPRESSION_ALGORITHM_DELTADELTA] = "deltadelta",
+	[COMPRESSION_ALGORITHM_GORILLA] = "gorilla",
+	[COMPRESSION_ALGORITHM_DICTIONARY] = "dictionary",
+};
+
+CompressionAlgorithm
+compression_algorithm_for_type(Oid typid)
+{
+	switch (typid)
+	{
+		case INT2OID:
+		case INT4OID:
+		case INT8OID:
+		case DATEOID:
+		case TIMESTAMPOID:
+		case TIMESTAMPTZOID:
+			return COMPRESSION_ALGORITHM_DELTADELTA;
+		case FLOAT4OID:
+		case FLOAT8OID:
+			return COMPRESSION_ALGORITHM_GORILLA;
+		default:
+			return COMPRESSION_ALGORITHM_DICTIONARY;
+	}
+}
+
+const char *
+compression_algorithm_name(CompressionAlgorithm algorithm)
+{
+	Assert(algorithm < _MAX_COMPRESSION_ALGORITHMS);
+	return compression_algorithm_names[algorithm];
+}
+
+static void
+compressed_data_corrupt(void)
+{
+	ereport(ERROR,
+			(errcode(ERRCODE_DATA_CORRUPTED),
+			 errmsg("compressed data is corrupt")));
+}
+
+static inline void
+reader_check(ByteReader *reader, Size needed)
+{
+	if (reader->pos + needed > reader->len)
+		compressed_data_corrupt();
+}
+
+static inline uint64
+zigzag_encode(int64 value)
+{
+	return ((uint64) value << 1) ^ (uint64) (value >> 63);
+}
+
+static inline int64
+zigzag_decode(uint64 value)
+{
+	return (int64) ((value >> 1) ^ (~(value & 1) + 1));
+}
+
+static void
+append_varint(StringInfo buf, uint64 value)
+{
+	char		bytes[VARINT_MAX_BYTES];
+	int			len = 0;
+
+	do
+	{
+		uint8		byte = value & 0x7F;
+
+		value >>= 7;
+
+		if (value != 0)
+			byte |= 0x80;
+
+		bytes[len++] = (char) byte;
+	} while (value != 0);
+
+	appendBinaryStringInfo(buf, bytes, len);
+}
+
+static uint64
+read_varint(ByteReader *reader)
+{
+	uint64		result = 0;
+	int			shift;
+
+	for (shift = 0; shift < 64; shift += 7)
+	{
+		uint8		byte;
+
+		reader_check(reader, 1);
+		byte = reader->data[reader->pos++];
+		result |= ((uint64) (byte & 0x7F)) << shift;
+
+		if ((byte & 0x80) == 0)
+			return result;
+	}
+
+	compressed_data_corrupt();
+	pg_unreachable();
+}
+
+static inline int
+leading_zeros64(uint64 value)
+{
+#ifdef __GNUC__
+	return __builtin_clzll(value);
+#else
+	int			n = 0;
+
+	while ((value & (UINT64CONST(1) << 63)) == 0)
+	{
+		value <<= 1;
+		n++;
+	}
+	return n;
+#endif
+}
+
+static inline int
+trailing_zeros64(uint64 value)
+{
+#ifdef __GNUC__
+	return __builtin_ctzll(value);
+#else
+	int			n = 0;
+
+	while ((value & 1) == 0)
+	{
+		value >>= 1;
+		n++;
+	}
+	return n;
+#endif
+}
+
+/*
+ * Append the lowest nbits of bits to the payload, most significant bit first.
+ */
+static void
+append_bits(Compressor *compressor, uint64 bits, int nbits)
+{
+	while (nbits > 0)
+	{
+		int			space = 8 - compressor->bits_used;
+		int			take = Min(space, nbits);
+		uint8		chunk = (uint8) ((bits >> (nbits - take)) & ((1U << take) - 1));
+
+		compressor->current_byte |= chunk << (space - take);
+		compressor->bits_used += take;
+		nbits -= take;
+
+		if (compressor->bits_used == 8)
+		{
+			appendStringInfoChar(&compressor->payload, (char) compressor->current_byte);
+			compressor->current_byte = 0;
+			compressor->bits_used = 0;
+		}
+	}
+}
+
+static uint64
+read_bits(ByteReader *reader, int nbits)
+{
+	uint64		result = 0;
+
+	while (nbits > 0)
+	{
+		int			avail = 8 - reader->bitpos;
+		int			take = Min(avail, nbits);
+		uint8		byte;
+
+		reader_check(reader, 1);
+		byte = reader->data[reader->pos];
+		result = (result << take) | ((byte >> (avail - take)) & ((1U << take) - 1));
+		reader->bitpos += take;
+		nbits -= take;
+
+		if (reader->bitpos == 8)
+		{
+			reader->pos++;
+			reader->bitpos = 0;
+		}
+	}
+
+	return result;
+}
+
+static int64
+datum_get_int64(Datum value, Oid typid)
+{
+	switch (typid)
+	{
+		case INT2OID:
+			return DatumGetInt16(value);
+		case INT4OID:
+		case DATEOID:
+			return DatumGetInt32(value);
+		case INT8OID:
+		case TIMESTAMPOID:
+		case TIMESTAMPTZOID:
+			return DatumGetInt64(value);
+		default:
+			elog(ERROR, "unsupported type %u for delta-of-delta compression", typid);
+			pg_unreachable();
+	}
+}
+
+static Datum
+int64_get_datum(int64 value, Oid typid)
+{
+	switch (typid)
+	{
+		case INT2OID:
+			return Int16GetDatum((int16) value);
+		case INT4OID:
+		case DATEOID:
+			return Int32GetDatum((int32) value);
+		case INT8OID:
+		case TIMESTAMPOID:
+		case TIMESTAMPTZOID:
+			return Int64GetDatum(value);
+		default:
+			elog(ERROR, "unsupported type %u for delta-of-delta compression", typid);
+			pg_unreachable();
+	}
+}
+
+static uint64
+datum_get_float_bits(Datum value, Oid typid)
+{
+	if (typid == FLOAT4OID)
+	{
+		float4		f = DatumGetFloat4(value);
+		uint32		bits;
+
+		memcpy(&bits, &f, sizeof(bits));
+		return bits;
+	}
+	else
+	{
+		float8		f = DatumGetFloat8(value);
+		uint64		bits;
+
+		memcpy(&bits, &f, sizeof(bits));
+		return bits;
+	}
+}
+
+static Datum
+float_bits_get_datum(uint64 bits, Oid typid)
+{
+	if (typid == FLOAT4OID)
+	{
+		uint32		bits4 = (uint32) bits;
+		float4		f;
+
+		memcpy(&f, &bits4, sizeof(f));
+		return Float4GetDatum(f);
+	}
+	else
+	{
+		float8		f;
+
+		memcpy(&f, &bits, sizeof(f));
+		return Float8GetDatum(f);
+	}
+}
+
+/*
+ * Serialize a datum for the dictionary. Varlena values are stored detoasted
+ * and in their (possibly short) in-memory form.
+ */
+static void
+append_datum(StringInfo buf, Datum value, int16 typlen, bool typbyval)
+{
+	if (typbyval)
+	{
+		union
+		{
+			Datum		datum;
+			char		bytes[sizeof(Datum)];
+		}			u;
+
+		store_att_byval(u.bytes, value, typlen);
+		appendBinaryStringInfo(buf, u.bytes, typlen);
+	}
+	else if (typlen > 0)
+		appendBinaryStringInfo(buf, DatumGetPointer(value), typlen);
+	else if (typlen == -1)
+	{
+		struct varlena *v = PG_DETOAST_DATUM_PACKED(value);
+
+		appendBinaryStringInfo(buf, (char *) v, VARSIZE_ANY(v));
+	}
+	else
+	{
+		char	   *s = DatumGetCString(value);
+
+		appendBinaryStringInfo(buf, s, strlen(s) + 1);
+	}
+}
+
+static Datum
+read_datum(ByteReader *reader, int16 typlen, bool typbyval)
+{
+	const char *start = (const char *) reader->data + reader->pos;
+	Size		len;
+	char	   *copy;
+
+	if (typlen > 0)
+		len = typlen;
+	else if (typlen == -1)
+	{
+		reader_check(reader, 1);
+
+		if (VARATT_IS_1B(start))
+			len = VARSIZE_1B(start);
+		else
+		{
+			uint32		header;
+
+			reader_check(reader, sizeof(header));
+			memcpy(&header, start, sizeof(header));
+			len = VARSIZE_4B(&header);
+		}
+	}
+	else
+		len = strnlen(start, reader->len - reader->pos) + 1;
+
+	if (len == 0)
+		compressed_data_corrupt();
+
+	reader_check(reader, len);
+	reader->pos += len;
+
+	if (typbyval)
+	{
+		union
+		{
+			Datum		datum;
+			char		bytes[sizeof(Datum)];
+		}			u;
+
+		memcpy(u.bytes, start, len);
+		return fetch_att(u.bytes, true, typlen);
+	}
+
+	/* Copy the value so that it is properly aligned */
+	copy = palloc(len);
+	memcpy(copy, start, len);
+
+	return PointerGetDatum(copy);
+}
+
+Compressor *
+compressor_create(Oid typid)
+{
+	Compressor *compressor = palloc0(sizeof(Compressor));
+
+	compressor->algorithm = compression_algorithm_for_type(typid);
+	compressor->typid = typid;
+	get_typlenbyval(typid, &compressor->typlen, &compressor->typbyval);
+	compressor->prev_leading = -1;
+	initStringInfo(&compressor->nulls);
+	initStringInfo(&compressor->payload);
+
+	if (compressor->algorithm == COMPRESSION_ALGORITHM_DICTIONARY)
+	{
+		initStringInfo(&compressor->entries);
+		initStringInfo(&compressor->scratch);
+		initStringInfo(&compressor->runs);
+		compressor->max_entries = 16;
+		compressor->entry_offsets = palloc(sizeof(int32) * compressor->max_entries);
+		compressor->entry_lengths = palloc(sizeof(int32) * compressor->max_entries);
+	}
+
+	return compressor;
+}
+
+static void
+deltadelta_append(Compressor *compressor, Datum value)
+{
+	uint64		v = (uint64) datum_get_int64(value, compressor->typid);
+
+	if (compressor->num_values == 0)
+		append_varint(&compressor->payload, zigzag_encode((int64) v));
+	else
+	{
+		/* Unsigned arithmetic so that overflows wrap around symmetrically */
+		uint64		delta = v - compressor->prev_value;
+
+		append_varint(&compressor->payload,
+					  zigzag_encode((int64) (delta - compressor->prev_delta)));
+		compressor->prev_delta = delta;
+	}
+
+	compressor->prev_value = v;
+}
+
+static void
+gorilla_append(Compressor *compressor, Datum value)
+{
+	uint64		bits = datum_get_float_bits(value, compressor->typid);
+	uint64		xor;
+	int			leading,
+				trailing;
+
+	if (compressor->num_values == 0)
+	{
+		append_bits(compressor, bits, 64);
+		compressor->prev_value = bits;
+		return;
+	}
+
+	xor = bits ^ compressor->prev_value;
+	compressor->prev_value = bits;
+
+	if (xor == 0)
+	{
+		append_bits(compressor, 0, 1);
+		return;
+	}
+
+	append_bits(compressor, 1, 1);
+	leading = leading_zeros64(xor);
+	trailing = trailing_zeros64(xor);
+
+	if (compressor->prev_leading >= 0 &&
+		leading >= compressor->prev_leading &&
+		trailing >= compressor->prev_trailing)
+	{
+		/* The meaningful bits fit in the previous window */
+		append_bits(compressor, 0, 1);
+		append_bits(compressor, xor >> compressor->prev_trailing,
+					64 - compressor->prev_leading - compressor->prev_trailing);
+	}
+	else
+	{
+		int			meaningful = 64 - leading - trailing;
+
+		append_bits(compressor, 1, 1);
+		append_bits(compressor, leading, GORILLA_WIDTH_BITS);
+		append_bits(compressor, meaningful - 1, GORILLA_WIDTH_BITS);
+		append_bits(compressor, xor >> trailing, meaningful);
+		compressor->prev_leading = leading;
+		compressor->prev_trailing = trailing;
+	}
+}
+
+static bool
+dictionary_entry_matches(Compressor *compressor, int32 index)
+{
+	return compressor->entry_lengths[index] == compressor->scratch.len &&
+		memcmp(compressor->entries.data + compressor->entry_offsets[index],
+			   compressor->scratch.data,
+			   compressor->scratch.len) == 0;
+}
+
+static void
+dictionary_flush_run(Compressor *compressor)
+{
+	if (compressor->run_length > 0)
+	{
+		append_varint(&compressor->runs, compressor->run_length);
+		append_varint(&compressor->runs, compressor->run_index);
+	}
+}
+
+/*
+ * Values are compared by their binary representation, which is exact for
+ * equality of the stored bytes. Values that are equal according to the type
+ * but have different representations simply get separate dictionary entries.
+ */
+static void
+dictionary_append(Compressor *compressor, Datum value)
+{
+	int32		index = -1;
+	int32		i;
+
+	resetStringInfo(&compressor->scratch);
+	append_datum(&compressor->scratch, value, compressor->typlen, compressor->typbyval);
+
+	/* Repeated values are the common case, so check the current run first */
+	if (compressor->run_length > 0 &&
+		dictionary_entry_matches(compressor, compressor->run_index))
+		index = compressor->run_index;
+	else
+	{
+		for (i = 0; i < compressor->num_entries; i++)
+		{
+			if (dictionary_entry_matches(compressor, i))
+			{
+				index = i;
+				break;
+			}
+		}
+	}
+
+	if (index < 0)
+	{
+		if (compressor->num_entries >= compressor->max_entries)
+		{
+			compressor->max_entries *= 2;
+			compressor->entry_offsets = repalloc(compressor->entry_offsets,
+												 sizeof(int32) * compressor->max_entries);
+			compressor->entry_lengths = repalloc(compressor->entry_lengths,
+												 sizeof(int32) * compressor->max_entries);
+		}
+
+		index = compressor->num_entries++;
+		compressor->entry_offsets[index] = compressor->entries.len;
+		compressor->entry_lengths[index] = compressor->scratch.len;
+		appendBinaryStringInfo(&compressor->entries,
+							   compressor->scratch.data,
+							   compressor->scratch.len);
+	}
+
+	if (compressor->run_length > 0 && index == compressor->run_index)
+		compressor->run_length++;
+	else
+	{
+		dictionary_flush_run(compressor);
+		compressor->run_index = index;
+		compressor->run_length = 1;
+	}
+}
+
+void
+compressor_append(Compressor *compressor, Datum value, bool isnull)
+{
+	int32		row = compressor->num_rows++;
+
+	if (row % 8 == 0)
+		appendStringInfoChar(&compressor->nulls, 0);
+
+	if (isnull)
+	{
+		compressor->nulls.data[row / 8] |= 1 << (row % 8);
+		compressor->has_nulls = true;
+		return;
+	}
+
+	switch (compressor->algorithm)
+	{
+		case COMPRESSION_ALGORITHM_DELTADELTA:
+			deltadelta_append(compressor, value);
+			break;
+		case COMPRESSION_ALGORITHM_GORILLA:
+			gorilla_append(compressor, value);
+			break;
+		case COMPRESSION_ALGORITHM_DICTIONARY:
+			dictionary_append(compressor, value);
+			break;
+		default:
+			elog(ERROR, "unknown compression algorithm %d", compressor->algorithm);
+	}
+
+	compressor->num_values++;
+}
+
+bytea *
+compressor_finish(Compressor *compressor)
+{
+	CompressedColumnHeader *header;
+	Size		nulls_len = compressor->has_nulls ? compressor->nulls.len : 0;
+	Size		total;
+	char	   *ptr;
+
+	switch (compressor->algorithm)
+	{
+		case COMPRESSION_ALGORITHM_GORILLA:
+			if (compressor->bits_used > 0)
+			{
+				appendStringInfoChar(&compressor->payload, (char) compressor->current_byte);
+				compressor->current_byte = 0;
+				compressor->bits_used = 0;
+			}
+			break;
+		case COMPRESSION_ALGORITHM_DICTIONARY:
+			dictionary_flush_run(compressor);
+			compressor->run_length = 0;
+			append_varint(&compressor->payload, compressor->num_entries);
+			appendBinaryStringInfo(&compressor->payload,
+								   compressor->entries.data,
+								   compressor->entries.len);
+			appendBinaryStringInfo(&compressor->payload,
+								   compressor->runs.data,
+								   compressor->runs.len);
+			break;
+		default:
+			break;
+	}
+
+	total = sizeof(CompressedColumnHeader) + nulls_len + compressor->payload.len;
+	header = palloc0(total);
+	SET_VARSIZE(header, total);
+	header->algorithm = compressor->algorithm;
+	header->has_nulls = compressor->has_nulls;
+	header->num_rows = compressor->num_rows;
+
+	ptr = (char *) header + sizeof(CompressedColumnHeader);
+
+	if (nulls_len > 0)
+	{
+		memcpy(ptr, compressor->nulls.data, nulls_len);
+		ptr += nulls_len;
+	}
+
+	memcpy(ptr, compressor->payload.data, compressor->payload.len);
+
+	return (bytea *) header;
+}
+
+static void
+deltadelta_decode(ByteReader *reader, Oid typid, Datum *values, int num_values)
+{
+	uint64		prev_value = 0;
+	uint64		prev_delta = 0;
+	int			i;
+
+	for (i = 0; i < num_values; i++)
+	{
+		int64		decoded = zigzag_decode(read_varint(reader));
+
+		if (i == 0)
+			prev_value = (uint64) decoded;
+		else
+		{
+			prev_delta += (uint64) decoded;
+			prev_value += prev_delta;
+		}
+
+		values[i] = int64_get_datum((int64) prev_value, typid);
+	}
+}
+
+static void
+gorilla_decode(ByteReader *reader, Oid typid, Datum *values, int num_values)
+{
+	uint64		prev_value = 0;
+	int			prev_leading = -1;
+	int			prev_trailing = 0;
+	int			i;
+
+	for (i = 0; i < num_values; i++)
+	{
+		if (i == 0)
+			prev_value = read_bits(reader, 64);
+		else if (read_bits(reader, 1) == 1)
+		{
+			int			meaningful;
+
+			if (read_bits(reader, 1) == 1)
+			{
+				prev_leading = (int) read_bits(reader, GORILLA_WIDTH_BITS);
+				meaningful = (int) read_bits(reader, GORILLA_WIDTH_BITS) + 1;
+				prev_trailing = 64 - prev_leading - meaningful;
+
+				if (prev_trailing < 0)
+					compressed_data_corrupt();
+			}
+			else
+			{
+				if (prev_leading < 0)
+					compressed_data_corrupt();
+
+				meaningful = 64 - prev_leading - prev_trailing;
+			}
+
+			prev_value ^= read_bits(reader, meaningful) << prev_trailing;
+		}
+
+		values[i] = float_bits_get_datum(prev_value, typid);
+	}
+}
+
+static void
+dictionary_decode(ByteReader *reader, Oid typid, Datum *values, int num_values)
+{
+	int16		typlen;
+	bool		typbyval;
+	uint64		num_entries;
+	Datum	   *entries;
+	int			i = 0;
+	uint64		j;
+
+	get_typlenbyval(typid, &typlen, &typbyval);
+
+	if (num_values == 0)
+		return;
+
+	num_entries = read_varint(reader);
+
+	if (num_entries == 0 || num_entries > (uint64) num_values)
+		compressed_data_corrupt();
+
+	entries = palloc(sizeof(Datum) * num_entries);
+
+	for (j = 0; j < num_entries; j++)
+		entries[j] = read_datum(reader, typlen, typbyval);
+
+	while (i < num_values)
+	{
+		uint64		run_length = read_varint(reader);
+		uint64		index = read_varint(reader);
+
+		if (run_length == 0 || run_length > (uint64) (num_values - i) || index >= num_entries)
+			compressed_data_corrupt();
+
+		for (j = 0; j < run_length; j++)
+			values[i++] = entries[index];
+	}
+}
+
+/*
+ * Decompress a column into arrays of values and NULL flags. The compressed
+ * data must be detoasted. Values of by-reference types are allocated in the
+ * current memory context.
+ */
+void
+decompress_column(bytea *compressed, Oid typid, DecompressedColumn *column)
+{
+	CompressedColumnHeader *header = (CompressedColumnHeader *) compressed;
+	ByteReader	reader = {
+		.data = (const uint8 *) compressed,
+		.len = VARSIZE(compressed),
+		.pos = sizeof(CompressedColumnHeader),
+	};
+	int			num_rows;
+	int			num_values;
+	int			i,
+				j;
+
+	if (reader.len < sizeof(CompressedColumnHeader) || header->num_rows < 0)
+		compressed_data_corrupt();
+
+	num_rows = num_values = header->num_rows;
+	column->num_rows = num_rows;
+	column->values = palloc(sizeof(Datum) * Max(num_rows, 1));
+	column->nulls = palloc0(sizeof(bool) * Max(num_rows, 1));
+
+	if (header->has_nulls)
+	{
+		Size		bitmap_len = (num_rows + 7) / 8;
+
+		reader_check(&reader, bitmap_len);
+
+		for (i = 0; i < num_rows; i++)
+		{
+			if (reader.data[reader.pos + i / 8] & (1 << (i % 8)))
+			{
+				column->nulls[i] = true;
+				num_values--;
+			}
+		}
+
+		reader.pos += bitmap_len;
+	}
+
+	switch (header->algorithm)
+	{
+		case COMPRESSION_ALGORITHM_DELTADELTA:
+			deltadelta_decode(&reader, typid, column->values, num_values);
+			break;
+		case COMPRESSION_ALGORITHM_GORILLA:
+			gorilla_decode(&reader, typid, column->values, num_values);
+			break;
+		case COMPRESSION_ALGORITHM_DICTIONARY:
+			dictionary_decode(&reader, typid, column->values, num_values);
+			break;
+		default:
+			compressed_data_corrupt();
+	}
+
+	if (num_values == num_rows)
+		return;
+
+	/*
+	 * The non-NULL values were decoded into the front of the array. Move them
+	 * into their row positions, starting from the back so that no value is
+	 * overwritten before it is moved.
+	 */
+	for (i = num_rows - 1, j = num_values - 1; i >= 0; i--)
+	{
+		if (column->nulls[i])
+			column->values[i] = (Datum) 0;
+		else
+			column->values[i] = column->values[j--];
+	}
+}
@@ -0,0 +1,64 @@
+#ifndef TIMESCALEDB_COMPRESSION_H
+#define TIMESCALEDB_COMPRESSION_H
+
+#include <postgres.h>
+
+/*
+ * Column compression for chunks.
+ *
+ * A compressed column holds the values of one column for a batch of rows. The
+ * algorithm is picked based on the column type:
+ *
+ * - integer and time types use delta-of-delta encoding, storing the
+ *   zig-zag encoded second-order differences as variable-length integers. A
+ *   regular time series encodes to a single byte per row.
+ *
+ * - floating point types use the Gorilla XOR encoding, which stores only the
+ *   meaningful bits of the XOR with the previous value.
+ *
+ * - all other types use a dictionary of distinct values and a run-length
+ *   encoded list of dictionary indexes.
+ *
+ * NULLs are stored in a separate bitmap and are not passed to the algorithm.
+ */
+typedef enum CompressionAlgorithm
+{
+	COMPRESSION_ALGORITHM_NONE = 0,
+	COMPRESSION_ALGORITHM_DELTADELTA,
+	COMPRESSION_ALGORITHM_GORILLA,
+	COMPRESSION_ALGORITHM_DICTIONARY,
+	_MAX_COMPRESSION_ALGORITHMS,
+} CompressionAlgorithm;
+
+/*
+ * The on-disk header of a compressed column. It is followed by the NULL bitmap
+ * (one bit per row, set for NULLs) if the column has NULLs, and then by the
+ * algorithm-specific payload.
+ */
+typedef struct CompressedColumnHeader
+{
+	int32		vl_len_;		/* varlena header (do not touch directly!) */
+	uint8		algorithm;
+	uint8		has_nulls;
+	uint16		reserved;
+	int32		num_rows;
+} CompressedColumnHeader;
+
+typedef struct Compressor Compressor;
+
+/* The decompressed values of a column in a batch */
+typedef struct DecompressedColumn
+{
+	int			num_rows;
+	Datum	   *values;
+	bool	   *nulls;
+} DecompressedColumn;
+
+extern CompressionAlgorithm compression_algorithm_for_type(Oid typid);
+extern const char *compression_algorithm_name(CompressionAlgorithm algorithm);
+extern Compressor *compressor_create(Oid typid);
+extern void compressor_append(Compressor *compressor, Datum value, bool isnull);
+extern bytea *compressor_finish(Compressor *compressor);
+extern void decompress_column(bytea *compressed, Oid typid, DecompressedColumn *column);
+
+#endif							/* TIMESCALEDB_COMPRESSION_H */
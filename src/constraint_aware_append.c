@@ -6,15 +6,60 @@
 #include <optimizer/clauses.h>
 #include <optimizer/prep.h>
 #include <executor/executor.h>
+#include <access/parallel.h>
+#include <storage/spin.h>
 #include <catalog/pg_class.h>
 #include <utils/memutils.h>
 #include <utils/lsyscache.h>
 #include <commands/explain.h>
+#include <catalog/namespace.h>
+#include <nodes/makefuncs.h>
 
 #include "constraint_aware_append.h"
 #include "hypertable.h"
+#include "hypertable_cache.h"
+#include "hypercube.h"
+#include "dimension.h"
+#include "dimension_slice.h"
+#include "partitioning.h"
+#include "plan_expand_hypertable.h"
+#include "runtime_chunk_filter.h"
+#include "minmax_index.h"
+#include "bloom_filter.h"
+#include "guc.h"
 #include "compat.h"
 
+#define INVALID_SUBPLAN_INDEX -1
+
+/*
+ * Shared state for a parallel-aware ConstraintAwareAppend.
+ *
+ * Participants (the leader and any workers) claim chunk subplans from this
+ * shared queue. A participant that finishes its chunk moves on to the next
+ * unclaimed one, so skewed chunk sizes do not leave workers idle. Subplans
+ * that are themselves parallel-aware (e.g., a Parallel Seq Scan on a large
+ * chunk) stay available until exhausted, which lets idle participants join
+ * in and share the chunk's block ranges. Other subplans are handed out as
+ * whole chunks to exactly one participant.
+ *
+ * Every participant excludes chunks on its own when the node starts, so the
+ * leader also records which subplans it kept and workers check that they
+ * kept the same ones before claiming subplans by index.
+ */
+typedef struct ParallelChunkAppendPlan
+{
+	int			plan_node_id;
+	bool		finished;
+} ParallelChunkAppendPlan;
+
+typedef struct ParallelChunkAppendShared
+{
+	slock_t		mutex;
+	int			next_plan;
+	int			num_plans;
+	ParallelChunkAppendPlan plans[FLEXIBLE_ARRAY_MEMBER];
+} ParallelChunkAppendShared;
+
 /*
  * Exclude child relations (chunks) at execution time based on constraints.
  *
@@ -77,9 +122,12 @@ excluded_by_constraint(RangeTblEntry *rte, AppendRelInfo *appinfo, List *restric
  * becomes
  *
  * ...WHERE time > '2017-06-02 11:26:43.935712+02'
+ *
+ * Parameters (e.g., in a generic plan for a prepared statement) are replaced
+ * by their values in the same way.
  */
 static List *
-constify_restrictinfos(List *restrictinfos)
+constify_restrictinfos(List *restrictinfos, ParamListInfo params)
 {
 	List	   *newinfos = NIL;
 	ListCell   *lc;
@@ -87,7 +135,7 @@ constify_restrictinfos(List *restrictinfos)
 		.resultRelation = InvalidOid,
 	};
 	PlannerGlobal glob = {
-		.boundParams = NULL,
+		.boundParams = params,
 	};
 	PlannerInfo root = {
 		.glob = &glob,
@@ -107,6 +155,217 @@ constify_restrictinfos(List *restrictinfos)
 	return newinfos;
 }
 
+static bool
+is_equality_operator(Oid opno, Oid left, Oid right)
+{
+	return opno == OpernameGetOprid(list_make2(makeString("pg_catalog"), makeString("=")), left, right);
+}
+
+static Dimension *
+get_closed_dimension_for_var(Hyperspace *hs, Index rti, Var *var)
+{
+	int			i;
+
+	if (var->varno != rti || var->varlevelsup != 0)
+		return NULL;
+
+	for (i = 0; i < hs->num_dimensions; i++)
+	{
+		Dimension  *dim = &hs->dimensions[i];
+
+		if (IS_CLOSED_DIMENSION(dim) && dim->column_attno == var->varattno)
+			return dim;
+	}
+
+	return NULL;
+}
+
+/*
+ * Create a partitioning function qual for a constified restriction of the form
+ * "column = value" or "column = ANY(array)" on a space-partitioning column.
+ * Such restrictions were not constant at planning time (e.g., they involved
+ * parameters), so they did not get the partitioning function qual that
+ * otherwise allows excluding space partitions.
+ */
+static Expr *
+space_partitioning_qual_create(Hyperspace *hs, Index rti, Expr *clause)
+{
+	Dimension  *dim;
+
+	if (IsA(clause, OpExpr) && list_length(((OpExpr *) clause)->args) == 2)
+	{
+		OpExpr	   *op = (OpExpr *) clause;
+		Node	   *left = linitial(op->args);
+		Node	   *right = lsecond(op->args);
+		Var		   *var;
+		Const	   *value;
+
+		if (IsA(left, Var) && IsA(right, Const))
+		{
+			var = (Var *) left;
+			value = (Const *) right;
+		}
+		else if (IsA(right, Var) && IsA(left, Const))
+		{
+			var = (Var *) right;
+			value = (Const *) left;
+		}
+		else
+			return NULL;
+
+		dim = get_closed_dimension_for_var(hs, rti, var);
+
+		if (NULL == dim ||
+			value->consttype != var->vartype ||
+			!is_equality_operator(op->opno, exprType(left), exprType(right)))
+			return NULL;
+
+		return partitioning_func_qual_create(dim->partitioning, var,
+											 &value->constvalue,
+											 &value->constisnull, 1);
+	}
+	else if (IsA(clause, ScalarArrayOpExpr))
+	{
+		ScalarArrayOpExpr *saop = (ScalarArrayOpExpr *) clause;
+		Node	   *left = linitial(saop->args);
+		Node	   *right = lsecond(saop->args);
+
+		if (!saop->useOr || !IsA(left, Var) || !IsA(right, Const))
+			return NULL;
+
+		dim = get_closed_dimension_for_var(hs, rti, (Var *) left);
+
+		if (NULL == dim ||
+			!is_equality_operator(saop->opno, exprType(left),
+								  get_element_type(exprType(right))))
+			return NULL;
+
+		return partitioning_func_array_qual_create(dim->partitioning, (Var *) left, (Const *) right);
+	}
+
+	return NULL;
+}
+
+/*
+ * Add the quals implied by the constified restrictions that exclude chunks
+ * on their dimensions: partitioning function quals for space partitions, and
+ * restrictions on the time column implied by restrictions on time_bucket() of
+ * the time column. The planner does not add the latter to the query (see
+ * plan_expand_hypertable_time_bucket_quals()), so they are derived here.
+ */
+static List *
+add_derived_quals(Index rti, Oid relid, List *restrictinfos)
+{
+	Cache	   *hcache = hypertable_cache_pin();
+	Hypertable *ht = hypertable_cache_get_entry(hcache, relid);
+	List	   *newinfos = NIL;
+	ListCell   *lc;
+
+	if (NULL != ht)
+	{
+		foreach(lc, restrictinfos)
+		{
+			RestrictInfo *rinfo = lfirst(lc);
+			Expr	   *qual = space_partitioning_qual_create(ht->space, rti, rinfo->clause);
+			List	   *quals = plan_expand_hypertable_time_bucket_quals(ht, rti, rinfo->clause);
+			ListCell   *lc_qual;
+
+			if (NULL != qual)
+				quals = lappend(quals, qual);
+
+			foreach(lc_qual, quals)
+			{
+				RestrictInfo *newinfo = makeNode(RestrictInfo);
+
+				newinfo->clause = lfirst(lc_qual);
+				newinfos = lappend(newinfos, newinfo);
+			}
+		}
+	}
+
+	cache_release(hcache);
+
+	return list_concat(restrictinfos, newinfos);
+}
+
+/*
+ * Get the slice of a chunk in the dimension used by the runtime chunk filter,
+ * or NULL if the subplan is not a scan of a chunk.
+ */
+static DimensionSlice *
+chunk_scan_get_slice(Plan *plan, EState *estate, Hypertable *ht, int32 dimension_id)
+{
+	RangeTblEntry *rte;
+	Hypercube  *cube;
+	DimensionSlice *slice;
+
+	switch (nodeTag(plan))
+	{
+		case T_SeqScan:
+		case T_SampleScan:
+		case T_IndexScan:
+		case T_IndexOnlyScan:
+		case T_BitmapHeapScan:
+		case T_TidScan:
+			break;
+		case T_CustomScan:
+			/* e.g., DecompressChunk on a compressed chunk */
+			if (((Scan *) plan)->scanrelid > 0)
+				break;
+			return NULL;
+		default:
+			return NULL;
+	}
+
+	rte = rt_fetch(((Scan *) plan)->scanrelid, estate->es_range_table);
+	cube = hypertable_get_chunk_cube(ht, rte->relid);
+
+	if (NULL == cube)
+		return NULL;
+
+	slice = hypercube_get_slice_by_dimension_id(cube, dimension_id);
+
+	return NULL == slice ? NULL : dimension_slice_copy(slice);
+}
+
+static void
+ca_append_init_runtime_filter(ConstraintAwareAppendState *state, EState *estate,
+							  Oid hypertable_relid, List *appendplans)
+{
+	Cache	   *hcache = hypertable_cache_pin();
+	Hypertable *ht = hypertable_cache_get_entry(hcache, hypertable_relid);
+	ListCell   *lc;
+	int			i = 0;
+
+	state->subplan_slices = palloc0(sizeof(DimensionSlice *) * list_length(appendplans));
+
+	if (NULL != ht)
+		foreach(lc, appendplans)
+			state->subplan_slices[i++] = chunk_scan_get_slice(lfirst(lc), estate, ht,
+															  state->filter_dimension_id);
+
+	cache_release(hcache);
+}
+
+/*
+ * Check if a chunk can be excluded based on its min/max ranges and bloom
+ * filters.
+ */
+static bool
+excluded_by_chunk_metadata(Hypertable *ht, RangeTblEntry *rte, List *minmax_restrictions,
+						   List *bloom_restrictions, Snapshot snapshot)
+{
+	int32		chunk_id;
+
+	if (minmax_restrictions == NIL && bloom_restrictions == NIL)
+		return false;
+
+	chunk_id = hypertable_get_chunk_id(ht, rte->relid);
+
+	return !chunk_minmax_matches(chunk_id, minmax_restrictions, snapshot) ||
+		!chunk_bloom_filter_matches(chunk_id, bloom_restrictions, snapshot);
+}
+
 /*
  * Initialize the scan state and prune any subplans from the Append node below
  * us in the plan tree. Pruning happens by evaluating the subplan's table
@@ -118,12 +377,30 @@ ca_append_begin(CustomScanState *node, EState *estate, int eflags)
 	ConstraintAwareAppendState *state = (ConstraintAwareAppendState *) node;
 	CustomScan *cscan = (CustomScan *) node->ss.ps.plan;
 	Plan	   *subplan = copyObject(state->subplan);
-	List	   *append_rel_info = lsecond(cscan->custom_private);
-	List	   *restrictinfos = constify_restrictinfos(lthird(cscan->custom_private));
+	Index		rti = linitial_int(linitial(cscan->custom_private));
+	Oid			hypertable_relid = linitial_oid(lsecond(cscan->custom_private));
+	List	   *append_rel_info = lthird(cscan->custom_private);
+	List	   *restrictinfos = constify_restrictinfos(lfourth(cscan->custom_private),
+													   estate->es_param_list_info);
 	List	  **appendplans,
 			   *old_appendplans;
 	ListCell   *lc_plan,
 			   *lc_info;
+	Cache	   *hcache;
+	Hypertable *ht;
+	List	   *minmax_restrictions = NIL;
+	List	   *bloom_restrictions = NIL;
+
+	if (list_length(cscan->custom_private) > 4)
+	{
+		List	   *filter_settings = list_nth(cscan->custom_private, 4);
+
+		state->filter_paramid = linitial_int(filter_settings);
+		state->filter_attno = lsecond_int(filter_settings);
+		state->filter_dimension_id = lthird_int(filter_settings);
+	}
+	else
+		state->filter_paramid = -1;
 
 	switch (nodeTag(subplan))
 	{
@@ -158,6 +435,23 @@ ca_append_begin(CustomScanState *node, EState *estate, int eflags)
 			elog(ERROR, "Invalid plan %d", nodeTag(subplan));
 	}
 
+	restrictinfos = add_derived_quals(rti, hypertable_relid, restrictinfos);
+
+	/*
+	 * Chunks can also be excluded based on the min/max ranges of indexed
+	 * columns and on bloom filters. These are read now rather than at
+	 * planning time since they might have changed since the plan was
+	 * created.
+	 */
+	hcache = hypertable_cache_pin();
+	ht = hypertable_cache_get_entry(hcache, hypertable_relid);
+
+	if (NULL != ht)
+	{
+		minmax_restrictions = minmax_restrict_info_create(ht, rti, restrictinfos);
+		bloom_restrictions = bloom_restrict_info_create(ht, rti, restrictinfos);
+	}
+
 	forboth(lc_plan, old_appendplans, lc_info, append_rel_info)
 	{
 		Scan	   *scan = lfirst(lc_plan);
@@ -188,18 +482,215 @@ ca_append_begin(CustomScanState *node, EState *estate, int eflags)
 				if (rte->rtekind == RTE_RELATION &&
 					rte->relkind == RELKIND_RELATION &&
 					!rte->inh &&
-					excluded_by_constraint(rte, appinfo, restrictinfos))
+					(excluded_by_constraint(rte, appinfo, restrictinfos) ||
+					 excluded_by_chunk_metadata(ht, rte, minmax_restrictions,
+												bloom_restrictions, estate->es_snapshot)))
 					break;
 			default:
 				*appendplans = lappend(*appendplans, scan);
 		}
 	}
 
+	cache_release(hcache);
+
 	state->num_append_subplans = list_length(*appendplans);
-	if (state->num_append_subplans > 0)
+
+	if (state->num_append_subplans == 0)
+		return;
+
+	/*
+	 * A parallel-aware node runs the chunk subplans itself, rather than
+	 * through the Append node, so that it can hand out chunks to parallel
+	 * participants. Workers check at startup that the exclusion above kept
+	 * the same subplans as in the leader. The same goes for a node with a runtime chunk filter, which needs to
+	 * skip chunks while executing.
+	 */
+	if ((node->ss.ps.plan->parallel_aware || state->filter_paramid >= 0) &&
+		IsA(subplan, Append))
+	{
+		int			i = 0;
+
+		if (state->filter_paramid >= 0)
+			ca_append_init_runtime_filter(state, estate, hypertable_relid, *appendplans);
+
+		state->subplanstates = palloc(sizeof(PlanState *) * state->num_append_subplans);
+
+		foreach(lc_plan, *appendplans)
+		{
+			PlanState  *ps = ExecInitNode(lfirst(lc_plan), estate, eflags);
+
+			state->subplanstates[i++] = ps;
+			node->custom_ps = lappend(node->custom_ps, ps);
+		}
+
+		state->current = INVALID_SUBPLAN_INDEX;
+		state->next_local = 0;
+	}
+	else
 		node->custom_ps = list_make1(ExecInitNode(subplan, estate, eflags));
 }
 
+/*
+ * Check if a chunk subplan can be skipped because the runtime chunk filter
+ * shows that none of its tuples can match the join it feeds into.
+ */
+static bool
+ca_append_skip_subplan(ConstraintAwareAppendState *state, int plan)
+{
+	RuntimeChunkFilter *filter;
+
+	if (NULL == state->subplan_slices)
+		return false;
+
+	filter = runtime_chunk_filter_get(state->csstate.ss.ps.state, state->filter_paramid);
+
+	if (runtime_chunk_filter_matches_slice(filter, state->subplan_slices[plan]))
+		return false;
+
+	state->num_skipped++;
+
+	return true;
+}
+
+/*
+ * Check a tuple against the runtime chunk filter, if any.
+ */
+static bool
+ca_append_filter_tuple(ConstraintAwareAppendState *state, TupleTableSlot *slot)
+{
+	RuntimeChunkFilter *filter;
+	Datum		value;
+	bool		isnull;
+
+	if (NULL == state->subplan_slices)
+		return true;
+
+	filter = runtime_chunk_filter_get(state->csstate.ss.ps.state, state->filter_paramid);
+
+	if (NULL == filter || !filter->complete || filter->disabled || !filter->open_dimension)
+		return true;
+
+	value = slot_getattr(slot, state->filter_attno, &isnull);
+
+	return runtime_chunk_filter_matches_value(filter, value, isnull);
+}
+
+/*
+ * Pick the next chunk subplan to execute in a parallel-aware node. Returns
+ * false if there are no subplans left to run.
+ */
+static bool
+ca_append_choose_next_subplan(ConstraintAwareAppendState *state)
+{
+	ParallelChunkAppendShared *pstate = state->pstate;
+	int			num_plans = state->num_append_subplans;
+	int			next;
+	int			i;
+
+	/* Not running in parallel, so just execute subplans in order */
+	if (NULL == pstate)
+	{
+		while (state->next_local < num_plans)
+		{
+			next = state->next_local++;
+
+			if (!ca_append_skip_subplan(state, next))
+			{
+				state->current = next;
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	while (true)
+	{
+		SpinLockAcquire(&pstate->mutex);
+
+		for (i = 0, next = pstate->next_plan; i < num_plans; i++, next = (next + 1) % num_plans)
+		{
+			if (!pstate->plans[next].finished)
+				break;
+		}
+
+		if (i == num_plans)
+		{
+			SpinLockRelease(&pstate->mutex);
+			return false;
+		}
+
+		/*
+		 * Subplans that are not parallel-aware must be run by exactly one
+		 * participant, so mark them as finished as soon as they are claimed.
+		 */
+		if (!state->subplanstates[next]->plan->parallel_aware)
+			pstate->plans[next].finished = true;
+
+		pstate->next_plan = (next + 1) % num_plans;
+		SpinLockRelease(&pstate->mutex);
+
+		/*
+		 * The runtime chunk filter is checked outside of the lock since it
+		 * can fail. A chunk it skips has no tuples for the join in any
+		 * participant, so it is finished for all of them.
+		 */
+		if (!ca_append_skip_subplan(state, next))
+			break;
+
+		SpinLockAcquire(&pstate->mutex);
+		pstate->plans[next].finished = true;
+		SpinLockRelease(&pstate->mutex);
+	}
+
+	state->current = next;
+
+	return true;
+}
+
+static void
+ca_append_finish_subplan(ConstraintAwareAppendState *state)
+{
+	ParallelChunkAppendShared *pstate = state->pstate;
+
+	if (NULL != pstate)
+	{
+		SpinLockAcquire(&pstate->mutex);
+		pstate->plans[state->current].finished = true;
+		SpinLockRelease(&pstate->mutex);
+	}
+
+	state->current = INVALID_SUBPLAN_INDEX;
+}
+
+static TupleTableSlot *
+ca_append_next_tuple(ConstraintAwareAppendState *state)
+{
+	CustomScanState *node = &state->csstate;
+	TupleTableSlot *subslot;
+
+	if (NULL == state->subplanstates)
+		return ExecProcNode(linitial(node->custom_ps));
+
+	while (state->current != INVALID_SUBPLAN_INDEX ||
+		   ca_append_choose_next_subplan(state))
+	{
+		subslot = ExecProcNode(state->subplanstates[state->current]);
+
+		if (!TupIsNull(subslot))
+		{
+			if (!ca_append_filter_tuple(state, subslot))
+				continue;
+
+			return subslot;
+		}
+
+		ca_append_finish_subplan(state);
+	}
+
+	return NULL;
+}
+
 static TupleTableSlot *
 ca_append_exec(CustomScanState *node)
 {
@@ -234,7 +725,7 @@ ca_append_exec(CustomScanState *node)
 
 	while (true)
 	{
-		subslot = ExecProcNode(linitial(node->custom_ps));
+		subslot = ca_append_next_tuple(state);
 
 		if (TupIsNull(subslot))
 			return NULL;
@@ -261,24 +752,98 @@ ca_append_exec(CustomScanState *node)
 static void
 ca_append_end(CustomScanState *node)
 {
-	if (node->custom_ps != NIL)
-	{
-		ExecEndNode(linitial(node->custom_ps));
-	}
+	ListCell   *lc;
+
+	foreach(lc, node->custom_ps)
+		ExecEndNode(lfirst(lc));
 }
 
 static void
 ca_append_rescan(CustomScanState *node)
 {
+	ConstraintAwareAppendState *state = (ConstraintAwareAppendState *) node;
+	ListCell   *lc;
+
 #if PG96
 	node->ss.ps.ps_TupFromTlist = false;
 #endif
-	if (node->custom_ps != NIL)
+	state->current = INVALID_SUBPLAN_INDEX;
+	state->next_local = 0;
+
+	foreach(lc, node->custom_ps)
+		ExecReScan(lfirst(lc));
+}
+
+static Size
+ca_append_estimate_dsm(CustomScanState *node, ParallelContext *pcxt)
+{
+	ConstraintAwareAppendState *state = (ConstraintAwareAppendState *) node;
+
+	return add_size(offsetof(ParallelChunkAppendShared, plans),
+					mul_size(sizeof(ParallelChunkAppendPlan), state->num_append_subplans));
+}
+
+static void
+ca_append_reset_shared(ConstraintAwareAppendState *state)
+{
+	ParallelChunkAppendShared *pstate = state->pstate;
+	int			i;
+
+	pstate->next_plan = 0;
+	pstate->num_plans = state->num_append_subplans;
+
+	for (i = 0; i < state->num_append_subplans; i++)
 	{
-		ExecReScan(linitial(node->custom_ps));
+		pstate->plans[i].plan_node_id = state->subplanstates[i]->plan->plan_node_id;
+		pstate->plans[i].finished = false;
 	}
 }
 
+static void
+ca_append_initialize_dsm(CustomScanState *node, ParallelContext *pcxt, void *coordinate)
+{
+	ConstraintAwareAppendState *state = (ConstraintAwareAppendState *) node;
+
+	/* Only parallel-aware nodes coordinate through shared memory */
+	if (NULL == state->subplanstates)
+		return;
+
+	state->pstate = coordinate;
+	SpinLockInit(&state->pstate->mutex);
+	ca_append_reset_shared(state);
+}
+
+#if PG10
+static void
+ca_append_reinitialize_dsm(CustomScanState *node, ParallelContext *pcxt, void *coordinate)
+{
+	ConstraintAwareAppendState *state = (ConstraintAwareAppendState *) node;
+
+	if (NULL != state->pstate)
+		ca_append_reset_shared(state);
+}
+#endif
+
+static void
+ca_append_initialize_worker(CustomScanState *node, shm_toc *toc, void *coordinate)
+{
+	ConstraintAwareAppendState *state = (ConstraintAwareAppendState *) node;
+	ParallelChunkAppendShared *pstate = coordinate;
+	int			i;
+
+	if (NULL == state->subplanstates)
+		return;
+
+	if (pstate->num_plans != state->num_append_subplans)
+		elog(ERROR, "parallel worker excluded different chunks than the leader");
+
+	for (i = 0; i < state->num_append_subplans; i++)
+		if (pstate->plans[i].plan_node_id != state->subplanstates[i]->plan->plan_node_id)
+			elog(ERROR, "parallel worker excluded different chunks than the leader");
+
+	state->pstate = pstate;
+}
+
 static void
 ca_append_explain(CustomScanState *node,
 				  List *ancestors,
@@ -286,11 +851,13 @@ ca_append_explain(CustomScanState *node,
 {
 	CustomScan *cscan = (CustomScan *) node->ss.ps.plan;
 	ConstraintAwareAppendState *state = (ConstraintAwareAppendState *) node;
-	Index		rti = linitial_int(linitial(cscan->custom_private));
-	RangeTblEntry *rte = rt_fetch(rti, es->rtable);
+	Oid			hypertable_relid = linitial_oid(lsecond(cscan->custom_private));
 
-	ExplainPropertyText("Hypertable", get_rel_name(rte->relid), es);
+	ExplainPropertyText("Hypertable", get_rel_name(hypertable_relid), es);
 	ExplainPropertyInteger("Chunks left after exclusion", state->num_append_subplans, es);
+
+	if (es->analyze && NULL != state->subplan_slices)
+		ExplainPropertyInteger("Chunks skipped by runtime filter", state->num_skipped, es);
 }
 
 
@@ -300,6 +867,12 @@ static CustomExecMethods constraint_aware_append_state_methods = {
 	.EndCustomScan = ca_append_end,
 	.ReScanCustomScan = ca_append_rescan,
 	.ExplainCustomScan = ca_append_explain,
+	.EstimateDSMCustomScan = ca_append_estimate_dsm,
+	.InitializeDSMCustomScan = ca_append_initialize_dsm,
+#if PG10
+	.ReInitializeDSMCustomScan = ca_append_reinitialize_dsm,
+#endif
+	.InitializeWorkerCustomScan = ca_append_initialize_worker,
 };
 
 static Node *
@@ -335,7 +908,14 @@ constraint_aware_append_plan_create(PlannerInfo *root,
 	cscan->scan.scanrelid = 0;	/* Not a real relation we are scanning */
 	cscan->scan.plan.targetlist = tlist;	/* Target list we expect as output */
 	cscan->custom_plans = custom_plans;
-	cscan->custom_private = list_make3(list_make1_int(rel->relid),
+
+	/*
+	 * Setrefs does not adjust custom_private, so the range table index only
+	 * matches the clauses and AppendRelInfos, not the final range table
+	 * (e.g., in a subquery). The executor identifies the hypertable by relid.
+	 */
+	cscan->custom_private = list_make4(list_make1_int(rel->relid),
+									   list_copy(path->custom_private),
 									   list_copy(root->append_rel_list),
 									   list_copy(clauses));
 	cscan->custom_scan_tlist = subplan->targetlist; /* Target list of tuples
@@ -346,11 +926,38 @@ constraint_aware_append_plan_create(PlannerInfo *root,
 	return &cscan->scan.plan;
 }
 
+bool
+is_constraint_aware_append_plan(Plan *plan)
+{
+	return IsA(plan, CustomScan) &&
+		((CustomScan *) plan)->methods == &constraint_aware_append_plan_methods;
+}
+
+/*
+ * Make a ConstraintAwareAppend plan skip chunks (and tuples) based on a
+ * runtime chunk filter passed in the given executor parameter.
+ */
+void
+constraint_aware_append_set_runtime_filter(CustomScan *cscan, int paramid,
+										   AttrNumber keyattno, int32 dimension_id)
+{
+	Assert(list_length(cscan->custom_private) == 4);
+	cscan->custom_private = lappend(cscan->custom_private,
+									list_make3_int(paramid, keyattno, dimension_id));
+}
+
 static CustomPathMethods constraint_aware_append_path_methods = {
 	.CustomName = "ConstraintAwareAppend",
 	.PlanCustomPath = constraint_aware_append_plan_create,
 };
 
+bool
+is_constraint_aware_append_path(Path *path)
+{
+	return IsA(path, CustomPath) &&
+		((CustomPath *) path)->methods == &constraint_aware_append_path_methods;
+}
+
 static inline List *
 remove_parent_subpath(PlannerInfo *root, List *subpaths, Oid parent_relid)
 {
@@ -382,6 +989,18 @@ constraint_aware_append_path_create(PlannerInfo *root, Hypertable *ht, Path *sub
 	path->cpath.path.pathkeys = subpath->pathkeys;
 	path->cpath.path.param_info = subpath->param_info;
 	path->cpath.path.pathtarget = subpath->pathtarget;
+	path->cpath.path.parallel_safe = subpath->parallel_safe;
+	path->cpath.path.parallel_workers = subpath->parallel_workers;
+
+	/*
+	 * A partial Append path (i.e., one with parallel workers) can be wrapped
+	 * in a parallel-aware node that hands out chunks to the participants of
+	 * the parallel scan instead of having all participants walk through the
+	 * chunks in the same order.
+	 */
+	path->cpath.path.parallel_aware = guc_parallel_chunk_append &&
+		IsA(subpath, AppendPath) &&
+		subpath->parallel_workers > 0;
 
 	/*
 	 * Set flags. We can set CUSTOMPATH_SUPPORT_BACKWARD_SCAN and
@@ -393,6 +1012,7 @@ constraint_aware_append_path_create(PlannerInfo *root, Hypertable *ht, Path *sub
 	 */
 	path->cpath.flags = 0;
 	path->cpath.custom_paths = list_make1(subpath);
+	path->cpath.custom_private = list_make1_oid(ht->main_table_relid);
 	path->cpath.methods = &constraint_aware_append_path_methods;
 
 	/*
@@ -428,3 +1048,15 @@ constraint_aware_append_path_create(PlannerInfo *root, Hypertable *ht, Path *sub
 
 	return &path->cpath.path;
 }
+
+void
+_constraint_aware_append_init(void)
+{
+	/* Needed to (de)serialize the plan for parallel workers */
+	RegisterCustomScanMethods(&constraint_aware_append_plan_methods);
+}
+
+void
+_constraint_aware_append_fini(void)
+{
+}
@@ -4,22 +4,41 @@
 #include <postgres.h>
 #include <nodes/relation.h>
 #include <nodes/extensible.h>
+#include <nodes/plannodes.h>
 
 typedef struct ConstraintAwareAppendPath
 {
 	CustomPath	cpath;
 } ConstraintAwareAppendPath;
 
+typedef struct ParallelChunkAppendShared ParallelChunkAppendShared;
+typedef struct DimensionSlice DimensionSlice;
+
 typedef struct ConstraintAwareAppendState
 {
 	CustomScanState csstate;
 	Plan	   *subplan;
 	Size		num_append_subplans;
+	/* Parallel-aware execution */
+	PlanState **subplanstates;
+	int			current;
+	int			next_local;
+	ParallelChunkAppendShared *pstate;
+	/* Runtime chunk filtering */
+	int			filter_paramid;
+	AttrNumber	filter_attno;
+	int32		filter_dimension_id;
+	DimensionSlice **subplan_slices;
+	int			num_skipped;
 } ConstraintAwareAppendState;
 
 typedef struct Hypertable Hypertable;
 
 Path	   *constraint_aware_append_path_create(PlannerInfo *root, Hypertable *ht, Path *subpath);
+bool		is_constraint_aware_append_path(Path *path);
+bool		is_constraint_aware_append_plan(Plan *plan);
+void		constraint_aware_append_set_runtime_filter(CustomScan *cscan, int paramid,
+										   AttrNumber keyattno, int32 dimension_id);
 
 
 #endif							/* TIMESCALEDB_CONSTRAINT_AWARE_APPEND_H */
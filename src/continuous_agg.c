@@ -0,0 +1,1419 @@
+#include <postgres.h>
+#include <access/heapam.h>
+#include <access/htup_details.h>
+#include <access/stratnum.h>
+#include <access/xact.h>
+#include <catalog/dependency.h>
+#include <catalog/index.h>
+#include <catalog/namespace.h>
+#include <catalog/objectaddress.h>
+#include <catalog/pg_inherits_fn.h>
+#include <catalog/pg_trigger.h>
+#include <catalog/pg_type.h>
+#include <commands/defrem.h>
+#include <commands/tablecmds.h>
+#include <commands/trigger.h>
+#include <commands/view.h>
+#include <executor/spi.h>
+#include <miscadmin.h>
+#include <nodes/makefuncs.h>
+#include <nodes/nodeFuncs.h>
+#include <optimizer/clauses.h>
+#include <parser/analyze.h>
+#include <storage/lmgr.h>
+#include <tcop/tcopprot.h>
+#include <utils/acl.h>
+#include <utils/builtins.h>
+#include <utils/date.h>
+#include <utils/fmgroids.h>
+#include <utils/hsearch.h>
+#include <utils/lsyscache.h>
+#include <utils/memutils.h>
+#include <utils/rel.h>
+#include <utils/snapmgr.h>
+#include <utils/timestamp.h>
+
+#include "catalog.h"
+#include "chunk.h"
+#include "continuous_agg.h"
+#include "dimension.h"
+#include "extension.h"
+#include "hypertable.h"
+#include "hypertable_cache.h"
+#include "scanner.h"
+#include "trigger.h"
+#include "utils.h"
+#include "compat.h"
+
+/*
+ * Continuous aggregates.
+ *
+ * A continuous aggregate is an aggregate query that groups the rows of a
+ * hypertable by time_bucket() of the hypertable's time column. The query is
+ * stored as the "direct view" and its result, one row per group, in the
+ * materialization table. Both live in the internal schema. The user queries
+ * the aggregate through the "user view", which returns the materialized
+ * buckets below the aggregate's watermark and computes the buckets at or
+ * above the watermark from the hypertable, so that the result includes the
+ * latest rows. Queries on the direct view restrict the buckets, which the
+ * planner turns into restrictions on the time column that exclude chunks
+ * (see time_bucket_quals_add()).
+ *
+ * Refreshing the aggregate materializes the buckets up to the latest time in
+ * the hypertable and moves the watermark past them. Buckets below the
+ * watermark are recomputed only if rows in their time range were modified
+ * since the last refresh. The time ranges of modified rows are recorded in
+ * the invalidation log:
+ *
+ * - Inserts record the range of time values they dispatch to chunks (see
+ *   chunk_dispatch_track_modified()).
+ * - Updates, deletes and truncation are recorded by triggers on the
+ *   hypertable and its chunks.
+ *
+ * The ranges are accumulated per hypertable in backend memory and written to
+ * the log, one row per continuous aggregate, when the transaction commits.
+ */
+
+typedef struct ContinuousAggScanData
+{
+	List	   *caggs;
+} ContinuousAggScanData;
+
+static ContinuousAgg *
+continuous_agg_from_tuple(TupleInfo *ti)
+{
+	ContinuousAgg *cagg = palloc0(sizeof(ContinuousAgg));
+	Datum		values[Natts_continuous_agg];
+	bool		nulls[Natts_continuous_agg];
+
+	heap_deform_tuple(ti->tuple, ti->desc, values, nulls);
+
+	cagg->fd.id = DatumGetInt32(values[Anum_continuous_agg_id - 1]);
+	cagg->fd.hypertable_id = DatumGetInt32(values[Anum_continuous_agg_hypertable_id - 1]);
+	namecpy(&cagg->fd.user_view_schema, DatumGetName(values[Anum_continuous_agg_user_view_schema - 1]));
+	namecpy(&cagg->fd.user_view_name, DatumGetName(values[Anum_continuous_agg_user_view_name - 1]));
+	namecpy(&cagg->fd.direct_view_schema, DatumGetName(values[Anum_continuous_agg_direct_view_schema - 1]));
+	namecpy(&cagg->fd.direct_view_name, DatumGetName(values[Anum_continuous_agg_direct_view_name - 1]));
+	namecpy(&cagg->fd.mat_table_schema, DatumGetName(values[Anum_continuous_agg_mat_table_schema - 1]));
+	namecpy(&cagg->fd.mat_table_name, DatumGetName(values[Anum_continuous_agg_mat_table_name - 1]));
+	namecpy(&cagg->fd.bucket_column_name, DatumGetName(values[Anum_continuous_agg_bucket_column_name - 1]));
+	cagg->fd.bucket_width = DatumGetInt64(values[Anum_continuous_agg_bucket_width - 1]);
+	cagg->fd.materialized_only = DatumGetBool(values[Anum_continuous_agg_materialized_only - 1]);
+	cagg->watermark_isnull = nulls[Anum_continuous_agg_watermark - 1];
+	cagg->fd.watermark = cagg->watermark_isnull ? 0 :
+		DatumGetInt64(values[Anum_continuous_agg_watermark - 1]);
+
+	return cagg;
+}
+
+static bool
+continuous_agg_tuple_found(TupleInfo *ti, void *data)
+{
+	ContinuousAggScanData *scandata = data;
+
+	scandata->caggs = lappend(scandata->caggs, continuous_agg_from_tuple(ti));
+
+	return true;
+}
+
+static bool
+continuous_agg_tuple_delete(TupleInfo *ti, void *data)
+{
+	CatalogSecurityContext sec_ctx;
+
+	catalog_become_owner(catalog_get(), &sec_ctx);
+	catalog_delete(ti->scanrel, ti->tuple);
+	catalog_restore_user(&sec_ctx);
+
+	return true;
+}
+
+static int
+continuous_agg_scan(ScanKeyData *scankey,
+					int nkeys,
+					int indexid,
+					tuple_found_func tuple_found,
+					void *data,
+					LOCKMODE lockmode,
+					Snapshot snapshot)
+{
+	Catalog    *catalog = catalog_get();
+	ScannerCtx	scanctx = {
+		.table = catalog->tables[CONTINUOUS_AGG].id,
+		.index = CATALOG_INDEX(catalog, CONTINUOUS_AGG, indexid),
+		.nkeys = nkeys,
+		.scankey = scankey,
+		.tuple_found = tuple_found,
+		.data = data,
+		.lockmode = lockmode,
+		.scandirection = ForwardScanDirection,
+		.snapshot = snapshot,
+	};
+
+	return scanner_scan(&scanctx);
+}
+
+List *
+continuous_agg_scan_by_hypertable_id(int32 hypertable_id)
+{
+	ContinuousAggScanData scandata = {
+		.caggs = NIL,
+	};
+	ScanKeyData scankey[1];
+
+	ScanKeyInit(&scankey[0], Anum_continuous_agg_hypertable_id_idx_hypertable_id,
+				BTEqualStrategyNumber, F_INT4EQ, Int32GetDatum(hypertable_id));
+
+	continuous_agg_scan(scankey, 1, CONTINUOUS_AGG_HYPERTABLE_ID_IDX,
+						continuous_agg_tuple_found, &scandata, AccessShareLock, NULL);
+
+	return scandata.caggs;
+}
+
+static ContinuousAgg *
+continuous_agg_get_by_id(int32 id, Snapshot snapshot)
+{
+	ContinuousAggScanData scandata = {
+		.caggs = NIL,
+	};
+	ScanKeyData scankey[1];
+
+	ScanKeyInit(&scankey[0], Anum_continuous_agg_pkey_idx_id,
+				BTEqualStrategyNumber, F_INT4EQ, Int32GetDatum(id));
+
+	continuous_agg_scan(scankey, 1, CONTINUOUS_AGG_PKEY_IDX,
+						continuous_agg_tuple_found, &scandata, AccessShareLock, snapshot);
+
+	return scandata.caggs == NIL ? NULL : linitial(scandata.caggs);
+}
+
+static ContinuousAgg *
+continuous_agg_get_by_user_view_name(const char *schema_name, const char *view_name)
+{
+	ContinuousAggScanData scandata = {
+		.caggs = NIL,
+	};
+	ScanKeyData scankey[2];
+
+	ScanKeyInit(&scankey[0], Anum_continuous_agg_user_view_schema_user_view_name_idx_user_view_schema,
+				BTEqualStrategyNumber, F_NAMEEQ,
+				DirectFunctionCall1(namein, CStringGetDatum(schema_name)));
+	ScanKeyInit(&scankey[1], Anum_continuous_agg_user_view_schema_user_view_name_idx_user_view_name,
+				BTEqualStrategyNumber, F_NAMEEQ,
+				DirectFunctionCall1(namein, CStringGetDatum(view_name)));
+
+	continuous_agg_scan(scankey, 2, CONTINUOUS_AGG_USER_VIEW_SCHEMA_USER_VIEW_NAME_IDX,
+						continuous_agg_tuple_found, &scandata, AccessShareLock, NULL);
+
+	return scandata.caggs == NIL ? NULL : linitial(scandata.caggs);
+}
+
+static void
+continuous_agg_insert(ContinuousAgg *cagg)
+{
+	Catalog    *catalog = catalog_get();
+	Relation	rel;
+	Datum		values[Natts_continuous_agg];
+	bool		nulls[Natts_continuous_agg] = {false};
+	CatalogSecurityContext sec_ctx;
+
+	values[Anum_continuous_agg_id - 1] = Int32GetDatum(cagg->fd.id);
+	values[Anum_continuous_agg_hypertable_id - 1] = Int32GetDatum(cagg->fd.hypertable_id);
+	values[Anum_continuous_agg_user_view_schema - 1] = NameGetDatum(&cagg->fd.user_view_schema);
+	values[Anum_continuous_agg_user_view_name - 1] = NameGetDatum(&cagg->fd.user_view_name);
+	values[Anum_continuous_agg_direct_view_schema - 1] = NameGetDatum(&cagg->fd.direct_view_schema);
+	values[Anum_continuous_agg_direct_view_name - 1] = NameGetDatum(&cagg->fd.direct_view_name);
+	values[Anum_continuous_agg_mat_table_schema - 1] = NameGetDatum(&cagg->fd.mat_table_schema);
+	values[Anum_continuous_agg_mat_table_name - 1] = NameGetDatum(&cagg->fd.mat_table_name);
+	values[Anum_continuous_agg_bucket_column_name - 1] = NameGetDatum(&cagg->fd.bucket_column_name);
+	values[Anum_continuous_agg_bucket_width - 1] = Int64GetDatum(cagg->fd.bucket_width);
+	values[Anum_continuous_agg_materialized_only - 1] = BoolGetDatum(cagg->fd.materialized_only);
+	values[Anum_continuous_agg_watermark - 1] = Int64GetDatum(cagg->fd.watermark);
+	nulls[Anum_continuous_agg_watermark - 1] = cagg->watermark_isnull;
+
+	rel = heap_open(catalog->tables[CONTINUOUS_AGG].id, RowExclusiveLock);
+	catalog_become_owner(catalog, &sec_ctx);
+	catalog_insert_values(rel, RelationGetDescr(rel), values, nulls);
+	catalog_restore_user(&sec_ctx);
+	heap_close(rel, RowExclusiveLock);
+}
+
+static bool
+continuous_agg_tuple_set_watermark(TupleInfo *ti, void *data)
+{
+	int64	   *watermark = data;
+	Datum		values[Natts_continuous_agg];
+	bool		nulls[Natts_continuous_agg];
+	HeapTuple	tuple;
+	CatalogSecurityContext sec_ctx;
+
+	heap_deform_tuple(ti->tuple, ti->desc, values, nulls);
+	values[Anum_continuous_agg_watermark - 1] = Int64GetDatum(*watermark);
+	nulls[Anum_continuous_agg_watermark - 1] = false;
+	tuple = heap_form_tuple(ti->desc, values, nulls);
+
+	catalog_become_owner(catalog_get(), &sec_ctx);
+	catalog_update_tid(ti->scanrel, &ti->tuple->t_self, tuple);
+	catalog_restore_user(&sec_ctx);
+
+	heap_freetuple(tuple);
+
+	return false;
+}
+
+static void
+continuous_agg_set_watermark(ContinuousAgg *cagg, int64 watermark)
+{
+	ScanKeyData scankey[1];
+
+	ScanKeyInit(&scankey[0], Anum_continuous_agg_pkey_idx_id,
+				BTEqualStrategyNumber, F_INT4EQ, Int32GetDatum(cagg->fd.id));
+
+	continuous_agg_scan(scankey, 1, CONTINUOUS_AGG_PKEY_IDX,
+						continuous_agg_tuple_set_watermark, &watermark, RowExclusiveLock, NULL);
+
+	cagg->fd.watermark = watermark;
+	cagg->watermark_isnull = false;
+}
+
+/*
+ * Invalidation log.
+ */
+
+typedef struct InvalidationRange
+{
+	int64		lowest;
+	int64		greatest;
+} InvalidationRange;
+
+static int
+invalidation_log_scan(int32 cagg_id, tuple_found_func tuple_found, void *data, LOCKMODE lockmode)
+{
+	Catalog    *catalog = catalog_get();
+	ScanKeyData scankey[1];
+	ScannerCtx	scanctx = {
+		.table = catalog->tables[CONTINUOUS_AGG_INVALIDATION_LOG].id,
+		.index = CATALOG_INDEX(catalog, CONTINUOUS_AGG_INVALIDATION_LOG,
+							   CONTINUOUS_AGG_INVALIDATION_LOG_CONTINUOUS_AGG_ID_IDX),
+		.nkeys = 1,
+		.scankey = scankey,
+		.tuple_found = tuple_found,
+		.data = data,
+		.lockmode = lockmode,
+		.scandirection = ForwardScanDirection,
+	};
+
+	ScanKeyInit(&scankey[0], Anum_continuous_agg_invalidation_log_continuous_agg_id_idx_continuous_agg_id,
+				BTEqualStrategyNumber, F_INT4EQ, Int32GetDatum(cagg_id));
+
+	return scanner_scan(&scanctx);
+}
+
+static void
+invalidation_log_insert_relation(Relation rel, int32 cagg_id, int64 lowest, int64 greatest)
+{
+	Datum		values[Natts_continuous_agg_invalidation_log];
+	bool		nulls[Natts_continuous_agg_invalidation_log] = {false};
+	CatalogSecurityContext sec_ctx;
+
+	values[Anum_continuous_agg_invalidation_log_continuous_agg_id - 1] = Int32GetDatum(cagg_id);
+	values[Anum_continuous_agg_invalidation_log_lowest_modified_value - 1] = Int64GetDatum(lowest);
+	values[Anum_continuous_agg_invalidation_log_greatest_modified_value - 1] = Int64GetDatum(greatest);
+
+	catalog_become_owner(catalog_get(), &sec_ctx);
+	catalog_insert_values(rel, RelationGetDescr(rel), values, nulls);
+	catalog_restore_user(&sec_ctx);
+}
+
+/*
+ * Remove the ranges of the log, collecting them in a list if one is given.
+ */
+static bool
+invalidation_log_tuple_delete(TupleInfo *ti, void *data)
+{
+	List	  **ranges = data;
+	CatalogSecurityContext sec_ctx;
+
+	if (NULL != ranges)
+	{
+		Form_continuous_agg_invalidation_log form = (Form_continuous_agg_invalidation_log) GETSTRUCT(ti->tuple);
+		InvalidationRange *range = palloc(sizeof(InvalidationRange));
+
+		range->lowest = form->lowest_modified_value;
+		range->greatest = form->greatest_modified_value;
+		*ranges = lappend(*ranges, range);
+	}
+
+	catalog_become_owner(catalog_get(), &sec_ctx);
+	catalog_delete(ti->scanrel, ti->tuple);
+	catalog_restore_user(&sec_ctx);
+
+	return true;
+}
+
+/*
+ * Pending invalidations.
+ *
+ * The time ranges modified in the current transaction, per hypertable. They
+ * live in the transaction's memory and are written to the invalidation log
+ * right before the transaction commits.
+ */
+
+typedef struct PendingInvalidation
+{
+	int32		hypertable_id;
+	int64		lowest;
+	int64		greatest;
+} PendingInvalidation;
+
+static HTAB *pending_invalidations = NULL;
+
+void
+continuous_agg_invalidate_range(int32 hypertable_id, int64 lowest, int64 greatest)
+{
+	PendingInvalidation *entry;
+	bool		found;
+
+	if (NULL == pending_invalidations)
+	{
+		HASHCTL		ctl = {
+			.keysize = sizeof(int32),
+			.entrysize = sizeof(PendingInvalidation),
+			.hcxt = TopTransactionContext,
+		};
+
+		pending_invalidations = hash_create("continuous agg pending invalidations", 16, &ctl,
+											HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
+	}
+
+	entry = hash_search(pending_invalidations, &hypertable_id, HASH_ENTER, &found);
+
+	if (!found)
+	{
+		entry->lowest = lowest;
+		entry->greatest = greatest;
+	}
+	else
+	{
+		if (lowest < entry->lowest)
+			entry->lowest = lowest;
+		if (greatest > entry->greatest)
+			entry->greatest = greatest;
+	}
+}
+
+static void
+continuous_agg_flush_invalidations(void)
+{
+	HTAB	   *htab = pending_invalidations;
+	HASH_SEQ_STATUS status;
+	PendingInvalidation *entry;
+	Relation	rel;
+
+	if (NULL == htab)
+		return;
+
+	pending_invalidations = NULL;
+	rel = heap_open(catalog_get()->tables[CONTINUOUS_AGG_INVALIDATION_LOG].id, RowExclusiveLock);
+	hash_seq_init(&status, htab);
+
+	while ((entry = hash_seq_search(&status)) != NULL)
+	{
+		List	   *caggs = continuous_agg_scan_by_hypertable_id(entry->hypertable_id);
+		ListCell   *lc;
+
+		foreach(lc, caggs)
+			invalidation_log_insert_relation(rel, ((ContinuousAgg *) lfirst(lc))->fd.id,
+											 entry->lowest, entry->greatest);
+	}
+
+	heap_close(rel, RowExclusiveLock);
+	hash_destroy(htab);
+}
+
+static void
+continuous_agg_xact_callback(XactEvent event, void *arg)
+{
+	switch (event)
+	{
+		case XACT_EVENT_PRE_COMMIT:
+		case XACT_EVENT_PRE_PREPARE:
+			if (extension_is_loaded())
+				continuous_agg_flush_invalidations();
+			pending_invalidations = NULL;
+			break;
+		case XACT_EVENT_COMMIT:
+		case XACT_EVENT_PREPARE:
+		case XACT_EVENT_ABORT:
+		case XACT_EVENT_PARALLEL_ABORT:
+			/* Freed along with the transaction's memory */
+			pending_invalidations = NULL;
+			break;
+		default:
+			break;
+	}
+}
+
+void
+_continuous_agg_init(void)
+{
+	RegisterXactCallback(continuous_agg_xact_callback, NULL);
+}
+
+void
+_continuous_agg_fini(void)
+{
+	UnregisterXactCallback(continuous_agg_xact_callback, NULL);
+}
+
+/*
+ * Invalidation triggers.
+ */
+
+static Oid
+continuous_agg_trigger_create(Oid relid, char *trigname, bool row, int16 events)
+{
+	CreateTrigStmt stmt = {
+		.type = T_CreateTrigStmt,
+		.trigname = trigname,
+		.relation = makeRangeVarFromRelid(relid),
+		.funcname = list_make2(makeString(INTERNAL_SCHEMA_NAME), makeString("continuous_agg_invalidate_trigger")),
+		.args = NIL,
+		.row = row,
+		.timing = TRIGGER_TYPE_AFTER,
+		.events = events,
+		.columns = NIL,
+		.whenClause = NULL,
+		.isconstraint = false,
+	};
+	Oid			trigger_oid = get_trigger_oid(relid, trigname, true);
+
+	if (OidIsValid(trigger_oid))
+		return trigger_oid;
+
+	trigger_oid = CreateTrigger(&stmt, NULL, InvalidOid, InvalidOid,
+								InvalidOid, InvalidOid, false).objectId;
+	CommandCounterIncrement();
+
+	return trigger_oid;
+}
+
+/*
+ * Create the triggers that record updates, deletes and truncation of the
+ * hypertable. The row trigger is created on the existing chunks like any
+ * other row trigger on the hypertable, and new chunks get it when they are
+ * created.
+ */
+static void
+continuous_agg_invalidate_trigger_create(Hypertable *ht)
+{
+	Oid			trigger_oid;
+	List	   *children;
+	ListCell   *lc;
+
+	continuous_agg_trigger_create(ht->main_table_relid, CONTINUOUS_AGG_INVALIDATE_TRUNCATE_TRIGGER_NAME,
+								  false, TRIGGER_TYPE_TRUNCATE);
+	trigger_oid = continuous_agg_trigger_create(ht->main_table_relid, CONTINUOUS_AGG_INVALIDATE_TRIGGER_NAME,
+												true, TRIGGER_TYPE_UPDATE | TRIGGER_TYPE_DELETE);
+	children = find_inheritance_children(ht->main_table_relid, NoLock);
+
+	foreach(lc, children)
+	{
+		Chunk	   *chunk = chunk_get_by_relid(lfirst_oid(lc), 0, false);
+
+		if (NULL == chunk ||
+			OidIsValid(get_trigger_oid(chunk->table_id, CONTINUOUS_AGG_INVALIDATE_TRIGGER_NAME, true)))
+			continue;
+
+		trigger_create_on_chunk(trigger_oid,
+								NameStr(chunk->fd.schema_name),
+								NameStr(chunk->fd.table_name));
+	}
+}
+
+static void
+continuous_agg_trigger_drop(Oid relid, const char *trigname)
+{
+	ObjectAddress address = {
+		.classId = TriggerRelationId,
+		.objectId = get_trigger_oid(relid, trigname, true),
+	};
+
+	if (OidIsValid(address.objectId))
+		performDeletion(&address, DROP_RESTRICT, 0);
+}
+
+static void
+continuous_agg_invalidate_trigger_drop(Oid hypertable_relid)
+{
+	List	   *children = find_inheritance_children(hypertable_relid, NoLock);
+	ListCell   *lc;
+
+	foreach(lc, children)
+		continuous_agg_trigger_drop(lfirst_oid(lc), CONTINUOUS_AGG_INVALIDATE_TRIGGER_NAME);
+
+	continuous_agg_trigger_drop(hypertable_relid, CONTINUOUS_AGG_INVALIDATE_TRIGGER_NAME);
+	continuous_agg_trigger_drop(hypertable_relid, CONTINUOUS_AGG_INVALIDATE_TRUNCATE_TRIGGER_NAME);
+}
+
+typedef struct InvalidateTriggerState
+{
+	Oid			relid;
+	int32		hypertable_id;	/* 0 if the relation is not part of a
+								 * hypertable */
+	AttrNumber	time_attno;
+	Oid			time_type;
+} InvalidateTriggerState;
+
+static void
+invalidate_trigger_state_init(InvalidateTriggerState *state, Oid relid)
+{
+	Cache	   *hcache = hypertable_cache_pin();
+	Hypertable *ht = hypertable_cache_get_entry(hcache, relid);
+
+	state->relid = relid;
+	state->hypertable_id = 0;
+
+	if (NULL == ht)
+	{
+		Chunk	   *chunk = chunk_get_by_relid(relid, 0, false);
+
+		if (NULL != chunk)
+			ht = hypertable_cache_get_entry_by_id(hcache, chunk->fd.hypertable_id);
+	}
+
+	if (NULL != ht)
+	{
+		Dimension  *dim = hyperspace_get_open_dimension(ht->space, 0);
+
+		state->hypertable_id = ht->fd.id;
+		state->time_attno = get_attnum(relid, NameStr(dim->fd.column_name));
+		state->time_type = dim->fd.column_type;
+	}
+
+	cache_release(hcache);
+}
+
+static int64
+invalidate_trigger_tuple_time(InvalidateTriggerState *state, HeapTuple tuple, TupleDesc tupdesc)
+{
+	bool		isnull;
+	Datum		value = heap_getattr(tuple, state->time_attno, tupdesc, &isnull);
+
+	/* The time column is NOT NULL */
+	Assert(!isnull);
+
+	return time_value_to_internal(value, state->time_type);
+}
+
+/*
+ * Trigger that records the time range of rows updated in or deleted from a
+ * hypertable's chunks. Truncation records the whole time range.
+ */
+TS_FUNCTION_INFO_V1(continuous_agg_invalidate_trigger);
+
+Datum
+continuous_agg_invalidate_trigger(PG_FUNCTION_ARGS)
+{
+	TriggerData *trigdata = (TriggerData *) fcinfo->context;
+	InvalidateTriggerState *state;
+	Relation	rel;
+	int64		lowest,
+				greatest;
+
+	if (!CALLED_AS_TRIGGER(fcinfo))
+		elog(ERROR, "continuous_agg_invalidate_trigger: not called by trigger manager");
+
+	if (!TRIGGER_FIRED_AFTER(trigdata->tg_event))
+		elog(ERROR, "continuous_agg_invalidate_trigger: must be fired AFTER");
+
+	rel = trigdata->tg_relation;
+	state = fcinfo->flinfo->fn_extra;
+
+	if (NULL == state || state->relid != RelationGetRelid(rel))
+	{
+		if (NULL == state)
+			state = MemoryContextAlloc(fcinfo->flinfo->fn_mcxt, sizeof(InvalidateTriggerState));
+
+		invalidate_trigger_state_init(state, RelationGetRelid(rel));
+		fcinfo->flinfo->fn_extra = state;
+	}
+
+	if (state->hypertable_id == 0)
+		return PointerGetDatum(NULL);
+
+	if (TRIGGER_FIRED_BY_TRUNCATE(trigdata->tg_event))
+	{
+		continuous_agg_invalidate_range(state->hypertable_id, PG_INT64_MIN, PG_INT64_MAX);
+		return PointerGetDatum(NULL);
+	}
+
+	if (!TRIGGER_FIRED_FOR_ROW(trigdata->tg_event) || !AttributeNumberIsValid(state->time_attno))
+		return PointerGetDatum(NULL);
+
+	lowest = greatest = invalidate_trigger_tuple_time(state, trigdata->tg_trigtuple,
+													  RelationGetDescr(rel));
+
+	if (TRIGGER_FIRED_BY_UPDATE(trigdata->tg_event))
+	{
+		int64		value = invalidate_trigger_tuple_time(state, trigdata->tg_newtuple,
+														  RelationGetDescr(rel));
+
+		if (value < lowest)
+			lowest = value;
+		if (value > greatest)
+			greatest = value;
+	}
+
+	continuous_agg_invalidate_range(state->hypertable_id, lowest, greatest);
+
+	return PointerGetDatum(NULL);
+}
+
+/*
+ * The watermark of a continuous aggregate, as a value of the type of the
+ * second argument. The watermark is read with the query's snapshot, so that
+ * it matches the materialized buckets that the query sees.
+ *
+ * Arguments:
+ * 0. ID of the continuous aggregate
+ * 1. A bucket value (ignored) giving the type of the result
+ */
+TS_FUNCTION_INFO_V1(continuous_agg_watermark);
+
+Datum
+continuous_agg_watermark(PG_FUNCTION_ARGS)
+{
+	int32		cagg_id = PG_GETARG_INT32(0);
+	Oid			type = get_fn_expr_argtype(fcinfo->flinfo, 1);
+	ContinuousAgg *cagg = fcinfo->flinfo->fn_extra;
+
+	if (NULL == cagg || cagg->fd.id != cagg_id)
+	{
+		ContinuousAgg *found = continuous_agg_get_by_id(cagg_id,
+														ActiveSnapshotSet() ? GetActiveSnapshot() : NULL);
+
+		if (NULL == found)
+			elog(ERROR, "continuous aggregate %d does not exist", cagg_id);
+
+		cagg = MemoryContextAlloc(fcinfo->flinfo->fn_mcxt, sizeof(ContinuousAgg));
+		memcpy(cagg, found, sizeof(ContinuousAgg));
+		fcinfo->flinfo->fn_extra = cagg;
+	}
+
+	if (!cagg->watermark_isnull)
+		return internal_to_time_value(cagg->fd.watermark, type);
+
+	switch (type)
+	{
+		case TIMESTAMPOID:
+		case TIMESTAMPTZOID:
+			PG_RETURN_TIMESTAMP(DT_NOBEGIN);
+		case DATEOID:
+			PG_RETURN_DATEADT(DATEVAL_NOBEGIN);
+		default:
+			elog(ERROR, "unsupported continuous aggregate bucket type %s", format_type_be(type));
+			pg_unreachable();
+	}
+}
+
+/*
+ * Creating continuous aggregates.
+ */
+
+typedef struct ContinuousAggQuery
+{
+	Query	   *query;
+	Hypertable *hypertable;
+	TargetEntry *bucket;
+	int64		bucket_width;
+} ContinuousAggQuery;
+
+static Query *
+continuous_agg_parse_query(const char *sql)
+{
+	List	   *parsetree_list = pg_parse_query(sql);
+
+	if (list_length(parsetree_list) != 1)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("invalid continuous aggregate query"),
+				 errdetail("The query must be a single SELECT statement.")));
+
+#if PG10
+	return parse_analyze(linitial(parsetree_list), sql, NULL, 0, NULL);
+#elif PG96
+	return parse_analyze(linitial(parsetree_list), sql, NULL, 0);
+#endif
+}
+
+#define continuous_agg_query_error(detail)						\
+	ereport(ERROR,												\
+			(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),			\
+			 errmsg("invalid continuous aggregate query"),		\
+			 errdetail(detail)))
+
+static bool
+is_time_bucket_function(Oid funcid)
+{
+	return function_has_symbol(funcid, "timestamp_bucket") ||
+		function_has_symbol(funcid, "timestamptz_bucket") ||
+		function_has_symbol(funcid, "date_bucket");
+}
+
+/*
+ * Check that a query can be maintained incrementally, i.e., that it
+ * aggregates the rows of a single hypertable by time bucket, so that the
+ * groups of a bucket only depend on the rows in the bucket's time range.
+ */
+static void
+continuous_agg_validate_query(ContinuousAggQuery *cq, Cache *hcache)
+{
+	Query	   *query = cq->query;
+	RangeTblEntry *rte;
+	Dimension  *dim;
+	ListCell   *lc;
+
+	if (query->commandType != CMD_SELECT || query->utilityStmt != NULL)
+		continuous_agg_query_error("The query must be a single SELECT statement.");
+
+	if (!query->hasAggs)
+		continuous_agg_query_error("The query must use aggregates.");
+
+	if (query->cteList != NIL || query->hasSubLinks || query->setOperations != NULL)
+		continuous_agg_query_error("The query must not use CTEs, subqueries or set operations.");
+
+	if (query->hasWindowFuncs || query->hasTargetSRFs)
+		continuous_agg_query_error("The query must not use window functions or set-returning functions.");
+
+	if (query->sortClause != NIL || query->limitCount != NULL || query->limitOffset != NULL ||
+		query->distinctClause != NIL || query->groupingSets != NIL || query->rowMarks != NIL)
+		continuous_agg_query_error("The query must not use ORDER BY, LIMIT, DISTINCT, grouping sets or locking clauses.");
+
+	if (list_length(query->rtable) != 1 || list_length(query->jointree->fromlist) != 1 ||
+		!IsA(linitial(query->jointree->fromlist), RangeTblRef))
+		continuous_agg_query_error("The query must select from a single hypertable.");
+
+	rte = linitial(query->rtable);
+
+	if (rte->rtekind != RTE_RELATION || !rte->inh)
+		continuous_agg_query_error("The query must select from a single hypertable.");
+
+	cq->hypertable = hypertable_cache_get_entry(hcache, rte->relid);
+
+	if (NULL == cq->hypertable)
+		continuous_agg_query_error("The query must select from a single hypertable.");
+
+	if (contain_mutable_functions((Node *) query))
+		continuous_agg_query_error("The query must only use immutable functions.");
+
+	dim = hyperspace_get_open_dimension(cq->hypertable->space, 0);
+
+	if (dim->fd.column_type != TIMESTAMPOID &&
+		dim->fd.column_type != TIMESTAMPTZOID &&
+		dim->fd.column_type != DATEOID)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("continuous aggregates on time columns of type %s are not supported",
+						format_type_be(dim->fd.column_type)),
+				 errhint("Use a time column of type timestamp, timestamptz or date.")));
+
+	if (NULL != dim->partitioning)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("continuous aggregates on time columns with a partitioning function are not supported")));
+
+	cq->bucket = NULL;
+
+	foreach(lc, query->targetList)
+	{
+		TargetEntry *tle = lfirst(lc);
+		FuncExpr   *fexpr;
+		Var		   *var;
+
+		if (tle->resjunk || tle->ressortgroupref == 0 || !IsA(tle->expr, FuncExpr))
+			continue;
+
+		fexpr = (FuncExpr *) tle->expr;
+
+		if (list_length(fexpr->args) != 2 || !is_time_bucket_function(fexpr->funcid))
+			continue;
+
+		var = lsecond(fexpr->args);
+
+		if (!IsA(var, Var) || var->varattno != dim->column_attno)
+			continue;
+
+		if (NULL != cq->bucket)
+			continuous_agg_query_error("The query must group by a single time bucket of the time column.");
+
+		if (!IsA(linitial(fexpr->args), Const) ||
+			((Const *) linitial(fexpr->args))->constisnull ||
+			DatumGetIntervalP(((Const *) linitial(fexpr->args))->constvalue)->month != 0)
+			continuous_agg_query_error("The time bucket width must be a constant interval without months or years.");
+
+		cq->bucket = tle;
+		cq->bucket_width = get_interval_period(DatumGetIntervalP(((Const *) linitial(fexpr->args))->constvalue));
+	}
+
+	if (NULL == cq->bucket)
+		continuous_agg_query_error("The query must group by time_bucket() of the hypertable's time column and select the bucket.");
+
+	if (cq->bucket_width <= 0)
+		continuous_agg_query_error("The time bucket width must be positive.");
+}
+
+/*
+ * Create a view or table in the catalog with the columns of a query's target
+ * list.
+ */
+static Oid
+continuous_agg_create_relation(const char *schema_name, const char *relname,
+							   char relkind, List *tlist, Oid ownerid)
+{
+	CreateStmt	stmt = {
+		.type = T_CreateStmt,
+		.relation = makeRangeVar(pstrdup(schema_name), pstrdup(relname), -1),
+		.oncommit = ONCOMMIT_NOOP,
+	};
+	ObjectAddress objaddr;
+	ListCell   *lc;
+
+	foreach(lc, tlist)
+	{
+		TargetEntry *tle = lfirst(lc);
+
+		if (tle->resjunk)
+			continue;
+
+		stmt.tableElts = lappend(stmt.tableElts,
+								 makeColumnDef(tle->resname,
+											   exprType((Node *) tle->expr),
+											   exprTypmod((Node *) tle->expr),
+											   exprCollation((Node *) tle->expr)));
+	}
+
+	objaddr = DefineRelation(&stmt,
+							 relkind,
+							 ownerid,
+							 NULL
+#if PG10
+							 ,NULL
+#endif
+		);
+	CommandCounterIncrement();
+
+	return objaddr.objectId;
+}
+
+static void
+continuous_agg_create_view(const char *schema_name, const char *view_name, Query *query, Oid ownerid)
+{
+	Oid			view_relid = continuous_agg_create_relation(schema_name, view_name, RELKIND_VIEW,
+															query->targetList, ownerid);
+
+	StoreViewQuery(view_relid, query, false);
+	CommandCounterIncrement();
+}
+
+static void
+continuous_agg_create_mat_table(ContinuousAgg *cagg, List *tlist, Oid ownerid)
+{
+	IndexElem	elem = {
+		.type = T_IndexElem,
+		.name = NameStr(cagg->fd.bucket_column_name),
+		.ordering = SORTBY_DEFAULT,
+		.nulls_ordering = SORTBY_NULLS_DEFAULT,
+	};
+	IndexStmt	stmt = {
+		.type = T_IndexStmt,
+		.accessMethod = DEFAULT_INDEX_TYPE,
+		.relation = makeRangeVar(NameStr(cagg->fd.mat_table_schema),
+								 NameStr(cagg->fd.mat_table_name), -1),
+		.indexParams = list_make1(&elem),
+	};
+	Oid			relid;
+
+	relid = continuous_agg_create_relation(NameStr(cagg->fd.mat_table_schema),
+										   NameStr(cagg->fd.mat_table_name),
+										   RELKIND_RELATION, tlist, ownerid);
+
+	/* Refreshes delete and insert the rows of bucket ranges */
+	DefineIndex(relid,
+				&stmt,
+				InvalidOid,
+				false,			/* is alter table */
+				false,			/* check rights */
+#if PG10
+				false,			/* check not in use */
+#endif
+				false,			/* skip build */
+				true);			/* quiet */
+	CommandCounterIncrement();
+}
+
+/*
+ * The query of the user view. Unless only the materialized buckets are
+ * returned, the buckets below the watermark come from the materialization
+ * table and the other buckets from the direct view.
+ */
+static char *
+continuous_agg_user_view_sql(ContinuousAgg *cagg, Oid bucket_type)
+{
+	StringInfoData sql;
+	const char *bucket = quote_identifier(NameStr(cagg->fd.bucket_column_name));
+	char	   *watermark;
+
+	initStringInfo(&sql);
+	appendStringInfo(&sql, "SELECT * FROM %s",
+					 quote_qualified_identifier(NameStr(cagg->fd.mat_table_schema),
+												NameStr(cagg->fd.mat_table_name)));
+
+	if (cagg->fd.materialized_only)
+		return sql.data;
+
+	watermark = psprintf("%s.continuous_agg_watermark(%d, NULL::%s)",
+						 quote_identifier(INTERNAL_SCHEMA_NAME), cagg->fd.id,
+						 format_type_be_qualified(bucket_type));
+	appendStringInfo(&sql, " WHERE %s < %s UNION ALL SELECT * FROM %s WHERE %s >= %s",
+					 bucket, watermark,
+					 quote_qualified_identifier(NameStr(cagg->fd.direct_view_schema),
+												NameStr(cagg->fd.direct_view_name)),
+					 bucket, watermark);
+
+	return sql.data;
+}
+
+TS_FUNCTION_INFO_V1(continuous_agg_create);
+
+/*
+ * Create a continuous aggregate.
+ *
+ * Arguments:
+ * 0. Name of the user view
+ * 1. Aggregate query
+ * 2. Only return materialized buckets (bool)
+ * 3. Schema of the user view
+ */
+Datum
+continuous_agg_create(PG_FUNCTION_ARGS)
+{
+	Name		view_name = PG_ARGISNULL(0) ? NULL : PG_GETARG_NAME(0);
+	char	   *sql = PG_ARGISNULL(1) ? NULL : text_to_cstring(PG_GETARG_TEXT_PP(1));
+	bool		materialized_only = PG_ARGISNULL(2) ? false : PG_GETARG_BOOL(2);
+	Name		schema_name = PG_ARGISNULL(3) ? NULL : PG_GETARG_NAME(3);
+	Catalog    *catalog = catalog_get();
+	ContinuousAggQuery cq;
+	ContinuousAgg cagg = {
+		.watermark_isnull = true,
+	};
+	Oid			ownerid = GetUserId();
+	Oid			view_nspid;
+	Query	   *user_query;
+	Cache	   *hcache;
+	CatalogSecurityContext sec_ctx;
+
+	if (NULL == view_name)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("invalid view name")));
+
+	if (NULL == sql)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("invalid continuous aggregate query")));
+
+	view_nspid = RangeVarGetCreationNamespace(makeRangeVar(NULL == schema_name ? NULL : NameStr(*schema_name),
+														   NameStr(*view_name), -1));
+
+	hcache = hypertable_cache_pin();
+	cq.query = continuous_agg_parse_query(sql);
+	continuous_agg_validate_query(&cq, hcache);
+
+	hypertable_permissions_check(cq.hypertable->main_table_relid, ownerid);
+
+	/* The lock needed to create triggers on the hypertable */
+	LockRelationOid(cq.hypertable->main_table_relid, ShareRowExclusiveLock);
+
+	catalog_become_owner(catalog, &sec_ctx);
+	cagg.fd.id = catalog_table_next_seq_id(catalog, CONTINUOUS_AGG);
+	catalog_restore_user(&sec_ctx);
+
+	cagg.fd.hypertable_id = cq.hypertable->fd.id;
+	namestrcpy(&cagg.fd.user_view_schema, get_namespace_name(view_nspid));
+	namecpy(&cagg.fd.user_view_name, view_name);
+	namestrcpy(&cagg.fd.direct_view_schema, INTERNAL_SCHEMA_NAME);
+	snprintf(NameStr(cagg.fd.direct_view_name), NAMEDATALEN, "_direct_view_%d", cagg.fd.id);
+	namestrcpy(&cagg.fd.mat_table_schema, INTERNAL_SCHEMA_NAME);
+	snprintf(NameStr(cagg.fd.mat_table_name), NAMEDATALEN, "_materialized_%d", cagg.fd.id);
+	namestrcpy(&cagg.fd.bucket_column_name, cq.bucket->resname);
+	cagg.fd.bucket_width = cq.bucket_width;
+	cagg.fd.materialized_only = materialized_only;
+
+	/*
+	 * The direct view and the materialization table are created in the
+	 * internal schema, which only the catalog owner can create relations in,
+	 * but are owned by the user.
+	 */
+	catalog_become_owner(catalog, &sec_ctx);
+	continuous_agg_create_view(NameStr(cagg.fd.direct_view_schema),
+							   NameStr(cagg.fd.direct_view_name),
+							   cq.query, ownerid);
+	continuous_agg_create_mat_table(&cagg, cq.query->targetList, ownerid);
+	catalog_restore_user(&sec_ctx);
+
+	user_query = continuous_agg_parse_query(continuous_agg_user_view_sql(&cagg, exprType((Node *) cq.bucket->expr)));
+	continuous_agg_create_view(NameStr(cagg.fd.user_view_schema),
+							   NameStr(cagg.fd.user_view_name),
+							   user_query, ownerid);
+
+	continuous_agg_insert(&cagg);
+	continuous_agg_invalidate_trigger_create(cq.hypertable);
+
+	cache_release(hcache);
+
+	PG_RETURN_VOID();
+}
+
+/*
+ * Dropping continuous aggregates.
+ */
+
+static void
+continuous_agg_drop_relation(Name schema_name, Name relname)
+{
+	Oid			nspid = get_namespace_oid(NameStr(*schema_name), true);
+	ObjectAddress objaddr = {
+		.classId = RelationRelationId,
+		.objectId = OidIsValid(nspid) ? get_relname_relid(NameStr(*relname), nspid) : InvalidOid,
+	};
+
+	if (OidIsValid(objaddr.objectId))
+		performDeletion(&objaddr, DROP_RESTRICT, 0);
+}
+
+/*
+ * Remove a continuous aggregate along with those of its relations that were
+ * not already dropped.
+ */
+static void
+continuous_agg_drop(ContinuousAgg *cagg)
+{
+	ScanKeyData scankey[1];
+
+	invalidation_log_scan(cagg->fd.id, invalidation_log_tuple_delete, NULL, RowExclusiveLock);
+
+	ScanKeyInit(&scankey[0], Anum_continuous_agg_pkey_idx_id,
+				BTEqualStrategyNumber, F_INT4EQ, Int32GetDatum(cagg->fd.id));
+	continuous_agg_scan(scankey, 1, CONTINUOUS_AGG_PKEY_IDX,
+						continuous_agg_tuple_delete, NULL, RowExclusiveLock, NULL);
+
+	continuous_agg_drop_relation(&cagg->fd.user_view_schema, &cagg->fd.user_view_name);
+	continuous_agg_drop_relation(&cagg->fd.direct_view_schema, &cagg->fd.direct_view_name);
+	continuous_agg_drop_relation(&cagg->fd.mat_table_schema, &cagg->fd.mat_table_name);
+}
+
+/*
+ * Remove the continuous aggregates of a hypertable that is being dropped. The
+ * invalidation triggers go with the hypertable.
+ */
+int
+continuous_agg_delete_by_hypertable_id(int32 hypertable_id)
+{
+	List	   *caggs = continuous_agg_scan_by_hypertable_id(hypertable_id);
+	ListCell   *lc;
+
+	foreach(lc, caggs)
+		continuous_agg_drop(lfirst(lc));
+
+	return list_length(caggs);
+}
+
+/*
+ * Remove the continuous aggregate of a user view that was dropped. The
+ * invalidation triggers are dropped along with the last continuous aggregate
+ * of the hypertable.
+ */
+int
+continuous_agg_delete_by_user_view_name(const char *schema_name, const char *view_name)
+{
+	ContinuousAgg *cagg = continuous_agg_get_by_user_view_name(schema_name, view_name);
+	Hypertable *ht;
+
+	if (NULL == cagg)
+		return 0;
+
+	continuous_agg_drop(cagg);
+
+	ht = hypertable_get_by_id(cagg->fd.hypertable_id);
+
+	if (NULL != ht && ht->continuous_aggs == NIL)
+		continuous_agg_invalidate_trigger_drop(ht->main_table_relid);
+
+	return 1;
+}
+
+/*
+ * Refreshing continuous aggregates.
+ */
+
+/* A range of buckets [start, end) to refresh. */
+typedef struct RefreshRange
+{
+	int64		start;			/* PG_INT64_MIN if unbounded */
+	int64		end;
+} RefreshRange;
+
+static int
+refresh_range_cmp(const void *left, const void *right)
+{
+	const RefreshRange *l = left;
+	const RefreshRange *r = right;
+
+	if (l->start < r->start)
+		return -1;
+	if (l->start > r->start)
+		return 1;
+	return 0;
+}
+
+/*
+ * Get the start of the bucket of a time value, in internal time format.
+ * Bucketing in the internal format gives the same buckets for all time types.
+ */
+static int64
+continuous_agg_bucket(ContinuousAgg *cagg, int64 value)
+{
+	Interval	interval = {
+		.time = cagg->fd.bucket_width,
+	};
+	Datum		bucket = DirectFunctionCall2(timestamp_bucket,
+											 IntervalPGetDatum(&interval),
+											 internal_to_time_value(value, TIMESTAMPOID));
+
+	return time_value_to_internal(bucket, TIMESTAMPOID);
+}
+
+static void
+continuous_agg_execute(const char *sql, Oid type, RefreshRange *range, int expected)
+{
+	Oid			argtypes[2] = {type, type};
+	Datum		values[2];
+	int			ret;
+
+	values[0] = internal_to_time_value(range->end, type);
+
+	if (range->start != PG_INT64_MIN)
+		values[1] = internal_to_time_value(range->start, type);
+
+	ret = SPI_execute_with_args(sql, range->start != PG_INT64_MIN ? 2 : 1,
+								argtypes, values, NULL, false, 0);
+
+	if (ret != expected)
+		elog(ERROR, "could not refresh continuous aggregate: %s", SPI_result_code_string(ret));
+}
+
+/*
+ * Recompute the materialized buckets of a range.
+ */
+static void
+continuous_agg_refresh_range(ContinuousAgg *cagg, Oid type, RefreshRange *range)
+{
+	const char *bucket = quote_identifier(NameStr(cagg->fd.bucket_column_name));
+	char	   *where;
+
+	if (range->start == PG_INT64_MIN)
+		where = psprintf("%s < $1", bucket);
+	else
+		where = psprintf("%s < $1 AND %s >= $2", bucket, bucket);
+
+	continuous_agg_execute(psprintf("DELETE FROM %s WHERE %s",
+									quote_qualified_identifier(NameStr(cagg->fd.mat_table_schema),
+															   NameStr(cagg->fd.mat_table_name)),
+									where),
+						   type, range, SPI_OK_DELETE);
+	continuous_agg_execute(psprintf("INSERT INTO %s SELECT * FROM %s WHERE %s",
+									quote_qualified_identifier(NameStr(cagg->fd.mat_table_schema),
+															   NameStr(cagg->fd.mat_table_name)),
+									quote_qualified_identifier(NameStr(cagg->fd.direct_view_schema),
+															   NameStr(cagg->fd.direct_view_name)),
+									where),
+						   type, range, SPI_OK_INSERT);
+}
+
+/*
+ * Get the latest time in the hypertable, in internal time format. Returns
+ * false if the hypertable has no rows.
+ */
+static bool
+continuous_agg_max_time(Hypertable *ht, Dimension *dim, int64 *max_time)
+{
+	char	   *sql = psprintf("SELECT max(%s) FROM %s",
+							   quote_identifier(NameStr(dim->fd.column_name)),
+							   quote_qualified_identifier(NameStr(ht->fd.schema_name),
+														  NameStr(ht->fd.table_name)));
+	Datum		value;
+	bool		isnull;
+	int			ret;
+
+	ret = SPI_execute(sql, true, 1);
+
+	if (ret != SPI_OK_SELECT || SPI_processed != 1)
+		elog(ERROR, "could not get the latest time of hypertable \"%s\"",
+			 NameStr(ht->fd.table_name));
+
+	value = SPI_getbinval(SPI_tuptable->vals[0], SPI_tuptable->tupdesc, 1, &isnull);
+
+	if (isnull)
+		return false;
+
+	*max_time = time_value_to_internal(value, dim->fd.column_type);
+
+	return true;
+}
+
+/*
+ * Get the bucket ranges to refresh, sorted and merged: the buckets below the
+ * watermark that overlap the invalidated ranges, and the buckets from the
+ * watermark to the new watermark.
+ */
+static List *
+continuous_agg_refresh_ranges(ContinuousAgg *cagg, List *invalidations, bool has_new_watermark,
+							  int64 new_watermark)
+{
+	RefreshRange *ranges = palloc(sizeof(RefreshRange) * (list_length(invalidations) + 1));
+	List	   *merged = NIL;
+	RefreshRange *last = NULL;
+	int			num_ranges = 0;
+	int			i;
+	ListCell   *lc;
+
+	/* Before the first refresh, there is nothing to recompute */
+	if (!cagg->watermark_isnull)
+	{
+		foreach(lc, invalidations)
+		{
+			InvalidationRange *inval = lfirst(lc);
+			RefreshRange *range = &ranges[num_ranges];
+
+			if (inval->lowest >= cagg->fd.watermark)
+				continue;
+
+			range->start = inval->lowest == PG_INT64_MIN ? PG_INT64_MIN :
+				continuous_agg_bucket(cagg, inval->lowest);
+
+			if (inval->greatest >= cagg->fd.watermark - cagg->fd.bucket_width)
+				range->end = cagg->fd.watermark;
+			else
+				range->end = continuous_agg_bucket(cagg, inval->greatest) + cagg->fd.bucket_width;
+
+			num_ranges++;
+		}
+	}
+
+	if (has_new_watermark)
+	{
+		ranges[num_ranges].start = cagg->watermark_isnull ? PG_INT64_MIN : cagg->fd.watermark;
+		ranges[num_ranges].end = new_watermark;
+		num_ranges++;
+	}
+
+	qsort(ranges, num_ranges, sizeof(RefreshRange), refresh_range_cmp);
+
+	for (i = 0; i < num_ranges; i++)
+	{
+		if (NULL != last && ranges[i].start <= last->end)
+		{
+			if (ranges[i].end > last->end)
+				last->end = ranges[i].end;
+			continue;
+		}
+
+		last = &ranges[i];
+		merged = lappend(merged, last);
+	}
+
+	return merged;
+}
+
+TS_FUNCTION_INFO_V1(continuous_agg_refresh);
+
+/*
+ * Refresh a continuous aggregate.
+ *
+ * Arguments:
+ * 0. Relation ID of the user view
+ */
+Datum
+continuous_agg_refresh(PG_FUNCTION_ARGS)
+{
+	Oid			view_relid = PG_ARGISNULL(0) ? InvalidOid : PG_GETARG_OID(0);
+	ContinuousAgg *cagg;
+	Cache	   *hcache;
+	Hypertable *ht;
+	Dimension  *dim;
+	Oid			mat_relid;
+	List	   *invalidations = NIL;
+	List	   *ranges;
+	int64		max_time;
+	int64		new_watermark = 0;
+	bool		has_new_watermark = false;
+	ListCell   *lc;
+
+	if (!OidIsValid(view_relid))
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("invalid continuous aggregate")));
+
+	cagg = continuous_agg_get_by_user_view_name(get_namespace_name(get_rel_namespace(view_relid)),
+												get_rel_name(view_relid));
+
+	if (NULL == cagg)
+		ereport(ERROR,
+				(errcode(ERRCODE_WRONG_OBJECT_TYPE),
+				 errmsg("\"%s\" is not a continuous aggregate", get_rel_name(view_relid))));
+
+	if (!pg_class_ownercheck(view_relid, GetUserId()))
+		aclcheck_error(ACLCHECK_NOT_OWNER, ACL_KIND_CLASS, get_rel_name(view_relid));
+
+	mat_relid = get_relname_relid(NameStr(cagg->fd.mat_table_name),
+								  get_namespace_oid(NameStr(cagg->fd.mat_table_schema), false));
+
+	/*
+	 * Serialize refreshes, but not reads, of the aggregate. A concurrent
+	 * refresh might have moved the watermark while we waited for the lock.
+	 */
+	LockRelationOid(mat_relid, ExclusiveLock);
+	cagg = continuous_agg_get_by_id(cagg->fd.id, NULL);
+
+	hcache = hypertable_cache_pin();
+	ht = hypertable_cache_get_entry_by_id(hcache, cagg->fd.hypertable_id);
+	dim = hyperspace_get_open_dimension(ht->space, 0);
+
+	/* Include the rows modified earlier in this transaction */
+	continuous_agg_flush_invalidations();
+	invalidation_log_scan(cagg->fd.id, invalidation_log_tuple_delete, &invalidations, RowExclusiveLock);
+
+	if (SPI_connect() != SPI_OK_CONNECT)
+		elog(ERROR, "could not connect to SPI");
+
+	if (continuous_agg_max_time(ht, dim, &max_time))
+	{
+		new_watermark = continuous_agg_bucket(cagg, max_time) + cagg->fd.bucket_width;
+		has_new_watermark = cagg->watermark_isnull || new_watermark > cagg->fd.watermark;
+	}
+
+	ranges = continuous_agg_refresh_ranges(cagg, invalidations, has_new_watermark, new_watermark);
+
+	foreach(lc, ranges)
+		continuous_agg_refresh_range(cagg, dim->fd.column_type, lfirst(lc));
+
+	SPI_finish();
+
+	if (has_new_watermark)
+		continuous_agg_set_watermark(cagg, new_watermark);
+
+	cache_release(hcache);
+
+	PG_RETURN_VOID();
+}
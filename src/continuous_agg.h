@@ -0,0 +1,33 @@
+#ifndef TIMESCALEDB_CONTINUOUS_AGG_H
+#define TIMESCALEDB_CONTINUOUS_AGG_H
+
+#include <postgres.h>
+#include <nodes/pg_list.h>
+
+#include "catalog.h"
+
+#define CONTINUOUS_AGG_INVALIDATE_TRIGGER_NAME "ts_continuous_agg_invalidate"
+#define CONTINUOUS_AGG_INVALIDATE_TRUNCATE_TRIGGER_NAME "ts_continuous_agg_invalidate_truncate"
+
+/*
+ * A continuous aggregate materializes an aggregate query over the time
+ * buckets of a hypertable and refreshes the materialized buckets
+ * incrementally, recomputing only the buckets that were modified since the
+ * last refresh.
+ */
+typedef struct ContinuousAgg
+{
+	FormData_continuous_agg fd;
+	bool		watermark_isnull;	/* nothing is materialized yet */
+} ContinuousAgg;
+
+extern List *continuous_agg_scan_by_hypertable_id(int32 hypertable_id);
+extern int	continuous_agg_delete_by_hypertable_id(int32 hypertable_id);
+extern int	continuous_agg_delete_by_user_view_name(const char *schema_name, const char *view_name);
+
+extern void continuous_agg_invalidate_range(int32 hypertable_id, int64 lowest, int64 greatest);
+
+extern void _continuous_agg_init(void);
+extern void _continuous_agg_fini(void);
+
+#endif							/* TIMESCALEDB_CONTINUOUS_AGG_H */
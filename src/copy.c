@@ -275,6 +275,11 @@ timescaledb_CopyFrom(CopyChunkState *ccstate, List *range_table, Hypertable *ht)
 
 		Assert(cis != NULL);
 
+		if (NULL != cis->minmax)
+			chunk_minmax_tracker_add_tuple(cis->minmax, tuple, tupDesc);
+
+		chunk_dispatch_track_modified(dispatch, point, tuple, tupDesc);
+
 		if (cis != prev_cis)
 		{
 			/* Different chunk so must release BulkInsertState */
@@ -368,6 +373,9 @@ timescaledb_CopyFrom(CopyChunkState *ccstate, List *range_table, Hypertable *ht)
 
 	MemoryContextSwitchTo(oldcontext);
 
+	/* Update min/max ranges before AFTER triggers fire */
+	chunk_dispatch_flush_minmax(ccstate->dispatch);
+
 	/*
 	 * if (cstate->copy_dest == COPY_OLD_FE) pq_endmsgread();
 	 */
@@ -0,0 +1,296 @@
+#include <postgres.h>
+#include <access/heapam.h>
+#include <access/htup_details.h>
+#include <catalog/pg_class.h>
+#include <executor/executor.h>
+#include <nodes/extensible.h>
+#include <nodes/makefuncs.h>
+#include <optimizer/cost.h>
+#include <optimizer/pathnode.h>
+#include <optimizer/restrictinfo.h>
+#include <storage/bufmgr.h>
+#include <utils/lsyscache.h>
+#include <utils/memutils.h>
+#include <utils/rel.h>
+
+#include "compat.h"
+#include "compressed_chunk.h"
+#include "decompress_chunk.h"
+
+/*
+ * DecompressChunk scans a compressed chunk.
+ *
+ * The node reads the batches of the chunk's compressed table, decompresses
+ * them and returns the rows in the chunk's row format, so that it can stand in
+ * for a scan of the chunk anywhere in a plan. Quals and projection are handled
+ * by the regular scan machinery (ExecScan) on the decompressed rows.
+ */
+
+/*
+ * Read and decompress the next batch of the compressed table into
+ * state->batch. Returns false when there are no more batches.
+ */
+bool
+decompress_chunk_next_batch(DecompressChunkState *state)
+{
+	EState	   *estate = state->csstate.ss.ps.state;
+	MemoryContext old;
+	HeapTuple	tuple;
+
+	if (NULL == state->scan)
+		state->scan = heap_beginscan(state->compressed_rel, estate->es_snapshot, 0, NULL);
+
+	tuple = heap_getnext(state->scan, ForwardScanDirection);
+
+	if (NULL == tuple)
+		return false;
+
+	MemoryContextReset(state->batch_context);
+	old = MemoryContextSwitchTo(state->batch_context);
+	heap_deform_tuple(tuple, RelationGetDescr(state->compressed_rel),
+					  state->compressed_values, state->compressed_nulls);
+	state->batch_rows = compressed_chunk_decompress_batch(state->columns,
+														  state->natts,
+														  state->count_attno,
+														  state->compressed_values,
+														  state->compressed_nulls,
+														  state->batch);
+	state->batch_row = 0;
+	MemoryContextSwitchTo(old);
+
+	return true;
+}
+
+static TupleTableSlot *
+decompress_chunk_next(ScanState *node)
+{
+	DecompressChunkState *state = (DecompressChunkState *) node;
+	TupleTableSlot *slot = node->ss_ScanTupleSlot;
+	int			i;
+
+	while (state->batch_row >= state->batch_rows)
+		if (!decompress_chunk_next_batch(state))
+			return ExecClearTuple(slot);
+
+	ExecClearTuple(slot);
+
+	for (i = 0; i < state->natts; i++)
+		decompressed_column_get(&state->batch[i], state->batch_row,
+								&slot->tts_values[i], &slot->tts_isnull[i]);
+
+	state->batch_row++;
+
+	return ExecStoreVirtualTuple(slot);
+}
+
+static bool
+decompress_chunk_recheck(ScanState *node, TupleTableSlot *slot)
+{
+	return true;
+}
+
+static void
+decompress_chunk_begin(CustomScanState *node, EState *estate, int eflags)
+{
+	DecompressChunkState *state = (DecompressChunkState *) node;
+	TupleDesc	chunkdesc = RelationGetDescr(node->ss.ss_currentRelation);
+	TupleDesc	compresseddesc;
+
+	state->compressed_rel = heap_open(state->compressed_relid, AccessShareLock);
+	compresseddesc = RelationGetDescr(state->compressed_rel);
+	state->natts = chunkdesc->natts;
+	state->columns = compressed_chunk_column_info(chunkdesc, compresseddesc,
+												  state->segment_by,
+												  &state->count_attno);
+	state->compressed_values = palloc(sizeof(Datum) * compresseddesc->natts);
+	state->compressed_nulls = palloc(sizeof(bool) * compresseddesc->natts);
+	state->batch = palloc0(sizeof(DecompressedColumn) * state->natts);
+	state->batch_context = AllocSetContextCreate(CurrentMemoryContext,
+												 "DecompressChunk batch",
+												 ALLOCSET_DEFAULT_SIZES);
+}
+
+static TupleTableSlot *
+decompress_chunk_exec(CustomScanState *node)
+{
+	return ExecScan(&node->ss, decompress_chunk_next, decompress_chunk_recheck);
+}
+
+static void
+decompress_chunk_end(CustomScanState *node)
+{
+	DecompressChunkState *state = (DecompressChunkState *) node;
+
+	if (NULL != state->scan)
+		heap_endscan(state->scan);
+
+	heap_close(state->compressed_rel, NoLock);
+}
+
+static void
+decompress_chunk_rescan(CustomScanState *node)
+{
+	DecompressChunkState *state = (DecompressChunkState *) node;
+
+	ExecScanReScan(&node->ss);
+
+	if (NULL != state->scan)
+		heap_rescan(state->scan, NULL);
+
+	state->batch_rows = 0;
+	state->batch_row = 0;
+}
+
+static CustomExecMethods decompress_chunk_state_methods = {
+	.CustomName = "DecompressChunk",
+	.BeginCustomScan = decompress_chunk_begin,
+	.ExecCustomScan = decompress_chunk_exec,
+	.EndCustomScan = decompress_chunk_end,
+	.ReScanCustomScan = decompress_chunk_rescan,
+};
+
+static Node *
+decompress_chunk_state_create(CustomScan *cscan)
+{
+	DecompressChunkState *state;
+	ListCell   *lc;
+
+	state = (DecompressChunkState *) newNode(sizeof(DecompressChunkState), T_CustomScanState);
+	state->csstate.methods = &decompress_chunk_state_methods;
+	state->compressed_relid = linitial_oid(linitial(cscan->custom_private));
+
+	foreach(lc, lsecond(cscan->custom_private))
+		state->segment_by = lappend(state->segment_by, strVal(lfirst(lc)));
+
+	return (Node *) state;
+}
+
+static CustomScanMethods decompress_chunk_plan_methods = {
+	.CustomName = "DecompressChunk",
+	.CreateCustomScanState = decompress_chunk_state_create,
+};
+
+static Plan *
+decompress_chunk_plan_create(PlannerInfo *root,
+							 RelOptInfo *rel,
+							 struct CustomPath *path,
+							 List *tlist,
+							 List *clauses,
+							 List *custom_plans)
+{
+	CustomScan *cscan = makeNode(CustomScan);
+
+	cscan->scan.scanrelid = rel->relid;
+	cscan->scan.plan.targetlist = tlist;
+	cscan->scan.plan.qual = extract_actual_clauses(clauses, false);
+	/* Scan tuples have the row type of the chunk */
+	cscan->custom_scan_tlist = NIL;
+	cscan->custom_private = path->custom_private;
+	cscan->flags = path->flags;
+	cscan->methods = &decompress_chunk_plan_methods;
+
+	return &cscan->scan.plan;
+}
+
+bool
+is_decompress_chunk_plan(Plan *plan)
+{
+	return IsA(plan, CustomScan) &&
+		((CustomScan *) plan)->methods == &decompress_chunk_plan_methods;
+}
+
+static CustomPathMethods decompress_chunk_path_methods = {
+	.CustomName = "DecompressChunk",
+	.PlanCustomPath = decompress_chunk_plan_create,
+};
+
+bool
+is_decompress_chunk_path(Path *path)
+{
+	return IsA(path, CustomPath) &&
+		((CustomPath *) path)->methods == &decompress_chunk_path_methods;
+}
+
+static Path *
+decompress_chunk_path_create(PlannerInfo *root, RelOptInfo *rel, CompressedChunk *cc)
+{
+	CustomPath *path;
+	Relation	compressed_rel;
+	BlockNumber pages;
+	List	   *segment_by = NIL;
+	ListCell   *lc;
+
+	compressed_rel = heap_open(cc->compressed_relid, AccessShareLock);
+	pages = RelationGetNumberOfBlocks(compressed_rel);
+	heap_close(compressed_rel, NoLock);
+
+	foreach(lc, cc->segment_by)
+		segment_by = lappend(segment_by, makeString(pstrdup(lfirst(lc))));
+
+	path = (CustomPath *) newNode(sizeof(CustomPath), T_CustomPath);
+	path->path.pathtype = T_CustomScan;
+	path->path.parent = rel;
+	path->path.pathtarget = rel->reltarget;
+	path->path.param_info = NULL;
+	path->path.parallel_safe = rel->consider_parallel;
+	path->path.rows = rel->rows;
+
+	/*
+	 * The compressed table is read sequentially, and every row is decompressed
+	 * and filtered
+	 */
+	path->path.startup_cost = 0;
+	path->path.total_cost = seq_page_cost * pages +
+		(cpu_tuple_cost + cpu_operator_cost + rel->baserestrictcost.per_tuple) * rel->tuples;
+	path->flags = 0;
+	path->custom_private = list_make2(list_make1_oid(cc->compressed_relid), segment_by);
+	path->methods = &decompress_chunk_path_methods;
+
+	return &path->path;
+}
+
+/*
+ * Replace the scan paths of a compressed chunk with a DecompressChunk path.
+ *
+ * Every scanned relation is looked up, since the heap of a compressed chunk
+ * need not be empty, e.g., after a write that was rolled back. The lookup is
+ * cached per relid.
+ */
+void
+decompress_chunk_add_paths(PlannerInfo *root, RelOptInfo *rel, Index rti, RangeTblEntry *rte)
+{
+	CompressedChunk *cc;
+
+	if (rte->rtekind != RTE_RELATION || rte->relkind != RELKIND_RELATION || rte->inh)
+		return;
+
+	cc = compressed_chunk_get_by_relid(rte->relid);
+
+	if (NULL == cc)
+		return;
+
+	if (!OidIsValid(cc->compressed_relid))
+		elog(ERROR, "compressed table for chunk \"%s\" does not exist", get_rel_name(rte->relid));
+
+	if (root->parse->resultRelation == rti)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("cannot modify compressed chunk \"%s\"", get_rel_name(rte->relid)),
+				 errhint("Decompress the chunk with decompress_chunk() first.")));
+
+	rel->pathlist = NIL;
+	rel->partial_pathlist = NIL;
+	add_path(rel, decompress_chunk_path_create(root, rel, cc));
+}
+
+void
+_decompress_chunk_init(void)
+{
+	/* Needed to (de)serialize the plan for parallel workers */
+	RegisterCustomScanMethods(&decompress_chunk_plan_methods);
+}
+
+void
+_decompress_chunk_fini(void)
+{
+}
@@ -0,0 +1,35 @@
+#ifndef TIMESCALEDB_DECOMPRESS_CHUNK_H
+#define TIMESCALEDB_DECOMPRESS_CHUNK_H
+
+#include <postgres.h>
+#include <access/heapam.h>
+#include <nodes/relation.h>
+#include <nodes/extensible.h>
+#include <nodes/plannodes.h>
+
+#include "compressed_chunk.h"
+
+typedef struct DecompressChunkState
+{
+	CustomScanState csstate;
+	Oid			compressed_relid;
+	List	   *segment_by;
+	Relation	compressed_rel;
+	HeapScanDesc scan;
+	CompressedColumnInfo *columns;
+	int			natts;
+	AttrNumber	count_attno;
+	Datum	   *compressed_values;
+	bool	   *compressed_nulls;
+	DecompressedColumn *batch;
+	int			batch_rows;
+	int			batch_row;
+	MemoryContext batch_context;
+} DecompressChunkState;
+
+extern void decompress_chunk_add_paths(PlannerInfo *root, RelOptInfo *rel, Index rti, RangeTblEntry *rte);
+extern bool is_decompress_chunk_path(Path *path);
+extern bool is_decompress_chunk_plan(Plan *plan);
+extern bool decompress_chunk_next_batch(DecompressChunkState *state);
+
+#endif							/* TIMESCALEDB_DECOMPRESS_CHUNK_H */
@@ -186,6 +186,23 @@ make_event_trigger_drop_trigger(char *trigger_name, char *schema, char *table)
 	return obj;
 }
 
+static EventTriggerDropView *
+make_event_trigger_drop_view(char *view_name, char *schema)
+{
+	EventTriggerDropView *obj = palloc(sizeof(EventTriggerDropView));
+
+	*obj = (EventTriggerDropView)
+	{
+		.obj =
+		{
+			.type = EVENT_TRIGGER_DROP_VIEW
+		},
+			.view_name = view_name,
+			.schema = schema,
+	};
+	return obj;
+}
+
 
 List *
 event_trigger_dropped_objects(void)
@@ -253,6 +270,14 @@ event_trigger_dropped_objects(void)
 									  make_event_trigger_drop_table(lsecond(addrnames),
 																	linitial(addrnames)));
 				}
+				else if (strcmp(objtype, "view") == 0)
+				{
+					List	   *addrnames = extract_addrnames(DatumGetArrayTypeP(values[10]));
+
+					objects = lappend(objects,
+									  make_event_trigger_drop_view(lsecond(addrnames),
+																   linitial(addrnames)));
+				}
 				break;
 			case NamespaceRelationId:
 				{
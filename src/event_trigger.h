@@ -10,7 +10,8 @@ typedef enum EventTriggerDropType
 	EVENT_TRIGGER_DROP_INDEX,
 	EVENT_TRIGGER_DROP_TABLE,
 	EVENT_TRIGGER_DROP_SCHEMA,
-	EVENT_TRIGGER_DROP_TRIGGER
+	EVENT_TRIGGER_DROP_TRIGGER,
+	EVENT_TRIGGER_DROP_VIEW
 } EventTriggerDropType;
 
 typedef struct EventTriggerDropObject
@@ -54,6 +55,13 @@ typedef struct EventTriggerDropTrigger
 	char	   *table;
 } EventTriggerDropTrigger;
 
+typedef struct EventTriggerDropView
+{
+	EventTriggerDropObject obj;
+	char	   *view_name;
+	char	   *schema;
+} EventTriggerDropView;
+
 extern List *event_trigger_dropped_objects(void);
 extern List *event_trigger_ddl_commands(void);
 extern void _event_trigger_init(void);
@@ -0,0 +1,729 @@
+#include <postgres.h>
+#include <catalog/pg_type.h>
+#include <executor/executor.h>
+#include <nodes/extensible.h>
+#include <nodes/nodeFuncs.h>
+#include <optimizer/clauses.h>
+#include <optimizer/pathnode.h>
+#include <optimizer/paths.h>
+#include <optimizer/tlist.h>
+#include <optimizer/var.h>
+#include <utils/builtins.h>
+#include <utils/lsyscache.h>
+#include <utils/memutils.h>
+#include <utils/timestamp.h>
+#include <utils/typcache.h>
+
+#include "gapfill.h"
+#include "sort_transform.h"
+#include "utils.h"
+#include "compat.h"
+
+/*
+ * Gap filling for time_bucket queries.
+ *
+ * A query that groups by time_bucket_gapfill(), e.g.,
+ *
+ *	 SELECT time_bucket_gapfill('1 hour', time, '2018-01-01', '2018-01-02'),
+ *			device, locf(avg(temp))
+ *	 FROM metrics GROUP BY 1, 2;
+ *
+ * returns a row for every bucket between start (inclusive) and finish
+ * (exclusive), and for every group, even for buckets without data. The grouped
+ * output is sorted by the other grouping columns and the bucket, and a GapFill
+ * node on top of it streams through the groups, emitting missing buckets
+ * inline. Columns of missing buckets are NULL except for the bucket, the
+ * grouping columns, and columns marked with locf() (the value of the previous
+ * bucket) or interpolate() (linear interpolation between the surrounding
+ * buckets).
+ *
+ * Outside of such a query, time_bucket_gapfill() is the same as time_bucket()
+ * and locf() and interpolate() return their argument.
+ */
+
+typedef enum GapFillColumnType
+{
+	GAPFILL_COLUMN_NULL,
+	GAPFILL_COLUMN_BUCKET,
+	GAPFILL_COLUMN_GROUP,
+	GAPFILL_COLUMN_LOCF,
+	GAPFILL_COLUMN_INTERPOLATE,
+} GapFillColumnType;
+
+typedef struct GapFillState
+{
+	CustomScanState csstate;
+	int			ncolumns;
+	GapFillColumnType *column_types;
+	FmgrInfo   *eq_funcs;		/* equality functions of grouping columns */
+	bool		has_groups;
+	AttrNumber	bucket_attno;
+	Oid			bucket_type;
+	ExprState  *width_expr;
+	ExprState  *start_expr;
+	ExprState  *finish_expr;
+	int64		period;
+	Timestamp	start;
+	Timestamp	finish;
+	Timestamp	next_bucket;	/* next bucket to emit in the current group */
+	/* The next tuple of the subplan, if not yet returned */
+	TupleTableSlot *pending;
+	Timestamp	pending_bucket;
+	bool		pending_bucket_isnull;
+	bool		pending_new_group;
+	bool		subplan_done;
+	/* The last tuple returned from the subplan in the current group */
+	TupleTableSlot *prev_slot;
+	bool		have_prev;
+	Timestamp	prev_bucket;
+	bool		prev_bucket_isnull;
+} GapFillState;
+
+TS_FUNCTION_INFO_V1(timestamp_bucket_gapfill);
+TS_FUNCTION_INFO_V1(timestamptz_bucket_gapfill);
+TS_FUNCTION_INFO_V1(gapfill_locf);
+TS_FUNCTION_INFO_V1(gapfill_interpolate);
+
+/*
+ * time_bucket_gapfill(bucket_width, ts, start, finish) buckets ts like
+ * time_bucket(bucket_width, ts). The start and finish arguments are only used
+ * by the gap-filling node.
+ */
+Datum
+timestamp_bucket_gapfill(PG_FUNCTION_ARGS)
+{
+	if (PG_ARGISNULL(0) || PG_ARGISNULL(1))
+		PG_RETURN_NULL();
+
+	return DirectFunctionCall2(timestamp_bucket, PG_GETARG_DATUM(0), PG_GETARG_DATUM(1));
+}
+
+Datum
+timestamptz_bucket_gapfill(PG_FUNCTION_ARGS)
+{
+	if (PG_ARGISNULL(0) || PG_ARGISNULL(1))
+		PG_RETURN_NULL();
+
+	return DirectFunctionCall2(timestamptz_bucket, PG_GETARG_DATUM(0), PG_GETARG_DATUM(1));
+}
+
+/* locf(value) and interpolate(value) only mark columns for the gap-filling node */
+Datum
+gapfill_locf(PG_FUNCTION_ARGS)
+{
+	if (PG_ARGISNULL(0))
+		PG_RETURN_NULL();
+
+	PG_RETURN_DATUM(PG_GETARG_DATUM(0));
+}
+
+Datum
+gapfill_interpolate(PG_FUNCTION_ARGS)
+{
+	if (PG_ARGISNULL(0))
+		PG_RETURN_NULL();
+
+	PG_RETURN_DATUM(PG_GETARG_DATUM(0));
+}
+
+static bool
+is_bucket_gapfill_call(Node *node)
+{
+	FuncExpr   *func;
+
+	if (!IsA(node, FuncExpr))
+		return false;
+
+	func = (FuncExpr *) node;
+
+	return list_length(func->args) == 4 &&
+		(function_has_symbol(func->funcid, "timestamptz_bucket_gapfill") ||
+		 function_has_symbol(func->funcid, "timestamp_bucket_gapfill"));
+}
+
+static bool
+is_marker_call(Node *node, const char *symbol)
+{
+	return IsA(node, FuncExpr) && function_has_symbol(((FuncExpr *) node)->funcid, symbol);
+}
+
+/*
+ * The bucket width, start and finish are evaluated once when the executor
+ * starts, so they cannot refer to the rows of the query.
+ */
+static void
+check_bucket_gapfill_arg(Node *arg, const char *name)
+{
+	if (contain_var_clause(arg) ||
+		contain_agg_clause(arg) ||
+		contain_subplans(arg) ||
+		contain_volatile_functions(arg))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("%s of time_bucket_gapfill must be a constant expression", name)));
+}
+
+/*
+ * Classify the output columns of the grouped relation by how the gap-filling
+ * node fills them in missing buckets.
+ */
+static List *
+gapfill_column_types(PlannerInfo *root, PathTarget *target, Index bucket_ref)
+{
+	List	   *types = NIL;
+	ListCell   *lc;
+	int			i = 0;
+
+	foreach(lc, target->exprs)
+	{
+		Node	   *expr = lfirst(lc);
+		Index		ref = get_pathtarget_sortgroupref(target, i);
+		GapFillColumnType type = GAPFILL_COLUMN_NULL;
+
+		if (ref != 0 && ref == bucket_ref)
+			type = GAPFILL_COLUMN_BUCKET;
+		else if (ref != 0 && get_sortgroupref_clause_noerr(ref, root->parse->groupClause) != NULL)
+			type = GAPFILL_COLUMN_GROUP;
+		else if (is_marker_call(expr, "gapfill_locf"))
+			type = GAPFILL_COLUMN_LOCF;
+		else if (is_marker_call(expr, "gapfill_interpolate"))
+			type = GAPFILL_COLUMN_INTERPOLATE;
+
+		types = lappend_int(types, type);
+		i++;
+	}
+
+	return types;
+}
+
+static CustomScanMethods gapfill_plan_methods;
+
+static Plan *
+gapfill_plan_create(PlannerInfo *root,
+					RelOptInfo *rel,
+					struct CustomPath *path,
+					List *tlist,
+					List *clauses,
+					List *custom_plans)
+{
+	CustomScan *cscan = makeNode(CustomScan);
+	Plan	   *subplan = linitial(custom_plans);
+	FuncExpr   *func = lsecond(path->custom_private);
+
+	cscan->scan.scanrelid = 0;	/* Not a real relation we are scanning */
+	cscan->scan.plan.targetlist = tlist;
+	cscan->custom_plans = custom_plans;
+	cscan->custom_private = linitial(path->custom_private);
+	cscan->custom_exprs = list_make3(linitial(func->args),
+									 lthird(func->args),
+									 lfourth(func->args));
+	cscan->custom_scan_tlist = copyObject(subplan->targetlist);
+	cscan->flags = path->flags;
+	cscan->methods = &gapfill_plan_methods;
+
+	return &cscan->scan.plan;
+}
+
+static CustomPathMethods gapfill_path_methods = {
+	.CustomName = "GapFill",
+	.PlanCustomPath = gapfill_plan_create,
+};
+
+static Path *
+gapfill_path_create(RelOptInfo *group_rel, Path *subpath, List *pathkeys,
+					List *column_types, FuncExpr *func)
+{
+	CustomPath *path = (CustomPath *) newNode(sizeof(CustomPath), T_CustomPath);
+
+	path->path.pathtype = T_CustomScan;
+	path->path.parent = group_rel;
+	path->path.pathtarget = subpath->pathtarget;
+	path->path.param_info = NULL;
+	path->path.parallel_aware = false;
+	path->path.parallel_safe = false;
+	path->path.parallel_workers = 0;
+	path->path.rows = subpath->rows;
+	path->path.startup_cost = subpath->startup_cost;
+	path->path.total_cost = subpath->total_cost;
+	path->path.pathkeys = pathkeys;
+	path->flags = 0;
+	path->custom_paths = list_make1(subpath);
+	path->custom_private = list_make2(column_types, func);
+	path->methods = &gapfill_path_methods;
+
+	return &path->path;
+}
+
+/*
+ * Put a GapFill node on top of the paths of a grouped relation if the query
+ * groups by time_bucket_gapfill(). The node needs its input sorted by the
+ * other grouping columns and then by the bucket, so paths that are not sorted
+ * that way get a sort first.
+ */
+void
+plan_add_gapfill(PlannerInfo *root, RelOptInfo *group_rel)
+{
+	Query	   *parse = root->parse;
+	SortGroupClause *bucket_clause = NULL;
+	FuncExpr   *func = NULL;
+	List	   *sortclauses = NIL;
+	List	   *pathkeys;
+	List	   *subpaths;
+	TypeCacheEntry *tce;
+	ListCell   *lc;
+
+	if (parse->groupClause == NIL || group_rel->pathlist == NIL)
+		return;
+
+	foreach(lc, parse->groupClause)
+	{
+		SortGroupClause *clause = lfirst(lc);
+		Node	   *expr = get_sortgroupclause_expr(clause, root->processed_tlist);
+
+		if (!is_bucket_gapfill_call(expr))
+		{
+			sortclauses = lappend(sortclauses, clause);
+			continue;
+		}
+
+		if (func != NULL)
+			ereport(ERROR,
+					(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					 errmsg("multiple time_bucket_gapfill calls not allowed")));
+
+		func = (FuncExpr *) expr;
+		bucket_clause = clause;
+	}
+
+	if (func == NULL)
+		return;
+
+	if (parse->groupingSets != NIL)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("time_bucket_gapfill is not supported with grouping sets")));
+
+	check_bucket_gapfill_arg(linitial(func->args), "bucket_width");
+	check_bucket_gapfill_arg(lthird(func->args), "start");
+	check_bucket_gapfill_arg(lfourth(func->args), "finish");
+
+	foreach(lc, sortclauses)
+		if (!OidIsValid(((SortGroupClause *) lfirst(lc))->sortop))
+			ereport(ERROR,
+					(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					 errmsg("time_bucket_gapfill requires sortable GROUP BY columns")));
+
+	/*
+	 * The groups can be in any order, but buckets must be ascending within a
+	 * group, even if the query orders them differently.
+	 */
+	tce = lookup_type_cache(func->funcresulttype, TYPECACHE_LT_OPR);
+	bucket_clause = copyObject(bucket_clause);
+	bucket_clause->sortop = tce->lt_opr;
+	bucket_clause->nulls_first = false;
+
+	pathkeys = make_pathkeys_for_sortclauses(root,
+											 lappend(sortclauses, bucket_clause),
+											 root->processed_tlist);
+
+	subpaths = group_rel->pathlist;
+	group_rel->pathlist = NIL;
+
+	foreach(lc, subpaths)
+	{
+		Path	   *subpath = lfirst(lc);
+		List	   *column_types = gapfill_column_types(root, subpath->pathtarget,
+														bucket_clause->tleSortGroupRef);
+
+		if (!pathkeys_contained_in(pathkeys, subpath->pathkeys))
+			subpath = (Path *) create_sort_path(root, group_rel, subpath, pathkeys, -1.0);
+
+		add_path(group_rel, gapfill_path_create(group_rel, subpath, pathkeys,
+												column_types, func));
+	}
+}
+
+static Datum
+gapfill_eval_arg(GapFillState *state, ExprState *expr, const char *name)
+{
+	ExprContext *econtext = state->csstate.ss.ps.ps_ExprContext;
+	Datum		value;
+	bool		isnull;
+
+	value = ExecEvalExprCompat(expr, econtext, &isnull);
+
+	if (isnull)
+		ereport(ERROR,
+				(errcode(ERRCODE_NULL_VALUE_NOT_ALLOWED),
+				 errmsg("%s of time_bucket_gapfill cannot be NULL", name)));
+
+	return value;
+}
+
+/*
+ * Evaluate the bucket width and the range to fill, and reset the node to the
+ * first bucket. Done on every (re)scan, since the arguments can depend on
+ * parameters.
+ */
+static void
+gapfill_init_range(GapFillState *state)
+{
+	ExprContext *econtext = state->csstate.ss.ps.ps_ExprContext;
+	MemoryContext old = MemoryContextSwitchTo(econtext->ecxt_per_tuple_memory);
+	Datum		width = gapfill_eval_arg(state, state->width_expr, "bucket_width");
+	Datum		start = gapfill_eval_arg(state, state->start_expr, "start");
+	Datum		finish = gapfill_eval_arg(state, state->finish_expr, "finish");
+
+	MemoryContextSwitchTo(old);
+	state->period = get_interval_period(DatumGetIntervalP(width));
+
+	if (state->period <= 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("bucket_width of time_bucket_gapfill must be greater than zero")));
+
+	if (TIMESTAMP_NOT_FINITE(DatumGetTimestamp(start)) ||
+		TIMESTAMP_NOT_FINITE(DatumGetTimestamp(finish)))
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("start and finish of time_bucket_gapfill must be finite")));
+
+	/* The range starts with the bucket that start falls into */
+	if (state->bucket_type == TIMESTAMPOID)
+		start = DirectFunctionCall2(timestamp_bucket, width, start);
+	else
+		start = DirectFunctionCall2(timestamptz_bucket, width, start);
+
+	state->start = DatumGetTimestamp(start);
+	state->finish = DatumGetTimestamp(finish);
+	state->next_bucket = state->start;
+	state->pending = NULL;
+	state->subplan_done = false;
+	state->have_prev = false;
+	ExecClearTuple(state->prev_slot);
+}
+
+static void
+gapfill_begin(CustomScanState *node, EState *estate, int eflags)
+{
+	GapFillState *state = (GapFillState *) node;
+	CustomScan *cscan = (CustomScan *) node->ss.ps.plan;
+	TupleDesc	tupdesc = node->ss.ss_ScanTupleSlot->tts_tupleDescriptor;
+	int			i;
+
+	Assert(state->ncolumns == tupdesc->natts);
+
+	state->eq_funcs = palloc0(sizeof(FmgrInfo) * state->ncolumns);
+
+	for (i = 0; i < state->ncolumns; i++)
+	{
+		Form_pg_attribute attr = tupdesc->attrs[i];
+
+		if (state->column_types[i] == GAPFILL_COLUMN_BUCKET)
+		{
+			state->bucket_attno = i + 1;
+			state->bucket_type = attr->atttypid;
+		}
+		else if (state->column_types[i] == GAPFILL_COLUMN_GROUP)
+		{
+			TypeCacheEntry *tce = lookup_type_cache(attr->atttypid, TYPECACHE_EQ_OPR);
+
+			if (!OidIsValid(tce->eq_opr))
+				ereport(ERROR,
+						(errcode(ERRCODE_UNDEFINED_FUNCTION),
+						 errmsg("could not identify an equality operator for type %s",
+								format_type_be(attr->atttypid))));
+
+			fmgr_info(get_opcode(tce->eq_opr), &state->eq_funcs[i]);
+			state->has_groups = true;
+		}
+	}
+
+	if (state->bucket_attno == InvalidAttrNumber)
+		elog(ERROR, "time_bucket_gapfill column not found in gap-filling node");
+
+	state->width_expr = ExecInitExpr(linitial(cscan->custom_exprs), &node->ss.ps);
+	state->start_expr = ExecInitExpr(lsecond(cscan->custom_exprs), &node->ss.ps);
+	state->finish_expr = ExecInitExpr(lthird(cscan->custom_exprs), &node->ss.ps);
+
+	state->prev_slot = ExecInitExtraTupleSlot(estate);
+	ExecSetSlotDescriptor(state->prev_slot, tupdesc);
+
+	node->custom_ps = list_make1(ExecInitNode(linitial(cscan->custom_plans), estate, eflags));
+
+	gapfill_init_range(state);
+}
+
+static bool
+gapfill_is_same_group(GapFillState *state, TupleTableSlot *a, TupleTableSlot *b)
+{
+	TupleDesc	tupdesc = a->tts_tupleDescriptor;
+	int			i;
+
+	for (i = 0; i < state->ncolumns; i++)
+	{
+		Datum		value_a,
+					value_b;
+		bool		isnull_a,
+					isnull_b;
+
+		if (state->column_types[i] != GAPFILL_COLUMN_GROUP)
+			continue;
+
+		value_a = slot_getattr(a, i + 1, &isnull_a);
+		value_b = slot_getattr(b, i + 1, &isnull_b);
+
+		if (isnull_a != isnull_b)
+			return false;
+
+		if (!isnull_a &&
+			!DatumGetBool(FunctionCall2Coll(&state->eq_funcs[i],
+											tupdesc->attrs[i]->attcollation,
+											value_a, value_b)))
+			return false;
+	}
+
+	return true;
+}
+
+static void
+gapfill_fetch_next(GapFillState *state)
+{
+	TupleTableSlot *slot = ExecProcNode(linitial(state->csstate.custom_ps));
+	Datum		bucket;
+
+	if (TupIsNull(slot))
+	{
+		state->subplan_done = true;
+		return;
+	}
+
+	bucket = slot_getattr(slot, state->bucket_attno, &state->pending_bucket_isnull);
+	state->pending = slot;
+	state->pending_bucket = state->pending_bucket_isnull ? 0 : DatumGetTimestamp(bucket);
+	state->pending_new_group = !state->have_prev ||
+		!gapfill_is_same_group(state, state->prev_slot, slot);
+}
+
+/*
+ * Linearly interpolate a value for the next bucket between the previous
+ * tuple and the given next tuple of the same group. The value is NULL if
+ * either point is missing.
+ */
+static Datum
+gapfill_interpolate_value(GapFillState *state, int attno, TupleTableSlot *next, bool *isnull)
+{
+	Datum		prev_value,
+				next_value;
+	bool		prev_isnull,
+				next_isnull;
+	double		y0,
+				y1;
+
+	*isnull = true;
+
+	if (!state->have_prev || state->prev_bucket_isnull || NULL == next)
+		return (Datum) 0;
+
+	prev_value = slot_getattr(state->prev_slot, attno, &prev_isnull);
+	next_value = slot_getattr(next, attno, &next_isnull);
+
+	if (prev_isnull || next_isnull)
+		return (Datum) 0;
+
+	y0 = DatumGetFloat8(prev_value);
+	y1 = DatumGetFloat8(next_value);
+	*isnull = false;
+
+	return Float8GetDatum(y0 + (y1 - y0) * (double) (state->next_bucket - state->prev_bucket) /
+						  (double) (state->pending_bucket - state->prev_bucket));
+}
+
+/*
+ * Build the tuple for the missing bucket next_bucket. Grouping columns are
+ * taken from group_slot and interpolated columns are interpolated towards
+ * next_slot, if given.
+ */
+static TupleTableSlot *
+gapfill_gap_tuple(GapFillState *state, TupleTableSlot *group_slot, TupleTableSlot *next_slot)
+{
+	TupleTableSlot *slot = state->csstate.ss.ss_ScanTupleSlot;
+	MemoryContext old;
+	int			i;
+
+	ExecClearTuple(slot);
+	old = MemoryContextSwitchTo(state->csstate.ss.ps.ps_ExprContext->ecxt_per_tuple_memory);
+
+	for (i = 0; i < state->ncolumns; i++)
+	{
+		switch (state->column_types[i])
+		{
+			case GAPFILL_COLUMN_BUCKET:
+				slot->tts_values[i] = TimestampGetDatum(state->next_bucket);
+				slot->tts_isnull[i] = false;
+				break;
+			case GAPFILL_COLUMN_GROUP:
+				slot->tts_values[i] = slot_getattr(group_slot, i + 1, &slot->tts_isnull[i]);
+				break;
+			case GAPFILL_COLUMN_LOCF:
+				if (state->have_prev)
+					slot->tts_values[i] = slot_getattr(state->prev_slot, i + 1, &slot->tts_isnull[i]);
+				else
+					slot->tts_isnull[i] = true;
+				break;
+			case GAPFILL_COLUMN_INTERPOLATE:
+				slot->tts_values[i] = gapfill_interpolate_value(state, i + 1, next_slot,
+																&slot->tts_isnull[i]);
+				break;
+			default:
+				slot->tts_isnull[i] = true;
+				break;
+		}
+	}
+
+	MemoryContextSwitchTo(old);
+	state->next_bucket += state->period;
+
+	return ExecStoreVirtualTuple(slot);
+}
+
+static TupleTableSlot *
+gapfill_project(GapFillState *state, TupleTableSlot *slot)
+{
+	ProjectionInfo *projinfo = state->csstate.ss.ps.ps_ProjInfo;
+#if PG96
+	ExprDoneCond isDone;
+#endif
+
+	if (NULL == projinfo)
+		return slot;
+
+	state->csstate.ss.ps.ps_ExprContext->ecxt_scantuple = slot;
+
+#if PG10
+	return ExecProject(projinfo);
+#elif PG96
+	return ExecProject(projinfo, &isDone);
+#endif
+}
+
+static TupleTableSlot *
+gapfill_exec(CustomScanState *node)
+{
+	GapFillState *state = (GapFillState *) node;
+	TupleTableSlot *slot;
+
+	ResetExprContext(node->ss.ps.ps_ExprContext);
+
+	if (NULL == state->pending && !state->subplan_done)
+		gapfill_fetch_next(state);
+
+	if (NULL == state->pending)
+	{
+		/*
+		 * Fill the end of the last group. Without grouping columns there is a
+		 * single group, which is filled even if the subplan returned nothing.
+		 */
+		if (state->next_bucket < state->finish &&
+			(state->have_prev || !state->has_groups))
+			return gapfill_project(state, gapfill_gap_tuple(state, state->prev_slot, NULL));
+
+		return NULL;
+	}
+
+	if (state->pending_new_group)
+	{
+		/* Fill the end of the previous group before starting the next one */
+		if (state->have_prev && state->next_bucket < state->finish)
+			return gapfill_project(state, gapfill_gap_tuple(state, state->prev_slot, NULL));
+
+		state->have_prev = false;
+		state->next_bucket = state->start;
+		state->pending_new_group = false;
+	}
+
+	/*
+	 * Fill the buckets before the pending tuple. A NULL bucket sorts last, so
+	 * the group is filled up to finish before it.
+	 */
+	if (state->next_bucket < state->finish &&
+		(state->pending_bucket_isnull || state->next_bucket < state->pending_bucket))
+		return gapfill_project(state,
+							   gapfill_gap_tuple(state, state->pending,
+												 state->pending_bucket_isnull ? NULL : state->pending));
+
+	slot = state->pending;
+	state->pending = NULL;
+
+	if (!state->pending_bucket_isnull)
+		state->next_bucket = Max(state->next_bucket, state->pending_bucket + state->period);
+
+	ExecCopySlot(state->prev_slot, slot);
+	state->have_prev = true;
+	state->prev_bucket = state->pending_bucket;
+	state->prev_bucket_isnull = state->pending_bucket_isnull;
+
+	return gapfill_project(state, slot);
+}
+
+static void
+gapfill_end(CustomScanState *node)
+{
+	ExecEndNode(linitial(node->custom_ps));
+}
+
+static void
+gapfill_rescan(CustomScanState *node)
+{
+	GapFillState *state = (GapFillState *) node;
+
+	ExecReScan(linitial(node->custom_ps));
+	gapfill_init_range(state);
+}
+
+static CustomExecMethods gapfill_state_methods = {
+	.CustomName = "GapFill",
+	.BeginCustomScan = gapfill_begin,
+	.ExecCustomScan = gapfill_exec,
+	.EndCustomScan = gapfill_end,
+	.ReScanCustomScan = gapfill_rescan,
+};
+
+static Node *
+gapfill_state_create(CustomScan *cscan)
+{
+	GapFillState *state;
+	ListCell   *lc;
+	int			i = 0;
+
+	state = (GapFillState *) newNode(sizeof(GapFillState), T_CustomScanState);
+	state->csstate.methods = &gapfill_state_methods;
+	state->ncolumns = list_length(cscan->custom_private);
+	state->column_types = palloc(sizeof(GapFillColumnType) * state->ncolumns);
+	state->bucket_attno = InvalidAttrNumber;
+
+	foreach(lc, cscan->custom_private)
+		state->column_types[i++] = lfirst_int(lc);
+
+	return (Node *) state;
+}
+
+static CustomScanMethods gapfill_plan_methods = {
+	.CustomName = "GapFill",
+	.CreateCustomScanState = gapfill_state_create,
+};
+
+void
+_gapfill_init(void)
+{
+	/* Needed to (de)serialize the plan */
+	RegisterCustomScanMethods(&gapfill_plan_methods);
+
+	/* time_bucket_gapfill(const, var, const, const) => var */
+	sort_transform_register_function("time_bucket_gapfill", 4, 1, NULL);
+}
+
+void
+_gapfill_fini(void)
+{
+}
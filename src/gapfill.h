@@ -0,0 +1,9 @@
+#ifndef TIMESCALEDB_GAPFILL_H
+#define TIMESCALEDB_GAPFILL_H
+
+#include <postgres.h>
+#include <nodes/relation.h>
+
+extern void plan_add_gapfill(PlannerInfo *root, RelOptInfo *group_rel);
+
+#endif							/* TIMESCALEDB_GAPFILL_H */
@@ -9,6 +9,12 @@ bool		guc_disable_optimizations = false;
 bool		guc_optimize_non_hypertables = false;
 bool		guc_restoring = false;
 bool		guc_constraint_aware_append = true;
+bool		guc_parallel_chunk_append = true;
+bool		guc_runtime_chunk_filter = true;
+bool		guc_bookend_index_scan = true;
+bool		guc_vector_agg = true;
+bool		guc_vector_filter = true;
+bool		guc_skip_scan = true;
 int			guc_max_open_chunks_per_insert = 10;
 int			guc_max_cached_chunks_per_hypertable = 10;
 
@@ -63,6 +69,66 @@ _guc_init(void)
 							 NULL,
 							 NULL);
 
+	DefineCustomBoolVariable("timescaledb.parallel_chunk_append", "Enable parallel-aware chunk append",
+							 "Hand out chunks to parallel workers in constraint-aware append scans",
+							 &guc_parallel_chunk_append,
+							 true,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomBoolVariable("timescaledb.runtime_chunk_filter", "Enable runtime chunk filtering in hash joins",
+							 "Skip hypertable chunks that cannot match the build side of a hash join",
+							 &guc_runtime_chunk_filter,
+							 true,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomBoolVariable("timescaledb.bookend_index_scan", "Enable index scans for first() and last()",
+							 "Answer ungrouped first() and last() aggregates with ordered index scans",
+							 &guc_bookend_index_scan,
+							 true,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomBoolVariable("timescaledb.vector_agg", "Enable vectorized aggregation",
+							 "Aggregate compressed chunks directly on decompressed column batches",
+							 &guc_vector_agg,
+							 true,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomBoolVariable("timescaledb.vector_filter", "Enable vectorized filtering",
+							 "Evaluate simple comparisons on chunk scans a page of tuples at a time",
+							 &guc_vector_filter,
+							 true,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
+	DefineCustomBoolVariable("timescaledb.skip_scan", "Enable skip scans for DISTINCT",
+							 "Find the distinct values of the leading column of an index with one index descent per value",
+							 &guc_skip_scan,
+							 true,
+							 PGC_USERSET,
+							 0,
+							 NULL,
+							 NULL,
+							 NULL);
+
 	DefineCustomIntVariable("timescaledb.max_open_chunks_per_insert",
 							"Maximum open chunks per insert",
 							"Maximum number of open chunk tables per insert",
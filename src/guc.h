@@ -5,6 +5,12 @@
 extern bool guc_disable_optimizations;
 extern bool guc_optimize_non_hypertables;
 extern bool guc_constraint_aware_append;
+extern bool guc_parallel_chunk_append;
+extern bool guc_runtime_chunk_filter;
+extern bool guc_bookend_index_scan;
+extern bool guc_vector_agg;
+extern bool guc_vector_filter;
+extern bool guc_skip_scan;
 extern bool guc_restoring;
 extern int	guc_max_open_chunks_per_insert;
 extern int	guc_max_cached_chunks_per_hypertable;
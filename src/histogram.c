@@ -2,13 +2,12 @@
 #include <catalog/pg_type.h>
 #include <utils/builtins.h>
 #include <utils/array.h>
-#include "nodes/makefuncs.h"
-#include "utils/lsyscache.h"
-#include <netinet/in.h>
+#include <lib/stringinfo.h>
+#include <libpq/pqformat.h>
+#include <math.h>
 
 #include "compat.h"
-
-#define HIST_LEN(state) ((VARSIZE(state) - VARHDRSZ ) / sizeof(Datum))
+#include "histogram.h"
 
 /* aggregate histogram:
  *	 histogram(state, val, min, max, nbuckets) returns the histogram array with nbuckets
@@ -24,26 +23,115 @@
  */
 
 TS_FUNCTION_INFO_V1(hist_sfunc);
+TS_FUNCTION_INFO_V1(hist_msfunc);
+TS_FUNCTION_INFO_V1(hist_minvfunc);
 TS_FUNCTION_INFO_V1(hist_combinefunc);
 TS_FUNCTION_INFO_V1(hist_serializefunc);
 TS_FUNCTION_INFO_V1(hist_deserializefunc);
 TS_FUNCTION_INFO_V1(hist_finalfunc);
 
+Histogram *
+histogram_create(MemoryContext mcxt, int32 nbuckets, double min, double max)
+{
+	Histogram  *hist = MemoryContextAllocZero(mcxt, HISTOGRAM_SIZE(nbuckets));
+
+	hist->nbuckets = nbuckets;
+	hist->min = min;
+	hist->max = max;
+
+	return hist;
+}
+
+static Histogram *
+histogram_copy(MemoryContext mcxt, Histogram *hist)
+{
+	Histogram  *copy = MemoryContextAlloc(mcxt, HISTOGRAM_SIZE(hist->nbuckets));
+
+	memcpy(copy, hist, HISTOGRAM_SIZE(hist->nbuckets));
+
+	return copy;
+}
+
+/*
+ * Check the bounds and number of buckets of a histogram. Errors are the same
+ * as those of width_bucket().
+ */
+void
+histogram_check_args(double min, double max, int32 nbuckets)
+{
+	if (nbuckets <= 0 || nbuckets > PG_INT32_MAX - 2)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_ARGUMENT_FOR_WIDTH_BUCKET_FUNCTION),
+				 errmsg("count must be greater than zero")));
+
+	if (isnan(min) || isnan(max))
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_ARGUMENT_FOR_WIDTH_BUCKET_FUNCTION),
+				 errmsg("operand, lower bound, and upper bound cannot be NaN")));
+
+	if (isinf(min) || isinf(max))
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_ARGUMENT_FOR_WIDTH_BUCKET_FUNCTION),
+				 errmsg("lower and upper bounds must be finite")));
+
+	if (min == max)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_ARGUMENT_FOR_WIDTH_BUCKET_FUNCTION),
+				 errmsg("lower bound cannot equal upper bound")));
+
+	if (min > max)
+	{
+		/* cannot generate a histogram with incompatible bounds */
+		elog(ERROR, "lower bound cannot exceed upper bound");
+	}
+}
+
+/*
+ * Get the histogram state for a row, creating it on the first row. Returns
+ * NULL if the row should be skipped.
+ */
+static Histogram *
+histogram_for_row(Histogram *hist, MemoryContext aggcontext, FunctionCallInfo fcinfo)
+{
+	double		min;
+	double		max;
+	int32		nbuckets;
+
+	if (PG_ARGISNULL(1) || PG_ARGISNULL(2) || PG_ARGISNULL(3) || PG_ARGISNULL(4))
+		return NULL;
+
+	min = PG_GETARG_FLOAT8(2);
+	max = PG_GETARG_FLOAT8(3);
+	nbuckets = PG_GETARG_INT32(4);
+
+	if (hist == NULL)
+	{
+		histogram_check_args(min, max, nbuckets);
+		return histogram_create(aggcontext, nbuckets, min, max);
+	}
+
+	/* the bounds are normally constant, so only check them when they change */
+	if (hist->min != min || hist->max != max || hist->nbuckets != nbuckets)
+	{
+		histogram_check_args(min, max, nbuckets);
+
+		if (hist->nbuckets != nbuckets)
+			elog(ERROR, "number of histogram buckets cannot change between rows");
+
+		hist->min = min;
+		hist->max = max;
+	}
+
+	return hist;
+}
+
 /* histogram(state, val, min, max, nbuckets) */
 Datum
 hist_sfunc(PG_FUNCTION_ARGS)
 {
 	MemoryContext aggcontext;
-	bytea	   *state = (PG_ARGISNULL(0) ? NULL : PG_GETARG_BYTEA_P(0));
-	Datum	   *hist;
-	Datum		val_datum = PG_GETARG_DATUM(1);
-	Datum		min_datum = PG_GETARG_DATUM(2);
-	Datum		max_datum = PG_GETARG_DATUM(3);
-	Datum		nbuckets_datum = PG_GETARG_DATUM(4);
-	double		min = DatumGetFloat8(min_datum);
-	double		max = DatumGetFloat8(max_datum);
-	int			nbuckets = DatumGetInt32(nbuckets_datum);
-	int32		bucket = DatumGetInt32(DirectFunctionCall4(width_bucket_float8, val_datum, min_datum, max_datum, nbuckets_datum));
+	Histogram  *state = PG_ARGISNULL(0) ? NULL : (Histogram *) PG_GETARG_POINTER(0);
+	Histogram  *hist;
 
 	if (!AggCheckCallContext(fcinfo, &aggcontext))
 	{
@@ -51,40 +139,80 @@ hist_sfunc(PG_FUNCTION_ARGS)
 		elog(ERROR, "hist_sfunc called in non-aggregate context");
 	}
 
-	if (min > max)
+	hist = histogram_for_row(state, aggcontext, fcinfo);
+
+	if (hist == NULL)
 	{
-		/* cannot generate a histogram with incompatible bounds */
-		elog(ERROR, "lower bound cannot exceed upper bound");
+		if (state == NULL)
+			PG_RETURN_NULL();
+		PG_RETURN_POINTER(state);
 	}
 
-	if (state == NULL)
+	/* Increment the proper histogram bucket */
+	hist->counts[histogram_bucket(hist, PG_GETARG_FLOAT8(1))]++;
+
+	PG_RETURN_POINTER(hist);
+}
+
+/*
+ * hist_msfunc(state, val, min, max, nbuckets) - hist_sfunc for moving aggregates
+ *
+ * A moving-aggregate transition function must not return NULL, so a window
+ * frame that starts with skipped rows gets a histogram without buckets. It is
+ * replaced by a real histogram on the first row that is counted.
+ */
+Datum
+hist_msfunc(PG_FUNCTION_ARGS)
+{
+	MemoryContext aggcontext;
+	Histogram  *state = PG_ARGISNULL(0) ? NULL : (Histogram *) PG_GETARG_POINTER(0);
+	Histogram  *hist;
+
+	if (!AggCheckCallContext(fcinfo, &aggcontext))
 	{
-		/* Allocate memory to a new histogram state array */
-		Size		arrsize = sizeof(Datum) * (nbuckets + 2);
+		/* cannot be called directly because of internal-type argument */
+		elog(ERROR, "hist_msfunc called in non-aggregate context");
+	}
 
-		state = MemoryContextAllocZero(aggcontext, VARHDRSZ + arrsize);
-		SET_VARSIZE(state, VARHDRSZ + arrsize);
+	hist = histogram_for_row(state != NULL && state->nbuckets > 0 ? state : NULL,
+							 aggcontext, fcinfo);
+
+	if (hist == NULL)
+	{
+		if (state == NULL)
+			PG_RETURN_POINTER(histogram_create(aggcontext, 0, 0, 0));
+		PG_RETURN_POINTER(state);
 	}
 
-	/* Increment the proper histogram bucket */
-	hist = (Datum *) VARDATA(state);
-	hist[bucket] = Int32GetDatum(DatumGetInt32(hist[bucket]) + 1);
+	hist->counts[histogram_bucket(hist, PG_GETARG_FLOAT8(1))]++;
 
-	PG_RETURN_BYTEA_P(state);
+	PG_RETURN_POINTER(hist);
 }
 
-/* Make a copy of the bytea state */
-static inline bytea *
-copy_state(MemoryContext aggcontext, bytea *state)
+/* hist_minvfunc(state, val, min, max, nbuckets) - inverse of hist_sfunc for moving aggregates */
+Datum
+hist_minvfunc(PG_FUNCTION_ARGS)
 {
-	bytea	   *copy;
-	Size		arrsize = VARSIZE(state) - VARHDRSZ;
+	MemoryContext aggcontext;
+	Histogram  *state = PG_ARGISNULL(0) ? NULL : (Histogram *) PG_GETARG_POINTER(0);
+	Histogram  *hist;
+
+	if (!AggCheckCallContext(fcinfo, &aggcontext))
+	{
+		/* cannot be called directly because of internal-type argument */
+		elog(ERROR, "hist_minvfunc called in non-aggregate context");
+	}
 
-	copy = MemoryContextAllocZero(aggcontext, VARHDRSZ + arrsize);
-	SET_VARSIZE(copy, VARHDRSZ + arrsize);
-	memcpy(copy, state, VARHDRSZ + arrsize);
+	if (state == NULL)
+		elog(ERROR, "histogram inverse transition called without a state");
 
-	return copy;
+	hist = histogram_for_row(state, aggcontext, fcinfo);
+
+	/* Decrement the bucket of the row leaving the window frame */
+	if (hist != NULL)
+		hist->counts[histogram_bucket(hist, PG_GETARG_FLOAT8(1))]--;
+
+	PG_RETURN_POINTER(state);
 }
 
 /* hist_combinefunc(internal, internal) => internal */
@@ -92,10 +220,9 @@ Datum
 hist_combinefunc(PG_FUNCTION_ARGS)
 {
 	MemoryContext aggcontext;
-
-	bytea	   *state1 = (PG_ARGISNULL(0) ? NULL : PG_GETARG_BYTEA_P(0));
-	bytea	   *state2 = (PG_ARGISNULL(1) ? NULL : PG_GETARG_BYTEA_P(1));
-	bytea	   *result;
+	Histogram  *state1 = PG_ARGISNULL(0) ? NULL : (Histogram *) PG_GETARG_POINTER(0);
+	Histogram  *state2 = PG_ARGISNULL(1) ? NULL : (Histogram *) PG_GETARG_POINTER(1);
+	int32		i;
 
 	if (!AggCheckCallContext(fcinfo, &aggcontext))
 	{
@@ -105,80 +232,121 @@ hist_combinefunc(PG_FUNCTION_ARGS)
 
 	if (state2 == NULL)
 	{
-		result = copy_state(aggcontext, state1);
-	}
-
-	else if (state1 == NULL)
-	{
-		result = copy_state(aggcontext, state2);
+		if (state1 == NULL)
+			PG_RETURN_NULL();
+		PG_RETURN_POINTER(state1);
 	}
 
-	else
-	{
-		Size		i;
-		Datum	   *hist,
-				   *hist_other;
+	/* state2 might not live in the aggregate context, so copy it */
+	if (state1 == NULL)
+		PG_RETURN_POINTER(histogram_copy(aggcontext, state2));
 
-		result = copy_state(aggcontext, state1);
-		hist = (Datum *) VARDATA(result);
-		hist_other = (Datum *) VARDATA(state2);
+	if (state1->nbuckets != state2->nbuckets)
+		elog(ERROR, "cannot combine histograms with different numbers of buckets");
 
-		/* Combine values from state1 and state2 when both states are non-null */
-		for (i = 0; i < HIST_LEN(state1); i++)
-			hist[i] = Int32GetDatum(DatumGetInt32(hist[i]) + DatumGetInt32(hist_other[i]));
-	}
+	/* Combine state2 into state1 in place */
+	for (i = 0; i < state1->nbuckets + 2; i++)
+		state1->counts[i] += state2->counts[i];
 
-	PG_RETURN_BYTEA_P(result);
+	PG_RETURN_POINTER(state1);
 }
 
 /* hist_serializefunc(internal) => bytea */
 Datum
 hist_serializefunc(PG_FUNCTION_ARGS)
 {
-	bytea	   *state;
-	Datum	   *hist;
-	Size		i;
+	Histogram  *state;
+	StringInfoData buf;
+	int32		i;
 
 	Assert(!PG_ARGISNULL(0));
-	state = PG_GETARG_BYTEA_P(0);
-	hist = (Datum *) VARDATA(state);
+	state = (Histogram *) PG_GETARG_POINTER(0);
 
-	for (i = 0; i < HIST_LEN(state); i++)
-	{
-		hist[i] = Int32GetDatum(htonl(DatumGetInt32(hist[i])));
-	}
+	pq_begintypsend(&buf);
+	pq_sendint(&buf, state->nbuckets, 4);
+	pq_sendfloat8(&buf, state->min);
+	pq_sendfloat8(&buf, state->max);
+
+	for (i = 0; i < state->nbuckets + 2; i++)
+		pq_sendint64(&buf, state->counts[i]);
 
-	PG_RETURN_BYTEA_P(state);
+	PG_RETURN_BYTEA_P(pq_endtypsend(&buf));
 }
 
 /* hist_deserializefunc(bytea, internal) => internal */
 Datum
 hist_deserializefunc(PG_FUNCTION_ARGS)
 {
-	bytea	   *state;
-	Datum	   *hist;
-	Size		i;
+	bytea	   *sstate;
+	StringInfoData buf;
+	Histogram  *state;
+	int32		nbuckets;
+	double		min;
+	double		max;
+	int32		i;
 
 	Assert(!PG_ARGISNULL(0));
-	state = PG_GETARG_BYTEA_P(0);
-	hist = (Datum *) VARDATA(state);
+	sstate = PG_GETARG_BYTEA_P(0);
+
+	/* Set up a StringInfo pointing into the bytea, which is not modified */
+	buf.data = VARDATA(sstate);
+	buf.len = VARSIZE(sstate) - VARHDRSZ;
+	buf.maxlen = buf.len;
+	buf.cursor = 0;
+
+	nbuckets = pq_getmsgint(&buf, 4);
+	min = pq_getmsgfloat8(&buf);
+	max = pq_getmsgfloat8(&buf);
+
+	if (nbuckets <= 0 || (Size) (buf.len - buf.cursor) != sizeof(int64) * ((Size) nbuckets + 2))
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+				 errmsg("invalid histogram state")));
+
+	state = histogram_create(CurrentMemoryContext, nbuckets, min, max);
+
+	for (i = 0; i < nbuckets + 2; i++)
+		state->counts[i] = pq_getmsgint64(&buf);
+
+	pq_getmsgend(&buf);
+
+	PG_RETURN_POINTER(state);
+}
+
+/*
+ * Convert the counts of a histogram into the integer array returned by
+ * histogram().
+ */
+ArrayType *
+histogram_to_array(Histogram *hist)
+{
+	Datum	   *counts = palloc(sizeof(Datum) * (hist->nbuckets + 2));
+	int			dims[1];
+	int			lbs[1];
+	int32		i;
 
-	for (i = 0; i < HIST_LEN(state); i++)
+	for (i = 0; i < hist->nbuckets + 2; i++)
 	{
-		hist[i] = Int32GetDatum(ntohl(DatumGetInt32(hist[i])));
+		if (hist->counts[i] > PG_INT32_MAX)
+			ereport(ERROR,
+					(errcode(ERRCODE_NUMERIC_VALUE_OUT_OF_RANGE),
+					 errmsg("histogram bucket count out of range for an integer array")));
+
+		counts[i] = Int32GetDatum((int32) hist->counts[i]);
 	}
 
-	PG_RETURN_BYTEA_P(state);
+	dims[0] = hist->nbuckets + 2;
+	lbs[0] = 1;
+
+	return construct_md_array(counts, NULL, 1, dims, lbs, INT4OID, 4, true, 'i');
 }
 
 /* hist_funalfunc(internal, val REAL, MIN REAL, MAX REAL, nbuckets INTEGER) => INTEGER[] */
 Datum
 hist_finalfunc(PG_FUNCTION_ARGS)
 {
-	bytea	   *state;
-	Datum	   *hist;
-	int			dims[1];
-	int			lbs[1];
+	Histogram  *hist;
+	int32		i;
 
 	if (!AggCheckCallContext(fcinfo, NULL))
 	{
@@ -189,11 +357,16 @@ hist_finalfunc(PG_FUNCTION_ARGS)
 	if (PG_ARGISNULL(0))
 		PG_RETURN_NULL();
 
-	state = PG_GETARG_BYTEA_P(0);
-	hist = (Datum *) VARDATA(state);
+	hist = (Histogram *) PG_GETARG_POINTER(0);
 
-	dims[0] = HIST_LEN(state);
-	lbs[0] = 1;
+	/*
+	 * Moving aggregates keep their state when all counted rows have left the
+	 * window frame. Return NULL for such frames, like for any set of rows
+	 * without a counted value.
+	 */
+	for (i = 0; i < hist->nbuckets + 2; i++)
+		if (hist->counts[i] != 0)
+			PG_RETURN_ARRAYTYPE_P(histogram_to_array(hist));
 
-	PG_RETURN_ARRAYTYPE_P(construct_md_array(hist, NULL, 1, dims, lbs, INT4OID, 4, true, 'i'));
+	PG_RETURN_NULL();
 }
@@ -0,0 +1,48 @@
+#ifndef TIMESCALEDB_HISTOGRAM_H
+#define TIMESCALEDB_HISTOGRAM_H
+
+#include <postgres.h>
+#include <utils/array.h>
+#include <math.h>
+
+/*
+ * Internal state for histograms. The counts are 64-bit so that they cannot
+ * overflow, no matter how many rows are aggregated.
+ */
+typedef struct Histogram
+{
+	int32		nbuckets;		/* number of buckets within the range */
+	double		min;			/* bounds the histogram was created with */
+	double		max;
+	int64		counts[FLEXIBLE_ARRAY_MEMBER];	/* nbuckets + 2 counts */
+} Histogram;
+
+#define HISTOGRAM_SIZE(nbuckets) \
+	(offsetof(Histogram, counts) + sizeof(int64) * ((nbuckets) + 2))
+
+extern Histogram *histogram_create(MemoryContext mcxt, int32 nbuckets, double min, double max);
+extern void histogram_check_args(double min, double max, int32 nbuckets);
+extern ArrayType *histogram_to_array(Histogram *hist);
+
+/*
+ * Compute the bucket of a value, like width_bucket(val, min, max, nbuckets)
+ * for min < max.
+ */
+static inline int32
+histogram_bucket(Histogram *hist, double val)
+{
+	if (isnan(val))
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_ARGUMENT_FOR_WIDTH_BUCKET_FUNCTION),
+				 errmsg("operand, lower bound, and upper bound cannot be NaN")));
+
+	if (val < hist->min)
+		return 0;
+
+	if (val >= hist->max)
+		return hist->nbuckets + 1;
+
+	return (int32) (((double) hist->nbuckets * (val - hist->min) / (hist->max - hist->min)) + 1);
+}
+
+#endif							/* TIMESCALEDB_HISTOGRAM_H */
@@ -0,0 +1,456 @@
+#include <postgres.h>
+#include <fmgr.h>
+#include <lib/stringinfo.h>
+#include <libpq/pqformat.h>
+#include <utils/builtins.h>
+#include <utils/lsyscache.h>
+#include <utils/typcache.h>
+#include <math.h>
+
+#include "compat.h"
+
+/* aggregate hyperloglog:
+ *	 hyperloglog(val [, precision]) returns a sketch of the distinct values of val
+ *	 hyperloglog_union(sketch) returns the union of several sketches
+ *	 distinct_count(sketch) returns the approximate number of distinct values in a sketch
+ *
+ * Usage:
+ *	 SELECT grouping_element, distinct_count(hyperloglog(field))
+ *	 FROM table GROUP BY grouping_element;
+ *
+ * Description:
+ * A HyperLogLog sketch hashes every value and keeps, for each of 2^precision registers, the
+ * longest run of leading zeros seen in the hashes assigned to the register. The number of
+ * distinct values is estimated from the registers with a standard error of about
+ * 1.04 / sqrt(2^precision), i.e., 1.6% for the default precision of 12. Unlike
+ * count(DISTINCT), no values are sorted or kept in a hash table, and sketches can be
+ * combined, so the aggregate can run in parallel. Sketches are returned as bytea so that
+ * they can be stored in tables and merged later with hyperloglog_union().
+ */
+
+TS_FUNCTION_INFO_V1(hll_sfunc);
+TS_FUNCTION_INFO_V1(hll_union_sfunc);
+TS_FUNCTION_INFO_V1(hll_combinefunc);
+TS_FUNCTION_INFO_V1(hll_serializefunc);
+TS_FUNCTION_INFO_V1(hll_deserializefunc);
+TS_FUNCTION_INFO_V1(hll_finalfunc);
+TS_FUNCTION_INFO_V1(hll_distinct_count);
+
+#define HLL_FORMAT_VERSION 1
+#define HLL_DEFAULT_PRECISION 12
+#define HLL_MIN_PRECISION 4
+#define HLL_MAX_PRECISION 16
+
+/*
+ * Serialized sketches with few non-zero registers only store those registers,
+ * as (index, value) pairs of three bytes.
+ */
+#define HLL_ENCODING_SPARSE 1
+#define HLL_ENCODING_DENSE 2
+#define HLL_SPARSE_ENTRY_SIZE 3
+
+typedef struct HyperLogLog
+{
+	int32		precision;
+	int32		nregisters;		/* 2^precision */
+	uint8		registers[FLEXIBLE_ARRAY_MEMBER];
+} HyperLogLog;
+
+#define HLL_SIZE(nregisters) \
+	(offsetof(HyperLogLog, registers) + sizeof(uint8) * (nregisters))
+
+static void
+hll_check_precision(int32 precision)
+{
+	if (precision < HLL_MIN_PRECISION || precision > HLL_MAX_PRECISION)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("precision must be between %d and %d",
+						HLL_MIN_PRECISION, HLL_MAX_PRECISION)));
+}
+
+static HyperLogLog *
+hll_create(MemoryContext mcxt, int32 precision)
+{
+	HyperLogLog *hll = MemoryContextAllocZero(mcxt, HLL_SIZE(1 << precision));
+
+	hll->precision = precision;
+	hll->nregisters = 1 << precision;
+
+	return hll;
+}
+
+static HyperLogLog *
+hll_copy(MemoryContext mcxt, HyperLogLog *hll)
+{
+	HyperLogLog *copy = MemoryContextAlloc(mcxt, HLL_SIZE(hll->nregisters));
+
+	memcpy(copy, hll, HLL_SIZE(hll->nregisters));
+
+	return copy;
+}
+
+/*
+ * Add a hash to a sketch. The first bits of the hash select the register and
+ * the register keeps the highest position of the first set bit among the
+ * remaining bits.
+ */
+static inline void
+hll_add_hash(HyperLogLog *hll, uint32 hash)
+{
+	uint32		index = hash >> (32 - hll->precision);
+	uint32		bits = hash << hll->precision;
+	uint8		rank = 1;
+
+	while (rank <= 32 - hll->precision && (bits & 0x80000000) == 0)
+	{
+		bits <<= 1;
+		rank++;
+	}
+
+	if (rank > hll->registers[index])
+		hll->registers[index] = rank;
+}
+
+static void
+hll_merge(HyperLogLog *into, HyperLogLog *from)
+{
+	int32		i;
+
+	if (into->precision != from->precision)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("cannot combine hyperloglog sketches with different precisions")));
+
+	for (i = 0; i < into->nregisters; i++)
+		if (from->registers[i] > into->registers[i])
+			into->registers[i] = from->registers[i];
+}
+
+static int64
+hll_estimate(HyperLogLog *hll)
+{
+	double		m = hll->nregisters;
+	double		alpha;
+	double		sum = 0;
+	int32		zeros = 0;
+	double		estimate;
+	int32		i;
+
+	switch (hll->nregisters)
+	{
+		case 16:
+			alpha = 0.673;
+			break;
+		case 32:
+			alpha = 0.697;
+			break;
+		case 64:
+			alpha = 0.709;
+			break;
+		default:
+			alpha = 0.7213 / (1 + 1.079 / m);
+			break;
+	}
+
+	for (i = 0; i < hll->nregisters; i++)
+	{
+		sum += ldexp(1.0, -hll->registers[i]);
+
+		if (hll->registers[i] == 0)
+			zeros++;
+	}
+
+	estimate = alpha * m * m / sum;
+
+	/* Use linear counting for small cardinalities */
+	if (estimate <= 2.5 * m && zeros > 0)
+		estimate = m * log(m / zeros);
+	/* Correct for hash collisions for cardinalities close to 2^32 */
+	else if (estimate > 4294967296.0 / 30)
+		estimate = -4294967296.0 * log(1 - estimate / 4294967296.0);
+
+	return (int64) rint(estimate);
+}
+
+static bytea *
+hll_serialize(HyperLogLog *hll)
+{
+	StringInfoData buf;
+	int32		nonzero = 0;
+	int32		i;
+
+	for (i = 0; i < hll->nregisters; i++)
+		if (hll->registers[i] != 0)
+			nonzero++;
+
+	pq_begintypsend(&buf);
+	pq_sendbyte(&buf, HLL_FORMAT_VERSION);
+	pq_sendbyte(&buf, hll->precision);
+
+	if (nonzero * HLL_SPARSE_ENTRY_SIZE < hll->nregisters)
+	{
+		pq_sendbyte(&buf, HLL_ENCODING_SPARSE);
+		pq_sendint(&buf, nonzero, 4);
+
+		for (i = 0; i < hll->nregisters; i++)
+		{
+			if (hll->registers[i] != 0)
+			{
+				pq_sendint(&buf, i, 2);
+				pq_sendbyte(&buf, hll->registers[i]);
+			}
+		}
+	}
+	else
+	{
+		pq_sendbyte(&buf, HLL_ENCODING_DENSE);
+		pq_sendbytes(&buf, (char *) hll->registers, hll->nregisters);
+	}
+
+	return pq_endtypsend(&buf);
+}
+
+static HyperLogLog *
+hll_deserialize(bytea *sstate, MemoryContext mcxt)
+{
+	StringInfoData buf;
+	HyperLogLog *hll;
+	int32		precision;
+	int32		encoding;
+	int32		i;
+
+	/* Set up a StringInfo pointing into the bytea, which is not modified */
+	buf.data = VARDATA_ANY(sstate);
+	buf.len = VARSIZE_ANY_EXHDR(sstate);
+	buf.maxlen = buf.len;
+	buf.cursor = 0;
+
+	if (buf.len < 3 || pq_getmsgbyte(&buf) != HLL_FORMAT_VERSION)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+				 errmsg("invalid hyperloglog sketch")));
+
+	precision = pq_getmsgbyte(&buf);
+	encoding = pq_getmsgbyte(&buf);
+
+	if (precision < HLL_MIN_PRECISION || precision > HLL_MAX_PRECISION)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+				 errmsg("invalid hyperloglog sketch")));
+
+	hll = hll_create(mcxt, precision);
+
+	if (encoding == HLL_ENCODING_SPARSE)
+	{
+		int32		nonzero = pq_getmsgint(&buf, 4);
+
+		if (nonzero < 0 || nonzero > hll->nregisters)
+			ereport(ERROR,
+					(errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+					 errmsg("invalid hyperloglog sketch")));
+
+		for (i = 0; i < nonzero; i++)
+		{
+			uint16		index = pq_getmsgint(&buf, 2);
+
+			if (index >= hll->nregisters)
+				ereport(ERROR,
+						(errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+						 errmsg("invalid hyperloglog sketch")));
+
+			hll->registers[index] = pq_getmsgbyte(&buf);
+		}
+	}
+	else if (encoding == HLL_ENCODING_DENSE)
+		pq_copymsgbytes(&buf, (char *) hll->registers, hll->nregisters);
+	else
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+				 errmsg("invalid hyperloglog sketch")));
+
+	pq_getmsgend(&buf);
+
+	for (i = 0; i < hll->nregisters; i++)
+		if (hll->registers[i] > 33 - precision)
+			ereport(ERROR,
+					(errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+					 errmsg("invalid hyperloglog sketch")));
+
+	return hll;
+}
+
+/*
+ * Get the type's hash function, cached in fn_extra.
+ */
+static FmgrInfo *
+hll_get_hash_proc(FunctionCallInfo fcinfo)
+{
+	TypeCacheEntry *tce = fcinfo->flinfo->fn_extra;
+
+	if (tce == NULL)
+	{
+		Oid			type = get_fn_expr_argtype(fcinfo->flinfo, 1);
+
+		tce = lookup_type_cache(type, TYPECACHE_HASH_PROC_FINFO);
+
+		if (!OidIsValid(tce->hash_proc))
+			ereport(ERROR,
+					(errcode(ERRCODE_UNDEFINED_FUNCTION),
+					 errmsg("could not identify a hash function for type %s",
+							format_type_be(type))));
+
+		fcinfo->flinfo->fn_extra = tce;
+	}
+
+	return &tce->hash_proc_finfo;
+}
+
+/* hll_sfunc(state, val [, precision]) */
+Datum
+hll_sfunc(PG_FUNCTION_ARGS)
+{
+	MemoryContext aggcontext;
+	HyperLogLog *state = PG_ARGISNULL(0) ? NULL : (HyperLogLog *) PG_GETARG_POINTER(0);
+	FmgrInfo   *hash_proc;
+
+	if (!AggCheckCallContext(fcinfo, &aggcontext))
+	{
+		/* cannot be called directly because of internal-type argument */
+		elog(ERROR, "hll_sfunc called in non-aggregate context");
+	}
+
+	if (PG_ARGISNULL(1) || (PG_NARGS() > 2 && PG_ARGISNULL(2)))
+	{
+		if (state == NULL)
+			PG_RETURN_NULL();
+		PG_RETURN_POINTER(state);
+	}
+
+	if (state == NULL)
+	{
+		int32		precision = HLL_DEFAULT_PRECISION;
+
+		if (PG_NARGS() > 2)
+		{
+			precision = PG_GETARG_INT32(2);
+			hll_check_precision(precision);
+		}
+
+		state = hll_create(aggcontext, precision);
+	}
+	else if (PG_NARGS() > 2 && PG_GETARG_INT32(2) != state->precision)
+		elog(ERROR, "precision of a hyperloglog sketch cannot change between rows");
+
+	hash_proc = hll_get_hash_proc(fcinfo);
+	hll_add_hash(state, DatumGetUInt32(FunctionCall1Coll(hash_proc,
+														 PG_GET_COLLATION(),
+														 PG_GETARG_DATUM(1))));
+
+	PG_RETURN_POINTER(state);
+}
+
+/* hll_union_sfunc(state, sketch bytea) */
+Datum
+hll_union_sfunc(PG_FUNCTION_ARGS)
+{
+	MemoryContext aggcontext;
+	HyperLogLog *state = PG_ARGISNULL(0) ? NULL : (HyperLogLog *) PG_GETARG_POINTER(0);
+	HyperLogLog *hll;
+
+	if (!AggCheckCallContext(fcinfo, &aggcontext))
+	{
+		/* cannot be called directly because of internal-type argument */
+		elog(ERROR, "hll_union_sfunc called in non-aggregate context");
+	}
+
+	if (PG_ARGISNULL(1))
+	{
+		if (state == NULL)
+			PG_RETURN_NULL();
+		PG_RETURN_POINTER(state);
+	}
+
+	/* The first sketch is deserialized directly into the aggregate context */
+	if (state == NULL)
+		PG_RETURN_POINTER(hll_deserialize(PG_GETARG_BYTEA_PP(1), aggcontext));
+
+	hll = hll_deserialize(PG_GETARG_BYTEA_PP(1), CurrentMemoryContext);
+	hll_merge(state, hll);
+	pfree(hll);
+
+	PG_RETURN_POINTER(state);
+}
+
+/* hll_combinefunc(internal, internal) => internal */
+Datum
+hll_combinefunc(PG_FUNCTION_ARGS)
+{
+	MemoryContext aggcontext;
+	HyperLogLog *state1 = PG_ARGISNULL(0) ? NULL : (HyperLogLog *) PG_GETARG_POINTER(0);
+	HyperLogLog *state2 = PG_ARGISNULL(1) ? NULL : (HyperLogLog *) PG_GETARG_POINTER(1);
+
+	if (!AggCheckCallContext(fcinfo, &aggcontext))
+	{
+		/* cannot be called directly because of internal-type argument */
+		elog(ERROR, "hll_combinefunc called in non-aggregate context");
+	}
+
+	if (state2 == NULL)
+	{
+		if (state1 == NULL)
+			PG_RETURN_NULL();
+		PG_RETURN_POINTER(state1);
+	}
+
+	/* state2 might not live in the aggregate context, so copy it */
+	if (state1 == NULL)
+		PG_RETURN_POINTER(hll_copy(aggcontext, state2));
+
+	hll_merge(state1, state2);
+
+	PG_RETURN_POINTER(state1);
+}
+
+/* hll_serializefunc(internal) => bytea */
+Datum
+hll_serializefunc(PG_FUNCTION_ARGS)
+{
+	Assert(!PG_ARGISNULL(0));
+
+	PG_RETURN_BYTEA_P(hll_serialize((HyperLogLog *) PG_GETARG_POINTER(0)));
+}
+
+/* hll_deserializefunc(bytea, internal) => internal */
+Datum
+hll_deserializefunc(PG_FUNCTION_ARGS)
+{
+	Assert(!PG_ARGISNULL(0));
+
+	PG_RETURN_POINTER(hll_deserialize(PG_GETARG_BYTEA_PP(0), CurrentMemoryContext));
+}
+
+/* hll_finalfunc(internal, ...) => bytea */
+Datum
+hll_finalfunc(PG_FUNCTION_ARGS)
+{
+	if (!AggCheckCallContext(fcinfo, NULL))
+	{
+		/* cannot be called directly because of internal-type argument */
+		elog(ERROR, "hll_finalfunc called in non-aggregate context");
+	}
+
+	if (PG_ARGISNULL(0))
+		PG_RETURN_NULL();
+
+	PG_RETURN_BYTEA_P(hll_serialize((HyperLogLog *) PG_GETARG_POINTER(0)));
+}
+
+/* distinct_count(sketch BYTEA) => BIGINT */
+Datum
+hll_distinct_count(PG_FUNCTION_ARGS)
+{
+	HyperLogLog *hll = hll_deserialize(PG_GETARG_BYTEA_PP(0), CurrentMemoryContext);
+
+	PG_RETURN_INT64(hll_estimate(hll));
+}
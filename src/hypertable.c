@@ -33,6 +33,10 @@
 #include "guc.h"
 #include "errors.h"
 #include "copy.h"
+#include "minmax_index.h"
+#include "bloom_filter.h"
+#include "continuous_agg.h"
+#include "last_point_cache.h"
 
 Oid
 rel_get_owner(Oid relid)
@@ -86,6 +90,10 @@ hypertable_from_tuple(HeapTuple tuple)
 	namespace_oid = get_namespace_oid(NameStr(h->fd.schema_name), false);
 	h->main_table_relid = get_relname_relid(NameStr(h->fd.table_name), namespace_oid);
 	h->space = dimension_scan(h->fd.id, h->main_table_relid, h->fd.num_dimensions);
+	h->minmax_indexes = minmax_index_scan_by_hypertable_id(h->fd.id, h->main_table_relid);
+	h->bloom_filters = bloom_filter_scan_by_hypertable_id(h->fd.id, h->main_table_relid);
+	h->continuous_aggs = continuous_agg_scan_by_hypertable_id(h->fd.id);
+	h->last_point_cache = last_point_cache_get_by_hypertable_id(h->fd.id, h->main_table_relid);
 	h->chunk_cache = subspace_store_init(h->space, CurrentMemoryContext, guc_max_cached_chunks_per_hypertable);
 
 	return h;
@@ -271,6 +279,10 @@ hypertable_tuple_delete(TupleInfo *ti, void *data)
 
 	tablespace_delete(hypertable_id, NULL);
 	chunk_delete_by_hypertable_id(hypertable_id);
+	minmax_index_delete_by_hypertable_id(hypertable_id);
+	bloom_filter_delete_by_hypertable_id(hypertable_id);
+	continuous_agg_delete_by_hypertable_id(hypertable_id);
+	last_point_cache_delete_by_hypertable_id(hypertable_id);
 	dimension_delete_by_hypertable_id(hypertable_id, true);
 
 	catalog_become_owner(catalog_get(), &sec_ctx);
@@ -614,6 +626,116 @@ hypertable_get_chunk(Hypertable *h, Point *point)
 	return cce->chunk;
 }
 
+typedef struct ChunkCubeEntry
+{
+	Oid			chunk_relid;
+	int32		chunk_id;
+	Hypercube  *cube;
+} ChunkCubeEntry;
+
+/*
+ * Get the cached entry of a chunk given the chunk's relid. The entry has a
+ * NULL hypercube if the relation is not a chunk.
+ *
+ * The hypercubes are cached with the hypertable so that planning a query does
+ * not need to scan the chunk catalogs for every chunk each time. Since the
+ * hypertable is part of the hypertable cache, the hypercubes are invalidated
+ * along with it whenever chunks or dimension slices are updated or
+ * deleted. New chunks simply get new entries.
+ */
+static ChunkCubeEntry *
+hypertable_get_chunk_cube_entry(Hypertable *h, Oid chunk_relid)
+{
+	MemoryContext mcxt = subspace_store_mcxt(h->chunk_cache);
+	MemoryContext old_mcxt;
+	ChunkCubeEntry *entry;
+	Chunk	   *chunk;
+
+	if (NULL == h->chunk_cubes)
+	{
+		HASHCTL		ctl = {
+			.keysize = sizeof(Oid),
+			.entrysize = sizeof(ChunkCubeEntry),
+			.hcxt = mcxt,
+		};
+
+		h->chunk_cubes = hash_create("chunk cube cache", 64, &ctl,
+									 HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
+	}
+
+	entry = hash_search(h->chunk_cubes, &chunk_relid, HASH_FIND, NULL);
+
+	if (NULL != entry)
+		return entry;
+
+	/* Scan the catalog on the caller's memory context */
+	chunk = chunk_get_by_relid(chunk_relid, h->space->num_dimensions, false);
+
+	old_mcxt = MemoryContextSwitchTo(mcxt);
+
+	entry = hash_search(h->chunk_cubes, &chunk_relid, HASH_ENTER, NULL);
+	entry->chunk_id = 0;
+	entry->cube = NULL;
+
+	if (NULL != chunk && NULL != chunk->cube)
+	{
+		entry->chunk_id = chunk->fd.id;
+		entry->cube = hypercube_copy(chunk->cube);
+	}
+
+	MemoryContextSwitchTo(old_mcxt);
+
+	return entry;
+}
+
+/*
+ * Get the hypercube of a chunk given the chunk's relid, or NULL if the
+ * relation is not a chunk.
+ */
+Hypercube *
+hypertable_get_chunk_cube(Hypertable *h, Oid chunk_relid)
+{
+	return hypertable_get_chunk_cube_entry(h, chunk_relid)->cube;
+}
+
+/*
+ * Get the ID of a chunk given the chunk's relid, or 0 if the relation is not
+ * a chunk.
+ */
+int32
+hypertable_get_chunk_id(Hypertable *h, Oid chunk_relid)
+{
+	return hypertable_get_chunk_cube_entry(h, chunk_relid)->chunk_id;
+}
+
+/*
+ * Get the relids of the chunks of a hypertable, i.e., its inheritance
+ * children.
+ *
+ * The list is read from pg_inherits once and then cached with the
+ * hypertable. Creating or deleting a chunk invalidates the hypertable cache,
+ * so the list is read again after chunks are added or removed. The returned
+ * list belongs to the cache and must not be modified.
+ */
+List *
+hypertable_get_chunk_relids(Hypertable *h)
+{
+	MemoryContext old_mcxt;
+	List	   *children;
+
+	if (h->chunk_relids_valid)
+		return h->chunk_relids;
+
+	children = find_inheritance_children(h->main_table_relid, NoLock);
+
+	old_mcxt = MemoryContextSwitchTo(subspace_store_mcxt(h->chunk_cache));
+	h->chunk_relids = list_copy(children);
+	h->chunk_relids_valid = true;
+	MemoryContextSwitchTo(old_mcxt);
+
+	return h->chunk_relids;
+}
+
 bool
 hypertable_has_tablespace(Hypertable *ht, Oid tspc_oid)
 {
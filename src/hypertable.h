@@ -2,7 +2,9 @@
 #define TIMESCALEDB_HYPERTABLE_H
 
 #include <postgres.h>
+#include <nodes/pg_list.h>
 #include <nodes/primnodes.h>
+#include <utils/hsearch.h>
 
 #include "catalog.h"
 #include "dimension.h"
@@ -11,7 +13,9 @@
 
 typedef struct SubspaceStore SubspaceStore;
 typedef struct Chunk Chunk;
+typedef struct Hypercube Hypercube;
 typedef struct HeapTupleData *HeapTuple;
+typedef struct LastPointCache LastPointCache;
 
 typedef struct Hypertable
 {
@@ -19,6 +23,18 @@ typedef struct Hypertable
 	Oid			main_table_relid;
 	Hyperspace *space;
 	SubspaceStore *chunk_cache;
+	/* Hypercubes of chunks, keyed on chunk relid. Used for planning. */
+	HTAB	   *chunk_cubes;
+	/* Relids of the chunks (inheritance children). Used for planning. */
+	List	   *chunk_relids;
+	bool		chunk_relids_valid;
+	/* Min/max indexes on non-partitioning columns */
+	List	   *minmax_indexes;
+	List	   *bloom_filters;
+	/* Continuous aggregates that read from the hypertable */
+	List	   *continuous_aggs;
+	/* NULL if the hypertable has no last point cache */
+	LastPointCache *last_point_cache;
 } Hypertable;
 
 
@@ -40,6 +56,9 @@ extern int	hypertable_delete_by_name(const char *schema_name, const char *table_
 extern int	hypertable_reset_associated_schema_name(const char *associated_schema);
 extern Oid	hypertable_id_to_relid(int32 hypertable_id);
 extern Chunk *hypertable_get_chunk(Hypertable *h, Point *point);
+extern Hypercube *hypertable_get_chunk_cube(Hypertable *h, Oid chunk_relid);
+extern int32 hypertable_get_chunk_id(Hypertable *h, Oid chunk_relid);
+extern List *hypertable_get_chunk_relids(Hypertable *h);
 extern Oid	hypertable_relid(RangeVar *rv);
 extern bool is_hypertable(Oid relid);
 extern bool hypertable_has_tablespace(Hypertable *ht, Oid tspc_oid);
@@ -27,6 +27,36 @@ extern void _cache_invalidate_fini(void);
 extern void _cache_init(void);
 extern void _cache_fini(void);
 
+extern void _constraint_aware_append_init(void);
+extern void _constraint_aware_append_fini(void);
+
+extern void _runtime_chunk_filter_init(void);
+extern void _runtime_chunk_filter_fini(void);
+
+extern void _gapfill_init(void);
+extern void _gapfill_fini(void);
+
+extern void _decompress_chunk_init(void);
+extern void _decompress_chunk_fini(void);
+
+extern void _vector_agg_init(void);
+extern void _vector_agg_fini(void);
+
+extern void _vector_filter_init(void);
+extern void _vector_filter_fini(void);
+
+extern void _skip_scan_init(void);
+extern void _skip_scan_fini(void);
+
+extern void _asof_join_init(void);
+extern void _asof_join_fini(void);
+
+extern void _continuous_agg_init(void);
+extern void _continuous_agg_fini(void);
+
+extern void _last_point_cache_init(void);
+extern void _last_point_cache_fini(void);
+
 extern void _planner_init(void);
 extern void _planner_fini(void);
 
@@ -55,6 +85,16 @@ _PG_init(void)
 	_cache_init();
 	_hypertable_cache_init();
 	_cache_invalidate_init();
+	_constraint_aware_append_init();
+	_runtime_chunk_filter_init();
+	_gapfill_init();
+	_decompress_chunk_init();
+	_vector_agg_init();
+	_vector_filter_init();
+	_skip_scan_init();
+	_asof_join_init();
+	_continuous_agg_init();
+	_last_point_cache_init();
 	_planner_init();
 	_event_trigger_init();
 	_process_utility_init();
@@ -74,6 +114,16 @@ _PG_fini(void)
 	_process_utility_fini();
 	_event_trigger_fini();
 	_planner_fini();
+	_last_point_cache_fini();
+	_continuous_agg_fini();
+	_asof_join_fini();
+	_skip_scan_fini();
+	_vector_filter_fini();
+	_vector_agg_fini();
+	_decompress_chunk_fini();
+	_gapfill_fini();
+	_runtime_chunk_filter_fini();
+	_constraint_aware_append_fini();
 	_cache_invalidate_fini();
 	_hypertable_cache_fini();
 	_cache_fini();
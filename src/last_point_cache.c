@@ -0,0 +1,1007 @@
+#include <postgres.h>
+#include <access/heapam.h>
+#include <access/htup_details.h>
+#include <access/stratnum.h>
+#include <access/tuptoaster.h>
+#include <access/xact.h>
+#include <catalog/dependency.h>
+#include <catalog/objectaddress.h>
+#include <catalog/pg_trigger.h>
+#include <commands/trigger.h>
+#include <executor/spi.h>
+#include <funcapi.h>
+#include <miscadmin.h>
+#include <nodes/makefuncs.h>
+#include <storage/lmgr.h>
+#include <utils/acl.h>
+#include <utils/builtins.h>
+#include <utils/fmgroids.h>
+#include <utils/guc.h>
+#include <utils/hsearch.h>
+#include <utils/lsyscache.h>
+#include <utils/memutils.h>
+#include <utils/rel.h>
+#include <utils/rls.h>
+#include <utils/tuplestore.h>
+#include <utils/typcache.h>
+
+#include "catalog.h"
+#include "dimension.h"
+#include "errors.h"
+#include "hypertable.h"
+#include "hypertable_cache.h"
+#include "last_point_cache.h"
+#include "scanner.h"
+#include "utils.h"
+#include "compat.h"
+
+#include "last_point_cache_shmem.c"
+
+/*
+ * Last point cache.
+ *
+ * The cache keeps, for every value of a hypertable's key column, the row
+ * with the latest time inserted through the hypertable. Rows live in a hash
+ * table in shared memory that the loader reserves at startup (see
+ * last_point_cache_shmem.c), so the cache is shared by all backends and
+ * last_points() reads the current row of every key without scanning the
+ * hypertable.
+ *
+ * Inserts collect their rows in the backend and add them to the cache when
+ * the transaction commits, so that other backends never see uncommitted
+ * rows. A row only replaces the cached row of its key if it is not older.
+ * Writes the cache cannot follow, like updates, deletes, truncation, upserts
+ * and altering the hypertable, remove all cached rows of the hypertable
+ * instead. So do rows whose subtransaction aborts, since the backend does
+ * not know which of its pending rows the subtransaction wrote. Transactions
+ * with pending changes cannot be prepared, since they could commit in a
+ * backend that does not have the changes.
+ *
+ * The cache is not persistent and starts out empty, so it only returns the
+ * keys inserted since the server started or the cache was last refreshed
+ * with refresh_last_point_cache(). When it is full, new keys are not cached.
+ */
+
+/* A row to add to the cache at commit */
+typedef struct PendingRow
+{
+	LastPointCacheKey key;
+	int64		time;
+	MinimalTuple row;			/* NULL if the key's cached row is removed */
+} PendingRow;
+
+static LastPointCacheShared *shared = NULL;
+static HTAB *shared_entries = NULL;
+static bool attached = false;
+
+/* Pending changes, allocated in the transaction's memory */
+static HTAB *pending_rows = NULL;
+static List *pending_resets = NIL;	/* IDs of hypertables to remove */
+
+/*
+ * Attach to the cache in shared memory. Returns false if the cache is
+ * disabled, which is the case unless the loader reserved it.
+ */
+static bool
+last_point_cache_attach(void)
+{
+	if (!attached)
+	{
+		const char *entries = GetConfigOption(GUC_LAST_POINT_CACHE_ENTRIES_NAME, true, false);
+
+		if (NULL != entries && strcmp(entries, "0") != 0)
+			shared = last_point_cache_shmem_init(0, 0, &shared_entries);
+
+		attached = true;
+	}
+
+	return NULL != shared;
+}
+
+/*
+ * Last point cache catalog.
+ */
+
+static LastPointCache *
+last_point_cache_from_tuple(HeapTuple tuple, Oid main_table_relid)
+{
+	LastPointCache *cache = palloc0(sizeof(LastPointCache));
+
+	memcpy(&cache->fd, GETSTRUCT(tuple), sizeof(FormData_last_point_cache));
+
+	if (OidIsValid(main_table_relid))
+	{
+		cache->key_attno = get_attnum(main_table_relid, NameStr(cache->fd.key_column_name));
+		cache->key_type = get_atttype(main_table_relid, cache->key_attno);
+
+		/* The column might be in the middle of being renamed */
+		if (OidIsValid(cache->key_type))
+			get_typlenbyval(cache->key_type, &cache->key_typlen, &cache->key_typbyval);
+	}
+
+	return cache;
+}
+
+typedef struct LastPointCacheScanData
+{
+	Oid			main_table_relid;
+	LastPointCache *cache;
+} LastPointCacheScanData;
+
+static bool
+last_point_cache_tuple_found(TupleInfo *ti, void *data)
+{
+	LastPointCacheScanData *scandata = data;
+
+	scandata->cache = last_point_cache_from_tuple(ti->tuple, scandata->main_table_relid);
+
+	return false;
+}
+
+static bool
+last_point_cache_tuple_delete(TupleInfo *ti, void *data)
+{
+	CatalogSecurityContext sec_ctx;
+
+	catalog_become_owner(catalog_get(), &sec_ctx);
+	catalog_delete(ti->scanrel, ti->tuple);
+	catalog_restore_user(&sec_ctx);
+
+	return true;
+}
+
+static bool
+last_point_cache_tuple_set_column_name(TupleInfo *ti, void *data)
+{
+	const char *newname = data;
+	HeapTuple	tuple = heap_copytuple(ti->tuple);
+	FormData_last_point_cache *form = (FormData_last_point_cache *) GETSTRUCT(tuple);
+	CatalogSecurityContext sec_ctx;
+
+	namestrcpy(&form->key_column_name, newname);
+	catalog_become_owner(catalog_get(), &sec_ctx);
+	catalog_update(ti->scanrel, tuple);
+	catalog_restore_user(&sec_ctx);
+	heap_freetuple(tuple);
+
+	return false;
+}
+
+static int
+last_point_cache_scan_by_hypertable_id(int32 hypertable_id,
+									   tuple_found_func tuple_found,
+									   void *data,
+									   LOCKMODE lockmode)
+{
+	Catalog    *catalog = catalog_get();
+	ScanKeyData scankey[1];
+	ScannerCtx	scanctx = {
+		.table = catalog->tables[LAST_POINT_CACHE].id,
+		.index = CATALOG_INDEX(catalog, LAST_POINT_CACHE, LAST_POINT_CACHE_PKEY_IDX),
+		.nkeys = 1,
+		.scankey = scankey,
+		.tuple_found = tuple_found,
+		.data = data,
+		.lockmode = lockmode,
+		.scandirection = ForwardScanDirection,
+	};
+
+	ScanKeyInit(&scankey[0], Anum_last_point_cache_pkey_idx_hypertable_id,
+				BTEqualStrategyNumber, F_INT4EQ, Int32GetDatum(hypertable_id));
+
+	return scanner_scan(&scanctx);
+}
+
+LastPointCache *
+last_point_cache_get_by_hypertable_id(int32 hypertable_id, Oid main_table_relid)
+{
+	LastPointCacheScanData scandata = {
+		.main_table_relid = main_table_relid,
+		.cache = NULL,
+	};
+
+	last_point_cache_scan_by_hypertable_id(hypertable_id, last_point_cache_tuple_found,
+										   &scandata, AccessShareLock);
+
+	return scandata.cache;
+}
+
+static void
+last_point_cache_insert(int32 hypertable_id, Name key_column_name)
+{
+	Catalog    *catalog = catalog_get();
+	Relation	rel;
+	Datum		values[Natts_last_point_cache];
+	bool		nulls[Natts_last_point_cache] = {false};
+	CatalogSecurityContext sec_ctx;
+
+	rel = heap_open(catalog->tables[LAST_POINT_CACHE].id, RowExclusiveLock);
+
+	values[Anum_last_point_cache_hypertable_id - 1] = Int32GetDatum(hypertable_id);
+	values[Anum_last_point_cache_key_column_name - 1] = NameGetDatum(key_column_name);
+
+	catalog_become_owner(catalog, &sec_ctx);
+	catalog_insert_values(rel, RelationGetDescr(rel), values, nulls);
+	catalog_restore_user(&sec_ctx);
+
+	heap_close(rel, RowExclusiveLock);
+}
+
+int
+last_point_cache_set_column_name(LastPointCache *cache, const char *newname)
+{
+	return last_point_cache_scan_by_hypertable_id(cache->fd.hypertable_id,
+												  last_point_cache_tuple_set_column_name,
+												  (void *) newname, RowExclusiveLock);
+}
+
+/*
+ * Pending changes.
+ */
+
+/*
+ * Make the cache key of a key column value. Values are keyed by their binary
+ * representation, so values that are equal but represented differently are
+ * different keys. Returns false if the value is too large to be a key.
+ */
+static bool
+last_point_cache_make_key(LastPointCacheKey *key, int32 hypertable_id,
+						  LastPointCache *cache, Datum value)
+{
+	const char *data;
+	Size		len;
+
+	if (cache->key_typbyval)
+	{
+		len = cache->key_typlen;
+		data = NULL;
+	}
+	else if (cache->key_typlen == -1)
+	{
+		struct varlena *v = PG_DETOAST_DATUM_PACKED(value);
+
+		len = VARSIZE_ANY_EXHDR(v);
+		data = VARDATA_ANY(v);
+	}
+	else if (cache->key_typlen == -2)
+	{
+		data = DatumGetCString(value);
+		len = strlen(data);
+	}
+	else
+	{
+		len = cache->key_typlen;
+		data = DatumGetPointer(value);
+	}
+
+	if (len > LAST_POINT_CACHE_KEY_SIZE)
+		return false;
+
+	memset(key, 0, sizeof(LastPointCacheKey));
+	key->database_id = MyDatabaseId;
+	key->hypertable_id = hypertable_id;
+	key->len = len;
+
+	if (NULL == data)
+		store_att_byval(key->data, value, cache->key_typlen);
+	else
+		memcpy(key->data, data, len);
+
+	return true;
+}
+
+static void
+pending_rows_remove_hypertable(int32 hypertable_id)
+{
+	HASH_SEQ_STATUS status;
+	PendingRow *pending;
+
+	if (NULL == pending_rows)
+		return;
+
+	hash_seq_init(&status, pending_rows);
+
+	while ((pending = hash_seq_search(&status)) != NULL)
+	{
+		if (pending->key.hypertable_id != hypertable_id)
+			continue;
+
+		if (NULL != pending->row)
+			pfree(pending->row);
+
+		hash_search(pending_rows, &pending->key, HASH_REMOVE, NULL);
+	}
+}
+
+/*
+ * Remove all cached rows of a hypertable when the transaction commits. Rows
+ * the transaction inserted before the reset are not added.
+ */
+void
+last_point_cache_reset(int32 hypertable_id)
+{
+	MemoryContext old = MemoryContextSwitchTo(TopTransactionContext);
+
+	pending_rows_remove_hypertable(hypertable_id);
+	pending_resets = list_append_unique_int(pending_resets, hypertable_id);
+
+	MemoryContextSwitchTo(old);
+}
+
+/*
+ * Form the cached row of a tuple in the transaction's memory. Returns NULL
+ * if the row does not fit in a cache entry.
+ */
+static MinimalTuple
+last_point_cache_form_row(HeapTuple tuple, TupleDesc tupdesc)
+{
+	HeapTuple	flat = tuple;
+	MinimalTuple row = NULL;
+
+	if (HeapTupleHasExternal(tuple))
+		flat = toast_flatten_tuple(tuple, tupdesc);
+
+	if (flat->t_len - MINIMAL_TUPLE_OFFSET <= shared->row_size)
+	{
+		MemoryContext old = MemoryContextSwitchTo(TopTransactionContext);
+
+		row = minimal_tuple_from_heap_tuple(flat);
+		MemoryContextSwitchTo(old);
+	}
+
+	if (flat != tuple)
+		heap_freetuple(flat);
+
+	return row;
+}
+
+static void
+last_point_cache_add_row_internal(LastPointCache *cache, int32 hypertable_id,
+								  HeapTuple tuple, TupleDesc tupdesc, int64 time)
+{
+	LastPointCacheKey key;
+	PendingRow *pending;
+	Datum		value;
+	bool		isnull;
+	bool		found;
+
+	value = heap_getattr(tuple, cache->key_attno, tupdesc, &isnull);
+
+	if (isnull || !last_point_cache_make_key(&key, hypertable_id, cache, value))
+		return;
+
+	if (NULL == pending_rows)
+	{
+		HASHCTL		ctl = {
+			.keysize = sizeof(LastPointCacheKey),
+			.entrysize = sizeof(PendingRow),
+			.hcxt = TopTransactionContext,
+		};
+
+		pending_rows = hash_create("last point cache pending rows", 64, &ctl,
+								   HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
+	}
+
+	pending = hash_search(pending_rows, &key, HASH_ENTER, &found);
+
+	if (found)
+	{
+		if (pending->time > time)
+			return;
+
+		if (NULL != pending->row)
+			pfree(pending->row);
+	}
+
+	pending->time = time;
+	pending->row = last_point_cache_form_row(tuple, tupdesc);
+}
+
+/*
+ * Add a row inserted into a hypertable to the cache when the transaction
+ * commits.
+ */
+void
+last_point_cache_add_row(Hypertable *ht, HeapTuple tuple, TupleDesc tupdesc)
+{
+	Dimension  *dim;
+	Datum		time;
+	bool		isnull;
+
+	if (NULL == ht->last_point_cache || !last_point_cache_attach())
+		return;
+
+	dim = hyperspace_get_open_dimension(ht->space, 0);
+	time = heap_getattr(tuple, dim->column_attno, tupdesc, &isnull);
+
+	/* The time column is NOT NULL */
+	Assert(!isnull);
+
+	last_point_cache_add_row_internal(ht->last_point_cache, ht->fd.id, tuple, tupdesc,
+									  time_value_to_internal(time, dim->fd.column_type));
+}
+
+/*
+ * Apply the pending changes to the cache. This happens after the transaction
+ * committed, so it must not fail.
+ */
+static void
+last_point_cache_apply_pending(void)
+{
+	HASH_SEQ_STATUS status;
+
+	if ((NIL == pending_resets && NULL == pending_rows) || !last_point_cache_attach())
+		return;
+
+	LWLockAcquire(shared->lock, LW_EXCLUSIVE);
+
+	if (NIL != pending_resets)
+	{
+		LastPointCacheEntry *entry;
+
+		hash_seq_init(&status, shared_entries);
+
+		while ((entry = hash_seq_search(&status)) != NULL)
+			if (entry->key.database_id == MyDatabaseId &&
+				list_member_int(pending_resets, entry->key.hypertable_id))
+				hash_search(shared_entries, &entry->key, HASH_REMOVE, NULL);
+	}
+
+	if (NULL != pending_rows)
+	{
+		PendingRow *pending;
+
+		hash_seq_init(&status, pending_rows);
+
+		while ((pending = hash_seq_search(&status)) != NULL)
+		{
+			LastPointCacheEntry *entry;
+			bool		found;
+
+			if (NULL == pending->row)
+			{
+				hash_search(shared_entries, &pending->key, HASH_REMOVE, NULL);
+				continue;
+			}
+
+			entry = hash_search(shared_entries, &pending->key, HASH_FIND, &found);
+
+			if (NULL == entry)
+			{
+				/* New keys are not cached once the cache is full */
+				if (hash_get_num_entries(shared_entries) >= shared->max_entries)
+					continue;
+
+				entry = hash_search(shared_entries, &pending->key, HASH_ENTER_NULL, &found);
+
+				if (NULL == entry)
+					continue;
+			}
+			else if (entry->time > pending->time)
+				continue;
+
+			entry->time = pending->time;
+			entry->row_len = pending->row->t_len;
+			memcpy(entry->row, pending->row, pending->row->t_len);
+		}
+	}
+
+	LWLockRelease(shared->lock);
+}
+
+static void
+last_point_cache_xact_callback(XactEvent event, void *arg)
+{
+	switch (event)
+	{
+		case XACT_EVENT_COMMIT:
+			last_point_cache_apply_pending();
+			pending_rows = NULL;
+			pending_resets = NIL;
+			break;
+		case XACT_EVENT_PRE_PREPARE:
+
+			/*
+			 * A prepared transaction can commit in another backend, which does
+			 * not have the pending changes to apply
+			 */
+			if ((NULL != pending_rows && hash_get_num_entries(pending_rows) > 0) ||
+				NIL != pending_resets)
+				ereport(ERROR,
+						(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+						 errmsg("cannot PREPARE a transaction that has written to a hypertable with a last point cache")));
+			break;
+		case XACT_EVENT_PREPARE:
+			pending_rows = NULL;
+			pending_resets = NIL;
+			break;
+		case XACT_EVENT_ABORT:
+		case XACT_EVENT_PARALLEL_ABORT:
+			/* Freed along with the transaction's memory */
+			pending_rows = NULL;
+			pending_resets = NIL;
+			break;
+		default:
+			break;
+	}
+}
+
+/*
+ * An aborted subtransaction might have written any of the pending rows, so
+ * the hypertables of all pending rows are reset instead.
+ */
+static void
+last_point_cache_subxact_callback(SubXactEvent event, SubTransactionId mySubid,
+								  SubTransactionId parentSubid, void *arg)
+{
+	HASH_SEQ_STATUS status;
+	PendingRow *pending;
+	List	   *hypertable_ids = NIL;
+	ListCell   *lc;
+
+	if (event != SUBXACT_EVENT_ABORT_SUB || NULL == pending_rows)
+		return;
+
+	hash_seq_init(&status, pending_rows);
+
+	while ((pending = hash_seq_search(&status)) != NULL)
+		hypertable_ids = list_append_unique_int(hypertable_ids, pending->key.hypertable_id);
+
+	foreach(lc, hypertable_ids)
+		last_point_cache_reset(lfirst_int(lc));
+}
+
+void
+_last_point_cache_init(void)
+{
+	RegisterXactCallback(last_point_cache_xact_callback, NULL);
+	RegisterSubXactCallback(last_point_cache_subxact_callback, NULL);
+}
+
+void
+_last_point_cache_fini(void)
+{
+	UnregisterSubXactCallback(last_point_cache_subxact_callback, NULL);
+	UnregisterXactCallback(last_point_cache_xact_callback, NULL);
+}
+
+/*
+ * Reset trigger.
+ */
+
+static void
+last_point_cache_reset_trigger_create(Oid relid)
+{
+	CreateTrigStmt stmt = {
+		.type = T_CreateTrigStmt,
+		.trigname = LAST_POINT_CACHE_RESET_TRIGGER_NAME,
+		.relation = makeRangeVarFromRelid(relid),
+		.funcname = list_make2(makeString(INTERNAL_SCHEMA_NAME), makeString("last_point_cache_reset_trigger")),
+		.args = NIL,
+		.row = false,
+		.timing = TRIGGER_TYPE_AFTER,
+		.events = TRIGGER_TYPE_UPDATE | TRIGGER_TYPE_DELETE | TRIGGER_TYPE_TRUNCATE,
+		.columns = NIL,
+		.whenClause = NULL,
+		.isconstraint = false,
+	};
+
+	if (OidIsValid(get_trigger_oid(relid, LAST_POINT_CACHE_RESET_TRIGGER_NAME, true)))
+		return;
+
+	CreateTrigger(&stmt, NULL, InvalidOid, InvalidOid, InvalidOid, InvalidOid, false);
+	CommandCounterIncrement();
+}
+
+static void
+last_point_cache_reset_trigger_drop(Oid relid)
+{
+	ObjectAddress address = {
+		.classId = TriggerRelationId,
+		.objectId = get_trigger_oid(relid, LAST_POINT_CACHE_RESET_TRIGGER_NAME, true),
+	};
+
+	if (OidIsValid(address.objectId))
+		performDeletion(&address, DROP_RESTRICT, 0);
+}
+
+/*
+ * Statement trigger that resets the cache of a hypertable when its rows are
+ * updated, deleted or truncated.
+ */
+TS_FUNCTION_INFO_V1(last_point_cache_reset_trigger);
+
+Datum
+last_point_cache_reset_trigger(PG_FUNCTION_ARGS)
+{
+	TriggerData *trigdata = (TriggerData *) fcinfo->context;
+	Cache	   *hcache;
+	Hypertable *ht;
+
+	if (!CALLED_AS_TRIGGER(fcinfo))
+		elog(ERROR, "last_point_cache_reset_trigger: not called by trigger manager");
+
+	if (!TRIGGER_FIRED_AFTER(trigdata->tg_event) || TRIGGER_FIRED_FOR_ROW(trigdata->tg_event))
+		elog(ERROR, "last_point_cache_reset_trigger: must be fired AFTER STATEMENT");
+
+	hcache = hypertable_cache_pin();
+	ht = hypertable_cache_get_entry(hcache, RelationGetRelid(trigdata->tg_relation));
+
+	if (NULL != ht)
+		last_point_cache_reset(ht->fd.id);
+
+	cache_release(hcache);
+
+	return PointerGetDatum(NULL);
+}
+
+/*
+ * Adding, refreshing and removing caches.
+ */
+
+static Hypertable *
+last_point_cache_get_hypertable(Cache *hcache, Oid table_relid)
+{
+	Hypertable *ht;
+
+	if (!OidIsValid(table_relid))
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("invalid main_table")));
+
+	hypertable_permissions_check(table_relid, GetUserId());
+
+	/*
+	 * Block writes to the hypertable while the cache is loaded. This is also
+	 * the lock needed to create and drop triggers.
+	 */
+	LockRelationOid(table_relid, ShareRowExclusiveLock);
+
+	ht = hypertable_cache_get_entry(hcache, table_relid);
+
+	if (NULL == ht)
+		ereport(ERROR,
+				(errcode(ERRCODE_IO_HYPERTABLE_NOT_EXIST),
+				 errmsg("table \"%s\" is not a hypertable",
+						get_rel_name(table_relid))));
+
+	return ht;
+}
+
+/*
+ * Load the latest row of every key of a hypertable into the cache.
+ */
+static void
+last_point_cache_load(Hypertable *ht, LastPointCache *cache)
+{
+	Dimension  *dim = hyperspace_get_open_dimension(ht->space, 0);
+	const char *key = quote_identifier(NameStr(cache->fd.key_column_name));
+	StringInfoData sql;
+	TupleDesc	tupdesc;
+	uint64		i;
+
+	if (!last_point_cache_attach())
+		return;
+
+	/* Whole-row values have the hypertable's row type, with dropped columns */
+	initStringInfo(&sql);
+	appendStringInfo(&sql,
+					 "SELECT DISTINCT ON (t.%s) t FROM %s t WHERE t.%s IS NOT NULL ORDER BY t.%s, t.%s DESC",
+					 key,
+					 quote_qualified_identifier(NameStr(ht->fd.schema_name), NameStr(ht->fd.table_name)),
+					 key,
+					 key,
+					 quote_identifier(NameStr(dim->fd.column_name)));
+
+	tupdesc = lookup_rowtype_tupdesc_copy(get_rel_type_id(ht->main_table_relid), -1);
+
+	if (SPI_connect() != SPI_OK_CONNECT)
+		elog(ERROR, "could not connect to SPI");
+
+	if (SPI_execute(sql.data, true, 0) != SPI_OK_SELECT)
+		elog(ERROR, "could not load the last point cache of \"%s\"",
+			 get_rel_name(ht->main_table_relid));
+
+	for (i = 0; i < SPI_processed; i++)
+	{
+		bool		isnull;
+		Datum		value = SPI_getbinval(SPI_tuptable->vals[i], SPI_tuptable->tupdesc, 1, &isnull);
+		HeapTupleHeader td = DatumGetHeapTupleHeader(value);
+		HeapTupleData tuple;
+		Datum		time;
+
+		tuple.t_len = HeapTupleHeaderGetDatumLength(td);
+		ItemPointerSetInvalid(&tuple.t_self);
+		tuple.t_tableOid = InvalidOid;
+		tuple.t_data = td;
+
+		time = heap_getattr(&tuple, dim->column_attno, tupdesc, &isnull);
+		last_point_cache_add_row_internal(cache, ht->fd.id, &tuple, tupdesc,
+										  time_value_to_internal(time, dim->fd.column_type));
+	}
+
+	SPI_finish();
+}
+
+/*
+ * Remove the cache of a hypertable. The cached rows are removed when the
+ * transaction commits.
+ */
+void
+last_point_cache_drop(Hypertable *ht)
+{
+	last_point_cache_delete_by_hypertable_id(ht->fd.id);
+	last_point_cache_reset_trigger_drop(ht->main_table_relid);
+}
+
+int
+last_point_cache_delete_by_hypertable_id(int32 hypertable_id)
+{
+	last_point_cache_reset(hypertable_id);
+
+	return last_point_cache_scan_by_hypertable_id(hypertable_id, last_point_cache_tuple_delete,
+												  NULL, RowExclusiveLock);
+}
+
+TS_FUNCTION_INFO_V1(last_point_cache_add);
+
+/*
+ * Add a last point cache to a hypertable and load the latest row of every
+ * key into it.
+ *
+ * Arguments:
+ * 0. Relation ID of the hypertable
+ * 1. Key column name
+ * 2. IF NOT EXISTS option (bool)
+ */
+Datum
+last_point_cache_add(PG_FUNCTION_ARGS)
+{
+	Oid			table_relid = PG_ARGISNULL(0) ? InvalidOid : PG_GETARG_OID(0);
+	Name		key_column_name = PG_ARGISNULL(1) ? NULL : PG_GETARG_NAME(1);
+	bool		if_not_exists = PG_ARGISNULL(2) ? false : PG_GETARG_BOOL(2);
+	Cache	   *hcache = hypertable_cache_pin();
+	Hypertable *ht = last_point_cache_get_hypertable(hcache, table_relid);
+	LastPointCache *cache;
+	AttrNumber	attno;
+	Oid			key_type;
+	int16		typlen;
+	bool		typbyval;
+
+	if (NULL == key_column_name)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("invalid key column name")));
+
+	if (NULL != ht->last_point_cache)
+	{
+		if (!if_not_exists)
+			ereport(ERROR,
+					(errcode(ERRCODE_DUPLICATE_OBJECT),
+					 errmsg("last point cache on table \"%s\" already exists",
+							get_rel_name(table_relid))));
+
+		ereport(NOTICE,
+				(errmsg("last point cache on table \"%s\" already exists, skipping",
+						get_rel_name(table_relid))));
+		cache_release(hcache);
+		PG_RETURN_VOID();
+	}
+
+	attno = get_attnum(table_relid, NameStr(*key_column_name));
+
+	if (!AttributeNumberIsValid(attno))
+		ereport(ERROR,
+				(errcode(ERRCODE_UNDEFINED_COLUMN),
+				 errmsg("column \"%s\" does not exist", NameStr(*key_column_name))));
+
+	key_type = get_atttype(table_relid, attno);
+	get_typlenbyval(key_type, &typlen, &typbyval);
+
+	if (typlen > LAST_POINT_CACHE_KEY_SIZE ||
+		!OidIsValid(lookup_type_cache(key_type, TYPECACHE_LT_OPR)->lt_opr))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("cannot cache the last points of key column \"%s\" of type %s",
+						NameStr(*key_column_name), format_type_be(key_type)),
+				 errhint("Key columns need a type with a default btree operator class "
+						 "and values of at most %d bytes.", LAST_POINT_CACHE_KEY_SIZE)));
+
+	last_point_cache_insert(ht->fd.id, key_column_name);
+	last_point_cache_reset_trigger_create(table_relid);
+
+	cache = palloc0(sizeof(LastPointCache));
+	cache->fd.hypertable_id = ht->fd.id;
+	namecpy(&cache->fd.key_column_name, key_column_name);
+	cache->key_attno = attno;
+	cache->key_type = key_type;
+	cache->key_typlen = typlen;
+	cache->key_typbyval = typbyval;
+	last_point_cache_load(ht, cache);
+
+	cache_release(hcache);
+
+	PG_RETURN_VOID();
+}
+
+TS_FUNCTION_INFO_V1(last_point_cache_remove);
+
+/*
+ * Remove the last point cache of a hypertable.
+ *
+ * Arguments:
+ * 0. Relation ID of the hypertable
+ * 1. IF EXISTS option (bool)
+ */
+Datum
+last_point_cache_remove(PG_FUNCTION_ARGS)
+{
+	Oid			table_relid = PG_ARGISNULL(0) ? InvalidOid : PG_GETARG_OID(0);
+	bool		if_exists = PG_ARGISNULL(1) ? false : PG_GETARG_BOOL(1);
+	Cache	   *hcache = hypertable_cache_pin();
+	Hypertable *ht = last_point_cache_get_hypertable(hcache, table_relid);
+
+	if (NULL == ht->last_point_cache)
+	{
+		if (!if_exists)
+			ereport(ERROR,
+					(errcode(ERRCODE_UNDEFINED_OBJECT),
+					 errmsg("last point cache on table \"%s\" does not exist",
+							get_rel_name(table_relid))));
+
+		ereport(NOTICE,
+				(errmsg("last point cache on table \"%s\" does not exist, skipping",
+						get_rel_name(table_relid))));
+	}
+	else
+		last_point_cache_drop(ht);
+
+	cache_release(hcache);
+
+	PG_RETURN_VOID();
+}
+
+TS_FUNCTION_INFO_V1(last_point_cache_refresh);
+
+/*
+ * Replace the cached rows of a hypertable with the latest row of every key.
+ *
+ * Arguments:
+ * 0. Relation ID of the hypertable
+ */
+Datum
+last_point_cache_refresh(PG_FUNCTION_ARGS)
+{
+	Oid			table_relid = PG_ARGISNULL(0) ? InvalidOid : PG_GETARG_OID(0);
+	Cache	   *hcache = hypertable_cache_pin();
+	Hypertable *ht = last_point_cache_get_hypertable(hcache, table_relid);
+
+	if (NULL == ht->last_point_cache)
+		ereport(ERROR,
+				(errcode(ERRCODE_UNDEFINED_OBJECT),
+				 errmsg("last point cache on table \"%s\" does not exist",
+						get_rel_name(table_relid))));
+
+	last_point_cache_reset(ht->fd.id);
+	last_point_cache_load(ht, ht->last_point_cache);
+
+	cache_release(hcache);
+
+	PG_RETURN_VOID();
+}
+
+/*
+ * Reading the cache.
+ */
+
+TS_FUNCTION_INFO_V1(last_point_cache_rows);
+
+/*
+ * Return the cached rows of a hypertable. The hypertable is given by a value
+ * of its row type, e.g. NULL::conditions, so that the function returns rows
+ * of that type.
+ *
+ * Arguments:
+ * 0. A value of the hypertable's row type
+ */
+Datum
+last_point_cache_rows(PG_FUNCTION_ARGS)
+{
+	ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+	Oid			rowtype = get_fn_expr_argtype(fcinfo->flinfo, 0);
+	Oid			table_relid = OidIsValid(rowtype) ? get_typ_typrelid(rowtype) : InvalidOid;
+	AclResult	aclresult;
+	Cache	   *hcache;
+	Hypertable *ht;
+	Tuplestorestate *tupstore;
+	TupleDesc	tupdesc;
+	MemoryContext old;
+	HASH_SEQ_STATUS status;
+	LastPointCacheEntry *entry;
+	List	   *rows = NIL;
+	ListCell   *lc;
+
+	if (!OidIsValid(table_relid))
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("argument must be of the row type of a hypertable"),
+				 errhint("Pass the hypertable's row type, e.g., NULL::conditions.")));
+
+	if (NULL == rsinfo || !IsA(rsinfo, ReturnSetInfo) ||
+		!(rsinfo->allowedModes & SFRM_Materialize))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("set-valued function called in context that cannot accept a set")));
+
+	aclresult = pg_class_aclcheck(table_relid, GetUserId(), ACL_SELECT);
+
+	if (aclresult != ACLCHECK_OK)
+		aclcheck_error(aclresult, ACL_KIND_CLASS, get_rel_name(table_relid));
+
+	if (check_enable_rls(table_relid, InvalidOid, false) == RLS_ENABLED)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("cannot read the last point cache of table \"%s\" with row-level security",
+						get_rel_name(table_relid))));
+
+	/* Block changes to the row type while the rows are returned */
+	LockRelationOid(table_relid, AccessShareLock);
+
+	hcache = hypertable_cache_pin();
+	ht = hypertable_cache_get_entry(hcache, table_relid);
+
+	if (NULL == ht)
+		ereport(ERROR,
+				(errcode(ERRCODE_IO_HYPERTABLE_NOT_EXIST),
+				 errmsg("table \"%s\" is not a hypertable",
+						get_rel_name(table_relid))));
+
+	if (NULL == ht->last_point_cache)
+		ereport(ERROR,
+				(errcode(ERRCODE_UNDEFINED_OBJECT),
+				 errmsg("last point cache on table \"%s\" does not exist",
+						get_rel_name(table_relid)),
+				 errhint("Add one with add_last_point_cache().")));
+
+	if (!last_point_cache_attach())
+		ereport(ERROR,
+				(errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
+				 errmsg("the last point cache is disabled"),
+				 errhint("Set %s and restart the server.", GUC_LAST_POINT_CACHE_ENTRIES_NAME)));
+
+	old = MemoryContextSwitchTo(rsinfo->econtext->ecxt_per_query_memory);
+
+	tupdesc = lookup_rowtype_tupdesc_copy(rowtype, -1);
+	tupstore = tuplestore_begin_heap(true, false, work_mem);
+
+	/* Copy the rows so that the lock is not held while they are returned */
+	LWLockAcquire(shared->lock, LW_SHARED);
+	hash_seq_init(&status, shared_entries);
+
+	while ((entry = hash_seq_search(&status)) != NULL)
+	{
+		MinimalTuple row;
+
+		if (entry->key.database_id != MyDatabaseId ||
+			entry->key.hypertable_id != ht->fd.id)
+			continue;
+
+		row = palloc(entry->row_len);
+		memcpy(row, entry->row, entry->row_len);
+		rows = lappend(rows, row);
+	}
+
+	LWLockRelease(shared->lock);
+
+	foreach(lc, rows)
+		tuplestore_puttuple(tupstore, heap_tuple_from_minimal_tuple(lfirst(lc)));
+
+	MemoryContextSwitchTo(old);
+	cache_release(hcache);
+
+	rsinfo->returnMode = SFRM_Materialize;
+	rsinfo->setResult = tupstore;
+	rsinfo->setDesc = tupdesc;
+
+	return (Datum) 0;
+}
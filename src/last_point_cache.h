@@ -0,0 +1,40 @@
+#ifndef TIMESCALEDB_LAST_POINT_CACHE_H
+#define TIMESCALEDB_LAST_POINT_CACHE_H
+
+#include <postgres.h>
+#include <access/attnum.h>
+#include <access/htup.h>
+#include <access/tupdesc.h>
+
+#include "catalog.h"
+
+#define LAST_POINT_CACHE_RESET_TRIGGER_NAME "ts_last_point_cache_reset"
+
+typedef struct Hypertable Hypertable;
+
+/*
+ * The last point cache keeps the most recent row inserted into a hypertable
+ * per value of a key column in shared memory, so that the current row of
+ * every key is read from memory instead of scanning the hypertable.
+ */
+typedef struct LastPointCache
+{
+	FormData_last_point_cache fd;
+	AttrNumber	key_attno;		/* attribute number in the main table */
+	Oid			key_type;
+	int16		key_typlen;
+	bool		key_typbyval;
+} LastPointCache;
+
+extern LastPointCache *last_point_cache_get_by_hypertable_id(int32 hypertable_id, Oid main_table_relid);
+extern int	last_point_cache_delete_by_hypertable_id(int32 hypertable_id);
+extern int	last_point_cache_set_column_name(LastPointCache *cache, const char *newname);
+extern void last_point_cache_drop(Hypertable *ht);
+
+extern void last_point_cache_add_row(Hypertable *ht, HeapTuple tuple, TupleDesc tupdesc);
+extern void last_point_cache_reset(int32 hypertable_id);
+
+extern void _last_point_cache_init(void);
+extern void _last_point_cache_fini(void);
+
+#endif							/* TIMESCALEDB_LAST_POINT_CACHE_H */
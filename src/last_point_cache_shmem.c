@@ -0,0 +1,108 @@
+/* This file will be used by the versioned timescaledb extension and the loader.
+ * The loader reserves the shared memory of the last point cache, since only
+ * libraries in shared_preload_libraries can, and the extension attaches to it.
+ * Like extension_utils.c, all functions here are static and the file is
+ * included via #include "last_point_cache_shmem.c".
+ */
+
+#include <postgres.h>
+#include <storage/lwlock.h>
+#include <storage/shmem.h>
+#include <utils/hsearch.h>
+
+#define GUC_LAST_POINT_CACHE_ENTRIES_NAME "timescaledb.last_point_cache_entries"
+#define GUC_LAST_POINT_CACHE_ROW_SIZE_NAME "timescaledb.last_point_cache_row_size"
+
+#define LAST_POINT_CACHE_SHMEM_NAME "timescaledb last point cache"
+#define LAST_POINT_CACHE_HASH_NAME "timescaledb last point cache entries"
+#define LAST_POINT_CACHE_KEY_SIZE 64
+
+/*
+ * Keys are compared as blobs, so they must be zeroed before they are filled
+ * in.
+ */
+typedef struct LastPointCacheKey
+{
+	Oid			database_id;
+	int32		hypertable_id;
+	int32		len;
+	char		data[LAST_POINT_CACHE_KEY_SIZE];	/* binary key value */
+} LastPointCacheKey;
+
+typedef struct LastPointCacheEntry
+{
+	LastPointCacheKey key;
+	int64		time;			/* time of the row, in internal time format */
+	uint32		row_len;
+	char		row[FLEXIBLE_ARRAY_MEMBER]; /* MinimalTuple of the row */
+} LastPointCacheEntry;
+
+typedef struct LastPointCacheShared
+{
+	LWLock	   *lock;			/* protects the entries */
+	int			max_entries;
+	int			row_size;
+} LastPointCacheShared;
+
+static inline Size
+last_point_cache_entry_size(int row_size)
+{
+	return MAXALIGN(offsetof(LastPointCacheEntry, row) + row_size);
+}
+
+static inline Size
+last_point_cache_shmem_size(int max_entries, int row_size)
+{
+	return add_size(MAXALIGN(sizeof(LastPointCacheShared)),
+					hash_estimate_size(max_entries, last_point_cache_entry_size(row_size)));
+}
+
+/*
+ * Create the cache in shared memory, or attach to it if it exists. The
+ * postmaster creates it at startup with the configured size, so backends
+ * attach with the size stored in the shared state. Returns NULL if the cache
+ * is disabled.
+ */
+static LastPointCacheShared *
+last_point_cache_shmem_init(int max_entries, int row_size, HTAB **entries)
+{
+	LastPointCacheShared *shared;
+	HASHCTL		info;
+	bool		found;
+
+	LWLockAcquire(AddinShmemInitLock, LW_EXCLUSIVE);
+
+	shared = ShmemInitStruct(LAST_POINT_CACHE_SHMEM_NAME, sizeof(LastPointCacheShared), &found);
+
+	/*
+	 * A backend only creates the state if the loader did not reserve the
+	 * cache, in which case the cache is disabled
+	 */
+	if (!found)
+	{
+		shared->lock = max_entries > 0 ? &(GetNamedLWLockTranche(LAST_POINT_CACHE_SHMEM_NAME))->lock : NULL;
+		shared->max_entries = max_entries;
+		shared->row_size = row_size;
+	}
+
+	if (shared->max_entries <= 0)
+	{
+		LWLockRelease(AddinShmemInitLock);
+		*entries = NULL;
+		return NULL;
+	}
+
+	memset(&info, 0, sizeof(info));
+	info.keysize = sizeof(LastPointCacheKey);
+	info.entrysize = last_point_cache_entry_size(shared->row_size);
+
+	*entries = ShmemInitHash(LAST_POINT_CACHE_HASH_NAME,
+							 shared->max_entries,
+							 shared->max_entries,
+							 &info,
+							 HASH_ELEM | HASH_BLOBS);
+
+	LWLockRelease(AddinShmemInitLock);
+
+	return shared;
+}
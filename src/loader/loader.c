@@ -9,10 +9,12 @@
 #include <utils/guc.h>
 #include <utils/inval.h>
 #include <nodes/print.h>
+#include <storage/ipc.h>
 
 #define EXTENSION_NAME "timescaledb"
 
 #include "../extension_utils.c"
+#include "../last_point_cache_shmem.c"
 
 #define PG96 ((PG_VERSION_NUM >= 90600) && (PG_VERSION_NUM < 100000))
 #define PG10 ((PG_VERSION_NUM >= 100000) && (PG_VERSION_NUM < 110000))
@@ -49,6 +51,12 @@ static char soversion[MAX_VERSION_LEN];
 /* GUC to disable the load */
 static bool guc_disable_load = false;
 
+/* GUCs sizing the last point cache, which is disabled without entries */
+static int	guc_last_point_cache_entries = 0;
+static int	guc_last_point_cache_row_size = 256;
+
+static shmem_startup_hook_type prev_shmem_startup_hook;
+
 /* This is the hook that existed before the loader was installed */
 static post_parse_analyze_hook_type prev_post_parse_analyze_hook;
 
@@ -60,6 +68,19 @@ static void call_extension_post_parse_analyze_hook(ParseState *pstate,
 									   Query *query);
 
 
+static void
+last_point_cache_shmem_startup(void)
+{
+	HTAB	   *entries;
+
+	if (prev_shmem_startup_hook != NULL)
+		prev_shmem_startup_hook();
+
+	last_point_cache_shmem_init(guc_last_point_cache_entries,
+								guc_last_point_cache_row_size,
+								&entries);
+}
+
 static void
 inval_cache_callback(Datum arg, Oid relid)
 {
@@ -252,6 +273,44 @@ _PG_init(void)
 							 NULL,
 							 NULL);
 
+	DefineCustomIntVariable(GUC_LAST_POINT_CACHE_ENTRIES_NAME, "Maximum number of rows in the last point cache",
+							"The last point cache keeps the most recent row per key of hypertables in shared memory. Zero disables the cache",
+							&guc_last_point_cache_entries,
+							0,
+							0,
+							PG_INT32_MAX / 2,
+							PGC_POSTMASTER,
+							0,
+							NULL,
+							NULL,
+							NULL);
+
+	DefineCustomIntVariable(GUC_LAST_POINT_CACHE_ROW_SIZE_NAME, "Maximum size of a row in the last point cache",
+							"Larger rows are not cached",
+							&guc_last_point_cache_row_size,
+							256,
+							64,
+							BLCKSZ,
+							PGC_POSTMASTER,
+							GUC_UNIT_BYTE,
+							NULL,
+							NULL,
+							NULL);
+
+	/*
+	 * Shared memory can only be reserved while the postmaster loads the
+	 * preloaded libraries
+	 */
+	if (process_shared_preload_libraries_in_progress && guc_last_point_cache_entries > 0)
+	{
+		RequestAddinShmemSpace(last_point_cache_shmem_size(guc_last_point_cache_entries,
+														   guc_last_point_cache_row_size));
+		RequestNamedLWLockTranche(LAST_POINT_CACHE_SHMEM_NAME, 1);
+
+		prev_shmem_startup_hook = shmem_startup_hook;
+		shmem_startup_hook = last_point_cache_shmem_startup;
+	}
+
 	/*
 	 * cannot check for extension here since not inside a transaction yet. Nor
 	 * do we even have an assigned database yet
@@ -271,6 +330,8 @@ void
 _PG_fini(void)
 {
 	post_parse_analyze_hook = prev_post_parse_analyze_hook;
+	if (shmem_startup_hook == last_point_cache_shmem_startup)
+		shmem_startup_hook = prev_shmem_startup_hook;
 	/* No way to unregister relcache callback */
 }
 
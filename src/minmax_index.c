@@ -0,0 +1,1467 @@
+#include <postgres.h>
+#include <access/heapam.h>
+#include <access/htup_details.h>
+#include <access/stratnum.h>
+#include <access/xact.h>
+#include <catalog/dependency.h>
+#include <catalog/objectaddress.h>
+#include <catalog/pg_inherits_fn.h>
+#include <catalog/pg_trigger.h>
+#include <catalog/pg_type.h>
+#include <commands/trigger.h>
+#include <miscadmin.h>
+#include <nodes/makefuncs.h>
+#include <nodes/relation.h>
+#include <storage/lmgr.h>
+#include <utils/builtins.h>
+#include <utils/date.h>
+#include <utils/datetime.h>
+#include <utils/fmgroids.h>
+#include <utils/lsyscache.h>
+#include <utils/rel.h>
+#include <utils/snapmgr.h>
+#include <utils/timestamp.h>
+#include <utils/typcache.h>
+
+#include "minmax_index.h"
+#include "catalog.h"
+#include "chunk.h"
+#include "compressed_chunk.h"
+#include "dimension.h"
+#include "errors.h"
+#include "hypertable.h"
+#include "hypertable_cache.h"
+#include "scanner.h"
+#include "trigger.h"
+#include "utils.h"
+#include "compat.h"
+
+#if PG10
+#include <utils/fmgrprotos.h>
+#endif
+
+/*
+ * Min/max indexes.
+ *
+ * A min/max index keeps, for every chunk of a hypertable, the range of values
+ * of a column in the chunk's rows. The ranges are stored in the chunk_minmax
+ * catalog table in the internal time representation, which covers the
+ * supported integer and time types. Ranges only ever widen: deleted rows do
+ * not shrink them, so a range might be wider than the chunk's values, but
+ * never narrower.
+ *
+ * Rows inserted via the hypertable are tracked while they are dispatched to
+ * chunks and the ranges are written to the catalog once the insert's subplan
+ * is exhausted, i.e., before any AFTER triggers fire. All other writes
+ * (updates, inserts directly into chunks, and inserts whose rows can still
+ * change after dispatch) are tracked by a row trigger on the chunks.
+ *
+ * The ranges are used at execution time by ConstraintAwareAppend to exclude
+ * chunks whose ranges do not overlap the restrictions of a query.
+ */
+
+typedef struct MinMaxRange
+{
+	bool		isnull;			/* no non-NULL values */
+	int64		min;
+	int64		max;
+} MinMaxRange;
+
+typedef struct ChunkMinMaxColumn
+{
+	int32		minmax_index_id;
+	AttrNumber	attno;
+	Oid			type;
+	bool		tracked;		/* the chunk has a range in the catalog */
+	MinMaxRange catalog_range;	/* the range last read from or written to the
+								 * catalog */
+	MinMaxRange range;			/* the catalog range plus tracked values */
+} ChunkMinMaxColumn;
+
+struct ChunkMinMaxTracker
+{
+	int32		chunk_id;
+	int			num_columns;
+	ChunkMinMaxColumn columns[FLEXIBLE_ARRAY_MEMBER];
+};
+
+/* A restriction on a min/max indexed column, with inclusive bounds */
+typedef struct MinMaxRestrictInfo
+{
+	int32		minmax_index_id;
+	int64		lower;
+	int64		upper;
+} MinMaxRestrictInfo;
+
+static bool
+minmax_index_type_is_supported(Oid type)
+{
+	switch (type)
+	{
+		case INT2OID:
+		case INT4OID:
+		case INT8OID:
+		case DATEOID:
+		case TIMESTAMPOID:
+		case TIMESTAMPTZOID:
+			return true;
+		default:
+			return false;
+	}
+}
+
+static bool
+minmax_index_type_is_integer(Oid type)
+{
+	return type == INT2OID || type == INT4OID || type == INT8OID;
+}
+
+/*
+ * Convert a value of a min/max indexed column to the internal representation
+ * of ranges.
+ *
+ * Returns false if the value has no exact internal representation (e.g.,
+ * infinite timestamps), in which case the result is clamped to the minimum or
+ * maximum of the internal range. Clamped values can be tracked in ranges, but
+ * cannot be used as restrictions.
+ */
+static bool
+minmax_value_to_internal(Datum value, Oid type, int64 *result)
+{
+	if (type == DATEOID)
+	{
+		DateADT		date = DatumGetDateADT(value);
+
+		if (DATE_IS_NOBEGIN(date))
+		{
+			*result = PG_INT64_MIN;
+			return false;
+		}
+
+		if (DATE_NOT_FINITE(date) ||
+			date >= (TIMESTAMP_END_JULIAN - POSTGRES_EPOCH_JDATE))
+		{
+			*result = PG_INT64_MAX;
+			return false;
+		}
+
+		value = DirectFunctionCall1(date_timestamp, value);
+		type = TIMESTAMPOID;
+	}
+
+	if (type == TIMESTAMPOID || type == TIMESTAMPTZOID)
+	{
+		Timestamp	timestamp = DatumGetTimestamp(value);
+		int64		epoch_diff_microseconds = (POSTGRES_EPOCH_JDATE - UNIX_EPOCH_JDATE) * USECS_PER_DAY;
+
+		if (TIMESTAMP_IS_NOBEGIN(timestamp) || timestamp < MIN_TIMESTAMP)
+		{
+			*result = PG_INT64_MIN;
+			return false;
+		}
+
+		if (TIMESTAMP_NOT_FINITE(timestamp) ||
+			timestamp >= (END_TIMESTAMP - epoch_diff_microseconds))
+		{
+			*result = PG_INT64_MAX;
+			return false;
+		}
+	}
+
+	*result = time_value_to_internal(value, type);
+
+	return true;
+}
+
+static void
+minmax_range_add_value(MinMaxRange *range, int64 value)
+{
+	if (range->isnull)
+	{
+		range->isnull = false;
+		range->min = value;
+		range->max = value;
+	}
+	else
+	{
+		range->min = Min(range->min, value);
+		range->max = Max(range->max, value);
+	}
+}
+
+static void
+minmax_range_add_range(MinMaxRange *range, MinMaxRange *other)
+{
+	if (other->isnull)
+		return;
+
+	minmax_range_add_value(range, other->min);
+	minmax_range_add_value(range, other->max);
+}
+
+static bool
+minmax_range_contains(MinMaxRange *range, MinMaxRange *other)
+{
+	if (other->isnull)
+		return true;
+
+	return !range->isnull && range->min <= other->min && other->max <= range->max;
+}
+
+/*
+ * Min/max index catalog.
+ */
+
+static MinMaxIndex *
+minmax_index_from_tuple(HeapTuple tuple, Oid main_table_relid)
+{
+	MinMaxIndex *index = palloc0(sizeof(MinMaxIndex));
+
+	memcpy(&index->fd, GETSTRUCT(tuple), sizeof(FormData_minmax_index));
+
+	if (OidIsValid(main_table_relid))
+	{
+		index->column_attno = get_attnum(main_table_relid, NameStr(index->fd.column_name));
+		index->column_type = get_atttype(main_table_relid, index->column_attno);
+	}
+
+	return index;
+}
+
+typedef struct MinMaxIndexScanData
+{
+	Oid			main_table_relid;
+	List	   *indexes;
+} MinMaxIndexScanData;
+
+static bool
+minmax_index_tuple_found(TupleInfo *ti, void *data)
+{
+	MinMaxIndexScanData *scandata = data;
+
+	scandata->indexes = lappend(scandata->indexes,
+								minmax_index_from_tuple(ti->tuple, scandata->main_table_relid));
+
+	return true;
+}
+
+static bool
+minmax_index_tuple_delete(TupleInfo *ti, void *data)
+{
+	CatalogSecurityContext sec_ctx;
+
+	catalog_become_owner(catalog_get(), &sec_ctx);
+	catalog_delete(ti->scanrel, ti->tuple);
+	catalog_restore_user(&sec_ctx);
+
+	return true;
+}
+
+static int
+minmax_index_scan(ScanKeyData *scankey,
+				  int nkeys,
+				  int indexid,
+				  tuple_found_func tuple_found,
+				  void *data,
+				  LOCKMODE lockmode)
+{
+	Catalog    *catalog = catalog_get();
+	ScannerCtx	scanctx = {
+		.table = catalog->tables[MINMAX_INDEX].id,
+		.index = CATALOG_INDEX(catalog, MINMAX_INDEX, indexid),
+		.nkeys = nkeys,
+		.scankey = scankey,
+		.tuple_found = tuple_found,
+		.data = data,
+		.lockmode = lockmode,
+		.scandirection = ForwardScanDirection,
+	};
+
+	return scanner_scan(&scanctx);
+}
+
+static int
+minmax_index_scan_by_hypertable_id_internal(int32 hypertable_id,
+											tuple_found_func tuple_found,
+											void *data,
+											LOCKMODE lockmode)
+{
+	ScanKeyData scankey[1];
+
+	ScanKeyInit(&scankey[0], Anum_minmax_index_hypertable_id_column_name_idx_hypertable_id,
+				BTEqualStrategyNumber, F_INT4EQ, Int32GetDatum(hypertable_id));
+
+	return minmax_index_scan(scankey, 1, MINMAX_INDEX_HYPERTABLE_ID_COLUMN_NAME_IDX,
+							 tuple_found, data, lockmode);
+}
+
+List *
+minmax_index_scan_by_hypertable_id(int32 hypertable_id, Oid main_table_relid)
+{
+	MinMaxIndexScanData scandata = {
+		.main_table_relid = main_table_relid,
+		.indexes = NIL,
+	};
+
+	minmax_index_scan_by_hypertable_id_internal(hypertable_id, minmax_index_tuple_found,
+												&scandata, AccessShareLock);
+
+	return scandata.indexes;
+}
+
+MinMaxIndex *
+minmax_index_get_by_column_name(List *indexes, const char *column_name)
+{
+	ListCell   *lc;
+
+	foreach(lc, indexes)
+	{
+		MinMaxIndex *index = lfirst(lc);
+
+		if (namestrcmp(&index->fd.column_name, column_name) == 0)
+			return index;
+	}
+
+	return NULL;
+}
+
+static MinMaxIndex *
+minmax_index_get_by_attno(List *indexes, AttrNumber attno)
+{
+	ListCell   *lc;
+
+	foreach(lc, indexes)
+	{
+		MinMaxIndex *index = lfirst(lc);
+
+		if (index->column_attno == attno)
+			return index;
+	}
+
+	return NULL;
+}
+
+static int32
+minmax_index_insert(int32 hypertable_id, Name column_name)
+{
+	Catalog    *catalog = catalog_get();
+	Relation	rel;
+	Datum		values[Natts_minmax_index];
+	bool		nulls[Natts_minmax_index] = {false};
+	CatalogSecurityContext sec_ctx;
+	int32		id;
+
+	rel = heap_open(catalog->tables[MINMAX_INDEX].id, RowExclusiveLock);
+
+	catalog_become_owner(catalog, &sec_ctx);
+	id = catalog_table_next_seq_id(catalog, MINMAX_INDEX);
+	values[Anum_minmax_index_id - 1] = Int32GetDatum(id);
+	values[Anum_minmax_index_hypertable_id - 1] = Int32GetDatum(hypertable_id);
+	values[Anum_minmax_index_column_name - 1] = NameGetDatum(column_name);
+	catalog_insert_values(rel, RelationGetDescr(rel), values, nulls);
+	catalog_restore_user(&sec_ctx);
+
+	heap_close(rel, RowExclusiveLock);
+
+	return id;
+}
+
+static bool
+minmax_index_tuple_set_column_name(TupleInfo *ti, void *data)
+{
+	const char *newname = data;
+	HeapTuple	tuple = heap_copytuple(ti->tuple);
+	FormData_minmax_index *form = (FormData_minmax_index *) GETSTRUCT(tuple);
+	CatalogSecurityContext sec_ctx;
+
+	namestrcpy(&form->column_name, newname);
+	catalog_become_owner(catalog_get(), &sec_ctx);
+	catalog_update(ti->scanrel, tuple);
+	catalog_restore_user(&sec_ctx);
+	heap_freetuple(tuple);
+
+	return false;
+}
+
+int
+minmax_index_set_column_name(MinMaxIndex *index, const char *newname)
+{
+	ScanKeyData scankey[1];
+
+	ScanKeyInit(&scankey[0], Anum_minmax_index_pkey_idx_id,
+				BTEqualStrategyNumber, F_INT4EQ, Int32GetDatum(index->fd.id));
+
+	return minmax_index_scan(scankey, 1, MINMAX_INDEX_PKEY_IDX,
+							 minmax_index_tuple_set_column_name,
+							 (void *) newname, RowExclusiveLock);
+}
+
+/*
+ * Chunk min/max range catalog.
+ */
+
+static void
+chunk_minmax_range_from_tuple(TupleInfo *ti, MinMaxRange *range)
+{
+	bool		min_isnull,
+				max_isnull;
+	Datum		min = heap_getattr(ti->tuple, Anum_chunk_minmax_min_value, ti->desc, &min_isnull);
+	Datum		max = heap_getattr(ti->tuple, Anum_chunk_minmax_max_value, ti->desc, &max_isnull);
+
+	range->isnull = min_isnull || max_isnull;
+	range->min = range->isnull ? 0 : DatumGetInt64(min);
+	range->max = range->isnull ? 0 : DatumGetInt64(max);
+}
+
+static void
+chunk_minmax_range_to_values(MinMaxRange *range, Datum *values, bool *nulls)
+{
+	values[Anum_chunk_minmax_min_value - 1] = Int64GetDatum(range->min);
+	values[Anum_chunk_minmax_max_value - 1] = Int64GetDatum(range->max);
+	nulls[Anum_chunk_minmax_min_value - 1] = range->isnull;
+	nulls[Anum_chunk_minmax_max_value - 1] = range->isnull;
+}
+
+static void
+chunk_minmax_insert_relation(Relation rel, int32 chunk_id, int32 minmax_index_id, MinMaxRange *range)
+{
+	Datum		values[Natts_chunk_minmax];
+	bool		nulls[Natts_chunk_minmax] = {false};
+	CatalogSecurityContext sec_ctx;
+
+	values[Anum_chunk_minmax_chunk_id - 1] = Int32GetDatum(chunk_id);
+	values[Anum_chunk_minmax_minmax_index_id - 1] = Int32GetDatum(minmax_index_id);
+	chunk_minmax_range_to_values(range, values, nulls);
+
+	catalog_become_owner(catalog_get(), &sec_ctx);
+	catalog_insert_values(rel, RelationGetDescr(rel), values, nulls);
+	catalog_restore_user(&sec_ctx);
+}
+
+static void
+chunk_minmax_insert(int32 chunk_id, int32 minmax_index_id, MinMaxRange *range)
+{
+	Catalog    *catalog = catalog_get();
+	Relation	rel;
+
+	rel = heap_open(catalog->tables[CHUNK_MINMAX].id, RowExclusiveLock);
+	chunk_minmax_insert_relation(rel, chunk_id, minmax_index_id, range);
+	heap_close(rel, RowExclusiveLock);
+}
+
+/*
+ * Add empty ranges for a new chunk. The chunk has no rows yet, so its ranges
+ * are known to be empty.
+ */
+void
+chunk_minmax_insert_empty(Hypertable *ht, int32 chunk_id)
+{
+	Catalog    *catalog = catalog_get();
+	Relation	rel;
+	MinMaxRange range = {
+		.isnull = true,
+	};
+	ListCell   *lc;
+
+	if (ht->minmax_indexes == NIL)
+		return;
+
+	rel = heap_open(catalog->tables[CHUNK_MINMAX].id, RowExclusiveLock);
+
+	foreach(lc, ht->minmax_indexes)
+	{
+		MinMaxIndex *index = lfirst(lc);
+
+		chunk_minmax_insert_relation(rel, chunk_id, index->fd.id, &range);
+	}
+
+	heap_close(rel, RowExclusiveLock);
+}
+
+static int
+chunk_minmax_scan(ScanKeyData *scankey,
+				  int nkeys,
+				  bool use_index,
+				  tuple_found_func tuple_found,
+				  void *data,
+				  LOCKMODE lockmode,
+				  bool tuplock,
+				  Snapshot snapshot)
+{
+	Catalog    *catalog = catalog_get();
+	ScannerCtx	scanctx = {
+		.table = catalog->tables[CHUNK_MINMAX].id,
+		.index = use_index ? CATALOG_INDEX(catalog, CHUNK_MINMAX, CHUNK_MINMAX_PKEY_IDX) : InvalidOid,
+		.nkeys = nkeys,
+		.scankey = scankey,
+		.tuple_found = tuple_found,
+		.data = data,
+		.lockmode = lockmode,
+		.tuplock = {
+			.lockmode = LockTupleExclusive,
+			.waitpolicy = LockWaitBlock,
+			.enabled = tuplock,
+		},
+		.scandirection = ForwardScanDirection,
+		.snapshot = snapshot,
+	};
+
+	return scanner_scan(&scanctx);
+}
+
+static int
+chunk_minmax_scan_by_chunk_and_index_id(int32 chunk_id,
+										int32 minmax_index_id,
+										tuple_found_func tuple_found,
+										void *data,
+										LOCKMODE lockmode,
+										bool tuplock,
+										Snapshot snapshot)
+{
+	ScanKeyData scankey[2];
+
+	ScanKeyInit(&scankey[0], Anum_chunk_minmax_pkey_idx_chunk_id,
+				BTEqualStrategyNumber, F_INT4EQ, Int32GetDatum(chunk_id));
+	ScanKeyInit(&scankey[1], Anum_chunk_minmax_pkey_idx_minmax_index_id,
+				BTEqualStrategyNumber, F_INT4EQ, Int32GetDatum(minmax_index_id));
+
+	return chunk_minmax_scan(scankey, 2, true, tuple_found, data, lockmode, tuplock, snapshot);
+}
+
+static bool
+chunk_minmax_tuple_get_range(TupleInfo *ti, void *data)
+{
+	chunk_minmax_range_from_tuple(ti, data);
+
+	return false;
+}
+
+/*
+ * Get the range of a chunk for a min/max index as seen by the given snapshot
+ * (or the latest range, if NULL). Returns false if the range is unknown.
+ */
+static bool
+chunk_minmax_get_range(int32 chunk_id, int32 minmax_index_id, MinMaxRange *range, Snapshot snapshot)
+{
+	return chunk_minmax_scan_by_chunk_and_index_id(chunk_id, minmax_index_id,
+												   chunk_minmax_tuple_get_range,
+												   range, AccessShareLock, false, snapshot) > 0;
+}
+
+static bool
+chunk_minmax_tuple_delete(TupleInfo *ti, void *data)
+{
+	CatalogSecurityContext sec_ctx;
+
+	catalog_become_owner(catalog_get(), &sec_ctx);
+	catalog_delete(ti->scanrel, ti->tuple);
+	catalog_restore_user(&sec_ctx);
+
+	return true;
+}
+
+int
+chunk_minmax_delete_by_chunk_id(int32 chunk_id)
+{
+	ScanKeyData scankey[1];
+
+	ScanKeyInit(&scankey[0], Anum_chunk_minmax_pkey_idx_chunk_id,
+				BTEqualStrategyNumber, F_INT4EQ, Int32GetDatum(chunk_id));
+
+	return chunk_minmax_scan(scankey, 1, true, chunk_minmax_tuple_delete,
+							 NULL, RowExclusiveLock, false, NULL);
+}
+
+static int
+chunk_minmax_delete_by_minmax_index_id(int32 minmax_index_id)
+{
+	ScanKeyData scankey[1];
+
+	/* Not the leading column of the primary key, so do a heap scan */
+	ScanKeyInit(&scankey[0], Anum_chunk_minmax_minmax_index_id,
+				BTEqualStrategyNumber, F_INT4EQ, Int32GetDatum(minmax_index_id));
+
+	return chunk_minmax_scan(scankey, 1, false, chunk_minmax_tuple_delete,
+							 NULL, RowExclusiveLock, false, NULL);
+}
+
+typedef struct ChunkMinMaxWiden
+{
+	MinMaxRange range;			/* the range to add, and the resulting range */
+	bool		found;
+	bool		retry;
+} ChunkMinMaxWiden;
+
+static bool
+chunk_minmax_tuple_widen(TupleInfo *ti, void *data)
+{
+	ChunkMinMaxWiden *widen = data;
+	MinMaxRange current;
+	HeapTuple	new_tuple;
+	Datum		values[Natts_chunk_minmax];
+	bool		nulls[Natts_chunk_minmax];
+	CatalogSecurityContext sec_ctx;
+
+	switch (ti->lockresult)
+	{
+		case HeapTupleMayBeUpdated:
+		case HeapTupleSelfUpdated:
+			break;
+		case HeapTupleUpdated:
+			/* Widened by a concurrent transaction, so read the new version */
+			widen->retry = true;
+			return false;
+		default:
+			elog(ERROR, "unexpected tuple lock status");
+	}
+
+	widen->found = true;
+	chunk_minmax_range_from_tuple(ti, &current);
+
+	if (minmax_range_contains(&current, &widen->range))
+	{
+		widen->range = current;
+		return false;
+	}
+
+	minmax_range_add_range(&widen->range, &current);
+
+	heap_deform_tuple(ti->tuple, ti->desc, values, nulls);
+	chunk_minmax_range_to_values(&widen->range, values, nulls);
+	new_tuple = heap_form_tuple(ti->desc, values, nulls);
+
+	catalog_become_owner(catalog_get(), &sec_ctx);
+	catalog_update_tid(ti->scanrel, &ti->tuple->t_self, new_tuple);
+	catalog_restore_user(&sec_ctx);
+	heap_freetuple(new_tuple);
+
+	return false;
+}
+
+/*
+ * Widen the range of a chunk to include the given range. The range is updated
+ * to the chunk's new range. Returns false if the chunk's range is unknown.
+ *
+ * The catalog row is locked while it is updated, so that concurrent writers
+ * widen the range in turn rather than overwriting each other's changes. The
+ * lock is held until the end of the transaction.
+ */
+static bool
+chunk_minmax_widen(int32 chunk_id, int32 minmax_index_id, MinMaxRange *range)
+{
+	ChunkMinMaxWiden widen = {
+		.range = *range,
+	};
+
+	do
+	{
+		widen.retry = false;
+		chunk_minmax_scan_by_chunk_and_index_id(chunk_id, minmax_index_id,
+												chunk_minmax_tuple_widen,
+												&widen, RowExclusiveLock, true, NULL);
+	} while (widen.retry);
+
+	*range = widen.range;
+
+	return widen.found;
+}
+
+/*
+ * Range tracking.
+ */
+
+static ChunkMinMaxTracker *
+chunk_minmax_tracker_alloc(List *indexes, int32 chunk_id, Oid relid)
+{
+	ChunkMinMaxTracker *tracker;
+	ListCell   *lc;
+	int			i = 0;
+
+	tracker = palloc0(sizeof(ChunkMinMaxTracker) + sizeof(ChunkMinMaxColumn) * list_length(indexes));
+	tracker->chunk_id = chunk_id;
+	tracker->num_columns = list_length(indexes);
+
+	foreach(lc, indexes)
+	{
+		MinMaxIndex *index = lfirst(lc);
+		ChunkMinMaxColumn *column = &tracker->columns[i++];
+
+		column->minmax_index_id = index->fd.id;
+		column->attno = get_attnum(relid, NameStr(index->fd.column_name));
+		column->type = index->column_type;
+		column->tracked = AttributeNumberIsValid(column->attno) &&
+			chunk_minmax_get_range(chunk_id, index->fd.id, &column->catalog_range, NULL);
+		column->range = column->catalog_range;
+	}
+
+	return tracker;
+}
+
+/*
+ * Remove the min/max range trigger from a chunk's result relation, since the
+ * rows inserted via the relation are tracked while they are dispatched.
+ */
+static void
+result_relation_remove_minmax_trigger(ResultRelInfo *rri)
+{
+	TriggerDesc *trigdesc = rri->ri_TrigDesc;
+	Oid			trigger_funcid = catalog_get_internal_function_id(catalog_get(), MINMAX_RANGE_TRIGGER);
+	int			i,
+				n = 0;
+
+	if (NULL == trigdesc)
+		return;
+
+	trigdesc->trig_insert_after_row = false;
+	trigdesc->trig_update_after_row = false;
+
+	for (i = 0; i < trigdesc->numtriggers; i++)
+	{
+		Trigger    *trigger = &trigdesc->triggers[i];
+
+		if (trigger->tgfoid == trigger_funcid)
+			continue;
+
+		if (TRIGGER_TYPE_MATCHES(trigger->tgtype, TRIGGER_TYPE_ROW,
+								 TRIGGER_TYPE_AFTER, TRIGGER_TYPE_INSERT))
+			trigdesc->trig_insert_after_row = true;
+
+		if (TRIGGER_TYPE_MATCHES(trigger->tgtype, TRIGGER_TYPE_ROW,
+								 TRIGGER_TYPE_AFTER, TRIGGER_TYPE_UPDATE))
+			trigdesc->trig_update_after_row = true;
+
+		/*
+		 * The trigger functions and WHEN expressions of the result relation
+		 * are not yet initialized, so it is enough to move the triggers
+		 */
+		if (n != i)
+			trigdesc->triggers[n] = *trigger;
+		n++;
+	}
+
+	trigdesc->numtriggers = n;
+
+	if (n == 0)
+		rri->ri_TrigDesc = NULL;
+}
+
+/*
+ * Create a tracker for rows inserted into a chunk via its hypertable. The
+ * tracker expects tuples of the hypertable's rowtype.
+ *
+ * Returns NULL if the rows are instead tracked by the chunk's min/max range
+ * trigger. That is the case if rows might change after they are dispatched,
+ * i.e., if the chunk has BEFORE ROW triggers or if conflicting rows are
+ * updated rather than inserted.
+ */
+ChunkMinMaxTracker *
+chunk_minmax_tracker_create(Hypertable *ht, int32 chunk_id, ResultRelInfo *rri, OnConflictAction onconflict)
+{
+	if (ht->minmax_indexes == NIL)
+		return NULL;
+
+	if (onconflict == ONCONFLICT_UPDATE ||
+		(NULL != rri->ri_TrigDesc && rri->ri_TrigDesc->trig_insert_before_row))
+		return NULL;
+
+	result_relation_remove_minmax_trigger(rri);
+
+	return chunk_minmax_tracker_alloc(ht->minmax_indexes, chunk_id, ht->main_table_relid);
+}
+
+void
+chunk_minmax_tracker_add_tuple(ChunkMinMaxTracker *tracker, HeapTuple tuple, TupleDesc tupdesc)
+{
+	int			i;
+
+	for (i = 0; i < tracker->num_columns; i++)
+	{
+		ChunkMinMaxColumn *column = &tracker->columns[i];
+		Datum		value;
+		bool		isnull;
+		int64		internal;
+
+		if (!column->tracked)
+			continue;
+
+		value = heap_getattr(tuple, column->attno, tupdesc, &isnull);
+
+		if (isnull)
+			continue;
+
+		minmax_value_to_internal(value, column->type, &internal);
+		minmax_range_add_value(&column->range, internal);
+	}
+}
+
+/*
+ * Write the tracked ranges to the catalog. Only ranges that are wider than
+ * the catalog's touch the catalog.
+ */
+void
+chunk_minmax_tracker_flush(ChunkMinMaxTracker *tracker)
+{
+	int			i;
+
+	for (i = 0; i < tracker->num_columns; i++)
+	{
+		ChunkMinMaxColumn *column = &tracker->columns[i];
+
+		if (!column->tracked ||
+			minmax_range_contains(&column->catalog_range, &column->range))
+			continue;
+
+		column->tracked = chunk_minmax_widen(tracker->chunk_id,
+											 column->minmax_index_id,
+											 &column->range);
+		column->catalog_range = column->range;
+	}
+}
+
+static int
+chunk_minmax_tracker_cmp(const void *left, const void *right)
+{
+	const ChunkMinMaxTracker *l = *((ChunkMinMaxTracker *const *) left);
+	const ChunkMinMaxTracker *r = *((ChunkMinMaxTracker *const *) right);
+
+	if (l->chunk_id < r->chunk_id)
+		return -1;
+	if (l->chunk_id > r->chunk_id)
+		return 1;
+	return 0;
+}
+
+/*
+ * Flush a list of trackers. The ranges are written in chunk order so that
+ * concurrent transactions lock the catalog rows in the same order.
+ */
+void
+chunk_minmax_tracker_flush_all(List *trackers)
+{
+	ChunkMinMaxTracker **sorted;
+	ListCell   *lc;
+	int			num_trackers = 0;
+	int			i;
+
+	if (trackers == NIL)
+		return;
+
+	sorted = palloc(sizeof(ChunkMinMaxTracker *) * list_length(trackers));
+
+	foreach(lc, trackers)
+		sorted[num_trackers++] = lfirst(lc);
+
+	qsort(sorted, num_trackers, sizeof(ChunkMinMaxTracker *), chunk_minmax_tracker_cmp);
+
+	for (i = 0; i < num_trackers; i++)
+		chunk_minmax_tracker_flush(sorted[i]);
+
+	pfree(sorted);
+}
+
+/*
+ * Compute the range of a column in a chunk from the chunk's rows and add it
+ * to the catalog.
+ */
+static void
+chunk_minmax_backfill(Oid chunk_relid, int32 chunk_id, int32 minmax_index_id,
+					  const char *column_name, Oid column_type)
+{
+	Relation	rel = heap_open(chunk_relid, ShareLock);
+	TupleDesc	tupdesc = RelationGetDescr(rel);
+	AttrNumber	attno = get_attnum(chunk_relid, column_name);
+	MinMaxRange range = {
+		.isnull = true,
+	};
+	Snapshot	snapshot;
+	HeapScanDesc scan;
+	HeapTuple	tuple;
+
+	snapshot = RegisterSnapshot(GetLatestSnapshot());
+	scan = heap_beginscan(rel, snapshot, 0, NULL);
+
+	while ((tuple = heap_getnext(scan, ForwardScanDirection)) != NULL)
+	{
+		bool		isnull;
+		Datum		value = heap_getattr(tuple, attno, tupdesc, &isnull);
+		int64		internal;
+
+		if (isnull)
+			continue;
+
+		minmax_value_to_internal(value, column_type, &internal);
+		minmax_range_add_value(&range, internal);
+	}
+
+	heap_endscan(scan);
+	UnregisterSnapshot(snapshot);
+	heap_close(rel, NoLock);
+
+	chunk_minmax_insert(chunk_id, minmax_index_id, &range);
+}
+
+/*
+ * Min/max range trigger.
+ */
+
+static void
+minmax_range_trigger_create(Hypertable *ht)
+{
+	CreateTrigStmt stmt = {
+		.type = T_CreateTrigStmt,
+		.trigname = MINMAX_RANGE_TRIGGER_NAME,
+		.relation = makeRangeVarFromRelid(ht->main_table_relid),
+		.funcname = list_make2(makeString(INTERNAL_SCHEMA_NAME), makeString("minmax_range_trigger")),
+		.args = NIL,
+		.row = true,
+		.timing = TRIGGER_TYPE_AFTER,
+		.events = TRIGGER_TYPE_INSERT | TRIGGER_TYPE_UPDATE,
+		.columns = NIL,
+		.whenClause = NULL,
+		.isconstraint = false,
+	};
+	ObjectAddress address;
+	List	   *children;
+	ListCell   *lc;
+
+	if (OidIsValid(get_trigger_oid(ht->main_table_relid, MINMAX_RANGE_TRIGGER_NAME, true)))
+		return;
+
+	address = CreateTrigger(&stmt, NULL, InvalidOid, InvalidOid,
+							InvalidOid, InvalidOid, false);
+	CommandCounterIncrement();
+
+	children = find_inheritance_children(ht->main_table_relid, NoLock);
+
+	foreach(lc, children)
+	{
+		Chunk	   *chunk = chunk_get_by_relid(lfirst_oid(lc), 0, true);
+
+		trigger_create_on_chunk(address.objectId,
+								NameStr(chunk->fd.schema_name),
+								NameStr(chunk->fd.table_name));
+	}
+}
+
+static void
+minmax_range_trigger_drop_on_relation(Oid relid)
+{
+	ObjectAddress address = {
+		.classId = TriggerRelationId,
+		.objectId = get_trigger_oid(relid, MINMAX_RANGE_TRIGGER_NAME, true),
+	};
+
+	if (OidIsValid(address.objectId))
+		performDeletion(&address, DROP_RESTRICT, 0);
+}
+
+static void
+minmax_range_trigger_drop(Hypertable *ht)
+{
+	List	   *children = find_inheritance_children(ht->main_table_relid, NoLock);
+	ListCell   *lc;
+
+	foreach(lc, children)
+		minmax_range_trigger_drop_on_relation(lfirst_oid(lc));
+
+	minmax_range_trigger_drop_on_relation(ht->main_table_relid);
+}
+
+typedef struct MinMaxRangeTriggerState
+{
+	Oid			relid;
+	ChunkMinMaxTracker *tracker;
+} MinMaxRangeTriggerState;
+
+static MinMaxRangeTriggerState *
+minmax_range_trigger_state_create(Relation rel, MemoryContext mcxt)
+{
+	MinMaxRangeTriggerState *state = MemoryContextAllocZero(mcxt, sizeof(MinMaxRangeTriggerState));
+	Chunk	   *chunk = chunk_get_by_relid(RelationGetRelid(rel), 0, false);
+	Cache	   *hcache;
+	Hypertable *ht;
+	MemoryContext old;
+
+	state->relid = RelationGetRelid(rel);
+
+	if (NULL == chunk)
+		return state;
+
+	hcache = hypertable_cache_pin();
+	ht = hypertable_cache_get_entry_by_id(hcache, chunk->fd.hypertable_id);
+
+	if (NULL != ht && ht->minmax_indexes != NIL)
+	{
+		old = MemoryContextSwitchTo(mcxt);
+		state->tracker = chunk_minmax_tracker_alloc(ht->minmax_indexes, chunk->fd.id, state->relid);
+		MemoryContextSwitchTo(old);
+	}
+
+	cache_release(hcache);
+
+	return state;
+}
+
+/*
+ * Row trigger that widens the min/max ranges of a chunk to include inserted
+ * and updated rows.
+ */
+TS_FUNCTION_INFO_V1(minmax_range_trigger);
+
+Datum
+minmax_range_trigger(PG_FUNCTION_ARGS)
+{
+	TriggerData *trigdata = (TriggerData *) fcinfo->context;
+	MinMaxRangeTriggerState *state;
+	HeapTuple	tuple;
+
+	if (!CALLED_AS_TRIGGER(fcinfo))
+		elog(ERROR, "minmax_range_trigger: not called by trigger manager");
+
+	if (!TRIGGER_FIRED_AFTER(trigdata->tg_event) || !TRIGGER_FIRED_FOR_ROW(trigdata->tg_event))
+		elog(ERROR, "minmax_range_trigger: must be fired AFTER ROW");
+
+	state = fcinfo->flinfo->fn_extra;
+
+	if (NULL == state || state->relid != RelationGetRelid(trigdata->tg_relation))
+	{
+		state = minmax_range_trigger_state_create(trigdata->tg_relation, fcinfo->flinfo->fn_mcxt);
+		fcinfo->flinfo->fn_extra = state;
+	}
+
+	if (TRIGGER_FIRED_BY_UPDATE(trigdata->tg_event))
+		tuple = trigdata->tg_newtuple;
+	else
+		tuple = trigdata->tg_trigtuple;
+
+	if (NULL != state->tracker)
+	{
+		chunk_minmax_tracker_add_tuple(state->tracker, tuple, RelationGetDescr(trigdata->tg_relation));
+		chunk_minmax_tracker_flush(state->tracker);
+	}
+
+	return PointerGetDatum(NULL);
+}
+
+/*
+ * Adding and removing min/max indexes.
+ */
+
+static Hypertable *
+minmax_index_get_hypertable(Cache *hcache, Oid table_relid)
+{
+	Hypertable *ht;
+
+	if (!OidIsValid(table_relid))
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("invalid main_table")));
+
+	hypertable_permissions_check(table_relid, GetUserId());
+
+	/*
+	 * Block writes to the hypertable while the ranges of existing chunks are
+	 * computed. This is also the lock needed to create and drop triggers.
+	 */
+	LockRelationOid(table_relid, ShareRowExclusiveLock);
+
+	ht = hypertable_cache_get_entry(hcache, table_relid);
+
+	if (NULL == ht)
+		ereport(ERROR,
+				(errcode(ERRCODE_IO_HYPERTABLE_NOT_EXIST),
+				 errmsg("table \"%s\" is not a hypertable",
+						get_rel_name(table_relid))));
+
+	return ht;
+}
+
+/*
+ * Remove a min/max index and its ranges. The min/max range trigger is dropped
+ * along with the last index of the hypertable.
+ */
+void
+minmax_index_drop(Hypertable *ht, MinMaxIndex *index)
+{
+	ScanKeyData scankey[1];
+
+	chunk_minmax_delete_by_minmax_index_id(index->fd.id);
+
+	ScanKeyInit(&scankey[0], Anum_minmax_index_pkey_idx_id,
+				BTEqualStrategyNumber, F_INT4EQ, Int32GetDatum(index->fd.id));
+	minmax_index_scan(scankey, 1, MINMAX_INDEX_PKEY_IDX,
+					  minmax_index_tuple_delete, NULL, RowExclusiveLock);
+
+	if (minmax_index_scan_by_hypertable_id_internal(ht->fd.id, NULL, NULL, AccessShareLock) == 0)
+		minmax_range_trigger_drop(ht);
+}
+
+int
+minmax_index_delete_by_hypertable_id(int32 hypertable_id)
+{
+	List	   *indexes = minmax_index_scan_by_hypertable_id(hypertable_id, InvalidOid);
+	ListCell   *lc;
+
+	foreach(lc, indexes)
+		chunk_minmax_delete_by_minmax_index_id(((MinMaxIndex *) lfirst(lc))->fd.id);
+
+	return minmax_index_scan_by_hypertable_id_internal(hypertable_id, minmax_index_tuple_delete,
+													   NULL, RowExclusiveLock);
+}
+
+TS_FUNCTION_INFO_V1(minmax_index_add);
+
+/*
+ * Add a min/max index on a column of a hypertable.
+ *
+ * Arguments:
+ * 0. Relation ID of the hypertable
+ * 1. Column name
+ * 2. IF NOT EXISTS option (bool)
+ */
+Datum
+minmax_index_add(PG_FUNCTION_ARGS)
+{
+	Oid			table_relid = PG_ARGISNULL(0) ? InvalidOid : PG_GETARG_OID(0);
+	Name		column_name = PG_ARGISNULL(1) ? NULL : PG_GETARG_NAME(1);
+	bool		if_not_exists = PG_ARGISNULL(2) ? false : PG_GETARG_BOOL(2);
+	Cache	   *hcache = hypertable_cache_pin();
+	Hypertable *ht = minmax_index_get_hypertable(hcache, table_relid);
+	AttrNumber	attno;
+	Oid			column_type;
+	int32		minmax_index_id;
+	List	   *children;
+	ListCell   *lc;
+
+	if (NULL == column_name)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("invalid column name")));
+
+	attno = get_attnum(table_relid, NameStr(*column_name));
+
+	if (!AttributeNumberIsValid(attno))
+		ereport(ERROR,
+				(errcode(ERRCODE_UNDEFINED_COLUMN),
+				 errmsg("column \"%s\" does not exist", NameStr(*column_name))));
+
+	column_type = get_atttype(table_relid, attno);
+
+	if (!minmax_index_type_is_supported(column_type))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("cannot add a min/max index on column \"%s\" of type %s",
+						NameStr(*column_name), format_type_be(column_type)),
+				 errhint("Min/max indexes support integer, date, and timestamp columns.")));
+
+	if (NULL != hyperspace_get_dimension_by_name(ht->space, DIMENSION_TYPE_ANY, NameStr(*column_name)))
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("cannot add a min/max index on partitioning column \"%s\"",
+						NameStr(*column_name))));
+
+	if (NULL != minmax_index_get_by_column_name(ht->minmax_indexes, NameStr(*column_name)))
+	{
+		if (!if_not_exists)
+			ereport(ERROR,
+					(errcode(ERRCODE_DUPLICATE_OBJECT),
+					 errmsg("min/max index on column \"%s\" already exists",
+							NameStr(*column_name))));
+
+		ereport(NOTICE,
+				(errmsg("min/max index on column \"%s\" already exists, skipping",
+						NameStr(*column_name))));
+		cache_release(hcache);
+		PG_RETURN_VOID();
+	}
+
+	minmax_index_id = minmax_index_insert(ht->fd.id, column_name);
+
+	/*
+	 * Compute the ranges of existing chunks. Compressed chunks are left
+	 * without a range, which means they are never excluded.
+	 */
+	children = find_inheritance_children(ht->main_table_relid, NoLock);
+
+	foreach(lc, children)
+	{
+		Oid			chunk_relid = lfirst_oid(lc);
+		Chunk	   *chunk = chunk_get_by_relid(chunk_relid, 0, false);
+
+		if (NULL == chunk || NULL != compressed_chunk_get_by_chunk_id(chunk->fd.id))
+			continue;
+
+		chunk_minmax_backfill(chunk_relid, chunk->fd.id, minmax_index_id,
+							  NameStr(*column_name), column_type);
+	}
+
+	minmax_range_trigger_create(ht);
+	cache_release(hcache);
+
+	PG_RETURN_VOID();
+}
+
+TS_FUNCTION_INFO_V1(minmax_index_remove);
+
+/*
+ * Remove a min/max index from a hypertable.
+ *
+ * Arguments:
+ * 0. Relation ID of the hypertable
+ * 1. Column name
+ * 2. IF EXISTS option (bool)
+ */
+Datum
+minmax_index_remove(PG_FUNCTION_ARGS)
+{
+	Oid			table_relid = PG_ARGISNULL(0) ? InvalidOid : PG_GETARG_OID(0);
+	Name		column_name = PG_ARGISNULL(1) ? NULL : PG_GETARG_NAME(1);
+	bool		if_exists = PG_ARGISNULL(2) ? false : PG_GETARG_BOOL(2);
+	Cache	   *hcache = hypertable_cache_pin();
+	Hypertable *ht = minmax_index_get_hypertable(hcache, table_relid);
+	MinMaxIndex *index;
+
+	if (NULL == column_name)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("invalid column name")));
+
+	index = minmax_index_get_by_column_name(ht->minmax_indexes, NameStr(*column_name));
+
+	if (NULL == index)
+	{
+		if (!if_exists)
+			ereport(ERROR,
+					(errcode(ERRCODE_UNDEFINED_OBJECT),
+					 errmsg("min/max index on column \"%s\" does not exist",
+							NameStr(*column_name))));
+
+		ereport(NOTICE,
+				(errmsg("min/max index on column \"%s\" does not exist, skipping",
+						NameStr(*column_name))));
+	}
+	else
+		minmax_index_drop(ht, index);
+
+	cache_release(hcache);
+
+	PG_RETURN_VOID();
+}
+
+/*
+ * Chunk exclusion.
+ */
+
+static MinMaxRestrictInfo *
+minmax_restrict_info_get(List **restrictions, int32 minmax_index_id)
+{
+	MinMaxRestrictInfo *mri;
+	ListCell   *lc;
+
+	foreach(lc, *restrictions)
+	{
+		mri = lfirst(lc);
+
+		if (mri->minmax_index_id == minmax_index_id)
+			return mri;
+	}
+
+	mri = palloc(sizeof(MinMaxRestrictInfo));
+	mri->minmax_index_id = minmax_index_id;
+	mri->lower = PG_INT64_MIN;
+	mri->upper = PG_INT64_MAX;
+	*restrictions = lappend(*restrictions, mri);
+
+	return mri;
+}
+
+/*
+ * Add a restriction of the form "column op value". Strict inequalities on the
+ * bounds of the internal range cannot be expressed as inclusive bounds and
+ * are ignored.
+ */
+static void
+minmax_restrict_info_add(List **restrictions, MinMaxIndex *index, int strategy, int64 value)
+{
+	MinMaxRestrictInfo *mri;
+
+	if ((strategy == BTLessStrategyNumber && value == PG_INT64_MIN) ||
+		(strategy == BTGreaterStrategyNumber && value == PG_INT64_MAX))
+		return;
+
+	mri = minmax_restrict_info_get(restrictions, index->fd.id);
+
+	switch (strategy)
+	{
+		case BTLessStrategyNumber:
+			mri->upper = Min(mri->upper, value - 1);
+			break;
+		case BTLessEqualStrategyNumber:
+			mri->upper = Min(mri->upper, value);
+			break;
+		case BTEqualStrategyNumber:
+			mri->lower = Max(mri->lower, value);
+			mri->upper = Min(mri->upper, value);
+			break;
+		case BTGreaterEqualStrategyNumber:
+			mri->lower = Max(mri->lower, value);
+			break;
+		case BTGreaterStrategyNumber:
+			mri->lower = Max(mri->lower, value + 1);
+			break;
+		default:
+			break;
+	}
+}
+
+static void
+minmax_restrict_info_add_opexpr(List **restrictions, Hypertable *ht, Index rti, OpExpr *op)
+{
+	Node	   *left,
+			   *right;
+	Var		   *var;
+	Const	   *c;
+	MinMaxIndex *index;
+	TypeCacheEntry *tce;
+	Oid			lefttype,
+				righttype;
+	int64		value;
+	int			strategy;
+	bool		commuted = false;
+
+	if (list_length(op->args) != 2)
+		return;
+
+	left = linitial(op->args);
+	right = lsecond(op->args);
+
+	if (IsA(left, Var) && IsA(right, Const))
+	{
+		var = (Var *) left;
+		c = (Const *) right;
+	}
+	else if (IsA(right, Var) && IsA(left, Const))
+	{
+		var = (Var *) right;
+		c = (Const *) left;
+		commuted = true;
+	}
+	else
+		return;
+
+	if (var->varno != rti || var->varlevelsup != 0 || c->constisnull)
+		return;
+
+	/*
+	 * Integers of different widths have the same internal representation, so
+	 * integer columns can be compared with any integer constant
+	 */
+	if (c->consttype != var->vartype &&
+		!(minmax_index_type_is_integer(c->consttype) &&
+		  minmax_index_type_is_integer(var->vartype)))
+		return;
+
+	index = minmax_index_get_by_attno(ht->minmax_indexes, var->varattno);
+
+	if (NULL == index)
+		return;
+
+	op_input_types(op->opno, &lefttype, &righttype);
+
+	if ((commuted ? righttype : lefttype) != var->vartype ||
+		(commuted ? lefttype : righttype) != c->consttype)
+		return;
+
+	tce = lookup_type_cache(var->vartype, TYPECACHE_BTREE_OPFAMILY);
+
+	if (!OidIsValid(tce->btree_opf))
+		return;
+
+	strategy = get_op_opfamily_strategy(op->opno, tce->btree_opf);
+
+	if (commuted)
+	{
+		switch (strategy)
+		{
+			case BTLessStrategyNumber:
+				strategy = BTGreaterStrategyNumber;
+				break;
+			case BTLessEqualStrategyNumber:
+				strategy = BTGreaterEqualStrategyNumber;
+				break;
+			case BTGreaterEqualStrategyNumber:
+				strategy = BTLessEqualStrategyNumber;
+				break;
+			case BTGreaterStrategyNumber:
+				strategy = BTLessStrategyNumber;
+				break;
+			default:
+				break;
+		}
+	}
+
+	if (strategy == 0 || !minmax_value_to_internal(c->constvalue, c->consttype, &value))
+		return;
+
+	minmax_restrict_info_add(restrictions, index, strategy, value);
+}
+
+/*
+ * Get the restrictions on min/max indexed columns of a hypertable from a list
+ * of restriction clauses. Only clauses of the form "column op constant" are
+ * used, so clauses must be constified before chunks are excluded.
+ */
+List *
+minmax_restrict_info_create(Hypertable *ht, Index rti, List *restrictinfos)
+{
+	List	   *restrictions = NIL;
+	ListCell   *lc;
+
+	if (ht->minmax_indexes == NIL)
+		return NIL;
+
+	foreach(lc, restrictinfos)
+	{
+		RestrictInfo *rinfo = lfirst(lc);
+
+		if (IsA(rinfo->clause, OpExpr))
+			minmax_restrict_info_add_opexpr(&restrictions, ht, rti, (OpExpr *) rinfo->clause);
+	}
+
+	return restrictions;
+}
+
+/*
+ * Check if a chunk's ranges overlap the given restrictions. Chunks with
+ * unknown ranges always match.
+ *
+ * The ranges are read with the query's snapshot, which sees the ranges of all
+ * rows visible to the query. Using the same snapshot also guarantees that all
+ * participants of a parallel query exclude the same chunks.
+ */
+bool
+chunk_minmax_matches(int32 chunk_id, List *restrictions, Snapshot snapshot)
+{
+	ListCell   *lc;
+
+	if (chunk_id <= 0)
+		return true;
+
+	foreach(lc, restrictions)
+	{
+		MinMaxRestrictInfo *mri = lfirst(lc);
+		MinMaxRange range;
+
+		if (mri->lower > mri->upper)
+			return false;
+
+		if (!chunk_minmax_get_range(chunk_id, mri->minmax_index_id, &range, snapshot))
+			continue;
+
+		/* The restriction clauses are strict, so NULLs never match */
+		if (range.isnull || range.max < mri->lower || range.min > mri->upper)
+			return false;
+	}
+
+	return true;
+}
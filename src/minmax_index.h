@@ -0,0 +1,49 @@
+#ifndef TIMESCALEDB_MINMAX_INDEX_H
+#define TIMESCALEDB_MINMAX_INDEX_H
+
+#include <postgres.h>
+#include <access/attnum.h>
+#include <access/htup.h>
+#include <access/tupdesc.h>
+#include <nodes/execnodes.h>
+#include <nodes/pg_list.h>
+#include <utils/snapshot.h>
+
+#include "catalog.h"
+#include "hypertable.h"
+
+#define MINMAX_RANGE_TRIGGER_NAME "ts_minmax_range"
+
+/*
+ * A min/max index tracks the range of values of a (non-partitioning) column
+ * in each chunk of a hypertable. Queries that restrict the column to values
+ * outside a chunk's range can skip the chunk.
+ */
+typedef struct MinMaxIndex
+{
+	FormData_minmax_index fd;
+	AttrNumber	column_attno;	/* attribute number in the main table */
+	Oid			column_type;
+} MinMaxIndex;
+
+/* Tracks the ranges of the rows written to a chunk */
+typedef struct ChunkMinMaxTracker ChunkMinMaxTracker;
+
+extern List *minmax_index_scan_by_hypertable_id(int32 hypertable_id, Oid main_table_relid);
+extern MinMaxIndex *minmax_index_get_by_column_name(List *indexes, const char *column_name);
+extern int	minmax_index_delete_by_hypertable_id(int32 hypertable_id);
+extern int	minmax_index_set_column_name(MinMaxIndex *index, const char *newname);
+extern void minmax_index_drop(Hypertable *ht, MinMaxIndex *index);
+
+extern void chunk_minmax_insert_empty(Hypertable *ht, int32 chunk_id);
+extern int	chunk_minmax_delete_by_chunk_id(int32 chunk_id);
+
+extern ChunkMinMaxTracker *chunk_minmax_tracker_create(Hypertable *ht, int32 chunk_id, ResultRelInfo *rri, OnConflictAction onconflict);
+extern void chunk_minmax_tracker_add_tuple(ChunkMinMaxTracker *tracker, HeapTuple tuple, TupleDesc tupdesc);
+extern void chunk_minmax_tracker_flush(ChunkMinMaxTracker *tracker);
+extern void chunk_minmax_tracker_flush_all(List *trackers);
+
+extern List *minmax_restrict_info_create(Hypertable *ht, Index rti, List *restrictinfos);
+extern bool chunk_minmax_matches(int32 chunk_id, List *restrictions, Snapshot snapshot);
+
+#endif							/* TIMESCALEDB_MINMAX_INDEX_H */
@@ -9,6 +9,7 @@
 #include <parser/parse_oper.h>
 #include <optimizer/clauses.h>
 #include <catalog/pg_type.h>
+#include <utils/lsyscache.h>
 
 #include "cache.h"
 #include "hypertable.h"
@@ -172,6 +173,49 @@ add_partitioning_func_qual_mutator(Node *node, AddPartFuncQualCtx *context)
 		}
 	}
 
+	/*
+	 * Detect partitioning_column = ANY(array), which is also what IN lists
+	 * are transformed into. If detected, replace with partitioning_column =
+	 * ANY(array) AND partitioning_func(partitioning_column) = ANY(hashes),
+	 * where hashes are the partitioning function applied to each element of
+	 * the array.
+	 */
+	if (IsA(node, ScalarArrayOpExpr))
+	{
+		ScalarArrayOpExpr *saop = (ScalarArrayOpExpr *) node;
+		Node	   *left = (Node *) linitial(saop->args);
+		Node	   *right = (Node *) lsecond(saop->args);
+
+		if (saop->useOr && IsA(left, Var))
+		{
+			if (!IsA(right, Const))
+			{
+				/* try to simplify the array expression */
+				right = eval_const_expressions(NULL, right);
+			}
+			if (IsA(right, Const))
+			{
+				Oid			eq_oid = OpernameGetOprid(list_make2(makeString("pg_catalog"), makeString("=")), exprType(left), get_element_type(exprType(right)));
+
+				if (eq_oid == saop->opno)
+				{
+					PartitioningInfo *pi =
+					get_partitioning_info_for_partition_column_var((Var *) left,
+																   context);
+
+					if (pi != NULL)
+					{
+						Expr	   *partitioning_clause =
+						partitioning_func_array_qual_create(pi, (Var *) left, (Const *) right);
+
+						if (partitioning_clause != NULL)
+							return (Node *) make_andclause(list_make2(node, partitioning_clause));
+					}
+				}
+			}
+		}
+	}
+
 	return expression_tree_mutator(node, add_partitioning_func_qual_mutator,
 								   (void *) context);
 }
@@ -189,6 +233,17 @@ add_partitioning_func_qual_mutator(Node *node, AddPartFuncQualCtx *context)
  *				partitioning_func(partition_column, partitioning_mod) =
  *				partitioning_func(const, partitioning_mod)
  *
+ * Similarly, quals of the form (including IN lists, which are transformed into
+ * this form by the parser):
+ *				partitioning_column = ANY(const_array)
+ * are transformed into:
+ *				partitioning_column = ANY(const_array) AND
+ *				partitioning_func(partition_column) = ANY(hashes)
+ * where hashes are the results of applying the partitioning function to each
+ * array element. OR-chains of equalities are covered by the first
+ * transformation, since each equality in the chain gets its own
+ * partitioning-function qual.
+ *
  * This tranformation helps because the check constraint on a table is of the
  * form CHECK(partitioning_func(partition_column, partitioning_mod) BETWEEN X
  * AND Y).
@@ -13,8 +13,11 @@
 #include <utils/acl.h>
 #include <utils/rangetypes.h>
 #include <utils/memutils.h>
+#include <utils/array.h>
+#include <utils/fmgroids.h>
 #include <catalog/namespace.h>
 #include <catalog/pg_type.h>
+#include <catalog/pg_operator.h>
 #include <access/hash.h>
 #include <access/htup_details.h>
 #include <parser/parse_coerce.h>
@@ -214,6 +217,103 @@ partitioning_func_apply_tuple(PartitioningInfo *pinfo, HeapTuple tuple, TupleDes
 	return partitioning_func_apply(pinfo, value);
 }
 
+/*
+ * Create a qual of the form
+ *
+ *	   partitioning_func(var) = ANY('{hash1, hash2, ...}')
+ *
+ * given a set of values for the partitioning column. Each value is hashed
+ * using the dimension's partitioning function, the same way as when tuples
+ * are inserted, so the resulting qual can be refuted by the CHECK constraints
+ * on chunks that do not cover any of the values. NULL values are skipped since
+ * they can never match an equality. Returns NULL if there are no non-NULL
+ * values.
+ */
+Expr *
+partitioning_func_qual_create(PartitioningInfo *pinfo, Var *var, Datum *values, bool *nulls, int num_values)
+{
+	ScalarArrayOpExpr *saop;
+	FuncExpr   *fexpr;
+	ArrayType  *arr;
+	int32	   *hashes;
+	Datum	   *elems;
+	int			num_hashes = 0;
+	int			num_elems = 0;
+	int			i;
+
+	if (num_values <= 0)
+		return NULL;
+
+	hashes = palloc(sizeof(int32) * num_values);
+
+	for (i = 0; i < num_values; i++)
+		if (NULL == nulls || !nulls[i])
+			hashes[num_hashes++] = partitioning_func_apply(pinfo, values[i]);
+
+	if (num_hashes == 0)
+		return NULL;
+
+	/* Remove duplicate hash values to keep the array small */
+	qsort(hashes, num_hashes, sizeof(int32), int_cmp);
+	elems = palloc(sizeof(Datum) * num_hashes);
+
+	for (i = 0; i < num_hashes; i++)
+		if (i == 0 || hashes[i] != hashes[i - 1])
+			elems[num_elems++] = Int32GetDatum(hashes[i]);
+
+	arr = construct_array(elems, num_elems, INT4OID, sizeof(int32), true, 'i');
+
+	fexpr = makeFuncExpr(pinfo->partfunc.func_fmgr.fn_oid,
+						 INT4OID,
+						 list_make1(copyObject(var)),
+						 InvalidOid,
+						 var->varcollid,
+						 COERCE_EXPLICIT_CALL);
+
+	saop = makeNode(ScalarArrayOpExpr);
+	saop->opno = Int4EqualOperator;
+	saop->opfuncid = F_INT4EQ;
+	saop->useOr = true;
+	saop->inputcollid = InvalidOid;
+	saop->args = list_make2(fexpr,
+							makeConst(INT4ARRAYOID, -1, InvalidOid, -1,
+									  PointerGetDatum(arr), false, false));
+	saop->location = -1;
+
+	return (Expr *) saop;
+}
+
+/*
+ * Create a partitioning function qual (see above) from an array of values of
+ * the partitioning column.
+ */
+Expr *
+partitioning_func_array_qual_create(PartitioningInfo *pinfo, Var *var, Const *array)
+{
+	ArrayType  *arr;
+	Datum	   *values;
+	bool	   *nulls;
+	int			num_values;
+	int16		elmlen;
+	bool		elmbyval;
+	char		elmalign;
+
+	if (array->constisnull)
+		return NULL;
+
+	arr = DatumGetArrayTypeP(array->constvalue);
+
+	/* The elements must have the type that the partitioning func expects */
+	if (ARR_ELEMTYPE(arr) != var->vartype)
+		return NULL;
+
+	get_typlenbyvalalign(ARR_ELEMTYPE(arr), &elmlen, &elmbyval, &elmalign);
+	deconstruct_array(arr, ARR_ELEMTYPE(arr), elmlen, elmbyval, elmalign,
+					  &values, &nulls, &num_values);
+
+	return partitioning_func_qual_create(pinfo, var, values, nulls, num_values);
+}
+
 /*
  * Resolve the type of the argument passed to a function.
  *
@@ -7,6 +7,7 @@
 #include <access/attnum.h>
 #include <access/htup_details.h>
 #include <utils/typcache.h>
+#include <nodes/primnodes.h>
 #include <fmgr.h>
 
 #include "catalog.h"
@@ -50,5 +51,7 @@ extern PartitioningInfo *partitioning_info_create(const char *schema,
 extern List *partitioning_func_qualified_name(PartitioningFunc *pf);
 extern int32 partitioning_func_apply(PartitioningInfo *pinfo, Datum value);
 extern int32 partitioning_func_apply_tuple(PartitioningInfo *pinfo, HeapTuple tuple, TupleDesc desc);
+extern Expr *partitioning_func_qual_create(PartitioningInfo *pinfo, Var *var, Datum *values, bool *nulls, int num_values);
+extern Expr *partitioning_func_array_qual_create(PartitioningInfo *pinfo, Var *var, Const *array);
 
 #endif							/* TIMESCALEDB_PARTITIONING_H */
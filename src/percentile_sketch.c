@@ -0,0 +1,587 @@
+#include <postgres.h>
+#include <fmgr.h>
+#include <lib/stringinfo.h>
+#include <libpq/pqformat.h>
+#include <utils/builtins.h>
+#include <math.h>
+
+#include "compat.h"
+
+/* aggregate percentile_sketch:
+ *	 percentile_sketch(val [, relative_accuracy]) returns a sketch of the distribution of val
+ *	 percentile_sketch_merge(sketch) returns the merge of several sketches
+ *	 approx_percentile(percentile, sketch) returns an approximate percentile from a sketch
+ *
+ * Usage:
+ *	 SELECT grouping_element, approx_percentile(0.99, percentile_sketch(field))
+ *	 FROM table GROUP BY grouping_element;
+ *
+ * Description:
+ * The sketch is a DDSketch: values are counted in logarithmically sized buckets, so that
+ * any percentile computed from the sketch is within the relative accuracy (1% by default)
+ * of a value at that rank. Unlike percentile_cont(), computing a sketch does not sort the
+ * values and sketches can be combined, so the aggregate can run in parallel. Sketches are
+ * returned as bytea so that they can be stored in tables and later merged with
+ * percentile_sketch_merge(), e.g., to roll up per-minute sketches into daily ones.
+ */
+
+TS_FUNCTION_INFO_V1(percentile_sketch_sfunc);
+TS_FUNCTION_INFO_V1(percentile_sketch_merge_sfunc);
+TS_FUNCTION_INFO_V1(percentile_sketch_combinefunc);
+TS_FUNCTION_INFO_V1(percentile_sketch_serializefunc);
+TS_FUNCTION_INFO_V1(percentile_sketch_deserializefunc);
+TS_FUNCTION_INFO_V1(percentile_sketch_finalfunc);
+TS_FUNCTION_INFO_V1(approx_percentile);
+
+#define SKETCH_FORMAT_VERSION 1
+#define SKETCH_DEFAULT_ACCURACY 0.01
+#define SKETCH_MIN_ACCURACY 0.0001
+#define SKETCH_MAX_ACCURACY 0.5
+
+/*
+ * The number of buckets per sign is bounded. With the default accuracy this
+ * covers more than 17 orders of magnitude; beyond that the buckets of the
+ * smallest magnitudes are collapsed into one.
+ */
+#define SKETCH_MAX_BUCKETS 2048
+
+/* Extra buckets to allocate when growing a store, to avoid frequent copying */
+#define SKETCH_BUCKET_SLACK 32
+
+/* Counts for a contiguous range of bucket indexes */
+typedef struct SketchStore
+{
+	int32		offset;			/* bucket index of counts[0] */
+	int32		nbuckets;
+	int64	   *counts;
+} SketchStore;
+
+typedef struct PercentileSketch
+{
+	double		relative_accuracy;
+	double		log_gamma;		/* log((1 + accuracy) / (1 - accuracy)) */
+	int64		count;
+	int64		zero_count;
+	double		min;
+	double		max;
+	SketchStore positive;		/* buckets of positive values */
+	SketchStore negative;		/* buckets of the magnitudes of negative values */
+} PercentileSketch;
+
+static void
+check_relative_accuracy(double relative_accuracy)
+{
+	if (isnan(relative_accuracy) ||
+		relative_accuracy < SKETCH_MIN_ACCURACY ||
+		relative_accuracy > SKETCH_MAX_ACCURACY)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("relative accuracy must be between %g and %g",
+						SKETCH_MIN_ACCURACY, SKETCH_MAX_ACCURACY)));
+}
+
+static PercentileSketch *
+sketch_create(MemoryContext mcxt, double relative_accuracy)
+{
+	PercentileSketch *sketch = MemoryContextAllocZero(mcxt, sizeof(PercentileSketch));
+
+	sketch->relative_accuracy = relative_accuracy;
+	sketch->log_gamma = log((1 + relative_accuracy) / (1 - relative_accuracy));
+	sketch->min = get_float8_infinity();
+	sketch->max = -get_float8_infinity();
+
+	return sketch;
+}
+
+/*
+ * Resize a store to cover the bucket indexes [lo, hi], where hi is not below
+ * the highest index of the store. Counts of buckets below lo are added to the
+ * lowest bucket.
+ */
+static void
+sketch_store_resize(SketchStore *store, int32 lo, int32 hi, MemoryContext mcxt)
+{
+	int64	   *counts = MemoryContextAllocZero(mcxt, sizeof(int64) * (hi - lo + 1));
+	int32		i;
+
+	for (i = 0; i < store->nbuckets; i++)
+	{
+		int32		index = store->offset + i;
+
+		counts[Max(index, lo) - lo] += store->counts[i];
+	}
+
+	if (store->counts != NULL)
+		pfree(store->counts);
+
+	store->offset = lo;
+	store->nbuckets = hi - lo + 1;
+	store->counts = counts;
+}
+
+/*
+ * Get the position of a bucket in a store, growing the store if needed.
+ */
+static int32
+sketch_store_position(SketchStore *store, int32 index, MemoryContext mcxt)
+{
+	int32		lo;
+	int32		hi;
+
+	if (store->nbuckets > 0 &&
+		index >= store->offset &&
+		index < store->offset + store->nbuckets)
+		return index - store->offset;
+
+	if (store->nbuckets == 0)
+	{
+		lo = index;
+		hi = index;
+	}
+	else if (index < store->offset)
+	{
+		lo = index - SKETCH_BUCKET_SLACK;
+		hi = store->offset + store->nbuckets - 1;
+	}
+	else
+	{
+		lo = store->offset;
+		hi = index + SKETCH_BUCKET_SLACK;
+	}
+
+	/* Collapse the buckets of the smallest magnitudes if there are too many */
+	if (hi - lo + 1 > SKETCH_MAX_BUCKETS)
+		lo = hi - SKETCH_MAX_BUCKETS + 1;
+
+	sketch_store_resize(store, lo, hi, mcxt);
+
+	return Max(index, lo) - lo;
+}
+
+static void
+sketch_store_add(SketchStore *store, int32 index, int64 count, MemoryContext mcxt)
+{
+	store->counts[sketch_store_position(store, index, mcxt)] += count;
+}
+
+static inline int32
+sketch_bucket_index(PercentileSketch *sketch, double magnitude)
+{
+	return (int32) ceil(log(magnitude) / sketch->log_gamma);
+}
+
+/*
+ * The value reported for a bucket. A bucket with index i covers the magnitudes
+ * (gamma^(i-1), gamma^i], which are all within the relative accuracy of
+ * gamma^i * (1 - accuracy).
+ */
+static inline double
+sketch_bucket_value(PercentileSketch *sketch, int32 index)
+{
+	return exp(index * sketch->log_gamma) * (1 - sketch->relative_accuracy);
+}
+
+static void
+sketch_add_value(PercentileSketch *sketch, double val, MemoryContext mcxt)
+{
+	if (isnan(val) || isinf(val))
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("percentile sketch values must be finite")));
+
+	if (val > 0)
+		sketch_store_add(&sketch->positive, sketch_bucket_index(sketch, val), 1, mcxt);
+	else if (val < 0)
+		sketch_store_add(&sketch->negative, sketch_bucket_index(sketch, -val), 1, mcxt);
+	else
+		sketch->zero_count++;
+
+	sketch->count++;
+
+	if (val < sketch->min)
+		sketch->min = val;
+	if (val > sketch->max)
+		sketch->max = val;
+}
+
+static void
+sketch_store_merge(SketchStore *into, SketchStore *from, MemoryContext mcxt)
+{
+	int32		i;
+
+	if (from->nbuckets == 0)
+		return;
+
+	/* Make room for the whole range up front, instead of bucket by bucket */
+	if (into->nbuckets > 0)
+	{
+		int32		lo = Min(into->offset, from->offset);
+		int32		hi = Max(into->offset + into->nbuckets, from->offset + from->nbuckets) - 1;
+
+		if (hi - lo + 1 > SKETCH_MAX_BUCKETS)
+			lo = hi - SKETCH_MAX_BUCKETS + 1;
+
+		if (lo != into->offset || hi != into->offset + into->nbuckets - 1)
+			sketch_store_resize(into, lo, hi, mcxt);
+	}
+
+	for (i = 0; i < from->nbuckets; i++)
+		if (from->counts[i] != 0)
+			sketch_store_add(into, from->offset + i, from->counts[i], mcxt);
+}
+
+/* Merge sketch "from" into sketch "into" */
+static void
+sketch_merge(PercentileSketch *into, PercentileSketch *from, MemoryContext mcxt)
+{
+	if (into->relative_accuracy != from->relative_accuracy)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("cannot combine percentile sketches with different relative accuracies")));
+
+	sketch_store_merge(&into->positive, &from->positive, mcxt);
+	sketch_store_merge(&into->negative, &from->negative, mcxt);
+	into->zero_count += from->zero_count;
+	into->count += from->count;
+
+	if (from->min < into->min)
+		into->min = from->min;
+	if (from->max > into->max)
+		into->max = from->max;
+}
+
+static PercentileSketch *
+sketch_copy(MemoryContext mcxt, PercentileSketch *sketch)
+{
+	PercentileSketch *copy = sketch_create(mcxt, sketch->relative_accuracy);
+
+	sketch_merge(copy, sketch, mcxt);
+
+	return copy;
+}
+
+static void
+sketch_store_send(StringInfo buf, SketchStore *store)
+{
+	int32		lo = 0;
+	int32		hi = store->nbuckets - 1;
+	int32		i;
+
+	/* Leave out empty buckets at the ends of the store */
+	while (lo <= hi && store->counts[lo] == 0)
+		lo++;
+	while (hi >= lo && store->counts[hi] == 0)
+		hi--;
+
+	pq_sendint(buf, store->offset + lo, 4);
+	pq_sendint(buf, hi - lo + 1, 4);
+
+	for (i = lo; i <= hi; i++)
+		pq_sendint64(buf, store->counts[i]);
+}
+
+static void
+sketch_store_recv(StringInfo buf, SketchStore *store, MemoryContext mcxt)
+{
+	int32		offset = pq_getmsgint(buf, 4);
+	int32		nbuckets = pq_getmsgint(buf, 4);
+	int32		i;
+
+	if (nbuckets < 0 || nbuckets > SKETCH_MAX_BUCKETS ||
+		(Size) (buf->len - buf->cursor) < sizeof(int64) * (Size) nbuckets)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+				 errmsg("invalid percentile sketch")));
+
+	if (nbuckets == 0)
+		return;
+
+	sketch_store_resize(store, offset, offset + nbuckets - 1, mcxt);
+
+	for (i = 0; i < nbuckets; i++)
+		store->counts[i] = pq_getmsgint64(buf);
+}
+
+static int64
+sketch_store_total(SketchStore *store)
+{
+	int64		total = 0;
+	int32		i;
+
+	for (i = 0; i < store->nbuckets; i++)
+	{
+		if (store->counts[i] < 0)
+			ereport(ERROR,
+					(errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+					 errmsg("invalid percentile sketch")));
+		total += store->counts[i];
+	}
+
+	return total;
+}
+
+static bytea *
+sketch_serialize(PercentileSketch *sketch)
+{
+	StringInfoData buf;
+
+	pq_begintypsend(&buf);
+	pq_sendbyte(&buf, SKETCH_FORMAT_VERSION);
+	pq_sendfloat8(&buf, sketch->relative_accuracy);
+	pq_sendint64(&buf, sketch->count);
+	pq_sendint64(&buf, sketch->zero_count);
+	pq_sendfloat8(&buf, sketch->min);
+	pq_sendfloat8(&buf, sketch->max);
+	sketch_store_send(&buf, &sketch->positive);
+	sketch_store_send(&buf, &sketch->negative);
+
+	return pq_endtypsend(&buf);
+}
+
+static PercentileSketch *
+sketch_deserialize(bytea *sstate, MemoryContext mcxt)
+{
+	StringInfoData buf;
+	PercentileSketch *sketch;
+	double		relative_accuracy;
+
+	/* Set up a StringInfo pointing into the bytea, which is not modified */
+	buf.data = VARDATA_ANY(sstate);
+	buf.len = VARSIZE_ANY_EXHDR(sstate);
+	buf.maxlen = buf.len;
+	buf.cursor = 0;
+
+	if (buf.len < 1 || pq_getmsgbyte(&buf) != SKETCH_FORMAT_VERSION)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+				 errmsg("invalid percentile sketch")));
+
+	relative_accuracy = pq_getmsgfloat8(&buf);
+
+	if (isnan(relative_accuracy) ||
+		relative_accuracy < SKETCH_MIN_ACCURACY ||
+		relative_accuracy > SKETCH_MAX_ACCURACY)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+				 errmsg("invalid percentile sketch")));
+
+	sketch = sketch_create(mcxt, relative_accuracy);
+	sketch->count = pq_getmsgint64(&buf);
+	sketch->zero_count = pq_getmsgint64(&buf);
+	sketch->min = pq_getmsgfloat8(&buf);
+	sketch->max = pq_getmsgfloat8(&buf);
+	sketch_store_recv(&buf, &sketch->positive, mcxt);
+	sketch_store_recv(&buf, &sketch->negative, mcxt);
+	pq_getmsgend(&buf);
+
+	if (sketch->zero_count < 0 ||
+		sketch_store_total(&sketch->positive) + sketch_store_total(&sketch->negative) +
+		sketch->zero_count != sketch->count)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+				 errmsg("invalid percentile sketch")));
+
+	return sketch;
+}
+
+static inline double
+sketch_clamp(PercentileSketch *sketch, double val)
+{
+	/* The exact bounds are known, so never report values outside of them */
+	if (val < sketch->min)
+		return sketch->min;
+	if (val > sketch->max)
+		return sketch->max;
+	return val;
+}
+
+/*
+ * Get the value at a percentile. Buckets are visited in the order of their
+ * values, i.e., negative values by descending magnitude first.
+ */
+static double
+sketch_percentile(PercentileSketch *sketch, double percentile)
+{
+	double		rank = percentile * (sketch->count - 1);
+	int64		seen = 0;
+	int32		i;
+
+	for (i = sketch->negative.nbuckets - 1; i >= 0; i--)
+	{
+		seen += sketch->negative.counts[i];
+
+		if (seen > rank)
+			return sketch_clamp(sketch, -sketch_bucket_value(sketch, sketch->negative.offset + i));
+	}
+
+	seen += sketch->zero_count;
+
+	if (seen > rank)
+		return sketch_clamp(sketch, 0);
+
+	for (i = 0; i < sketch->positive.nbuckets; i++)
+	{
+		seen += sketch->positive.counts[i];
+
+		if (seen > rank)
+			return sketch_clamp(sketch, sketch_bucket_value(sketch, sketch->positive.offset + i));
+	}
+
+	/* Not reached, since the buckets add up to the count */
+	return sketch->max;
+}
+
+/* percentile_sketch_sfunc(state, val [, relative_accuracy]) */
+Datum
+percentile_sketch_sfunc(PG_FUNCTION_ARGS)
+{
+	MemoryContext aggcontext;
+	PercentileSketch *state = PG_ARGISNULL(0) ? NULL : (PercentileSketch *) PG_GETARG_POINTER(0);
+
+	if (!AggCheckCallContext(fcinfo, &aggcontext))
+	{
+		/* cannot be called directly because of internal-type argument */
+		elog(ERROR, "percentile_sketch_sfunc called in non-aggregate context");
+	}
+
+	if (PG_ARGISNULL(1) || (PG_NARGS() > 2 && PG_ARGISNULL(2)))
+	{
+		if (state == NULL)
+			PG_RETURN_NULL();
+		PG_RETURN_POINTER(state);
+	}
+
+	if (state == NULL)
+	{
+		double		relative_accuracy = SKETCH_DEFAULT_ACCURACY;
+
+		if (PG_NARGS() > 2)
+		{
+			relative_accuracy = PG_GETARG_FLOAT8(2);
+			check_relative_accuracy(relative_accuracy);
+		}
+
+		state = sketch_create(aggcontext, relative_accuracy);
+	}
+	else if (PG_NARGS() > 2 && PG_GETARG_FLOAT8(2) != state->relative_accuracy)
+		elog(ERROR, "relative accuracy of a percentile sketch cannot change between rows");
+
+	sketch_add_value(state, PG_GETARG_FLOAT8(1), aggcontext);
+
+	PG_RETURN_POINTER(state);
+}
+
+/* percentile_sketch_merge_sfunc(state, sketch bytea) */
+Datum
+percentile_sketch_merge_sfunc(PG_FUNCTION_ARGS)
+{
+	MemoryContext aggcontext;
+	PercentileSketch *state = PG_ARGISNULL(0) ? NULL : (PercentileSketch *) PG_GETARG_POINTER(0);
+	PercentileSketch *sketch;
+
+	if (!AggCheckCallContext(fcinfo, &aggcontext))
+	{
+		/* cannot be called directly because of internal-type argument */
+		elog(ERROR, "percentile_sketch_merge_sfunc called in non-aggregate context");
+	}
+
+	if (PG_ARGISNULL(1))
+	{
+		if (state == NULL)
+			PG_RETURN_NULL();
+		PG_RETURN_POINTER(state);
+	}
+
+	/* The first sketch is deserialized directly into the aggregate context */
+	if (state == NULL)
+		PG_RETURN_POINTER(sketch_deserialize(PG_GETARG_BYTEA_PP(1), aggcontext));
+
+	sketch = sketch_deserialize(PG_GETARG_BYTEA_PP(1), CurrentMemoryContext);
+	sketch_merge(state, sketch, aggcontext);
+
+	PG_RETURN_POINTER(state);
+}
+
+/* percentile_sketch_combinefunc(internal, internal) => internal */
+Datum
+percentile_sketch_combinefunc(PG_FUNCTION_ARGS)
+{
+	MemoryContext aggcontext;
+	PercentileSketch *state1 = PG_ARGISNULL(0) ? NULL : (PercentileSketch *) PG_GETARG_POINTER(0);
+	PercentileSketch *state2 = PG_ARGISNULL(1) ? NULL : (PercentileSketch *) PG_GETARG_POINTER(1);
+
+	if (!AggCheckCallContext(fcinfo, &aggcontext))
+	{
+		/* cannot be called directly because of internal-type argument */
+		elog(ERROR, "percentile_sketch_combinefunc called in non-aggregate context");
+	}
+
+	if (state2 == NULL)
+	{
+		if (state1 == NULL)
+			PG_RETURN_NULL();
+		PG_RETURN_POINTER(state1);
+	}
+
+	/* state2 might not live in the aggregate context, so copy it */
+	if (state1 == NULL)
+		PG_RETURN_POINTER(sketch_copy(aggcontext, state2));
+
+	sketch_merge(state1, state2, aggcontext);
+
+	PG_RETURN_POINTER(state1);
+}
+
+/* percentile_sketch_serializefunc(internal) => bytea */
+Datum
+percentile_sketch_serializefunc(PG_FUNCTION_ARGS)
+{
+	Assert(!PG_ARGISNULL(0));
+
+	PG_RETURN_BYTEA_P(sketch_serialize((PercentileSketch *) PG_GETARG_POINTER(0)));
+}
+
+/* percentile_sketch_deserializefunc(bytea, internal) => internal */
+Datum
+percentile_sketch_deserializefunc(PG_FUNCTION_ARGS)
+{
+	Assert(!PG_ARGISNULL(0));
+
+	PG_RETURN_POINTER(sketch_deserialize(PG_GETARG_BYTEA_PP(0), CurrentMemoryContext));
+}
+
+/* percentile_sketch_finalfunc(internal, ...) => bytea */
+Datum
+percentile_sketch_finalfunc(PG_FUNCTION_ARGS)
+{
+	if (!AggCheckCallContext(fcinfo, NULL))
+	{
+		/* cannot be called directly because of internal-type argument */
+		elog(ERROR, "percentile_sketch_finalfunc called in non-aggregate context");
+	}
+
+	if (PG_ARGISNULL(0))
+		PG_RETURN_NULL();
+
+	PG_RETURN_BYTEA_P(sketch_serialize((PercentileSketch *) PG_GETARG_POINTER(0)));
+}
+
+/* approx_percentile(percentile DOUBLE PRECISION, sketch BYTEA) => DOUBLE PRECISION */
+Datum
+approx_percentile(PG_FUNCTION_ARGS)
+{
+	double		percentile = PG_GETARG_FLOAT8(0);
+	PercentileSketch *sketch;
+
+	if (isnan(percentile) || percentile < 0 || percentile > 1)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("percentile must be between 0 and 1")));
+
+	sketch = sketch_deserialize(PG_GETARG_BYTEA_PP(1), CurrentMemoryContext);
+
+	if (sketch->count == 0)
+		PG_RETURN_NULL();
+
+	PG_RETURN_FLOAT8(sketch_percentile(sketch, percentile));
+}
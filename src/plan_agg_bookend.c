@@ -0,0 +1,375 @@
+#include <postgres.h>
+#include <access/heapam.h>
+#include <access/htup_details.h>
+#include <catalog/namespace.h>
+#include <catalog/pg_aggregate.h>
+#include <catalog/pg_am.h>
+#include <catalog/pg_class.h>
+#include <catalog/pg_index.h>
+#include <catalog/pg_type.h>
+#include <nodes/makefuncs.h>
+#include <nodes/nodeFuncs.h>
+#include <optimizer/clauses.h>
+#include <parser/parsetree.h>
+#include <utils/lsyscache.h>
+#include <utils/rel.h>
+#include <utils/relcache.h>
+#include <utils/syscache.h>
+#include <utils/typcache.h>
+
+#include "plan_agg_bookend.h"
+#include "hypertable.h"
+#include "hypertable_cache.h"
+#include "dimension.h"
+#include "catalog.h"
+
+/*
+ * Planner optimization for the bookend aggregates first() and last().
+ *
+ * Similar to how PostgreSQL answers min() and max() with index scans, an
+ * ungrouped query like
+ *
+ *	 SELECT last(temp, time) FROM metrics WHERE device = 42;
+ *
+ * is rewritten to
+ *
+ *	 SELECT (SELECT temp FROM metrics WHERE device = 42
+ *			 ORDER BY time DESC LIMIT 1);
+ *
+ * The subquery is planned as an initplan with an ordered scan over the
+ * hypertable's chunks that stops after the first row, instead of feeding
+ * every row of every chunk through the aggregate's transition function.
+ *
+ * The rewrite is only done when the comparison element is the hypertable's
+ * time column, which is never NULL (a NULL comparison element would make the
+ * aggregate NULL), and when there is a btree index on that column so that the
+ * ordered scan is cheap.
+ */
+
+typedef struct BookendAgg
+{
+	Aggref	   *aggref;
+	bool		is_first;
+	SubLink    *sublink;
+} BookendAgg;
+
+typedef struct BookendCtx
+{
+	Index		rtindex;
+	AttrNumber	time_attno;
+	List	   *aggs;
+	bool		can_optimize;
+} BookendCtx;
+
+/*
+ * Check if an aggregate is first() or last() by looking at its transition
+ * function.
+ */
+static bool
+is_bookend_agg(Oid aggfnoid, bool *is_first)
+{
+	HeapTuple	tuple;
+	Oid			transfn;
+	char	   *name;
+
+	tuple = SearchSysCache1(AGGFNOID, ObjectIdGetDatum(aggfnoid));
+
+	if (!HeapTupleIsValid(tuple))
+		return false;
+
+	transfn = ((Form_pg_aggregate) GETSTRUCT(tuple))->aggtransfn;
+	ReleaseSysCache(tuple);
+
+	if (get_func_namespace(transfn) != get_namespace_oid(INTERNAL_SCHEMA_NAME, true))
+		return false;
+
+	name = get_func_name(transfn);
+
+	if (strcmp(name, "first_sfunc") == 0)
+		*is_first = true;
+	else if (strcmp(name, "last_sfunc") == 0)
+		*is_first = false;
+	else
+		return false;
+
+	return true;
+}
+
+static bool
+has_btree_index_on_column(Oid relid, AttrNumber attno)
+{
+	Relation	rel = heap_open(relid, AccessShareLock);
+	List	   *indexes = RelationGetIndexList(rel);
+	ListCell   *lc;
+	bool		found = false;
+
+	heap_close(rel, NoLock);
+
+	foreach(lc, indexes)
+	{
+		Oid			indexoid = lfirst_oid(lc);
+		HeapTuple	tuple;
+		Form_pg_index index;
+		int			i;
+
+		tuple = SearchSysCache1(RELOID, ObjectIdGetDatum(indexoid));
+
+		if (!HeapTupleIsValid(tuple))
+			continue;
+
+		if (((Form_pg_class) GETSTRUCT(tuple))->relam != BTREE_AM_OID)
+		{
+			ReleaseSysCache(tuple);
+			continue;
+		}
+
+		ReleaseSysCache(tuple);
+
+		tuple = SearchSysCache1(INDEXRELID, ObjectIdGetDatum(indexoid));
+
+		if (!HeapTupleIsValid(tuple))
+			continue;
+
+		index = (Form_pg_index) GETSTRUCT(tuple);
+
+		if (IndexIsValid(index) && heap_attisnull(tuple, Anum_pg_index_indpred))
+			for (i = 0; i < index->indnatts; i++)
+				if (index->indkey.values[i] == attno)
+					found = true;
+
+		ReleaseSysCache(tuple);
+
+		if (found)
+			break;
+	}
+
+	list_free(indexes);
+
+	return found;
+}
+
+/*
+ * Build the subquery that replaces a bookend aggregate:
+ *
+ * SELECT value FROM <query's FROM and WHERE> ORDER BY time ASC|DESC LIMIT 1
+ */
+static Query *
+make_bookend_subquery(Query *parse, Aggref *aggref, bool is_first)
+{
+	TargetEntry *value = linitial(aggref->args);
+	TargetEntry *cmp = lsecond(aggref->args);
+	Query	   *subquery = copyObject(parse);
+	TypeCacheEntry *tce;
+	TargetEntry *sort_tle;
+	SortGroupClause *sortcl;
+
+	tce = lookup_type_cache(exprType((Node *) cmp->expr),
+							TYPECACHE_EQ_OPR | TYPECACHE_LT_OPR | TYPECACHE_GT_OPR);
+
+	if (!OidIsValid(tce->eq_opr) || !OidIsValid(is_first ? tce->lt_opr : tce->gt_opr))
+		return NULL;
+
+	sort_tle = makeTargetEntry(copyObject(cmp->expr), 2, NULL, true);
+	sort_tle->ressortgroupref = 1;
+
+	sortcl = makeNode(SortGroupClause);
+	sortcl->tleSortGroupRef = 1;
+	sortcl->eqop = tce->eq_opr;
+	sortcl->sortop = is_first ? tce->lt_opr : tce->gt_opr;
+	sortcl->nulls_first = !is_first;
+	sortcl->hashable = false;
+
+	subquery->targetList = list_make2(makeTargetEntry(copyObject(value->expr), 1,
+													  pstrdup("value"), false),
+									  sort_tle);
+	subquery->hasAggs = false;
+	subquery->distinctClause = NIL;
+	subquery->hasDistinctOn = false;
+	subquery->sortClause = list_make1(sortcl);
+	subquery->limitOffset = NULL;
+	subquery->limitCount = (Node *) makeConst(INT8OID, -1, InvalidOid, sizeof(int64),
+											  Int64GetDatum(1), false, FLOAT8PASSBYVAL);
+
+	return subquery;
+}
+
+static bool
+bookend_aggref_is_optimizable(Aggref *aggref, BookendCtx *ctx)
+{
+	TargetEntry *cmp;
+	Var		   *var;
+
+	if (aggref->agglevelsup != 0 ||
+		aggref->aggkind != AGGKIND_NORMAL ||
+		aggref->aggfilter != NULL ||
+		aggref->aggorder != NIL ||
+		aggref->aggdistinct != NIL ||
+		list_length(aggref->args) != 2 ||
+		contain_volatile_functions((Node *) aggref->args) ||
+		contain_subplans((Node *) aggref->args))
+		return false;
+
+	cmp = lsecond(aggref->args);
+
+	if (!IsA(cmp->expr, Var))
+		return false;
+
+	var = (Var *) cmp->expr;
+
+	return var->varno == ctx->rtindex &&
+		var->varlevelsup == 0 &&
+		var->varattno == ctx->time_attno;
+}
+
+/*
+ * Collect the bookend aggregates of the target list and check that the target
+ * list has nothing else that needs the aggregation.
+ */
+static bool
+bookend_targetlist_walker(Node *node, BookendCtx *ctx)
+{
+	if (node == NULL)
+		return false;
+
+	if (IsA(node, Aggref))
+	{
+		Aggref	   *aggref = (Aggref *) node;
+		BookendAgg *agg;
+		bool		is_first;
+
+		if (!is_bookend_agg(aggref->aggfnoid, &is_first) ||
+			!bookend_aggref_is_optimizable(aggref, ctx))
+		{
+			ctx->can_optimize = false;
+			return true;
+		}
+
+		agg = palloc(sizeof(BookendAgg));
+		agg->aggref = aggref;
+		agg->is_first = is_first;
+		agg->sublink = makeNode(SubLink);
+		agg->sublink->subLinkType = EXPR_SUBLINK;
+		agg->sublink->subLinkId = 0;
+		agg->sublink->testexpr = NULL;
+		agg->sublink->operName = NIL;
+		agg->sublink->location = aggref->location;
+		ctx->aggs = lappend(ctx->aggs, agg);
+
+		return false;
+	}
+
+	if (IsA(node, Var) || IsA(node, Query) || IsA(node, SubLink))
+	{
+		ctx->can_optimize = false;
+		return true;
+	}
+
+	return expression_tree_walker(node, bookend_targetlist_walker, ctx);
+}
+
+static Node *
+replace_bookend_aggs_mutator(Node *node, List *aggs)
+{
+	if (node == NULL)
+		return NULL;
+
+	if (IsA(node, Aggref))
+	{
+		ListCell   *lc;
+
+		foreach(lc, aggs)
+		{
+			BookendAgg *agg = lfirst(lc);
+
+			if (agg->aggref == (Aggref *) node)
+				return (Node *) agg->sublink;
+		}
+
+		elog(ERROR, "unexpected aggregate in bookend optimization");
+	}
+
+	return expression_tree_mutator(node, replace_bookend_aggs_mutator, aggs);
+}
+
+/*
+ * Rewrite ungrouped first() and last() aggregates over a hypertable into
+ * ordered, single-row subqueries. Returns true if the query was rewritten.
+ */
+bool
+plan_agg_bookend_optimization(Query *parse, Cache *hcache)
+{
+	BookendCtx	ctx = {
+		.can_optimize = true,
+	};
+	RangeTblRef *rtr;
+	RangeTblEntry *rte;
+	Hypertable *ht;
+	Dimension  *dim;
+	ListCell   *lc;
+
+	if (parse->commandType != CMD_SELECT ||
+		!parse->hasAggs ||
+		parse->groupClause != NIL ||
+		parse->groupingSets != NIL ||
+		parse->havingQual != NULL ||
+		parse->hasWindowFuncs ||
+		parse->cteList != NIL ||
+		parse->setOperations != NULL ||
+		parse->rowMarks != NIL ||
+		list_length(parse->jointree->fromlist) != 1 ||
+		expression_returns_set((Node *) parse->targetList))
+		return false;
+
+	rtr = linitial(parse->jointree->fromlist);
+
+	if (!IsA(rtr, RangeTblRef))
+		return false;
+
+	rte = rt_fetch(rtr->rtindex, parse->rtable);
+
+	if (rte->rtekind != RTE_RELATION || !rte->inh || rte->tablesample != NULL)
+		return false;
+
+	ht = hypertable_cache_get_entry(hcache, rte->relid);
+
+	if (NULL == ht)
+		return false;
+
+	dim = hyperspace_get_dimension(ht->space, DIMENSION_TYPE_OPEN, 0);
+
+	if (NULL == dim)
+		return false;
+
+	ctx.rtindex = rtr->rtindex;
+	ctx.time_attno = dim->column_attno;
+
+	bookend_targetlist_walker((Node *) parse->targetList, &ctx);
+
+	if (!ctx.can_optimize || ctx.aggs == NIL ||
+		!has_btree_index_on_column(rte->relid, ctx.time_attno))
+		return false;
+
+	foreach(lc, ctx.aggs)
+	{
+		BookendAgg *agg = lfirst(lc);
+		Query	   *subquery = make_bookend_subquery(parse, agg->aggref, agg->is_first);
+
+		if (NULL == subquery)
+			return false;
+
+		agg->sublink->subselect = (Node *) subquery;
+	}
+
+	/*
+	 * The outer query no longer scans any relations. Permissions on the
+	 * relations are still checked since the subqueries' range tables end up
+	 * in the final plan.
+	 */
+	parse->targetList = (List *) replace_bookend_aggs_mutator((Node *) parse->targetList, ctx.aggs);
+	parse->rtable = NIL;
+	parse->jointree = makeFromExpr(NIL, NULL);
+	parse->hasAggs = false;
+	parse->hasSubLinks = true;
+
+	return true;
+}
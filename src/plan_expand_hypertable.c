@@ -0,0 +1,1018 @@
+#include <postgres.h>
+#include <access/heapam.h>
+#include <access/stratnum.h>
+#include <catalog/pg_class.h>
+#include <catalog/pg_inherits_fn.h>
+#include <catalog/pg_operator.h>
+#include <catalog/pg_type.h>
+#include <nodes/makefuncs.h>
+#include <nodes/nodeFuncs.h>
+#include <optimizer/clauses.h>
+#include <optimizer/var.h>
+#include <parser/parsetree.h>
+#include <storage/lmgr.h>
+#include <utils/array.h>
+#include <utils/lsyscache.h>
+#include <utils/rel.h>
+#include <utils/syscache.h>
+#include <utils/timestamp.h>
+#include <utils/typcache.h>
+
+#include "plan_expand_hypertable.h"
+#include "hypertable.h"
+#include "hypertable_cache.h"
+#include "hypercube.h"
+#include "dimension.h"
+#include "dimension_slice.h"
+#include "partitioning.h"
+#include "utils.h"
+#include "compat.h"
+
+/*
+ * Hypertables are expanded into their chunks by us rather than by
+ * PostgreSQL's inheritance expansion, which runs before any hook is called,
+ * locks and opens every chunk, and leaves it to constraint exclusion to prove
+ * each chunk irrelevant by reading its CHECK constraints again. Instead, we
+ * clear the inheritance flag of hypertable range table entries in the
+ * planner hook and mark them for expansion. The expansion then happens when
+ * the planner asks for the relation info of the hypertable, at which point
+ * the restrictions of the query are known and chunks can be excluded based on
+ * the (cached) dimension slices of the hypertable's chunks.
+ *
+ * The range table entry field used as a mark is otherwise unused for plain
+ * relations.
+ */
+#define EXPAND_HYPERTABLE_MARK "ts_expand_hypertable"
+
+/*
+ * Restrictions on a dimension that a chunk's slice has to satisfy in order to
+ * not be excluded.
+ */
+typedef struct DimensionRestrictInfo
+{
+	Dimension  *dimension;
+	/* Open dimensions: a slice must have range_end > lower */
+	int64		lower;
+	/* Open dimensions: a slice must have range_start < upper */
+	int64		upper;
+	/* Closed dimensions: a slice must contain a hash value of each list */
+	List	   *hash_lists;
+} DimensionRestrictInfo;
+
+typedef struct HypertableRestrictInfo
+{
+	int			num_restrictions;
+	int			num_dimensions;
+	DimensionRestrictInfo dimension_restriction[FLEXIBLE_ARRAY_MEMBER];
+} HypertableRestrictInfo;
+
+static HypertableRestrictInfo *
+hypertable_restrict_info_create(Hypertable *ht)
+{
+	Hyperspace *hs = ht->space;
+	HypertableRestrictInfo *hri;
+	int			i;
+
+	hri = palloc0(sizeof(HypertableRestrictInfo) +
+				  sizeof(DimensionRestrictInfo) * hs->num_dimensions);
+	hri->num_dimensions = hs->num_dimensions;
+
+	for (i = 0; i < hs->num_dimensions; i++)
+	{
+		DimensionRestrictInfo *dri = &hri->dimension_restriction[i];
+
+		dri->dimension = &hs->dimensions[i];
+		dri->lower = PG_INT64_MIN;
+		dri->upper = PG_INT64_MAX;
+		dri->hash_lists = NIL;
+	}
+
+	return hri;
+}
+
+static DimensionRestrictInfo *
+hypertable_restrict_info_get(HypertableRestrictInfo *hri, Index rti, Var *var, DimensionType type)
+{
+	int			i;
+
+	if (var->varno != rti || var->varlevelsup != 0)
+		return NULL;
+
+	for (i = 0; i < hri->num_dimensions; i++)
+	{
+		DimensionRestrictInfo *dri = &hri->dimension_restriction[i];
+
+		if (dri->dimension->type == type &&
+			dri->dimension->column_attno == var->varattno)
+			return dri;
+	}
+
+	return NULL;
+}
+
+/*
+ * Add a restriction of the form "time_column op const" on an open dimension.
+ *
+ * A chunk whose slice is [start, end) can only contain matching tuples if:
+ *
+ *	time > v, time >= v:	end > v
+ *	time < v:				start < v
+ *	time <= v:				start <= v, i.e., start < v + 1
+ *	time = v:				start <= v and end > v
+ *
+ * These are exactly the conditions under which the chunk's CHECK constraints
+ * do not refute the restriction, so we never exclude a chunk that constraint
+ * exclusion would keep.
+ */
+static void
+dimension_restrict_info_add_open(DimensionRestrictInfo *dri, int strategy, int64 value)
+{
+	switch (strategy)
+	{
+		case BTLessStrategyNumber:
+			dri->upper = Min(dri->upper, value);
+			break;
+		case BTLessEqualStrategyNumber:
+			if (value < PG_INT64_MAX)
+				dri->upper = Min(dri->upper, value + 1);
+			break;
+		case BTEqualStrategyNumber:
+			dri->lower = Max(dri->lower, value);
+			if (value < PG_INT64_MAX)
+				dri->upper = Min(dri->upper, value + 1);
+			break;
+		case BTGreaterEqualStrategyNumber:
+		case BTGreaterStrategyNumber:
+			dri->lower = Max(dri->lower, value);
+			break;
+		default:
+			break;
+	}
+}
+
+/*
+ * Get the restriction info for an expression of the form
+ * partitioning_func(column), where the column is a closed dimension.
+ */
+static DimensionRestrictInfo *
+hypertable_restrict_info_get_partfunc(HypertableRestrictInfo *hri, Index rti, Node *node)
+{
+	FuncExpr   *fexpr;
+	DimensionRestrictInfo *dri;
+
+	if (!IsA(node, FuncExpr))
+		return NULL;
+
+	fexpr = (FuncExpr *) node;
+
+	if (list_length(fexpr->args) != 1 || !IsA(linitial(fexpr->args), Var))
+		return NULL;
+
+	dri = hypertable_restrict_info_get(hri, rti, linitial(fexpr->args), DIMENSION_TYPE_CLOSED);
+
+	if (NULL == dri ||
+		NULL == dri->dimension->partitioning ||
+		dri->dimension->partitioning->partfunc.func_fmgr.fn_oid != fexpr->funcid)
+		return NULL;
+
+	return dri;
+}
+
+static void
+hypertable_restrict_info_add_opexpr(HypertableRestrictInfo *hri, Index rti, OpExpr *op)
+{
+	Node	   *left,
+			   *right;
+	Var		   *var;
+	Const	   *c;
+	DimensionRestrictInfo *dri;
+	TypeCacheEntry *tce;
+	Oid			lefttype,
+				righttype;
+	int64		value;
+	int			strategy;
+	bool		commuted = false;
+
+	if (list_length(op->args) != 2)
+		return;
+
+	left = linitial(op->args);
+	right = lsecond(op->args);
+
+	if (IsA(right, Const) && !((Const *) right)->constisnull)
+	{
+		c = (Const *) right;
+
+		/*
+		 * The partitioning function quals added when parsing queries with
+		 * equality on a space partitioning column
+		 */
+		dri = hypertable_restrict_info_get_partfunc(hri, rti, left);
+
+		if (NULL != dri)
+		{
+			if (op->opno == Int4EqualOperator && c->consttype == INT4OID)
+			{
+				dri->hash_lists = lappend(dri->hash_lists,
+										  list_make1_int(DatumGetInt32(c->constvalue)));
+				hri->num_restrictions++;
+			}
+			return;
+		}
+	}
+
+	if (IsA(left, Var) && IsA(right, Const))
+	{
+		var = (Var *) left;
+		c = (Const *) right;
+	}
+	else if (IsA(right, Var) && IsA(left, Const))
+	{
+		var = (Var *) right;
+		c = (Const *) left;
+		commuted = true;
+	}
+	else
+		return;
+
+	dri = hypertable_restrict_info_get(hri, rti, var, DIMENSION_TYPE_OPEN);
+
+	if (NULL == dri || NULL != dri->dimension->partitioning ||
+		c->constisnull || c->consttype != var->vartype)
+		return;
+
+	op_input_types(op->opno, &lefttype, &righttype);
+
+	if (lefttype != var->vartype || righttype != var->vartype)
+		return;
+
+	tce = lookup_type_cache(var->vartype, TYPECACHE_BTREE_OPFAMILY);
+
+	if (!OidIsValid(tce->btree_opf))
+		return;
+
+	strategy = get_op_opfamily_strategy(op->opno, tce->btree_opf);
+
+	if (commuted)
+	{
+		switch (strategy)
+		{
+			case BTLessStrategyNumber:
+				strategy = BTGreaterStrategyNumber;
+				break;
+			case BTLessEqualStrategyNumber:
+				strategy = BTGreaterEqualStrategyNumber;
+				break;
+			case BTGreaterEqualStrategyNumber:
+				strategy = BTLessEqualStrategyNumber;
+				break;
+			case BTGreaterStrategyNumber:
+				strategy = BTLessStrategyNumber;
+				break;
+			default:
+				break;
+		}
+	}
+
+	if (strategy == 0 || !time_value_is_convertible(c->constvalue, c->consttype))
+		return;
+
+	value = time_value_to_internal(c->constvalue, c->consttype);
+	dimension_restrict_info_add_open(dri, strategy, value);
+	hri->num_restrictions++;
+}
+
+/*
+ * Add a restriction of the form partitioning_func(column) = ANY(hashes),
+ * which is what queries with IN lists on space partitioning columns get.
+ */
+static void
+hypertable_restrict_info_add_saop(HypertableRestrictInfo *hri, Index rti, ScalarArrayOpExpr *saop)
+{
+	DimensionRestrictInfo *dri;
+	Const	   *c;
+	Datum	   *elems;
+	bool	   *nulls;
+	int			num_elems;
+	List	   *hashes = NIL;
+	int			i;
+
+	if (!saop->useOr || saop->opno != Int4EqualOperator ||
+		list_length(saop->args) != 2 || !IsA(lsecond(saop->args), Const))
+		return;
+
+	c = lsecond(saop->args);
+
+	if (c->constisnull || c->consttype != INT4ARRAYOID)
+		return;
+
+	dri = hypertable_restrict_info_get_partfunc(hri, rti, linitial(saop->args));
+
+	if (NULL == dri)
+		return;
+
+	deconstruct_array(DatumGetArrayTypeP(c->constvalue),
+					  INT4OID, sizeof(int32), true, 'i',
+					  &elems, &nulls, &num_elems);
+
+	for (i = 0; i < num_elems; i++)
+		if (!nulls[i])
+			hashes = lappend_int(hashes, DatumGetInt32(elems[i]));
+
+	if (hashes == NIL)
+		return;
+
+	dri->hash_lists = lappend(dri->hash_lists, hashes);
+	hri->num_restrictions++;
+}
+
+/*
+ * Check if an expression is time_bucket() of the time column of a hypertable,
+ * with a constant width, and return the width in the internal unit of time.
+ */
+static bool
+time_bucket_expr_get_width(Node *node, Index rti, Dimension *dim, int64 *width)
+{
+	FuncExpr   *fexpr;
+	Const	   *c;
+	Var		   *var;
+	Interval   *interval;
+
+	if (!IsA(node, FuncExpr))
+		return false;
+
+	fexpr = (FuncExpr *) node;
+
+	if (list_length(fexpr->args) != 2 ||
+		!IsA(linitial(fexpr->args), Const) ||
+		!IsA(lsecond(fexpr->args), Var))
+		return false;
+
+	c = linitial(fexpr->args);
+	var = lsecond(fexpr->args);
+
+	if (c->constisnull || c->consttype != INTERVALOID ||
+		var->varno != rti || var->varlevelsup != 0 ||
+		var->varattno != dim->column_attno)
+		return false;
+
+	if (!function_has_symbol(fexpr->funcid, "timestamp_bucket") &&
+		!function_has_symbol(fexpr->funcid, "timestamptz_bucket") &&
+		!function_has_symbol(fexpr->funcid, "date_bucket"))
+		return false;
+
+	interval = DatumGetIntervalP(c->constvalue);
+
+	if (interval->month != 0)
+		return false;
+
+	*width = get_interval_period(interval);
+
+	return *width > 0;
+}
+
+static Expr *
+make_time_qual(Var *var, Oid opfamily, int strategy, Expr *value)
+{
+	Oid			opno = get_opfamily_member(opfamily, var->vartype, var->vartype, strategy);
+	Expr	   *qual;
+
+	if (!OidIsValid(opno))
+		return NULL;
+
+	qual = make_opclause(opno, BOOLOID, false, (Expr *) copyObject(var), value,
+						 InvalidOid, InvalidOid);
+	set_opfuncid((OpExpr *) qual);
+
+	return qual;
+}
+
+/*
+ * Derive restrictions on the time column from a restriction on time_bucket()
+ * of the time column. Since buckets start at or before the times they hold,
+ *
+ *   time_bucket(w, time) >= x  implies  time >= x,
+ *   time_bucket(w, time) > x   implies  time > x,
+ *   time_bucket(w, time) <= x  implies  time < time_bucket(w, x) + w, and
+ *   time_bucket(w, time) < x   implies  time < x if x starts a bucket, and
+ *                              time < time_bucket(w, x) + w otherwise,
+ *
+ * while an equality implies both bounds. Upper bounds need the bucket of the
+ * value, so they are only derived for constants.
+ */
+static List *
+time_bucket_qual_derive(Index rti, Dimension *dim, OpExpr *op)
+{
+	Node	   *left,
+			   *right,
+			   *value;
+	FuncExpr   *bucket;
+	Var		   *var;
+	TypeCacheEntry *tce;
+	Oid			lefttype,
+				righttype;
+	int64		width;
+	int			strategy;
+	bool		commuted = false;
+	List	   *quals = NIL;
+	Expr	   *qual;
+
+	if (list_length(op->args) != 2)
+		return NIL;
+
+	left = linitial(op->args);
+	right = lsecond(op->args);
+
+	if (time_bucket_expr_get_width(left, rti, dim, &width))
+	{
+		bucket = (FuncExpr *) left;
+		value = right;
+	}
+	else if (time_bucket_expr_get_width(right, rti, dim, &width))
+	{
+		bucket = (FuncExpr *) right;
+		value = left;
+		commuted = true;
+	}
+	else
+		return NIL;
+
+	var = lsecond(bucket->args);
+
+	if (exprType(value) != var->vartype ||
+		contain_var_clause(value) ||
+		contain_volatile_functions(value) ||
+		contain_subplans(value))
+		return NIL;
+
+	op_input_types(op->opno, &lefttype, &righttype);
+
+	if (lefttype != var->vartype || righttype != var->vartype)
+		return NIL;
+
+	tce = lookup_type_cache(var->vartype, TYPECACHE_BTREE_OPFAMILY);
+
+	if (!OidIsValid(tce->btree_opf))
+		return NIL;
+
+	strategy = get_op_opfamily_strategy(op->opno, tce->btree_opf);
+
+	if (commuted)
+	{
+		switch (strategy)
+		{
+			case BTLessStrategyNumber:
+				strategy = BTGreaterStrategyNumber;
+				break;
+			case BTLessEqualStrategyNumber:
+				strategy = BTGreaterEqualStrategyNumber;
+				break;
+			case BTGreaterEqualStrategyNumber:
+				strategy = BTLessEqualStrategyNumber;
+				break;
+			case BTGreaterStrategyNumber:
+				strategy = BTLessStrategyNumber;
+				break;
+			default:
+				break;
+		}
+	}
+
+	switch (strategy)
+	{
+		case BTEqualStrategyNumber:
+		case BTGreaterEqualStrategyNumber:
+			qual = make_time_qual(var, tce->btree_opf, BTGreaterEqualStrategyNumber,
+								  copyObject(value));
+			break;
+		case BTGreaterStrategyNumber:
+			qual = make_time_qual(var, tce->btree_opf, BTGreaterStrategyNumber,
+								  copyObject(value));
+			break;
+		default:
+			qual = NULL;
+			break;
+	}
+
+	if (NULL != qual)
+		quals = lappend(quals, qual);
+
+	if ((strategy == BTEqualStrategyNumber ||
+		 strategy == BTLessStrategyNumber ||
+		 strategy == BTLessEqualStrategyNumber) &&
+		IsA(value, Const) &&
+		!((Const *) value)->constisnull &&
+		time_value_is_convertible(((Const *) value)->constvalue, var->vartype))
+	{
+		Const	   *c = (Const *) value;
+		Datum		bucketed = OidFunctionCall2(bucket->funcid,
+												((Const *) linitial(bucket->args))->constvalue,
+												c->constvalue);
+		int64		start = time_value_to_internal(bucketed, var->vartype);
+		Const	   *upper;
+
+		if (strategy == BTLessStrategyNumber &&
+			start == time_value_to_internal(c->constvalue, var->vartype))
+			upper = copyObject(c);
+		else if (start <= PG_INT64_MAX - width)
+		{
+			upper = copyObject(c);
+			upper->constvalue = internal_to_time_value(start + width, var->vartype);
+			upper->location = -1;
+		}
+		else
+			upper = NULL;
+
+		if (NULL != upper)
+		{
+			qual = make_time_qual(var, tce->btree_opf, BTLessStrategyNumber, (Expr *) upper);
+
+			if (NULL != qual)
+				quals = lappend(quals, qual);
+		}
+	}
+
+	return quals;
+}
+
+/*
+ * Derive restrictions on the time column of a hypertable from a restriction
+ * on time_bucket() of the time column (see time_bucket_qual_derive()).
+ * Returns NIL if the clause is not such a restriction.
+ */
+List *
+plan_expand_hypertable_time_bucket_quals(Hypertable *ht, Index rti, Expr *clause)
+{
+	Dimension  *dim = hyperspace_get_dimension(ht->space, DIMENSION_TYPE_OPEN, 0);
+
+	if (NULL == dim || NULL != dim->partitioning || !IsA(clause, OpExpr))
+		return NIL;
+
+	return time_bucket_qual_derive(rti, dim, (OpExpr *) clause);
+}
+
+/*
+ * Collect the restrictions on the time column that are implied by
+ * restrictions on time_bucket() of the time column in the quals of the
+ * query's join tree. This way, queries on time buckets, like those on the
+ * buckets of continuous aggregates, exclude chunks here or, for values only
+ * known at execution time, in ConstraintAwareAppend, which derives the
+ * restrictions again from the constified quals.
+ *
+ * The derived restrictions are not added to the query. They cannot filter
+ * out rows that the restrictions they are implied by let through, but the
+ * planner would still count their selectivity on top of those restrictions.
+ */
+static void
+hypertable_restrict_info_add_time_buckets(HypertableRestrictInfo *hri, Hypertable *ht,
+										  Index rti, FromExpr *from)
+{
+	List	   *quals;
+	ListCell   *lc;
+
+	if (NULL == from->quals)
+		return;
+
+	if (IsA(from->quals, List))
+		quals = (List *) from->quals;
+	else
+		quals = make_ands_implicit((Expr *) from->quals);
+
+	foreach(lc, quals)
+	{
+		ListCell   *lc_derived;
+
+		foreach(lc_derived, plan_expand_hypertable_time_bucket_quals(ht, rti, lfirst(lc)))
+			hypertable_restrict_info_add_opexpr(hri, rti, lfirst(lc_derived));
+	}
+}
+
+/*
+ * Collect restrictions on the hypertable from the quals of the query's join
+ * tree. We only look at quals that apply to all joined relations, i.e., we do
+ * not descend into (possibly outer) join expressions.
+ */
+static void
+hypertable_restrict_info_add_fromexpr(HypertableRestrictInfo *hri, Index rti, FromExpr *from)
+{
+	List	   *quals;
+	ListCell   *lc;
+
+	if (NULL == from->quals)
+		quals = NIL;
+	else if (IsA(from->quals, List))
+		quals = (List *) from->quals;
+	else
+		quals = make_ands_implicit((Expr *) from->quals);
+
+	foreach(lc, quals)
+	{
+		Node	   *clause = lfirst(lc);
+
+		if (IsA(clause, OpExpr))
+			hypertable_restrict_info_add_opexpr(hri, rti, (OpExpr *) clause);
+		else if (IsA(clause, ScalarArrayOpExpr))
+			hypertable_restrict_info_add_saop(hri, rti, (ScalarArrayOpExpr *) clause);
+	}
+
+	foreach(lc, from->fromlist)
+	{
+		Node	   *node = lfirst(lc);
+
+		if (IsA(node, FromExpr))
+			hypertable_restrict_info_add_fromexpr(hri, rti, (FromExpr *) node);
+	}
+}
+
+static bool
+hypertable_restrict_info_chunk_matches(HypertableRestrictInfo *hri, Hypercube *cube)
+{
+	int			i;
+
+	for (i = 0; i < hri->num_dimensions; i++)
+	{
+		DimensionRestrictInfo *dri = &hri->dimension_restriction[i];
+		DimensionSlice *slice;
+		ListCell   *lc;
+
+		slice = hypercube_get_slice_by_dimension_id(cube, dri->dimension->fd.id);
+
+		if (NULL == slice)
+			continue;
+
+		if (slice->fd.range_end <= dri->lower ||
+			slice->fd.range_start >= dri->upper)
+			return false;
+
+		foreach(lc, dri->hash_lists)
+		{
+			List	   *hashes = lfirst(lc);
+			ListCell   *lc_hash;
+			bool		found = false;
+
+			foreach(lc_hash, hashes)
+			{
+				int64		hash = lfirst_int(lc_hash);
+
+				if (hash >= slice->fd.range_start && hash < slice->fd.range_end)
+				{
+					found = true;
+					break;
+				}
+			}
+
+			if (!found)
+				return false;
+		}
+	}
+
+	return true;
+}
+
+/*
+ * Build the translation list that maps the hypertable's columns to the
+ * chunk's columns. Chunks normally have the same column layout as the
+ * hypertable, but dropped columns can make the attribute numbers differ.
+ *
+ * This is adapted from make_inh_translation_list() in PostgreSQL's
+ * prepunion.c, which is not exported.
+ */
+static List *
+make_chunk_translation_list(Relation oldrelation, Relation newrelation, Index newvarno)
+{
+	List	   *vars = NIL;
+	TupleDesc	old_tupdesc = RelationGetDescr(oldrelation);
+	TupleDesc	new_tupdesc = RelationGetDescr(newrelation);
+	int			oldnatts = old_tupdesc->natts;
+	int			newnatts = new_tupdesc->natts;
+	int			old_attno;
+
+	for (old_attno = 0; old_attno < oldnatts; old_attno++)
+	{
+		Form_pg_attribute att = old_tupdesc->attrs[old_attno];
+		char	   *attname;
+		Oid			atttypid;
+		int32		atttypmod;
+		Oid			attcollation;
+		int			new_attno;
+
+		if (att->attisdropped)
+		{
+			vars = lappend(vars, NULL);
+			continue;
+		}
+
+		attname = NameStr(att->attname);
+		atttypid = att->atttypid;
+		atttypmod = att->atttypmod;
+		attcollation = att->attcollation;
+
+		if (oldrelation == newrelation)
+		{
+			vars = lappend(vars, makeVar(newvarno,
+										 (AttrNumber) (old_attno + 1),
+										 atttypid,
+										 atttypmod,
+										 attcollation,
+										 0));
+			continue;
+		}
+
+		/* Try the same position first, since that is the common case */
+		if (old_attno < newnatts &&
+			(att = new_tupdesc->attrs[old_attno]) != NULL &&
+			!att->attisdropped && att->attinhcount != 0 &&
+			strcmp(attname, NameStr(att->attname)) == 0)
+			new_attno = old_attno;
+		else
+		{
+			for (new_attno = 0; new_attno < newnatts; new_attno++)
+			{
+				att = new_tupdesc->attrs[new_attno];
+
+				if (!att->attisdropped && att->attinhcount != 0 &&
+					strcmp(attname, NameStr(att->attname)) == 0)
+					break;
+			}
+
+			if (new_attno >= newnatts)
+				elog(ERROR, "could not find inherited attribute \"%s\" of relation \"%s\"",
+					 attname, RelationGetRelationName(newrelation));
+		}
+
+		if (atttypid != att->atttypid || atttypmod != att->atttypmod)
+			elog(ERROR, "attribute \"%s\" of relation \"%s\" does not match parent's type",
+				 attname, RelationGetRelationName(newrelation));
+
+		if (attcollation != att->attcollation)
+			elog(ERROR, "attribute \"%s\" of relation \"%s\" does not match parent's collation",
+				 attname, RelationGetRelationName(newrelation));
+
+		vars = lappend(vars, makeVar(newvarno,
+									 (AttrNumber) (new_attno + 1),
+									 atttypid,
+									 atttypmod,
+									 attcollation,
+									 0));
+	}
+
+	return vars;
+}
+
+/*
+ * Add a child range table entry and append relation info for a chunk (or the
+ * hypertable itself, which is the first member of the append relation).
+ */
+static void
+expand_child(PlannerInfo *root, RangeTblEntry *rte, Index rti,
+			 Relation oldrelation, Relation newrelation)
+{
+	Query	   *parse = root->parse;
+	RangeTblEntry *childrte;
+	AppendRelInfo *appinfo;
+	Index		child_rti;
+
+	childrte = copyObject(rte);
+	childrte->relid = RelationGetRelid(newrelation);
+	childrte->relkind = newrelation->rd_rel->relkind;
+	childrte->inh = false;
+	childrte->requiredPerms = 0;
+	parse->rtable = lappend(parse->rtable, childrte);
+	child_rti = list_length(parse->rtable);
+
+	Assert(child_rti < root->simple_rel_array_size);
+	root->simple_rte_array[child_rti] = childrte;
+
+	appinfo = makeNode(AppendRelInfo);
+	appinfo->parent_relid = rti;
+	appinfo->child_relid = child_rti;
+	appinfo->parent_reltype = oldrelation->rd_rel->reltype;
+	appinfo->child_reltype = newrelation->rd_rel->reltype;
+	appinfo->translated_vars = make_chunk_translation_list(oldrelation, newrelation, child_rti);
+	appinfo->parent_reloid = RelationGetRelid(oldrelation);
+	root->append_rel_list = lappend(root->append_rel_list, appinfo);
+}
+
+typedef struct MarkRtesCtx
+{
+	Cache	   *hcache;
+	bool		can_expand;
+} MarkRtesCtx;
+
+/*
+ * Our expansion does not set up the row marks and result relations that
+ * PostgreSQL creates for inheritance children, so we only take over expansion
+ * when the query tree has no row marks and no UPDATEs or DELETEs (which might
+ * get row marks for the tables they join with).
+ */
+static bool
+check_can_expand_walker(Node *node, MarkRtesCtx *ctx)
+{
+	if (node == NULL)
+		return false;
+
+	if (IsA(node, Query))
+	{
+		Query	   *query = (Query *) node;
+
+		if (query->rowMarks != NIL ||
+			(query->commandType != CMD_SELECT && query->commandType != CMD_INSERT))
+		{
+			ctx->can_expand = false;
+			return true;
+		}
+
+		return query_tree_walker(query, check_can_expand_walker, ctx, 0);
+	}
+
+	return expression_tree_walker(node, check_can_expand_walker, ctx);
+}
+
+static bool
+mark_rtes_walker(Node *node, MarkRtesCtx *ctx)
+{
+	if (node == NULL)
+		return false;
+
+	if (IsA(node, Query))
+	{
+		Query	   *query = (Query *) node;
+		ListCell   *lc;
+
+		foreach(lc, query->rtable)
+		{
+			RangeTblEntry *rte = lfirst(lc);
+
+			if (rte->rtekind == RTE_RELATION &&
+				rte->relkind == RELKIND_RELATION &&
+				rte->inh &&
+				NULL != hypertable_cache_get_entry(ctx->hcache, rte->relid))
+			{
+				rte->inh = false;
+				rte->ctename = EXPAND_HYPERTABLE_MARK;
+			}
+		}
+
+		return query_tree_walker(query, mark_rtes_walker, ctx, 0);
+	}
+
+	return expression_tree_walker(node, mark_rtes_walker, ctx);
+}
+
+/*
+ * Mark the hypertable range table entries of a query (including its
+ * subqueries) for expansion by plan_expand_hypertable_chunks() instead of
+ * PostgreSQL's inheritance expansion.
+ */
+void
+plan_expand_hypertable_mark_rtes(Query *parse, Cache *hcache)
+{
+	MarkRtesCtx ctx = {
+		.hcache = hcache,
+		.can_expand = true,
+	};
+
+	check_can_expand_walker((Node *) parse, &ctx);
+
+	if (ctx.can_expand)
+		mark_rtes_walker((Node *) parse, &ctx);
+}
+
+bool
+plan_expand_hypertable_is_marked(RangeTblEntry *rte)
+{
+	return rte->rtekind == RTE_RELATION &&
+		rte->ctename != NULL &&
+		strcmp(rte->ctename, EXPAND_HYPERTABLE_MARK) == 0;
+}
+
+/*
+ * Expand a marked hypertable into its chunks.
+ *
+ * This is called from the get_relation_info hook, i.e., when the relation
+ * info of the hypertable is built, and does what PostgreSQL's inheritance
+ * expansion would have done, except that chunks that cannot match the
+ * query's restrictions on dimension columns are never added to the append
+ * relation. The hypertable itself is always kept as the first child, like in
+ * regular inheritance expansion.
+ *
+ * The list of chunks and their hypercubes are cached with the hypertable
+ * (see hypertable_get_chunk_relids() and hypertable_get_chunk_cube()), so
+ * chunks are excluded without reading the catalogs and only the matching
+ * chunks have to be locked and opened. The remaining chunks are still subject
+ * to regular constraint exclusion, which reads their CHECK constraints from
+ * the relcache as it does for any inheritance child.
+ */
+void
+plan_expand_hypertable_chunks(Hypertable *ht,
+							  PlannerInfo *root,
+							  Oid relation_objectid,
+							  RelOptInfo *rel,
+							  bool exclude_chunks)
+{
+	RangeTblEntry *rte = rt_fetch(rel->relid, root->parse->rtable);
+	HypertableRestrictInfo *hri = NULL;
+	List	   *inh_oids;
+	List	   *chunk_oids = NIL;
+	List	   *fkeys = NIL;
+	Relation	oldrelation;
+	ListCell   *lc;
+	int			old_size,
+				new_size;
+
+	Assert(plan_expand_hypertable_is_marked(rte));
+	rte->ctename = NULL;
+
+	if (NULL != ht)
+		inh_oids = hypertable_get_chunk_relids(ht);
+	else
+		inh_oids = find_inheritance_children(relation_objectid, NoLock);
+
+	/* Like PostgreSQL, treat a hypertable without chunks as a plain table */
+	if (inh_oids == NIL)
+		return;
+
+	if (exclude_chunks && NULL != ht)
+	{
+		hri = hypertable_restrict_info_create(ht);
+		hypertable_restrict_info_add_fromexpr(hri, rel->relid, root->parse->jointree);
+		hypertable_restrict_info_add_time_buckets(hri, ht, rel->relid, root->parse->jointree);
+
+		if (hri->num_restrictions == 0)
+			hri = NULL;
+	}
+
+	foreach(lc, inh_oids)
+	{
+		Oid			chunk_oid = lfirst_oid(lc);
+
+		if (NULL != hri)
+		{
+			Hypercube  *cube = hypertable_get_chunk_cube(ht, chunk_oid);
+
+			if (NULL != cube && !hypertable_restrict_info_chunk_matches(hri, cube))
+				continue;
+		}
+
+		LockRelationOid(chunk_oid, AccessShareLock);
+
+		/* The chunk might have been dropped while we waited for the lock */
+		if (!SearchSysCacheExists1(RELOID, ObjectIdGetDatum(chunk_oid)))
+		{
+			UnlockRelationOid(chunk_oid, AccessShareLock);
+			continue;
+		}
+
+		chunk_oids = lappend_oid(chunk_oids, chunk_oid);
+	}
+
+	/* Make room for the hypertable and its chunks in the planner's arrays */
+	old_size = root->simple_rel_array_size;
+	new_size = old_size + list_length(chunk_oids) + 1;
+
+	Assert(list_length(root->parse->rtable) + 1 == old_size);
+
+	root->simple_rel_array = repalloc(root->simple_rel_array,
+									  new_size * sizeof(RelOptInfo *));
+	root->simple_rte_array = repalloc(root->simple_rte_array,
+									  new_size * sizeof(RangeTblEntry *));
+	MemSet(root->simple_rel_array + old_size, 0,
+		   (new_size - old_size) * sizeof(RelOptInfo *));
+	MemSet(root->simple_rte_array + old_size, 0,
+		   (new_size - old_size) * sizeof(RangeTblEntry *));
+	root->simple_rel_array_size = new_size;
+
+	oldrelation = heap_open(relation_objectid, NoLock);
+
+	expand_child(root, rte, rel->relid, oldrelation, oldrelation);
+
+	foreach(lc, chunk_oids)
+	{
+		Relation	newrelation = heap_open(lfirst_oid(lc), NoLock);
+
+		expand_child(root, rte, rel->relid, oldrelation, newrelation);
+		heap_close(newrelation, NoLock);
+	}
+
+	heap_close(oldrelation, NoLock);
+
+	/*
+	 * The relation is now an append relation parent, so remove the
+	 * information that get_relation_info() only collects for plain tables.
+	 */
+	rte->inh = true;
+	rel->indexlist = NIL;
+	rel->pages = 0;
+	rel->tuples = 0;
+	rel->allvisfrac = 0;
+
+	foreach(lc, root->fkey_list)
+	{
+		ForeignKeyOptInfo *fkinfo = lfirst(lc);
+
+		if (fkinfo->con_relid != rel->relid)
+			fkeys = lappend(fkeys, fkinfo);
+	}
+
+	root->fkey_list = fkeys;
+}
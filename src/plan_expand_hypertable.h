@@ -0,0 +1,21 @@
+#ifndef TIMESCALEDB_PLAN_EXPAND_HYPERTABLE_H
+#define TIMESCALEDB_PLAN_EXPAND_HYPERTABLE_H
+
+#include <postgres.h>
+#include <nodes/parsenodes.h>
+#include <nodes/relation.h>
+
+#include "cache.h"
+
+typedef struct Hypertable Hypertable;
+
+extern void plan_expand_hypertable_mark_rtes(Query *parse, Cache *hcache);
+extern bool plan_expand_hypertable_is_marked(RangeTblEntry *rte);
+extern void plan_expand_hypertable_chunks(Hypertable *ht,
+							  PlannerInfo *root,
+							  Oid relation_objectid,
+							  RelOptInfo *rel,
+							  bool exclude_chunks);
+extern List *plan_expand_hypertable_time_bucket_quals(Hypertable *ht, Index rti, Expr *clause);
+
+#endif							/* TIMESCALEDB_PLAN_EXPAND_HYPERTABLE_H */
@@ -1,10 +1,12 @@
 #include <postgres.h>
 #include <nodes/plannodes.h>
+#include <nodes/nodeFuncs.h>
 #include <parser/parsetree.h>
 #include <optimizer/clauses.h>
 #include <optimizer/planner.h>
 #include <optimizer/pathnode.h>
 #include <optimizer/paths.h>
+#include <optimizer/plancat.h>
 #include <catalog/namespace.h>
 #include <utils/guc.h>
 #include <miscadmin.h>
@@ -22,12 +24,27 @@
 #include "planner_utils.h"
 #include "hypertable_insert.h"
 #include "constraint_aware_append.h"
+#include "plan_agg_bookend.h"
+#include "plan_expand_hypertable.h"
+#include "runtime_chunk_filter.h"
+#include "sort_transform.h"
+#include "gapfill.h"
+#include "decompress_chunk.h"
+#include "skip_scan.h"
+#include "asof_join.h"
+#include "vector_agg.h"
+#include "vector_filter.h"
+#include "minmax_index.h"
+#include "bloom_filter.h"
 
 void		_planner_init(void);
 void		_planner_fini(void);
 
 static planner_hook_type prev_planner_hook;
 static set_rel_pathlist_hook_type prev_set_rel_pathlist_hook;
+static get_relation_info_hook_type prev_get_relation_info_hook;
+static create_upper_paths_hook_type prev_create_upper_paths_hook;
+static set_join_pathlist_hook_type prev_set_join_pathlist_hook;
 
 typedef struct ModifyTableWalkerCtx
 {
@@ -148,6 +165,26 @@ timescaledb_planner(Query *parse, int cursor_opts, ParamListInfo bound_params)
 {
 	PlannedStmt *plan_stmt = NULL;
 
+	if (extension_is_loaded() && !guc_disable_optimizations)
+	{
+		Cache	   *hcache = hypertable_cache_pin();
+
+		/*
+		 * Rewrite first() and last() into ordered subqueries before marking
+		 * hypertables for expansion, so that the subqueries' hypertables are
+		 * marked too.
+		 */
+		if (guc_bookend_index_scan)
+			plan_agg_bookend_optimization(parse, hcache);
+
+		/*
+		 * Take over the expansion of hypertables into chunks from
+		 * PostgreSQL. See plan_expand_hypertable.c.
+		 */
+		plan_expand_hypertable_mark_rtes(parse, hcache);
+		cache_release(hcache);
+	}
+
 	if (prev_planner_hook != NULL)
 	{
 		/* Call any earlier hooks */
@@ -168,6 +205,10 @@ timescaledb_planner(Query *parse, int cursor_opts, ParamListInfo bound_params)
 		};
 
 		planned_stmt_walker(plan_stmt, modifytable_plan_walker, &ctx);
+
+		if (!guc_disable_optimizations)
+			runtime_chunk_filter_add_to_plan(plan_stmt, ctx.hcache);
+
 		cache_release(ctx.hcache);
 	}
 
@@ -183,10 +224,20 @@ should_optimize_query(Hypertable *ht)
 }
 
 
-extern void sort_transform_optimization(PlannerInfo *root, RelOptInfo *rel);
+static bool
+contain_extern_param_walker(Node *node, void *context)
+{
+	if (node == NULL)
+		return false;
+
+	if (IsA(node, Param))
+		return ((Param *) node)->paramkind == PARAM_EXTERN;
+
+	return expression_tree_walker(node, contain_extern_param_walker, context);
+}
 
 static inline bool
-should_optimize_append(const Path *path)
+should_optimize_append(Hypertable *ht, const Path *path)
 {
 	RelOptInfo *rel = path->parent;
 	ListCell   *lc;
@@ -196,14 +247,24 @@ should_optimize_append(const Path *path)
 		return false;
 
 	/*
-	 * If there are clauses that have mutable functions, this path is ripe for
-	 * execution-time optimization
+	 * Restrictions on min/max indexed columns and columns with bloom filters
+	 * can only exclude chunks at execution time, since the ranges and
+	 * filters of chunks might change after planning
+	 */
+	if (minmax_restrict_info_create(ht, rel->relid, rel->baserestrictinfo) != NIL ||
+		bloom_restrict_info_create(ht, rel->relid, rel->baserestrictinfo) != NIL)
+		return true;
+
+	/*
+	 * If there are clauses that have mutable functions or parameters, this
+	 * path is ripe for execution-time optimization
 	 */
 	foreach(lc, rel->baserestrictinfo)
 	{
 		RestrictInfo *rinfo = (RestrictInfo *) lfirst(lc);
 
-		if (contain_mutable_functions((Node *) rinfo->clause))
+		if (contain_mutable_functions((Node *) rinfo->clause) ||
+			contain_extern_param_walker((Node *) rinfo->clause, NULL))
 			return true;
 	}
 	return false;
@@ -244,6 +305,13 @@ timescaledb_set_rel_pathlist(PlannerInfo *root,
 	if (!extension_is_loaded() || IS_DUMMY_REL(rel) || !OidIsValid(rte->relid))
 		return;
 
+	/* compressed chunks can only be read through DecompressChunk */
+	if (!rte->inh)
+		decompress_chunk_add_paths(root, rel, rti, rte);
+
+	if (!guc_disable_optimizations && guc_vector_filter && is_append_child(rel, rte))
+		vector_filter_add_paths(root, rel, rte);
+
 	/* quick abort if only optimizing hypertables */
 	if (!guc_optimize_non_hypertables && !(is_append_parent(rel, rte) || is_append_child(rel, rte)))
 		return;
@@ -271,18 +339,30 @@ timescaledb_set_rel_pathlist(PlannerInfo *root,
 		 * time it's too late.
 		 */
 		ListCell   *l;
+		Index		parent_relid = 0;
+
+		/*
+		 * Find the range table index of the parent so that we only visit the
+		 * chunks of this instance of the hypertable, and not those of other
+		 * references to the same hypertable (e.g., in self joins).
+		 */
+		foreach(l, root->append_rel_list)
+		{
+			AppendRelInfo *appinfo = (AppendRelInfo *) lfirst(l);
+
+			if (appinfo->child_relid == rel->relid)
+			{
+				parent_relid = appinfo->parent_relid;
+				break;
+			}
+		}
 
 		foreach(l, root->append_rel_list)
 		{
 			AppendRelInfo *appinfo = (AppendRelInfo *) lfirst(l);
 			RelOptInfo *siblingrel;
 
-			/*
-			 * Note: check against the reloid not the index in the
-			 * simple_rel_array since the current rel is not the parent but
-			 * just the child of the append_rel representing the main table.
-			 */
-			if (appinfo->parent_reloid != rte->relid)
+			if (appinfo->parent_relid != parent_relid)
 				continue;
 			siblingrel = root->simple_rel_array[appinfo->child_relid];
 			sort_transform_optimization(root, siblingrel);
@@ -311,18 +391,119 @@ timescaledb_set_rel_pathlist(PlannerInfo *root,
 			{
 				case T_AppendPath:
 				case T_MergeAppendPath:
-					if (should_optimize_append(path))
+					if (should_optimize_append(ht, path))
 						*pathptr = constraint_aware_append_path_create(root, ht, path);
+					break;
+				case T_GatherPath:
+					{
+						/*
+						 * Gather paths over the partial Append are generated
+						 * before this hook is called, so we need to replace
+						 * the Append below the Gather.
+						 */
+						GatherPath *gather = (GatherPath *) path;
+
+						if (IsA(gather->subpath, AppendPath) &&
+							should_optimize_append(ht, gather->subpath))
+							gather->subpath = constraint_aware_append_path_create(root, ht, gather->subpath);
+						break;
+					}
 				default:
 					break;
 			}
 		}
+
+		foreach(lc, rel->partial_pathlist)
+		{
+			Path	  **pathptr = (Path **) &lfirst(lc);
+
+			if (IsA(*pathptr, AppendPath) && should_optimize_append(ht, *pathptr))
+				*pathptr = constraint_aware_append_path_create(root, ht, *pathptr);
+		}
 	}
 
 out_release:
 	cache_release(hcache);
 }
 
+static void
+timescaledb_get_relation_info_hook(PlannerInfo *root,
+								   Oid relation_objectid,
+								   bool inhparent,
+								   RelOptInfo *rel)
+{
+	RangeTblEntry *rte;
+
+	if (prev_get_relation_info_hook != NULL)
+		prev_get_relation_info_hook(root, relation_objectid, inhparent, rel);
+
+	if (!extension_is_loaded())
+		return;
+
+	rte = planner_rt_fetch(rel->relid, root);
+
+	if (plan_expand_hypertable_is_marked(rte))
+	{
+		Cache	   *hcache = hypertable_cache_pin();
+		Hypertable *ht = hypertable_cache_get_entry(hcache, relation_objectid);
+
+		plan_expand_hypertable_chunks(ht, root, relation_objectid, rel,
+									  constraint_exclusion != CONSTRAINT_EXCLUSION_OFF);
+		cache_release(hcache);
+	}
+}
+
+static void
+timescaledb_create_upper_paths_hook(PlannerInfo *root,
+									UpperRelationKind stage,
+									RelOptInfo *input_rel,
+									RelOptInfo *output_rel)
+{
+	if (prev_create_upper_paths_hook != NULL)
+		prev_create_upper_paths_hook(root, stage, input_rel, output_rel);
+
+	if (!extension_is_loaded())
+		return;
+
+	if (stage == UPPERREL_GROUP_AGG)
+	{
+		if (!guc_disable_optimizations && guc_vector_agg)
+			plan_add_vector_agg(root, input_rel, output_rel);
+
+		/*
+		 * Gap filling changes the results of a query, so it is done even if
+		 * optimizations are disabled
+		 */
+		plan_add_gapfill(root, output_rel);
+	}
+	else if (stage == UPPERREL_DISTINCT)
+	{
+		if (!guc_disable_optimizations && guc_skip_scan)
+			plan_add_skip_scan(root, output_rel);
+	}
+}
+
+static void
+timescaledb_set_join_pathlist_hook(PlannerInfo *root,
+								   RelOptInfo *joinrel,
+								   RelOptInfo *outerrel,
+								   RelOptInfo *innerrel,
+								   JoinType jointype,
+								   JoinPathExtraData *extra)
+{
+	if (prev_set_join_pathlist_hook != NULL)
+		prev_set_join_pathlist_hook(root, joinrel, outerrel, innerrel, jointype, extra);
+
+	if (!extension_is_loaded())
+		return;
+
+	/*
+	 * ASOF joins change the results of a query, so they are planned even if
+	 * optimizations are disabled
+	 */
+	plan_add_asof_join(root, joinrel, outerrel, innerrel, jointype, extra);
+}
+
 void
 _planner_init(void)
 {
@@ -330,6 +511,12 @@ _planner_init(void)
 	planner_hook = timescaledb_planner;
 	prev_set_rel_pathlist_hook = set_rel_pathlist_hook;
 	set_rel_pathlist_hook = timescaledb_set_rel_pathlist;
+	prev_get_relation_info_hook = get_relation_info_hook;
+	get_relation_info_hook = timescaledb_get_relation_info_hook;
+	prev_create_upper_paths_hook = create_upper_paths_hook;
+	create_upper_paths_hook = timescaledb_create_upper_paths_hook;
+	prev_set_join_pathlist_hook = set_join_pathlist_hook;
+	set_join_pathlist_hook = timescaledb_set_join_pathlist_hook;
 }
 
 void
@@ -337,4 +524,7 @@ _planner_fini(void)
 {
 	planner_hook = prev_planner_hook;
 	set_rel_pathlist_hook = prev_set_rel_pathlist_hook;
+	get_relation_info_hook = prev_get_relation_info_hook;
+	create_upper_paths_hook = prev_create_upper_paths_hook;
+	set_join_pathlist_hook = prev_set_join_pathlist_hook;
 }
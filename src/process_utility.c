@@ -34,6 +34,8 @@
 #include "chunk.h"
 #include "chunk_index.h"
 #include "compat.h"
+#include "compressed_chunk.h"
+#include "continuous_agg.h"
 #include "copy.h"
 #include "errors.h"
 #include "event_trigger.h"
@@ -42,6 +44,9 @@
 #include "hypertable_cache.h"
 #include "dimension_vector.h"
 #include "indexing.h"
+#include "minmax_index.h"
+#include "bloom_filter.h"
+#include "last_point_cache.h"
 #include "trigger.h"
 #include "utils.h"
 
@@ -640,10 +645,33 @@ process_rename_column(Cache *hcache, Oid relid, RenameStmt *stmt)
 {
 	Hypertable *ht = hypertable_cache_get_entry(hcache, relid);
 	Dimension  *dim;
+	MinMaxIndex *index;
+	BloomFilter *filter;
 
 	if (NULL == ht)
 		return;
 
+	/* Compressed columns are matched to chunk columns by name */
+	if (compressed_chunk_get_by_hypertable(ht) != NIL)
+		ereport(ERROR,
+				(errcode(ERRCODE_IO_OPERATION_NOT_SUPPORTED),
+				 errmsg("cannot rename a column of a hypertable with compressed chunks"),
+				 errhint("Decompress the chunks with decompress_chunk() first.")));
+
+	index = minmax_index_get_by_column_name(ht->minmax_indexes, stmt->subname);
+
+	if (NULL != index)
+		minmax_index_set_column_name(index, stmt->newname);
+
+	filter = bloom_filter_get_by_column_name(ht->bloom_filters, stmt->subname);
+
+	if (NULL != filter)
+		bloom_filter_set_column_name(filter, stmt->newname);
+
+	if (NULL != ht->last_point_cache &&
+		namestrcmp(&ht->last_point_cache->fd.key_column_name, stmt->subname) == 0)
+		last_point_cache_set_column_name(ht->last_point_cache, stmt->newname);
+
 	dim = hyperspace_get_dimension_by_name(ht->space, DIMENSION_TYPE_ANY, stmt->subname);
 
 	if (NULL == dim)
@@ -1242,6 +1270,112 @@ process_alter_column_type_start(Hypertable *ht, AlterTableCmd *cmd)
 					(errcode(ERRCODE_IO_OPERATION_NOT_SUPPORTED),
 					 errmsg("Cannot change the type of a hash-partitioned column")));
 	}
+
+	/*
+	 * The ranges of a min/max index are stored in internal time format of the
+	 * column type, so they cannot survive a type change.
+	 */
+	if (NULL != minmax_index_get_by_column_name(ht->minmax_indexes, cmd->name))
+		ereport(ERROR,
+				(errcode(ERRCODE_IO_OPERATION_NOT_SUPPORTED),
+				 errmsg("cannot change the type of a column with a min/max index"),
+				 errhint("Remove the min/max index with remove_minmax_index() first.")));
+
+	/* Values of the new type might hash differently */
+	if (NULL != bloom_filter_get_by_column_name(ht->bloom_filters, cmd->name))
+		ereport(ERROR,
+				(errcode(ERRCODE_IO_OPERATION_NOT_SUPPORTED),
+				 errmsg("cannot change the type of a column with a bloom filter"),
+				 errhint("Remove the bloom filter with remove_bloom_filter() first.")));
+
+	/* Keys of the new type might not fit in the cache */
+	if (NULL != ht->last_point_cache &&
+		namestrcmp(&ht->last_point_cache->fd.key_column_name, cmd->name) == 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_IO_OPERATION_NOT_SUPPORTED),
+				 errmsg("cannot change the type of the key column of a last point cache"),
+				 errhint("Remove the last point cache with remove_last_point_cache() first.")));
+
+	/* Compressed values are not rewritten to the new type */
+	if (compressed_chunk_get_by_hypertable(ht) != NIL)
+		ereport(ERROR,
+				(errcode(ERRCODE_IO_OPERATION_NOT_SUPPORTED),
+				 errmsg("cannot change the type of a column of a hypertable with compressed chunks"),
+				 errhint("Decompress the chunks with decompress_chunk() first.")));
+}
+
+/*
+ * Check whether adding a column fills it with values in existing rows.
+ */
+static bool
+column_def_has_default(ColumnDef *coldef)
+{
+	static const char *serial_types[] = {
+		"smallserial", "serial2", "serial", "serial4", "bigserial", "serial8",
+	};
+	const char *typename = typename_get_unqual_name(coldef->typeName);
+	ListCell   *lc;
+	int			i;
+
+	if (NULL != coldef->raw_default || NULL != coldef->cooked_default || coldef->is_not_null)
+		return true;
+
+	for (i = 0; i < lengthof(serial_types); i++)
+		if (strcmp(typename, serial_types[i]) == 0)
+			return true;
+
+	foreach(lc, coldef->constraints)
+	{
+		Constraint *constraint = lfirst(lc);
+
+		switch (constraint->contype)
+		{
+			case CONSTR_DEFAULT:
+			case CONSTR_NOTNULL:
+#if PG10
+			case CONSTR_IDENTITY:
+#endif
+				return true;
+			default:
+				break;
+		}
+	}
+
+	return false;
+}
+
+static void
+process_altertable_add_column(Hypertable *ht, AlterTableCmd *cmd)
+{
+	/*
+	 * Compressed chunks read a column that is missing from their compressed
+	 * table as NULL, so only columns without values can be added.
+	 */
+	if (column_def_has_default((ColumnDef *) cmd->def) &&
+		compressed_chunk_get_by_hypertable(ht) != NIL)
+		ereport(ERROR,
+				(errcode(ERRCODE_IO_OPERATION_NOT_SUPPORTED),
+				 errmsg("cannot add a column with a default value to a hypertable with compressed chunks"),
+				 errhint("Decompress the chunks with decompress_chunk() first.")));
+}
+
+static void
+process_altertable_drop_column(Hypertable *ht, AlterTableCmd *cmd)
+{
+	MinMaxIndex *index = minmax_index_get_by_column_name(ht->minmax_indexes, cmd->name);
+	BloomFilter *filter = bloom_filter_get_by_column_name(ht->bloom_filters, cmd->name);
+
+	if (NULL != index)
+		minmax_index_drop(ht, index);
+
+	if (NULL != filter)
+		bloom_filter_drop(ht, filter);
+
+	if (NULL != ht->last_point_cache &&
+		namestrcmp(&ht->last_point_cache->fd.key_column_name, cmd->name) == 0)
+		last_point_cache_drop(ht);
+
+	compressed_chunk_drop_column(ht, cmd->name);
 }
 
 static void
@@ -1328,8 +1462,14 @@ process_altertable_start_table(Node *parsetree)
 	hcache = hypertable_cache_pin();
 	ht = hypertable_cache_get_entry(hcache, relid);
 	if (ht != NULL)
+	{
 		relation_not_only(stmt->relation);
 
+		/* Cached rows might not match the altered row type */
+		if (NULL != ht->last_point_cache)
+			last_point_cache_reset(ht->fd.id);
+	}
+
 	foreach(lc, stmt->cmds)
 	{
 		AlterTableCmd *cmd = (AlterTableCmd *) lfirst(lc);
@@ -1359,12 +1499,22 @@ process_altertable_start_table(Node *parsetree)
 				else
 					verify_constraint_hypertable(ht, cmd->def);
 				break;
+			case AT_AddColumn:
+				Assert(IsA(cmd->def, ColumnDef));
+
+				if (ht != NULL)
+					process_altertable_add_column(ht, cmd);
+				break;
 			case AT_AlterColumnType:
 				Assert(IsA(cmd->def, ColumnDef));
 
 				if (ht != NULL)
 					process_alter_column_type_start(ht, cmd);
 				break;
+			case AT_DropColumn:
+				if (ht != NULL)
+					process_altertable_drop_column(ht, cmd);
+				break;
 #if PG10
 			case AT_AttachPartition:
 				{
@@ -1780,6 +1930,17 @@ process_drop_schema(EventTriggerDropObject *obj)
 						INTERNAL_SCHEMA_NAME, count, (count > 1) ? 's' : '\0')));
 }
 
+static void
+process_drop_view(EventTriggerDropObject *obj)
+{
+	EventTriggerDropView *view;
+
+	Assert(obj->type == EVENT_TRIGGER_DROP_VIEW);
+	view = (EventTriggerDropView *) obj;
+
+	continuous_agg_delete_by_user_view_name(view->schema, view->view_name);
+}
+
 static void
 process_drop_trigger_on_chunk(Hypertable *ht, Oid chunk_relid, void *arg)
 {
@@ -1830,6 +1991,9 @@ process_ddl_sql_drop(EventTriggerDropObject *obj)
 		case EVENT_TRIGGER_DROP_TRIGGER:
 			process_drop_trigger(obj);
 			break;
+		case EVENT_TRIGGER_DROP_VIEW:
+			process_drop_view(obj);
+			break;
 	}
 }
 
@@ -0,0 +1,581 @@
+#include <postgres.h>
+#include <nodes/extensible.h>
+#include <nodes/makefuncs.h>
+#include <nodes/nodeFuncs.h>
+#include <executor/executor.h>
+#include <parser/parsetree.h>
+#include <optimizer/tlist.h>
+#include <utils/lsyscache.h>
+
+#include "runtime_chunk_filter.h"
+#include "constraint_aware_append.h"
+#include "hypertable.h"
+#include "hypertable_cache.h"
+#include "dimension.h"
+#include "dimension_slice.h"
+#include "partitioning.h"
+#include "utils.h"
+#include "guc.h"
+#include "planner_utils.h"
+#include "compat.h"
+
+/*
+ * Runtime chunk filtering for hash joins.
+ *
+ * A common query shape joins a hypertable with a small table of metadata, for
+ * instance:
+ *
+ * SELECT * FROM metrics m JOIN devices d ON (m.device_id = d.id)
+ * WHERE d.region = 'us-east' AND m.time > now() - interval '1 day';
+ *
+ * If the join is a hash join with the hypertable on the probe (outer) side,
+ * all chunks in the time range are scanned, although only chunks that can
+ * contain the devices in the hash table can produce join results.
+ *
+ * To avoid this, we add a RuntimeChunkFilter node on top of the build (inner)
+ * side of the hash join. It collects the join keys as the hash table is built,
+ * either as a time range (when joining on the hypertable's time column) or as
+ * a set of partitioning hashes (when joining on a space-partitioning
+ * column). The filter is handed to the ConstraintAwareAppend node on the probe
+ * side through an executor parameter, and that node skips chunks whose
+ * dimension slices cannot match any of the build-side keys. When joining on
+ * time, rows outside the time range are also skipped before being passed on
+ * to the join.
+ *
+ * Note that the hash join might read the first tuple from the probe side
+ * before building the hash table. In that case, chunks are only skipped once
+ * the build side is complete.
+ */
+
+/* Maximum number of partitioning hashes to collect for a filter */
+#define RUNTIME_CHUNK_FILTER_MAX_HASHES (64 * 1024)
+
+typedef struct RuntimeChunkFilterState
+{
+	CustomScanState csstate;
+	Plan	   *subplan;
+	int			paramid;
+	AttrNumber	keyattno;
+	int32		dimension_id;
+	Oid			hypertable_relid;
+	Cache	   *hcache;
+	Dimension  *dimension;
+	RuntimeChunkFilter *filter;
+} RuntimeChunkFilterState;
+
+static void
+runtime_chunk_filter_reset(RuntimeChunkFilter *filter)
+{
+	filter->complete = false;
+	filter->disabled = false;
+	filter->empty = true;
+	filter->min = PG_INT64_MAX;
+	filter->max = PG_INT64_MIN;
+	filter->num_hashes = 0;
+}
+
+static void
+runtime_chunk_filter_add_key(RuntimeChunkFilterState *state, Datum value)
+{
+	RuntimeChunkFilter *filter = state->filter;
+
+	if (filter->open_dimension)
+	{
+		int64		time;
+
+		/* Keys that are out of range cannot match any chunk */
+		if (!time_value_is_convertible(value, filter->keytype))
+			return;
+
+		time = time_value_to_internal(value, filter->keytype);
+		filter->min = Min(filter->min, time);
+		filter->max = Max(filter->max, time);
+		filter->empty = false;
+		return;
+	}
+
+	if (filter->num_hashes >= filter->max_hashes)
+	{
+		if (filter->max_hashes >= RUNTIME_CHUNK_FILTER_MAX_HASHES)
+		{
+			filter->disabled = true;
+			return;
+		}
+
+		filter->max_hashes *= 2;
+		filter->hashes = repalloc(filter->hashes, sizeof(int32) * filter->max_hashes);
+	}
+
+	filter->hashes[filter->num_hashes++] =
+		partitioning_func_apply(state->dimension->partitioning, value);
+}
+
+static void
+runtime_chunk_filter_finalize(RuntimeChunkFilter *filter)
+{
+	if (!filter->open_dimension && filter->num_hashes > 1)
+	{
+		int			i,
+					num_hashes = 1;
+
+		qsort(filter->hashes, filter->num_hashes, sizeof(int32), int_cmp);
+
+		for (i = 1; i < filter->num_hashes; i++)
+			if (filter->hashes[i] != filter->hashes[num_hashes - 1])
+				filter->hashes[num_hashes++] = filter->hashes[i];
+
+		filter->num_hashes = num_hashes;
+	}
+
+	filter->complete = true;
+}
+
+/*
+ * Get the filter for the given executor parameter, or NULL if the node
+ * building the filter has not been initialized yet.
+ */
+RuntimeChunkFilter *
+runtime_chunk_filter_get(EState *estate, int paramid)
+{
+	ParamExecData *prm = &estate->es_param_exec_vals[paramid];
+
+	if (prm->isnull)
+		return NULL;
+
+	return (RuntimeChunkFilter *) DatumGetPointer(prm->value);
+}
+
+/*
+ * Check if a chunk's slice in the filter's dimension can contain tuples that
+ * match any of the build-side keys.
+ */
+bool
+runtime_chunk_filter_matches_slice(RuntimeChunkFilter *filter, DimensionSlice *slice)
+{
+	int			low,
+				high;
+
+	if (NULL == filter || !filter->complete || filter->disabled || NULL == slice)
+		return true;
+
+	if (filter->open_dimension)
+		return !filter->empty &&
+			slice->fd.range_start <= filter->max &&
+			slice->fd.range_end > filter->min;
+
+	/* Find the first hash that is not below the start of the slice */
+	low = 0;
+	high = filter->num_hashes;
+
+	while (low < high)
+	{
+		int			mid = low + (high - low) / 2;
+
+		if (filter->hashes[mid] < slice->fd.range_start)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+
+	return low < filter->num_hashes && filter->hashes[low] < slice->fd.range_end;
+}
+
+/*
+ * Check if a probe-side join key can match any of the build-side keys. Only
+ * time ranges are checked, since checking partitioning hashes would require
+ * hashing every probe-side key, which is as expensive as probing the hash
+ * table itself.
+ */
+bool
+runtime_chunk_filter_matches_value(RuntimeChunkFilter *filter, Datum value, bool isnull)
+{
+	int64		time;
+
+	if (NULL == filter || !filter->complete || filter->disabled)
+		return true;
+
+	/* NULL keys never match in a hash join */
+	if (isnull)
+		return false;
+
+	if (!filter->open_dimension)
+		return true;
+
+	if (filter->empty)
+		return false;
+
+	if (!time_value_is_convertible(value, filter->keytype))
+		return true;
+
+	time = time_value_to_internal(value, filter->keytype);
+
+	return time >= filter->min && time <= filter->max;
+}
+
+static void
+runtime_chunk_filter_begin(CustomScanState *node, EState *estate, int eflags)
+{
+	RuntimeChunkFilterState *state = (RuntimeChunkFilterState *) node;
+	RuntimeChunkFilter *filter = palloc0(sizeof(RuntimeChunkFilter));
+	ParamExecData *prm = &estate->es_param_exec_vals[state->paramid];
+	Hypertable *ht;
+
+	state->hcache = hypertable_cache_pin();
+	ht = hypertable_cache_get_entry(state->hcache, state->hypertable_relid);
+
+	if (NULL != ht)
+		state->dimension = hyperspace_get_dimension_by_id(ht->space, state->dimension_id);
+
+	runtime_chunk_filter_reset(filter);
+
+	if (NULL == state->dimension)
+		filter->disabled = true;
+	else
+	{
+		filter->open_dimension = IS_OPEN_DIMENSION(state->dimension);
+		filter->keytype = state->dimension->fd.column_type;
+
+		if (!filter->open_dimension)
+		{
+			filter->max_hashes = 64;
+			filter->hashes = palloc(sizeof(int32) * filter->max_hashes);
+		}
+	}
+
+	state->filter = filter;
+
+	/* Make the filter available to the probe side of the join */
+	prm->execPlan = NULL;
+	prm->value = PointerGetDatum(filter);
+	prm->isnull = false;
+
+	node->custom_ps = list_make1(ExecInitNode(state->subplan, estate, eflags));
+}
+
+static TupleTableSlot *
+runtime_chunk_filter_exec(CustomScanState *node)
+{
+	RuntimeChunkFilterState *state = (RuntimeChunkFilterState *) node;
+	RuntimeChunkFilter *filter = state->filter;
+	TupleTableSlot *slot = ExecProcNode(linitial(node->custom_ps));
+
+	if (TupIsNull(slot))
+	{
+		if (!filter->complete)
+			runtime_chunk_filter_finalize(filter);
+
+		return slot;
+	}
+
+	if (!filter->disabled)
+	{
+		bool		isnull;
+		Datum		value = slot_getattr(slot, state->keyattno, &isnull);
+
+		if (!isnull)
+			runtime_chunk_filter_add_key(state, value);
+	}
+
+	return slot;
+}
+
+static void
+runtime_chunk_filter_end(CustomScanState *node)
+{
+	RuntimeChunkFilterState *state = (RuntimeChunkFilterState *) node;
+
+	ExecEndNode(linitial(node->custom_ps));
+	cache_release(state->hcache);
+}
+
+static void
+runtime_chunk_filter_rescan(CustomScanState *node)
+{
+	RuntimeChunkFilterState *state = (RuntimeChunkFilterState *) node;
+	PlanState  *subplanstate = linitial(node->custom_ps);
+
+	runtime_chunk_filter_reset(state->filter);
+
+	if (NULL == state->dimension)
+		state->filter->disabled = true;
+
+	if (node->ss.ps.chgParam != NULL)
+		UpdateChangedParamSet(subplanstate, node->ss.ps.chgParam);
+
+	ExecReScan(subplanstate);
+}
+
+static CustomExecMethods runtime_chunk_filter_state_methods = {
+	.CustomName = "RuntimeChunkFilter",
+	.BeginCustomScan = runtime_chunk_filter_begin,
+	.ExecCustomScan = runtime_chunk_filter_exec,
+	.EndCustomScan = runtime_chunk_filter_end,
+	.ReScanCustomScan = runtime_chunk_filter_rescan,
+};
+
+static Node *
+runtime_chunk_filter_state_create(CustomScan *cscan)
+{
+	RuntimeChunkFilterState *state;
+	List	   *settings = linitial(cscan->custom_private);
+
+	state = (RuntimeChunkFilterState *) newNode(sizeof(RuntimeChunkFilterState),
+												T_CustomScanState);
+	state->csstate.methods = &runtime_chunk_filter_state_methods;
+	state->subplan = linitial(cscan->custom_plans);
+	state->paramid = linitial_int(settings);
+	state->keyattno = lsecond_int(settings);
+	state->dimension_id = lthird_int(settings);
+	state->hypertable_relid = linitial_oid(lsecond(cscan->custom_private));
+
+	return (Node *) state;
+}
+
+static CustomScanMethods runtime_chunk_filter_plan_methods = {
+	.CustomName = "RuntimeChunkFilter",
+	.CreateCustomScanState = runtime_chunk_filter_state_create,
+};
+
+/*
+ * Create a RuntimeChunkFilter node on top of the given (build-side)
+ * plan. Since this happens after set_plan_references(), the target list is
+ * built directly in its final form, referencing the subplan's output.
+ */
+static Plan *
+runtime_chunk_filter_plan_create(Plan *subplan, int paramid, AttrNumber keyattno,
+								 Oid hypertable_relid, int32 dimension_id)
+{
+	CustomScan *cscan = makeNode(CustomScan);
+	List	   *tlist = NIL;
+	ListCell   *lc;
+
+	foreach(lc, subplan->targetlist)
+	{
+		TargetEntry *tle = lfirst(lc);
+		Var		   *var = makeVar(INDEX_VAR,
+								  tle->resno,
+								  exprType((Node *) tle->expr),
+								  exprTypmod((Node *) tle->expr),
+								  exprCollation((Node *) tle->expr),
+								  0);
+
+		tlist = lappend(tlist, makeTargetEntry((Expr *) var,
+											   tle->resno,
+											   tle->resname,
+											   tle->resjunk));
+	}
+
+	cscan->scan.plan.startup_cost = subplan->startup_cost;
+	cscan->scan.plan.total_cost = subplan->total_cost;
+	cscan->scan.plan.plan_rows = subplan->plan_rows;
+	cscan->scan.plan.plan_width = subplan->plan_width;
+#if PG10
+	cscan->scan.plan.parallel_safe = subplan->parallel_safe;
+#endif
+	cscan->scan.plan.targetlist = tlist;
+	cscan->scan.plan.extParam = bms_copy(subplan->extParam);
+	cscan->scan.plan.allParam = bms_copy(subplan->allParam);
+	cscan->scan.scanrelid = 0;
+	cscan->custom_scan_tlist = subplan->targetlist;
+	cscan->custom_plans = list_make1(subplan);
+	cscan->custom_private = list_make2(list_make3_int(paramid, keyattno, dimension_id),
+									   list_make1_oid(hypertable_relid));
+	cscan->methods = &runtime_chunk_filter_plan_methods;
+
+	return &cscan->scan.plan;
+}
+
+typedef struct RuntimeFilterWalkerCtx
+{
+	PlannedStmt *stmt;
+	Cache	   *hcache;
+} RuntimeFilterWalkerCtx;
+
+/*
+ * Resolve a Var in a plan's target list that references the output of a child
+ * plan (e.g., OUTER_VAR or INDEX_VAR) to the attribute number in that child's
+ * output.
+ */
+static AttrNumber
+resolve_tlist_var(List *tlist, Var *var, Index varno)
+{
+	TargetEntry *tle;
+	Var		   *ref;
+
+	if (var->varattno <= 0)
+		return InvalidAttrNumber;
+
+	tle = get_tle_by_resno(tlist, var->varattno);
+
+	if (NULL == tle || !IsA(tle->expr, Var))
+		return InvalidAttrNumber;
+
+	ref = (Var *) tle->expr;
+
+	if (ref->varno != varno || ref->varattno <= 0 ||
+		ref->vartype != var->vartype)
+		return InvalidAttrNumber;
+
+	return ref->varattno;
+}
+
+/*
+ * Try to add a runtime filter for the given hash clause. The outer (probe)
+ * side of the clause must reference a dimension column of a hypertable scanned
+ * by a ConstraintAwareAppend node.
+ */
+static bool
+runtime_filter_add_for_clause(RuntimeFilterWalkerCtx *ctx, HashJoin *hj, OpExpr *op)
+{
+	CustomScan *ca = (CustomScan *) outerPlan(hj);
+	Hash	   *hash = (Hash *) innerPlan(hj);
+	Var		   *outer_var,
+			   *inner_var,
+			   *column;
+	TargetEntry *tle;
+	RangeTblEntry *rte;
+	Hypertable *ht;
+	Dimension  *dim = NULL;
+	AttrNumber	probe_attno,
+				build_attno;
+	Oid			lefttype,
+				righttype;
+	int			paramid;
+	int			i;
+
+	if (!IsA(op, OpExpr) || list_length(op->args) != 2 ||
+		!IsA(linitial(op->args), Var) || !IsA(lsecond(op->args), Var))
+		return false;
+
+	outer_var = linitial(op->args);
+	inner_var = lsecond(op->args);
+
+	if (outer_var->varno != OUTER_VAR || inner_var->varno != INNER_VAR ||
+		outer_var->vartype != inner_var->vartype)
+		return false;
+
+	op_input_types(op->opno, &lefttype, &righttype);
+
+	if (lefttype != outer_var->vartype || righttype != inner_var->vartype)
+		return false;
+
+	/* Find the hypertable column in the ConstraintAwareAppend's input */
+	probe_attno = resolve_tlist_var(ca->scan.plan.targetlist, outer_var, INDEX_VAR);
+
+	if (probe_attno == InvalidAttrNumber)
+		return false;
+
+	tle = get_tle_by_resno(ca->custom_scan_tlist, probe_attno);
+
+	if (NULL == tle || !IsA(tle->expr, Var))
+		return false;
+
+	column = (Var *) tle->expr;
+
+	if (IS_SPECIAL_VARNO(column->varno) || column->varlevelsup != 0)
+		return false;
+
+	rte = rt_fetch(column->varno, ctx->stmt->rtable);
+	ht = hypertable_cache_get_entry(ctx->hcache, rte->relid);
+
+	if (NULL == ht)
+		return false;
+
+	for (i = 0; i < ht->space->num_dimensions; i++)
+	{
+		Dimension  *d = &ht->space->dimensions[i];
+
+		if (d->column_attno == column->varattno &&
+			d->fd.column_type == column->vartype &&
+			(IS_CLOSED_DIMENSION(d) ? NULL != d->partitioning : NULL == d->partitioning))
+		{
+			dim = d;
+			break;
+		}
+	}
+
+	if (NULL == dim)
+		return false;
+
+	/* Find the join key in the output of the hash node's subplan */
+	build_attno = resolve_tlist_var(hash->plan.targetlist, inner_var, OUTER_VAR);
+
+	if (build_attno == InvalidAttrNumber)
+		return false;
+
+	paramid = ctx->stmt->nParamExec++;
+
+	hash->plan.lefttree = runtime_chunk_filter_plan_create(hash->plan.lefttree,
+														   paramid,
+														   build_attno,
+														   rte->relid,
+														   dim->fd.id);
+	constraint_aware_append_set_runtime_filter(ca, paramid, probe_attno, dim->fd.id);
+
+	return true;
+}
+
+static void
+runtime_filter_plan_walker(Plan **planptr, void *pctx)
+{
+	RuntimeFilterWalkerCtx *ctx = pctx;
+	HashJoin   *hj;
+	ListCell   *lc;
+
+	if (!IsA(*planptr, HashJoin))
+		return;
+
+	hj = (HashJoin *) *planptr;
+
+	/*
+	 * Probe-side tuples that have no match in the hash table must not be
+	 * needed for the join result.
+	 */
+	if (hj->join.jointype != JOIN_INNER &&
+		hj->join.jointype != JOIN_SEMI &&
+		hj->join.jointype != JOIN_RIGHT)
+		return;
+
+	if (!is_constraint_aware_append_plan(outerPlan(hj)) ||
+		!IsA(innerPlan(hj), Hash))
+		return;
+
+	/* Chunks can only be skipped when the subplan is an Append */
+	if (!IsA(linitial(((CustomScan *) outerPlan(hj))->custom_plans), Append) ||
+		list_length(((CustomScan *) outerPlan(hj))->custom_private) > 4)
+		return;
+
+	foreach(lc, hj->hashclauses)
+		if (runtime_filter_add_for_clause(ctx, hj, lfirst(lc)))
+			return;
+}
+
+/*
+ * Add runtime chunk filters to the hash joins in a plan that have a
+ * hypertable on the probe side.
+ */
+void
+runtime_chunk_filter_add_to_plan(PlannedStmt *stmt, Cache *hcache)
+{
+	RuntimeFilterWalkerCtx ctx = {
+		.stmt = stmt,
+		.hcache = hcache,
+	};
+
+	if (!guc_runtime_chunk_filter)
+		return;
+
+	planned_stmt_walker(stmt, runtime_filter_plan_walker, &ctx);
+}
+
+void
+_runtime_chunk_filter_init(void)
+{
+	/* Needed to (de)serialize the plan for parallel workers */
+	RegisterCustomScanMethods(&runtime_chunk_filter_plan_methods);
+}
+
+void
+_runtime_chunk_filter_fini(void)
+{
+}
@@ -0,0 +1,42 @@
+#ifndef TIMESCALEDB_RUNTIME_CHUNK_FILTER_H
+#define TIMESCALEDB_RUNTIME_CHUNK_FILTER_H
+
+#include <postgres.h>
+#include <nodes/execnodes.h>
+#include <nodes/plannodes.h>
+
+#include "cache.h"
+
+typedef struct DimensionSlice DimensionSlice;
+
+/*
+ * A filter on the hypertable (probe) side of a hash join, built from the join
+ * keys on the build side of the join. It is passed from the node collecting
+ * the build-side keys to the ConstraintAwareAppend node on the probe side
+ * through an executor parameter.
+ */
+typedef struct RuntimeChunkFilter
+{
+	/* Set when all build-side keys have been collected */
+	bool		complete;
+	/* Set if the filter cannot be used, e.g., because of too many keys */
+	bool		disabled;
+	/* The join key is an open (time) dimension, otherwise a closed one */
+	bool		open_dimension;
+	Oid			keytype;
+	/* Open dimensions: range of the build-side keys in internal time */
+	bool		empty;
+	int64		min;
+	int64		max;
+	/* Closed dimensions: partitioning hashes of the build-side keys */
+	int32	   *hashes;
+	int			num_hashes;
+	int			max_hashes;
+} RuntimeChunkFilter;
+
+extern void runtime_chunk_filter_add_to_plan(PlannedStmt *stmt, Cache *hcache);
+extern RuntimeChunkFilter *runtime_chunk_filter_get(EState *estate, int paramid);
+extern bool runtime_chunk_filter_matches_slice(RuntimeChunkFilter *filter, DimensionSlice *slice);
+extern bool runtime_chunk_filter_matches_value(RuntimeChunkFilter *filter, Datum value, bool isnull);
+
+#endif							/* TIMESCALEDB_RUNTIME_CHUNK_FILTER_H */
@@ -40,6 +40,12 @@ typedef struct Scanner
 	void		(*closeheap) (InternalScannerCtx *ctx);
 } Scanner;
 
+static inline Snapshot
+scanner_snapshot(ScannerCtx *sctx)
+{
+	return NULL == sctx->snapshot ? SnapshotSelf : sctx->snapshot;
+}
+
 /* Functions implementing heap scans */
 static Relation
 heap_scanner_open(InternalScannerCtx *ctx)
@@ -53,7 +59,7 @@ heap_scanner_beginscan(InternalScannerCtx *ctx)
 {
 	ScannerCtx *sctx = ctx->sctx;
 
-	ctx->scan.heap_scan = heap_beginscan(ctx->tablerel, SnapshotSelf,
+	ctx->scan.heap_scan = heap_beginscan(ctx->tablerel, scanner_snapshot(sctx),
 										 sctx->nkeys, sctx->scankey);
 	return ctx->scan;
 }
@@ -92,7 +98,7 @@ index_scanner_beginscan(InternalScannerCtx *ctx)
 	ScannerCtx *sctx = ctx->sctx;
 
 	ctx->scan.index_scan = index_beginscan(ctx->tablerel, ctx->indexrel,
-										   SnapshotSelf, sctx->nkeys,
+										   scanner_snapshot(sctx), sctx->nkeys,
 										   sctx->norderbys);
 	ctx->scan.index_scan->xs_want_itup = ctx->sctx->want_itup;
 	index_rescan(ctx->scan.index_scan, sctx->scankey,
@@ -52,6 +52,12 @@ typedef struct ScannerCtx
 		bool		enabled;
 	}			tuplock;
 	ScanDirection scandirection;
+
+	/*
+	 * Snapshot to scan with. Defaults to SnapshotSelf, which sees the latest
+	 * committed catalog state and the current transaction's changes.
+	 */
+	Snapshot	snapshot;
 	void	   *data;			/* User-provided data passed on to filter()
 								 * and tuple_found() */
 
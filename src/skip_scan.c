@@ -0,0 +1,661 @@
+#include <postgres.h>
+#include <access/nbtree.h>
+#include <access/relscan.h>
+#include <catalog/pg_am.h>
+#include <catalog/pg_index.h>
+#include <commands/explain.h>
+#include <executor/executor.h>
+#include <executor/nodeIndexscan.h>
+#include <miscadmin.h>
+#include <nodes/extensible.h>
+#include <nodes/nodeFuncs.h>
+#include <optimizer/cost.h>
+#include <optimizer/pathnode.h>
+#include <utils/datum.h>
+#include <utils/lsyscache.h>
+#include <utils/memutils.h>
+#include <utils/rel.h>
+#include <utils/selfuncs.h>
+
+#include "compat.h"
+#include "constraint_aware_append.h"
+#include "skip_scan.h"
+
+/*
+ * SkipScan answers DISTINCT (ON) queries over a btree index whose leading
+ * column is the distinct key by returning only the first tuple of every key.
+ *
+ * Instead of reading all tuples of a key and having Unique throw away all
+ * but the first one, the index is descended again for every key with an
+ * extra scan key that finds the first tuple past the current key (e.g.,
+ * device > 'a' on an index on (device, time DESC)). With few keys and many
+ * tuples per key, this reads a handful of index pages per key instead of the
+ * whole index.
+ *
+ * The node replaces the index scans under the Unique node of a DISTINCT
+ * plan, so every chunk is skip scanned on its own and Unique still merges
+ * the keys of the chunks.
+ */
+
+/*
+ * Create the ExprContext for the runtime keys, like ExecInitIndexScan(),
+ * since they are evaluated in a context of their own.
+ */
+static ExprContext *
+skip_scan_runtime_context(CustomScanState *node, EState *estate)
+{
+	ExprContext *stdecontext = node->ss.ps.ps_ExprContext;
+	ExprContext *econtext;
+
+	ExecAssignExprContext(estate, &node->ss.ps);
+	econtext = node->ss.ps.ps_ExprContext;
+	node->ss.ps.ps_ExprContext = stdecontext;
+
+	return econtext;
+}
+
+static void
+skip_scan_begin(CustomScanState *node, EState *estate, int eflags)
+{
+	SkipScanState *state = (SkipScanState *) node;
+	CustomScan *cscan = (CustomScan *) node->ss.ps.plan;
+	TupleDesc	tupdesc = RelationGetDescr(node->ss.ss_currentRelation);
+	List	   *indexqual = linitial(cscan->custom_exprs);
+	List	   *indexqualorig = lsecond(cscan->custom_exprs);
+	Relation	index;
+	int16		indoption;
+	bool		forward;
+	Oid			opno;
+
+	index = index_open(linitial_oid(linitial(cscan->custom_private)), AccessShareLock);
+	state->index = index;
+	state->direction = (ScanDirection) linitial_int(lsecond(cscan->custom_private));
+
+#if PG10
+	state->indexqualorig = ExecInitQual(indexqualorig, &node->ss.ps);
+#elif PG96
+	state->indexqualorig = (List *) ExecInitExpr((Expr *) indexqualorig, &node->ss.ps);
+#endif
+
+	ExecIndexBuildScanKeys(&node->ss.ps,
+						   index,
+						   indexqual,
+						   false,
+						   &state->scankeys,
+						   &state->num_scankeys,
+						   &state->runtime_keys,
+						   &state->num_runtime_keys,
+						   NULL,
+						   NULL);
+
+	if (state->num_runtime_keys != 0)
+		state->runtime_context = skip_scan_runtime_context(node, estate);
+
+	state->runtime_keys_ready = state->num_runtime_keys == 0;
+	state->keys = palloc0(sizeof(ScanKeyData) * (state->num_scankeys + 1));
+
+	/*
+	 * The next key in scan order is the first one greater than the current
+	 * key on an ascending index scanned forward, or a descending index
+	 * scanned backward, and the first one less than it otherwise.
+	 */
+	indoption = index->rd_indoption[0];
+	forward = ScanDirectionIsForward(state->direction);
+	state->strategy = (forward == ((indoption & INDOPTION_DESC) == 0)) ?
+		BTGreaterStrategyNumber : BTLessStrategyNumber;
+	state->nulls_first = forward == ((indoption & INDOPTION_NULLS_FIRST) != 0);
+	state->opcintype = index->rd_opcintype[0];
+	state->collation = index->rd_indcollation[0];
+
+	opno = get_opfamily_member(index->rd_opfamily[0],
+							   state->opcintype,
+							   state->opcintype,
+							   state->strategy);
+
+	if (!OidIsValid(opno))
+		elog(ERROR, "missing operator %d(%u,%u) in opfamily %u",
+			 state->strategy, state->opcintype, state->opcintype, index->rd_opfamily[0]);
+
+	state->skip_proc = get_opcode(opno);
+	state->key_attno = index->rd_index->indkey.values[0];
+	state->key_typlen = tupdesc->attrs[state->key_attno - 1]->attlen;
+	state->key_typbyval = tupdesc->attrs[state->key_attno - 1]->attbyval;
+	state->key_context = AllocSetContextCreate(CurrentMemoryContext,
+											   "SkipScan key",
+											   ALLOCSET_SMALL_SIZES);
+}
+
+/*
+ * Descend the index again with the skip key followed by the index qual keys.
+ */
+static void
+skip_scan_restart(ScanState *node)
+{
+	SkipScanState *state = (SkipScanState *) node;
+
+	/* A scan is restarted only with as many keys as it began with */
+	if (state->scan->numberOfKeys != state->num_scankeys + 1)
+	{
+		index_endscan(state->scan);
+		state->scan = index_beginscan(node->ss_currentRelation,
+									  state->index,
+									  node->ps.state->es_snapshot,
+									  state->num_scankeys + 1,
+									  0);
+	}
+
+	state->keys[0] = state->skip_key;
+	memcpy(&state->keys[1], state->scankeys, sizeof(ScanKeyData) * state->num_scankeys);
+	index_rescan(state->scan, state->keys, state->num_scankeys + 1, NULL, 0);
+	state->skip = false;
+}
+
+/* Set the skip key to an IS NULL (SK_SEARCHNULL) or IS NOT NULL key */
+static void
+skip_scan_set_null_key(SkipScanState *state, int flags)
+{
+	ScanKeyEntryInitialize(&state->skip_key,
+						   SK_ISNULL | flags,
+						   1,
+						   InvalidStrategy,
+						   InvalidOid,
+						   InvalidOid,
+						   InvalidOid,
+						   (Datum) 0);
+}
+
+static TupleTableSlot *
+skip_scan_next(ScanState *node)
+{
+	SkipScanState *state = (SkipScanState *) node;
+	EState	   *estate = node->ps.state;
+	TupleTableSlot *slot = node->ss_ScanTupleSlot;
+	HeapTuple	tuple;
+
+	if (state->done)
+		return ExecClearTuple(slot);
+
+	if (!state->runtime_keys_ready)
+	{
+		ResetExprContext(state->runtime_context);
+		ExecIndexEvalRuntimeKeys(state->runtime_context,
+								 state->runtime_keys,
+								 state->num_runtime_keys);
+		state->runtime_keys_ready = true;
+	}
+
+	if (NULL == state->scan)
+	{
+		/* The first key is found without the skip key */
+		state->scan = index_beginscan(node->ss_currentRelation,
+									  state->index,
+									  estate->es_snapshot,
+									  state->num_scankeys,
+									  0);
+		index_rescan(state->scan, state->scankeys, state->num_scankeys, NULL, 0);
+	}
+	else if (state->skip)
+		skip_scan_restart(node);
+
+	tuple = index_getnext(state->scan, state->direction);
+
+	/*
+	 * The skip key never matches NULLs, so when they come last in scan order
+	 * the index is descended once more to find them after the last non-NULL
+	 * key
+	 */
+	if (NULL == tuple && state->search_nulls)
+	{
+		skip_scan_set_null_key(state, SK_SEARCHNULL);
+		state->search_nulls = false;
+		skip_scan_restart(node);
+		tuple = index_getnext(state->scan, state->direction);
+	}
+
+	if (NULL == tuple)
+	{
+		state->done = true;
+		return ExecClearTuple(slot);
+	}
+
+	return ExecStoreTuple(tuple, slot, state->scan->xs_cbuf, false);
+}
+
+/* Recheck the index quals, like IndexRecheck() */
+static bool
+skip_scan_recheck(ScanState *node, TupleTableSlot *slot)
+{
+	SkipScanState *state = (SkipScanState *) node;
+	ExprContext *econtext = node->ps.ps_ExprContext;
+
+	econtext->ecxt_scantuple = slot;
+	ResetExprContext(econtext);
+
+#if PG10
+	return ExecQual(state->indexqualorig, econtext);
+#elif PG96
+	return ExecQual(state->indexqualorig, econtext, false);
+#endif
+}
+
+/*
+ * Set the skip key to find the first tuple past the key of the returned
+ * tuple. All NULLs are a single key, so if they come last in scan order the
+ * scan is done, and if they come first the next key is the first non-NULL
+ * one. Past a non-NULL key, NULLs that come last are only found once no
+ * non-NULL key is left.
+ */
+static void
+skip_scan_set_skip_key(SkipScanState *state, TupleTableSlot *slot)
+{
+	Datum		value;
+	bool		isnull;
+	MemoryContext old;
+
+	value = slot_getattr(slot, state->key_attno, &isnull);
+
+	MemoryContextReset(state->key_context);
+
+	if (isnull)
+	{
+		if (!state->nulls_first)
+		{
+			state->done = true;
+			return;
+		}
+
+		skip_scan_set_null_key(state, SK_SEARCHNOTNULL);
+		state->search_nulls = false;
+	}
+	else
+	{
+		old = MemoryContextSwitchTo(state->key_context);
+		value = datumCopy(value, state->key_typbyval, state->key_typlen);
+		MemoryContextSwitchTo(old);
+
+		ScanKeyEntryInitialize(&state->skip_key,
+							   0,
+							   1,
+							   state->strategy,
+							   state->opcintype,
+							   state->collation,
+							   state->skip_proc,
+							   value);
+		state->search_nulls = !state->nulls_first;
+	}
+
+	state->skip = true;
+}
+
+static TupleTableSlot *
+skip_scan_exec(CustomScanState *node)
+{
+	SkipScanState *state = (SkipScanState *) node;
+	TupleTableSlot *slot = ExecScan(&node->ss, skip_scan_next, skip_scan_recheck);
+
+	/* The scan slot still holds the returned tuple after projection */
+	if (!TupIsNull(slot))
+		skip_scan_set_skip_key(state, node->ss.ss_ScanTupleSlot);
+
+	return slot;
+}
+
+static void
+skip_scan_end(CustomScanState *node)
+{
+	SkipScanState *state = (SkipScanState *) node;
+
+	if (NULL != state->scan)
+		index_endscan(state->scan);
+
+	index_close(state->index, NoLock);
+}
+
+static void
+skip_scan_rescan(CustomScanState *node)
+{
+	SkipScanState *state = (SkipScanState *) node;
+
+	ExecScanReScan(&node->ss);
+
+	if (state->num_runtime_keys != 0)
+		state->runtime_keys_ready = false;
+
+	if (NULL != state->scan)
+		index_endscan(state->scan);
+
+	state->scan = NULL;
+	state->skip = false;
+	state->search_nulls = false;
+	state->done = false;
+}
+
+static void
+skip_scan_explain(CustomScanState *node, List *ancestors, ExplainState *es)
+{
+	SkipScanState *state = (SkipScanState *) node;
+
+	ExplainPropertyText("Index", RelationGetRelationName(state->index), es);
+}
+
+static CustomExecMethods skip_scan_state_methods = {
+	.CustomName = "SkipScan",
+	.BeginCustomScan = skip_scan_begin,
+	.ExecCustomScan = skip_scan_exec,
+	.EndCustomScan = skip_scan_end,
+	.ReScanCustomScan = skip_scan_rescan,
+	.ExplainCustomScan = skip_scan_explain,
+};
+
+static Node *
+skip_scan_state_create(CustomScan *cscan)
+{
+	SkipScanState *state;
+
+	state = (SkipScanState *) newNode(sizeof(SkipScanState), T_CustomScanState);
+	state->csstate.methods = &skip_scan_state_methods;
+
+	return (Node *) state;
+}
+
+static CustomScanMethods skip_scan_plan_methods = {
+	.CustomName = "SkipScan",
+	.CreateCustomScanState = skip_scan_state_create,
+};
+
+/*
+ * The plan takes over the index quals and filter of the index scan planned
+ * for the child path, and scans the index itself.
+ */
+static Plan *
+skip_scan_plan_create(PlannerInfo *root,
+					  RelOptInfo *rel,
+					  struct CustomPath *path,
+					  List *tlist,
+					  List *clauses,
+					  List *custom_plans)
+{
+	CustomScan *cscan = makeNode(CustomScan);
+	IndexScan  *index_scan = linitial(custom_plans);
+
+	if (!IsA(index_scan, IndexScan))
+		elog(ERROR, "unexpected child of SkipScan node");
+
+	cscan->scan.scanrelid = rel->relid;
+	cscan->scan.plan.targetlist = tlist;
+	cscan->scan.plan.qual = index_scan->scan.plan.qual;
+
+	/* Scan tuples have the row type of the chunk */
+	cscan->custom_scan_tlist = NIL;
+	cscan->custom_plans = NIL;
+	cscan->custom_exprs = list_make2(index_scan->indexqual, index_scan->indexqualorig);
+	cscan->custom_private = list_make2(list_make1_oid(index_scan->indexid),
+									   list_make1_int(index_scan->indexorderdir));
+	cscan->flags = path->flags;
+	cscan->methods = &skip_scan_plan_methods;
+
+	return &cscan->scan.plan;
+}
+
+static CustomPathMethods skip_scan_path_methods = {
+	.CustomName = "SkipScan",
+	.PlanCustomPath = skip_scan_plan_create,
+};
+
+/*
+ * Get the column of the relation in the equivalence class of a pathkey, or
+ * NULL if it has none.
+ */
+static Var *
+skip_scan_pathkey_var(PathKey *pathkey, RelOptInfo *rel)
+{
+	ListCell   *lc;
+
+	foreach(lc, pathkey->pk_eclass->ec_members)
+	{
+		EquivalenceMember *em = lfirst(lc);
+		Expr	   *expr = em->em_expr;
+
+		while (IsA(expr, RelabelType))
+			expr = ((RelabelType *) expr)->arg;
+
+		if (IsA(expr, Var) &&
+			((Var *) expr)->varno == rel->relid &&
+			((Var *) expr)->varlevelsup == 0 &&
+			((Var *) expr)->varattno > 0)
+			return (Var *) expr;
+	}
+
+	return NULL;
+}
+
+/*
+ * Create a SkipScan path for an index path that returns tuples ordered by
+ * the distinct key. Returns NULL if the index cannot be skip scanned or if
+ * skipping is estimated to be no cheaper than scanning the whole index.
+ */
+static Path *
+skip_scan_path_create(PlannerInfo *root, IndexPath *path, PathKey *pathkey)
+{
+	RelOptInfo *rel = path->path.parent;
+	IndexOptInfo *indexinfo = path->indexinfo;
+	IndexPath  *index_path;
+	CustomPath *skip_path;
+	Var		   *var;
+	double		ndistinct;
+	Cost		descent_cost;
+	Cost		total_cost;
+	ListCell   *lc;
+
+	if (indexinfo->relam != BTREE_AM_OID || path->indexorderbys != NIL ||
+		path->path.param_info != NULL || path->path.pathkeys == NIL ||
+		linitial(path->path.pathkeys) != pathkey)
+		return NULL;
+
+	var = skip_scan_pathkey_var(pathkey, rel);
+
+	/* The key must be the leading index column, not just the first ordered one */
+	if (NULL == var || indexinfo->indexkeys[0] != var->varattno)
+		return NULL;
+
+	foreach(lc, path->indexquals)
+	{
+		RestrictInfo *rinfo = lfirst(lc);
+
+		if (IsA(rinfo->clause, ScalarArrayOpExpr))
+			return NULL;
+	}
+
+	/* Pseudoconstant quals would put a Result node on top of the index scan */
+	foreach(lc, rel->baserestrictinfo)
+	{
+		RestrictInfo *rinfo = lfirst(lc);
+
+		if (rinfo->pseudoconstant)
+			return NULL;
+	}
+
+	ndistinct = estimate_num_groups(root, list_make1(var), path->path.rows, NULL);
+	ndistinct = clamp_row_est(Min(ndistinct, path->path.rows));
+
+	/*
+	 * Every key costs a descent to a leaf page of the index and a heap
+	 * fetch, and the scan ends with a descent that finds no tuple.
+	 */
+	descent_cost = random_page_cost * 2 + cpu_index_tuple_cost + cpu_tuple_cost +
+		rel->baserestrictcost.per_tuple + path->path.pathtarget->cost.per_tuple;
+	total_cost = path->path.startup_cost + (ndistinct + 1) * descent_cost;
+
+	if (total_cost >= path->path.total_cost)
+		return NULL;
+
+	/* The heap tuples are needed for the key, so no index-only scans */
+	index_path = makeNode(IndexPath);
+	memcpy(index_path, path, sizeof(IndexPath));
+	index_path->path.pathtype = T_IndexScan;
+
+	skip_path = (CustomPath *) newNode(sizeof(CustomPath), T_CustomPath);
+	skip_path->path.pathtype = T_CustomScan;
+	skip_path->path.parent = rel;
+	skip_path->path.pathtarget = path->path.pathtarget;
+	skip_path->path.param_info = NULL;
+	skip_path->path.parallel_safe = path->path.parallel_safe;
+	skip_path->path.rows = ndistinct;
+	skip_path->path.startup_cost = path->path.startup_cost;
+	skip_path->path.total_cost = total_cost;
+	skip_path->path.pathkeys = path->path.pathkeys;
+	skip_path->flags = 0;
+	skip_path->custom_paths = list_make1(index_path);
+	skip_path->custom_private = NIL;
+	skip_path->methods = &skip_scan_path_methods;
+
+	return &skip_path->path;
+}
+
+/*
+ * Replace the index scans in the input of a Unique node with skip scans.
+ * Returns NULL if no index scan was replaced.
+ */
+static Path *
+skip_scan_transform_path(PlannerInfo *root, Path *path, PathKey *pathkey)
+{
+	ListCell   *lc;
+
+	switch (nodeTag(path))
+	{
+		case T_IndexPath:
+			return skip_scan_path_create(root, (IndexPath *) path, pathkey);
+		case T_MergeAppendPath:
+			{
+				MergeAppendPath *append = (MergeAppendPath *) path;
+				MergeAppendPath *skip_append;
+				List	   *subpaths = NIL;
+				Cost		total_cost = append->path.total_cost;
+				double		rows = 0;
+				bool		changed = false;
+
+				foreach(lc, append->subpaths)
+				{
+					Path	   *child = lfirst(lc);
+					Path	   *skip_child = skip_scan_transform_path(root, child, pathkey);
+
+					if (NULL != skip_child)
+					{
+						total_cost += skip_child->total_cost - child->total_cost;
+						child = skip_child;
+						changed = true;
+					}
+
+					rows += child->rows;
+					subpaths = lappend(subpaths, child);
+				}
+
+				if (!changed)
+					return NULL;
+
+				skip_append = makeNode(MergeAppendPath);
+				memcpy(skip_append, append, sizeof(MergeAppendPath));
+				skip_append->subpaths = subpaths;
+				skip_append->path.rows = rows;
+				skip_append->path.total_cost = total_cost;
+
+				return &skip_append->path;
+			}
+		case T_ProjectionPath:
+			{
+				ProjectionPath *projection = (ProjectionPath *) path;
+				ProjectionPath *skip_projection;
+				Path	   *subpath = skip_scan_transform_path(root, projection->subpath, pathkey);
+
+				if (NULL == subpath)
+					return NULL;
+
+				skip_projection = makeNode(ProjectionPath);
+				memcpy(skip_projection, projection, sizeof(ProjectionPath));
+				skip_projection->subpath = subpath;
+				skip_projection->path.rows = subpath->rows;
+				skip_projection->path.total_cost +=
+					subpath->total_cost - projection->subpath->total_cost;
+
+				return &skip_projection->path;
+			}
+		case T_CustomPath:
+			{
+				ConstraintAwareAppendPath *append = (ConstraintAwareAppendPath *) path;
+				ConstraintAwareAppendPath *skip_append;
+				Path	   *subpath;
+
+				if (!is_constraint_aware_append_path(path))
+					return NULL;
+
+				subpath = skip_scan_transform_path(root, linitial(append->cpath.custom_paths), pathkey);
+
+				if (NULL == subpath)
+					return NULL;
+
+				skip_append = (ConstraintAwareAppendPath *)
+					newNode(sizeof(ConstraintAwareAppendPath), T_CustomPath);
+				memcpy(skip_append, append, sizeof(ConstraintAwareAppendPath));
+				skip_append->cpath.custom_paths = list_make1(subpath);
+				skip_append->cpath.path.rows = subpath->rows;
+				skip_append->cpath.path.total_cost = subpath->total_cost;
+
+				return &skip_append->cpath.path;
+			}
+		default:
+			return NULL;
+	}
+}
+
+/*
+ * Add Unique paths with skip scans to a DISTINCT relation with a single
+ * distinct key, for every Unique path whose index scans can skip through the
+ * keys.
+ */
+void
+plan_add_skip_scan(PlannerInfo *root, RelOptInfo *distinct_rel)
+{
+	PathKey    *pathkey;
+	List	   *skip_paths = NIL;
+	ListCell   *lc;
+
+	if (list_length(root->distinct_pathkeys) != 1)
+		return;
+
+	pathkey = linitial(root->distinct_pathkeys);
+
+	foreach(lc, distinct_rel->pathlist)
+	{
+		UpperUniquePath *unique = lfirst(lc);
+		Path	   *subpath;
+
+		if (!IsA(unique, UpperUniquePath) || unique->numkeys != 1)
+			continue;
+
+		subpath = skip_scan_transform_path(root, unique->subpath, pathkey);
+
+		if (NULL != subpath)
+			skip_paths = lappend(skip_paths,
+								 create_upper_unique_path(root,
+														  distinct_rel,
+														  subpath,
+														  1,
+														  unique->path.rows));
+	}
+
+	/* Adding paths while walking the pathlist could free the current path */
+	foreach(lc, skip_paths)
+		add_path(distinct_rel, lfirst(lc));
+}
+
+void
+_skip_scan_init(void)
+{
+	/* Needed to (de)serialize the plan for parallel workers */
+	RegisterCustomScanMethods(&skip_scan_plan_methods);
+}
+
+void
+_skip_scan_fini(void)
+{
+}
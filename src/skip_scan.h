@@ -0,0 +1,50 @@
+#ifndef TIMESCALEDB_SKIP_SCAN_H
+#define TIMESCALEDB_SKIP_SCAN_H
+
+#include <postgres.h>
+#include <access/genam.h>
+#include <access/skey.h>
+#include <executor/nodeIndexscan.h>
+#include <nodes/execnodes.h>
+#include <nodes/extensible.h>
+#include <nodes/relation.h>
+#include <utils/rel.h>
+
+#include "compat.h"
+
+typedef struct SkipScanState
+{
+	CustomScanState csstate;
+	Relation	index;
+	IndexScanDesc scan;
+	ScanDirection direction;
+	ScanKey		scankeys;		/* keys of the index quals */
+	int			num_scankeys;
+	IndexRuntimeKeyInfo *runtime_keys;
+	int			num_runtime_keys;
+	bool		runtime_keys_ready;
+	ExprContext *runtime_context;
+#if PG10
+	ExprState  *indexqualorig;	/* for rechecking tuples */
+#elif PG96
+	List	   *indexqualorig;
+#endif
+	ScanKey		keys;			/* skip key followed by the index qual keys */
+	ScanKeyData skip_key;		/* finds the next distinct value */
+	AttrNumber	key_attno;		/* heap attribute of the leading index column */
+	int16		key_typlen;
+	bool		key_typbyval;
+	StrategyNumber strategy;
+	Oid			opcintype;
+	Oid			collation;
+	RegProcedure skip_proc;
+	bool		nulls_first;	/* NULLs come first in scan order */
+	MemoryContext key_context;	/* holds the value of the skip key */
+	bool		skip;			/* the skip key is set for the next tuple */
+	bool		search_nulls;	/* look for NULLs when the skip key finds none */
+	bool		done;
+} SkipScanState;
+
+extern void plan_add_skip_scan(PlannerInfo *root, RelOptInfo *distinct_rel);
+
+#endif							/* TIMESCALEDB_SKIP_SCAN_H */
@@ -8,6 +8,13 @@
 #include <optimizer/planner.h>
 #include <optimizer/paths.h>
 #include <utils/lsyscache.h>
+#include <utils/builtins.h>
+#include <utils/datetime.h>
+#include <utils/memutils.h>
+#include <parser/scansup.h>
+#include <pgtime.h>
+
+#include "sort_transform.h"
 
 /* This optimizations allows GROUP BY clauses that transform time in
  * order-preserving ways to use indexes on the time field. It works
@@ -16,102 +23,173 @@
  * is order preserving.
  *
  * For example, an ordering on date_trunc('minute', time) can be transformed
- * to an ordering on time.
+ * to an ordering on time. Transforms nest, so an ordering on
+ * time_bucket('5 minutes', time AT TIME ZONE 'UTC', '1 minute') can also be
+ * transformed to an ordering on time.
  */
 
-extern void sort_transform_optimization(PlannerInfo *root, RelOptInfo *rel);
 static Expr *sort_transform_expr(Expr *orig_expr);
 
-static Expr *
-transform_date_trunc(FuncExpr *func)
+typedef struct OrderPreservingFunc
+{
+	const char *name;
+	/* number of arguments of the function */
+	int			nargs;
+	/* the argument the function is order preserving in */
+	int			argno;
+	/* optional check on the function call */
+	sort_transform_check check;
+} OrderPreservingFunc;
+
+static bool
+date_cast_is_order_preserving(FuncExpr *func)
+{
+	/* only casts from timestamp, which do not depend on the session timezone */
+	return exprType(linitial(func->args)) == TIMESTAMPOID;
+}
+
+static bool
+timezone_is_fixed_offset(FuncExpr *func)
 {
 	/*
-	 * date_trunc (const, var) => var
-	 *
-	 * proof: date_trunc(c, time1) > date_trunc(c,time2) iff time1 > time2
+	 * Converting between timestamp and timestamptz at a time zone is only
+	 * order preserving if the zone has a fixed UTC offset, since local time
+	 * jumps back when daylight saving time ends.
 	 */
-	Expr	   *second;
+	Const	   *zone = linitial(func->args);
+	char		tzname[TZ_STRLEN_MAX + 1];
+	char	   *lowzone;
+	int			type,
+				val;
+	pg_tz	   *tzp = NULL;
+	long		gmtoff;
 
-	if (list_length(func->args) != 2 || !IsA(linitial(func->args), Const))
-		return (Expr *) func;
+	if (zone->constisnull)
+		return false;
 
-	second = sort_transform_expr(lsecond(func->args));
-	if (!IsA(second, Var))
-		return (Expr *) func;
+	if (zone->consttype == INTERVALOID)
+		return true;
+
+	if (zone->consttype != TEXTOID)
+		return false;
+
+	text_to_cstring_buffer(DatumGetTextPP(zone->constvalue), tzname, sizeof(tzname));
+
+	/* abbreviations take precedence over zone names, as in timestamptz_zone() */
+	lowzone = downcase_truncate_identifier(tzname, strlen(tzname), false);
+	type = DecodeTimezoneAbbrev(0, lowzone, &val, &tzp);
 
-	return (Expr *) copyObject(second);
+	if (type == TZ || type == DTZ)
+		return true;
+
+	if (type != DYNTZ)
+		tzp = pg_tzset(tzname);
+
+	return tzp != NULL && pg_get_timezone_offset(tzp, &gmtoff);
 }
 
-static Expr *
-transform_time_bucket(FuncExpr *func)
-{
-	/*
-	 * time_bucket(const, var, const) => var
-	 *
-	 * proof: time_bucket(const1, time1) > time_bucket(const1,time2) iff time1
-	 * > time2
-	 */
-	Expr	   *second;
+/*
+ * Functions that are order preserving in one argument, given that all other
+ * arguments are constant:
+ *
+ * f(const1, var1) > f(const1, var2) implies var1 > var2
+ */
+static OrderPreservingFunc builtin_order_preserving_funcs[] = {
+	/* date_trunc(const, var) => var */
+	{"date_trunc", 2, 1, NULL},
+	/* time_bucket(const, var) => var */
+	{"time_bucket", 2, 1, NULL},
+	/* time_bucket(const, var, const) => var */
+	{"time_bucket", 3, 1, NULL},
+	/* timestamp(var) => var */
+	{"timestamp", 1, 0, NULL},
+	/* timestamptz(var) => var, the single-argument cast versions only */
+	{"timestamptz", 1, 0, NULL},
+	/* date(var) => var */
+	{"date", 1, 0, date_cast_is_order_preserving},
+	/* var AT TIME ZONE const => var */
+	{"timezone", 2, 1, timezone_is_fixed_offset},
+};
+
+/* Order-preserving functions registered by other modules */
+static List *registered_order_preserving_funcs = NIL;
 
-	if (list_length(func->args) != 2 || !IsA(linitial(func->args), Const))
-		return (Expr *) func;
+/*
+ * Register a function as order preserving in its argument argno when called
+ * with nargs arguments. All other arguments must be constant for the sort
+ * transform to apply.
+ */
+void
+sort_transform_register_function(const char *name, int nargs, int argno,
+								 sort_transform_check check)
+{
+	MemoryContext old = MemoryContextSwitchTo(TopMemoryContext);
+	OrderPreservingFunc *opf = palloc(sizeof(OrderPreservingFunc));
 
-	second = sort_transform_expr(lsecond(func->args));
-	if (!IsA(second, Var))
-		return (Expr *) func;
+	Assert(argno >= 0 && argno < nargs);
 
-	return (Expr *) copyObject(second);
+	opf->name = pstrdup(name);
+	opf->nargs = nargs;
+	opf->argno = argno;
+	opf->check = check;
+	registered_order_preserving_funcs = lappend(registered_order_preserving_funcs, opf);
+	MemoryContextSwitchTo(old);
 }
 
-static Expr *
-transform_timestamp_cast(FuncExpr *func)
+static OrderPreservingFunc *
+order_preserving_func_lookup(FuncExpr *func)
 {
-	/*
-	 * transform cast from timestamptz to timestamp
-	 *
-	 * timestamp(var) => var
-	 *
-	 * proof: timestamp(time1) > timestamp(time2) iff time1 > time2
-	 *
-	 */
+	char	   *func_name = get_func_name(func->funcid);
+	int			nargs = list_length(func->args);
+	ListCell   *lc;
+	int			i;
 
-	Expr	   *first;
+	if (func_name == NULL)
+		return NULL;
 
-	if (list_length(func->args) != 1)
-		return (Expr *) func;
+	for (i = 0; i < lengthof(builtin_order_preserving_funcs); i++)
+	{
+		OrderPreservingFunc *opf = &builtin_order_preserving_funcs[i];
 
-	first = sort_transform_expr(linitial(func->args));
-	if (!IsA(first, Var))
-		return (Expr *) func;
+		if (opf->nargs == nargs && strncmp(func_name, opf->name, NAMEDATALEN) == 0)
+			return opf;
+	}
+
+	foreach(lc, registered_order_preserving_funcs)
+	{
+		OrderPreservingFunc *opf = lfirst(lc);
+
+		if (opf->nargs == nargs && strncmp(func_name, opf->name, NAMEDATALEN) == 0)
+			return opf;
+	}
 
-	return (Expr *) copyObject(first);
+	return NULL;
 }
 
 static Expr *
-transform_timestamptz_cast(FuncExpr *func)
+transform_order_preserving_func(FuncExpr *func, OrderPreservingFunc *opf)
 {
-	/*
-	 * Transform cast from date to timestamptz, or timestamp to timestamptz,
-	 * or abstime to timestamptz Handles only single-argument versions of the
-	 * cast to avoid explicit timezone specifiers
-	 *
-	 *
-	 * timestamptz(var) => var
-	 *
-	 * proof: timestamptz(time1) > timestamptz(time2) iff time1 > time2
-	 *
-	 */
+	Expr	   *arg = NULL;
+	ListCell   *lc;
+	int			i = 0;
 
-	Expr	   *first;
+	foreach(lc, func->args)
+	{
+		if (i == opf->argno)
+			arg = lfirst(lc);
+		else if (!IsA(lfirst(lc), Const))
+			return (Expr *) func;
+		i++;
+	}
 
-	if (list_length(func->args) != 1)
+	if (arg == NULL || (opf->check != NULL && !opf->check(func)))
 		return (Expr *) func;
 
-	first = sort_transform_expr(linitial(func->args));
-	if (!IsA(first, Var))
+	arg = sort_transform_expr(arg);
+	if (!IsA(arg, Var))
 		return (Expr *) func;
 
-	return (Expr *) copyObject(first);
+	return (Expr *) copyObject(arg);
 }
 
 
@@ -147,6 +225,25 @@ transform_time_op_const_interval(OpExpr *op)
 	return (Expr *) op;
 }
 
+static bool
+int_const_is_positive(Const *c)
+{
+	if (c->constisnull)
+		return false;
+
+	switch (c->consttype)
+	{
+		case INT2OID:
+			return DatumGetInt16(c->constvalue) > 0;
+		case INT4OID:
+			return DatumGetInt32(c->constvalue) > 0;
+		case INT8OID:
+			return DatumGetInt64(c->constvalue) > 0;
+		default:
+			return false;
+	}
+}
+
 static inline Expr *
 transform_int_op_const(OpExpr *op)
 {
@@ -155,8 +252,9 @@ transform_int_op_const(OpExpr *op)
 	 * of  some_int + const fulfilled by sort of some_int same for the
 	 * following operator: + - / *
 	 *
-	 * Note that / is not commutative and const / var does NOT work (namely it
-	 * reverses sort order, which we don't handle yet)
+	 * Note that - and / are not commutative and const - var or const / var
+	 * does NOT work (namely it reverses sort order, which we don't handle
+	 * yet). For the same reason, * and / only work with positive constants.
 	 */
 	if (list_length(op->args) == 2 &&
 		(IsA(lsecond(op->args), Const) ||IsA(linitial(op->args), Const)))
@@ -176,9 +274,12 @@ transform_int_op_const(OpExpr *op)
 			{
 				switch (name[0])
 				{
-					case '-':
-					case '+':
 					case '*':
+						if (!int_const_is_positive(IsA(linitial(op->args), Const) ?
+												   linitial(op->args) : lsecond(op->args)))
+							break;
+						/* FALLTHROUGH */
+					case '+':
 						/* commutative cases */
 						if (IsA(linitial(op->args), Const))
 						{
@@ -196,9 +297,11 @@ transform_int_op_const(OpExpr *op)
 
 						}
 						break;
+					case '-':
 					case '/':
-						/* only if second arg is const */
-						if (IsA(lsecond(op->args), Const))
+						/* only if second arg is const (and positive for /) */
+						if (IsA(lsecond(op->args), Const) &&
+							(name[0] == '-' || int_const_is_positive(lsecond(op->args))))
 						{
 							Expr	   *nonconst = sort_transform_expr((Expr *) linitial(op->args));
 
@@ -235,16 +338,10 @@ sort_transform_expr(Expr *orig_expr)
 	if (IsA(orig_expr, FuncExpr))
 	{
 		FuncExpr   *func = (FuncExpr *) orig_expr;
-		char	   *func_name = get_func_name(func->funcid);
-
-		if (strncmp(func_name, "date_trunc", NAMEDATALEN) == 0)
-			return transform_date_trunc(func);
-		if (strncmp(func_name, "time_bucket", NAMEDATALEN) == 0)
-			return transform_time_bucket(func);
-		if (strncmp(func_name, "timestamp", NAMEDATALEN) == 0)
-			return transform_timestamp_cast(func);
-		if (strncmp(func_name, "timestamptz", NAMEDATALEN) == 0)
-			return transform_timestamptz_cast(func);
+		OrderPreservingFunc *opf = order_preserving_func_lookup(func);
+
+		if (opf != NULL)
+			return transform_order_preserving_func(func, opf);
 	}
 	if (IsA(orig_expr, OpExpr))
 	{
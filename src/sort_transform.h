@@ -0,0 +1,18 @@
+#ifndef TIMESCALEDB_SORT_TRANSFORM_H
+#define TIMESCALEDB_SORT_TRANSFORM_H
+
+#include <postgres.h>
+#include <nodes/primnodes.h>
+#include <nodes/relation.h>
+
+/*
+ * Optional check on a call to an order-preserving function, e.g., to
+ * validate the values of the constant arguments.
+ */
+typedef bool (*sort_transform_check) (FuncExpr *func);
+
+extern void sort_transform_optimization(PlannerInfo *root, RelOptInfo *rel);
+extern void sort_transform_register_function(const char *name, int nargs, int argno,
+								 sort_transform_check check);
+
+#endif							/* TIMESCALEDB_SORT_TRANSFORM_H */
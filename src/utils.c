@@ -3,9 +3,11 @@
 #include <catalog/pg_type.h>
 #include <catalog/pg_trigger.h>
 #include <catalog/namespace.h>
+#include <catalog/pg_language.h>
 #include <access/htup_details.h>
 #include <nodes/nodes.h>
 #include <nodes/makefuncs.h>
+#include <utils/builtins.h>
 #include <utils/guc.h>
 #include <utils/date.h>
 #include <utils/datetime.h>
@@ -206,6 +208,63 @@ time_value_to_internal(Datum time_val, Oid type)
 	return -1;
 }
 
+/*
+ * Convert a value in the internal time representation back into a value of
+ * the given time type.
+ */
+Datum
+internal_to_time_value(int64 value, Oid type)
+{
+	switch (type)
+	{
+		case INT2OID:
+			return Int16GetDatum((int16) value);
+		case INT4OID:
+			return Int32GetDatum((int32) value);
+		case INT8OID:
+			return Int64GetDatum(value);
+		case TIMESTAMPOID:
+		case TIMESTAMPTZOID:
+			return DirectFunctionCall1(pg_unix_microseconds_to_timestamp, Int64GetDatum(value));
+		case DATEOID:
+			return DirectFunctionCall1(timestamp_date,
+									   DirectFunctionCall1(pg_unix_microseconds_to_timestamp,
+														   Int64GetDatum(value)));
+		default:
+			elog(ERROR, "unkown time type oid '%d'", type);
+			pg_unreachable();
+	}
+}
+
+/*
+ * Check whether a time value can be converted into the internal time
+ * representation, i.e., it is not infinite or otherwise out of the range of
+ * timestamps.
+ */
+bool
+time_value_is_convertible(Datum time_val, Oid type)
+{
+	switch (type)
+	{
+		case INT2OID:
+		case INT4OID:
+		case INT8OID:
+			return true;
+		case TIMESTAMPOID:
+		case TIMESTAMPTZOID:
+			return !TIMESTAMP_NOT_FINITE(DatumGetTimestamp(time_val));
+		case DATEOID:
+			{
+				DateADT		date = DatumGetDateADT(time_val);
+
+				return !DATE_NOT_FINITE(date) &&
+					date < (TIMESTAMP_END_JULIAN - POSTGRES_EPOCH_JDATE);
+			}
+		default:
+			return false;
+	}
+}
+
 /* Make a RangeVar from a regclass Oid */
 RangeVar *
 makeRangeVarFromRelid(Oid relid)
@@ -248,7 +307,7 @@ create_fmgr(char *schema, char *function_name, int num_args)
 	return finfo;
 }
 
-static inline int64
+int64
 get_interval_period(Interval *interval)
 {
 	if (interval->month != 0)
@@ -384,3 +443,34 @@ date_bucket(PG_FUNCTION_ARGS)
 	bucketed = DirectFunctionCall2(timestamp_bucket, PG_GETARG_DATUM(0), converted_ts);
 	return DirectFunctionCall1(timestamp_date, bucketed);
 }
+
+/*
+ * Check if a function is implemented by the given C symbol. Functions are
+ * looked up by their symbol rather than their name, so that our functions are
+ * found no matter which schema the extension is installed in, and user
+ * functions with the same name are not mistaken for built-in ones.
+ */
+bool
+function_has_symbol(Oid funcid, const char *symbol)
+{
+	HeapTuple	tuple = SearchSysCache1(PROCOID, ObjectIdGetDatum(funcid));
+	Form_pg_proc form;
+	bool		result = false;
+
+	if (!HeapTupleIsValid(tuple))
+		return false;
+
+	form = (Form_pg_proc) GETSTRUCT(tuple);
+
+	if (form->prolang == ClanguageId || form->prolang == INTERNALlanguageId)
+	{
+		bool		isnull;
+		Datum		prosrc = SysCacheGetAttr(PROCOID, tuple, Anum_pg_proc_prosrc, &isnull);
+
+		result = !isnull && strcmp(TextDatumGetCString(prosrc), symbol) == 0;
+	}
+
+	ReleaseSysCache(tuple);
+
+	return result;
+}
@@ -5,11 +5,23 @@
 #include <fmgr.h>
 #include <nodes/primnodes.h>
 #include <catalog/pg_proc.h>
+#include <datatype/timestamp.h>
 
 /*
  * Convert a column value into the internal time representation.
  */
 extern int64 time_value_to_internal(Datum time_val, Oid type);
+extern bool time_value_is_convertible(Datum time_val, Oid type);
+extern Datum internal_to_time_value(int64 value, Oid type);
+
+/*
+ * Get the length of a time_bucket() interval in the internal unit of
+ * timestamps.
+ */
+extern int64 get_interval_period(Interval *interval);
+
+PGDLLEXPORT Datum timestamp_bucket(PG_FUNCTION_ARGS);
+PGDLLEXPORT Datum timestamptz_bucket(PG_FUNCTION_ARGS);
 
 #if 0
 #define CACHE1_elog(a,b)				elog(a,b)
@@ -30,6 +42,7 @@ extern int64 time_value_to_internal(Datum time_val, Oid type);
 extern FmgrInfo *create_fmgr(char *schema, char *function_name, int num_args);
 extern RangeVar *makeRangeVarFromRelid(Oid relid);
 extern int	int_cmp(const void *a, const void *b);
+extern bool function_has_symbol(Oid funcid, const char *symbol);
 
 #define DATUM_GET(values, attno) \
 	values[attno-1]
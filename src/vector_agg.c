@@ -0,0 +1,1661 @@
+#include <postgres.h>
+#include <access/htup_details.h>
+#include <catalog/pg_aggregate.h>
+#include <catalog/pg_type.h>
+#include <commands/explain.h>
+#include <executor/executor.h>
+#include <miscadmin.h>
+#include <nodes/extensible.h>
+#include <nodes/makefuncs.h>
+#include <nodes/nodeFuncs.h>
+#include <optimizer/cost.h>
+#include <optimizer/pathnode.h>
+#include <optimizer/tlist.h>
+#include <optimizer/var.h>
+#include <utils/builtins.h>
+#include <utils/datum.h>
+#include <utils/lsyscache.h>
+#include <utils/memutils.h>
+#include <utils/syscache.h>
+#include <utils/timestamp.h>
+#include <utils/typcache.h>
+#include <math.h>
+
+#include "chunk_stats.h"
+#include "compat.h"
+#include "decompress_chunk.h"
+#include "dimension.h"
+#include "histogram.h"
+#include "hypertable_cache.h"
+#include "utils.h"
+#include "vector_agg.h"
+
+/*
+ * VectorAgg aggregates a hypertable with compressed chunks.
+ *
+ * The node replaces the Agg and Append nodes of a query that aggregates a
+ * single hypertable and reads the chunks itself. Compressed chunks are read a
+ * batch at a time from their DecompressChunk node and aggregated directly on
+ * the decompressed column arrays, while all other chunks are read row by
+ * row. Rows of a batch are ordered by the segment_by columns, so consecutive
+ * rows with the same grouping key form runs: the group of a run is looked up
+ * once and the aggregates are then updated in tight loops over the run.
+ *
+ * Only count, sum, avg, min, max and histogram of plain columns are
+ * supported, grouped by columns and time_bucket() of timestamp columns.
+ *
+ * Without grouping, count(*) and count, min and max of the time column are
+ * answered from the recorded statistics of chunks that lie entirely within
+ * the query's time range, so such chunks are not read at all. The node is
+ * then also used for hypertables without compressed chunks.
+ */
+
+/* Per-row cost of aggregating decompressed batches relative to rows */
+#define VECTOR_AGG_BATCH_COST_FACTOR 0.1
+
+typedef enum VectorAggKind
+{
+	VECTOR_AGG_COUNT_STAR,
+	VECTOR_AGG_COUNT,
+	VECTOR_AGG_SUM,
+	VECTOR_AGG_AVG,
+	VECTOR_AGG_MIN,
+	VECTOR_AGG_MAX,
+	VECTOR_AGG_HISTOGRAM,
+} VectorAggKind;
+
+/* How the values of an aggregated column are stored in a Datum */
+typedef enum VectorValueType
+{
+	VECTOR_VALUE_NONE,
+	VECTOR_VALUE_INT2,
+	VECTOR_VALUE_INT4,
+	VECTOR_VALUE_INT8,
+	VECTOR_VALUE_FLOAT4,
+	VECTOR_VALUE_FLOAT8,
+} VectorValueType;
+
+/*
+ * Supported aggregates are recognized by the C symbols of their transition
+ * and final functions, so that both the builtin aggregates and any aggregate
+ * defined on top of the same functions are covered.
+ */
+typedef struct VectorAggFunc
+{
+	const char *transfn;
+	const char *finalfn;		/* NULL if there is no final function */
+	VectorAggKind kind;
+	VectorValueType type;
+} VectorAggFunc;
+
+static const VectorAggFunc vector_agg_funcs[] = {
+	{"int8inc", NULL, VECTOR_AGG_COUNT_STAR, VECTOR_VALUE_NONE},
+	{"int8inc_any", NULL, VECTOR_AGG_COUNT, VECTOR_VALUE_NONE},
+	{"int2_sum", NULL, VECTOR_AGG_SUM, VECTOR_VALUE_INT2},
+	{"int4_sum", NULL, VECTOR_AGG_SUM, VECTOR_VALUE_INT4},
+	{"float4pl", NULL, VECTOR_AGG_SUM, VECTOR_VALUE_FLOAT4},
+	{"float8pl", NULL, VECTOR_AGG_SUM, VECTOR_VALUE_FLOAT8},
+	{"int2_avg_accum", "int8_avg", VECTOR_AGG_AVG, VECTOR_VALUE_INT2},
+	{"int4_avg_accum", "int8_avg", VECTOR_AGG_AVG, VECTOR_VALUE_INT4},
+	{"float4_accum", "float8_avg", VECTOR_AGG_AVG, VECTOR_VALUE_FLOAT4},
+	{"float8_accum", "float8_avg", VECTOR_AGG_AVG, VECTOR_VALUE_FLOAT8},
+	{"int2smaller", NULL, VECTOR_AGG_MIN, VECTOR_VALUE_INT2},
+	{"int4smaller", NULL, VECTOR_AGG_MIN, VECTOR_VALUE_INT4},
+	{"int8smaller", NULL, VECTOR_AGG_MIN, VECTOR_VALUE_INT8},
+	{"float4smaller", NULL, VECTOR_AGG_MIN, VECTOR_VALUE_FLOAT4},
+	{"float8smaller", NULL, VECTOR_AGG_MIN, VECTOR_VALUE_FLOAT8},
+	{"date_smaller", NULL, VECTOR_AGG_MIN, VECTOR_VALUE_INT4},
+	{"timestamp_smaller", NULL, VECTOR_AGG_MIN, VECTOR_VALUE_INT8},
+	{"int2larger", NULL, VECTOR_AGG_MAX, VECTOR_VALUE_INT2},
+	{"int4larger", NULL, VECTOR_AGG_MAX, VECTOR_VALUE_INT4},
+	{"int8larger", NULL, VECTOR_AGG_MAX, VECTOR_VALUE_INT8},
+	{"float4larger", NULL, VECTOR_AGG_MAX, VECTOR_VALUE_FLOAT4},
+	{"float8larger", NULL, VECTOR_AGG_MAX, VECTOR_VALUE_FLOAT8},
+	{"date_larger", NULL, VECTOR_AGG_MAX, VECTOR_VALUE_INT4},
+	{"timestamp_larger", NULL, VECTOR_AGG_MAX, VECTOR_VALUE_INT8},
+	{"hist_sfunc", "hist_finalfunc", VECTOR_AGG_HISTOGRAM, VECTOR_VALUE_FLOAT8},
+};
+
+struct VectorAggKey
+{
+	int			column;			/* input column of the key */
+	bool		bucket;			/* key is time_bucket() of the column */
+	int64		period;			/* bucket width */
+	int16		typlen;
+	bool		typbyval;
+	Oid			collation;
+	FmgrInfo   *hash_fn;
+	FmgrInfo   *eq_fn;
+};
+
+struct VectorAggDef
+{
+	VectorAggKind kind;
+	VectorValueType type;
+	int			column;			/* input column, or -1 for count(*) */
+	Oid			typid;			/* type of the input column */
+	double		hist_min;
+	double		hist_max;
+	int32		hist_nbuckets;
+};
+
+/*
+ * The values of an input column for the rows that are currently aggregated.
+ * A constant column holds a single value for all rows, e.g., a segment_by
+ * column of a batch.
+ */
+struct VectorAggColumn
+{
+	Datum	   *values;
+	bool	   *nulls;
+	bool		constant;
+};
+
+typedef struct VectorAggTrans
+{
+	int64		count;			/* number of aggregated values */
+	int64		isum;			/* integer sum, minimum or maximum */
+	double		fsum;			/* float sum, minimum or maximum */
+	float4		f4sum;			/* sum of float4 values */
+	bool		saw_inf;		/* an infinite value was summed */
+	Histogram  *hist;
+} VectorAggTrans;
+
+struct VectorAggGroup
+{
+	Datum	   *key_values;
+	bool	   *key_nulls;
+	VectorAggTrans trans[FLEXIBLE_ARRAY_MEMBER];
+};
+
+typedef struct VectorAggHashEntry
+{
+	uint32		hash;			/* hash key, must be first */
+	List	   *groups;			/* groups with this hash value */
+} VectorAggHashEntry;
+
+/*
+ * Adding -0.0 leaves any float sum unchanged, including a sum of -0.0, so
+ * it stands in for NULLs in the sum loops and starts the sums that PostgreSQL
+ * starts with the first value.
+ */
+#define FLOAT_SUM_IDENTITY (-0.0)
+
+static Datum null_value = (Datum) 0;
+static bool null_isnull = true;
+
+static int
+vector_agg_input_column(List *input_attnos, Node *node)
+{
+	ListCell   *lc;
+	int			i = 0;
+
+	if (!IsA(node, Var))
+		return -1;
+
+	foreach(lc, input_attnos)
+	{
+		if (lfirst_int(lc) == ((Var *) node)->varattno)
+			return i;
+		i++;
+	}
+
+	return -1;
+}
+
+static VectorValueType
+vector_value_type(Oid typid)
+{
+	switch (typid)
+	{
+		case INT2OID:
+			return VECTOR_VALUE_INT2;
+		case INT4OID:
+		case DATEOID:
+			return VECTOR_VALUE_INT4;
+		case INT8OID:
+			return VECTOR_VALUE_INT8;
+#ifdef HAVE_INT64_TIMESTAMP
+		case TIMESTAMPOID:
+		case TIMESTAMPTZOID:
+			return VECTOR_VALUE_INT8;
+#endif
+		case FLOAT4OID:
+			return VECTOR_VALUE_FLOAT4;
+		case FLOAT8OID:
+			return VECTOR_VALUE_FLOAT8;
+		default:
+			return VECTOR_VALUE_NONE;
+	}
+}
+
+/*
+ * Find the implementation of an aggregate call. Returns NULL if the call is
+ * not supported.
+ */
+static const VectorAggFunc *
+vector_agg_get_func(Aggref *aggref, List *input_attnos)
+{
+	const VectorAggFunc *func = NULL;
+	HeapTuple	tuple;
+	Oid			transfn;
+	Oid			finalfn;
+	Node	   *arg;
+	ListCell   *lc;
+	int			i;
+
+	if (aggref->aggfilter != NULL || aggref->aggdistinct != NIL ||
+		aggref->aggorder != NIL || aggref->aggdirectargs != NIL ||
+		aggref->aggkind != AGGKIND_NORMAL || aggref->agglevelsup != 0 ||
+		aggref->aggsplit != AGGSPLIT_SIMPLE)
+		return NULL;
+
+	tuple = SearchSysCache1(AGGFNOID, ObjectIdGetDatum(aggref->aggfnoid));
+
+	if (!HeapTupleIsValid(tuple))
+		return NULL;
+
+	transfn = ((Form_pg_aggregate) GETSTRUCT(tuple))->aggtransfn;
+	finalfn = ((Form_pg_aggregate) GETSTRUCT(tuple))->aggfinalfn;
+	ReleaseSysCache(tuple);
+
+	for (i = 0; i < lengthof(vector_agg_funcs); i++)
+	{
+		const VectorAggFunc *f = &vector_agg_funcs[i];
+
+		if (function_has_symbol(transfn, f->transfn) &&
+			(f->finalfn == NULL ? !OidIsValid(finalfn) : function_has_symbol(finalfn, f->finalfn)))
+		{
+			func = f;
+			break;
+		}
+	}
+
+	if (func == NULL)
+		return NULL;
+
+	if (func->kind == VECTOR_AGG_COUNT_STAR)
+		return aggref->aggstar ? func : NULL;
+
+	if (list_length(aggref->args) != (func->kind == VECTOR_AGG_HISTOGRAM ? 4 : 1))
+		return NULL;
+
+	arg = (Node *) ((TargetEntry *) linitial(aggref->args))->expr;
+
+	if (vector_agg_input_column(input_attnos, arg) < 0)
+		return NULL;
+
+	if (func->type != VECTOR_VALUE_NONE && vector_value_type(exprType(arg)) != func->type)
+		return NULL;
+
+	/* The histogram bounds must be known up front */
+	if (func->kind == VECTOR_AGG_HISTOGRAM)
+		for_each_cell(lc, lnext(list_head(aggref->args)))
+		{
+			Const	   *c = (Const *) ((TargetEntry *) lfirst(lc))->expr;
+
+			if (!IsA(c, Const) || c->constisnull)
+				return NULL;
+		}
+
+	return func;
+}
+
+/*
+ * Check that a grouping expression is either an input column or
+ * time_bucket() of an input column with a fixed bucket width.
+ */
+static bool
+vector_agg_key_supported(Node *expr, List *input_attnos)
+{
+	TypeCacheEntry *tce = lookup_type_cache(exprType(expr), TYPECACHE_HASH_PROC | TYPECACHE_EQ_OPR);
+
+	if (!OidIsValid(tce->hash_proc) || !OidIsValid(tce->eq_opr))
+		return false;
+
+	if (IsA(expr, Var))
+		return vector_agg_input_column(input_attnos, expr) >= 0;
+
+#ifdef HAVE_INT64_TIMESTAMP
+	if (IsA(expr, FuncExpr))
+	{
+		FuncExpr   *func = (FuncExpr *) expr;
+		Const	   *width;
+		Interval   *interval;
+
+		if (list_length(func->args) != 2 ||
+			!(function_has_symbol(func->funcid, "timestamp_bucket") ||
+			  function_has_symbol(func->funcid, "timestamptz_bucket")))
+			return false;
+
+		width = linitial(func->args);
+
+		if (!IsA(width, Const) || width->constisnull ||
+			vector_agg_input_column(input_attnos, lsecond(func->args)) < 0)
+			return false;
+
+		/* Leave invalid widths to time_bucket() to report */
+		interval = DatumGetIntervalP(width->constvalue);
+
+		return interval->month == 0 && get_interval_period(interval) > 0;
+	}
+#endif
+
+	return false;
+}
+
+/*
+ * Check if an expression references columns outside of the grouping keys and
+ * aggregates.
+ */
+static bool
+vector_agg_uses_ungrouped_vars(Node *node, List *keys)
+{
+	if (node == NULL)
+		return false;
+
+	if (list_member(keys, node) || IsA(node, Aggref))
+		return false;
+
+	if (IsA(node, Var))
+		return true;
+
+	return expression_tree_walker(node, vector_agg_uses_ungrouped_vars, keys);
+}
+
+/*
+ * Get the Append path that scans the chunks of a hypertable.
+ */
+static AppendPath *
+vector_agg_find_append(RelOptInfo *input_rel)
+{
+	Path	   *path = input_rel->cheapest_total_path;
+
+	if (path == NULL)
+		return NULL;
+
+	if (IsA(path, ProjectionPath))
+		path = ((ProjectionPath *) path)->subpath;
+
+	if (!IsA(path, AppendPath) || path->param_info != NULL)
+		return NULL;
+
+	return (AppendPath *) path;
+}
+
+static CustomScanMethods vector_agg_plan_methods;
+
+static Plan *
+vector_agg_plan_create(PlannerInfo *root,
+					   RelOptInfo *rel,
+					   struct CustomPath *path,
+					   List *tlist,
+					   List *clauses,
+					   List *custom_plans)
+{
+	CustomScan *cscan = makeNode(CustomScan);
+
+	cscan->scan.scanrelid = 0;
+	cscan->scan.plan.targetlist = tlist;
+	cscan->scan.plan.qual = (List *) copyObject(root->parse->havingQual);
+	/* Scan tuples hold the grouping keys followed by the aggregates */
+	cscan->custom_scan_tlist = linitial(path->custom_private);
+	cscan->custom_plans = custom_plans;
+	cscan->custom_private = list_copy_tail(path->custom_private, 1);
+	cscan->flags = path->flags;
+	cscan->methods = &vector_agg_plan_methods;
+
+	return &cscan->scan.plan;
+}
+
+static CustomPathMethods vector_agg_path_methods = {
+	.CustomName = "VectorAgg",
+	.PlanCustomPath = vector_agg_plan_create,
+};
+
+/*
+ * Check if aggregates can be answered from chunk statistics, i.e., they are
+ * count(*) or count, min or max of the time column.
+ */
+static bool
+vector_agg_stats_supported(List *aggrefs, List *input_attnos, AttrNumber time_attno)
+{
+	ListCell   *lc;
+
+	foreach(lc, aggrefs)
+	{
+		Aggref	   *aggref = lfirst(lc);
+		const VectorAggFunc *func = vector_agg_get_func(aggref, input_attnos);
+
+		switch (func->kind)
+		{
+			case VECTOR_AGG_COUNT_STAR:
+				break;
+			case VECTOR_AGG_COUNT:
+			case VECTOR_AGG_MIN:
+			case VECTOR_AGG_MAX:
+				if (((Var *) ((TargetEntry *) linitial(aggref->args))->expr)->varattno != time_attno)
+					return false;
+				break;
+			default:
+				return false;
+		}
+	}
+
+	return true;
+}
+
+/*
+ * Get, for every child of the append, the ID of the chunk whose statistics
+ * can answer the aggregates over the child, or 0 if the child has to be
+ * read. Returns NIL if the aggregates cannot be answered from statistics.
+ */
+static List *
+vector_agg_stats_chunk_ids(PlannerInfo *root, RelOptInfo *input_rel, AppendPath *append,
+						   List *aggrefs, List *input_attnos)
+{
+	RangeTblEntry *rte = planner_rt_fetch(input_rel->relid, root);
+	Cache	   *hcache = hypertable_cache_pin();
+	Hypertable *ht = hypertable_cache_get_entry(hcache, rte->relid);
+	Dimension  *dim;
+	List	   *chunk_ids = NIL;
+	ListCell   *lc;
+
+	if (NULL == ht)
+	{
+		cache_release(hcache);
+		return NIL;
+	}
+
+	dim = hyperspace_get_open_dimension(ht->space, 0);
+
+	if (NULL != dim && vector_agg_stats_supported(aggrefs, input_attnos, dim->column_attno))
+		foreach(lc, append->subpaths)
+			chunk_ids = lappend_int(chunk_ids,
+									chunk_stats_covered_chunk_id(root, ht, ((Path *) lfirst(lc))->parent));
+
+	cache_release(hcache);
+
+	return chunk_ids;
+}
+
+/*
+ * Add a VectorAgg path to the grouping relation of a query that aggregates a
+ * hypertable with compressed chunks or chunks with statistics.
+ */
+void
+plan_add_vector_agg(PlannerInfo *root, RelOptInfo *input_rel, RelOptInfo *group_rel)
+{
+	Query	   *parse = root->parse;
+	Path	   *group_path;
+	AppendPath *append;
+	CustomPath *path;
+	List	   *input_attnos = NIL;
+	List	   *keys = NIL;
+	List	   *aggrefs = NIL;
+	List	   *scan_tlist = NIL;
+	List	   *stats_chunk_ids = NIL;
+	List	   *exprs;
+	Cost		cost = 0;
+	bool		has_compressed = false;
+	int			num_stats = 0;
+	ListCell   *lc;
+	ListCell   *lc_id;
+
+	if (group_rel->pathlist == NIL || !parse->hasAggs || parse->groupingSets != NIL ||
+		parse->hasTargetSRFs || input_rel->reloptkind != RELOPT_BASEREL)
+		return;
+
+	append = vector_agg_find_append(input_rel);
+
+	if (append == NULL)
+		return;
+
+	foreach(lc, append->subpaths)
+		if (is_decompress_chunk_path(lfirst(lc)))
+			has_compressed = true;
+
+	/* The children of the append return the columns in the same order */
+	foreach(lc, append->path.pathtarget->exprs)
+	{
+		Var		   *var = lfirst(lc);
+
+		if (!IsA(var, Var) || var->varattno <= 0)
+			return;
+
+		input_attnos = lappend_int(input_attnos, var->varattno);
+	}
+
+	foreach(lc, parse->groupClause)
+	{
+		Node	   *expr = get_sortgroupclause_expr(lfirst(lc), root->processed_tlist);
+
+		if (!vector_agg_key_supported(expr, input_attnos))
+			return;
+
+		keys = lappend(keys, expr);
+	}
+
+	group_path = linitial(group_rel->pathlist);
+	exprs = list_copy(group_path->pathtarget->exprs);
+
+	if (parse->havingQual != NULL)
+		exprs = lappend(exprs, parse->havingQual);
+
+	foreach(lc, exprs)
+		if (vector_agg_uses_ungrouped_vars(lfirst(lc), keys))
+			return;
+
+	foreach(lc, pull_var_clause((Node *) exprs, PVC_INCLUDE_AGGREGATES | PVC_RECURSE_PLACEHOLDERS))
+	{
+		Node	   *node = lfirst(lc);
+
+		if (!IsA(node, Aggref))
+			continue;
+
+		if (vector_agg_get_func((Aggref *) node, input_attnos) == NULL)
+			return;
+
+		aggrefs = list_append_unique(aggrefs, node);
+	}
+
+	if (keys == NIL)
+		stats_chunk_ids = vector_agg_stats_chunk_ids(root, input_rel, append, aggrefs, input_attnos);
+
+	lc_id = list_head(stats_chunk_ids);
+
+	foreach(lc, append->subpaths)
+	{
+		Path	   *subpath = lfirst(lc);
+		Cost		per_row = cpu_operator_cost * (list_length(keys) + list_length(aggrefs));
+		int32		chunk_id = 0;
+		ChunkStats	stats;
+
+		if (lc_id != NULL)
+		{
+			chunk_id = lfirst_int(lc_id);
+			lc_id = lnext(lc_id);
+		}
+
+		/* Only the statistics are read if the chunk has statistics now */
+		if (chunk_id > 0 && chunk_stats_get(chunk_id, NULL, &stats))
+		{
+			cost += cpu_tuple_cost;
+			num_stats++;
+			continue;
+		}
+
+		if (is_decompress_chunk_path(subpath))
+			per_row *= VECTOR_AGG_BATCH_COST_FACTOR;
+
+		cost += subpath->total_cost + per_row * subpath->rows;
+	}
+
+	/* Rows of uncompressed chunks are not aggregated faster than by Agg */
+	if (!has_compressed && num_stats == 0)
+		return;
+
+	foreach(lc, keys)
+		scan_tlist = lappend(scan_tlist,
+							 makeTargetEntry(lfirst(lc), list_length(scan_tlist) + 1, NULL, false));
+
+	foreach(lc, aggrefs)
+		scan_tlist = lappend(scan_tlist,
+							 makeTargetEntry(lfirst(lc), list_length(scan_tlist) + 1, NULL, false));
+
+	path = (CustomPath *) newNode(sizeof(CustomPath), T_CustomPath);
+	path->path.pathtype = T_CustomScan;
+	path->path.parent = group_rel;
+	path->path.pathtarget = group_path->pathtarget;
+	path->path.param_info = NULL;
+	path->path.parallel_safe = group_rel->consider_parallel && append->path.parallel_safe;
+	path->path.rows = group_path->rows;
+	/* All input is aggregated before the first group is returned */
+	path->path.startup_cost = cost + cpu_tuple_cost * group_path->rows;
+	path->path.total_cost = path->path.startup_cost;
+	path->path.pathkeys = NIL;
+	path->flags = 0;
+	path->custom_paths = append->subpaths;
+	path->custom_private = list_make4(scan_tlist, makeInteger(list_length(keys)), input_attnos,
+									  stats_chunk_ids);
+	path->methods = &vector_agg_path_methods;
+
+	add_path(group_rel, &path->path);
+}
+
+static void
+vector_agg_init_key(VectorAggKey *key, Expr *expr, List *input_attnos)
+{
+	TypeCacheEntry *tce = lookup_type_cache(exprType((Node *) expr),
+											TYPECACHE_HASH_PROC_FINFO | TYPECACHE_EQ_OPR_FINFO);
+	Node	   *column = (Node *) expr;
+
+	if (IsA(expr, FuncExpr))
+	{
+		FuncExpr   *func = (FuncExpr *) expr;
+
+		key->bucket = true;
+		key->period = get_interval_period(DatumGetIntervalP(((Const *) linitial(func->args))->constvalue));
+		column = lsecond(func->args);
+	}
+
+	key->column = vector_agg_input_column(input_attnos, column);
+	key->typlen = tce->typlen;
+	key->typbyval = tce->typbyval;
+	key->collation = exprCollation((Node *) expr);
+	key->hash_fn = &tce->hash_proc_finfo;
+	key->eq_fn = &tce->eq_opr_finfo;
+}
+
+static void
+vector_agg_init_agg(VectorAggDef *agg, Aggref *aggref, List *input_attnos)
+{
+	const VectorAggFunc *func = vector_agg_get_func(aggref, input_attnos);
+
+	if (func == NULL)
+		elog(ERROR, "unsupported aggregate in VectorAgg node");
+
+	agg->kind = func->kind;
+	agg->type = func->type;
+	agg->column = -1;
+
+	if (aggref->args != NIL)
+	{
+		Node	   *arg = (Node *) ((TargetEntry *) linitial(aggref->args))->expr;
+
+		agg->column = vector_agg_input_column(input_attnos, arg);
+		agg->typid = exprType(arg);
+	}
+
+	if (func->kind == VECTOR_AGG_HISTOGRAM)
+	{
+		agg->hist_min = DatumGetFloat8(((Const *) ((TargetEntry *) lsecond(aggref->args))->expr)->constvalue);
+		agg->hist_max = DatumGetFloat8(((Const *) ((TargetEntry *) lthird(aggref->args))->expr)->constvalue);
+		agg->hist_nbuckets = DatumGetInt32(((Const *) ((TargetEntry *) lfourth(aggref->args))->expr)->constvalue);
+	}
+}
+
+/*
+ * A child is read in batches if it is a DecompressChunk node that returns the
+ * input columns as they are. Returns the chunk attribute number of each input
+ * column, or NULL if the child has to be read row by row.
+ */
+static AttrNumber *
+vector_agg_batch_attnos(Plan *plan, int ncolumns)
+{
+	AttrNumber *attnos;
+	ListCell   *lc;
+	int			i = 0;
+
+	if (!is_decompress_chunk_plan(plan) || plan->qual != NIL ||
+		list_length(plan->targetlist) != ncolumns)
+		return NULL;
+
+	attnos = palloc(sizeof(AttrNumber) * ncolumns);
+
+	foreach(lc, plan->targetlist)
+	{
+		TargetEntry *tle = lfirst(lc);
+
+		if (!IsA(tle->expr, Var))
+			return NULL;
+
+		attnos[i++] = ((Var *) tle->expr)->varattno;
+	}
+
+	return attnos;
+}
+
+static void
+vector_agg_reset(VectorAggState *state)
+{
+	HASHCTL		ctl;
+
+	MemoryContextReset(state->agg_context);
+
+	memset(&ctl, 0, sizeof(ctl));
+	ctl.keysize = sizeof(uint32);
+	ctl.entrysize = sizeof(VectorAggHashEntry);
+	ctl.hcxt = state->agg_context;
+
+	state->group_htab = hash_create("VectorAgg groups", 256, &ctl,
+									HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
+	state->groups = NIL;
+	state->next_group = NULL;
+	state->last_group = NULL;
+	state->aggregated = false;
+}
+
+static inline int64
+vector_agg_bucket(int64 timestamp, int64 period)
+{
+	int64		result;
+
+	if (TIMESTAMP_NOT_FINITE(timestamp))
+		return timestamp;
+
+	/* Round towards minus infinity, like time_bucket() */
+	result = timestamp / period;
+
+	if (timestamp - result * period < 0)
+		result--;
+
+	return result * period;
+}
+
+static inline void
+vector_agg_key_value(VectorAggState *state, VectorAggKey *key, int row, Datum *value, bool *isnull)
+{
+	VectorAggColumn *column = &state->columns[key->column];
+	int			i = column->constant ? 0 : row;
+
+	*isnull = column->nulls[i];
+	*value = column->values[i];
+
+	if (key->bucket && !*isnull)
+		*value = Int64GetDatum(vector_agg_bucket(DatumGetInt64(*value), key->period));
+}
+
+/*
+ * Check if two rows have the same grouping key. Binary equality is enough to
+ * split runs, since equal keys that differ in binary are merged by the group
+ * lookup.
+ */
+static inline bool
+vector_agg_same_keys(VectorAggState *state, int a, int b)
+{
+	int			i;
+
+	for (i = 0; i < state->nkeys; i++)
+	{
+		VectorAggKey *key = &state->keys[i];
+		VectorAggColumn *column = &state->columns[key->column];
+
+		if (column->constant)
+			continue;
+
+		if (column->nulls[a] != column->nulls[b])
+			return false;
+
+		if (column->nulls[a])
+			continue;
+
+		if (key->bucket)
+		{
+			if (vector_agg_bucket(DatumGetInt64(column->values[a]), key->period) !=
+				vector_agg_bucket(DatumGetInt64(column->values[b]), key->period))
+				return false;
+		}
+		else if (!datumIsEqual(column->values[a], column->values[b], key->typbyval, key->typlen))
+			return false;
+	}
+
+	return true;
+}
+
+static bool
+vector_agg_group_has_key(VectorAggState *state, VectorAggGroup *group, bool binary)
+{
+	int			i;
+
+	for (i = 0; i < state->nkeys; i++)
+	{
+		VectorAggKey *key = &state->keys[i];
+
+		if (group->key_nulls[i] != state->key_nulls[i])
+			return false;
+
+		if (group->key_nulls[i])
+			continue;
+
+		if (binary)
+		{
+			if (!datumIsEqual(group->key_values[i], state->key_values[i], key->typbyval, key->typlen))
+				return false;
+		}
+		else if (!DatumGetBool(FunctionCall2Coll(key->eq_fn, key->collation,
+												 group->key_values[i], state->key_values[i])))
+			return false;
+	}
+
+	return true;
+}
+
+static VectorAggGroup *
+vector_agg_group_create(VectorAggState *state)
+{
+	MemoryContext old = MemoryContextSwitchTo(state->agg_context);
+	VectorAggGroup *group;
+	int			i;
+
+	group = palloc0(offsetof(VectorAggGroup, trans) + sizeof(VectorAggTrans) * state->naggs);
+	group->key_values = palloc(sizeof(Datum) * Max(state->nkeys, 1));
+	group->key_nulls = palloc(sizeof(bool) * Max(state->nkeys, 1));
+
+	for (i = 0; i < state->nkeys; i++)
+	{
+		group->key_nulls[i] = state->key_nulls[i];
+		group->key_values[i] = state->key_nulls[i] ? (Datum) 0 :
+			datumCopy(state->key_values[i], state->keys[i].typbyval, state->keys[i].typlen);
+	}
+
+	for (i = 0; i < state->naggs; i++)
+		if (state->aggs[i].kind == VECTOR_AGG_SUM)
+		{
+			group->trans[i].fsum = FLOAT_SUM_IDENTITY;
+			group->trans[i].f4sum = FLOAT_SUM_IDENTITY;
+		}
+
+	state->groups = lappend(state->groups, group);
+	MemoryContextSwitchTo(old);
+
+	return group;
+}
+
+/*
+ * Find the group of a row, creating it if it does not exist yet.
+ */
+static VectorAggGroup *
+vector_agg_lookup_group(VectorAggState *state, int row)
+{
+	VectorAggHashEntry *entry;
+	VectorAggGroup *group;
+	MemoryContext old;
+	ListCell   *lc;
+	uint32		hash = 0;
+	bool		found;
+	int			i;
+
+	for (i = 0; i < state->nkeys; i++)
+		vector_agg_key_value(state, &state->keys[i], row, &state->key_values[i], &state->key_nulls[i]);
+
+	/* Consecutive runs often belong to the same group */
+	if (state->last_group != NULL && vector_agg_group_has_key(state, state->last_group, true))
+		return state->last_group;
+
+	for (i = 0; i < state->nkeys; i++)
+	{
+		hash = (hash << 1) | (hash >> 31);
+
+		if (!state->key_nulls[i])
+			hash ^= DatumGetUInt32(FunctionCall1Coll(state->keys[i].hash_fn,
+													 state->keys[i].collation,
+													 state->key_values[i]));
+	}
+
+	entry = hash_search(state->group_htab, &hash, HASH_ENTER, &found);
+
+	if (!found)
+		entry->groups = NIL;
+
+	foreach(lc, entry->groups)
+	{
+		group = lfirst(lc);
+
+		if (vector_agg_group_has_key(state, group, false))
+		{
+			state->last_group = group;
+			return group;
+		}
+	}
+
+	group = vector_agg_group_create(state);
+	old = MemoryContextSwitchTo(state->agg_context);
+	entry->groups = lappend(entry->groups, group);
+	MemoryContextSwitchTo(old);
+	state->last_group = group;
+
+	return group;
+}
+
+/*
+ * Report the overflow of a float sum, unless the sum is infinite because one
+ * of the summed values is, like float8pl() and float8_accum().
+ */
+static void
+vector_agg_check_overflow(VectorAggDef *agg, VectorAggTrans *trans, VectorAggColumn *column, int start, int end)
+{
+	int			i;
+
+	for (i = start; i < end; i++)
+	{
+		int			row = column->constant ? 0 : i;
+		double		value;
+
+		if (column->nulls[row])
+			continue;
+
+		value = agg->type == VECTOR_VALUE_FLOAT4 ?
+			DatumGetFloat4(column->values[row]) : DatumGetFloat8(column->values[row]);
+
+		if (isinf(value))
+		{
+			trans->saw_inf = true;
+			return;
+		}
+	}
+
+	ereport(ERROR,
+			(errcode(ERRCODE_NUMERIC_VALUE_OUT_OF_RANGE),
+			 errmsg("value out of range: overflow")));
+}
+
+static Histogram *
+vector_agg_histogram(VectorAggState *state, VectorAggDef *agg, VectorAggTrans *trans)
+{
+	if (trans->hist == NULL)
+	{
+		histogram_check_args(agg->hist_min, agg->hist_max, agg->hist_nbuckets);
+		trans->hist = histogram_create(state->agg_context, agg->hist_nbuckets,
+									   agg->hist_min, agg->hist_max);
+	}
+
+	return trans->hist;
+}
+
+static void
+vector_agg_accum_sum(VectorAggDef *agg, VectorAggTrans *trans, VectorAggColumn *column, int start, int end)
+{
+	Datum	   *values = column->values;
+	bool	   *nulls = column->nulls;
+	int64		count = 0;
+	int			i;
+
+	switch (agg->type)
+	{
+		case VECTOR_VALUE_INT2:
+			{
+				int64		sum = 0;
+
+				for (i = start; i < end; i++)
+				{
+					sum += nulls[i] ? 0 : DatumGetInt16(values[i]);
+					count += !nulls[i];
+				}
+				trans->isum += sum;
+				break;
+			}
+		case VECTOR_VALUE_INT4:
+			{
+				int64		sum = 0;
+
+				for (i = start; i < end; i++)
+				{
+					sum += nulls[i] ? 0 : DatumGetInt32(values[i]);
+					count += !nulls[i];
+				}
+				trans->isum += sum;
+				break;
+			}
+		case VECTOR_VALUE_FLOAT4:
+			if (agg->kind == VECTOR_AGG_SUM)
+			{
+				/* sum(float4) adds in float4 precision */
+				float4		sum = trans->f4sum;
+
+				for (i = start; i < end; i++)
+				{
+					sum += nulls[i] ? (float4) FLOAT_SUM_IDENTITY : DatumGetFloat4(values[i]);
+					count += !nulls[i];
+				}
+				trans->f4sum = sum;
+
+				if (isinf(sum) && !trans->saw_inf)
+					vector_agg_check_overflow(agg, trans, column, start, end);
+			}
+			else
+			{
+				double		sum = trans->fsum;
+
+				for (i = start; i < end; i++)
+				{
+					sum += nulls[i] ? FLOAT_SUM_IDENTITY : DatumGetFloat4(values[i]);
+					count += !nulls[i];
+				}
+				trans->fsum = sum;
+
+				if (isinf(sum) && !trans->saw_inf)
+					vector_agg_check_overflow(agg, trans, column, start, end);
+			}
+			break;
+		case VECTOR_VALUE_FLOAT8:
+			{
+				double		sum = trans->fsum;
+
+				for (i = start; i < end; i++)
+				{
+					sum += nulls[i] ? FLOAT_SUM_IDENTITY : DatumGetFloat8(values[i]);
+					count += !nulls[i];
+				}
+				trans->fsum = sum;
+
+				if (isinf(sum) && !trans->saw_inf)
+					vector_agg_check_overflow(agg, trans, column, start, end);
+				break;
+			}
+		default:
+			elog(ERROR, "unexpected value type %d for sum in VectorAgg node", agg->type);
+	}
+
+	trans->count += count;
+}
+
+#define INT_LT(a, b) ((a) < (b))
+#define INT_GT(a, b) ((a) > (b))
+/* NaN sorts after all other values, like in float8_cmp_internal() */
+#define FLOAT_LT(a, b) (!isnan(a) && (isnan(b) || (a) < (b)))
+#define FLOAT_GT(a, b) (!isnan(b) && (isnan(a) || (a) > (b)))
+
+#define MINMAX_LOOP(acc, GETVALUE, BETTER) \
+	do \
+	{ \
+		for (i = start; i < end; i++) \
+		{ \
+			if (nulls[i]) \
+				continue; \
+			if (count == 0 || BETTER(GETVALUE(values[i]), acc)) \
+				acc = GETVALUE(values[i]); \
+			count++; \
+		} \
+	} while (0)
+
+#define DatumGetFloat4AsFloat8(d) ((double) DatumGetFloat4(d))
+
+static void
+vector_agg_accum_minmax(VectorAggDef *agg, VectorAggTrans *trans, VectorAggColumn *column, int start, int end)
+{
+	Datum	   *values = column->values;
+	bool	   *nulls = column->nulls;
+	int64		count = trans->count;
+	int64		iacc = trans->isum;
+	double		facc = trans->fsum;
+	bool		min = agg->kind == VECTOR_AGG_MIN;
+	int			i;
+
+	switch (agg->type)
+	{
+		case VECTOR_VALUE_INT2:
+			if (min)
+				MINMAX_LOOP(iacc, DatumGetInt16, INT_LT);
+			else
+				MINMAX_LOOP(iacc, DatumGetInt16, INT_GT);
+			break;
+		case VECTOR_VALUE_INT4:
+			if (min)
+				MINMAX_LOOP(iacc, DatumGetInt32, INT_LT);
+			else
+				MINMAX_LOOP(iacc, DatumGetInt32, INT_GT);
+			break;
+		case VECTOR_VALUE_INT8:
+			if (min)
+				MINMAX_LOOP(iacc, DatumGetInt64, INT_LT);
+			else
+				MINMAX_LOOP(iacc, DatumGetInt64, INT_GT);
+			break;
+		case VECTOR_VALUE_FLOAT4:
+			if (min)
+				MINMAX_LOOP(facc, DatumGetFloat4AsFloat8, FLOAT_LT);
+			else
+				MINMAX_LOOP(facc, DatumGetFloat4AsFloat8, FLOAT_GT);
+			break;
+		case VECTOR_VALUE_FLOAT8:
+			if (min)
+				MINMAX_LOOP(facc, DatumGetFloat8, FLOAT_LT);
+			else
+				MINMAX_LOOP(facc, DatumGetFloat8, FLOAT_GT);
+			break;
+		default:
+			elog(ERROR, "unexpected value type %d for min/max in VectorAgg node", agg->type);
+	}
+
+	trans->count = count;
+	trans->isum = iacc;
+	trans->fsum = facc;
+}
+
+/*
+ * Aggregate a non-NULL value that holds for n rows.
+ */
+static void
+vector_agg_accum_const(VectorAggState *state, VectorAggDef *agg, VectorAggTrans *trans,
+					   VectorAggColumn *column, int64 n)
+{
+	Datum		value = column->values[0];
+	int64		i;
+
+	switch (agg->kind)
+	{
+		case VECTOR_AGG_COUNT_STAR:
+		case VECTOR_AGG_COUNT:
+			trans->count += n;
+			break;
+		case VECTOR_AGG_SUM:
+		case VECTOR_AGG_AVG:
+			switch (agg->type)
+			{
+				case VECTOR_VALUE_INT2:
+					trans->isum += DatumGetInt16(value) * n;
+					break;
+				case VECTOR_VALUE_INT4:
+					trans->isum += DatumGetInt32(value) * n;
+					break;
+				case VECTOR_VALUE_FLOAT4:
+					/* Float sums are order dependent, so add the value n times */
+					if (agg->kind == VECTOR_AGG_SUM)
+						for (i = 0; i < n; i++)
+							trans->f4sum += DatumGetFloat4(value);
+					else
+						for (i = 0; i < n; i++)
+							trans->fsum += DatumGetFloat4(value);
+					break;
+				case VECTOR_VALUE_FLOAT8:
+					for (i = 0; i < n; i++)
+						trans->fsum += DatumGetFloat8(value);
+					break;
+				default:
+					elog(ERROR, "unexpected value type %d for sum in VectorAgg node", agg->type);
+			}
+
+			if (agg->type == VECTOR_VALUE_FLOAT4 || agg->type == VECTOR_VALUE_FLOAT8)
+			{
+				double		sum = (agg->kind == VECTOR_AGG_SUM && agg->type == VECTOR_VALUE_FLOAT4) ?
+				trans->f4sum : trans->fsum;
+
+				if (isinf(sum) && !trans->saw_inf)
+					vector_agg_check_overflow(agg, trans, column, 0, 1);
+			}
+
+			trans->count += n;
+			break;
+		case VECTOR_AGG_MIN:
+		case VECTOR_AGG_MAX:
+			vector_agg_accum_minmax(agg, trans, column, 0, 1);
+			trans->count += n - 1;
+			break;
+		case VECTOR_AGG_HISTOGRAM:
+			{
+				Histogram  *hist = vector_agg_histogram(state, agg, trans);
+
+				hist->counts[histogram_bucket(hist, DatumGetFloat8(value))] += n;
+				trans->count += n;
+				break;
+			}
+	}
+}
+
+/*
+ * Aggregate the rows [start, end) of the current input into a group.
+ */
+static void
+vector_agg_accum(VectorAggState *state, VectorAggDef *agg, VectorAggTrans *trans, int start, int end)
+{
+	VectorAggColumn *column;
+	int			i;
+
+	if (agg->kind == VECTOR_AGG_COUNT_STAR)
+	{
+		trans->count += end - start;
+		return;
+	}
+
+	column = &state->columns[agg->column];
+
+	if (column->constant)
+	{
+		if (!column->nulls[0])
+			vector_agg_accum_const(state, agg, trans, column, end - start);
+		return;
+	}
+
+	switch (agg->kind)
+	{
+		case VECTOR_AGG_COUNT:
+			{
+				int64		count = 0;
+
+				for (i = start; i < end; i++)
+					count += !column->nulls[i];
+				trans->count += count;
+				break;
+			}
+		case VECTOR_AGG_SUM:
+		case VECTOR_AGG_AVG:
+			vector_agg_accum_sum(agg, trans, column, start, end);
+			break;
+		case VECTOR_AGG_MIN:
+		case VECTOR_AGG_MAX:
+			vector_agg_accum_minmax(agg, trans, column, start, end);
+			break;
+		case VECTOR_AGG_HISTOGRAM:
+			{
+				Histogram  *hist = vector_agg_histogram(state, agg, trans);
+				int64		count = 0;
+
+				/* Like hist_sfunc(), skip NULL values */
+				for (i = start; i < end; i++)
+				{
+					if (column->nulls[i])
+						continue;
+
+					hist->counts[histogram_bucket(hist, DatumGetFloat8(column->values[i]))]++;
+					count++;
+				}
+				trans->count += count;
+				break;
+			}
+		case VECTOR_AGG_COUNT_STAR:
+			break;
+	}
+}
+
+static void
+vector_agg_process_run(VectorAggState *state, int start, int end)
+{
+	VectorAggGroup *group = vector_agg_lookup_group(state, start);
+	int			i;
+
+	for (i = 0; i < state->naggs; i++)
+		vector_agg_accum(state, &state->aggs[i], &group->trans[i], start, end);
+}
+
+/*
+ * Aggregate a batch of rows by splitting it into runs of rows with the same
+ * grouping key.
+ */
+static void
+vector_agg_process_batch(VectorAggState *state, int nrows)
+{
+	int			start = 0;
+	int			end;
+
+	while (start < nrows)
+	{
+		for (end = start + 1; end < nrows; end++)
+			if (!vector_agg_same_keys(state, start, end))
+				break;
+
+		vector_agg_process_run(state, start, end);
+		start = end;
+	}
+}
+
+static void
+vector_agg_consume_batches(VectorAggState *state, DecompressChunkState *dcs, AttrNumber *attnos)
+{
+	ExprContext *econtext = state->csstate.ss.ps.ps_ExprContext;
+	int			i;
+
+	while (decompress_chunk_next_batch(dcs))
+	{
+		for (i = 0; i < state->ncolumns; i++)
+		{
+			DecompressedColumn *batch = &dcs->batch[attnos[i] - 1];
+			VectorAggColumn *column = &state->columns[i];
+
+			if (batch->num_rows == 0)
+			{
+				column->values = &null_value;
+				column->nulls = &null_isnull;
+				column->constant = true;
+			}
+			else
+			{
+				column->values = batch->values;
+				column->nulls = batch->nulls;
+				column->constant = batch->num_rows == 1;
+			}
+		}
+
+		vector_agg_process_batch(state, dcs->batch_rows);
+		dcs->batch_row = dcs->batch_rows;
+		ResetExprContext(econtext);
+		CHECK_FOR_INTERRUPTS();
+	}
+}
+
+static void
+vector_agg_consume_rows(VectorAggState *state, PlanState *child)
+{
+	ExprContext *econtext = state->csstate.ss.ps.ps_ExprContext;
+	int			i;
+
+	for (;;)
+	{
+		TupleTableSlot *slot = ExecProcNode(child);
+
+		if (TupIsNull(slot))
+			break;
+
+		slot_getallattrs(slot);
+
+		for (i = 0; i < state->ncolumns; i++)
+		{
+			state->columns[i].values = &slot->tts_values[i];
+			state->columns[i].nulls = &slot->tts_isnull[i];
+			state->columns[i].constant = true;
+		}
+
+		vector_agg_process_run(state, 0, 1);
+		ResetExprContext(econtext);
+	}
+}
+
+/*
+ * Aggregate the rows of a chunk from its statistics. The aggregates are
+ * count(*) or count, min or max of the time column, which is NOT NULL.
+ */
+static void
+vector_agg_consume_stats(VectorAggState *state, ChunkStats *stats)
+{
+	VectorAggGroup *group = vector_agg_lookup_group(state, 0);
+	int			i;
+
+	if (stats->row_count == 0)
+		return;
+
+	for (i = 0; i < state->naggs; i++)
+	{
+		VectorAggDef *agg = &state->aggs[i];
+		Datum		value = (Datum) 0;
+		bool		isnull = false;
+		VectorAggColumn column = {
+			.values = &value,
+			.nulls = &isnull,
+			.constant = true,
+		};
+
+		if (agg->kind == VECTOR_AGG_MIN)
+			value = internal_to_time_value(stats->min_time, agg->typid);
+		else if (agg->kind == VECTOR_AGG_MAX)
+			value = internal_to_time_value(stats->max_time, agg->typid);
+
+		vector_agg_accum_const(state, agg, &group->trans[i], &column, stats->row_count);
+	}
+}
+
+static void
+vector_agg_consume(VectorAggState *state)
+{
+	ExprContext *econtext = state->csstate.ss.ps.ps_ExprContext;
+	MemoryContext old = MemoryContextSwitchTo(econtext->ecxt_per_tuple_memory);
+	ListCell   *lc;
+	int			i = 0;
+
+	/* Without grouping keys there is a result even without input rows */
+	if (state->nkeys == 0)
+		vector_agg_lookup_group(state, 0);
+
+	foreach(lc, state->csstate.custom_ps)
+	{
+		PlanState  *child = lfirst(lc);
+		AttrNumber *attnos = state->batch_attnos[i];
+		ChunkStats *stats = state->chunk_stats[i++];
+
+		if (stats != NULL)
+			vector_agg_consume_stats(state, stats);
+		else if (attnos != NULL)
+			vector_agg_consume_batches(state, (DecompressChunkState *) child, attnos);
+		else
+			vector_agg_consume_rows(state, child);
+	}
+
+	MemoryContextSwitchTo(old);
+}
+
+static Datum
+vector_agg_final(VectorAggDef *agg, VectorAggTrans *trans, bool *isnull)
+{
+	*isnull = false;
+
+	if (agg->kind == VECTOR_AGG_COUNT_STAR || agg->kind == VECTOR_AGG_COUNT)
+		return Int64GetDatum(trans->count);
+
+	if (trans->count == 0)
+	{
+		*isnull = true;
+		return (Datum) 0;
+	}
+
+	switch (agg->kind)
+	{
+		case VECTOR_AGG_SUM:
+			switch (agg->type)
+			{
+				case VECTOR_VALUE_FLOAT4:
+					return Float4GetDatum(trans->f4sum);
+				case VECTOR_VALUE_FLOAT8:
+					return Float8GetDatum(trans->fsum);
+				default:
+					return Int64GetDatum(trans->isum);
+			}
+		case VECTOR_AGG_AVG:
+			if (agg->type == VECTOR_VALUE_FLOAT4 || agg->type == VECTOR_VALUE_FLOAT8)
+				return Float8GetDatum(trans->fsum / (double) trans->count);
+
+			return DirectFunctionCall2(numeric_div,
+									   DirectFunctionCall1(int8_numeric, Int64GetDatum(trans->isum)),
+									   DirectFunctionCall1(int8_numeric, Int64GetDatum(trans->count)));
+		case VECTOR_AGG_MIN:
+		case VECTOR_AGG_MAX:
+			switch (agg->type)
+			{
+				case VECTOR_VALUE_INT2:
+					return Int16GetDatum((int16) trans->isum);
+				case VECTOR_VALUE_INT4:
+					return Int32GetDatum((int32) trans->isum);
+				case VECTOR_VALUE_FLOAT4:
+					return Float4GetDatum((float4) trans->fsum);
+				case VECTOR_VALUE_FLOAT8:
+					return Float8GetDatum(trans->fsum);
+				default:
+					return Int64GetDatum(trans->isum);
+			}
+		case VECTOR_AGG_HISTOGRAM:
+			return PointerGetDatum(histogram_to_array(trans->hist));
+		default:
+			break;
+	}
+
+	elog(ERROR, "unexpected aggregate kind %d in VectorAgg node", agg->kind);
+	pg_unreachable();
+}
+
+static TupleTableSlot *
+vector_agg_next(ScanState *node)
+{
+	VectorAggState *state = (VectorAggState *) node;
+	TupleTableSlot *slot = node->ss_ScanTupleSlot;
+	VectorAggGroup *group;
+	MemoryContext old;
+	int			i;
+
+	if (!state->aggregated)
+	{
+		vector_agg_consume(state);
+		state->next_group = list_head(state->groups);
+		state->aggregated = true;
+	}
+
+	ExecClearTuple(slot);
+
+	if (state->next_group == NULL)
+		return slot;
+
+	group = lfirst(state->next_group);
+	state->next_group = lnext(state->next_group);
+
+	old = MemoryContextSwitchTo(node->ps.ps_ExprContext->ecxt_per_tuple_memory);
+
+	for (i = 0; i < state->nkeys; i++)
+	{
+		slot->tts_values[i] = group->key_values[i];
+		slot->tts_isnull[i] = group->key_nulls[i];
+	}
+
+	for (i = 0; i < state->naggs; i++)
+		slot->tts_values[state->nkeys + i] = vector_agg_final(&state->aggs[i], &group->trans[i],
+															  &slot->tts_isnull[state->nkeys + i]);
+
+	MemoryContextSwitchTo(old);
+
+	return ExecStoreVirtualTuple(slot);
+}
+
+static bool
+vector_agg_recheck(ScanState *node, TupleTableSlot *slot)
+{
+	return true;
+}
+
+static void
+vector_agg_begin(CustomScanState *node, EState *estate, int eflags)
+{
+	VectorAggState *state = (VectorAggState *) node;
+	CustomScan *cscan = (CustomScan *) node->ss.ps.plan;
+	List	   *input_attnos = lsecond(cscan->custom_private);
+	ListCell   *lc_id = list_head(lthird(cscan->custom_private));
+	ListCell   *lc;
+	int			i = 0;
+
+	state->nkeys = intVal(linitial(cscan->custom_private));
+	state->naggs = list_length(cscan->custom_scan_tlist) - state->nkeys;
+	state->ncolumns = list_length(input_attnos);
+	state->keys = palloc0(sizeof(VectorAggKey) * Max(state->nkeys, 1));
+	state->aggs = palloc0(sizeof(VectorAggDef) * Max(state->naggs, 1));
+	state->columns = palloc0(sizeof(VectorAggColumn) * Max(state->ncolumns, 1));
+	state->key_values = palloc(sizeof(Datum) * Max(state->nkeys, 1));
+	state->key_nulls = palloc(sizeof(bool) * Max(state->nkeys, 1));
+
+	foreach(lc, cscan->custom_scan_tlist)
+	{
+		Expr	   *expr = ((TargetEntry *) lfirst(lc))->expr;
+
+		if (i < state->nkeys)
+			vector_agg_init_key(&state->keys[i], expr, input_attnos);
+		else
+			vector_agg_init_agg(&state->aggs[i - state->nkeys], (Aggref *) expr, input_attnos);
+		i++;
+	}
+
+	state->batch_attnos = palloc0(sizeof(AttrNumber *) * Max(list_length(cscan->custom_plans), 1));
+	state->chunk_stats = palloc0(sizeof(ChunkStats *) * Max(list_length(cscan->custom_plans), 1));
+	i = 0;
+
+	foreach(lc, cscan->custom_plans)
+	{
+		Plan	   *plan = lfirst(lc);
+
+		node->custom_ps = lappend(node->custom_ps, ExecInitNode(plan, estate, eflags));
+		state->batch_attnos[i] = vector_agg_batch_attnos(plan, state->ncolumns);
+
+		/*
+		 * The statistics are read with the query's snapshot, since they might
+		 * have been recorded or removed after planning
+		 */
+		if (lc_id != NULL)
+		{
+			int32		chunk_id = lfirst_int(lc_id);
+			ChunkStats	stats;
+
+			if (chunk_id > 0 && chunk_stats_get(chunk_id, estate->es_snapshot, &stats))
+			{
+				state->chunk_stats[i] = palloc(sizeof(ChunkStats));
+				*state->chunk_stats[i] = stats;
+				state->num_stats_children++;
+			}
+
+			lc_id = lnext(lc_id);
+		}
+
+		i++;
+	}
+
+	state->agg_context = AllocSetContextCreate(CurrentMemoryContext,
+											   "VectorAgg",
+											   ALLOCSET_DEFAULT_SIZES);
+	vector_agg_reset(state);
+}
+
+static TupleTableSlot *
+vector_agg_exec(CustomScanState *node)
+{
+	return ExecScan(&node->ss, vector_agg_next, vector_agg_recheck);
+}
+
+static void
+vector_agg_end(CustomScanState *node)
+{
+	VectorAggState *state = (VectorAggState *) node;
+	ListCell   *lc;
+
+	foreach(lc, node->custom_ps)
+		ExecEndNode(lfirst(lc));
+
+	MemoryContextDelete(state->agg_context);
+}
+
+static void
+vector_agg_rescan(CustomScanState *node)
+{
+	ListCell   *lc;
+
+	ExecScanReScan(&node->ss);
+
+	foreach(lc, node->custom_ps)
+	{
+		PlanState  *child = lfirst(lc);
+
+		if (node->ss.ps.chgParam != NULL)
+			UpdateChangedParamSet(child, node->ss.ps.chgParam);
+
+		ExecReScan(child);
+	}
+
+	vector_agg_reset((VectorAggState *) node);
+}
+
+static void
+vector_agg_explain(CustomScanState *node, List *ancestors, ExplainState *es)
+{
+	VectorAggState *state = (VectorAggState *) node;
+
+	if (state->num_stats_children > 0)
+		ExplainPropertyInteger("Chunks answered from statistics", state->num_stats_children, es);
+}
+
+static CustomExecMethods vector_agg_state_methods = {
+	.CustomName = "VectorAgg",
+	.BeginCustomScan = vector_agg_begin,
+	.ExecCustomScan = vector_agg_exec,
+	.EndCustomScan = vector_agg_end,
+	.ReScanCustomScan = vector_agg_rescan,
+	.ExplainCustomScan = vector_agg_explain,
+};
+
+static Node *
+vector_agg_state_create(CustomScan *cscan)
+{
+	VectorAggState *state;
+
+	state = (VectorAggState *) newNode(sizeof(VectorAggState), T_CustomScanState);
+	state->csstate.methods = &vector_agg_state_methods;
+
+	return (Node *) state;
+}
+
+static CustomScanMethods vector_agg_plan_methods = {
+	.CustomName = "VectorAgg",
+	.CreateCustomScanState = vector_agg_state_create,
+};
+
+void
+_vector_agg_init(void)
+{
+	/* Needed to (de)serialize the plan for parallel workers */
+	RegisterCustomScanMethods(&vector_agg_plan_methods);
+}
+
+void
+_vector_agg_fini(void)
+{
+}
@@ -0,0 +1,45 @@
+#ifndef TIMESCALEDB_VECTOR_AGG_H
+#define TIMESCALEDB_VECTOR_AGG_H
+
+#include <postgres.h>
+#include <nodes/execnodes.h>
+#include <nodes/extensible.h>
+#include <nodes/relation.h>
+#include <utils/hsearch.h>
+
+#include "chunk_stats.h"
+
+typedef struct VectorAggKey VectorAggKey;
+typedef struct VectorAggDef VectorAggDef;
+typedef struct VectorAggColumn VectorAggColumn;
+typedef struct VectorAggGroup VectorAggGroup;
+
+typedef struct VectorAggState
+{
+	CustomScanState csstate;
+	int			nkeys;
+	VectorAggKey *keys;
+	int			naggs;
+	VectorAggDef *aggs;
+	int			ncolumns;
+	VectorAggColumn *columns;	/* current values of the input columns */
+	AttrNumber **batch_attnos;	/* per child, the chunk attribute numbers of
+								 * the input columns, or NULL if the child is
+								 * read row by row */
+	ChunkStats **chunk_stats;	/* per child, the statistics of the chunk
+								 * that answer the aggregates over the child
+								 * instead of reading it, or NULL */
+	int			num_stats_children;
+	Datum	   *key_values;		/* grouping key of the current row */
+	bool	   *key_nulls;
+	HTAB	   *group_htab;
+	List	   *groups;			/* groups in order of creation */
+	ListCell   *next_group;
+	VectorAggGroup *last_group;
+	MemoryContext agg_context;
+	bool		aggregated;
+} VectorAggState;
+
+extern void plan_add_vector_agg(PlannerInfo *root, RelOptInfo *input_rel, RelOptInfo *group_rel);
+
+#endif							/* TIMESCALEDB_VECTOR_AGG_H */
@@ -0,0 +1,662 @@
+#include <postgres.h>
+#include <access/relscan.h>
+#include <catalog/pg_type.h>
+#include <commands/explain.h>
+#include <executor/executor.h>
+#include <miscadmin.h>
+#include <nodes/extensible.h>
+#include <nodes/nodeFuncs.h>
+#include <optimizer/clauses.h>
+#include <optimizer/cost.h>
+#include <optimizer/pathnode.h>
+#include <optimizer/restrictinfo.h>
+#include <storage/bufmgr.h>
+#include <utils/lsyscache.h>
+#include <utils/rel.h>
+#include <utils/ruleutils.h>
+#include <math.h>
+
+#include "compat.h"
+#include "chunk.h"
+#include "decompress_chunk.h"
+#include "utils.h"
+#include "vector_filter.h"
+
+/*
+ * VectorFilter scans a chunk a heap page at a time.
+ *
+ * All visible tuples of a page form a batch. The columns referenced by simple
+ * comparisons between a column and a constant (e.g., time > X or value < Y)
+ * are deformed into arrays for the whole batch, and the comparisons are
+ * evaluated with tight loops over the arrays that the compiler can vectorize.
+ * Only the tuples that pass all of them are returned, and any remaining quals
+ * are evaluated on those tuples by the regular scan machinery.
+ */
+
+/* Per-tuple cost of a vectorized comparison relative to a regular one */
+#define VECTOR_FILTER_COST_FACTOR 0.1
+
+typedef enum VectorFilterType
+{
+	VECTOR_FILTER_INT2,
+	VECTOR_FILTER_INT4,
+	VECTOR_FILTER_INT8,
+	VECTOR_FILTER_FLOAT4,
+	VECTOR_FILTER_FLOAT8,
+} VectorFilterType;
+
+typedef enum VectorFilterOp
+{
+	VECTOR_FILTER_EQ,
+	VECTOR_FILTER_NE,
+	VECTOR_FILTER_LT,
+	VECTOR_FILTER_LE,
+	VECTOR_FILTER_GT,
+	VECTOR_FILTER_GE,
+} VectorFilterOp;
+
+/* Suffixes of the comparison functions, in VectorFilterOp order */
+static const char *vector_filter_op_names[] = {"eq", "ne", "lt", "le", "gt", "ge"};
+
+/* The operator to use when the column is on the right-hand side */
+static const VectorFilterOp vector_filter_op_commutators[] = {
+	VECTOR_FILTER_EQ,
+	VECTOR_FILTER_NE,
+	VECTOR_FILTER_GT,
+	VECTOR_FILTER_GE,
+	VECTOR_FILTER_LT,
+	VECTOR_FILTER_LE,
+};
+
+struct VectorFilterQual
+{
+	AttrNumber	attno;
+	VectorFilterType type;
+	VectorFilterOp op;
+	Datum		value;
+};
+
+/*
+ * Get the prefix of the comparison functions of a column type, and how the
+ * values of the type are compared. Returns NULL if the type is not
+ * supported.
+ */
+static const char *
+vector_filter_type_prefix(Oid typid, VectorFilterType *type)
+{
+	switch (typid)
+	{
+		case INT2OID:
+			*type = VECTOR_FILTER_INT2;
+			return "int2";
+		case INT4OID:
+			*type = VECTOR_FILTER_INT4;
+			return "int4";
+		case INT8OID:
+			*type = VECTOR_FILTER_INT8;
+			return "int8";
+		case FLOAT4OID:
+			*type = VECTOR_FILTER_FLOAT4;
+			return "float4";
+		case FLOAT8OID:
+			*type = VECTOR_FILTER_FLOAT8;
+			return "float8";
+		case DATEOID:
+			*type = VECTOR_FILTER_INT4;
+			return "date_";
+#ifdef HAVE_INT64_TIMESTAMP
+		case TIMESTAMPOID:
+		case TIMESTAMPTZOID:
+			/* timestamptz operators use the timestamp functions */
+			*type = VECTOR_FILTER_INT8;
+			return "timestamp_";
+#endif
+		default:
+			return NULL;
+	}
+}
+
+/*
+ * Check if a clause compares a column of the scanned relation with a
+ * constant using a builtin comparison operator of the column's type, and
+ * fill in the qual if it does.
+ */
+static bool
+vector_filter_qual_init(VectorFilterQual *qual, Expr *clause, Index relid)
+{
+	OpExpr	   *op;
+	Var		   *var;
+	Const	   *value;
+	bool		commuted = false;
+	const char *prefix;
+	Oid			funcid;
+	int			i;
+
+	if (!IsA(clause, OpExpr) || list_length(((OpExpr *) clause)->args) != 2)
+		return false;
+
+	op = (OpExpr *) clause;
+
+	if (IsA(linitial(op->args), Var) && IsA(lsecond(op->args), Const))
+	{
+		var = linitial(op->args);
+		value = lsecond(op->args);
+	}
+	else if (IsA(linitial(op->args), Const) && IsA(lsecond(op->args), Var))
+	{
+		value = linitial(op->args);
+		var = lsecond(op->args);
+		commuted = true;
+	}
+	else
+		return false;
+
+	if (var->varno != relid || var->varattno <= 0 || var->varlevelsup != 0 ||
+		value->constisnull || var->vartype != value->consttype)
+		return false;
+
+	prefix = vector_filter_type_prefix(var->vartype, &qual->type);
+
+	if (prefix == NULL)
+		return false;
+
+	funcid = get_opcode(op->opno);
+
+	for (i = 0; i < lengthof(vector_filter_op_names); i++)
+	{
+		char		symbol[NAMEDATALEN];
+
+		snprintf(symbol, NAMEDATALEN, "%s%s", prefix, vector_filter_op_names[i]);
+
+		if (function_has_symbol(funcid, symbol))
+		{
+			qual->attno = var->varattno;
+			qual->op = commuted ? vector_filter_op_commutators[i] : (VectorFilterOp) i;
+			qual->value = value->constvalue;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+#define FILTER_LOOP(TYPE, GETVALUE, COND) \
+	for (i = 0; i < nrows; i++) \
+	{ \
+		TYPE		v = GETVALUE(values[i]); \
+		selected[i] = selected[i] & !nulls[i] & (COND); \
+	}
+
+#define FILTER_KERNEL(TYPE, GETVALUE) \
+	do \
+	{ \
+		TYPE		c = GETVALUE(qual->value); \
+		switch (qual->op) \
+		{ \
+			case VECTOR_FILTER_EQ: \
+				FILTER_LOOP(TYPE, GETVALUE, v == c); \
+				break; \
+			case VECTOR_FILTER_NE: \
+				FILTER_LOOP(TYPE, GETVALUE, v != c); \
+				break; \
+			case VECTOR_FILTER_LT: \
+				FILTER_LOOP(TYPE, GETVALUE, v < c); \
+				break; \
+			case VECTOR_FILTER_LE: \
+				FILTER_LOOP(TYPE, GETVALUE, v <= c); \
+				break; \
+			case VECTOR_FILTER_GT: \
+				FILTER_LOOP(TYPE, GETVALUE, v > c); \
+				break; \
+			case VECTOR_FILTER_GE: \
+				FILTER_LOOP(TYPE, GETVALUE, v >= c); \
+				break; \
+		} \
+	} while (0)
+
+/*
+ * Floats compare like in float8_cmp_internal(): NaN equals NaN and is larger
+ * than any other value.
+ */
+#define FLOAT_FILTER_KERNEL(TYPE, GETVALUE) \
+	do \
+	{ \
+		TYPE		c = GETVALUE(qual->value); \
+		if (isnan(c)) \
+		{ \
+			switch (qual->op) \
+			{ \
+				case VECTOR_FILTER_EQ: \
+				case VECTOR_FILTER_GE: \
+					FILTER_LOOP(TYPE, GETVALUE, isnan(v) != 0); \
+					break; \
+				case VECTOR_FILTER_NE: \
+				case VECTOR_FILTER_LT: \
+					FILTER_LOOP(TYPE, GETVALUE, isnan(v) == 0); \
+					break; \
+				case VECTOR_FILTER_LE: \
+					for (i = 0; i < nrows; i++) \
+						selected[i] = selected[i] & !nulls[i]; \
+					break; \
+				case VECTOR_FILTER_GT: \
+					memset(selected, false, sizeof(bool) * nrows); \
+					break; \
+			} \
+		} \
+		else \
+		{ \
+			switch (qual->op) \
+			{ \
+				case VECTOR_FILTER_EQ: \
+					FILTER_LOOP(TYPE, GETVALUE, v == c); \
+					break; \
+				case VECTOR_FILTER_NE: \
+					FILTER_LOOP(TYPE, GETVALUE, v != c); \
+					break; \
+				case VECTOR_FILTER_LT: \
+					FILTER_LOOP(TYPE, GETVALUE, v < c); \
+					break; \
+				case VECTOR_FILTER_LE: \
+					FILTER_LOOP(TYPE, GETVALUE, v <= c); \
+					break; \
+				case VECTOR_FILTER_GT: \
+					FILTER_LOOP(TYPE, GETVALUE, v > c || isnan(v)); \
+					break; \
+				case VECTOR_FILTER_GE: \
+					FILTER_LOOP(TYPE, GETVALUE, v >= c || isnan(v)); \
+					break; \
+			} \
+		} \
+	} while (0)
+
+/*
+ * Clear the rows that do not pass a qual from the selection. The values of
+ * NULL rows must be valid Datums of the column type.
+ */
+static void
+vector_filter_kernel(VectorFilterQual *qual, Datum *values, bool *nulls, bool *selected, int nrows)
+{
+	int			i;
+
+	switch (qual->type)
+	{
+		case VECTOR_FILTER_INT2:
+			FILTER_KERNEL(int16, DatumGetInt16);
+			break;
+		case VECTOR_FILTER_INT4:
+			FILTER_KERNEL(int32, DatumGetInt32);
+			break;
+		case VECTOR_FILTER_INT8:
+			FILTER_KERNEL(int64, DatumGetInt64);
+			break;
+		case VECTOR_FILTER_FLOAT4:
+			FLOAT_FILTER_KERNEL(float4, DatumGetFloat4);
+			break;
+		case VECTOR_FILTER_FLOAT8:
+			FLOAT_FILTER_KERNEL(float8, DatumGetFloat8);
+			break;
+	}
+}
+
+static void
+vector_filter_release_batch(VectorFilterState *state)
+{
+	if (BufferIsValid(state->batch_buffer))
+		ReleaseBuffer(state->batch_buffer);
+
+	state->batch_buffer = InvalidBuffer;
+	state->batch_rows = 0;
+	state->batch_row = 0;
+}
+
+/*
+ * Read the visible tuples of the next heap page. The tuples point into the
+ * page, which stays pinned until the next batch is read.
+ */
+static bool
+vector_filter_next_batch(VectorFilterState *state)
+{
+	EState	   *estate = state->csstate.ss.ps.state;
+	HeapTuple	tuple;
+	BlockNumber block;
+
+	vector_filter_release_batch(state);
+
+	if (NULL == state->scan)
+		state->scan = heap_beginscan(state->csstate.ss.ss_currentRelation,
+									 estate->es_snapshot, 0, NULL);
+
+	if (state->has_pending)
+	{
+		state->batch[0] = state->pending;
+		state->has_pending = false;
+	}
+	else
+	{
+		/* a finished heap scan would start over */
+		if (state->done)
+			return false;
+
+		tuple = heap_getnext(state->scan, ForwardScanDirection);
+
+		if (NULL == tuple)
+		{
+			state->done = true;
+			return false;
+		}
+
+		state->batch[0] = *tuple;
+	}
+
+	state->batch_rows = 1;
+	state->batch_buffer = state->scan->rs_cbuf;
+	IncrBufferRefCount(state->batch_buffer);
+	block = ItemPointerGetBlockNumber(&state->batch[0].t_self);
+
+	while (NULL != (tuple = heap_getnext(state->scan, ForwardScanDirection)))
+	{
+		if (ItemPointerGetBlockNumber(&tuple->t_self) != block)
+		{
+			state->pending = *tuple;
+			state->has_pending = true;
+			return true;
+		}
+
+		state->batch[state->batch_rows++] = *tuple;
+	}
+
+	state->done = true;
+
+	return true;
+}
+
+/*
+ * Deform the qual columns of the batch and evaluate the quals.
+ */
+static void
+vector_filter_evaluate(VectorFilterState *state)
+{
+	TupleTableSlot *slot = state->batch_slot;
+	int			nrows = state->batch_rows;
+	int			i;
+	int			q;
+
+	for (i = 0; i < nrows; i++)
+	{
+		ExecStoreTuple(&state->batch[i], slot, InvalidBuffer, false);
+		slot_getsomeattrs(slot, state->max_attno);
+
+		for (q = 0; q < state->nquals; q++)
+		{
+			VectorFilterQual *qual = &state->quals[q];
+			int			index = q * MaxHeapTuplesPerPage + i;
+
+			state->nulls[index] = slot->tts_isnull[qual->attno - 1];
+			state->values[index] = state->nulls[index] ? qual->value : slot->tts_values[qual->attno - 1];
+		}
+	}
+
+	ExecClearTuple(slot);
+	memset(state->selected, true, sizeof(bool) * nrows);
+
+	for (q = 0; q < state->nquals; q++)
+		vector_filter_kernel(&state->quals[q],
+							 &state->values[q * MaxHeapTuplesPerPage],
+							 &state->nulls[q * MaxHeapTuplesPerPage],
+							 state->selected,
+							 nrows);
+}
+
+static TupleTableSlot *
+vector_filter_next(ScanState *node)
+{
+	VectorFilterState *state = (VectorFilterState *) node;
+	TupleTableSlot *slot = node->ss_ScanTupleSlot;
+
+	for (;;)
+	{
+		while (state->batch_row < state->batch_rows)
+		{
+			int			row = state->batch_row++;
+
+			if (state->selected[row])
+				return ExecStoreTuple(&state->batch[row], slot, state->batch_buffer, false);
+		}
+
+		ExecClearTuple(slot);
+
+		if (!vector_filter_next_batch(state))
+			return slot;
+
+		vector_filter_evaluate(state);
+		CHECK_FOR_INTERRUPTS();
+	}
+}
+
+/* Evaluate the quals on a single tuple, e.g., for EvalPlanQual */
+static bool
+vector_filter_recheck(ScanState *node, TupleTableSlot *slot)
+{
+	VectorFilterState *state = (VectorFilterState *) node;
+	bool		selected = true;
+	int			i;
+
+	slot_getsomeattrs(slot, state->max_attno);
+
+	for (i = 0; i < state->nquals; i++)
+	{
+		VectorFilterQual *qual = &state->quals[i];
+		bool	   *isnull = &slot->tts_isnull[qual->attno - 1];
+		Datum		value = *isnull ? qual->value : slot->tts_values[qual->attno - 1];
+
+		vector_filter_kernel(qual, &value, isnull, &selected, 1);
+	}
+
+	return selected;
+}
+
+static void
+vector_filter_begin(CustomScanState *node, EState *estate, int eflags)
+{
+	VectorFilterState *state = (VectorFilterState *) node;
+	CustomScan *cscan = (CustomScan *) node->ss.ps.plan;
+	ListCell   *lc;
+	int			i = 0;
+
+	state->nquals = list_length(cscan->custom_exprs);
+	state->quals = palloc(sizeof(VectorFilterQual) * state->nquals);
+
+	foreach(lc, cscan->custom_exprs)
+	{
+		if (!vector_filter_qual_init(&state->quals[i], lfirst(lc), cscan->scan.scanrelid))
+			elog(ERROR, "unsupported qual in VectorFilter node");
+
+		state->max_attno = Max(state->max_attno, state->quals[i].attno);
+		i++;
+	}
+
+	state->batch_slot = MakeSingleTupleTableSlot(RelationGetDescr(node->ss.ss_currentRelation));
+	state->batch_buffer = InvalidBuffer;
+	state->selected = palloc(sizeof(bool) * MaxHeapTuplesPerPage);
+	state->values = palloc(sizeof(Datum) * MaxHeapTuplesPerPage * state->nquals);
+	state->nulls = palloc(sizeof(bool) * MaxHeapTuplesPerPage * state->nquals);
+}
+
+static TupleTableSlot *
+vector_filter_exec(CustomScanState *node)
+{
+	return ExecScan(&node->ss, vector_filter_next, vector_filter_recheck);
+}
+
+static void
+vector_filter_end(CustomScanState *node)
+{
+	VectorFilterState *state = (VectorFilterState *) node;
+
+	vector_filter_release_batch(state);
+	ExecDropSingleTupleTableSlot(state->batch_slot);
+
+	if (NULL != state->scan)
+		heap_endscan(state->scan);
+}
+
+static void
+vector_filter_rescan(CustomScanState *node)
+{
+	VectorFilterState *state = (VectorFilterState *) node;
+
+	ExecScanReScan(&node->ss);
+	vector_filter_release_batch(state);
+
+	if (NULL != state->scan)
+		heap_rescan(state->scan, NULL);
+
+	state->has_pending = false;
+	state->done = false;
+}
+
+static void
+vector_filter_explain(CustomScanState *node, List *ancestors, ExplainState *es)
+{
+	CustomScan *cscan = (CustomScan *) node->ss.ps.plan;
+	List	   *context;
+	char	   *exprstr;
+
+	context = set_deparse_context_planstate(es->deparse_cxt, (Node *) node, ancestors);
+	exprstr = deparse_expression((Node *) make_ands_explicit(cscan->custom_exprs),
+								 context, es->verbose, false);
+	ExplainPropertyText("Vectorized Filter", exprstr, es);
+}
+
+static CustomExecMethods vector_filter_state_methods = {
+	.CustomName = "VectorFilter",
+	.BeginCustomScan = vector_filter_begin,
+	.ExecCustomScan = vector_filter_exec,
+	.EndCustomScan = vector_filter_end,
+	.ReScanCustomScan = vector_filter_rescan,
+	.ExplainCustomScan = vector_filter_explain,
+};
+
+static Node *
+vector_filter_state_create(CustomScan *cscan)
+{
+	VectorFilterState *state;
+
+	state = (VectorFilterState *) newNode(sizeof(VectorFilterState), T_CustomScanState);
+	state->csstate.methods = &vector_filter_state_methods;
+
+	return (Node *) state;
+}
+
+static CustomScanMethods vector_filter_plan_methods = {
+	.CustomName = "VectorFilter",
+	.CreateCustomScanState = vector_filter_state_create,
+};
+
+static Plan *
+vector_filter_plan_create(PlannerInfo *root,
+						  RelOptInfo *rel,
+						  struct CustomPath *path,
+						  List *tlist,
+						  List *clauses,
+						  List *custom_plans)
+{
+	CustomScan *cscan = makeNode(CustomScan);
+	VectorFilterQual qual;
+	ListCell   *lc;
+
+	cscan->scan.scanrelid = rel->relid;
+	cscan->scan.plan.targetlist = tlist;
+
+	/* Vectorized quals go into custom_exprs, all others are a regular filter */
+	foreach(lc, clauses)
+	{
+		RestrictInfo *rinfo = lfirst(lc);
+
+		if (rinfo->pseudoconstant)
+			continue;
+
+		if (vector_filter_qual_init(&qual, rinfo->clause, rel->relid))
+			cscan->custom_exprs = lappend(cscan->custom_exprs, rinfo->clause);
+		else
+			cscan->scan.plan.qual = lappend(cscan->scan.plan.qual, rinfo->clause);
+	}
+
+	/* Scan tuples have the row type of the chunk */
+	cscan->custom_scan_tlist = NIL;
+	cscan->custom_private = NIL;
+	cscan->flags = path->flags;
+	cscan->methods = &vector_filter_plan_methods;
+
+	return &cscan->scan.plan;
+}
+
+static CustomPathMethods vector_filter_path_methods = {
+	.CustomName = "VectorFilter",
+	.PlanCustomPath = vector_filter_plan_create,
+};
+
+/*
+ * Add a VectorFilter path to a chunk that has quals that can be vectorized.
+ */
+void
+vector_filter_add_paths(PlannerInfo *root, RelOptInfo *rel, RangeTblEntry *rte)
+{
+	CustomPath *path;
+	VectorFilterQual qual;
+	List	   *other_quals = NIL;
+	int			nquals = 0;
+	QualCost	qual_cost;
+	Cost		cpu_per_tuple;
+	ListCell   *lc;
+
+	/* compressed chunks have no tuples in their heap */
+	if (rel->pathlist != NIL && is_decompress_chunk_path(linitial(rel->pathlist)))
+		return;
+
+	foreach(lc, rel->baserestrictinfo)
+	{
+		RestrictInfo *rinfo = lfirst(lc);
+
+		if (!rinfo->pseudoconstant && vector_filter_qual_init(&qual, rinfo->clause, rel->relid))
+			nquals++;
+		else
+			other_quals = lappend(other_quals, rinfo);
+	}
+
+	if (nquals == 0 || !chunk_exists_relid(rte->relid))
+		return;
+
+	cost_qual_eval(&qual_cost, other_quals, root);
+	cpu_per_tuple = cpu_tuple_cost + qual_cost.per_tuple +
+		cpu_operator_cost * VECTOR_FILTER_COST_FACTOR * nquals;
+
+	path = (CustomPath *) newNode(sizeof(CustomPath), T_CustomPath);
+	path->path.pathtype = T_CustomScan;
+	path->path.parent = rel;
+	path->path.pathtarget = rel->reltarget;
+	path->path.param_info = NULL;
+	path->path.parallel_safe = rel->consider_parallel;
+	path->path.rows = rel->rows;
+	path->path.startup_cost = qual_cost.startup + rel->reltarget->cost.startup;
+	path->path.total_cost = path->path.startup_cost + seq_page_cost * rel->pages +
+		cpu_per_tuple * rel->tuples + rel->reltarget->cost.per_tuple * rel->rows;
+	path->path.pathkeys = NIL;
+	path->flags = 0;
+	path->custom_private = NIL;
+	path->methods = &vector_filter_path_methods;
+
+	add_path(rel, &path->path);
+}
+
+void
+_vector_filter_init(void)
+{
+	/* Needed to (de)serialize the plan for parallel workers */
+	RegisterCustomScanMethods(&vector_filter_plan_methods);
+}
+
+void
+_vector_filter_fini(void)
+{
+}
@@ -0,0 +1,35 @@
+#ifndef TIMESCALEDB_VECTOR_FILTER_H
+#define TIMESCALEDB_VECTOR_FILTER_H
+
+#include <postgres.h>
+#include <access/heapam.h>
+#include <access/htup_details.h>
+#include <nodes/execnodes.h>
+#include <nodes/extensible.h>
+#include <nodes/relation.h>
+
+typedef struct VectorFilterQual VectorFilterQual;
+
+typedef struct VectorFilterState
+{
+	CustomScanState csstate;
+	int			nquals;
+	VectorFilterQual *quals;
+	AttrNumber	max_attno;		/* highest attribute referenced by the quals */
+	HeapScanDesc scan;
+	TupleTableSlot *batch_slot; /* for deforming the tuples of a batch */
+	HeapTupleData batch[MaxHeapTuplesPerPage];	/* tuples of the current page */
+	int			batch_rows;
+	int			batch_row;
+	Buffer		batch_buffer;	/* pinned while the batch is in use */
+	bool	   *selected;		/* rows of the batch that pass the quals */
+	Datum	   *values;			/* per qual, the values of its column */
+	bool	   *nulls;
+	bool		has_pending;	/* first tuple of the next batch was read */
+	HeapTupleData pending;
+	bool		done;			/* the heap scan returned all tuples */
+} VectorFilterState;
+
+extern void vector_filter_add_paths(PlannerInfo *root, RelOptInfo *rel, RangeTblEntry *rte);
+
+#endif							/* TIMESCALEDB_VECTOR_FILTER_H */
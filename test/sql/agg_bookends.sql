@@ -14,6 +14,17 @@ SELECT last(temp, time) FROM "btest";
 SELECT first(temp, time) FROM "btest";
 SELECT last(temp, time_alt) FROM "btest";
 SELECT first(temp, time_alt) FROM "btest";
+--comparison elements of other types
+SELECT first(time, temp), last(gp, temp) FROM "btest";
+
+--sliding window frames use the moving-aggregate implementation
+SELECT gp, temp,
+       first(temp, temp) OVER w AS min_temp,
+       last(temp, temp) OVER w AS max_temp,
+       last(temp, time) OVER w AS last_temp
+FROM "btest"
+WINDOW w AS (ORDER BY time, gp ROWS BETWEEN 2 PRECEDING AND CURRENT ROW)
+ORDER BY time, gp;
 
 
 SELECT gp, last(temp, time) FROM "btest" GROUP BY gp ORDER BY gp;
@@ -42,6 +53,24 @@ SELECT last(temp, time_alt) FROM "btest";
 --cmp nulls make the group NULL but don't interfere with other groups
 SELECT gp, last(temp, time_alt) FROM "btest" GROUP BY gp ORDER BY gp;
 
+--ungrouped first/last on the time column are answered by index scans
+EXPLAIN (costs off)
+SELECT first(temp, time), last(temp, time) FROM "btest" WHERE gp = 1;
+SELECT first(temp, time), last(temp, time) FROM "btest" WHERE gp = 1;
+EXPLAIN (costs off)
+SELECT last(temp, time) FROM "btest" WHERE time < '2017-01-20T09:00:45';
+SELECT last(temp, time) FROM "btest" WHERE time < '2017-01-20T09:00:45';
+SELECT last(temp, time) FROM "btest" WHERE gp = 3;
+
+--other comparison elements and the GUC turned off aggregate all rows
+EXPLAIN (costs off)
+SELECT last(temp, time_alt) FROM "btest";
+SET timescaledb.bookend_index_scan = off;
+EXPLAIN (costs off)
+SELECT last(temp, time) FROM "btest";
+SELECT last(temp, time) FROM "btest";
+RESET timescaledb.bookend_index_scan;
+
 
 --Previously, some bugs were found with NULLS and numeric types, so test that
 CREATE TABLE btest_numeric
@@ -0,0 +1,55 @@
+CREATE TABLE quotes(time timestamp NOT NULL, symbol text, bid double precision);
+SELECT create_hypertable('quotes', 'time', chunk_time_interval => interval '1 day');
+CREATE TABLE trades(time timestamp NOT NULL, symbol text, price double precision);
+SELECT create_hypertable('trades', 'time', chunk_time_interval => interval '1 day');
+
+INSERT INTO quotes VALUES
+    ('2018-01-01 09:00', 'A', 10), ('2018-01-01 09:30', 'B', 20),
+    ('2018-01-01 12:00', 'A', 11), ('2018-01-02 09:00', 'B', 21),
+    ('2018-01-02 12:00', 'A', 12), ('2018-01-03 09:00', NULL, 99);
+INSERT INTO trades VALUES
+    ('2018-01-01 08:00', 'A', 9.5), ('2018-01-01 09:00', 'A', 10.1),
+    ('2018-01-01 15:00', 'B', 20.5), ('2018-01-02 10:00', 'A', 11.2),
+    ('2018-01-02 12:00', 'B', 21.1), ('2018-01-03 10:00', 'A', 12.3),
+    ('2018-01-03 10:00', 'C', 1), ('2018-01-03 11:00', NULL, 2);
+
+-- the chunks of both sides are read in time order from their indexes
+EXPLAIN (costs off)
+SELECT trades.time, trades.symbol, trades.price, quotes.bid
+FROM trades LEFT JOIN quotes ON quotes.symbol = trades.symbol AND asof(quotes.time, trades.time)
+ORDER BY trades.time, trades.symbol;
+
+-- every trade gets the latest quote of its symbol at or before its time
+SELECT trades.time, trades.symbol, trades.price, quotes.bid
+FROM trades LEFT JOIN quotes ON quotes.symbol = trades.symbol AND asof(quotes.time, trades.time)
+ORDER BY trades.time, trades.symbol;
+
+-- inner joins only return trades with a quote
+SELECT trades.time, trades.symbol, trades.price, quotes.bid
+FROM trades JOIN quotes ON trades.symbol = quotes.symbol AND asof(quotes.time, trades.time)
+ORDER BY trades.time, trades.symbol;
+
+-- without keys, every trade gets the latest quote of any symbol
+SELECT trades.time, trades.symbol, quotes.symbol, quotes.bid
+FROM trades LEFT JOIN quotes ON asof(quotes.time, trades.time)
+ORDER BY trades.time, trades.symbol;
+
+-- inputs without an index on time are sorted by the join
+CREATE TABLE quotes_plain AS SELECT * FROM quotes;
+EXPLAIN (costs off)
+SELECT trades.time, trades.symbol, trades.price, quotes_plain.bid
+FROM trades LEFT JOIN quotes_plain ON quotes_plain.symbol = trades.symbol AND asof(quotes_plain.time, trades.time)
+ORDER BY trades.time, trades.symbol;
+SELECT trades.time, trades.symbol, trades.price, quotes_plain.bid
+FROM trades LEFT JOIN quotes_plain ON quotes_plain.symbol = trades.symbol AND asof(quotes_plain.time, trades.time)
+ORDER BY trades.time, trades.symbol;
+
+\set ON_ERROR_STOP 0
+-- asof() cannot be evaluated on its own
+SELECT asof(time, time) FROM quotes;
+-- the joined rows of a left join are the ones of the outer side
+SELECT * FROM trades LEFT JOIN quotes ON asof(trades.time, quotes.time);
+-- left joins only support equalities of columns besides asof()
+SELECT * FROM trades LEFT JOIN quotes ON quotes.symbol = lower(trades.symbol) AND asof(quotes.time, trades.time);
+SELECT * FROM trades LEFT JOIN quotes ON asof(quotes.time, trades.time + interval '1 hour');
+\set ON_ERROR_STOP 1
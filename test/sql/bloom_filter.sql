@@ -0,0 +1,96 @@
+CREATE TABLE bloom_test(time bigint NOT NULL, trace_id text, span_id bigint, duration double precision, location point);
+SELECT create_hypertable('bloom_test', 'time', chunk_time_interval => 10);
+INSERT INTO bloom_test SELECT t, 'trace-' || t, t * 1000, t / 2.0, point(t, t) FROM generate_series(0, 29) t;
+
+-- filters of existing chunks are built when the bloom filter is added
+SELECT add_bloom_filter('bloom_test', 'trace_id', false_positive_rate => 0.0001);
+SELECT add_bloom_filter('bloom_test', 'span_id', 0.0001);
+SELECT add_bloom_filter('bloom_test', 'duration', 0.0001);
+
+SELECT * FROM _timescaledb_catalog.bloom_filter ORDER BY id;
+SELECT count(*) FROM pg_trigger WHERE tgname = 'ts_bloom_filter_invalidate';
+
+CREATE VIEW bloom_filters AS
+SELECT c.table_name, f.column_name, cf.num_hashes, octet_length(cf.filter) AS filter_size
+FROM _timescaledb_catalog.chunk_bloom_filter cf
+INNER JOIN _timescaledb_catalog.chunk c ON (c.id = cf.chunk_id)
+INNER JOIN _timescaledb_catalog.bloom_filter f ON (f.id = cf.bloom_filter_id);
+
+SELECT * FROM bloom_filters ORDER BY table_name, column_name;
+
+-- chunks whose filters do not contain the value are excluded
+EXPLAIN (costs off)
+SELECT * FROM bloom_test WHERE trace_id = 'trace-15';
+EXPLAIN (costs off)
+SELECT * FROM bloom_test WHERE trace_id = 'missing';
+SELECT time, trace_id, span_id FROM bloom_test WHERE 'trace-15' = trace_id;
+
+-- constants of other types of the column's hash operator family hash the same
+EXPLAIN (costs off)
+SELECT * FROM bloom_test WHERE span_id = 25000;
+EXPLAIN (costs off)
+SELECT * FROM bloom_test WHERE span_id = 25000::smallint;
+EXPLAIN (costs off)
+SELECT * FROM bloom_test WHERE duration = 7.5::real;
+
+-- a constant of a type outside the family cannot use the filters
+EXPLAIN (costs off)
+SELECT * FROM bloom_test WHERE span_id = 25000.0;
+SELECT time, trace_id, span_id FROM bloom_test WHERE span_id = 25000.0;
+
+-- deleting rows keeps the filters, so the chunk still matches the deleted
+-- value, but the scan returns no rows
+DELETE FROM bloom_test WHERE trace_id = 'trace-15';
+EXPLAIN (costs off)
+SELECT * FROM bloom_test WHERE trace_id = 'trace-15';
+SELECT count(*) FROM bloom_test WHERE trace_id = 'trace-15';
+
+-- writing to a chunk removes its filters, and new chunks have no filters
+INSERT INTO bloom_test VALUES (5, 'trace-15', 5, 0, point(0, 0));
+INSERT INTO bloom_test VALUES (35, 'trace-35', 35000, 0, point(0, 0));
+SELECT * FROM bloom_filters ORDER BY table_name, column_name;
+EXPLAIN (costs off)
+SELECT * FROM bloom_test WHERE trace_id = 'trace-15';
+SELECT time, trace_id, span_id FROM bloom_test WHERE trace_id = 'trace-15' ORDER BY time;
+
+SELECT build_chunk_bloom_filters('_timescaledb_internal._hyper_1_1_chunk');
+SELECT build_chunk_bloom_filters('_timescaledb_internal._hyper_1_4_chunk');
+SELECT * FROM bloom_filters ORDER BY table_name, column_name;
+EXPLAIN (costs off)
+SELECT * FROM bloom_test WHERE trace_id = 'missing';
+
+-- a filter with a high false positive rate is small, and matches values that
+-- are not in the chunk
+CREATE TABLE bloom_fp(time bigint NOT NULL, tag text);
+SELECT create_hypertable('bloom_fp', 'time', chunk_time_interval => 100000);
+INSERT INTO bloom_fp SELECT t, 'tag-' || t FROM generate_series(1, 10000) t;
+SELECT add_bloom_filter('bloom_fp', 'tag', false_positive_rate => 0.999);
+SELECT * FROM bloom_filters WHERE column_name = 'tag';
+EXPLAIN (costs off)
+SELECT * FROM bloom_fp WHERE tag = 'missing';
+SELECT count(*) FROM bloom_fp WHERE tag = 'missing';
+DROP TABLE bloom_fp;
+
+\set ON_ERROR_STOP 0
+SELECT add_bloom_filter('bloom_test', 'trace_id');
+SELECT add_bloom_filter('bloom_test', 'location');
+SELECT add_bloom_filter('bloom_test', 'time');
+SELECT add_bloom_filter('bloom_test', 'missing');
+SELECT add_bloom_filter('bloom_test', 'location', false_positive_rate => 1);
+SELECT remove_bloom_filter('bloom_test', 'location');
+SELECT build_chunk_bloom_filters('bloom_test');
+ALTER TABLE bloom_test ALTER COLUMN trace_id TYPE varchar;
+\set ON_ERROR_STOP 1
+SELECT add_bloom_filter('bloom_test', 'trace_id', if_not_exists => true);
+
+-- renaming and dropping columns updates the bloom filters
+ALTER TABLE bloom_test RENAME COLUMN trace_id TO trace;
+ALTER TABLE bloom_test DROP COLUMN span_id;
+SELECT * FROM _timescaledb_catalog.bloom_filter ORDER BY id;
+SELECT * FROM bloom_filters ORDER BY table_name, column_name;
+
+SELECT remove_bloom_filter('bloom_test', 'trace');
+SELECT remove_bloom_filter('bloom_test', 'trace', if_exists => true);
+SELECT remove_bloom_filter('bloom_test', 'duration');
+SELECT count(*) FROM _timescaledb_catalog.chunk_bloom_filter;
+SELECT count(*) FROM pg_trigger WHERE tgname = 'ts_bloom_filter_invalidate';
@@ -0,0 +1,77 @@
+CREATE TABLE stats_test(time bigint NOT NULL, device int, value int);
+SELECT create_hypertable('stats_test', 'time', chunk_time_interval => 10);
+INSERT INTO stats_test SELECT t, t % 3, t FROM generate_series(0, 34) t;
+
+-- record the statistics of the chunks that no longer receive writes
+SELECT record_chunk_stats('_timescaledb_internal._hyper_1_1_chunk');
+SELECT record_chunk_stats('_timescaledb_internal._hyper_1_2_chunk');
+SELECT record_chunk_stats('_timescaledb_internal._hyper_1_3_chunk');
+
+SELECT * FROM _timescaledb_catalog.chunk_stats ORDER BY chunk_id;
+SELECT count(*) FROM pg_trigger WHERE tgname LIKE 'ts_chunk_stats_invalidate%';
+
+-- chunks entirely within the time range are answered from their statistics
+EXPLAIN (costs off)
+SELECT count(*), min(time), max(time) FROM stats_test WHERE time >= 10;
+SELECT count(*), count(time), min(time), max(time) FROM stats_test WHERE time >= 10;
+
+-- chunks partially within the time range are read
+EXPLAIN (costs off)
+SELECT count(*), min(time), max(time) FROM stats_test WHERE time > 15 AND time <= 29;
+SELECT count(*), min(time), max(time) FROM stats_test WHERE time > 15 AND time <= 29;
+
+-- other restrictions need the rows
+EXPLAIN (costs off)
+SELECT count(*) FROM stats_test WHERE time >= 10 AND device = 1;
+SELECT count(*) FROM stats_test WHERE time >= 10 AND device = 1;
+
+-- the statistics are read instead of the rows
+\c single :ROLE_SUPERUSER
+UPDATE _timescaledb_catalog.chunk_stats SET row_count = 1000 WHERE chunk_id = 3;
+\c single :ROLE_DEFAULT_PERM_USER
+SELECT count(*) FROM stats_test WHERE time >= 10;
+SELECT record_chunk_stats('_timescaledb_internal._hyper_1_3_chunk');
+
+-- writing to a chunk removes its statistics
+INSERT INTO stats_test VALUES (15, 0, 15);
+DELETE FROM stats_test WHERE time = 25;
+UPDATE stats_test SET value = 0 WHERE time = 5;
+SELECT * FROM _timescaledb_catalog.chunk_stats ORDER BY chunk_id;
+SELECT count(*), min(time), max(time) FROM stats_test WHERE time >= 0;
+
+SELECT record_chunk_stats('_timescaledb_internal._hyper_1_1_chunk');
+SELECT record_chunk_stats('_timescaledb_internal._hyper_1_3_chunk');
+TRUNCATE _timescaledb_internal._hyper_1_3_chunk;
+SELECT * FROM _timescaledb_catalog.chunk_stats ORDER BY chunk_id;
+
+-- an empty chunk has no time range
+SELECT record_chunk_stats('_timescaledb_internal._hyper_1_3_chunk');
+SELECT * FROM _timescaledb_catalog.chunk_stats ORDER BY chunk_id;
+SELECT count(*), min(time), max(time) FROM stats_test WHERE time < 30;
+
+-- prepared statements do not use statistics removed after planning
+PREPARE stats_prep AS SELECT count(*), max(time) FROM stats_test WHERE time < 10;
+EXECUTE stats_prep;
+INSERT INTO stats_test VALUES (9, 0, 9);
+EXECUTE stats_prep;
+DEALLOCATE stats_prep;
+
+-- compressing a chunk keeps its statistics
+CREATE TABLE stats_ts(time timestamp NOT NULL, value int);
+SELECT create_hypertable('stats_ts', 'time', chunk_time_interval => interval '1 day');
+INSERT INTO stats_ts SELECT t, 1 FROM generate_series('2018-01-01 00:00'::timestamp, '2018-01-03 23:00', '1 hour') t;
+SELECT record_chunk_stats('_timescaledb_internal._hyper_2_5_chunk');
+SELECT record_chunk_stats('_timescaledb_internal._hyper_2_6_chunk');
+SELECT compress_chunk('_timescaledb_internal._hyper_2_6_chunk');
+SELECT chunk_id, row_count FROM _timescaledb_catalog.chunk_stats WHERE chunk_id > 4 ORDER BY chunk_id;
+SELECT count(*), min(time), max(time) FROM stats_ts WHERE time >= '2018-01-01';
+SELECT count(*), min(time), max(time) FROM stats_ts WHERE time >= '2018-01-02';
+
+\set ON_ERROR_STOP 0
+SELECT record_chunk_stats('stats_test');
+SELECT record_chunk_stats('_timescaledb_internal._hyper_2_6_chunk');
+\set ON_ERROR_STOP 1
+
+-- dropping a hypertable removes the statistics of its chunks
+DROP TABLE stats_test;
+SELECT chunk_id, row_count FROM _timescaledb_catalog.chunk_stats ORDER BY chunk_id;
@@ -0,0 +1,99 @@
+CREATE TABLE compress_test(time timestamp NOT NULL, device int, value double precision, label text);
+SELECT create_hypertable('compress_test', 'time', chunk_time_interval => interval '1 day');
+
+INSERT INTO compress_test
+SELECT t, d, d * 10 + extract(hour from t), CASE WHEN d = 2 THEN NULL ELSE 'dev' || d END
+FROM generate_series('2018-01-01 00:00'::timestamp, '2018-01-01 23:00', '1 hour') t,
+     generate_series(1, 3) d;
+
+CREATE TABLE compress_before AS SELECT * FROM compress_test;
+
+SELECT count(*), sum(value), min(time), max(time) FROM compress_test;
+
+SELECT compress_chunk('_timescaledb_internal._hyper_1_1_chunk', '{device}');
+SELECT * FROM _timescaledb_catalog.compressed_chunk;
+
+-- the rows were moved out of the chunk's heap
+SELECT pg_relation_size('_timescaledb_internal._hyper_1_1_chunk');
+
+-- queries return the same results on the compressed chunk
+SELECT count(*), sum(value), min(time), max(time) FROM compress_test;
+(SELECT * FROM compress_test EXCEPT ALL SELECT * FROM compress_before)
+UNION ALL
+(SELECT * FROM compress_before EXCEPT ALL SELECT * FROM compress_test);
+SELECT * FROM compress_test WHERE device = 2 AND time < '2018-01-01 03:00' ORDER BY time;
+
+EXPLAIN (costs off)
+SELECT * FROM _timescaledb_internal._hyper_1_1_chunk WHERE device = 1;
+
+-- rows in other chunks can still be inserted
+INSERT INTO compress_test VALUES ('2018-01-02 05:30', 1, 1, 'x');
+
+\set ON_ERROR_STOP 0
+INSERT INTO compress_test VALUES ('2018-01-01 05:30', 1, 1, 'x');
+UPDATE compress_test SET value = 0 WHERE device = 1;
+DELETE FROM compress_test WHERE device = 1;
+INSERT INTO _timescaledb_internal._hyper_1_1_chunk VALUES ('2018-01-01 05:30', 1, 1, 'x');
+UPDATE _timescaledb_internal._hyper_1_1_chunk SET value = 0;
+SELECT compress_chunk('_timescaledb_internal._hyper_1_1_chunk');
+SELECT compress_chunk('compress_before');
+SELECT compress_chunk('_timescaledb_internal._hyper_1_2_chunk', '{time}');
+SELECT compress_chunk('_timescaledb_internal._hyper_1_2_chunk', '{missing}');
+SELECT compress_chunk('_timescaledb_internal._hyper_1_2_chunk', '{device, device}');
+SELECT decompress_chunk('_timescaledb_internal._hyper_1_2_chunk');
+\set ON_ERROR_STOP 1
+
+-- a rolled back decompression leaves dead rows in the chunk's heap, but the
+-- chunk is still read from its compressed table and refuses writes
+BEGIN;
+SELECT decompress_chunk('_timescaledb_internal._hyper_1_1_chunk');
+ROLLBACK;
+SELECT pg_relation_size('_timescaledb_internal._hyper_1_1_chunk') > 0 AS has_blocks;
+SELECT count(*), sum(value) FROM compress_test WHERE time < '2018-01-02';
+EXPLAIN (costs off)
+SELECT * FROM _timescaledb_internal._hyper_1_1_chunk WHERE device = 1;
+\set ON_ERROR_STOP 0
+INSERT INTO _timescaledb_internal._hyper_1_1_chunk VALUES ('2018-01-01 05:30', 1, 1, 'x');
+\set ON_ERROR_STOP 1
+
+-- without segment_by columns, all columns are compressed
+SELECT compress_chunk('_timescaledb_internal._hyper_1_2_chunk');
+SELECT * FROM compress_test WHERE time >= '2018-01-02';
+
+SELECT decompress_chunk('_timescaledb_internal._hyper_1_1_chunk');
+SELECT chunk_id, segment_by FROM _timescaledb_catalog.compressed_chunk;
+SELECT relname FROM pg_class WHERE relname LIKE '\_compressed\_chunk\_%' ORDER BY relname;
+(SELECT * FROM compress_test WHERE time < '2018-01-02' EXCEPT ALL SELECT * FROM compress_before)
+UNION ALL
+(SELECT * FROM compress_before EXCEPT ALL SELECT * FROM compress_test WHERE time < '2018-01-02');
+
+-- DDL that does not match the compressed data is rejected
+SELECT compress_chunk('_timescaledb_internal._hyper_1_1_chunk', '{device}');
+\set ON_ERROR_STOP 0
+ALTER TABLE compress_test RENAME COLUMN value TO reading;
+ALTER TABLE compress_test RENAME COLUMN device TO dev;
+ALTER TABLE compress_test ALTER COLUMN value TYPE numeric;
+ALTER TABLE compress_test ADD COLUMN extra int DEFAULT 1;
+ALTER TABLE compress_test ADD COLUMN extra int NOT NULL;
+ALTER TABLE compress_test ADD COLUMN extra serial;
+ALTER TABLE compress_test DROP COLUMN device;
+\set ON_ERROR_STOP 1
+
+-- columns without values read as NULL and dropped columns do not come back
+ALTER TABLE compress_test ADD COLUMN extra int;
+ALTER TABLE compress_test DROP COLUMN label;
+ALTER TABLE compress_test ADD COLUMN label int;
+SELECT * FROM compress_test WHERE device = 2 AND time < '2018-01-01 03:00' ORDER BY time;
+SELECT * FROM compress_test WHERE time >= '2018-01-02';
+
+-- the columns can be changed once the chunks are decompressed
+SELECT decompress_chunk('_timescaledb_internal._hyper_1_1_chunk');
+SELECT decompress_chunk('_timescaledb_internal._hyper_1_2_chunk');
+ALTER TABLE compress_test RENAME COLUMN value TO reading;
+ALTER TABLE compress_test ALTER COLUMN reading TYPE numeric;
+SELECT * FROM compress_test WHERE device = 2 AND time < '2018-01-01 03:00' ORDER BY time;
+
+-- compressed chunks are dropped with their hypertable
+DROP TABLE compress_test;
+SELECT count(*) FROM _timescaledb_catalog.compressed_chunk;
+SELECT relname FROM pg_class WHERE relname LIKE '\_compressed\_chunk\_%';
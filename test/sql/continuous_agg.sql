@@ -0,0 +1,97 @@
+CREATE TABLE conditions(time timestamp NOT NULL, device int, temperature float);
+SELECT create_hypertable('conditions', 'time', chunk_time_interval => interval '1 day', create_default_indexes => false);
+INSERT INTO conditions SELECT t, 1, 10 FROM generate_series('2018-01-01 00:00'::timestamp, '2018-01-03 23:00', '1 hour') t;
+
+SET timescaledb.vector_filter = off;
+
+-- restrictions on time buckets exclude chunks
+EXPLAIN (costs off)
+SELECT * FROM conditions WHERE time_bucket('1 day', time) >= '2018-01-03';
+EXPLAIN (costs off)
+SELECT * FROM conditions WHERE time_bucket('1 day', time) < '2018-01-02 06:00';
+
+-- restrictions on time buckets that are only known at execution time exclude
+-- chunks in ConstraintAwareAppend
+CREATE FUNCTION cagg_test_start() RETURNS timestamp LANGUAGE plpgsql STABLE AS
+$$ BEGIN RETURN '2018-01-03'; END $$;
+EXPLAIN (costs off)
+SELECT * FROM conditions WHERE time_bucket('1 day', time) >= cagg_test_start();
+
+RESET timescaledb.vector_filter;
+
+SELECT create_continuous_aggregate('conditions_daily',
+$$SELECT time_bucket('1 day', time) AS day, device, count(*) AS readings, sum(temperature) AS total
+FROM conditions GROUP BY day, device$$);
+
+SELECT id, hypertable_id, user_view_schema, user_view_name, direct_view_name, mat_table_name,
+bucket_column_name, bucket_width, materialized_only, watermark
+FROM _timescaledb_catalog.continuous_agg;
+SELECT count(*) FROM pg_trigger WHERE tgname LIKE 'ts_continuous_agg_invalidate%';
+
+-- buckets at or above the watermark are computed from the hypertable
+SELECT * FROM conditions_daily ORDER BY day, device;
+
+SELECT refresh_continuous_aggregate('conditions_daily');
+SELECT watermark FROM _timescaledb_catalog.continuous_agg;
+SELECT * FROM _timescaledb_internal._materialized_1 ORDER BY day, device;
+
+-- inserts are logged and the buckets below the watermark are recomputed on
+-- refresh
+INSERT INTO conditions VALUES ('2018-01-02 12:30', 1, 100);
+INSERT INTO conditions VALUES ('2018-01-04 05:00', 1, 10);
+SELECT * FROM _timescaledb_catalog.continuous_agg_invalidation_log ORDER BY lowest_modified_value;
+SELECT * FROM conditions_daily ORDER BY day, device;
+
+SELECT refresh_continuous_aggregate('conditions_daily');
+SELECT * FROM conditions_daily ORDER BY day, device;
+SELECT watermark FROM _timescaledb_catalog.continuous_agg;
+SELECT count(*) FROM _timescaledb_catalog.continuous_agg_invalidation_log;
+
+-- updates and deletes are logged by triggers
+UPDATE conditions SET temperature = 20 WHERE time = '2018-01-01 00:00';
+DELETE FROM conditions WHERE time = '2018-01-03 00:00';
+SELECT * FROM _timescaledb_catalog.continuous_agg_invalidation_log ORDER BY lowest_modified_value;
+
+SELECT refresh_continuous_aggregate('conditions_daily');
+SELECT * FROM conditions_daily ORDER BY day, device;
+
+-- an aggregate that only returns materialized buckets
+SELECT create_continuous_aggregate('conditions_max',
+$$SELECT time_bucket('12 hours', time) AS half_day, max(temperature)
+FROM conditions GROUP BY half_day$$, materialized_only => true);
+SELECT * FROM conditions_max ORDER BY half_day;
+SELECT refresh_continuous_aggregate('conditions_max');
+SELECT * FROM conditions_max ORDER BY half_day;
+SELECT id, watermark FROM _timescaledb_catalog.continuous_agg ORDER BY id;
+SELECT count(*) FROM pg_trigger WHERE tgname LIKE 'ts_continuous_agg_invalidate%';
+
+-- truncating the hypertable invalidates all buckets
+TRUNCATE conditions;
+SELECT * FROM _timescaledb_catalog.continuous_agg_invalidation_log ORDER BY continuous_agg_id;
+SELECT refresh_continuous_aggregate('conditions_daily');
+SELECT * FROM conditions_daily ORDER BY day, device;
+SELECT * FROM _timescaledb_catalog.continuous_agg_invalidation_log ORDER BY continuous_agg_id;
+
+CREATE TABLE int_time(time bigint NOT NULL, value int);
+SELECT create_hypertable('int_time', 'time', chunk_time_interval => 10);
+
+\set ON_ERROR_STOP 0
+SELECT create_continuous_aggregate('invalid', $$SELECT device, count(*) FROM conditions GROUP BY device$$);
+SELECT create_continuous_aggregate('invalid', $$SELECT time_bucket('1 day', time) AS day FROM conditions GROUP BY day$$);
+SELECT create_continuous_aggregate('invalid', $$SELECT time_bucket('1 month', time) AS month, count(*) FROM conditions GROUP BY month$$);
+SELECT create_continuous_aggregate('invalid', $$SELECT time_bucket('1 day', day) AS d, count(*) FROM conditions_daily GROUP BY d$$);
+SELECT create_continuous_aggregate('invalid', $$SELECT time_bucket(10, time) AS b, count(*) FROM int_time GROUP BY b$$);
+SELECT refresh_continuous_aggregate('conditions');
+\set ON_ERROR_STOP 1
+
+-- dropping the view removes the continuous aggregate and its relations
+DROP VIEW conditions_max;
+SELECT id, user_view_name FROM _timescaledb_catalog.continuous_agg ORDER BY id;
+SELECT count(*) FROM _timescaledb_catalog.continuous_agg_invalidation_log;
+SELECT count(*) FROM pg_class WHERE relname IN ('_direct_view_2', '_materialized_2');
+SELECT count(*) FROM pg_trigger WHERE tgname LIKE 'ts_continuous_agg_invalidate%';
+
+-- the triggers are dropped along with the last continuous aggregate
+DROP VIEW conditions_daily;
+SELECT count(*) FROM _timescaledb_catalog.continuous_agg;
+SELECT count(*) FROM pg_trigger WHERE tgname LIKE 'ts_continuous_agg_invalidate%';
@@ -0,0 +1,37 @@
+CREATE TABLE gapfill_test(time timestamp, device int, value double precision);
+SELECT create_hypertable('gapfill_test', 'time');
+
+INSERT INTO gapfill_test VALUES
+    ('2018-01-01 01:00', 1, 10),
+    ('2018-01-01 01:30', 1, 20),
+    ('2018-01-01 04:00', 1, 40),
+    ('2018-01-01 02:00', 2, 5);
+
+-- missing buckets are added between start and finish
+SELECT time_bucket_gapfill('1 hour', time, '2018-01-01 00:00', '2018-01-01 06:00') AS bucket, count(*), avg(value)
+FROM gapfill_test GROUP BY 1 ORDER BY 1;
+
+-- every group is filled, carrying values forward or interpolating them if requested
+SELECT device,
+       time_bucket_gapfill('1 hour', time, '2018-01-01 00:00', '2018-01-01 06:00') AS bucket,
+       avg(value),
+       locf(avg(value)),
+       interpolate(avg(value))
+FROM gapfill_test GROUP BY device, bucket ORDER BY device, bucket;
+
+-- without grouping columns, an empty result is filled too
+SELECT time_bucket_gapfill('2 hours', time, '2018-01-02 00:00', '2018-01-02 06:00') AS bucket, count(*)
+FROM gapfill_test WHERE time >= '2018-01-02' GROUP BY 1 ORDER BY 1;
+
+-- outside of a gap-filled query, time_bucket_gapfill is time_bucket
+SELECT time_bucket_gapfill('1 hour', '2018-01-01 01:30'::timestamp, NULL, NULL);
+
+\set ON_ERROR_STOP 0
+SELECT time_bucket_gapfill('1 hour', time, time, '2018-01-01 06:00'), count(*)
+FROM gapfill_test GROUP BY 1;
+SELECT time_bucket_gapfill('1 hour', time, NULL, '2018-01-01 06:00'), count(*)
+FROM gapfill_test GROUP BY 1;
+SELECT time_bucket_gapfill('1 hour', time, '2018-01-01', '2018-01-02'),
+       time_bucket_gapfill('2 hours', time, '2018-01-01', '2018-01-02'), count(*)
+FROM gapfill_test GROUP BY 1, 2;
+\set ON_ERROR_STOP 1
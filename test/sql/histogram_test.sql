@@ -41,4 +41,15 @@ SELECT histogram(key, 1, 3, 1) FROM hitest1;
 -- standard 2 bucket
 SELECT qualify, histogram(score, 0, 10, 2) FROM hitest2 GROUP BY qualify;
 -- standard multi-bucket
-SELECT qualify, histogram(score, 0, 10, 5) FROM hitest2 GROUP BY qualify
+SELECT qualify, histogram(score, 0, 10, 5) FROM hitest2 GROUP BY qualify;
+
+-- null values are ignored
+SELECT histogram(key, 0, 9, 2) FROM (SELECT key FROM hitest1 UNION ALL SELECT NULL) k;
+
+-- sliding window frames use the moving-aggregate implementation
+SELECT key, histogram(key, 0, 6, 3) OVER (ORDER BY key, val ROWS BETWEEN 2 PRECEDING AND CURRENT ROW)
+FROM hitest1 ORDER BY key, val;
+
+-- window frames that start with null values or lose all counted values
+SELECT i, histogram(key, 0, 6, 3) OVER (ORDER BY i ROWS BETWEEN 1 PRECEDING AND CURRENT ROW)
+FROM (VALUES (1, NULL::float8), (2, NULL), (3, 1), (4, 4), (5, NULL), (6, NULL)) k(i, key) ORDER BY i;
@@ -0,0 +1,48 @@
+CREATE TABLE hll_test(time timestamptz, device int, name text);
+SELECT create_hypertable('hll_test', 'time', chunk_time_interval => interval '1 day');
+
+INSERT INTO hll_test
+SELECT '2018-01-01 00:00:00+00'::timestamptz + x * interval '1 minute', x % 1000, 'dev' || x % 500
+FROM generate_series(1, 4320) x;
+
+-- estimates are close to the exact counts
+SELECT distinct_count(hyperloglog(device)) AS devices, count(DISTINCT device) AS exact_devices,
+       distinct_count(hyperloglog(name)) AS names, count(DISTINCT name) AS exact_names
+FROM hll_test;
+
+SELECT distinct_count(hyperloglog(x)) AS default_precision,
+       distinct_count(hyperloglog(x, 16)) AS high_precision,
+       distinct_count(hyperloglog(x, 6)) AS low_precision
+FROM generate_series(1, 100000) x;
+
+-- sketches are small when there are few distinct values
+SELECT length(hyperloglog(x)) AS sparse FROM generate_series(1, 10) x;
+SELECT length(hyperloglog(x)) AS dense FROM generate_series(1, 100000) x;
+
+-- sketches can be stored and merged
+CREATE TABLE hll_rollup AS
+SELECT time_bucket('1 day', time) AS day, hyperloglog(device) AS sketch
+FROM hll_test GROUP BY day;
+
+SELECT distinct_count(sketch) FROM hll_rollup ORDER BY day;
+SELECT distinct_count(hyperloglog_union(sketch)) FROM hll_rollup;
+
+-- the union is the same as sketching all values at once
+SELECT hyperloglog_union(sketch) = (SELECT hyperloglog(device) FROM hll_test) AS same
+FROM hll_rollup;
+
+-- null values are ignored
+SELECT distinct_count(hyperloglog(v)) FROM unnest(ARRAY[1, NULL, 1, 2]) v;
+
+-- no rows
+SELECT distinct_count(hyperloglog(device)) FROM hll_test WHERE device < 0;
+
+\set ON_ERROR_STOP 0
+SELECT hyperloglog(device, 20) FROM hll_test;
+SELECT hyperloglog(point(1, 2));
+SELECT distinct_count('\x00'::bytea);
+SELECT hyperloglog_union(sketch)
+FROM (SELECT hyperloglog(device) AS sketch FROM hll_test
+      UNION ALL
+      SELECT hyperloglog(device, 14) FROM hll_test) s;
+\set ON_ERROR_STOP 1
@@ -149,6 +149,28 @@ FROM hyper_1_tz GROUP BY t ORDER BY t DESC limit 2;
 SELECT time_bucket('1 minute', time::timestamp) t, avg(series_0), min(series_1), avg(series_2)
 FROM hyper_1_tz GROUP BY t ORDER BY t DESC limit 2;
 
+EXPLAIN (costs off) SELECT time_bucket('1 minute', time AT TIME ZONE 'UTC') t, avg(series_0), min(series_1), avg(series_2)
+FROM hyper_1_tz GROUP BY t ORDER BY t DESC limit 2;
+SELECT time_bucket('1 minute', time AT TIME ZONE 'UTC') t, avg(series_0), min(series_1), avg(series_2)
+FROM hyper_1_tz GROUP BY t ORDER BY t DESC limit 2;
+
+EXPLAIN (costs off) SELECT time_bucket('1 minute', time AT TIME ZONE INTERVAL '+05:30') t, avg(series_0), min(series_1), avg(series_2)
+FROM hyper_1_tz GROUP BY t ORDER BY t DESC limit 2;
+SELECT time_bucket('1 minute', time AT TIME ZONE INTERVAL '+05:30') t, avg(series_0), min(series_1), avg(series_2)
+FROM hyper_1_tz GROUP BY t ORDER BY t DESC limit 2;
+
+--local time in zones with daylight saving time is not ordered like time
+EXPLAIN (costs off) SELECT time_bucket('1 minute', time AT TIME ZONE 'America/New_York') t, avg(series_0), min(series_1), avg(series_2)
+FROM hyper_1_tz GROUP BY t ORDER BY t DESC limit 2;
+SELECT time_bucket('1 minute', time AT TIME ZONE 'America/New_York') t, avg(series_0), min(series_1), avg(series_2)
+FROM hyper_1_tz GROUP BY t ORDER BY t DESC limit 2;
+
+--the date variant of time_bucket with an offset is inlined to a date cast
+EXPLAIN (costs off) SELECT time_bucket('1 day', time, INTERVAL '12 hours') t, count(*), min(series_0), max(series_0)
+FROM hyper_1_date GROUP BY t ORDER BY t DESC limit 2;
+SELECT time_bucket('1 day', time, INTERVAL '12 hours') t, count(*), min(series_0), max(series_0)
+FROM hyper_1_date GROUP BY t ORDER BY t DESC limit 2;
+
 EXPLAIN (costs off) SELECT time_bucket(10, time) t, avg(series_0), min(series_1), avg(series_2)
 FROM hyper_1_int GROUP BY t ORDER BY t DESC limit 2;
 SELECT time_bucket(10, time) t, avg(series_0), min(series_1), avg(series_2)
@@ -159,6 +181,18 @@ FROM hyper_1_int GROUP BY t ORDER BY t DESC limit 2;
 SELECT time_bucket(10, time) t, avg(series_0), min(series_1), avg(series_2)
 FROM hyper_1_int GROUP BY t ORDER BY t DESC limit 2;
 
+--subtracting from a constant or multiplying with a negative constant
+--reverses the order, so these are not transformed
+EXPLAIN (costs off) SELECT 20000 - time t, avg(series_0), min(series_1), avg(series_2)
+FROM hyper_1_int GROUP BY t ORDER BY t DESC limit 2;
+SELECT 20000 - time t, avg(series_0), min(series_1), avg(series_2)
+FROM hyper_1_int GROUP BY t ORDER BY t DESC limit 2;
+
+EXPLAIN (costs off) SELECT time * -1 t, avg(series_0), min(series_1), avg(series_2)
+FROM hyper_1_int GROUP BY t ORDER BY t DESC limit 2;
+SELECT time * -1 t, avg(series_0), min(series_1), avg(series_2)
+FROM hyper_1_int GROUP BY t ORDER BY t DESC limit 2;
+
 
 --plain tables shouldnt be optimized by default
 EXPLAIN (costs off)
@@ -0,0 +1,80 @@
+CREATE TABLE conditions(time timestamp NOT NULL, device text, temperature float);
+SELECT create_hypertable('conditions', 'time', chunk_time_interval => interval '1 day');
+INSERT INTO conditions VALUES ('2018-01-01 00:00', 'a', 1), ('2018-01-01 01:00', 'a', 2), ('2018-01-01 00:30', 'b', 3);
+
+-- the latest row of every key is loaded when the cache is added
+SELECT add_last_point_cache('conditions', 'device');
+SELECT * FROM _timescaledb_catalog.last_point_cache;
+SELECT count(*) FROM pg_trigger WHERE tgname = 'ts_last_point_cache_reset';
+SELECT * FROM last_points(NULL::conditions) ORDER BY device;
+
+-- inserts replace the cached row of their key unless they are older
+INSERT INTO conditions VALUES ('2018-01-02 00:00', 'a', 4), ('2017-12-31 00:00', 'b', 5), ('2018-01-01 12:00', 'c', 6);
+SELECT * FROM last_points(NULL::conditions) ORDER BY device;
+
+-- rows of aborted transactions and rows without a key are not cached
+BEGIN;
+INSERT INTO conditions VALUES ('2018-01-03 00:00', 'a', 7);
+ROLLBACK;
+INSERT INTO conditions VALUES ('2018-01-03 00:00', NULL, 8);
+SELECT * FROM last_points(NULL::conditions) ORDER BY device;
+
+-- deletes empty the cache until it is refreshed
+DELETE FROM conditions WHERE device = 'c';
+SELECT count(*) FROM last_points(NULL::conditions);
+SELECT refresh_last_point_cache('conditions');
+SELECT * FROM last_points(NULL::conditions) ORDER BY device;
+
+-- an aborted subtransaction empties the cache of the hypertables written to
+BEGIN;
+INSERT INTO conditions VALUES ('2018-01-04 00:00', 'a', 9);
+SAVEPOINT s;
+INSERT INTO conditions VALUES ('2018-01-04 00:00', 'b', 10);
+ROLLBACK TO SAVEPOINT s;
+COMMIT;
+SELECT count(*) FROM last_points(NULL::conditions);
+SELECT refresh_last_point_cache('conditions');
+
+-- transactions that wrote to the hypertable cannot be prepared
+\set ON_ERROR_STOP 0
+BEGIN;
+INSERT INTO conditions VALUES ('2018-01-05 00:00', 'a', 12);
+PREPARE TRANSACTION 'last_point_cache';
+\set ON_ERROR_STOP 1
+SELECT count(*) FROM pg_prepared_xacts;
+SELECT * FROM last_points(NULL::conditions) ORDER BY device;
+
+-- renaming the key column keeps the cache
+ALTER TABLE conditions RENAME COLUMN device TO location;
+SELECT * FROM _timescaledb_catalog.last_point_cache;
+SELECT * FROM last_points(NULL::conditions) ORDER BY location;
+
+\set ON_ERROR_STOP 0
+ALTER TABLE conditions ALTER COLUMN location TYPE varchar;
+SELECT add_last_point_cache('conditions', 'location');
+SELECT * FROM last_points(NULL::int);
+\set ON_ERROR_STOP 1
+SELECT add_last_point_cache('conditions', 'location', if_not_exists => true);
+
+-- altering the hypertable empties the cache
+ALTER TABLE conditions ADD COLUMN humidity float;
+SELECT count(*) FROM last_points(NULL::conditions);
+INSERT INTO conditions VALUES ('2018-01-05 00:00', 'a', 11, 50);
+SELECT * FROM last_points(NULL::conditions) ORDER BY location;
+
+-- dropping the key column removes the cache
+ALTER TABLE conditions DROP COLUMN location;
+SELECT count(*) FROM _timescaledb_catalog.last_point_cache;
+SELECT count(*) FROM pg_trigger WHERE tgname = 'ts_last_point_cache_reset';
+
+\set ON_ERROR_STOP 0
+SELECT * FROM last_points(NULL::conditions);
+SELECT remove_last_point_cache('conditions');
+\set ON_ERROR_STOP 1
+SELECT remove_last_point_cache('conditions', if_exists => true);
+
+-- dropping the hypertable removes the cache
+SELECT add_last_point_cache('conditions', 'temperature');
+SELECT * FROM last_points(NULL::conditions) ORDER BY temperature;
+DROP TABLE conditions;
+SELECT count(*) FROM _timescaledb_catalog.last_point_cache;
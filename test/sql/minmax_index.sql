@@ -0,0 +1,97 @@
+CREATE TABLE minmax_test(time bigint NOT NULL, device smallint, value bigint, note text);
+SELECT create_hypertable('minmax_test', 'time', chunk_time_interval => 10);
+
+-- every fourth value is NULL, and all values of the third chunk are NULL
+INSERT INTO minmax_test
+SELECT t, t % 3, CASE WHEN t % 4 = 3 OR t >= 20 THEN NULL ELSE t * 100 END, 'a'
+FROM generate_series(0, 29) t;
+
+-- ranges of existing chunks are computed from their non-NULL values, and a
+-- chunk without any has an empty range
+SELECT add_minmax_index('minmax_test', 'value');
+SELECT add_minmax_index('minmax_test', 'device');
+
+SELECT * FROM _timescaledb_catalog.minmax_index ORDER BY id;
+SELECT count(*) FROM pg_trigger WHERE tgname = 'ts_minmax_range';
+
+CREATE VIEW minmax_ranges AS
+SELECT c.table_name, i.column_name, m.min_value, m.max_value
+FROM _timescaledb_catalog.chunk_minmax m
+INNER JOIN _timescaledb_catalog.chunk c ON (c.id = m.chunk_id)
+INNER JOIN _timescaledb_catalog.minmax_index i ON (i.id = m.minmax_index_id);
+
+SELECT * FROM minmax_ranges ORDER BY table_name, column_name;
+
+-- restrictions are strict, so chunks with empty ranges are excluded by any
+-- restriction on the column
+EXPLAIN (costs off)
+SELECT * FROM minmax_test WHERE value > 1500;
+EXPLAIN (costs off)
+SELECT * FROM minmax_test WHERE 1000 > value AND device = 1;
+EXPLAIN (costs off)
+SELECT * FROM minmax_test WHERE device > 5;
+
+-- but not by IS NULL
+EXPLAIN (costs off)
+SELECT * FROM minmax_test WHERE value IS NULL;
+SELECT count(*) FROM minmax_test WHERE value IS NULL;
+
+-- inserted rows widen the ranges below and above, empty ranges, and the
+-- ranges of new chunks
+INSERT INTO minmax_test VALUES
+    (1, 0, -500, 'b'), (12, 0, 5000, 'b'), (25, 7, 2500, 'b'),
+    (35, NULL, NULL, 'b'), (36, 1, 3600, 'b'), (45, NULL, NULL, 'b');
+SELECT * FROM minmax_ranges ORDER BY table_name, column_name;
+
+-- rows inserted directly into chunks, updated rows and rows changed by BEFORE
+-- ROW triggers widen the ranges as well
+INSERT INTO _timescaledb_internal._hyper_1_3_chunk VALUES (26, 2, 2900, 'c');
+UPDATE minmax_test SET value = 9000 WHERE time = 5;
+CREATE FUNCTION minmax_double() RETURNS trigger LANGUAGE plpgsql AS
+$BODY$
+BEGIN
+    NEW.value := NEW.value * 2;
+    RETURN NEW;
+END
+$BODY$;
+CREATE TRIGGER minmax_double BEFORE INSERT ON minmax_test
+FOR EACH ROW EXECUTE PROCEDURE minmax_double();
+INSERT INTO minmax_test VALUES (46, 3, 4000, 'd');
+DROP TRIGGER minmax_double ON minmax_test;
+
+-- deleted rows do not shrink the ranges
+DELETE FROM minmax_test WHERE value = -500;
+SELECT * FROM minmax_ranges ORDER BY table_name, column_name;
+
+SELECT * FROM minmax_test WHERE value > 4000 ORDER BY time;
+SELECT * FROM minmax_test WHERE device >= 7 ORDER BY time;
+EXPLAIN (costs off)
+SELECT * FROM minmax_test WHERE value > 4000;
+
+-- prepared statements see ranges that widen after they are prepared
+PREPARE minmax_prep AS SELECT count(*) FROM minmax_test WHERE value >= 9500;
+EXECUTE minmax_prep;
+INSERT INTO minmax_test VALUES (15, 0, 9500, 'e');
+EXECUTE minmax_prep;
+DEALLOCATE minmax_prep;
+
+\set ON_ERROR_STOP 0
+SELECT add_minmax_index('minmax_test', 'value');
+SELECT add_minmax_index('minmax_test', 'note');
+SELECT add_minmax_index('minmax_test', 'time');
+SELECT add_minmax_index('minmax_test', 'missing');
+SELECT remove_minmax_index('minmax_test', 'note');
+ALTER TABLE minmax_test ALTER COLUMN value TYPE int;
+\set ON_ERROR_STOP 1
+SELECT add_minmax_index('minmax_test', 'value', if_not_exists => true);
+
+-- renaming and dropping columns updates the indexes
+ALTER TABLE minmax_test RENAME COLUMN value TO reading;
+ALTER TABLE minmax_test DROP COLUMN device;
+SELECT * FROM _timescaledb_catalog.minmax_index ORDER BY id;
+SELECT * FROM minmax_ranges ORDER BY table_name, column_name;
+
+SELECT remove_minmax_index('minmax_test', 'reading');
+SELECT remove_minmax_index('minmax_test', 'reading', if_exists => true);
+SELECT count(*) FROM _timescaledb_catalog.chunk_minmax;
+SELECT count(*) FROM pg_trigger WHERE tgname = 'ts_minmax_range';
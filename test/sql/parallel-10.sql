@@ -46,3 +46,44 @@ SELECT histogram(i, 0, 100000, 5) FROM "test";
 
 EXPLAIN (costs off) SELECT histogram(i, 10,100000,5) FROM "test";
 SELECT histogram(i, 10, 100000, 5) FROM "test";
+
+--test percentile sketches
+EXPLAIN (costs off) SELECT approx_percentile(0.5, percentile_sketch(i)) FROM "test";
+SELECT round(approx_percentile(0.5, percentile_sketch(i))::numeric, 3) AS p50,
+       round(approx_percentile(0.99, percentile_sketch(i))::numeric, 3) AS p99
+FROM "test";
+
+--test hyperloglog sketches
+EXPLAIN (costs off) SELECT distinct_count(hyperloglog(i)) FROM "test";
+SELECT distinct_count(hyperloglog(i)) FROM "test";
+
+--test time-series aggregates
+EXPLAIN (costs off) SELECT delta(j, ts) FROM "test";
+SELECT delta(j, ts) FROM "test";
+
+--the rows of parallel workers interleave in time, so time_weight_avg() and
+--counter_rate() have no partial states and run in the leader
+EXPLAIN (costs off) SELECT time_weight_avg(j, ts), counter_rate(i, ts) FROM "test";
+SELECT time_weight_avg(j, ts), counter_rate(i, ts) FROM "test";
+
+--test ConstraintAwareAppend below a Gather
+CREATE TABLE test_ht (i int, j double precision, ts timestamp);
+SELECT create_hypertable('test_ht', 'ts', chunk_time_interval => interval '200 seconds');
+INSERT INTO test_ht SELECT * FROM test;
+ANALYZE test_ht;
+
+SET parallel_setup_cost = 0;
+
+--the stable comparison leaves chunk exclusion to execution time
+EXPLAIN (costs off)
+SELECT count(*), sum(i) FROM test_ht WHERE ts < '1969-12-31 16:05:00'::timestamptz;
+SELECT count(*), sum(i) FROM test_ht WHERE ts < '1969-12-31 16:05:00'::timestamptz;
+
+--chunks are no longer handed out, the result must be the same
+SET timescaledb.parallel_chunk_append = off;
+EXPLAIN (costs off)
+SELECT count(*), sum(i) FROM test_ht WHERE ts < '1969-12-31 16:05:00'::timestamptz;
+SELECT count(*), sum(i) FROM test_ht WHERE ts < '1969-12-31 16:05:00'::timestamptz;
+
+RESET timescaledb.parallel_chunk_append;
+RESET parallel_setup_cost;
@@ -0,0 +1,65 @@
+CREATE TABLE sketch_test(time timestamptz, device int, value double precision);
+SELECT create_hypertable('sketch_test', 'time', chunk_time_interval => interval '1 day');
+
+INSERT INTO sketch_test
+SELECT '2018-01-01 00:00:00+00'::timestamptz + x * interval '1 minute', x % 3, x * 0.25
+FROM generate_series(1, 4320) x;
+
+-- percentiles are within 1% of the exact ones
+SELECT device,
+       round(approx_percentile(0.5, percentile_sketch(value))::numeric, 3) AS p50,
+       round(approx_percentile(0.95, percentile_sketch(value))::numeric, 3) AS p95,
+       round(approx_percentile(0.99, percentile_sketch(value))::numeric, 3) AS p99
+FROM sketch_test GROUP BY device ORDER BY device;
+
+SELECT device,
+       percentile_cont(0.5) WITHIN GROUP (ORDER BY value) AS p50,
+       percentile_cont(0.95) WITHIN GROUP (ORDER BY value) AS p95,
+       percentile_cont(0.99) WITHIN GROUP (ORDER BY value) AS p99
+FROM sketch_test GROUP BY device ORDER BY device;
+
+-- higher accuracy
+SELECT round(approx_percentile(0.5, percentile_sketch(value, 0.001))::numeric, 3) AS p50,
+       round(approx_percentile(0.99, percentile_sketch(value, 0.001))::numeric, 3) AS p99
+FROM sketch_test;
+
+-- the bounds are exact
+SELECT approx_percentile(0, percentile_sketch(value)) AS min,
+       approx_percentile(1, percentile_sketch(value)) AS max
+FROM sketch_test;
+
+-- sketches can be stored and rolled up
+CREATE TABLE sketch_rollup AS
+SELECT time_bucket('1 day', time) AS day, device, percentile_sketch(value) AS sketch
+FROM sketch_test GROUP BY day, device;
+
+SELECT device, round(approx_percentile(0.99, percentile_sketch_merge(sketch))::numeric, 3) AS p99
+FROM sketch_rollup GROUP BY device ORDER BY device;
+
+-- merging gives the same sketch as sketching all values at once
+SELECT device, merged.sketch = direct.sketch AS same
+FROM (SELECT device, percentile_sketch_merge(sketch) AS sketch FROM sketch_rollup GROUP BY device) merged
+JOIN (SELECT device, percentile_sketch(value) AS sketch FROM sketch_test GROUP BY device) direct
+USING (device)
+ORDER BY device;
+
+-- negative values and zeros, null values are ignored
+SELECT p, round(approx_percentile(p, sketch)::numeric, 3)
+FROM (SELECT percentile_sketch(v) AS sketch
+      FROM unnest(ARRAY[-10, -1, 0, NULL, 1, 10, 100]::float8[]) v) s,
+     unnest(ARRAY[0, 0.2, 0.4, 0.5, 0.6, 0.8, 1]) p
+ORDER BY p;
+
+-- no rows
+SELECT approx_percentile(0.5, percentile_sketch(value)) FROM sketch_test WHERE device > 3;
+
+\set ON_ERROR_STOP 0
+SELECT percentile_sketch(value, 0.9) FROM sketch_test;
+SELECT percentile_sketch('NaN'::float8);
+SELECT approx_percentile(1.5, percentile_sketch(value)) FROM sketch_test;
+SELECT approx_percentile(0.5, '\x00'::bytea);
+SELECT percentile_sketch_merge(sketch)
+FROM (SELECT percentile_sketch(value) AS sketch FROM sketch_test
+      UNION ALL
+      SELECT percentile_sketch(value, 0.001) FROM sketch_test) s;
+\set ON_ERROR_STOP 1
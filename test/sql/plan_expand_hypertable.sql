@@ -0,0 +1,45 @@
+CREATE TABLE hyper(time timestamp NOT NULL, device int, value float);
+SELECT create_hypertable('hyper', 'time', chunk_time_interval => interval '1 day', create_default_indexes => false);
+INSERT INTO hyper SELECT t, 1, 10 FROM generate_series('2018-01-01 00:00'::timestamp, '2018-01-04 23:00', '1 hour') t;
+
+-- the plans show plain scans on the chunks
+SET timescaledb.vector_filter = off;
+
+-- restrictions on the time column exclude chunks when expanding the hypertable
+EXPLAIN (costs off)
+SELECT * FROM hyper WHERE time < '2018-01-02 12:00';
+SELECT count(*) FROM hyper WHERE time < '2018-01-02 12:00';
+EXPLAIN (costs off)
+SELECT * FROM hyper WHERE time >= '2018-01-02' AND time <= '2018-01-03';
+EXPLAIN (costs off)
+SELECT * FROM hyper WHERE '2018-01-03 12:00' < time;
+EXPLAIN (costs off)
+SELECT * FROM hyper WHERE time = '2018-01-04 06:00';
+SELECT * FROM hyper WHERE time = '2018-01-04 06:00';
+
+-- no chunk matches, only the (empty) hypertable is left
+EXPLAIN (costs off)
+SELECT * FROM hyper WHERE time > '2018-02-01';
+
+-- chunks are not excluded without constraint exclusion
+SET constraint_exclusion = off;
+EXPLAIN (costs off)
+SELECT * FROM hyper WHERE time < '2018-01-02 12:00';
+RESET constraint_exclusion;
+
+-- queries with row marks use the regular inheritance expansion
+EXPLAIN (costs off)
+SELECT * FROM hyper WHERE time < '2018-01-02 12:00' FOR SHARE;
+
+-- a chunk created after the chunk metadata was cached is found and,
+-- because of the dropped column, has a different column layout
+ALTER TABLE hyper DROP COLUMN device;
+INSERT INTO hyper VALUES ('2018-01-05 01:00', 20);
+EXPLAIN (costs off)
+SELECT * FROM hyper WHERE time > '2018-01-04 12:00';
+SELECT * FROM hyper WHERE time > '2018-01-04 20:00' ORDER BY time;
+
+-- dropped chunks are no longer expanded
+SELECT drop_chunks('2018-01-03'::timestamp, 'hyper');
+EXPLAIN (costs off)
+SELECT * FROM hyper WHERE time < '2018-01-03 12:00';
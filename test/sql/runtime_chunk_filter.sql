@@ -0,0 +1,48 @@
+CREATE TABLE metrics(time timestamp NOT NULL, device_id int, value float);
+SELECT create_hypertable('metrics', 'time', chunk_time_interval => interval '1 day', create_default_indexes => false);
+INSERT INTO metrics SELECT t, d, d FROM generate_series('2018-01-01 00:00'::timestamp, '2018-01-04 23:00', '1 hour') t, generate_series(1, 2) d;
+ANALYZE metrics;
+
+CREATE TABLE events(time timestamp, name text);
+INSERT INTO events VALUES ('2018-01-01 00:00', 'start'), ('2018-01-01 12:00', 'noon');
+ANALYZE events;
+
+-- EXPLAIN ANALYZE without timings and memory usage
+CREATE OR REPLACE FUNCTION explain_analyze(query text) RETURNS SETOF TEXT LANGUAGE plpgsql AS
+$BODY$
+DECLARE
+    line TEXT;
+BEGIN
+    FOR line IN EXECUTE 'EXPLAIN (analyze, costs off, timing off) ' || query LOOP
+        IF line NOT LIKE '%Memory%' AND line NOT LIKE '%time:%' THEN
+            RETURN NEXT line;
+        END IF;
+    END LOOP;
+END
+$BODY$;
+
+SET enable_nestloop = off;
+SET enable_mergejoin = off;
+
+-- the events only match the first chunk, so the other chunks are skipped
+-- once the hash table is built
+SELECT * FROM explain_analyze($$
+SELECT m.time, m.device_id, e.name FROM metrics m JOIN events e ON (m.time = e.time)
+WHERE m.time < now() ORDER BY 1, 2
+$$);
+SELECT m.time, m.device_id, e.name FROM metrics m JOIN events e ON (m.time = e.time)
+WHERE m.time < now() ORDER BY 1, 2;
+
+-- outer joins need all probe-side rows, so chunks cannot be skipped
+EXPLAIN (costs off)
+SELECT m.time, m.device_id, e.name FROM metrics m LEFT JOIN events e ON (m.time = e.time)
+WHERE m.time < now();
+
+-- the result is the same without the filter
+SET timescaledb.runtime_chunk_filter = off;
+SELECT m.time, m.device_id, e.name FROM metrics m JOIN events e ON (m.time = e.time)
+WHERE m.time < now() ORDER BY 1, 2;
+
+RESET timescaledb.runtime_chunk_filter;
+RESET enable_nestloop;
+RESET enable_mergejoin;
@@ -0,0 +1,35 @@
+CREATE TABLE skip_test(time timestamp NOT NULL, device int, value double precision);
+SELECT create_hypertable('skip_test', 'time', chunk_time_interval => interval '1 day');
+CREATE INDEX ON skip_test(device, time DESC);
+
+INSERT INTO skip_test
+SELECT '2018-01-01'::timestamp + i * interval '1 minute', d, i % 100 + d
+FROM generate_series(0, 2879) i, generate_series(1, 4) d;
+INSERT INTO skip_test VALUES ('2018-01-01 06:00', NULL, 1), ('2018-01-02 06:00', NULL, 2);
+ANALYZE skip_test;
+
+-- every chunk returns the first row of each device
+EXPLAIN (costs off)
+SELECT DISTINCT ON (device) * FROM skip_test ORDER BY device, time DESC;
+SELECT DISTINCT ON (device) * FROM skip_test ORDER BY device, time DESC;
+
+-- rows that do not pass the filter are skipped until the next device
+EXPLAIN (costs off)
+SELECT DISTINCT ON (device) * FROM skip_test WHERE value > 50 ORDER BY device, time DESC;
+SELECT DISTINCT ON (device) * FROM skip_test WHERE value > 50 ORDER BY device, time DESC;
+
+-- NULLs come last in a forward scan and are looked up after the last device
+SELECT DISTINCT ON (device) * FROM skip_test WHERE value > 1 ORDER BY device, time DESC;
+SELECT DISTINCT ON (device) * FROM skip_test WHERE device >= 3 ORDER BY device, time DESC;
+
+-- NULLs come first in a backward scan
+SELECT DISTINCT device FROM skip_test ORDER BY device DESC;
+
+-- the results are the same without skip scans
+SET timescaledb.skip_scan = off;
+SELECT DISTINCT ON (device) * FROM skip_test ORDER BY device, time DESC;
+SELECT DISTINCT ON (device) * FROM skip_test WHERE value > 50 ORDER BY device, time DESC;
+SELECT DISTINCT ON (device) * FROM skip_test WHERE value > 1 ORDER BY device, time DESC;
+SELECT DISTINCT ON (device) * FROM skip_test WHERE device >= 3 ORDER BY device, time DESC;
+SELECT DISTINCT device FROM skip_test ORDER BY device DESC;
+RESET timescaledb.skip_scan;
@@ -23,6 +23,8 @@ SELECT * FROM test.show_subtables('int_part');
 SELECT * FROM "int_part" WHERE object_id = 1;
 --make sure this touches only one partititon
 EXPLAIN (verbose ON, costs off) SELECT * FROM "int_part" WHERE object_id = 1;
+--make sure IN lists only touch matching partitions (1 and 5 hash to the same partition)
+EXPLAIN (verbose ON, costs off) SELECT * FROM "int_part" WHERE object_id IN (1, 5);
 
 --TODO: handle this later?
 --EXPLAIN (verbose ON, costs off) SELECT * FROM "two_Partitions" WHERE device_id IN ('dev2', 'dev21');
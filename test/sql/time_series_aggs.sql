@@ -0,0 +1,75 @@
+CREATE TABLE ts_agg_test(time timestamptz, device int, temp double precision, requests double precision);
+SELECT create_hypertable('ts_agg_test', 'time', chunk_time_interval => interval '1 hour');
+
+-- rows of device 2 are inserted out of time order
+INSERT INTO ts_agg_test VALUES
+    ('2018-01-01 00:00:00+00', 1, 10, 0),
+    ('2018-01-01 00:10:00+00', 1, 20, 100),
+    ('2018-01-01 00:40:00+00', 1, 30, 250),
+    ('2018-01-01 01:00:00+00', 1, 10, 40),
+    ('2018-01-01 01:30:00+00', 1, 20, 100),
+    ('2018-01-01 01:45:00+00', 1, NULL, NULL),
+    ('2018-01-01 00:30:00+00', 2, 5, 1000),
+    ('2018-01-01 00:00:00+00', 2, 15, 0),
+    ('2018-01-01 02:00:00+00', 2, 25, 3000);
+
+SELECT device,
+       time_weight_avg(temp, time ORDER BY time),
+       counter_rate(requests, time ORDER BY time),
+       delta(temp, time) AS temp_delta,
+       delta(requests, time) AS requests_delta
+FROM ts_agg_test GROUP BY device ORDER BY device;
+
+-- a single point
+SELECT time_weight_avg(temp, time), counter_rate(requests, time), delta(temp, time)
+FROM ts_agg_test WHERE device = 1 AND time = '2018-01-01 00:40:00+00';
+
+-- no rows
+SELECT time_weight_avg(temp, time), counter_rate(requests, time), delta(temp, time)
+FROM ts_agg_test WHERE device = 3;
+
+-- downsampling
+SELECT * FROM unnest_points((SELECT lttb(temp, time, 3) FROM ts_agg_test WHERE device = 1));
+SELECT * FROM unnest_points((SELECT minmax_downsample(temp, time, 4) FROM ts_agg_test WHERE device = 1));
+
+-- with a time range, rows are added to their time range as they arrive;
+-- rows outside of the range are ignored
+SELECT * FROM unnest_points((SELECT minmax_downsample(temp, time, 4, '2018-01-01 00:00+00', '2018-01-01 02:00+00') FROM ts_agg_test WHERE device = 1));
+SELECT * FROM unnest_points((SELECT minmax_downsample(temp, time, 2, '2018-01-01 00:30+00', '2018-01-01 01:30+00') FROM ts_agg_test WHERE device = 1));
+
+-- series with fewer points than the resolution are returned as is
+SELECT s.device, p.*
+FROM (SELECT device, lttb(temp, time, 10) AS series FROM ts_agg_test GROUP BY device) s,
+     unnest_points(s.series) p
+ORDER BY s.device, p.time;
+
+\set ON_ERROR_STOP 0
+SELECT lttb(temp, time, 1) FROM ts_agg_test;
+SELECT minmax_downsample(temp, time, 4, '2018-01-01 02:00+00', '2018-01-01 00:00+00') FROM ts_agg_test;
+\set ON_ERROR_STOP 1
+
+-- without ORDER BY, rows must arrive in runs in time order or in reverse time
+-- order, like the rows of device 2 in the first chunk
+SELECT time_weight_avg(temp, time), counter_rate(requests, time), delta(temp, time)
+FROM ts_agg_test WHERE device = 2;
+
+-- a run that starts before the earlier rows is summarized on its own
+INSERT INTO ts_agg_test VALUES
+    ('2018-01-01 00:30:00+00', 5, 30, 300),
+    ('2018-01-01 00:40:00+00', 5, 20, 400),
+    ('2018-01-01 00:00:00+00', 5, 10, 0),
+    ('2018-01-01 00:10:00+00', 5, 40, 100);
+SELECT time_weight_avg(temp, time), counter_rate(requests, time), delta(temp, time)
+FROM ts_agg_test WHERE device = 5;
+
+-- a late row that falls between earlier rows needs ORDER BY
+INSERT INTO ts_agg_test VALUES
+    ('2018-01-01 00:00:00+00', 4, 10, 0),
+    ('2018-01-01 00:40:00+00', 4, 20, 200),
+    ('2018-01-01 00:20:00+00', 4, 40, 100);
+\set ON_ERROR_STOP 0
+SELECT time_weight_avg(temp, time) FROM ts_agg_test WHERE device = 4;
+SELECT counter_rate(requests, time) FROM ts_agg_test WHERE device = 4;
+\set ON_ERROR_STOP 1
+SELECT time_weight_avg(temp, time ORDER BY time), counter_rate(requests, time ORDER BY time), delta(temp, time)
+FROM ts_agg_test WHERE device = 4;
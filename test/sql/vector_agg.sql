@@ -0,0 +1,58 @@
+CREATE TABLE vagg_test(time timestamp NOT NULL, device int, temp double precision, reading int);
+SELECT create_hypertable('vagg_test', 'time', chunk_time_interval => interval '1 day');
+
+INSERT INTO vagg_test
+SELECT '2018-01-01'::timestamp + i * interval '10 minutes', d, (i % 50) + d,
+       CASE WHEN i % 7 = 0 THEN NULL ELSE i % 100 + d END
+FROM generate_series(0, 431) i, generate_series(1, 3) d;
+
+-- compress the first chunk by device and the second one without segment_by
+-- columns, and leave the last chunk uncompressed
+SELECT compress_chunk('_timescaledb_internal._hyper_1_1_chunk', '{device}');
+SELECT compress_chunk('_timescaledb_internal._hyper_1_2_chunk');
+
+EXPLAIN (costs off)
+SELECT device, count(*), sum(reading), avg(temp) FROM vagg_test GROUP BY device;
+
+SELECT device, count(*), count(reading), sum(reading), round(avg(reading), 2),
+       avg(temp), min(temp), max(reading), sum(temp)
+FROM vagg_test GROUP BY device ORDER BY device;
+
+SELECT time_bucket('1 day', time) AS day, count(*), max(temp), histogram(temp, 0, 50, 5)
+FROM vagg_test GROUP BY day ORDER BY day;
+
+SELECT count(*), sum(reading), min(time), max(time) FROM vagg_test;
+
+-- compressed chunks with quals are aggregated row by row
+SELECT device, sum(reading) FROM vagg_test
+WHERE temp > 40 GROUP BY device HAVING count(*) > 40 ORDER BY device;
+
+-- aggregates without grouping return a row even without input
+SELECT count(*), sum(reading), avg(temp) FROM vagg_test WHERE device = 10;
+
+-- the results are the same without vectorized aggregation
+CREATE TABLE vagg_on AS
+SELECT device, time_bucket('6 hours', time) AS bucket, count(*) AS n,
+       count(reading) AS n_reading, sum(reading) AS sum_reading,
+       avg(reading) AS avg_reading, sum(temp) AS sum_temp, avg(temp) AS avg_temp,
+       min(temp) AS min_temp, max(temp) AS max_temp, min(time) AS first_time,
+       histogram(reading, 0, 150, 5) AS hist_reading
+FROM vagg_test GROUP BY 1, 2;
+SET timescaledb.vector_agg = off;
+CREATE TABLE vagg_off AS
+SELECT device, time_bucket('6 hours', time) AS bucket, count(*) AS n,
+       count(reading) AS n_reading, sum(reading) AS sum_reading,
+       avg(reading) AS avg_reading, sum(temp) AS sum_temp, avg(temp) AS avg_temp,
+       min(temp) AS min_temp, max(temp) AS max_temp, min(time) AS first_time,
+       histogram(reading, 0, 150, 5) AS hist_reading
+FROM vagg_test GROUP BY 1, 2;
+RESET timescaledb.vector_agg;
+SELECT count(*) FROM vagg_on;
+SELECT count(*) FROM
+((SELECT * FROM vagg_on EXCEPT ALL SELECT * FROM vagg_off)
+ UNION ALL
+ (SELECT * FROM vagg_off EXCEPT ALL SELECT * FROM vagg_on)) diff;
+
+-- NULL values are skipped, also when a column is NULL for whole batches
+ALTER TABLE vagg_test ADD COLUMN extra double precision;
+SELECT count(extra), histogram(extra, 0, 10, 2) FROM vagg_test;
@@ -0,0 +1,37 @@
+CREATE TABLE vfilter_test(time timestamp NOT NULL, device int, temp double precision, reading bigint);
+SELECT create_hypertable('vfilter_test', 'time', chunk_time_interval => interval '1 day');
+
+INSERT INTO vfilter_test
+SELECT '2018-01-01'::timestamp + i * interval '10 minutes', d,
+       CASE WHEN i % 11 = 0 THEN NULL ELSE (i % 50) + d END, i * d
+FROM generate_series(0, 431) i, generate_series(1, 3) d;
+INSERT INTO vfilter_test VALUES ('2018-01-02 12:05', 4, 'NaN', NULL);
+
+EXPLAIN (costs off)
+SELECT * FROM vfilter_test WHERE temp > 45 AND device <> 2;
+
+-- quals that cannot be vectorized are evaluated on the remaining rows
+EXPLAIN (costs off)
+SELECT * FROM vfilter_test WHERE 40 <= temp AND device + 1 = 3;
+
+SELECT device, count(*), min(temp), max(temp) FROM vfilter_test
+WHERE temp > 45 AND device <> 2 GROUP BY device ORDER BY device;
+
+-- NaN is larger than any other value
+SELECT count(*) FROM vfilter_test WHERE temp >= 'NaN';
+SELECT count(*) FROM vfilter_test WHERE temp < 'NaN';
+
+SELECT * FROM vfilter_test WHERE time >= '2018-01-03 23:20' AND reading < 700 ORDER BY time, device;
+
+-- the results are the same with a regular scan
+CREATE TABLE vfilter_on AS
+SELECT * FROM vfilter_test WHERE temp > 20 AND reading <= 800 AND 3 > device;
+SET timescaledb.vector_filter = off;
+CREATE TABLE vfilter_off AS
+SELECT * FROM vfilter_test WHERE temp > 20 AND reading <= 800 AND 3 > device;
+RESET timescaledb.vector_filter;
+SELECT count(*) FROM vfilter_on;
+SELECT count(*) FROM
+((SELECT * FROM vfilter_on EXCEPT ALL SELECT * FROM vfilter_off)
+ UNION ALL
+ (SELECT * FROM vfilter_off EXCEPT ALL SELECT * FROM vfilter_on)) diff;